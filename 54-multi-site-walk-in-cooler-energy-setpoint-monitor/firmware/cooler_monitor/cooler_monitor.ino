@@ -23,7 +23,9 @@
 //   volts_nominal         120.0   Nominal line voltage for apparent-power kWh estimate
 //
 // Power strategy:
-//   The Cygnet host sleeps between samples via NotePayloadSaveAndSleep / card.attn.
+//   The Cygnet host sleeps between samples via NotePayloadSaveAndSleep / card.attn,
+//   or, built with HOST_RETAINED_SLEEP, in STM32L4 Shutdown with its state in
+//   the RTC backup registers (see cooler_monitor_helpers.h).
 //   The Notecard idles at ~8–18 µA between outbound sync sessions.
 //   Summary notes queue locally and flush in one cellular session per hour.
 //   Alert notes carry sync:true and flush within one session-establishment window.
@@ -44,6 +46,10 @@ DallasTemperature probe(&oneWire);
 // Persisted state — global so loop() can reach it for NotePayloadSaveAndSleep.
 static AppState state;
 
+#ifdef HOST_RETAINED_SLEEP
+static STM32RTC &rtc = STM32RTC::getInstance();
+#endif
+
 // Live config (re-populated from Notehub env vars on every wake)
 uint32_t cfgSampleSec        = DEFAULT_SAMPLE_INTERVAL_SEC;
 uint32_t cfgSummaryMin       = DEFAULT_SUMMARY_INTERVAL_MIN;
@@ -81,16 +87,39 @@ void setup() {
     DBG_SET_STREAM();
 
     // Attempt to restore persisted state from Notecard flash.
-    // NotePayloadGetSegment returns false when the stored segment ID does not
-    // match SEG_STATE (e.g. after a firmware upgrade that bumps the ID), so
-    // restored is set false and the cold-boot branch below runs, ensuring
-    // hubConfigure() and defineTemplates() are called with the new build.
-    NotePayloadDesc payload;
-    bool restored = NotePayloadRetrieveAfterSleep(&payload);
+    // appStateDecode() returns false when the encoded state was written with a
+    // different STATE_SCHEMA_VERSION (e.g. after a firmware upgrade that bumps
+    // it), and a missing SEG_STATE segment fails the lookup, so restored is set
+    // false and the cold-boot branch below runs, ensuring hubConfigure() and
+    // defineTemplates() are called with the new build.
     memset(&state, 0, sizeof(state));
-    if (restored) {
-        restored = NotePayloadGetSegment(&payload, SEG_STATE, &state, sizeof(state));
-        NotePayloadFree(&payload);
+    bool restored = false;
+    bool retainedWake = false;
+#ifdef HOST_RETAINED_SLEEP
+    // The host slept in Shutdown with its state in the RTC backup registers;
+    // they are only invalid after the host lost power (or on first boot, or
+    // when the last state was too large for them), and only then is the
+    // Notecard payload consulted below.
+    rtc.setClockSource(STM32RTC::LSE_CLOCK);
+    rtc.begin();
+    LowPower.begin();
+    {
+        uint8_t retained[RETAINED_STATE_MAX];
+        const size_t retainedLen = retainedStateLoad(retained, sizeof(retained));
+        restored = retainedLen > 0 && appStateDecode(state, retained, retainedLen);
+        retainedWake = restored;
+    }
+#endif
+    if (!restored) {
+        NotePayloadDesc payload;
+        restored = NotePayloadRetrieveAfterSleep(&payload);
+        if (restored) {
+            uint8_t *encoded = NULL;
+            uint32_t encodedLen = 0;
+            restored = NotePayloadFindSegment(&payload, SEG_STATE, &encoded, &encodedLen) &&
+                       appStateDecode(state, encoded, encodedLen);
+            NotePayloadFree(&payload);
+        }
     }
     if (!restored) {
         // First boot (or segment ID mismatch after firmware upgrade): attempt
@@ -145,7 +174,15 @@ void setup() {
     // is already confirmed and the cadence has changed — a transient env.get
     // failure must not revert the Notecard's outbound timer, and hub.set
     // cadence updates are meaningless until the initial association succeeds.
-    if (fetchEnvOverrides(state)) {
+    //
+    // A wake restored from the backup registers fetches env vars only on the
+    // first wake of each summary window and otherwise runs on the persisted
+    // config, so a steady-state wake makes no Notecard request unless an alert
+    // or the summary is due.  The Notecard only pulls new values from Notehub
+    // every inbound sync (2 × summary_interval_min), so this adds at most one
+    // window to the time an edit takes to apply.
+    const bool envDue = !retainedWake || state.elapsedSecSinceSummary == 0;
+    if (envDue && fetchEnvOverrides(state)) {
         if (state.hubSetConfirmed) {
             applyHubSetIfChanged(state);
         }
@@ -159,8 +196,23 @@ void setup() {
 // line cuts host power, so execution beyond NotePayloadSaveAndSleep is not
 // expected in normal operation.
 void loop() {
+    // Only fields that differ from the steady-state baseline are encoded, which
+    // keeps the base64 card.attn payload — and the I²C time spent sending it on
+    // every sleep — to a few bytes in the common case.
+    uint8_t encoded[APP_STATE_ENCODED_MAX];
+    uint32_t encodedLen = (uint32_t)appStateEncode(state, encoded);
+
+#ifdef HOST_RETAINED_SLEEP
+    // Keep the state on the host and sleep in Shutdown until the RTC wakeup,
+    // which resets into setup().  A state too large for the backup registers
+    // falls through to the Notecard for this one sleep.
+    if (retainedStateSave(encoded, encodedLen)) {
+        LowPower.shutdown(cfgSampleSec * 1000UL);
+    }
+#endif
+
     NotePayloadDesc outPayload = {0, 0, 0};
-    NotePayloadAddSegment(&outPayload, SEG_STATE, &state, sizeof(state));
+    NotePayloadAddSegment(&outPayload, SEG_STATE, encoded, encodedLen);
     NotePayloadSaveAndSleep(&outPayload, cfgSampleSec, NULL);
 
     // Reached only if ATTN-based host power cut is unavailable (bench / bring-
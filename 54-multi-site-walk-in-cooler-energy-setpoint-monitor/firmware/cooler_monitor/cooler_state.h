@@ -0,0 +1,190 @@
+#pragma once
+// cooler_state.h — persisted application state for the multi-site walk-in
+// cooler energy & setpoint monitor, and its compact sleep-payload encoding.
+//
+// Kept free of Arduino and Notecard dependencies so the host benchmark in
+// ../../sim builds against the same struct, field table and baseline as the
+// firmware.
+
+#include <stdint.h>
+#include <string.h>
+
+#include "state_codec.h"
+
+// Firmware defaults — all overridable via Notehub environment variables
+#define DEFAULT_SAMPLE_INTERVAL_SEC   60u
+#define DEFAULT_SUMMARY_INTERVAL_MIN  60u
+#define DEFAULT_TEMP_SETPOINT_F       35.0f
+#define DEFAULT_TEMP_ALERT_F          40.0f
+#define DEFAULT_DOOR_ALERT_SEC        300u
+#define DEFAULT_COMPRESSOR_ON_AMPS    2.0f
+#define DEFAULT_VOLTS_NOMINAL         120.0f
+
+// Payload segment ID for NotePayload helpers.  CS5 and later carry AppState
+// encoded with state_codec.h rather than the raw struct, so the ID no longer
+// changes with the struct layout; bump STATE_SCHEMA_VERSION instead.
+#define SEG_STATE  "CS5"
+
+// IMPORTANT: bump whenever kAppStateFields, appStateBaseline() or the
+// cooler_summary.qo template body changes.  A mismatched version fails
+// appStateDecode(), which the setup() cold-boot branch treats as a first boot
+// and re-runs hubConfigure() + defineTemplates().  This prevents a firmware
+// upgrade from rehydrating stale state into a new layout or skipping
+// re-registration of an updated template.
+// 1: first codec-encoded layout (previously raw struct segment CS4).
+#define STATE_SCHEMA_VERSION  1
+
+// ── Persisted application state ────────────────────────────────────────────
+// Stored in Notecard flash between host-sleep cycles via NotePayloadSaveAndSleep,
+// encoded field by field (see kAppStateFields below), so the in-memory layout
+// and padding never reach the payload.
+
+struct AppState {
+    // Summary cadence: sum of scheduled sample intervals (prevSampleSec ticks)
+    // elapsed since the last summary was sent.  Awake time is excluded, so this
+    // tracks scheduled sleep time rather than true wall-clock elapsed time.
+    // Reset to zero after each successful summary.  When sample_interval_sec
+    // does not evenly divide summary_interval_min×60, the window overshoots by
+    // at most one sample period; window_sec in the emitted Note carries this
+    // measured sum so downstream rate calculations use the correct denominator.
+    uint32_t elapsedSecSinceSummary;
+
+    // Per-window energy and runtime accumulators
+    float    kwhAccum;               // kWh accumulated this window
+    uint32_t compressorRunSec;       // compressor-on seconds this window
+    uint32_t doorOpenSec;            // total door-open seconds this window
+    uint16_t doorOpenCount;          // door-open events (low→high transitions)
+
+    // Alert cooldowns in wall-clock seconds.  Storing seconds (not sample counts)
+    // keeps timing stable across sample_interval_sec changes.
+    uint32_t doorAlertCooldownSec;
+    uint32_t tempAlertCooldownSec;
+
+    // Edge-detection and continuous-open alert tracking
+    uint8_t  prevDoorOpen;           // door state at previous wake (0 or 1)
+    uint32_t doorContinuousOpenSec;  // unbroken open span; resets to 0 on close
+
+    // Tracks the last hub.set outbound cadence so re-send is skipped when
+    // summary_interval_min has not changed.
+    uint32_t appliedSummaryMin;
+
+    // Actual sleep duration of the completed interval.  Set to cfgSampleSec at
+    // the end of each runSampleCycle() so the next wake correctly accounts for
+    // elapsed time independent of any in-flight env-var change.  Zero on first boot.
+    uint32_t prevSampleSec;
+
+    // Window-average accumulators: running sums + per-metric valid-sample counts.
+    // A failed sensor read (NAN) increments neither sum nor count, so it cannot
+    // bias the average or produce a spurious sentinel in a window where other
+    // reads succeeded.
+    float    tempFSum;
+    uint16_t tempFCount;
+    float    ampsSum;
+    uint16_t ampsCount;
+
+    // Set to 1 after both note.template calls succeed; retried on every wake
+    // until confirmed so a transient first-boot I²C failure never leaves the
+    // device running with untemplated Notes indefinitely.
+    uint8_t  templatesRegistered;
+
+    // Last-known-good configuration, persisted across host power cycles.
+    // Loaded into cfg globals before env.get on every wake; overwritten only
+    // when env.get returns a valid response.  This prevents a transient
+    // inbound-sync failure from silently reverting operator-tuned values to
+    // compile-time defaults.
+    uint32_t persistedSampleSec;
+    uint32_t persistedSummaryMin;
+    float    persistedTempSetpointF;
+    float    persistedTempAlertF;
+    uint32_t persistedDoorAlertSec;
+    float    persistedCompressorOnAmps;
+    float    persistedVoltsNominal;
+    uint8_t  configPersisted;    // non-zero once a successful env.get has run
+
+    // Set to 1 the first time hubConfigure() returns true (hub.set
+    // acknowledged by the Notecard).  While this is 0, every warm wake
+    // retries hubConfigure() unconditionally in setup() — independent of
+    // env.get success — so a transient cold-boot I²C failure can never leave
+    // the device permanently unassociated and silently queueing Notes.
+    // Once set, the device falls back to the cadence-only re-application path
+    // (applyHubSetIfChanged).
+    uint8_t  hubSetConfirmed;    // non-zero once hub.set has been acknowledged
+};
+
+// ── Sleep-payload encoding ─────────────────────────────────────────────────
+// Every persisted field, in a fixed order.  Fields equal to the baseline below
+// cost one bitmap bit; the window counters cost 1–3 bytes each.
+
+#define APP_STATE_FIELD_COUNT  25
+
+static const StateField kAppStateFields[APP_STATE_FIELD_COUNT] = {
+    STATE_FIELD(AppState, elapsedSecSinceSummary,    STATE_U32),
+    STATE_FIELD(AppState, kwhAccum,                  STATE_F32),
+    STATE_FIELD(AppState, compressorRunSec,          STATE_U32),
+    STATE_FIELD(AppState, doorOpenSec,               STATE_U32),
+    STATE_FIELD(AppState, doorOpenCount,             STATE_U16),
+    STATE_FIELD(AppState, doorAlertCooldownSec,      STATE_U32),
+    STATE_FIELD(AppState, tempAlertCooldownSec,      STATE_U32),
+    STATE_FIELD(AppState, prevDoorOpen,              STATE_U8),
+    STATE_FIELD(AppState, doorContinuousOpenSec,     STATE_U32),
+    STATE_FIELD(AppState, appliedSummaryMin,         STATE_U32),
+    STATE_FIELD(AppState, prevSampleSec,             STATE_U32),
+    STATE_FIELD(AppState, tempFSum,                  STATE_F32),
+    STATE_FIELD(AppState, tempFCount,                STATE_U16),
+    STATE_FIELD(AppState, ampsSum,                   STATE_F32),
+    STATE_FIELD(AppState, ampsCount,                 STATE_U16),
+    STATE_FIELD(AppState, templatesRegistered,       STATE_U8),
+    STATE_FIELD(AppState, persistedSampleSec,        STATE_U32),
+    STATE_FIELD(AppState, persistedSummaryMin,       STATE_U32),
+    STATE_FIELD(AppState, persistedTempSetpointF,    STATE_F32),
+    STATE_FIELD(AppState, persistedTempAlertF,       STATE_F32),
+    STATE_FIELD(AppState, persistedDoorAlertSec,     STATE_U32),
+    STATE_FIELD(AppState, persistedCompressorOnAmps, STATE_F32),
+    STATE_FIELD(AppState, persistedVoltsNominal,     STATE_F32),
+    STATE_FIELD(AppState, configPersisted,           STATE_U8),
+    STATE_FIELD(AppState, hubSetConfirmed,           STATE_U8),
+};
+
+#define APP_STATE_ENCODED_MAX  STATE_CODEC_MAX_SIZE(APP_STATE_FIELD_COUNT)
+
+// The steady state of a configured device between summaries with default
+// config: everything confirmed, config persisted at the compile-time defaults,
+// counters at zero.  The slow-changing config and flags therefore cost nothing
+// in the payload until an operator tunes them, and the window counters are
+// encoded as their distance from zero.
+static inline AppState appStateBaseline() {
+    AppState b;
+    memset(&b, 0, sizeof(b));
+    b.appliedSummaryMin         = DEFAULT_SUMMARY_INTERVAL_MIN;
+    b.prevSampleSec             = DEFAULT_SAMPLE_INTERVAL_SEC;
+    b.templatesRegistered       = 1u;
+    b.persistedSampleSec        = DEFAULT_SAMPLE_INTERVAL_SEC;
+    b.persistedSummaryMin       = DEFAULT_SUMMARY_INTERVAL_MIN;
+    b.persistedTempSetpointF    = DEFAULT_TEMP_SETPOINT_F;
+    b.persistedTempAlertF       = DEFAULT_TEMP_ALERT_F;
+    b.persistedDoorAlertSec     = DEFAULT_DOOR_ALERT_SEC;
+    b.persistedCompressorOnAmps = DEFAULT_COMPRESSOR_ON_AMPS;
+    b.persistedVoltsNominal     = DEFAULT_VOLTS_NOMINAL;
+    b.configPersisted           = 1u;
+    b.hubSetConfirmed           = 1u;
+    return b;
+}
+
+// Returns the encoded length written to out (APP_STATE_ENCODED_MAX bytes).
+static inline size_t appStateEncode(const AppState &s, uint8_t *out) {
+    const AppState baseline = appStateBaseline();
+    return stateEncode(&s, &baseline, kAppStateFields, APP_STATE_FIELD_COUNT,
+                       STATE_SCHEMA_VERSION, out, APP_STATE_ENCODED_MAX);
+}
+
+// Returns false, leaving s zeroed as on a first boot, when the buffer was
+// written by a different schema version or is malformed.
+static inline bool appStateDecode(AppState &s, const uint8_t *in, size_t len) {
+    const AppState baseline = appStateBaseline();
+    if (stateDecode(&s, sizeof(s), &baseline, kAppStateFields, APP_STATE_FIELD_COUNT,
+                    STATE_SCHEMA_VERSION, in, len)) {
+        return true;
+    }
+    memset(&s, 0, sizeof(s));
+    return false;
+}
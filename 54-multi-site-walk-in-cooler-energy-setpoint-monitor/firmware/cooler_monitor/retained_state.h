@@ -0,0 +1,90 @@
+#pragma once
+// retained_state.h — host-retained copy of the encoded AppState for the
+// HOST_RETAINED_SLEEP build option (see cooler_monitor_helpers.h).
+//
+// The STM32L433's RTC backup registers (32 × 32-bit) sit in the backup domain,
+// which keeps its contents through Shutdown and Standby, the RTC wakeup reset
+// and NRST, and loses them only when the MCU itself loses power.  The encoded
+// state (see cooler_state.h) is a few dozen bytes in steady state, so it fits
+// there with a header and CRC and never has to round-trip through the
+// Notecard on an ordinary wake.
+//
+// Layout, starting at RETAINED_BKP_FIRST:
+//   word 0      RETAINED_MAGIC << 16 | encoded length
+//   word 1      CRC-32 of word 0 and the encoded bytes
+//   word 2...   encoded bytes, little-endian, zero-padded to a whole word
+//
+// DR0–DR7 are left to the core's RTC bookkeeping (STM32RTC keeps its
+// "initialized" flag there).
+
+#include <Arduino.h>
+#include <backup.h>
+
+#define RETAINED_BKP_FIRST   8u
+#define RETAINED_BKP_COUNT   24u
+#define RETAINED_MAGIC       0xC5A7u
+
+// Largest encoded state the registers can hold; larger states fall back to
+// the Notecard payload for that sleep.
+#define RETAINED_STATE_MAX   ((RETAINED_BKP_COUNT - 2u) * 4u)
+
+static inline uint32_t retainedCrc32(uint32_t crc, const uint8_t *p, size_t len) {
+    crc = ~crc;
+    while (len--) {
+        crc ^= *p++;
+        for (int k = 0; k < 8; k++) {
+            crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u)));
+        }
+    }
+    return ~crc;
+}
+
+static inline uint32_t retainedChecksum(uint32_t header, const uint8_t *data, size_t len) {
+    uint8_t h[4] = { (uint8_t)header, (uint8_t)(header >> 8),
+                     (uint8_t)(header >> 16), (uint8_t)(header >> 24) };
+    return retainedCrc32(retainedCrc32(0, h, sizeof(h)), data, len);
+}
+
+// Invalidates the retained copy, so the next boot falls back to the Notecard.
+static inline void retainedStateClear() {
+    enableBackupDomain();
+    setBackupRegister(RETAINED_BKP_FIRST, 0);
+}
+
+// Stores len encoded bytes.  Returns false, and clears any previous copy so it
+// can't be restored in place of newer state, when they don't fit.
+static inline bool retainedStateSave(const uint8_t *data, size_t len) {
+    if (len > RETAINED_STATE_MAX) {
+        retainedStateClear();
+        return false;
+    }
+    enableBackupDomain();
+    const uint32_t header = ((uint32_t)RETAINED_MAGIC << 16) | (uint32_t)len;
+    for (size_t w = 0; w < (len + 3u) / 4u; w++) {
+        uint32_t word = 0;
+        for (size_t k = 0; k < 4u && w * 4u + k < len; k++) {
+            word |= (uint32_t)data[w * 4u + k] << (8u * k);
+        }
+        setBackupRegister(RETAINED_BKP_FIRST + 2u + w, word);
+    }
+    setBackupRegister(RETAINED_BKP_FIRST + 1u, retainedChecksum(header, data, len));
+    setBackupRegister(RETAINED_BKP_FIRST, header);   // written last: marks the copy valid
+    return true;
+}
+
+// Copies the retained encoded state into data.  Returns its length, or 0 after
+// a power loss (registers reset), a first boot, or a failed CRC.
+static inline size_t retainedStateLoad(uint8_t *data, size_t cap) {
+    const uint32_t header = getBackupRegister(RETAINED_BKP_FIRST);
+    const size_t   len    = header & 0xFFFFu;
+    if ((header >> 16) != RETAINED_MAGIC || len == 0 || len > RETAINED_STATE_MAX || len > cap) {
+        return 0;
+    }
+    for (size_t i = 0; i < len; i++) {
+        data[i] = (uint8_t)(getBackupRegister(RETAINED_BKP_FIRST + 2u + i / 4u) >> (8u * (i % 4u)));
+    }
+    if (getBackupRegister(RETAINED_BKP_FIRST + 1u) != retainedChecksum(header, data, len)) {
+        return 0;
+    }
+    return len;
+}
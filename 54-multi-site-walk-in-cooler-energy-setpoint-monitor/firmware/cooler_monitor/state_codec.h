@@ -0,0 +1,155 @@
+#pragma once
+// state_codec.h — compact, versioned encoding of a persisted state struct for
+// the NotePayload sleep segment.
+//
+// Saving the raw struct with NotePayloadAddSegment sends every byte of it,
+// base64-encoded, to the Notecard on each sleep and back again on each wake,
+// even though most fields sit at their steady-state value almost all the time.
+// This codec encodes a state struct against a baseline struct that both ends
+// know at compile time (the steady state), and writes only the fields that
+// differ from it:
+//
+//   [schema version][presence bitmap, 1 bit per field][field values...]
+//
+//   - Integer fields are written as the zig-zag LEB128 varint of their
+//     difference from the baseline, so small counters and values near their
+//     default take 1-2 bytes instead of 4.
+//   - Float fields are written raw (4 bytes, little-endian) when their bit
+//     pattern differs from the baseline's.
+//   - Fields equal to the baseline cost only their bit in the bitmap.
+//
+// Decoding starts from a copy of the baseline and applies the fields that are
+// present, so a decoded state is bit-for-bit the state that was encoded.  A
+// different schema version, a truncated buffer or trailing bytes all fail the
+// decode, which callers treat as a cold boot, just as they treat a missing
+// payload segment.  Bump the schema version whenever the field table changes.
+//
+// The codec has no Arduino or Notecard dependencies, so the same header builds
+// into the host benchmark in sim/.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+enum StateFieldType : uint8_t {
+    STATE_U8,
+    STATE_U16,
+    STATE_U32,
+    STATE_F32
+};
+
+struct StateField {
+    uint16_t       offset;
+    StateFieldType type;
+};
+
+// Describes one member of a state struct, e.g. STATE_FIELD(AppState, kwhAccum, STATE_F32)
+#define STATE_FIELD(Struct, member, type)  { (uint16_t)offsetof(Struct, member), (type) }
+
+// Worst case for n fields: version byte, bitmap, and a 5-byte varint or 4-byte
+// float for every field.  Size encode buffers with this.
+#define STATE_CODEC_MAX_SIZE(n)  (1u + ((n) + 7u) / 8u + 5u * (n))
+
+// ── Internals ──────────────────────────────────────────────────────────────
+
+static inline uint32_t stateFieldRead(const void *base, const StateField &f) {
+    const uint8_t *p = (const uint8_t *)base + f.offset;
+    switch (f.type) {
+    case STATE_U8:  { return *p; }
+    case STATE_U16: { uint16_t v; memcpy(&v, p, sizeof(v)); return v; }
+    default:        { uint32_t v; memcpy(&v, p, sizeof(v)); return v; }  // U32 and F32 bits
+    }
+}
+
+static inline void stateFieldWrite(void *base, const StateField &f, uint32_t v) {
+    uint8_t *p = (uint8_t *)base + f.offset;
+    switch (f.type) {
+    case STATE_U8:  { *p = (uint8_t)v; break; }
+    case STATE_U16: { uint16_t w = (uint16_t)v; memcpy(p, &w, sizeof(w)); break; }
+    default:        { memcpy(p, &v, sizeof(v)); break; }
+    }
+}
+
+// ── Encode / decode ────────────────────────────────────────────────────────
+
+// Encodes state against baseline into out.  Returns the encoded length, or 0
+// when cap is too small (never the case with STATE_CODEC_MAX_SIZE(n)).
+static inline size_t stateEncode(const void *state, const void *baseline,
+                                 const StateField *fields, size_t n,
+                                 uint8_t version, uint8_t *out, size_t cap) {
+    const size_t bitmapLen = (n + 7u) / 8u;
+    if (cap < 1u + bitmapLen) return 0;
+    out[0] = version;
+    uint8_t *bitmap = out + 1;
+    memset(bitmap, 0, bitmapLen);
+    size_t len = 1u + bitmapLen;
+
+    for (size_t i = 0; i < n; i++) {
+        const uint32_t v = stateFieldRead(state, fields[i]);
+        const uint32_t b = stateFieldRead(baseline, fields[i]);
+        if (v == b) continue;
+        bitmap[i / 8u] |= (uint8_t)(1u << (i % 8u));
+
+        if (fields[i].type == STATE_F32) {
+            if (cap - len < 4u) return 0;
+            for (int k = 0; k < 4; k++) out[len++] = (uint8_t)(v >> (8 * k));
+            continue;
+        }
+        // Zig-zag the signed difference so a value just below its baseline
+        // is as short as one just above it.
+        const int32_t  d  = (int32_t)(v - b);
+        uint32_t       zz = ((uint32_t)d << 1) ^ (uint32_t)(d >> 31);
+        do {
+            if (len == cap) return 0;
+            uint8_t byte = zz & 0x7Fu;
+            zz >>= 7;
+            out[len++] = zz ? (uint8_t)(byte | 0x80u) : byte;
+        } while (zz);
+    }
+    return len;
+}
+
+static inline bool stateDecodeFields(void *state, const void *baseline,
+                                     const StateField *fields, size_t n,
+                                     const uint8_t *in, size_t len) {
+    const uint8_t *bitmap = in + 1;
+    size_t pos = 1u + (n + 7u) / 8u;
+
+    for (size_t i = 0; i < n; i++) {
+        if (!(bitmap[i / 8u] & (1u << (i % 8u)))) continue;
+
+        uint32_t v;
+        if (fields[i].type == STATE_F32) {
+            if (len - pos < 4u) return false;
+            v = (uint32_t)in[pos] | ((uint32_t)in[pos + 1] << 8) |
+                ((uint32_t)in[pos + 2] << 16) | ((uint32_t)in[pos + 3] << 24);
+            pos += 4u;
+        } else {
+            uint32_t zz = 0;
+            for (unsigned shift = 0; ; shift += 7) {
+                if (pos == len || shift > 28) return false;
+                const uint8_t byte = in[pos++];
+                zz |= (uint32_t)(byte & 0x7Fu) << shift;
+                if (!(byte & 0x80u)) break;
+            }
+            const int32_t d = (int32_t)(zz >> 1) ^ -(int32_t)(zz & 1u);
+            v = stateFieldRead(baseline, fields[i]) + (uint32_t)d;
+        }
+        stateFieldWrite(state, fields[i], v);
+    }
+    return pos == len;  // trailing bytes mean a different field table
+}
+
+// Decodes in into state.  Returns false, leaving state as a copy of the
+// baseline, when the version doesn't match or the buffer is malformed.
+static inline bool stateDecode(void *state, size_t stateSize, const void *baseline,
+                               const StateField *fields, size_t n,
+                               uint8_t version, const uint8_t *in, size_t len) {
+    memcpy(state, baseline, stateSize);
+    if (len < 1u + (n + 7u) / 8u || in[0] != version) return false;
+    if (!stateDecodeFields(state, baseline, fields, n, in, len)) {
+        memcpy(state, baseline, stateSize);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,164 @@
+// state_codec_bench.cpp — host benchmark for the sleep-payload state codec.
+//
+// Replays a day of 60-second wakes of one walk-in cooler (compressor cycling,
+// door openings, hourly summaries) and, for every sleep, compares the state
+// segment the firmware used to save (the raw AppState struct) with the
+// encoded one it saves now.  For each it reports the payload bytes, the
+// card.attn request that carries them and the time note-c spends sending that
+// request over I²C, then checks that every encoded state decodes back to the
+// same bytes.
+//
+// Build and run from this directory:
+//   g++ -O2 -std=c++11 -I../firmware/cooler_monitor state_codec_bench.cpp -o state_codec_bench
+//   ./state_codec_bench
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cooler_state.h"
+
+// note-c I²C transmit pacing (n_i2c.c / n_lib.h): 30-byte chunks with 20 ms
+// between chunks, and a further 250 ms after every 250 bytes.
+static const unsigned I2C_CHUNK_LEN        = 30;
+static const unsigned I2C_CHUNK_DELAY_MS   = 20;
+static const unsigned I2C_SEGMENT_LEN      = 250;
+static const unsigned I2C_SEGMENT_DELAY_MS = 250;
+
+// NotePayload segment header: 4-byte segment ID + 4-byte length.
+static const unsigned SEGMENT_HEADER_LEN = 8;
+
+static unsigned base64Len(unsigned n) {
+    return ((n + 2) / 3) * 4;
+}
+
+// Bytes of {"req":"card.attn","mode":"sleep","seconds":60,"payload":"..."}\n
+static unsigned attnRequestLen(unsigned payloadLen) {
+    char seconds[16];
+    snprintf(seconds, sizeof(seconds), "%u", DEFAULT_SAMPLE_INTERVAL_SEC);
+    return (unsigned)(strlen("{\"req\":\"card.attn\",\"mode\":\"sleep\",\"seconds\":")
+                      + strlen(seconds) + strlen(",\"payload\":\"\"}\n"))
+           + base64Len(payloadLen);
+}
+
+static unsigned i2cTransmitMs(unsigned len) {
+    unsigned ms = 0, inSegment = 0;
+    while (len) {
+        unsigned chunk = len < I2C_CHUNK_LEN ? len : I2C_CHUNK_LEN;
+        len -= chunk;
+        inSegment += chunk;
+        if (inSegment > I2C_SEGMENT_LEN) {
+            inSegment = 0;
+            ms += I2C_SEGMENT_DELAY_MS;
+        }
+        ms += I2C_CHUNK_DELAY_MS;
+    }
+    return ms;
+}
+
+struct Totals {
+    unsigned long payload, request, ms;
+    unsigned minPayload, maxPayload;
+    Totals() : payload(0), request(0), ms(0), minPayload(~0u), maxPayload(0) {}
+    void add(unsigned stateLen) {
+        unsigned p = SEGMENT_HEADER_LEN + stateLen;
+        unsigned r = attnRequestLen(p);
+        payload += p;
+        request += r;
+        ms += i2cTransmitMs(r);
+        if (p < minPayload) minPayload = p;
+        if (p > maxPayload) maxPayload = p;
+    }
+};
+
+int main() {
+    const unsigned sleeps = 24u * 3600u / DEFAULT_SAMPLE_INTERVAL_SEC;
+    const unsigned summaryEvery = DEFAULT_SUMMARY_INTERVAL_MIN * 60u / DEFAULT_SAMPLE_INTERVAL_SEC;
+
+    // A configured device whose operator has lowered the setpoint, so one
+    // persisted config field differs from the firmware defaults all day.
+    AppState s = appStateBaseline();
+    s.persistedTempSetpointF = 33.0f;
+
+    srand(54);
+    Totals raw, enc;
+    unsigned failures = 0;
+    unsigned doorLeftSec = 0;
+
+    for (unsigned i = 0; i < sleeps; i++) {
+        // Compressor cycles roughly 12 minutes on, 18 off.
+        bool compressorOn = (i % 30u) < 12u;
+        float amps = compressorOn ? 9.5f + (rand() % 200) / 100.0f : 0.0f;
+        float tempF = 33.0f + (compressorOn ? -0.5f : 1.5f) + (rand() % 100) / 100.0f;
+
+        // A door opening every half hour or so, lasting one to three samples.
+        bool doorOpen = doorLeftSec > 0;
+        if (doorOpen) {
+            doorLeftSec -= DEFAULT_SAMPLE_INTERVAL_SEC;
+        } else if (rand() % 30 == 0) {
+            doorLeftSec = (unsigned)(rand() % 3) * DEFAULT_SAMPLE_INTERVAL_SEC;
+            doorOpen = true;
+        }
+
+        // Accumulate as runSampleCycle() does.
+        s.elapsedSecSinceSummary += DEFAULT_SAMPLE_INTERVAL_SEC;
+        s.tempFSum += tempF;
+        s.tempFCount++;
+        s.ampsSum += amps;
+        s.ampsCount++;
+        if (compressorOn) {
+            s.compressorRunSec += DEFAULT_SAMPLE_INTERVAL_SEC;
+            s.kwhAccum += DEFAULT_VOLTS_NOMINAL * amps * DEFAULT_SAMPLE_INTERVAL_SEC / 3600.0f / 1000.0f;
+        }
+        if (doorOpen) {
+            if (!s.prevDoorOpen) s.doorOpenCount++;
+            s.doorOpenSec += DEFAULT_SAMPLE_INTERVAL_SEC;
+            s.doorContinuousOpenSec += DEFAULT_SAMPLE_INTERVAL_SEC;
+        } else {
+            s.doorContinuousOpenSec = 0;
+        }
+        s.prevDoorOpen = doorOpen ? 1u : 0u;
+        if ((i + 1u) % summaryEvery == 0) {
+            s.elapsedSecSinceSummary = 0;
+            s.kwhAccum = 0.0f;
+            s.compressorRunSec = s.doorOpenSec = 0;
+            s.doorOpenCount = 0;
+            s.tempFSum = s.ampsSum = 0.0f;
+            s.tempFCount = s.ampsCount = 0;
+        }
+
+        // Sleep: what the firmware sends, and a round trip of it.
+        uint8_t encoded[APP_STATE_ENCODED_MAX];
+        size_t len = appStateEncode(s, encoded);
+        AppState decoded;
+        if (len == 0 || !appStateDecode(decoded, encoded, len) ||
+            memcmp(&decoded, &s, sizeof(s)) != 0) {
+            failures++;
+        }
+        raw.add(sizeof(AppState));
+        enc.add((unsigned)len);
+    }
+
+    // A buffer from another schema version must read as a cold boot.
+    uint8_t stale[APP_STATE_ENCODED_MAX];
+    size_t staleLen = appStateEncode(s, stale);
+    stale[0]++;
+    AppState rejected;
+    if (appStateDecode(rejected, stale, staleLen) || rejected.hubSetConfirmed != 0) {
+        failures++;
+    }
+
+    printf("%u sleeps, sizeof(AppState) = %u bytes, encoded max = %u bytes\n\n",
+           sleeps, (unsigned)sizeof(AppState), (unsigned)APP_STATE_ENCODED_MAX);
+    printf("%-8s %12s %12s %14s %14s %14s\n",
+           "", "payload min", "payload max", "payload avg", "card.attn avg", "I2C TX ms avg");
+    printf("%-8s %12u %12u %14.1f %14.1f %14.1f\n", "raw",
+           raw.minPayload, raw.maxPayload, (double)raw.payload / sleeps,
+           (double)raw.request / sleeps, (double)raw.ms / sleeps);
+    printf("%-8s %12u %12u %14.1f %14.1f %14.1f\n", "encoded",
+           enc.minPayload, enc.maxPayload, (double)enc.payload / sleeps,
+           (double)enc.request / sleeps, (double)enc.ms / sleeps);
+    printf("\nI2C transmit time saved per day: %.1f s\n", (raw.ms - enc.ms) / 1000.0);
+    printf("round-trip failures: %u\n", failures);
+    return failures ? 1 : 0;
+}
@@ -4,21 +4,24 @@
 // module-global variables, and function prototypes used across all
 // compilation units in the solar_battery_dispatcher sketch.
 //
-// Implementation is split across four files in this sketch folder:
+// Implementation is split across these files in this sketch folder:
 //   solar_battery_dispatcher.ino  -- setup, loop, global definitions
 //   dispatcher.h                  -- this file
-//   notecard_helpers.cpp          -- Notecard config, env-var fetch, dispatch polling
+//   notecard_helpers.cpp          -- Notecard config, env-var fetch, dispatch
+//                                    and tariff-schedule polling
 //   modbus_helpers.cpp            -- Modbus bus init and device polling
 //   mode_helpers.cpp              -- mode resolution, relay control, note emission
+//   planner.h / planner.cpp       -- look-ahead dispatch planner (no Arduino deps)
 
 #pragma once
 #include <Arduino.h>
 #include <Notecard.h>
 #include <ArduinoRS485.h>
 #include <ArduinoModbus.h>
-#include <string.h>    // strstr
+#include <string.h>    // strstr, memcmp, memcpy
 #include <strings.h>   // strcasecmp
 #include <math.h>      // isnan, isinf
+#include "planner.h"
 
 #define usbSerial Serial
 
@@ -93,6 +96,13 @@ extern uint8_t  g_modbus_parity;
 extern uint8_t  g_modbus_stop_bits;
 extern uint16_t g_reg_inv_base;
 extern uint16_t g_reg_bms_base;
+extern uint8_t  g_planner_enabled;
+extern float    g_batt_wh;
+extern float    g_batt_charge_w;
+extern float    g_batt_discharge_w;
+extern float    g_batt_eff_pct;
+extern float    g_price_import;
+extern float    g_price_export;
 
 // -------- Runtime state (defined in .ino) ------------------------------------
 extern DispatchMode   g_commanded_mode;   // set by checkDispatch, consumed by resolveMode
@@ -100,6 +110,10 @@ extern DispatchMode   g_active_mode;      // last mode applied; read by sendTele
 extern uint32_t       g_dr_expires_epoch; // 0 = command persists until superseded
 extern InverterSample g_inv;              // most recent inverter sample
 extern BmsSample      g_bms;             // most recent BMS sample
+extern PlanSchedule   g_schedule;         // tariff.db windows/events + base prices
+extern PvForecast     g_forecast;         // learned PV / load profile
+extern Plan           g_plan;             // current look-ahead policy
+extern bool           g_plan_dirty;       // schedule or planner config changed
 
 // -------- Function prototypes -----------------------------------------------
 // notecard_helpers.cpp
@@ -109,6 +123,7 @@ void    fetchEnvOverrides();
 void    applyHubSetIfChanged(const char *product_uid);
 bool    isQueueEmpty(const char *err);
 void    checkDispatch();
+void    fetchTariffSchedule(uint32_t utc_epoch);
 
 // modbus_helpers.cpp
 void    applyModbusIfChanged();
@@ -121,3 +136,4 @@ DispatchMode resolveMode(uint32_t utc_epoch, bool bms_valid, float soc_pct);
 void         applyRelays(DispatchMode mode, float soc_pct, bool bms_valid);
 void         sendTelemetry();
 void         sendModeEvent(DispatchMode new_mode, DispatchMode old_mode);
+void         plannerStep(uint32_t utc_epoch);
@@ -1,8 +1,8 @@
 // mode_helpers.cpp
 //
-// UTC time utilities, operating-mode resolution with TOU schedule and SOC
-// guards, relay output control, and outbound note emission for the
-// solar_battery_dispatcher sketch.
+// UTC time utilities, look-ahead planner scheduling, operating-mode
+// resolution with planner / TOU schedule and SOC guards, relay output
+// control, and outbound note emission for the solar_battery_dispatcher sketch.
 
 #include "dispatcher.h"
 
@@ -72,8 +72,63 @@ uint32_t currentUtcEpoch() {
     return 0;   // never acquired a valid time (pre-first-sync)
 }
 
+// -------- Look-ahead planner -----------------------------------------------
+// Called once per sample cycle. Every valid inverter sample trains the PV and
+// load forecast whether or not the planner is enabled, so enabling it later
+// starts from a warm profile. The backward pass (96 slots × 41 SOC levels ×
+// 3 actions) is re-run at each 15-minute slot boundary — picking up the
+// forecast's latest clearness correction — and immediately after tariff.db or
+// planner env vars change. Between re-plans the policy already covers every
+// SOC, so a battery that drifts from the forecast needs no re-plan.
+void plannerStep(uint32_t utc_epoch) {
+    if (utc_epoch == 0) return;   // no network time yet; slots are meaningless
+    if (g_inv.valid) {
+        forecastAddSample(g_forecast, utc_epoch, g_inv.pv_w, g_inv.ac_out_w);
+    }
+    if (!g_planner_enabled) {
+        g_plan.valid = false;
+        return;
+    }
+    if (!g_plan_dirty && g_plan.valid && utc_epoch / PLAN_SLOT_SEC == g_plan.start_slot) return;
+
+    g_schedule.base_import = g_price_import;
+    g_schedule.base_export = g_price_export;
+    PlanBattery b;
+    b.capacity_wh     = g_batt_wh;
+    b.max_charge_w    = g_batt_charge_w;
+    b.max_discharge_w = g_batt_discharge_w;
+    b.efficiency      = g_batt_eff_pct / 100.0f;
+    b.soc_min_pct     = g_soc_min_pct;
+    b.soc_max_pct     = g_soc_max_pct;
+
+    const uint32_t t0 = millis();
+    planBuild(g_plan, g_schedule, b, g_forecast, utc_epoch, g_bms.valid ? g_bms.soc_pct : g_soc_min_pct);
+    g_plan_dirty = false;
+
+    PlanAction now_action = PLAN_SELF;
+    planAction(g_plan, utc_epoch, g_bms.valid ? g_bms.soc_pct : g_soc_min_pct, now_action);
+    usbSerial.print("[planner] re-planned in ");
+    usbSerial.print(millis() - t0);
+    usbSerial.print(" ms, horizon cost ");
+    usbSerial.print(g_plan.expected_cost, 2);
+    usbSerial.print(", now: ");
+    usbSerial.println(planActionName(now_action));
+}
+
+static DispatchMode planActionMode(PlanAction a) {
+    switch (a) {
+        case PLAN_CHARGE:    return MODE_OVERNIGHT_CHARGE;
+        case PLAN_DISCHARGE: return MODE_PEAK_DISCHARGE;
+        case PLAN_CURTAIL:   return MODE_DR_CURTAIL;
+        case PLAN_SELF:
+        default:             return MODE_NORMAL;
+    }
+}
+
 // -------- Mode resolution ---------------------------------------------------
-// Priority: cloud dispatch > TOU peak window > TOU off-peak charge > NORMAL.
+// Priority: cloud dispatch > look-ahead plan > TOU peak window > TOU off-peak
+// charge > NORMAL. The plan is only consulted with a valid BMS reading; it
+// supersedes the fixed TOU windows entirely while it is valid.
 //
 // Cloud dispatch commands are stored in g_commanded_mode. The "normal" command
 // maps to MODE_FORCED_NORMAL — a distinct state that is != MODE_NORMAL so it
@@ -100,8 +155,11 @@ DispatchMode resolveMode(uint32_t utc_epoch, bool bms_valid, float soc_pct) {
     // default to disabled (start == end == 0) and engage only after an
     // operator sets them via env vars.
     DispatchMode candidate = MODE_NORMAL;
+    PlanAction   planned   = PLAN_SELF;
     if (g_commanded_mode != MODE_NORMAL) {
         candidate = g_commanded_mode;
+    } else if (bms_valid && planAction(g_plan, utc_epoch, soc_pct, planned)) {
+        candidate = planActionMode(planned);
     } else if (utc_epoch > 0 && isInPeakWindow(utcHour(utc_epoch), g_peak_start_utc, g_peak_end_utc)) {
         candidate = MODE_PEAK_DISCHARGE;
     } else if (utc_epoch > 0 && isInPeakWindow(utcHour(utc_epoch), g_charge_start_utc, g_charge_end_utc)) {
@@ -1,8 +1,8 @@
 // notecard_helpers.cpp
 //
 // Notecard configuration, environment-variable fetch and validation,
-// outbound sync-cadence management, and inbound dispatch-note polling
-// for the solar_battery_dispatcher sketch.
+// outbound sync-cadence management, inbound dispatch-note polling, and
+// tariff-schedule (tariff.db) loading for the solar_battery_dispatcher sketch.
 
 #include "dispatcher.h"
 
@@ -126,6 +126,13 @@ void fetchEnvOverrides() {
     JAddItemToArray(names, JCreateString("modbus_stop_bits"));
     JAddItemToArray(names, JCreateString("reg_inv_base"));
     JAddItemToArray(names, JCreateString("reg_bms_base"));
+    JAddItemToArray(names, JCreateString("planner_enabled"));
+    JAddItemToArray(names, JCreateString("batt_wh"));
+    JAddItemToArray(names, JCreateString("batt_charge_w"));
+    JAddItemToArray(names, JCreateString("batt_discharge_w"));
+    JAddItemToArray(names, JCreateString("batt_eff_pct"));
+    JAddItemToArray(names, JCreateString("price_import"));
+    JAddItemToArray(names, JCreateString("price_export"));
 
     J *rsp = notecard.requestAndResponse(req);
     if (!rsp) return;
@@ -177,6 +184,31 @@ void fetchEnvOverrides() {
     g_reg_inv_base     = (uint16_t)clampU32(envLong(rsp, "reg_inv_base",    g_reg_inv_base),  0, 65530, g_reg_inv_base);
     g_reg_bms_base     = (uint16_t)clampU32(envLong(rsp, "reg_bms_base",    g_reg_bms_base),  0, 65530, g_reg_bms_base);
 
+    // Planner inputs. Any change invalidates the current plan so the next
+    // sample re-plans with the new battery model or prices.
+    {
+        const uint8_t prev_enabled   = g_planner_enabled;
+        const float   prev_wh        = g_batt_wh;
+        const float   prev_ch        = g_batt_charge_w;
+        const float   prev_dis       = g_batt_discharge_w;
+        const float   prev_eff       = g_batt_eff_pct;
+        const float   prev_imp       = g_price_import;
+        const float   prev_exp       = g_price_export;
+        g_planner_enabled  = (uint8_t)clampU32(envLong(rsp, "planner_enabled", g_planner_enabled), 0, 1, g_planner_enabled);
+        g_batt_wh          = clampF(envFloat(rsp, "batt_wh",          g_batt_wh),          500.0f, 1000000.0f, g_batt_wh);
+        g_batt_charge_w    = clampF(envFloat(rsp, "batt_charge_w",    g_batt_charge_w),    100.0f, 100000.0f,  g_batt_charge_w);
+        g_batt_discharge_w = clampF(envFloat(rsp, "batt_discharge_w", g_batt_discharge_w), 100.0f, 100000.0f,  g_batt_discharge_w);
+        g_batt_eff_pct     = clampF(envFloat(rsp, "batt_eff_pct",     g_batt_eff_pct),     50.0f,  100.0f,     g_batt_eff_pct);
+        g_price_import     = clampF(envFloat(rsp, "price_import",     g_price_import),     0.0f,   10.0f,      g_price_import);
+        g_price_export     = clampF(envFloat(rsp, "price_export",     g_price_export),     0.0f,   10.0f,      g_price_export);
+        if (g_planner_enabled != prev_enabled || g_batt_wh != prev_wh ||
+            g_batt_charge_w != prev_ch || g_batt_discharge_w != prev_dis ||
+            g_batt_eff_pct != prev_eff || g_price_import != prev_imp ||
+            g_price_export != prev_exp) {
+            g_plan_dirty = true;
+        }
+    }
+
     notecard.deleteResponse(rsp);
 }
 
@@ -278,3 +310,95 @@ void checkDispatch() {
     }
     notecard.deleteResponse(rsp);
 }
+
+// -------- Tariff / DR schedule ----------------------------------------------
+// tariff.db is a bidirectional database Notefile edited from the cloud (Notehub
+// API note.add / note.update), so the schedule survives reboots on the
+// Notecard and a new entry reaches the device on the next inbound sync.
+// Each Note is one of:
+//   {"start_min":960,"end_min":1260,"import":0.42,"export":0.05}
+//       daily TOU window, UTC minutes of day (start > end wraps midnight)
+//   {"start_epoch":1767283200,"end_epoch":1767290400,"import":1.50,"curtail":true}
+//       one-off DR event; expired events are skipped
+// Malformed entries are logged and skipped. The whole file is re-read on each
+// call and g_plan_dirty is raised only if the parsed schedule changed.
+void fetchTariffSchedule(uint32_t utc_epoch) {
+    J *req = notecard.newRequest("note.changes");
+    if (!req) return;
+    JAddStringToObject(req, "file", "tariff.db");
+    JAddNumberToObject(req, "max",  PLAN_MAX_WINDOWS + PLAN_MAX_EVENTS + 4);
+
+    J *rsp = notecard.requestAndResponse(req);
+    if (!rsp) return;
+    if (notecard.responseError(rsp)) {
+        // No tariff.db yet is normal until the first schedule is pushed;
+        // keep whatever schedule is loaded.
+        usbSerial.print("[planner] tariff.db: ");
+        usbSerial.println(JGetString(rsp, "err"));
+        notecard.deleteResponse(rsp);
+        return;
+    }
+
+    // Zero the whole struct so the memcmp below is not confused by padding.
+    PlanSchedule next;
+    memset(&next, 0, sizeof(next));
+    next.base_import = g_schedule.base_import;
+    next.base_export = g_schedule.base_export;
+
+    J *notes = JGetObject(rsp, "notes");
+    for (J *n = notes ? notes->child : nullptr; n; n = n->next) {
+        J *body = JGetObject(n, "body");
+        if (!body) continue;
+        const double imp = JGetNumber(body, "import");
+        if (isnan(imp) || isinf(imp) || imp < 0.0) continue;
+
+        if (JIsPresent(body, "start_min")) {
+            const double st = JGetNumber(body, "start_min");
+            const double en = JGetNumber(body, "end_min");
+            const double ex = JIsPresent(body, "export") ? JGetNumber(body, "export") : g_price_export;
+            if (st < 0 || st >= 1440 || en < 0 || en >= 1440 || isnan(ex) || ex < 0) {
+                usbSerial.print("[planner] tariff.db window rejected: ");
+                usbSerial.println(n->string ? n->string : "(unnamed)");
+                continue;
+            }
+            if (next.n_windows >= PLAN_MAX_WINDOWS) {
+                usbSerial.println("[planner] tariff.db: too many windows, extras ignored");
+                continue;
+            }
+            TariffWindow &w = next.windows[next.n_windows++];
+            w.start_min    = (uint16_t)st;
+            w.end_min      = (uint16_t)en;
+            w.import_price = (float)imp;
+            w.export_price = (float)ex;
+        } else if (JIsPresent(body, "start_epoch")) {
+            const uint32_t st = (uint32_t)JGetNumber(body, "start_epoch");
+            const uint32_t en = (uint32_t)JGetNumber(body, "end_epoch");
+            if (en <= st) {
+                usbSerial.print("[planner] tariff.db event rejected: ");
+                usbSerial.println(n->string ? n->string : "(unnamed)");
+                continue;
+            }
+            if (utc_epoch > 0 && en <= utc_epoch) continue;   // already over
+            if (next.n_events >= PLAN_MAX_EVENTS) {
+                usbSerial.println("[planner] tariff.db: too many events, extras ignored");
+                continue;
+            }
+            DrEvent &e = next.events[next.n_events++];
+            e.start_epoch  = st;
+            e.end_epoch    = en;
+            e.import_price = (float)imp;
+            e.curtail      = JGetBool(body, "curtail");
+        }
+    }
+    notecard.deleteResponse(rsp);
+
+    if (memcmp(&next, &g_schedule, sizeof(next)) != 0) {
+        memcpy(&g_schedule, &next, sizeof(next));
+        g_plan_dirty = true;
+        usbSerial.print("[planner] tariff.db loaded: ");
+        usbSerial.print(g_schedule.n_windows);
+        usbSerial.print(" window(s), ");
+        usbSerial.print(g_schedule.n_events);
+        usbSerial.println(" event(s)");
+    }
+}
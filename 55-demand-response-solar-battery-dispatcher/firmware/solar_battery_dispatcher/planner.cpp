@@ -0,0 +1,268 @@
+// planner.cpp
+//
+// Look-ahead dispatch planner: PV/load forecast, tariff lookup, one-slot
+// battery model and the backward dynamic-programming pass that produces the
+// per-(slot, SOC) policy. See planner.h for the data layout.
+
+#include "planner.h"
+#include <math.h>
+
+// Profile slots below this PV level (dawn, dusk, night) are too noisy to
+// estimate a clearness ratio from.
+#define CLEARNESS_MIN_PV_W   200
+// Slots over which the same-day clearness ratio fades back to 1.0 (2 h).
+#define CLEARNESS_FADE_SLOTS 8
+// A non-SELF action must beat SELF by at least this much (currency units) to
+// be chosen, so flat tariffs do not cycle the battery for rounding noise.
+#define PLAN_TIE_EPS         0.0005f
+
+// -------- Forecast ----------------------------------------------------------
+void forecastInit(PvForecast &f) {
+    for (uint8_t i = 0; i < PLAN_SLOTS; i++) {
+        f.pv_w[i]   = FORECAST_UNSEEN;
+        f.load_w[i] = FORECAST_UNSEEN;
+    }
+    f.clearness    = 1.0f;
+    f.last_load_w  = 0;
+    f.acc_slot     = 0;
+    f.acc_pv_sum   = 0;
+    f.acc_load_sum = 0;
+    f.acc_n        = 0;
+}
+
+static int16_t clampW(int32_t w) {
+    if (w < 0)     return 0;
+    if (w > 32767) return 32767;
+    return (int16_t)w;
+}
+
+// Fold a closed slot's averages into the day profile (EWMA, alpha 1/4) and
+// refresh the same-day clearness ratio from the pre-update profile.
+static void forecastCloseSlot(PvForecast &f) {
+    const int32_t  pv   = f.acc_pv_sum   / f.acc_n;
+    const int32_t  load = f.acc_load_sum / f.acc_n;
+    const uint8_t  idx  = (uint8_t)(f.acc_slot % PLAN_SLOTS);
+    const int16_t  prev = f.pv_w[idx];
+
+    if (prev != FORECAST_UNSEEN && prev >= CLEARNESS_MIN_PV_W) {
+        float r = (float)pv / (float)prev;
+        f.clearness = (r > 2.0f) ? 2.0f : r;
+    } else if (pv < CLEARNESS_MIN_PV_W) {
+        f.clearness = 1.0f;   // night: start each morning neutral
+    }
+
+    f.pv_w[idx]   = (prev == FORECAST_UNSEEN) ? clampW(pv)
+                                               : clampW(prev + (pv - prev) / 4);
+    f.load_w[idx] = (f.load_w[idx] == FORECAST_UNSEEN) ? clampW(load)
+                                                        : clampW(f.load_w[idx] + (load - f.load_w[idx]) / 4);
+    f.last_load_w = load;
+}
+
+void forecastAddSample(PvForecast &f, uint32_t epoch, int32_t pv_w, int32_t load_w) {
+    const uint32_t slot = epoch / PLAN_SLOT_SEC;
+    if (f.acc_slot != 0 && slot != f.acc_slot && f.acc_n > 0) {
+        forecastCloseSlot(f);
+        f.acc_n = 0;
+    }
+    if (f.acc_n == 0) {
+        f.acc_slot     = slot;
+        f.acc_pv_sum   = 0;
+        f.acc_load_sum = 0;
+    }
+    f.acc_pv_sum   += pv_w;
+    f.acc_load_sum += load_w;
+    f.acc_n++;
+}
+
+float forecastPvW(const PvForecast &f, uint32_t slot_epoch, uint32_t now_epoch) {
+    const int16_t p = f.pv_w[(slot_epoch / PLAN_SLOT_SEC) % PLAN_SLOTS];
+    if (p == FORECAST_UNSEEN) return 0.0f;   // no history: assume no PV
+    const uint32_t ahead = (slot_epoch > now_epoch) ? (slot_epoch - now_epoch) / PLAN_SLOT_SEC : 0;
+    if (ahead >= CLEARNESS_FADE_SLOTS) return (float)p;
+    const float w = (float)(CLEARNESS_FADE_SLOTS - ahead) / CLEARNESS_FADE_SLOTS;
+    return (float)p * (1.0f + (f.clearness - 1.0f) * w);
+}
+
+float forecastLoadW(const PvForecast &f, uint32_t slot_epoch) {
+    const int16_t l = f.load_w[(slot_epoch / PLAN_SLOT_SEC) % PLAN_SLOTS];
+    return (l == FORECAST_UNSEEN) ? (float)f.last_load_w : (float)l;
+}
+
+// -------- Schedule ----------------------------------------------------------
+static bool inWindow(uint16_t minute, uint16_t start, uint16_t end) {
+    if (start == end) return false;
+    if (start < end)  return (minute >= start && minute < end);
+    return (minute >= start || minute < end);
+}
+
+void scheduleAt(const PlanSchedule &s, uint32_t epoch,
+                float &import_price, float &export_price, bool &curtail) {
+    import_price = s.base_import;
+    export_price = s.base_export;
+    curtail      = false;
+
+    // First matching TOU window wins; dated events override windows.
+    const uint16_t minute = (uint16_t)((epoch % 86400UL) / 60UL);
+    for (uint8_t i = 0; i < s.n_windows; i++) {
+        if (inWindow(minute, s.windows[i].start_min, s.windows[i].end_min)) {
+            import_price = s.windows[i].import_price;
+            export_price = s.windows[i].export_price;
+            break;
+        }
+    }
+    for (uint8_t i = 0; i < s.n_events; i++) {
+        if (epoch >= s.events[i].start_epoch && epoch < s.events[i].end_epoch) {
+            import_price = s.events[i].import_price;
+            curtail     |= s.events[i].curtail;
+        }
+    }
+}
+
+// -------- Battery model -----------------------------------------------------
+SlotFlows simulateSlot(const PlanBattery &b, PlanAction a, float soc_wh,
+                       float pv_w, float load_w, uint32_t slot_sec) {
+    const float h      = (float)slot_sec / 3600.0f;
+    const float eta    = sqrtf(b.efficiency);
+    const float min_wh = b.capacity_wh * b.soc_min_pct / 100.0f;
+    const float max_wh = b.capacity_wh * b.soc_max_pct / 100.0f;
+    const float net_w  = pv_w - load_w;
+
+    float room_w  = (max_wh - soc_wh) / (h * eta);
+    float avail_w = (soc_wh - min_wh) * eta / h;
+    if (room_w  < 0.0f) room_w  = 0.0f;
+    if (avail_w < 0.0f) avail_w = 0.0f;
+
+    SlotFlows r = { 0.0f, 0.0f, soc_wh };
+    switch (a) {
+        case PLAN_SELF: {
+            if (net_w > 0.0f) {
+                const float ch = fminf(fminf(net_w, b.max_charge_w), room_w);
+                r.soc_wh   += ch * h * eta;
+                r.export_wh = (net_w - ch) * h;
+            } else {
+                r.import_wh = -net_w * h;
+            }
+            break;
+        }
+        case PLAN_CHARGE: {
+            const float ch     = fminf(b.max_charge_w, room_w);
+            const float grid_w = load_w + ch - pv_w;
+            r.soc_wh += ch * h * eta;
+            if (grid_w > 0.0f) r.import_wh =  grid_w * h;
+            else               r.export_wh = -grid_w * h;
+            break;
+        }
+        case PLAN_DISCHARGE: {
+            // Charge relay is open in PEAK_DISCHARGE, so PV surplus exports.
+            if (net_w < 0.0f) {
+                const float dis = fminf(fminf(-net_w, b.max_discharge_w), avail_w);
+                r.soc_wh   -= dis * h / eta;
+                r.import_wh = (-net_w - dis) * h;
+            } else {
+                r.export_wh = net_w * h;
+            }
+            break;
+        }
+        case PLAN_CURTAIL:
+        default:
+            // Export relay open, battery relays open: surplus PV is curtailed.
+            if (net_w < 0.0f) r.import_wh = -net_w * h;
+            break;
+    }
+    return r;
+}
+
+// -------- Planner -----------------------------------------------------------
+// Linear interpolation of the value function at soc_wh.
+static float valueAt(const float *v, float soc_wh, float capacity_wh) {
+    float x = soc_wh / capacity_wh * (PLAN_SOC_LEVELS - 1);
+    if (x <= 0.0f)                    return v[0];
+    if (x >= PLAN_SOC_LEVELS - 1)     return v[PLAN_SOC_LEVELS - 1];
+    const uint8_t i = (uint8_t)x;
+    const float   t = x - (float)i;
+    return v[i] + (v[i + 1] - v[i]) * t;
+}
+
+static void policySet(Plan &p, uint16_t idx, PlanAction a) {
+    const uint8_t shift = (uint8_t)((idx & 3u) * 2u);
+    p.policy[idx >> 2] = (uint8_t)((p.policy[idx >> 2] & ~(3u << shift)) | ((uint8_t)a << shift));
+}
+
+static PlanAction policyGet(const Plan &p, uint16_t idx) {
+    return (PlanAction)((p.policy[idx >> 2] >> ((idx & 3u) * 2u)) & 3u);
+}
+
+void planBuild(Plan &p, const PlanSchedule &s, const PlanBattery &b,
+               const PvForecast &f, uint32_t now_epoch, float soc_pct) {
+    p.valid      = false;
+    p.start_slot = now_epoch / PLAN_SLOT_SEC;
+    if (b.capacity_wh <= 0.0f) return;
+
+    // Energy left in the battery at the horizon is valued at the cheapest
+    // import price the horizon offers — what it would cost to put it back.
+    float min_import = 1e9f;
+    for (uint8_t t = 0; t < PLAN_SLOTS; t++) {
+        float pi, pe; bool c;
+        scheduleAt(s, (p.start_slot + t) * PLAN_SLOT_SEC, pi, pe, c);
+        if (pi < min_import) min_import = pi;
+    }
+
+    const float min_wh = b.capacity_wh * b.soc_min_pct / 100.0f;
+    const float eta    = sqrtf(b.efficiency);
+    float va[PLAN_SOC_LEVELS], vb[PLAN_SOC_LEVELS];
+    float *next = va, *cur = vb;
+    for (uint8_t i = 0; i < PLAN_SOC_LEVELS; i++) {
+        const float wh     = b.capacity_wh * i / (PLAN_SOC_LEVELS - 1);
+        const float usable = (wh > min_wh) ? (wh - min_wh) * eta : 0.0f;
+        next[i] = -usable * min_import / 1000.0f;
+    }
+
+    for (int t = PLAN_SLOTS - 1; t >= 0; t--) {
+        const uint32_t slot_epoch = (p.start_slot + (uint32_t)t) * PLAN_SLOT_SEC;
+        const float    pv   = forecastPvW(f, slot_epoch, now_epoch);
+        const float    load = forecastLoadW(f, slot_epoch);
+        float pi, pe; bool curtail;
+        scheduleAt(s, slot_epoch, pi, pe, curtail);
+
+        for (uint8_t i = 0; i < PLAN_SOC_LEVELS; i++) {
+            const float wh = b.capacity_wh * i / (PLAN_SOC_LEVELS - 1);
+            PlanAction best      = curtail ? PLAN_CURTAIL : PLAN_SELF;
+            float      best_cost = 0.0f;
+            for (uint8_t a = 0; a < 3; a++) {
+                const PlanAction act = curtail ? PLAN_CURTAIL : (PlanAction)a;
+                const SlotFlows  r   = simulateSlot(b, act, wh, pv, load, PLAN_SLOT_SEC);
+                const float cost = (r.import_wh * pi - r.export_wh * pe) / 1000.0f
+                                 + valueAt(next, r.soc_wh, b.capacity_wh);
+                if (a == 0) { best_cost = cost; if (curtail) break; continue; }
+                if (cost < best_cost - PLAN_TIE_EPS) { best = act; best_cost = cost; }
+            }
+            cur[i] = best_cost;
+            policySet(p, (uint16_t)(t * PLAN_SOC_LEVELS + i), best);
+        }
+        float *tmp = next; next = cur; cur = tmp;
+    }
+
+    p.expected_cost = valueAt(next, b.capacity_wh * soc_pct / 100.0f, b.capacity_wh);
+    p.valid         = true;
+}
+
+bool planAction(const Plan &p, uint32_t now_epoch, float soc_pct, PlanAction &out) {
+    if (!p.valid) return false;
+    const uint32_t slot = now_epoch / PLAN_SLOT_SEC;
+    if (slot < p.start_slot || slot - p.start_slot >= PLAN_SLOTS) return false;
+    float x = soc_pct / 100.0f * (PLAN_SOC_LEVELS - 1) + 0.5f;
+    if (x < 0.0f)                x = 0.0f;
+    if (x > PLAN_SOC_LEVELS - 1) x = PLAN_SOC_LEVELS - 1;
+    out = policyGet(p, (uint16_t)((slot - p.start_slot) * PLAN_SOC_LEVELS + (uint8_t)x));
+    return true;
+}
+
+const char *planActionName(PlanAction a) {
+    switch (a) {
+        case PLAN_SELF:      return "self";
+        case PLAN_CHARGE:    return "charge";
+        case PLAN_DISCHARGE: return "discharge";
+        case PLAN_CURTAIL:   return "curtail";
+        default:             return "unknown";
+    }
+}
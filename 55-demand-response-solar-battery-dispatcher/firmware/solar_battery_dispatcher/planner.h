@@ -0,0 +1,141 @@
+// planner.h
+//
+// Look-ahead dispatch planner for the solar_battery_dispatcher sketch.
+//
+// Builds a 24-hour state-of-charge plan over 15-minute slots from three
+// inputs: the tariff / demand-response schedule (tariff.db), a rolling PV and
+// load forecast learned from recent samples, and the battery limits. The plan
+// is a closed-loop policy — one action per (slot, SOC level) — so a battery
+// that drifts from the predicted trajectory simply reads a different row on
+// the next sample instead of forcing a re-plan.
+//
+// This module is plain arithmetic with no Arduino, Notecard or Modbus
+// dependencies, so the same planner.cpp builds into the sketch and into the
+// host simulation harness in sim/.
+//
+// RAM: Plan ≈ 1 KB (2-bit packed policy), PvForecast ≈ 0.4 KB,
+//      PlanSchedule ≈ 0.2 KB; the backward pass uses ~0.4 KB of stack.
+
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+
+// -------- Plan geometry -----------------------------------------------------
+#define PLAN_SLOT_SEC      900UL   // 15-minute slots
+#define PLAN_SLOTS         96      // 24-hour horizon
+#define PLAN_SOC_LEVELS    41      // SOC grid: 0 %, 2.5 %, … 100 %
+#define PLAN_MAX_WINDOWS   8       // daily TOU windows held from tariff.db
+#define PLAN_MAX_EVENTS    4       // dated DR events held from tariff.db
+
+// -------- Per-slot actions --------------------------------------------------
+// Each action maps onto an existing DispatchMode so relay control, the SOC
+// guards and dr_event.qo emission stay exactly as they are for TOU/cloud modes.
+//   PLAN_SELF       NORMAL           PV surplus charges, no discharge
+//   PLAN_CHARGE     OVERNIGHT_CHARGE grid + PV charge at the charge limit
+//   PLAN_DISCHARGE  PEAK_DISCHARGE   battery covers load, PV surplus exports
+//   PLAN_CURTAIL    DR_CURTAIL       forced for curtail events; no export
+enum PlanAction {
+    PLAN_SELF      = 0,
+    PLAN_CHARGE    = 1,
+    PLAN_DISCHARGE = 2,
+    PLAN_CURTAIL   = 3
+};
+
+// -------- Tariff / event schedule -------------------------------------------
+// Daily recurring time-of-use window, UTC minutes of day. start > end wraps
+// midnight, start == end is ignored (matches isInPeakWindow()).
+struct TariffWindow {
+    uint16_t start_min;
+    uint16_t end_min;
+    float    import_price;   // per kWh imported
+    float    export_price;   // per kWh exported
+};
+
+// One-off demand-response event. A curtail event forces DR_CURTAIL for its
+// slots; the planner's job is to arrive at it with the battery full.
+struct DrEvent {
+    uint32_t start_epoch;
+    uint32_t end_epoch;
+    float    import_price;   // event import price (often a penalty rate)
+    bool     curtail;
+};
+
+struct PlanSchedule {
+    float        base_import;   // price outside every window
+    float        base_export;
+    uint8_t      n_windows;
+    TariffWindow windows[PLAN_MAX_WINDOWS];
+    uint8_t      n_events;
+    DrEvent      events[PLAN_MAX_EVENTS];
+};
+
+// -------- Battery model -----------------------------------------------------
+struct PlanBattery {
+    float capacity_wh;
+    float max_charge_w;
+    float max_discharge_w;
+    float efficiency;       // round trip, 0–1; applied as sqrt() each way
+    float soc_min_pct;      // planner never discharges below this
+    float soc_max_pct;      // planner never charges above this
+};
+
+// -------- PV / load forecast ------------------------------------------------
+// Per-slot-of-day profiles, exponentially averaged across days (alpha 1/4),
+// plus a same-day clearness ratio (actual ÷ profile PV over the last completed
+// slot) that scales the next few hours and decays back to 1.0 — so a cloudy
+// morning lowers the afternoon forecast without rewriting the profile.
+#define FORECAST_UNSEEN    INT16_MIN   // profile slot has no history yet
+
+struct PvForecast {
+    int16_t  pv_w[PLAN_SLOTS];
+    int16_t  load_w[PLAN_SLOTS];
+    float    clearness;       // actual / profile PV, clamped 0–2
+    int32_t  last_load_w;     // persistence fallback for unseen load slots
+    // Open slot accumulation
+    uint32_t acc_slot;        // epoch / PLAN_SLOT_SEC of the open slot; 0 = none
+    int32_t  acc_pv_sum;
+    int32_t  acc_load_sum;
+    uint16_t acc_n;
+};
+
+// -------- Plan --------------------------------------------------------------
+struct Plan {
+    bool     valid;
+    uint32_t start_slot;              // epoch / PLAN_SLOT_SEC of policy slot 0
+    float    expected_cost;           // horizon cost from the SOC at build time
+    uint8_t  policy[(PLAN_SLOTS * PLAN_SOC_LEVELS + 3) / 4];   // 2 bits each
+};
+
+// Result of simulating one slot; used by the planner and the sim harness.
+struct SlotFlows {
+    float import_wh;
+    float export_wh;
+    float soc_wh;             // battery energy at the end of the slot
+};
+
+// -------- Function prototypes -----------------------------------------------
+void        forecastInit(PvForecast &f);
+// Feed one valid inverter sample. Closes the open slot (updating the profile
+// and clearness ratio) when the sample falls in a later slot.
+void        forecastAddSample(PvForecast &f, uint32_t epoch, int32_t pv_w, int32_t load_w);
+// Forecast for the slot starting at slot_epoch, as seen from now_epoch.
+float       forecastPvW(const PvForecast &f, uint32_t slot_epoch, uint32_t now_epoch);
+float       forecastLoadW(const PvForecast &f, uint32_t slot_epoch);
+
+// Prices and curtail flag in force at epoch.
+void        scheduleAt(const PlanSchedule &s, uint32_t epoch,
+                       float &import_price, float &export_price, bool &curtail);
+
+// Energy flows for one slot under action a, starting at soc_wh.
+SlotFlows   simulateSlot(const PlanBattery &b, PlanAction a, float soc_wh,
+                         float pv_w, float load_w, uint32_t slot_sec);
+
+// Backward pass over the horizon starting at the slot containing now_epoch.
+// soc_pct only sets expected_cost; the policy covers every SOC level.
+void        planBuild(Plan &p, const PlanSchedule &s, const PlanBattery &b,
+                      const PvForecast &f, uint32_t now_epoch, float soc_pct);
+// Action for now_epoch at the measured SOC. Returns false when the plan is
+// invalid or now_epoch is outside its horizon.
+bool        planAction(const Plan &p, uint32_t now_epoch, float soc_pct, PlanAction &out);
+
+const char *planActionName(PlanAction a);
@@ -14,12 +14,14 @@
 //   - ArduinoModbus, ArduinoRS485              -- install via Library Manager
 //   - Arduino Mbed OS Opta Boards (core)       -- install via Boards Manager
 //
-// Implementation is split across four files in this sketch folder:
+// Implementation is split across these files in this sketch folder:
 //   solar_battery_dispatcher.ino  -- setup, loop, global definitions (this file)
 //   dispatcher.h                  -- shared types, externs, function prototypes
-//   notecard_helpers.cpp          -- Notecard config, env-var fetch, dispatch polling
+//   notecard_helpers.cpp          -- Notecard config, env-var fetch, dispatch
+//                                    and tariff-schedule polling
 //   modbus_helpers.cpp            -- Modbus bus init and device polling
 //   mode_helpers.cpp              -- mode resolution, relay control, note emission
+//   planner.h / planner.cpp       -- look-ahead dispatch planner (no Arduino deps)
 
 #include "dispatcher.h"
 
@@ -60,6 +62,16 @@ uint8_t  g_modbus_parity     = 0;      // 0=none(N), 1=even(E), 2=odd(O)
 uint8_t  g_modbus_stop_bits  = 1;      // 1 or 2
 uint16_t g_reg_inv_base      = 100;    // inverter holding-register block start
 uint16_t g_reg_bms_base      = 200;    // BMS holding-register block start
+// Look-ahead planner — DISABLED by default for the same reason as the TOU
+// windows. When enabled it replaces the fixed TOU windows (cloud dispatch
+// still wins) and needs the battery figures below to match the installation.
+uint8_t  g_planner_enabled   = 0;
+float    g_batt_wh           = 10000.0f; // usable battery capacity (Wh)
+float    g_batt_charge_w     = 3000.0f;  // inverter charge limit (W)
+float    g_batt_discharge_w  = 3000.0f;  // inverter discharge limit (W)
+float    g_batt_eff_pct      = 90.0f;    // round-trip efficiency (%)
+float    g_price_import      = 0.15f;    // import price outside tariff.db windows (/kWh)
+float    g_price_export      = 0.05f;    // export credit outside tariff.db windows (/kWh)
 
 // -------- Runtime state -----------------------------------------------------
 // g_commanded_mode is set by checkDispatch() and consumed by resolveMode().
@@ -70,6 +82,10 @@ DispatchMode   g_active_mode      = MODE_NORMAL;
 uint32_t       g_dr_expires_epoch = 0;
 InverterSample g_inv              = {};
 BmsSample      g_bms              = {};
+PlanSchedule   g_schedule         = {};
+PvForecast     g_forecast         = {};
+Plan           g_plan             = {};
+bool           g_plan_dirty       = true;
 
 // -------- File-private state ------------------------------------------------
 static DispatchMode s_prev_mode     = MODE_NORMAL;
@@ -103,6 +119,8 @@ void setup() {
     fetchEnvOverrides();
     applyHubSetIfChanged(PRODUCT_UID);   // applies any report_minutes override at boot
     applyModbusIfChanged();
+    forecastInit(g_forecast);
+    fetchTariffSchedule(currentUtcEpoch());
 
     last_sample_ms = millis();
     last_report_ms = millis();
@@ -124,6 +142,7 @@ void loop() {
         // comm loss (see mode_helpers.cpp: applyRelays()).
         const uint32_t epoch         = currentUtcEpoch();
         const float    soc_for_guard = g_bms.valid ? g_bms.soc_pct : 0.0f;
+        plannerStep(epoch);   // learn from this sample; re-plan on slot boundary
         DispatchMode   new_mode      = resolveMode(epoch, g_bms.valid, soc_for_guard);
         applyRelays(new_mode, soc_for_guard, g_bms.valid);
 
@@ -146,6 +165,7 @@ void loop() {
         fetchEnvOverrides();
         applyModbusIfChanged();
         applyHubSetIfChanged(PRODUCT_UID);   // re-issues hub.set if report_minutes changed
+        fetchTariffSchedule(currentUtcEpoch());
         sendTelemetry();
         last_report_ms = now;
     }
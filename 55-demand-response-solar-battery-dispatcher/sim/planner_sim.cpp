@@ -0,0 +1,228 @@
+// planner_sim.cpp
+//
+// Linux replay harness for the look-ahead dispatch planner. Builds the
+// firmware's planner.cpp unchanged, replays recorded telemetry through three
+// strategies and reports the energy cost of each over the final 24 hours:
+//
+//   self     MODE_NORMAL all day (PV self-consumption, no dispatch)
+//   tou      the reactive firmware: fixed peak-discharge / charge windows
+//   planner  the look-ahead plan, re-built at every 15-minute slot exactly as
+//            plannerStep() does on the device
+//
+// Every row before the final 24 hours only trains the PV / load forecast, so
+// a file with a day or more of history before the evaluated day gives the
+// planner the warm profile it would have in the field.
+//
+// Build and run (from this directory):
+//   g++ -O2 -std=c++11 -I../firmware/solar_battery_dispatcher planner_sim.cpp
+//       ../firmware/solar_battery_dispatcher/planner.cpp -o planner_sim
+//   ./planner_sim sample_telemetry.csv sample_tariff.csv --peak 17-21 --charge 0-6
+//
+// Telemetry CSV: header line, then epoch,pv_w,load_w at any fixed cadence
+// (export the solar_telemetry.qo pv_w and ac_out_w columns from Notehub).
+// Tariff CSV: see sample_tariff.csv; '#' lines are comments.
+
+#include "planner.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+struct Row { uint32_t epoch; float pv_w; float load_w; };
+
+struct Totals {
+    double cost;
+    double import_kwh;
+    double export_kwh;
+    float  soc_wh;
+};
+
+static bool loadTelemetry(const char *path, std::vector<Row> &rows) {
+    FILE *f = fopen(path, "r");
+    if (!f) { perror(path); return false; }
+    char line[128];
+    while (fgets(line, sizeof(line), f)) {
+        Row r;
+        unsigned long e;
+        if (sscanf(line, "%lu,%f,%f", &e, &r.pv_w, &r.load_w) != 3) continue;   // header
+        r.epoch = (uint32_t)e;
+        rows.push_back(r);
+    }
+    fclose(f);
+    return rows.size() >= 2;
+}
+
+static bool loadTariff(const char *path, PlanSchedule &s) {
+    FILE *f = fopen(path, "r");
+    if (!f) { perror(path); return false; }
+    char line[160];
+    while (fgets(line, sizeof(line), f)) {
+        if (line[0] == '#' || line[0] == '\n') continue;
+        char kind[8];
+        unsigned long a, b;
+        float imp, last;
+        if (sscanf(line, "%7[^,],%lu,%lu,%f,%f", kind, &a, &b, &imp, &last) != 5) {
+            fprintf(stderr, "tariff: bad line: %s", line);
+            return false;
+        }
+        if (strcmp(kind, "tou") == 0 && s.n_windows < PLAN_MAX_WINDOWS) {
+            TariffWindow &w = s.windows[s.n_windows++];
+            w.start_min = (uint16_t)a; w.end_min = (uint16_t)b;
+            w.import_price = imp;      w.export_price = last;
+        } else if (strcmp(kind, "event") == 0 && s.n_events < PLAN_MAX_EVENTS) {
+            DrEvent &e = s.events[s.n_events++];
+            e.start_epoch = (uint32_t)a; e.end_epoch = (uint32_t)b;
+            e.import_price = imp;        e.curtail = (last != 0.0f);
+        } else {
+            fprintf(stderr, "tariff: ignored: %s", line);
+        }
+    }
+    fclose(f);
+    return true;
+}
+
+// Mirrors isInPeakWindow() in mode_helpers.cpp (hour granularity, UTC).
+static bool inHourWindow(uint32_t epoch, int start, int end) {
+    const int h = (int)((epoch % 86400UL) / 3600UL);
+    if (start == end) return false;
+    if (start < end)  return h >= start && h < end;
+    return h >= start || h < end;
+}
+
+static bool parseHours(const char *s, int &a, int &b) {
+    return sscanf(s, "%d-%d", &a, &b) == 2 && a >= 0 && a < 24 && b >= 0 && b < 24;
+}
+
+static void account(Totals &t, const SlotFlows &r, const PlanSchedule &s, uint32_t epoch) {
+    float pi, pe; bool c;
+    scheduleAt(s, epoch, pi, pe, c);
+    t.cost       += (r.import_wh * pi - r.export_wh * pe) / 1000.0;
+    t.import_kwh += r.import_wh / 1000.0;
+    t.export_kwh += r.export_wh / 1000.0;
+    t.soc_wh      = r.soc_wh;
+}
+
+static void usage() {
+    fprintf(stderr,
+        "usage: planner_sim telemetry.csv tariff.csv [options]\n"
+        "  --soc PCT          initial SOC (default 50)\n"
+        "  --batt-wh WH       usable capacity (default 10000)\n"
+        "  --charge-w W       charge limit (default 3000)\n"
+        "  --discharge-w W    discharge limit (default 3000)\n"
+        "  --eff PCT          round-trip efficiency (default 90)\n"
+        "  --soc-min PCT      soc_min_pct (default 20)\n"
+        "  --soc-max PCT      soc_max_pct (default 95)\n"
+        "  --import P         price_import outside windows (default 0.15)\n"
+        "  --export P         price_export outside windows (default 0.05)\n"
+        "  --peak H-H         tou baseline peak_start_utc-peak_end_utc\n"
+        "  --charge H-H       tou baseline charge_start_utc-charge_end_utc\n"
+        "  --trace            print the planner's per-slot decisions\n");
+}
+
+int main(int argc, char **argv) {
+    if (argc < 3) { usage(); return 2; }
+
+    PlanSchedule sched;
+    memset(&sched, 0, sizeof(sched));
+    sched.base_import = 0.15f;
+    sched.base_export = 0.05f;
+    PlanBattery b = { 10000.0f, 3000.0f, 3000.0f, 0.90f, 20.0f, 95.0f };
+    float soc0 = 50.0f;
+    int peak_s = 0, peak_e = 0, chg_s = 0, chg_e = 0;
+    bool trace = false;
+
+    for (int i = 3; i < argc; i++) {
+        const char *k = argv[i];
+        const char *v = (i + 1 < argc) ? argv[i + 1] : NULL;
+        if      (!strcmp(k, "--trace"))                { trace = true; continue; }
+        else if (!v)                                   { usage(); return 2; }
+        else if (!strcmp(k, "--soc"))                  soc0 = (float)atof(v);
+        else if (!strcmp(k, "--batt-wh"))              b.capacity_wh = (float)atof(v);
+        else if (!strcmp(k, "--charge-w"))             b.max_charge_w = (float)atof(v);
+        else if (!strcmp(k, "--discharge-w"))          b.max_discharge_w = (float)atof(v);
+        else if (!strcmp(k, "--eff"))                  b.efficiency = (float)atof(v) / 100.0f;
+        else if (!strcmp(k, "--soc-min"))              b.soc_min_pct = (float)atof(v);
+        else if (!strcmp(k, "--soc-max"))              b.soc_max_pct = (float)atof(v);
+        else if (!strcmp(k, "--import"))               sched.base_import = (float)atof(v);
+        else if (!strcmp(k, "--export"))               sched.base_export = (float)atof(v);
+        else if (!strcmp(k, "--peak"))   { if (!parseHours(v, peak_s, peak_e)) { usage(); return 2; } }
+        else if (!strcmp(k, "--charge")) { if (!parseHours(v, chg_s, chg_e))   { usage(); return 2; } }
+        else                                           { usage(); return 2; }
+        i++;
+    }
+
+    std::vector<Row> rows;
+    if (!loadTelemetry(argv[1], rows) || !loadTariff(argv[2], sched)) return 1;
+
+    const uint32_t last      = rows.back().epoch;
+    const uint32_t eval_from = (last - rows.front().epoch >= 86400UL) ? last - 86400UL + 1 : rows.front().epoch;
+
+    static PvForecast f;
+    static Plan       plan;
+    forecastInit(f);
+    memset(&plan, 0, sizeof(plan));
+
+    const float init_wh = b.capacity_wh * soc0 / 100.0f;
+    Totals self = { 0, 0, 0, init_wh }, tou = self, pl = self;
+    uint32_t replans = 0;
+
+    for (size_t i = 0; i < rows.size(); i++) {
+        const Row     &r  = rows[i];
+        const uint32_t dt = (i + 1 < rows.size()) ? rows[i + 1].epoch - r.epoch
+                                                   : r.epoch - rows[i - 1].epoch;
+        // The device learns from each sample before resolving the mode.
+        forecastAddSample(f, r.epoch, (int32_t)r.pv_w, (int32_t)r.load_w);
+        if (r.epoch < eval_from) continue;
+
+        float pi, pe; bool curtail;
+        scheduleAt(sched, r.epoch, pi, pe, curtail);
+
+        // self: NORMAL unless a DR curtail event is in force (cloud dr_curtail).
+        account(self, simulateSlot(b, curtail ? PLAN_CURTAIL : PLAN_SELF,
+                                   self.soc_wh, r.pv_w, r.load_w, dt), sched, r.epoch);
+
+        // tou: resolveMode() with fixed windows; curtail events as cloud commands.
+        PlanAction ta = PLAN_SELF;
+        if      (curtail)                                ta = PLAN_CURTAIL;
+        else if (inHourWindow(r.epoch, peak_s, peak_e))  ta = PLAN_DISCHARGE;
+        else if (inHourWindow(r.epoch, chg_s, chg_e))    ta = PLAN_CHARGE;
+        account(tou, simulateSlot(b, ta, tou.soc_wh, r.pv_w, r.load_w, dt), sched, r.epoch);
+
+        // planner: re-plan at each slot boundary, then read the policy at the
+        // measured SOC — the same sequence as plannerStep() + resolveMode().
+        const float soc_pct = pl.soc_wh / b.capacity_wh * 100.0f;
+        if (!plan.valid || r.epoch / PLAN_SLOT_SEC != plan.start_slot) {
+            planBuild(plan, sched, b, f, r.epoch, soc_pct);
+            replans++;
+            if (trace) {
+                PlanAction a = PLAN_SELF;
+                planAction(plan, r.epoch, soc_pct, a);
+                printf("%10u  soc %5.1f%%  pv %5.0f  load %5.0f  import %.2f  -> %-9s  horizon cost %.2f\n",
+                       (unsigned)r.epoch, soc_pct, r.pv_w, r.load_w, pi,
+                       planActionName(a), plan.expected_cost);
+            }
+        }
+        PlanAction pa = PLAN_SELF;
+        planAction(plan, r.epoch, soc_pct, pa);
+        if (curtail) pa = PLAN_CURTAIL;
+        account(pl, simulateSlot(b, pa, pl.soc_wh, r.pv_w, r.load_w, dt), sched, r.epoch);
+    }
+
+    // Energy left in the battery is credited at the base import price so a
+    // strategy cannot look cheap by simply ending the day empty.
+    const Totals *all[3]  = { &self, &tou, &pl };
+    const char   *name[3] = { "self", "tou", "planner" };
+    double adj[3];
+    printf("\nEvaluated %u h of telemetry (%u re-plans)\n", (unsigned)((last - eval_from + 1) / 3600), replans);
+    printf("%-8s %10s %10s %10s %8s %10s\n", "strategy", "import_kWh", "export_kWh", "cost", "end_soc", "adj_cost");
+    for (int i = 0; i < 3; i++) {
+        const double delta_kwh = (all[i]->soc_wh - init_wh) / 1000.0;
+        adj[i] = all[i]->cost - delta_kwh * sched.base_import;
+        printf("%-8s %10.2f %10.2f %10.2f %7.1f%% %10.2f\n", name[i], all[i]->import_kwh,
+               all[i]->export_kwh, all[i]->cost, all[i]->soc_wh / b.capacity_wh * 100.0f, adj[i]);
+    }
+    printf("\nplanner saves %.2f vs self", adj[0] - adj[2]);
+    if (peak_s != peak_e || chg_s != chg_e) printf(", %.2f vs tou", adj[1] - adj[2]);
+    printf(" (adjusted for end-of-day SOC)\n");
+    return 0;
+}
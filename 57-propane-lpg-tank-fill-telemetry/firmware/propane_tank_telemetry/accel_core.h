@@ -0,0 +1,240 @@
+/***************************************************************************
+  accel_core.h
+
+  Shared building blocks for the accelerator sketches, so each app composes
+  them instead of carrying its own copy:
+
+    AccelStat<T>       summary-window accumulator (count, sum, first, last,
+                       lowest, highest) whose readouts return ACCEL_SENTINEL
+                       when the window holds no samples
+    AccelCooldown<N>   per-alert-type cooldown table; an alert is marked only
+                       after its note.add succeeds, so a failed send retries
+    AccelEnvVar        one row of an env-var schema: name, type, range and
+                       the variable it writes; accelEnvApply() walks a table
+    AccelCadence       last hub.set outbound/inbound the Notecard accepted;
+                       accelHubCadence() issues hub.set only on a change
+
+  Every state type is a plain aggregate with no constructors or virtual
+  members, so it can sit directly inside a PersistState struct that is
+  memset() on cold boot and carried across sleep in a NotePayload; zeroed
+  memory is a valid empty accumulator, an expired cooldown and a cadence
+  that has never been applied.
+
+  Everything is a template or static inline, so a sketch pays only for the
+  parts it uses.  The pure parts have no Notecard or Arduino dependencies
+  and are exercised on the host by the check in sim/; the Notecard glue at
+  the end is left out when ACCEL_CORE_HOST is defined.
+
+  This file is copied unchanged into each sketch that uses it (Arduino
+  builds one sketch folder at a time); keep the copies identical.
+***************************************************************************/
+
+#pragma once
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Value reported in place of a reading when a window has no data.  Chosen
+// well outside every physical range the apps measure, so downstream
+// consumers can tell "missing" from a real low reading.
+#define ACCEL_SENTINEL      (-9999.0f)
+
+// Notecard cadence limits, minutes.  hub.set rejects 0; one week is the
+// longest interval any of the apps uses.
+#define ACCEL_HUB_MIN_MIN   1u
+#define ACCEL_HUB_MAX_MIN   10080u
+
+// ─── Summary accumulator ──────────────────────────────────────────────────────
+// T is the sample type; Sum is the running-total type (float keeps the
+// struct small and matches the note templates' 4-byte reals).  The count
+// saturates instead of wrapping, so a window that overruns its report
+// interval by weeks still averages correctly.
+template <typename T, typename Sum = float>
+struct AccelStat {
+    Sum      sum;
+    T        first;
+    T        last;
+    T        lo;
+    T        hi;
+    uint16_t n;
+
+    void reset()
+    {
+        memset(this, 0, sizeof(*this));
+    }
+
+    void add(T v)
+    {
+        if (n == 0) {
+            first = lo = hi = v;
+        } else {
+            if (v < lo) lo = v;
+            if (v > hi) hi = v;
+        }
+        last = v;
+        sum += (Sum)v;
+        if (n < 0xFFFF) n++;
+    }
+
+    bool  empty()   const { return n == 0; }
+    float avg()     const { return n ? (float)sum / (float)n : ACCEL_SENTINEL; }
+    float latest()  const { return n ? (float)last : ACCEL_SENTINEL; }
+    float lowest()  const { return n ? (float)lo   : ACCEL_SENTINEL; }
+    float highest() const { return n ? (float)hi   : ACCEL_SENTINEL; }
+    float delta()   const { return n ? (float)last - (float)first : ACCEL_SENTINEL; }
+};
+
+// ─── Alert cooldown table ─────────────────────────────────────────────────────
+// One epoch per alert type, indexed by an app-side enum.  ready() is false
+// until the Notecard has time (now == 0), so an unsynchronised clock cannot
+// defeat the cooldown; apps that alert before time sync keep their own
+// one-shot flags and mark() the table once time arrives.
+template <uint8_t N>
+struct AccelCooldown {
+    uint32_t last[N];
+
+    bool ready(uint8_t i, uint32_t now, uint32_t windowSec) const
+    {
+        return now != 0 && (now - last[i]) > windowSec;
+    }
+
+    // Call only after the alert note was accepted.
+    void mark(uint8_t i, uint32_t now) { last[i] = now; }
+    void clear() { memset(last, 0, sizeof(last)); }
+};
+
+// ─── Env-var schema ───────────────────────────────────────────────────────────
+enum AccelEnvType {
+    ACCEL_ENV_FLOAT,
+    ACCEL_ENV_U32,
+    ACCEL_ENV_U16,
+    ACCEL_ENV_U8
+};
+
+// Range flags: by default both bounds are inclusive.
+#define ACCEL_ENV_LO_OPEN   0x01    // value must be strictly greater than lo
+#define ACCEL_ENV_HI_OPEN   0x02    // value must be strictly less than hi
+
+struct AccelEnvVar {
+    const char *name;
+    uint8_t     type;       // AccelEnvType
+    uint8_t     flags;      // ACCEL_ENV_LO_OPEN | ACCEL_ENV_HI_OPEN
+    float       lo;
+    float       hi;
+    void       *target;     // float*, uint32_t*, uint16_t* or uint8_t*
+};
+
+static inline bool accelEnvInRange(const AccelEnvVar *e, double v)
+{
+    if ((e->flags & ACCEL_ENV_LO_OPEN) ? v <= e->lo : v < e->lo) return false;
+    if ((e->flags & ACCEL_ENV_HI_OPEN) ? v >= e->hi : v > e->hi) return false;
+    return true;
+}
+
+// Parse one env-var string into e->target.  Integers are parsed with atol()
+// before the range check, so "-1" is rejected instead of wrapping to a
+// large unsigned value.  Returns false, leaving the target untouched, when
+// the value is out of range; an absent or empty string also returns false
+// but is not an error (see accelEnvApply).
+static inline bool accelEnvSet(const AccelEnvVar *e, const char *raw)
+{
+    if (raw == NULL || raw[0] == '\0') return false;
+    if (e->type == ACCEL_ENV_FLOAT) {
+        float f = (float)atof(raw);
+        if (!accelEnvInRange(e, f)) return false;
+        *(float *)e->target = f;
+        return true;
+    }
+    long l = atol(raw);
+    if (!accelEnvInRange(e, (double)l)) return false;
+    switch (e->type) {
+    case ACCEL_ENV_U32: *(uint32_t *)e->target = (uint32_t)l; break;
+    case ACCEL_ENV_U16: *(uint16_t *)e->target = (uint16_t)l; break;
+    default:            *(uint8_t *)e->target  = (uint8_t)l;  break;
+    }
+    return true;
+}
+
+// ─── Hub cadence ──────────────────────────────────────────────────────────────
+struct AccelCadence {
+    uint16_t outbound_min;  // last values hub.set accepted; 0 = never applied
+    uint16_t inbound_min;
+
+    bool due(uint32_t outboundMin, uint32_t inboundMin) const
+    {
+        return outbound_min != outboundMin || inbound_min != inboundMin;
+    }
+
+    void confirm(uint32_t outboundMin, uint32_t inboundMin)
+    {
+        outbound_min = (uint16_t)outboundMin;
+        inbound_min  = (uint16_t)inboundMin;
+    }
+};
+
+static inline uint32_t accelClampMin(uint32_t minutes)
+{
+    if (minutes < ACCEL_HUB_MIN_MIN) return ACCEL_HUB_MIN_MIN;
+    if (minutes > ACCEL_HUB_MAX_MIN) return ACCEL_HUB_MAX_MIN;
+    return minutes;
+}
+
+// ─── Notecard glue ────────────────────────────────────────────────────────────
+#ifndef ACCEL_CORE_HOST
+
+#include <Notecard.h>
+
+// Add every schema name to an env.get "names" array, so the Notecard returns
+// only the variables the app reads.
+template <size_t N>
+static inline void accelEnvNames(J *names, const AccelEnvVar (&schema)[N])
+{
+    for (size_t i = 0; i < N; i++) {
+        JAddItemToArray(names, JCreateString(schema[i].name));
+    }
+}
+
+// Apply an env.get body to a schema.  Returns a bitmask of the rows whose
+// value was present but out of range (bit i = schema[i]) so the caller can
+// log them with its own serial port; those targets are left unchanged.
+template <size_t N>
+static inline uint32_t accelEnvApply(J *body, const AccelEnvVar (&schema)[N])
+{
+    static_assert(N <= 32, "env schema is limited to 32 rows");
+    uint32_t rejected = 0;
+    for (size_t i = 0; i < N; i++) {
+        const char *v = JGetString(body, schema[i].name);
+        if (v && v[0] && !accelEnvSet(&schema[i], v)) {
+            rejected |= (1UL << i);
+        }
+    }
+    return rejected;
+}
+
+// Issue hub.set with a periodic cadence, but only when it differs from the
+// last one the Notecard accepted; the cache is updated on success only, so
+// a failed hub.set is retried on the next call.  productUID may be NULL.
+// Returns true when the Notecard is on the requested cadence.
+static inline bool accelHubCadence(Notecard &nc, AccelCadence *c,
+                                   uint32_t outboundMin, uint32_t inboundMin,
+                                   const char *productUID)
+{
+    outboundMin = accelClampMin(outboundMin);
+    inboundMin  = accelClampMin(inboundMin);
+    if (!c->due(outboundMin, inboundMin)) return true;
+
+    J *req = nc.newRequest("hub.set");
+    if (req == NULL) return false;
+    if (productUID && productUID[0]) JAddStringToObject(req, "product", productUID);
+    JAddStringToObject(req, "mode", "periodic");
+    JAddNumberToObject(req, "outbound", (int)outboundMin);
+    JAddNumberToObject(req, "inbound",  (int)inboundMin);
+    // sendRequestWithRetry covers the cold-boot I2C race and reports a
+    // Notecard-side err as failure.
+    if (!nc.sendRequestWithRetry(req, 10)) return false;
+    c->confirm(outboundMin, inboundMin);
+    return true;
+}
+
+#endif  // ACCEL_CORE_HOST
@@ -93,28 +93,35 @@ static uint8_t CONSUMPTION_ALERT_STREAK = 3;  // consecutive above-threshold wak
 // cutting host power. NotePayloadRetrieveAfterSleep rehydrates it at the
 // top of the next setup(). Field order matters for ABI compatibility —
 // add new fields at the end only.
+// Alert types, indexing the cooldown table in PersistState.
+enum AlertKind {
+  ALERT_SENSOR_FAULT,
+  ALERT_LOW_FILL,
+  ALERT_HIGH_CONSUMPTION,
+  ALERT_KINDS
+};
+
 struct PersistState {
   // Summary window state (reset after each summary note).
-  // last_fill_* hold the most-recent valid reading so the daily note carries
-  // current tank state rather than a 24-hour average. n_fill is a has-data flag
-  // (> 0 means at least one valid reading was collected this window).
-  // min_fill_pct tracks the window's lowest fill level for analytics.
-  float    last_fill_pct;    uint32_t n_fill;   // n_fill: 0 = no valid reading this window
+  // fill_pct.latest() is the most-recent valid reading, so the daily note
+  // carries current tank state rather than a 24-hour average, and
+  // fill_pct.lowest() is the window's lowest fill level for analytics.
+  // fill_pct.empty() means no valid reading was collected this window;
+  // last_fill_gal / last_xmtr_ma belong to the same reading as fill_pct.last.
+  AccelStat<float> fill_pct;
   float    last_fill_gal;
-  float    sum_temp_c;       uint32_t n_temp;
+  AccelStat<float> temp_c;
   float    last_xmtr_ma;
   uint32_t summary_window_start_epoch;
 
   // Consumption tracking (survives summary-window resets)
   ConsumptionState consumption;
 
-  // Alert deduplication: epoch of last fire per type
-  uint32_t last_low_fill_epoch;
-  uint32_t last_high_consumption_epoch;
-  uint32_t last_sensor_fault_epoch;
+  // Alert deduplication: epoch of last fire per AlertKind
+  AccelCooldown<ALERT_KINDS> cooldown;
 
-  // Tracks the last outbound cadence sent to hub.set so we can detect changes
-  uint32_t last_applied_outbound_hr;
+  // Last outbound/inbound cadence the Notecard accepted from hub.set
+  AccelCadence hub;
 
   uint32_t cycles;
 
@@ -135,8 +142,6 @@ struct PersistState {
   // Cleared automatically the first time a valid epoch is available.
   bool    pre_time_low_fill_sent;
   bool    pre_time_sensor_fault_sent;
-
-  float   min_fill_pct;   // lowest fill_pct seen in this reporting window (NAN = none yet)
 };
 
 static const char STATE_SEG_ID[] = "PLPG";
@@ -150,32 +155,22 @@ DallasTemperature tempSensor(&oneWire);
 // -------- Notecard helpers --------
 
 static void hubConfigure() {
-  J *req = notecard.newRequest("hub.set");
-  if (PRODUCT_UID[0]) JAddStringToObject(req, "product", PRODUCT_UID);
-  JAddStringToObject(req, "mode", "periodic");
-  // Derive outbound/inbound in minutes and clamp defensively.  REPORT_INTERVAL_HR
-  // is bounded to 168 by fetchEnvOverrides, so the products fit safely in uint32_t;
-  // the explicit cap guards against hubConfigure() being called before env vars are
-  // fetched (cold-start first wake) and against any future code path that could
-  // bypass the env-var validation.
-  uint32_t outbound_min = REPORT_INTERVAL_HR * 60u;
-  uint32_t inbound_min  = REPORT_INTERVAL_HR * 120u;  // 2× outbound
-  if (outbound_min > 10080u) outbound_min = 10080u;   // cap at 1 week (168 hr × 60)
-  if (inbound_min  > 10080u) inbound_min  = 10080u;
-  JAddNumberToObject(req, "outbound", (int)outbound_min);
-  JAddNumberToObject(req, "inbound",  (int)inbound_min);
-  // sendRequestWithRetry handles the cold-boot I2C race noted in note-arduino.
-  // Only cache the new cadence after confirmed success — if hub.set fails we keep
-  // the old last_applied_outbound_hr so the mismatch is detected and retried on
-  // the next wake, preventing the Notecard from staying on a stale schedule.
-  if (notecard.sendRequestWithRetry(req, 10)) {
-    state.last_applied_outbound_hr = REPORT_INTERVAL_HR;
-  } else {
+  // Outbound follows the report interval; inbound runs at 2x outbound.
+  // accelHubCadence clamps both to the Notecard's 1 min – 1 week range, so
+  // the products cannot overflow even if this runs before env vars are
+  // fetched (cold-start first wake). It skips hub.set when the cadence is
+  // unchanged and caches a new one only after the Notecard accepts it, so a
+  // failed hub.set is retried on the next wake instead of leaving the
+  // Notecard on a stale schedule.
+  if (!accelHubCadence(notecard, &state.hub, REPORT_INTERVAL_HR * 60u,
+                       REPORT_INTERVAL_HR * 120u, PRODUCT_UID)) {
 #ifdef usbSerial
     usbSerial.println("[hub.set] failed — will retry on next wake");
 #endif
   }
+}
 
+static void transportConfigure() {
   // Transport selection for the Notecard for Skylo (NOTE-NBGLWX).
   // The board carries WiFi, cellular, and Skylo satellite (NTN) radios, but
   // satellite fallback is NOT enabled by default — the factory transport does
@@ -188,7 +183,7 @@ static void hubConfigure() {
   //
   // Note: Skylo requires at least one initial non-NTN (cellular or WiFi) sync
   // to associate with Notehub and register Notefile templates before NTN can be
-  // used. In "periodic" mode the cold-boot hub.set above triggers that first
+  // used. In "periodic" mode the cold-boot hub.set triggers that first
   // sync over cellular/WiFi, so commission each unit where it has terrestrial
   // coverage even if it will routinely operate over satellite.
   J *t = notecard.newRequest("card.transport");
@@ -268,18 +263,43 @@ static uint32_t notecardEpoch() {
   return epoch;  // 0 means the Notecard has not yet acquired time
 }
 
+// -------- Env-var schema --------
+// Single-valued overrides, each applied only when inside its range:
+//   tank_capacity_gal 10–30000: the ceiling covers the largest commercial bulk
+//     tanks and catches decimal-point typos that would inflate the consumption
+//     deadband and silently break the EWMA.
+//   fill_alert_pct 0–100: 0 effectively disables the alert, 100 alerts
+//     continuously — both are accepted as deliberate operator choices.
+//   consumption_alert_gal_per_day (0, 10000]: zero or negative would fire the
+//     alert permanently; no residential or light-commercial site exceeds 10 000.
+//   sample_interval_min 1–1440: the floor prevents a tight wake loop that drains
+//     the battery; the ceiling keeps the bench delay() product within uint32_t
+//     and guarantees a sample per window at report_interval_hr = 24.
+//   report_interval_hr 1–168: hub.set rejects outbound = 0, and one week keeps
+//     the summary-window epoch comparison from overflowing.
+//   alert_cooldown_hr 1–168: zero would re-fire every sample cycle; the ceiling
+//     keeps cooldown_sec within uint32_t and never silences alerts for over a week.
+//   consumption_alert_streak 1–20: 1 disables debouncing; 20 bounds the alerting
+//     delay to 5 hours at the 15-minute default sample interval.
+// sensor_empty_ma / sensor_full_ma and the WiFi credentials are validated as
+// pairs in fetchEnvOverrides().
+static const AccelEnvVar ENV_SCHEMA[] = {
+  { "tank_capacity_gal",             ACCEL_ENV_FLOAT, 0,                 10.0f, 30000.0f, &TANK_CAPACITY_GAL },
+  { "fill_alert_pct",                ACCEL_ENV_FLOAT, 0,                  0.0f,   100.0f, &FILL_ALERT_PCT },
+  { "consumption_alert_gal_per_day", ACCEL_ENV_FLOAT, ACCEL_ENV_LO_OPEN,  0.0f, 10000.0f, &CONSUMPTION_ALERT_GPD },
+  { "sample_interval_min",           ACCEL_ENV_U32,   0,                  1.0f,  1440.0f, &SAMPLE_INTERVAL_MIN },
+  { "report_interval_hr",            ACCEL_ENV_U32,   0,                  1.0f,   168.0f, &REPORT_INTERVAL_HR },
+  { "alert_cooldown_hr",             ACCEL_ENV_U32,   0,                  1.0f,   168.0f, &ALERT_COOLDOWN_HR },
+  { "consumption_alert_streak",      ACCEL_ENV_U8,    0,                  1.0f,    20.0f, &CONSUMPTION_ALERT_STREAK },
+};
+static const size_t ENV_SCHEMA_LEN = sizeof(ENV_SCHEMA) / sizeof(ENV_SCHEMA[0]);
+
 static bool fetchEnvOverrides() {
   J *req = notecard.newRequest("env.get");
   J *names = JAddArrayToObject(req, "names");
-  JAddItemToArray(names, JCreateString("tank_capacity_gal"));
+  accelEnvNames(names, ENV_SCHEMA);
   JAddItemToArray(names, JCreateString("sensor_empty_ma"));
   JAddItemToArray(names, JCreateString("sensor_full_ma"));
-  JAddItemToArray(names, JCreateString("fill_alert_pct"));
-  JAddItemToArray(names, JCreateString("consumption_alert_gal_per_day"));
-  JAddItemToArray(names, JCreateString("sample_interval_min"));
-  JAddItemToArray(names, JCreateString("report_interval_hr"));
-  JAddItemToArray(names, JCreateString("alert_cooldown_hr"));
-  JAddItemToArray(names, JCreateString("consumption_alert_streak"));
   JAddItemToArray(names, JCreateString("wifi_ssid"));
   JAddItemToArray(names, JCreateString("wifi_password"));
 
@@ -290,24 +310,20 @@ static bool fetchEnvOverrides() {
   J *body = JGetObjectItem(rsp, "body");
   if (body) {
     const char *v;
-    float    fv;
-    uint32_t uv;
-
-    // tank_capacity_gal: must be a physically plausible positive tank size.
-    // Upper bound of 30 000 gal covers the largest commercial bulk tanks;
-    // rejecting values above it catches decimal-point typos that would
-    // inflate the consumption deadband and silently break the EWMA.
-    v = JGetString(body, "tank_capacity_gal");
-    if (v && v[0]) {
-      fv = atof(v);
-      if (fv >= 10.0f && fv <= 30000.0f) {
-        TANK_CAPACITY_GAL = fv;
-      } else {
+
+    uint32_t rejected = accelEnvApply(body, ENV_SCHEMA);
 #ifdef usbSerial
-        usbSerial.print("[env] tank_capacity_gal must be 10–30000, ignored: "); usbSerial.println(v);
-#endif
+    for (size_t i = 0; i < ENV_SCHEMA_LEN; i++) {
+      if (rejected & (1UL << i)) {
+        usbSerial.print("[env] ");         usbSerial.print(ENV_SCHEMA[i].name);
+        usbSerial.print(" must be ");      usbSerial.print(ENV_SCHEMA[i].lo);
+        usbSerial.print("–");              usbSerial.print(ENV_SCHEMA[i].hi);
+        usbSerial.print(", ignored: ");    usbSerial.println(JGetString(body, ENV_SCHEMA[i].name));
       }
     }
+#else
+    (void)rejected;
+#endif
 
     // sensor_empty_ma / sensor_full_ma: read together before validating.
     // A span < 1 mA causes computeFillPct to return NAN for every reading.
@@ -333,103 +349,6 @@ static bool fetchEnvOverrides() {
       }
     }
 
-    // fill_alert_pct: 0–100 % is the full valid range. 0 effectively disables
-    // the alert (fill can never drop below 0 %); 100 would alert continuously —
-    // both are accepted as deliberate operator choices.
-    v = JGetString(body, "fill_alert_pct");
-    if (v && v[0]) {
-      fv = atof(v);
-      if (fv >= 0.0f && fv <= 100.0f) {
-        FILL_ALERT_PCT = fv;
-      } else {
-#ifdef usbSerial
-        usbSerial.print("[env] fill_alert_pct must be 0–100, ignored: "); usbSerial.println(v);
-#endif
-      }
-    }
-
-    // consumption_alert_gal_per_day: must be > 0 (zero or negative would fire
-    // the alert permanently) and ≤ 10 000 gal/day (catches magnitude typos;
-    // no residential or light-commercial installation legitimately exceeds this).
-    v = JGetString(body, "consumption_alert_gal_per_day");
-    if (v && v[0]) {
-      fv = atof(v);
-      if (fv > 0.0f && fv <= 10000.0f) {
-        CONSUMPTION_ALERT_GPD = fv;
-      } else {
-#ifdef usbSerial
-        usbSerial.print("[env] consumption_alert_gal_per_day must be >0 and <=10000, ignored: "); usbSerial.println(v);
-#endif
-      }
-    }
-
-    // sample_interval_min: 1–1440.  Lower bound prevents a tight host wake loop
-    // that drains the battery and spams the Notecard over I2C.  Upper bound of
-    // 1440 (once per day) keeps the bench-mode delay() product (interval × 60 s
-    // × 1000 ms) well within uint32_t and ensures at least one sample per
-    // report window when report_interval_hr == 24.
-    v = JGetString(body, "sample_interval_min");
-    if (v && v[0]) {
-      uv = (uint32_t)atol(v);
-      if (uv >= 1 && uv <= 1440) {
-        SAMPLE_INTERVAL_MIN = uv;
-      } else {
-#ifdef usbSerial
-        usbSerial.print("[env] sample_interval_min must be 1–1440, ignored: "); usbSerial.println(v);
-#endif
-      }
-    }
-
-    // report_interval_hr: 1–168.  Lower bound prevents hub.set outbound=0
-    // which is an invalid Notecard cadence and would cause continuous cellular
-    // sessions.  Upper bound of 168 (one week) keeps the derived outbound_min
-    // and inbound_min products in hubConfigure() within the Notecard's accepted
-    // range and protects the summary-window epoch comparison from overflow.
-    v = JGetString(body, "report_interval_hr");
-    if (v && v[0]) {
-      uv = (uint32_t)atol(v);
-      if (uv >= 1 && uv <= 168) {
-        REPORT_INTERVAL_HR = uv;
-      } else {
-#ifdef usbSerial
-        usbSerial.print("[env] report_interval_hr must be 1–168, ignored: "); usbSerial.println(v);
-#endif
-      }
-    }
-
-    // alert_cooldown_hr: 1–168.  Lower bound prevents per-cycle alert spam on a
-    // slowly-draining tank (zero would re-fire every sample cycle).  Upper bound
-    // of 168 keeps cooldown_sec = ALERT_COOLDOWN_HR × 3600 comfortably within
-    // uint32_t and avoids silently disabling alerts for more than a week at a time.
-    v = JGetString(body, "alert_cooldown_hr");
-    if (v && v[0]) {
-      uv = (uint32_t)atol(v);
-      if (uv >= 1 && uv <= 168) {
-        ALERT_COOLDOWN_HR = uv;
-      } else {
-#ifdef usbSerial
-        usbSerial.print("[env] alert_cooldown_hr must be 1–168, ignored: "); usbSerial.println(v);
-#endif
-      }
-    }
-
-    // consumption_alert_streak: 1–20.  Lower bound of 1 disables debouncing so
-    // any single above-threshold reading fires the alert.  Upper bound of 20
-    // bounds the worst-case alerting delay to 20 × SAMPLE_INTERVAL_MIN minutes
-    // — at the 15-minute default that is 5 hours, which is the longest a
-    // genuine sustained high-consumption event should be silenced before alert.
-    v = JGetString(body, "consumption_alert_streak");
-    if (v && v[0]) {
-      uv = (uint32_t)atol(v);
-      if (uv >= 1 && uv <= 20) {
-        CONSUMPTION_ALERT_STREAK = (uint8_t)uv;
-      } else {
-#ifdef usbSerial
-        usbSerial.print("[env] consumption_alert_streak must be 1–20, ignored: "); usbSerial.println(v);
-#endif
-      }
-    }
-
     // WiFi credentials: when both wifi_ssid and wifi_password are present and
     // non-empty, provision WiFi on the Notecard via card.wifi. This is the
     // recommended provisioning path for deployed Notecarrier CX hardware where
@@ -475,10 +394,8 @@ static bool fetchEnvOverrides() {
       // single reporting window must not span a calibration boundary.
       memset(&state.consumption, 0, sizeof(state.consumption));
       state.high_consumption_streak    = 0;
-      state.n_fill                     = 0;
-      state.sum_temp_c                 = 0.0f;
-      state.n_temp                     = 0;
-      state.min_fill_pct               = NAN;
+      state.fill_pct.reset();
+      state.temp_c.reset();
       state.summary_window_start_epoch = 0;  // force re-anchor on next valid epoch
       state.last_tank_capacity_gal = TANK_CAPACITY_GAL;
       state.last_sensor_empty_ma   = SENSOR_EMPTY_MA;
@@ -491,10 +408,8 @@ static bool fetchEnvOverrides() {
 
   // Re-issue hub.set if the operator changed the report cadence from Notehub.
   // Without this, the Notecard keeps transmitting on the old schedule even
-  // after the firmware has adopted the new interval.
-  if (REPORT_INTERVAL_HR != state.last_applied_outbound_hr) {
-    hubConfigure();
-  }
+  // after the firmware has adopted the new interval. A no-op when unchanged.
+  hubConfigure();
 
   return true;
 }
@@ -514,10 +429,10 @@ static bool sendAlert(const char *kind, float fill_pct, float fill_gal,
     JAddBoolToObject  (req, "sync", true);  // bypass daily outbound timer
     J *body = JAddObjectToObject(req, "body");
     JAddStringToObject(body, "alert",            kind);
-    JAddNumberToObject(body, "fill_pct",         isnan(fill_pct) ? INVALID_SENTINEL : fill_pct);
-    JAddNumberToObject(body, "fill_gal",         isnan(fill_gal) ? INVALID_SENTINEL : fill_gal);
-    JAddNumberToObject(body, "gal_per_day",      (gpd < 0.01f || isnan(gpd)) ? INVALID_SENTINEL : gpd);
-    JAddNumberToObject(body, "days_until_empty", isnan(dte)      ? INVALID_SENTINEL : dte);
+    JAddNumberToObject(body, "fill_pct",         isnan(fill_pct) ? ACCEL_SENTINEL : fill_pct);
+    JAddNumberToObject(body, "fill_gal",         isnan(fill_gal) ? ACCEL_SENTINEL : fill_gal);
+    JAddNumberToObject(body, "gal_per_day",      (gpd < 0.01f || isnan(gpd)) ? ACCEL_SENTINEL : gpd);
+    JAddNumberToObject(body, "days_until_empty", isnan(dte)      ? ACCEL_SENTINEL : dte);
     sent = notecard.sendRequest(req);
   }
 #ifdef usbSerial
@@ -536,11 +451,12 @@ static void sendSummary(uint32_t now_epoch) {
   // a refill event or a sharp draw-down, undermining the route-dispatch use case.
   // Temperature is averaged to represent the day's thermal environment.
   // min_fill_pct captures the lowest point seen in the window for analytics.
-  float cur_fill_pct = (state.n_fill > 0) ? state.last_fill_pct : INVALID_SENTINEL;
-  float cur_fill_gal = (state.n_fill > 0) ? state.last_fill_gal : INVALID_SENTINEL;
-  float cur_xmtr_ma  = (state.n_fill > 0) ? state.last_xmtr_ma  : INVALID_SENTINEL;
-  float win_min_pct  = isnan(state.min_fill_pct) ? INVALID_SENTINEL : state.min_fill_pct;
-  float avg_temp_c   = safeAvg(state.sum_temp_c, state.n_temp);
+  bool  has_fill     = !state.fill_pct.empty();
+  float cur_fill_pct = state.fill_pct.latest();
+  float cur_fill_gal = has_fill ? state.last_fill_gal : ACCEL_SENTINEL;
+  float cur_xmtr_ma  = has_fill ? state.last_xmtr_ma  : ACCEL_SENTINEL;
+  float win_min_pct  = state.fill_pct.lowest();
+  float avg_temp_c   = state.temp_c.avg();
   float gpd          = state.consumption.gal_per_day;
   float dte          = daysUntilEmpty(cur_fill_gal, gpd);
 
@@ -556,7 +472,7 @@ static void sendSummary(uint32_t now_epoch) {
     JAddNumberToObject(body, "fill_gal",         cur_fill_gal);
     JAddNumberToObject(body, "min_fill_pct",     win_min_pct);
     JAddNumberToObject(body, "temp_c",           avg_temp_c);
-    JAddNumberToObject(body, "gal_per_day",      gpd < 0.01f ? INVALID_SENTINEL : gpd);
+    JAddNumberToObject(body, "gal_per_day",      gpd < 0.01f ? ACCEL_SENTINEL : gpd);
     JAddNumberToObject(body, "days_until_empty", dte);
     JAddNumberToObject(body, "transmitter_ma",   cur_xmtr_ma);
     sent = notecard.sendRequest(req);  // no sync:true — periodic outbound window batches this
@@ -579,13 +495,11 @@ static void sendSummary(uint32_t now_epoch) {
 #endif
 
   // Reset window state only after the note has been accepted by the Notecard
-  // queue. last_fill_* are overwritten on the next valid sample — only the
-  // has-data flag and min tracker need explicit reset. The consumption EWMA and
-  // alert dedup timestamps are persistent state and are intentionally NOT reset.
-  state.n_fill       = 0;
-  state.sum_temp_c   = 0.0f;
-  state.n_temp       = 0;
-  state.min_fill_pct = NAN;
+  // queue. last_fill_gal / last_xmtr_ma are overwritten on the next valid
+  // sample and are only read while fill_pct holds data. The consumption EWMA
+  // and alert cooldowns are persistent state and are intentionally NOT reset.
+  state.fill_pct.reset();
+  state.temp_c.reset();
   state.summary_window_start_epoch = now_epoch;
 }
 
@@ -611,23 +525,18 @@ static void runSampleCycle() {
   usbSerial.print(" temp_c=");          usbSerial.println(temp_c);
 #endif
 
-  // Update summary window state. last_fill_* always hold the most-recent valid
-  // reading so the daily note carries current tank state, not a window average.
-  // min_fill_pct tracks the lowest fill seen in the window for analytics.
-  // Readings are collected regardless of RTC validity so the window has data
-  // the moment time becomes available.
+  // Update summary window state. fill_pct keeps the most-recent valid reading
+  // so the daily note carries current tank state, not a window average, and
+  // the lowest fill seen in the window for analytics. Readings are collected
+  // regardless of RTC validity so the window has data the moment time becomes
+  // available.
   if (!isnan(fill_pct) && !isnan(fill_gal)) {
-    state.last_fill_pct = fill_pct;
+    state.fill_pct.add(fill_pct);
     state.last_fill_gal = fill_gal;
     state.last_xmtr_ma  = xmtr_ma;
-    state.n_fill++;
-    if (isnan(state.min_fill_pct) || fill_pct < state.min_fill_pct) {
-      state.min_fill_pct = fill_pct;
-    }
   }
   if (!isnan(temp_c)) {
-    state.sum_temp_c += temp_c;
-    state.n_temp++;
+    state.temp_c.add(temp_c);
   }
 
   // Update the EWMA consumption rate only when the Notecard has a valid epoch.
@@ -649,15 +558,15 @@ static void runSampleCycle() {
   // boolean flags so the operator is notified without per-cycle alert spam.
   if (!time_valid) {
     if (isnan(xmtr_ma) && !state.pre_time_sensor_fault_sent) {
-      if (sendAlert("sensor_fault", INVALID_SENTINEL, INVALID_SENTINEL,
-                    INVALID_SENTINEL, INVALID_SENTINEL)) {
+      if (sendAlert("sensor_fault", ACCEL_SENTINEL, ACCEL_SENTINEL,
+                    ACCEL_SENTINEL, ACCEL_SENTINEL)) {
         state.pre_time_sensor_fault_sent = true;
       }
     }
     if (!isnan(fill_pct) && fill_pct < FILL_ALERT_PCT &&
         !state.pre_time_low_fill_sent) {
       if (sendAlert("low_fill", fill_pct, fill_gal,
-                    INVALID_SENTINEL, INVALID_SENTINEL)) {
+                    ACCEL_SENTINEL, ACCEL_SENTINEL)) {
         state.pre_time_low_fill_sent = true;
       }
     }
@@ -680,20 +589,19 @@ static void runSampleCycle() {
   // Indicates open loop (broken wire) or a short circuit — needs a site visit.
   // Cooldown timestamp is only advanced when the Notecard accepted the note —
   // if queuing fails the alert can be retried on the next wake.
-  if (isnan(xmtr_ma) &&
-      (now_epoch - state.last_sensor_fault_epoch) > cooldown_sec) {
-    if (sendAlert("sensor_fault", INVALID_SENTINEL, INVALID_SENTINEL,
-                  gpd < 0.01f ? INVALID_SENTINEL : gpd, INVALID_SENTINEL)) {
-      state.last_sensor_fault_epoch = now_epoch;
+  if (isnan(xmtr_ma) && state.cooldown.ready(ALERT_SENSOR_FAULT, now_epoch, cooldown_sec)) {
+    if (sendAlert("sensor_fault", ACCEL_SENTINEL, ACCEL_SENTINEL,
+                  gpd < 0.01f ? ACCEL_SENTINEL : gpd, ACCEL_SENTINEL)) {
+      state.cooldown.mark(ALERT_SENSOR_FAULT, now_epoch);
     }
   }
 
   // Low fill: tank approaching empty. Fire once per cooldown window.
   if (!isnan(fill_pct) && fill_pct < FILL_ALERT_PCT &&
-      (now_epoch - state.last_low_fill_epoch) > cooldown_sec) {
+      state.cooldown.ready(ALERT_LOW_FILL, now_epoch, cooldown_sec)) {
     if (sendAlert("low_fill", fill_pct, fill_gal,
-                  gpd < 0.01f ? INVALID_SENTINEL : gpd, dte)) {
-      state.last_low_fill_epoch = now_epoch;
+                  gpd < 0.01f ? ACCEL_SENTINEL : gpd, dte)) {
+      state.cooldown.mark(ALERT_LOW_FILL, now_epoch);
     }
   }
 
@@ -716,9 +624,9 @@ static void runSampleCycle() {
     state.high_consumption_streak = 0;
   }
   if (state.high_consumption_streak >= CONSUMPTION_ALERT_STREAK &&
-      (now_epoch - state.last_high_consumption_epoch) > cooldown_sec) {
+      state.cooldown.ready(ALERT_HIGH_CONSUMPTION, now_epoch, cooldown_sec)) {
     if (sendAlert("high_consumption", fill_pct, fill_gal, gpd, dte)) {
-      state.last_high_consumption_epoch = now_epoch;
+      state.cooldown.mark(ALERT_HIGH_CONSUMPTION, now_epoch);
     }
   }
 
@@ -770,9 +678,9 @@ void setup() {
   }
 
   if (!restored) {
-    memset(&state, 0, sizeof(state));
-    state.min_fill_pct = NAN;  // memset zeros floats to 0.0; NAN must be set explicitly
+    memset(&state, 0, sizeof(state));  // empty accumulators, expired cooldowns, no cadence
     hubConfigure();
+    transportConfigure();
     // Quiet the onboard accelerometer to prevent motion-interrupt wakes from
     // corrupting Mojo power traces during bench validation.
     J *req = notecard.newRequest("card.motion.mode");
@@ -819,16 +727,14 @@ static void perWakeConfigure() {
   // the first summary span potentially much longer than REPORT_INTERVAL_HR.
   uint32_t now = notecardEpoch();
   if (now != 0 && state.summary_window_start_epoch == 0) {
-    state.n_fill       = 0;
-    state.sum_temp_c   = 0.0f;
-    state.n_temp       = 0;
-    state.min_fill_pct = NAN;
+    state.fill_pct.reset();
+    state.temp_c.reset();
     state.summary_window_start_epoch = now;
     // Seed epoch cooldowns for any alerts that fired pre-time so they do not
     // double-fire immediately on the same wake the clock syncs. The epoch-based
     // cooldown will keep them quiet for a full ALERT_COOLDOWN_HR.
-    if (state.pre_time_low_fill_sent)     state.last_low_fill_epoch     = now;
-    if (state.pre_time_sensor_fault_sent) state.last_sensor_fault_epoch = now;
+    if (state.pre_time_low_fill_sent)     state.cooldown.mark(ALERT_LOW_FILL, now);
+    if (state.pre_time_sensor_fault_sent) state.cooldown.mark(ALERT_SENSOR_FAULT, now);
   }
 }
 
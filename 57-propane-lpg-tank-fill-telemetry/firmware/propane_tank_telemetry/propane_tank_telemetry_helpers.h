@@ -8,6 +8,7 @@
 #include <Arduino.h>
 #include <OneWire.h>
 #include <DallasTemperature.h>
+#include "accel_core.h"
 
 // -------- ADC constants (Cygnet STM32L4 12-bit ADC @ 3.3 V ref) --------
 static const float    ADC_VREF_V     = 3.30f;
@@ -36,9 +37,6 @@ static const float CONSUMPTION_ALPHA = 0.30f;
 // prevents the EWMA from ever being seeded.
 static const float CONSUMPTION_MIN_DELTA_GAL_FRAC = 0.002f;
 
-// Sentinel value used when a metric has no valid samples.
-static const float INVALID_SENTINEL  = -9999.0f;
-
 // -------- Sensor reading --------
 
 // Read the 4-20 mA gauge-port level transmitter: average 16 ADC samples,
@@ -167,23 +165,18 @@ static bool updateConsumption(ConsumptionState &c, float curr_gal,
 // Compute days-until-empty from current fill and EWMA consumption rate.
 //
 // Return value semantics:
-//   INVALID_SENTINEL  — fill data is missing (NAN from a transmitter fault, or the
-//                       INVALID_SENTINEL produced by safeAvg() when no valid samples
+//   ACCEL_SENTINEL    — fill data is missing (NAN from a transmitter fault, or the
+//                       ACCEL_SENTINEL an empty AccelStat reports when no valid samples
 //                       were collected in the summary window), OR the consumption EWMA
 //                       hasn't been seeded yet.
 //   0.0               — fill_gal is a valid, confirmed zero (tank is truly empty).
 //   positive float    — projected days remaining at the current consumption rate.
 //
-// The cutoff at -1.0 distinguishes the INVALID_SENTINEL (-9999) from a valid empty
+// The cutoff at -1.0 distinguishes the ACCEL_SENTINEL (-9999) from a valid empty
 // reading (0.0) or tiny negative noise values near zero.
 static float daysUntilEmpty(float fill_gal, float gal_per_day) {
-  if (isnan(fill_gal) || fill_gal < -1.0f) return INVALID_SENTINEL;  // missing data
-  if (fill_gal <= 0.0f) return 0.0f;                                   // valid empty tank
-  if (gal_per_day < 0.01f) return INVALID_SENTINEL;                    // no rate estimate yet
+  if (isnan(fill_gal) || fill_gal < -1.0f) return ACCEL_SENTINEL;  // missing data
+  if (fill_gal <= 0.0f) return 0.0f;                                 // valid empty tank
+  if (gal_per_day < 0.01f) return ACCEL_SENTINEL;                    // no rate estimate yet
   return fminf(fill_gal / gal_per_day, 9999.0f);
 }
-
-// Safe average: returns INVALID_SENTINEL when no valid samples were collected.
-static float safeAvg(float sum, uint32_t n) {
-  return n > 0 ? (sum / (float)n) : INVALID_SENTINEL;
-}
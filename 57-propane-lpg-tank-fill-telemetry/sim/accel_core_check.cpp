@@ -0,0 +1,212 @@
+// accel_core_check.cpp — host check for the shared accel_core.h building blocks.
+//
+// accel_core.h is copied unchanged into every sketch that composes it (today
+// the propane tank telemetry and the apiary hive monitor), so this one check
+// covers the summary, cooldown, env-var and cadence plumbing of each of them.
+// It builds only the pure parts of the header (ACCEL_CORE_HOST leaves out the
+// Notecard glue) and replays the cases each app relies on:
+//   AccelStat     — empty readouts report ACCEL_SENTINEL, a true-zero reading
+//                   counts, first/last/lowest/highest/delta track the window,
+//                   the count saturates instead of wrapping, reset() empties it
+//   AccelCooldown — zeroed table is expired, nothing fires before time sync,
+//                   mark() holds one slot for exactly the window
+//   AccelEnvVar   — inclusive and open bounds, every integer width, negative
+//                   and oversized strings rejected without touching the target
+//   AccelCadence  — zeroed cache is due, confirm() clears it, clamping to the
+//                   Notecard's 1 min – 1 week range
+// It also prints each state type's size, since they are carried across sleep
+// in the NotePayload.  Exits 1 on any failure.
+//
+// Build and run from this directory:
+//   g++ -O2 -std=c++11 -I../firmware/propane_tank_telemetry accel_core_check.cpp -o accel_core_check
+//   ./accel_core_check
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ACCEL_CORE_HOST
+#include "accel_core.h"
+
+static int failures = 0;
+
+static void check(bool ok, const char *what)
+{
+    if (!ok) {
+        printf("FAIL: %s\n", what);
+        failures++;
+    }
+}
+
+static bool near(float a, float b)
+{
+    return fabsf(a - b) < 1e-4f;
+}
+
+// ─── AccelStat ───────────────────────────────────────────────────────────────
+static void checkStat()
+{
+    AccelStat<float> s;
+    memset(&s, 0, sizeof(s));       // as a cold-boot PersistState memset leaves it
+    check(s.empty(), "zeroed stat is empty");
+    check(s.avg() == ACCEL_SENTINEL && s.latest() == ACCEL_SENTINEL &&
+          s.lowest() == ACCEL_SENTINEL && s.highest() == ACCEL_SENTINEL &&
+          s.delta() == ACCEL_SENTINEL, "empty stat reports the sentinel");
+
+    // Hive weight over a window: an empty platform (0 kg) is a real reading.
+    const float kg[] = { 0.0f, 41.5f, 42.0f, 39.0f, 40.5f };
+    for (unsigned i = 0; i < sizeof(kg) / sizeof(kg[0]); i++) s.add(kg[i]);
+    printf("%-22s %8s %8s %8s %8s %8s %8s\n", "AccelStat<float>", "n", "avg", "first", "last", "lowest", "delta");
+    printf("%-22s %8u %8.2f %8.2f %8.2f %8.2f %8.2f\n", "  weight window",
+           (unsigned)s.n, s.avg(), s.first, s.latest(), s.lowest(), s.delta());
+    check(s.n == 5, "count");
+    check(near(s.avg(), 32.6f), "average");
+    check(s.first == 0.0f && s.lowest() == 0.0f, "true-zero first reading is kept");
+    check(s.highest() == 42.0f, "highest");
+    check(near(s.delta(), 40.5f), "delta is last minus first");
+
+    s.reset();
+    check(s.empty() && s.avg() == ACCEL_SENTINEL, "reset empties the window");
+
+    // A single audio snapshot per window.
+    s.add(812.0f);
+    check(s.avg() == 812.0f && s.delta() == 0.0f, "single-sample window");
+
+    // Overrunning a window by months must not wrap the count to zero.
+    AccelStat<float> big;
+    big.reset();
+    for (unsigned i = 0; i < 70000; i++) big.add(1.0f);
+    check(big.n == 0xFFFF && !big.empty(), "count saturates at 65535");
+
+    // Integer field type with an integer running total.
+    AccelStat<int16_t, int32_t> ci;
+    ci.reset();
+    ci.add(-120); ci.add(300); ci.add(30000); ci.add(30000);
+    printf("%-22s %8u %8.2f %8d %8d %8d %8.2f\n\n", "  int16_t samples",
+           (unsigned)ci.n, ci.avg(), ci.first, ci.last, ci.lo, ci.delta());
+    check(ci.sum == 60180 && near(ci.avg(), 15045.0f), "int16 samples sum in int32");
+    check(ci.lo == -120 && ci.hi == 30000, "int16 lowest/highest");
+}
+
+// ─── AccelCooldown ───────────────────────────────────────────────────────────
+static void checkCooldown()
+{
+    enum { A_FAULT, A_LOW, A_HIGH, A_KINDS };
+    const uint32_t window = 4 * 3600;
+    const uint32_t t0     = 1760000000;
+
+    AccelCooldown<A_KINDS> cd;
+    cd.clear();
+    check(!cd.ready(A_LOW, 0, window), "nothing fires before time sync");
+    check(cd.ready(A_LOW, t0, window), "zeroed table is expired");
+
+    cd.mark(A_LOW, t0);
+    check(!cd.ready(A_LOW, t0 + window, window), "held for the whole window");
+    check(cd.ready(A_LOW, t0 + window + 1, window), "fires once the window has passed");
+    check(cd.ready(A_FAULT, t0 + 60, window) && cd.ready(A_HIGH, t0 + 60, window),
+          "slots are independent");
+
+    // An unsent alert (mark() not called) stays ready on the next wake.
+    check(cd.ready(A_HIGH, t0 + 900, window), "failed send retries next wake");
+}
+
+// ─── AccelEnvVar ─────────────────────────────────────────────────────────────
+struct EnvCase {
+    const char *raw;
+    bool        accept;
+};
+
+static void runEnv(const AccelEnvVar *e, const EnvCase *cases, unsigned n, double (*read)(const void *))
+{
+    for (unsigned i = 0; i < n; i++) {
+        double before = read(e->target);
+        bool   ok     = accelEnvSet(e, cases[i].raw);
+        double after  = read(e->target);
+        printf("%-30s %-9s %-8s %10g\n", e->name, cases[i].raw, ok ? "applied" : "ignored", after);
+        char what[96];
+        snprintf(what, sizeof(what), "%s=\"%s\" %s", e->name, cases[i].raw,
+                 cases[i].accept ? "accepted" : "rejected");
+        check(ok == cases[i].accept, what);
+        if (!ok) check(after == before, "rejected value leaves the target unchanged");
+    }
+}
+
+static double readF(const void *p)   { return *(const float *)p; }
+static double readU32(const void *p) { return *(const uint32_t *)p; }
+static double readU16(const void *p) { return *(const uint16_t *)p; }
+static double readU8(const void *p)  { return *(const uint8_t *)p; }
+
+static void checkEnv()
+{
+    float    capacity = 500.0f, gpd = 100.0f, drop = 2.0f;
+    uint32_t report   = 24;
+    uint16_t zcr      = 1200;
+    uint8_t  streak   = 3;
+
+    const AccelEnvVar vCap    = { "tank_capacity_gal",             ACCEL_ENV_FLOAT, 0, 10.0f, 30000.0f, &capacity };
+    const AccelEnvVar vGpd    = { "consumption_alert_gal_per_day", ACCEL_ENV_FLOAT, ACCEL_ENV_LO_OPEN, 0.0f, 10000.0f, &gpd };
+    const AccelEnvVar vDrop   = { "weight_alert_kg_drop",          ACCEL_ENV_FLOAT, ACCEL_ENV_LO_OPEN | ACCEL_ENV_HI_OPEN, 0.0f, 50.0f, &drop };
+    const AccelEnvVar vReport = { "report_interval_hr",            ACCEL_ENV_U32,   0, 1.0f, 168.0f, &report };
+    const AccelEnvVar vZcr    = { "audio_zcr_alert",               ACCEL_ENV_U16,   0, 100.0f, 5000.0f, &zcr };
+    const AccelEnvVar vStreak = { "consumption_alert_streak",      ACCEL_ENV_U8,    0, 1.0f, 20.0f, &streak };
+
+    const EnvCase cCap[]    = { { "10", true }, { "30000", true }, { "9.99", false }, { "300000", false }, { "", false } };
+    const EnvCase cGpd[]    = { { "0", false }, { "0.5", true }, { "10000", true }, { "-5", false } };
+    const EnvCase cDrop[]   = { { "50", false }, { "49.9", true }, { "0", false }, { "1.5", true } };
+    const EnvCase cReport[] = { { "168", true }, { "169", false }, { "0", false }, { "-1", false }, { "12", true } };
+    // "70000" wraps to 4464 if cast to uint16_t before the range check.
+    const EnvCase cZcr[]    = { { "70000", false }, { "99", false }, { "5000", true }, { "1500", true } };
+    const EnvCase cStreak[] = { { "257", false }, { "20", true }, { "1", true } };
+
+    printf("%-30s %-9s %-8s %10s\n", "env var", "raw", "result", "value");
+    runEnv(&vCap,    cCap,    sizeof(cCap) / sizeof(cCap[0]),       readF);
+    runEnv(&vGpd,    cGpd,    sizeof(cGpd) / sizeof(cGpd[0]),       readF);
+    runEnv(&vDrop,   cDrop,   sizeof(cDrop) / sizeof(cDrop[0]),     readF);
+    runEnv(&vReport, cReport, sizeof(cReport) / sizeof(cReport[0]), readU32);
+    runEnv(&vZcr,    cZcr,    sizeof(cZcr) / sizeof(cZcr[0]),       readU16);
+    runEnv(&vStreak, cStreak, sizeof(cStreak) / sizeof(cStreak[0]), readU8);
+    printf("\n");
+
+    check(capacity == 30000.0f && gpd == 10000.0f && drop == 1.5f, "float targets end on last accepted value");
+    check(report == 12 && zcr == 1500 && streak == 1, "integer targets end on last accepted value");
+    check(!accelEnvSet(&vCap, NULL), "NULL string is not applied");
+}
+
+// ─── AccelCadence ────────────────────────────────────────────────────────────
+static void checkCadence()
+{
+    AccelCadence c;
+    memset(&c, 0, sizeof(c));
+    check(c.due(1440, 10080), "zeroed cadence is due");
+    c.confirm(1440, 10080);
+    check(!c.due(1440, 10080), "confirmed cadence is not due");
+    check(c.due(720, 10080) && c.due(1440, 2880), "either interval changing is due");
+
+    // 168 h reports with inbound at 2x outbound: both capped at one week.
+    check(accelClampMin(168 * 60) == 10080 && accelClampMin(168 * 120) == 10080,
+          "week-long cadence clamps to 10080");
+    check(accelClampMin(0) == 1, "zero cadence clamps to 1 minute");
+    check(accelClampMin(90) == 90, "in-range cadence unchanged");
+}
+
+int main()
+{
+    checkStat();
+    checkCooldown();
+    checkEnv();
+    checkCadence();
+
+    printf("%-28s %6s\n", "persisted type", "bytes");
+    printf("%-28s %6u\n", "AccelStat<float>",    (unsigned)sizeof(AccelStat<float>));
+    printf("%-28s %6u\n", "AccelCooldown<3>",    (unsigned)sizeof(AccelCooldown<3>));
+    printf("%-28s %6u\n", "AccelCadence",        (unsigned)sizeof(AccelCadence));
+    printf("\n");
+
+    if (failures) {
+        printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("All checks passed.\n");
+    return 0;
+}
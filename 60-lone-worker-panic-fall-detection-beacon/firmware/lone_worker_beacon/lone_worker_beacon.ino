@@ -17,8 +17,9 @@
  *       window, a beacon_location.qo follow-up note is queued (sync:true) with
  *       the event-time coordinates and the same event_id as the initial alert,
  *       so downstream systems can correlate the two notes by (device, event_id).
- *       beginGpsSearch() is called only after beacon_alert.qo is confirmed
- *       queued, so no follow-up search can be orphaned by a failed note.add.
+ *       beginGpsSearch() is called once beacon_alert.qo is sent or held in
+ *       the outbox; a held alert is replayed with the same event_id, so
+ *       the follow-up still pairs with it.
  *       Only one GPS enrichment window is active at a time; a second alert
  *       that fires during an ongoing search receives its cached location only
  *       — no beacon_location.qo follow-up is queued for it.
@@ -97,14 +98,14 @@ uint32_t g_impactWindowStart = 0;   // start of impact window (wraparound-safe)
 // Alert timing
 uint32_t g_lastAlertMs     = 0;
 
-// Fixed-depth alert retry queue. Each entry stores its own event-time context
-// (type + GPS cache epoch + event_id) so a second alert that fails before the
-// first retry succeeds is queued independently — preventing the earlier,
+// Alert outbox. An alert the Notecard doesn't accept is held with its
+// event-time body and replayed in order, so a second alert that fails before
+// the first is delivered is kept independently — preventing the earlier,
 // safety-critical alert from being silently dropped under transient
-// Notecard/I²C failures.
-AlertQueueEntry g_alertQueue[ALERT_QUEUE_DEPTH];   // zero-initialized at boot
-uint8_t         g_alertQueueHead  = 0;   // index of oldest live entry
-uint8_t         g_alertQueueCount = 0;   // number of live entries
+// Notecard/I²C failures. The first few wait in the outbox ring here, the
+// rest in its spill in Notecard flash.
+Outbox   g_outbox;                   // zero-initialized at boot; see outboxBegin()
+uint32_t g_lastAlertRetryMs = 0;     // millis() of the last replay attempt
 
 // Panic button debounce + hold-to-confirm state machine
 bool     g_btnRaw       = false;
@@ -180,6 +181,12 @@ void setup()
     if (g_setupFault)
         DEBUG_PRINTLN("[FAULT] Notecard configuration or template registration failed.");
 
+    // Every boot is a cold boot for the outbox: start a new generation and
+    // recover alerts spilled before the power cycle, so they are still replayed.
+    // If the Notecard doesn't answer, pollAlertRetry() tries again.
+    if (!g_setupFault)
+        outboxBegin(g_outbox);
+
     // Initial env var fetch; arm the 2-hour refresh timer so loop() does not
     // immediately re-fetch on its first pass.
     fetchEnvVars();
@@ -279,17 +286,13 @@ void loop()
     // Advance GPS fix search; never blocks the loop.
     pollGpsSearch();
 
-    // Advance the non-blocking alert retry state machine before processing new
-    // events so that a queued retry fires as early as possible and
-    // g_lastAlertMs is updated before any new cooldown calculation.
+    // Replay held alerts before processing new events so that a waiting
+    // alert goes out as early as possible, ahead of any new one.
     pollAlertRetry();
 
-    // Re-capture `now` AFTER pollAlertRetry. A successful retry sets
-    // g_lastAlertMs from its own millis() snapshot, which is later than the
-    // `now` captured at the top of loop(). Computing (loop_now - g_lastAlertMs)
-    // in uint32_t would underflow to a huge positive value, falsely signalling
-    // an expired cooldown — bypassing the alert-storm protection on the same
-    // loop pass as a successful retry.
+    // Re-capture `now` AFTER pollAlertRetry. A replay can block the loop for
+    // the outbox's note.add retries, and the cooldown and GPS timing below
+    // should see the time the event is actually handled.
     now = millis();
 
     if (fell || panicked) {
@@ -354,33 +357,30 @@ void loop()
             // two notes using (device, event_id) as the join key.
             uint32_t thisEventId = ++g_alertEventId;
 
-            bool sent = sendAlert(alertType, thisEventId, thisLocAgeS);
-            if (sent) {
+            // sendAlert() sends the alert or, if note.add fails, holds it
+            // with the original event-time locAgeS and event_id so its replay
+            // reports the same fix age and correlation key.
+            OutboxResult result = sendAlert(alertType, thisEventId, thisLocAgeS);
+            if (result != OUTBOX_DROPPED) {
                 g_lastAlertMs = now;
                 // Panic triple-buzz fires once the alert is accepted for
-                // transmission — here after a successful note.add. When
-                // note.add fails the buzz still fires (see else branch below)
-                // because the alert is in the firmware retry queue and will
-                // be delivered as soon as the Notecard is reachable. In both
-                // cases the worker receives "alert accepted" feedback, not
-                // "note.add succeeded specifically". A suppressed panic (in-
-                // cooldown) gets a single buzz below to distinguish the two.
+                // transmission — after a successful note.add, or once the
+                // alert is held and will be replayed as soon as the
+                // Notecard accepts it. In both cases the worker receives
+                // "alert accepted" feedback, not "note.add succeeded
+                // specifically". A suppressed panic (in-cooldown) gets a
+                // single buzz below to distinguish the two.
                 if (panicked) triggerHaptic(HAPTIC_BUZZ, 3);
                 // If a GPS search is already active, beginGpsSearch() returns
                 // immediately — this alert receives its cached location only;
                 // no beacon_location.qo follow-up is queued for it.
                 beginGpsSearch(alertType, thisEventId);
-            } else {
-                // sendAlert() makes one attempt. Enqueue for non-blocking
-                // retry, preserving the original event-time locAgeS and
-                // event_id so every retry reports the same fix age and the
-                // same correlation key as this first attempt.
-                enqueueAlert(alertType, thisCacheEpoch, thisEventId, thisLocAgeS);
-                // Triple-buzz fires even on local-queue acceptance: the alert
-                // is held in the firmware retry queue and transmitted as soon
-                // as the Notecard is reachable — "accepted for transmission"
-                // is the correct operator signal here, not "Notecard ACK".
-                if (panicked) triggerHaptic(HAPTIC_BUZZ, 3);
+            } else if (panicked) {
+                // Neither sent nor held: the outbox ring is full and the
+                // spill is full or unreachable. The cooldown is not started, so the worker
+                // can hold the button again at once; the single buzz says
+                // the hold was registered but nothing was sent.
+                triggerHaptic(HAPTIC_BUZZ, 1);
             }
         } else if (panicked) {
             // Panic hold recognised but suppressed by the 60-second cooldown.
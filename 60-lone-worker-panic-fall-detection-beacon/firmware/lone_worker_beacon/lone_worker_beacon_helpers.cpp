@@ -128,6 +128,8 @@ bool defineTemplates()
             JAddNumberToObject(body, "event_id",  14);     // 4-byte signed int32 correlation key
             JAddNumberToObject(body, "voltage",   14.1);   // 4-byte float
             JAddNumberToObject(body, "loc_age_s", 14.1);   // seconds; -1.0 = unknown
+            JAddNumberToObject(body, "boot",      14);     // outbox generation (outbox.h)
+            JAddNumberToObject(body, "seq",       14);     // outbox sequence within it
             JAddNumberToObject(body, "_lat",      14.1);   // from Notecard GPS cache
             JAddNumberToObject(body, "_lon",      14.1);
             J *rsp = notecard.requestAndResponse(req);
@@ -414,7 +416,7 @@ static void disableGps()
 // returns immediately. g_gpsCacheEpoch (the freshness baseline the search uses
 // to distinguish a new fix from the pre-alert cache) must be set by the caller
 // before this function is called. The caller must also have confirmed the alert
-// note was queued — GPS search is never started for an alert that failed.
+// note was sent or held — GPS search is never started for a dropped alert.
 //
 // pollGpsSearch() (called once per outer loop) throttles card.location polls
 // to once every 2 seconds. When a fix whose epoch post-dates g_gpsCacheEpoch
@@ -422,8 +424,8 @@ static void disableGps()
 // g_gpsEventId — the same event_id as the paired beacon_alert.qo.
 //
 // beginGpsSearch() is called only after sendAlert() confirms the initial
-// beacon_alert.qo was queued, so no GPS search can be orphaned by a failed
-// note.add.
+// beacon_alert.qo was sent or held for replay with the same event_id, so no
+// GPS search can be orphaned by a dropped alert.
 //
 // Only one GPS enrichment window can be active at a time. If beginGpsSearch()
 // is called while a search is already running (e.g. a second alert fires during
@@ -582,24 +584,25 @@ void pollGpsSearch()
 // beacon_location.qo follow-up using (device, event_id) as the join key.
 //
 // locAgeS is the cached-fix age in seconds computed by the caller at event-
-// fire time (via card.time) and passed unchanged through every retry attempt.
-// This guarantees every send — first try or last retry — reports the original
-// fix age rather than the age relative to the retry timestamp. The sentinel
-// value −1.0 means the fix age is unknown (no valid cached fix at alert time).
-//
-// beginGpsSearch() is called by the caller only after this function returns
-// true, so no GPS search can be orphaned by a failed note.add.
+// fire time (via card.time). The note goes through the outbox: note.add is
+// tried three times, and a note that still fails is held in the outbox
+// with this body and replayed by pollAlertRetry(), so every send — first try
+// or replay — reports the original fix age. The sentinel value −1.0 means the
+// fix age is unknown (no valid cached fix at alert time). _lat/_lon are filled
+// by the Notecard when the note is finally added, so a replayed alert carries
+// the position at replay time. boot/seq (added by the outbox) let downstream
+// dispatch drop the duplicate a lost I²C acknowledgement can produce.
 //
-// Single note.add attempt — no blocking retries. On failure the caller calls
-// enqueueAlert() to add the alert to the fixed-depth retry queue so the
-// detection loop is never stalled by Notecard I/O.
+// beginGpsSearch() is called by the caller only when this function returns
+// anything but OUTBOX_DROPPED, so no GPS search can be orphaned by a
+// dropped alert.
 //
 // voltage is initialised to -1.0 (sentinel) and updated only on a successful
 // card.voltage read. A second attempt is made if the first fails (card.voltage
 // occasionally loses I²C arbitration after a note.add burst) without delay so
 // the detection loop is not stalled. Downstream rules should treat voltage < 0
 // as "unknown" rather than "0 V".
-bool sendAlert(const char *alertType, uint32_t eventId, float locAgeS)
+OutboxResult sendAlert(const char *alertType, uint32_t eventId, float locAgeS)
 {
     // Retry card.voltage once without delay before accepting failure.
     float voltage = -1.0f;
@@ -612,131 +615,75 @@ bool sendAlert(const char *alertType, uint32_t eventId, float locAgeS)
         }
     }
     // locAgeS was computed by the caller at event-fire time and is used
-    // unchanged here — no card.time call is made inside sendAlert() so
-    // retried notes always carry the original fix age, not the retry-time age.
-
-    // Single note.add attempt. On failure the caller calls enqueueAlert().
-    J *req = notecard.newRequest("note.add");
-    if (!req) return false;
-    JAddStringToObject(req, "file", "beacon_alert.qo");
-    JAddBoolToObject(req,   "sync", true);
-    J *body = JAddObjectToObject(req, "body");
-    JAddStringToObject(body, "type",      alertType);
-    JAddStringToObject(body, "worker_id", g_workerId);
-    JAddNumberToObject(body, "event_id",  (double)eventId);
-    JAddNumberToObject(body, "voltage",   voltage);   // -1.0 = read failed
-    JAddNumberToObject(body, "loc_age_s", locAgeS);
-    // _lat/_lon populated from Notecard cache by compact template
-    J *rsp = notecard.requestAndResponse(req);
-    bool ok = (rsp != NULL && !notecard.responseError(rsp));
-    if (rsp) notecard.deleteResponse(rsp);
-    if (ok) {
+    // unchanged here — no card.time call is made inside sendAlert() so a
+    // replayed note carries the original fix age, not the replay-time age.
+
+    J *body = JCreateObject();
+    if (body) {
+        JAddStringToObject(body, "type",      alertType);
+        JAddStringToObject(body, "worker_id", g_workerId);
+        JAddNumberToObject(body, "event_id",  (double)eventId);
+        JAddNumberToObject(body, "voltage",   voltage);   // -1.0 = read failed
+        JAddNumberToObject(body, "loc_age_s", locAgeS);
+        // _lat/_lon populated from Notecard cache by compact template
+    }
+    OutboxResult result = outboxAdd(g_outbox, "beacon_alert.qo", true, body);
+    if (result == OUTBOX_SENT) {
         DEBUG_PRINT("[ALERT] type="); DEBUG_PRINT(alertType);
         DEBUG_PRINT(" event_id=");    DEBUG_PRINT(eventId);
         DEBUG_PRINT(" worker=");      DEBUG_PRINT(g_workerId);
         DEBUG_PRINT(" vbat=");        DEBUG_PRINT(voltage, 2);
         DEBUG_PRINT(" loc_age_s=");   DEBUG_PRINTLN((int)locAgeS);
+    } else if (result == OUTBOX_QUEUED) {
+        DEBUG_PRINT("[ALERT] note.add failed — event_id="); DEBUG_PRINT(eventId);
+        DEBUG_PRINTLN(" held for replay.");
+    } else if (result == OUTBOX_SPILLED) {
+        DEBUG_PRINT("[ALERT] note.add failed — event_id="); DEBUG_PRINT(eventId);
+        DEBUG_PRINTLN(" spilled for replay.");
     } else {
-        DEBUG_PRINTLN("[ALERT] note.add failed — caller will retry.");
-    }
-    return ok;
-}
-
-// ─── Alert Enqueue ────────────────────────────────────────────────────────
-// Appends a failed-send alert to the fixed-depth circular retry queue.
-// cacheEpoch is the GPS-fix epoch captured at event time; it is kept so
-// pollAlertRetry() can set g_gpsCacheEpoch before starting the GPS search
-// after a successful retry. locAgeS is the cached-fix age computed once at
-// event-fire time; it travels with the entry unchanged so every retry attempt
-// reports the original fix age, not the age relative to the retry timestamp.
-// event_id is preserved so the retried note carries the same correlation key
-// as any eventual beacon_location.qo follow-up. If the queue is full
-// (ALERT_QUEUE_DEPTH concurrent pending alerts — an extreme edge case), the
-// entry is dropped with a debug log; the device cannot buffer unlimited alerts
-// without dynamic allocation.
-void enqueueAlert(const char *alertType, uint32_t cacheEpoch, uint32_t eventId,
-                  float locAgeS)
-{
-    if (g_alertQueueCount >= ALERT_QUEUE_DEPTH) {
-        DEBUG_PRINTLN("[ALERT] Retry queue full — alert dropped.");
-        return;
+        DEBUG_PRINT("[ALERT] note.add failed and outbox full — event_id=");
+        DEBUG_PRINT(eventId); DEBUG_PRINTLN(" dropped.");
     }
-    uint8_t idx = (g_alertQueueHead + g_alertQueueCount) % ALERT_QUEUE_DEPTH;
-    strncpy(g_alertQueue[idx].type, alertType,
-            sizeof(g_alertQueue[idx].type) - 1);
-    g_alertQueue[idx].type[sizeof(g_alertQueue[idx].type) - 1] = '\0';
-    g_alertQueue[idx].cacheEpoch    = cacheEpoch;
-    g_alertQueue[idx].event_id      = eventId;
-    g_alertQueue[idx].locAgeS       = locAgeS;
-    g_alertQueue[idx].retryCount    = 0;
-    // Treat enqueue time as the "0th attempt" timestamp; the first retry fires
-    // once (now - lastAttemptMs) >= ALERT_RETRY_INTERVAL_MS — wraparound-safe.
-    g_alertQueue[idx].lastAttemptMs = millis();
-    g_alertQueueCount++;
-    DEBUG_PRINT("[ALERT] Enqueued '"); DEBUG_PRINT(alertType);
-    DEBUG_PRINT("' event_id="); DEBUG_PRINT(eventId);
-    DEBUG_PRINT(" for retry (queue depth: "); DEBUG_PRINT(g_alertQueueCount);
-    DEBUG_PRINTLN(").");
+    return result;
 }
 
-// ─── Non-Blocking Alert Retry ─────────────────────────────────────────────
+// ─── Held Alert Replay ────────────────────────────────────────────────────
 // Called once per outer loop pass before processing new fall/panic events.
-// Services the head of the fixed-depth retry queue: waits until
-// ALERT_RETRY_INTERVAL_MS has elapsed since the entry's last attempt
-// (wraparound-safe), then makes one sendAlert() attempt. On success the
-// entry is dequeued, g_lastAlertMs is updated, and a GPS follow-up search is
-// started. On failure the retry count is incremented; after ALERT_RETRY_MAX
-// attempts the entry is **discarded** — it was never successfully accepted by
-// note.add, so the Notecard has nothing to reattempt. Only notes that
-// note.add successfully queues are retried by the Notecard for delivery to
-// Notehub. Only one attempt is made per outer loop pass so the detection path
-// is never blocked by Notecard I/O.
+// While alerts are waiting in the outbox, replays them oldest first,
+// up to OUTBOX_FLUSH_MAX per attempt, at most once per
+// ALERT_RETRY_INTERVAL_MS (elapsed-time comparison, wraparound-safe).
+// outboxFlush() stops at the first alert the Notecard still refuses, which
+// stays in the outbox for the next attempt — there is no retry cap, so an
+// alert is never discarded while the Notecard is only temporarily refusing
+// note.add.
+//
+// A replayed alert does not start a GPS search: its search, if any, was
+// started when the alert was held, and a replay can land long after the
+// event.
 //
-// locAgeS and event_id are taken from the queued entry; both were captured
-// at the original event-fire time so every retry attempt reports the same
-// loc_age_s and correlation key as the first attempt.
+// Until outboxBegin() has read the outbox meta Note alerts wait unstamped in
+// the outbox ring and nothing is replayed, so it is retried here on the same
+// schedule.
 void pollAlertRetry()
 {
-    if (g_alertQueueCount == 0) return;
+    if (g_outbox.ready && outboxPending(g_outbox) == 0) return;
     uint32_t now = millis();
+    if ((now - g_lastAlertRetryMs) < ALERT_RETRY_INTERVAL_MS) return;
+    g_lastAlertRetryMs = now;
 
-    AlertQueueEntry &entry = g_alertQueue[g_alertQueueHead % ALERT_QUEUE_DEPTH];
-    // Elapsed-time comparison (wraparound-safe). An absolute deadline would
-    // misbehave around the 49.7-day millis() rollover.
-    if ((now - entry.lastAttemptMs) < ALERT_RETRY_INTERVAL_MS) return;
-
-    // Pass the event-time locAgeS directly to sendAlert() — it was pre-computed
-    // at alert-fire time and stored in the queue entry, so the retried note
-    // always carries the original fix age regardless of retry delay.
-    // g_gpsCacheEpoch (the GPS freshness baseline for pollGpsSearch()) is only
-    // updated here when no search is active and we are about to start one;
-    // leaving it unchanged while a search runs prevents the epoch comparison
-    // from being corrupted mid-search.
-    bool sent = sendAlert(entry.type, entry.event_id, entry.locAgeS);
-    if (sent) {
-        g_lastAlertMs = now;
-        if (!g_gpsSearching)
-            g_gpsCacheEpoch = entry.cacheEpoch;
-        beginGpsSearch(entry.type, entry.event_id);
-        // Dequeue the successfully-sent entry.
-        g_alertQueueHead  = (g_alertQueueHead + 1) % ALERT_QUEUE_DEPTH;
-        g_alertQueueCount--;
+    if (!g_outbox.ready && !outboxBegin(g_outbox)) {
+        DEBUG_PRINTLN("[ALERT] Outbox not started — retrying.");
         return;
     }
+    if (outboxPending(g_outbox) == 0) return;
 
-    if (++entry.retryCount >= ALERT_RETRY_MAX) {
-        DEBUG_PRINT("[ALERT] Max retries ("); DEBUG_PRINT(ALERT_RETRY_MAX);
-        DEBUG_PRINT(") reached for '"); DEBUG_PRINT(entry.type);
-        DEBUG_PRINT("' event_id="); DEBUG_PRINT(entry.event_id);
-        DEBUG_PRINTLN(" — alert dropped (note.add never succeeded).");
-        // Discard and advance to the next queued alert.
-        g_alertQueueHead  = (g_alertQueueHead + 1) % ALERT_QUEUE_DEPTH;
-        g_alertQueueCount--;
+    uint32_t replayed = outboxFlush(g_outbox);
+    if (replayed) {
+        DEBUG_PRINT("[ALERT] Replayed "); DEBUG_PRINT(replayed);
+        DEBUG_PRINT(" held alert(s); "); DEBUG_PRINT(outboxPending(g_outbox));
+        DEBUG_PRINTLN(" still waiting.");
     } else {
-        entry.lastAttemptMs = now;
-        DEBUG_PRINT("[ALERT] Retry "); DEBUG_PRINT(entry.retryCount);
-        DEBUG_PRINT(" for '"); DEBUG_PRINT(entry.type);
-        DEBUG_PRINTLN("' failed — rescheduled.");
+        DEBUG_PRINTLN("[ALERT] Held alert replay failed — rescheduled.");
     }
 }
 
@@ -25,6 +25,8 @@
 #include <math.h>
 #include <string.h>
 
+#include "outbox.h"
+
 // ── Debug output ──────────────────────────────────────────────────────────
 // Uncomment DEBUG_SERIAL to enable serial tracing in all sketch files.
 // Leaving it defined adds a 3-second USB-enumeration wait at boot and
@@ -62,41 +64,18 @@
 // local env-var cache in sync with Notehub on the same 2-hour cadence.
 #define ENV_FETCH_INTERVAL_MS  (120UL * 60000UL)   // 2 hours in ms
 
-// ── Non-blocking alert retry queue ───────────────────────────────────────
-// A fixed-depth circular queue replaces the previous single-slot state machine.
-// Each entry carries its own event-time context (type + GPS-cache epoch +
-// event_id) so a second event that fires before the first retry succeeds is
-// enqueued separately rather than overwriting the earlier entry — preventing
-// silent alert drops on a safety device under transient Notecard/I²C failures.
-// ALERT_QUEUE_DEPTH > max concurrent pending types (fall pending retry = 1
-// realistic maximum; 4 gives a comfortable safety margin).
-#define ALERT_QUEUE_DEPTH        4
-#define ALERT_RETRY_MAX          3
-#define ALERT_RETRY_INTERVAL_MS  500UL
-
-// Per-alert context stored in each queue slot.
-// cacheEpoch is the GPS-fix epoch captured at event time; it is used as the
-// freshness baseline for pollGpsSearch() (not for loc_age_s computation).
-// locAgeS is the fix age in seconds computed once at event-fire time and
-// preserved unchanged through every retry, so the reported freshness always
-// reflects the original alert moment — not the retry time.
-// event_id is the monotonic counter value assigned at alert-fire time;
-// beacon_location.qo carries the same value so downstream systems can pair
-// the two notes using (device, event_id) as the join key. event_id is
-// device-local and resets on power cycle; it is not unique across devices.
-struct AlertQueueEntry {
-    char     type[16];       // alert type string ("fall", "panic")
-    uint32_t cacheEpoch;     // card.location "time" epoch at event time
-    uint32_t event_id;       // monotonic event counter for note correlation
-    float    locAgeS;        // age of cached fix at event-fire time (−1.0 = unknown)
-    uint8_t  retryCount;     // attempts made so far
-    uint32_t lastAttemptMs;  // millis() at last attempt; pollAlertRetry() waits
-                             // until (now - lastAttemptMs) >= ALERT_RETRY_INTERVAL_MS.
-                             // Elapsed-time comparison is wraparound-safe across
-                             // the 49.7-day millis() rollover; an absolute
-                             // deadline would underflow at the rollover and
-                             // either fire too early or too late.
-};
+// ── Alert outbox ──────────────────────────────────────────────────────────
+// beacon_alert.qo goes through the durable outbox (outbox.h). An alert whose
+// note.add still fails after the outbox's three attempts is held with its
+// event-time body (type, event_id, voltage, loc_age_s) and replayed by
+// pollAlertRetry(). The first OUTBOX_RING_MAX wait in a RAM ring, so they are
+// kept even while the Notecard can't be reached; beyond that they spill to
+// Notecard flash, which survives a power cycle of the host and holds
+// OUTBOX_SPILL_MAX alerts.
+// Held alerts are replayed no more often than this. A replay that fails
+// blocks the loop for the outbox's retries (~0.5 s), so an unreachable
+// Notecard is not hammered on every 10 Hz pass.
+#define ALERT_RETRY_INTERVAL_MS  5000UL
 
 // ── Worker ID ─────────────────────────────────────────────────────────────
 // Hard maximum for worker_id (chars, excluding null terminator). A fixed-size
@@ -181,10 +160,9 @@ extern uint32_t g_impactWindowStart;  // start of impact window (wraparound-safe
 // Alert timing
 extern uint32_t g_lastAlertMs;
 
-// Fixed-depth alert retry queue (see pollAlertRetry() / enqueueAlert())
-extern AlertQueueEntry g_alertQueue[ALERT_QUEUE_DEPTH];
-extern uint8_t         g_alertQueueHead;    // index of oldest live entry
-extern uint8_t         g_alertQueueCount;   // number of live entries
+// Alert outbox (see sendAlert() / pollAlertRetry())
+extern Outbox   g_outbox;
+extern uint32_t g_lastAlertRetryMs;   // millis() of the last replay attempt
 
 // Panic button
 extern bool     g_btnRaw;
@@ -240,22 +218,16 @@ void tryReinitAccel();
 bool checkPanicButton();
 void beginGpsSearch(const char *alertType, uint32_t eventId);
 void pollGpsSearch();
-// sendAlert() makes a single note.add attempt (no internal blocking retries).
-// On failure the caller calls enqueueAlert() to schedule non-blocking retries.
-// eventId must match the value that will be written to any follow-up
-// beacon_location.qo so downstream systems can correlate the two notes.
-// locAgeS is the cached-fix age in seconds computed once at event-fire time
-// by the caller (via card.time); it is passed through unchanged on retries
-// so every attempt reports the original fix age, not the retry-time age.
-bool sendAlert(const char *alertType, uint32_t eventId, float locAgeS);
-// Enqueue a failed alert for non-blocking retry. Stores the event-time
-// cacheEpoch (GPS freshness baseline for pollGpsSearch()), the pre-computed
-// locAgeS (fix age at event time, preserved on all retries), and event_id.
-// Drops the entry with a debug log if the queue is full.
-void enqueueAlert(const char *alertType, uint32_t cacheEpoch, uint32_t eventId,
-                  float locAgeS);
-// Drain the head of the retry queue. Call once per outer loop pass before
-// processing new fall/panic events so retries fire as early as possible.
+// sendAlert() queues the alert through the outbox, which holds it for replay
+// if note.add fails. eventId must match the value that will be written to any
+// follow-up beacon_location.qo so downstream systems can correlate the two
+// notes. locAgeS is the cached-fix age in seconds computed once at event-fire
+// time by the caller (via card.time); a held alert is replayed with the
+// same body, so every attempt reports the original fix age.
+OutboxResult sendAlert(const char *alertType, uint32_t eventId, float locAgeS);
+// Replay held alerts, at most once per ALERT_RETRY_INTERVAL_MS. Call once
+// per outer loop pass before processing new fall/panic events so replays
+// fire as early as possible.
 void pollAlertRetry();
 void triggerHaptic(uint8_t effect, int pulses = 1);
 void pollHaptic();
@@ -0,0 +1,308 @@
+/*
+  outbox.cpp
+
+  Durable outbox — see outbox.h for the delivery and dedup semantics.
+
+  Ring slots hold the target Notefile, the sync flag and the body printed
+  unformatted. Spill layout in OUTBOX_FILE: one Note per spilled slot, with
+  ID "s<slot>" and body {"file": target Notefile, "sync": bool, "body":
+  original body}, plus the meta Note {"boot", "head", "tail"}. The meta Note is rewritten
+  only when the spill changes, so a wake that sends everything first time
+  costs no extra Notecard transactions.
+*/
+
+#include "outbox.h"
+
+#include <stdio.h>
+#include <string.h>
+
+extern Notecard notecard;
+
+// Three attempts 250 ms apart ride out a transient I²C fault.
+#define OUTBOX_ATTEMPTS        3
+#define OUTBOX_RETRY_DELAY_MS  250
+
+// Room kept free in a ring slot holding an unstamped body, for the boot/seq
+// it gains once the outbox begins: ,"boot":4294967295,"seq":4294967295
+#define OUTBOX_STAMP_ROOM      36
+
+static void slotNoteId(uint32_t slot, char *id, size_t len) {
+    snprintf(id, len, "s%lu", (unsigned long)slot);
+}
+
+// Sends req and reports whether the Notecard answered without error.
+// Consumes req.
+static bool requestOk(J *req) {
+    if (req == NULL) return false;
+    J *rsp = notecard.requestAndResponse(req);
+    if (rsp == NULL) return false;
+    bool ok = !notecard.responseError(rsp);
+    notecard.deleteResponse(rsp);
+    return ok;
+}
+
+// note.add of a copy of body, retried. noteId is NULL for queue Notefiles.
+static bool addNote(const char *file, const char *noteId, bool sync, const J *body) {
+    for (int attempt = 0; attempt < OUTBOX_ATTEMPTS; attempt++) {
+        if (attempt > 0) delay(OUTBOX_RETRY_DELAY_MS);
+        J *req = notecard.newRequest("note.add");
+        if (req == NULL) continue;
+        JAddStringToObject(req, "file", file);
+        if (noteId != NULL) JAddStringToObject(req, "note", noteId);
+        if (sync) JAddBoolToObject(req, "sync", true);
+        JAddItemToObject(req, "body", JDuplicate(body, true));
+        if (requestOk(req)) return true;
+    }
+    return false;
+}
+
+// Upserts a Note in the spill file: a stale Note can hold the slot's ID when
+// the host lost its state after spilling but before the meta Note caught up.
+static bool putSpillNote(const char *noteId, const J *body) {
+    J *req = notecard.newRequest("note.update");
+    if (req != NULL) {
+        JAddStringToObject(req, "file", OUTBOX_FILE);
+        JAddStringToObject(req, "note", noteId);
+        JAddItemToObject(req, "body", JDuplicate(body, true));
+        if (requestOk(req)) return true;
+    }
+    return addNote(OUTBOX_FILE, noteId, false, body);
+}
+
+static bool writeMeta(const Outbox &ob) {
+    // Every generation written is at least 1; a zero boot is an outbox that
+    // hasn't begun, and would overwrite the real meta Note.
+    if (ob.boot == 0) return false;
+    J *meta = JCreateObject();
+    if (meta == NULL) return false;
+    JAddNumberToObject(meta, "boot", (double)ob.boot);
+    JAddNumberToObject(meta, "head", (double)ob.head);
+    JAddNumberToObject(meta, "tail", (double)ob.tail);
+    bool ok = putSpillNote(OUTBOX_META_NOTE, meta);
+    JDelete(meta);
+    return ok;
+}
+
+static void stamp(Outbox &ob, J *body) {
+    JAddNumberToObject(body, "boot", (double)ob.boot);
+    JAddNumberToObject(body, "seq",  (double)ob.next_seq++);
+}
+
+static OutboxEntry &ringAt(Outbox &ob, uint8_t i) {
+    return ob.ring[(ob.ring_head + i) % OUTBOX_RING_MAX];
+}
+
+// Prints body into the next ring slot. False if the ring is full or the
+// Note doesn't fit a slot.
+static bool ringPush(Outbox &ob, const char *file, bool sync, J *body, bool stamped) {
+    if (ob.ring_count >= OUTBOX_RING_MAX || strlen(file) >= OUTBOX_NOTEFILE_MAX) return false;
+    OutboxEntry &e = ringAt(ob, ob.ring_count);
+    int room = OUTBOX_BODY_MAX - (stamped ? 0 : OUTBOX_STAMP_ROOM);
+    if (!JPrintPreallocated(body, e.body, room, false)) return false;
+    strcpy(e.file, file);
+    e.sync    = sync;
+    e.stamped = stamped;
+    ob.ring_count++;
+    return true;
+}
+
+// Stamps a Note that was held before the outbox began. Leaves the slot
+// untouched if the body can't be parsed or printed (out of memory).
+static bool stampEntry(Outbox &ob, OutboxEntry &e) {
+    J *body = JParse(e.body);
+    if (body == NULL) return false;
+    char text[OUTBOX_BODY_MAX];
+    stamp(ob, body);
+    bool ok = JPrintPreallocated(body, text, sizeof(text), false);
+    JDelete(body);
+    if (!ok) return false;
+    memcpy(e.body, text, sizeof(text));
+    e.stamped = 1;
+    return true;
+}
+
+static OutboxResult spillStamped(Outbox &ob, const char *file, bool sync, J *body) {
+    if (ob.tail - ob.head >= OUTBOX_SPILL_MAX) {
+        ob.dropped++;
+        return OUTBOX_DROPPED;
+    }
+    J *entry = JCreateObject();
+    if (entry == NULL) {
+        ob.dropped++;
+        return OUTBOX_DROPPED;
+    }
+    JAddStringToObject(entry, "file", file);
+    JAddBoolToObject(entry, "sync", sync);
+    JAddItemToObject(entry, "body", JDuplicate(body, true));
+
+    char id[16];
+    slotNoteId(ob.tail, id, sizeof(id));
+    bool ok = putSpillNote(id, entry);
+    JDelete(entry);
+    if (!ok) {
+        ob.dropped++;
+        return OUTBOX_DROPPED;
+    }
+    ob.tail++;
+    writeMeta(ob);  // best-effort: the host state already holds the new tail
+    return OUTBOX_SPILLED;
+}
+
+// Keeps a Note that wasn't sent: in the ring while nothing is spilled and a
+// slot is free, otherwise in the spill. The ring therefore always holds the
+// oldest Notes, and replaying it before the spill keeps them in order. Before
+// the outbox has begun there is no spill to fall back on.
+static OutboxResult hold(Outbox &ob, const char *file, bool sync, J *body) {
+    if (ob.head == ob.tail && ringPush(ob, file, sync, body, ob.ready)) return OUTBOX_QUEUED;
+    if (!ob.ready) {
+        ob.dropped++;
+        return OUTBOX_DROPPED;
+    }
+    return spillStamped(ob, file, sync, body);
+}
+
+bool outboxBegin(Outbox &ob) {
+    if (ob.ready) return true;
+
+    J *req = notecard.newRequest("note.get");
+    if (req == NULL) return false;
+    JAddStringToObject(req, "file", OUTBOX_FILE);
+    JAddStringToObject(req, "note", OUTBOX_META_NOTE);
+    J *rsp = notecard.requestAndResponse(req);
+    if (rsp == NULL) return false;  // Notecard unreachable; retry next wake
+
+    // Only {note-noexist} means there is no meta Note yet: the first boot of
+    // a new device. Any other error, such as {io} or a busy Notecard, says
+    // nothing about the meta Note, so leave the outbox unbegun rather than
+    // overwrite it and reuse the first generation's keys.
+    uint32_t boot = 0, head = 0, tail = 0;
+    bool known;
+    const char *err = JGetString(rsp, "err");
+    if (err != NULL && *err != '\0') {
+        known = NoteErrorContains(err, "{note-noexist}");
+    } else {
+        known = true;
+        J *meta = JGetObject(rsp, "body");
+        if (meta != NULL) {
+            boot = (uint32_t)JGetNumber(meta, "boot");
+            head = (uint32_t)JGetNumber(meta, "head");
+            tail = (uint32_t)JGetNumber(meta, "tail");
+            if (tail - head > OUTBOX_SPILL_MAX) head = tail;  // corrupt meta
+        }
+    }
+    notecard.deleteResponse(rsp);
+    if (!known) return false;
+
+    // The new generation counts only once it is on the Notecard; otherwise
+    // the next cold boot would read the old one and stamp the same keys.
+    ob.boot = boot + 1;
+    ob.head = head;
+    ob.tail = tail;
+    if (!writeMeta(ob)) {
+        ob.boot = ob.head = ob.tail = 0;
+        return false;
+    }
+    ob.next_seq = 0;
+    ob.ready = 1;
+
+    // Notes held while the outbox couldn't begin take the first keys of the
+    // generation, in the order they were held; one that can't be stamped now
+    // is stamped when it is replayed.
+    for (uint8_t i = 0; i < ob.ring_count; i++) {
+        OutboxEntry &e = ringAt(ob, i);
+        if (!e.stamped) stampEntry(ob, e);
+    }
+    return true;
+}
+
+OutboxResult outboxAdd(Outbox &ob, const char *file, bool sync, J *body) {
+    if (body == NULL) {
+        ob.dropped++;
+        return OUTBOX_DROPPED;
+    }
+    OutboxResult result;
+    if (ob.ready) {
+        stamp(ob, body);
+        result = addNote(file, NULL, sync, body) ? OUTBOX_SENT : hold(ob, file, sync, body);
+    } else {
+        result = hold(ob, file, sync, body);  // no generation to stamp yet
+    }
+    JDelete(body);
+    return result;
+}
+
+OutboxResult outboxHold(Outbox &ob, const char *file, bool sync, J *body) {
+    if (body == NULL) {
+        ob.dropped++;
+        return OUTBOX_DROPPED;
+    }
+    if (ob.ready) stamp(ob, body);
+    OutboxResult result = hold(ob, file, sync, body);
+    JDelete(body);
+    return result;
+}
+
+uint32_t outboxFlush(Outbox &ob) {
+    uint32_t replayed = 0;
+    bool moved = false;
+    char id[16];
+
+    if (!ob.ready) return 0;
+
+    // The ring holds the oldest Notes, so it is drained first.
+    while (replayed < OUTBOX_FLUSH_MAX && ob.ring_count > 0) {
+        OutboxEntry &e = ob.ring[ob.ring_head];
+        if (!e.stamped && !stampEntry(ob, e)) return replayed;
+        J *body = JParse(e.body);
+        if (body == NULL) return replayed;  // out of memory; retry next wake
+        bool sent = addNote(e.file, NULL, e.sync, body);
+        JDelete(body);
+        if (!sent) return replayed;
+        ob.ring_head = (ob.ring_head + 1) % OUTBOX_RING_MAX;
+        ob.ring_count--;
+        replayed++;
+    }
+
+    while (replayed < OUTBOX_FLUSH_MAX && ob.head != ob.tail) {
+        slotNoteId(ob.head, id, sizeof(id));
+
+        J *req = notecard.newRequest("note.get");
+        if (req == NULL) break;
+        JAddStringToObject(req, "file", OUTBOX_FILE);
+        JAddStringToObject(req, "note", id);
+        J *rsp = notecard.requestAndResponse(req);
+        if (rsp == NULL) break;  // Notecard unreachable; try again next wake
+
+        // Only a slot the Notecard reports as nonexistent was already replayed
+        // and deleted (e.g. before a power cut, ahead of the meta update). Any
+        // other error, such as {io} or a busy Notecard, says nothing about the
+        // slot, so stop here and retry it on the next wake rather than moving
+        // head past a reading that was never replayed.
+        bool delivered;
+        const char *err = JGetString(rsp, "err");
+        if (err != NULL && *err != '\0') {
+            delivered = NoteErrorContains(err, "{note-noexist}");
+        } else {
+            J *entry = JGetObject(rsp, "body");
+            J *body  = entry ? JGetObject(entry, "body") : NULL;
+            const char *file = entry ? JGetString(entry, "file") : "";
+            delivered = (body == NULL || *file == '\0') ||
+                        addNote(file, NULL, JGetBool(entry, "sync"), body);
+        }
+        notecard.deleteResponse(rsp);
+        if (!delivered) break;
+
+        J *del = notecard.newRequest("note.delete");
+        if (del != NULL) {
+            JAddStringToObject(del, "file", OUTBOX_FILE);
+            JAddStringToObject(del, "note", id);
+            notecard.sendRequest(del);  // a leftover is overwritten when the slot is reused
+        }
+        ob.head++;
+        replayed++;
+        moved = true;
+    }
+
+    if (moved) writeMeta(ob);  // one meta update for the whole flush
+    return replayed;
+}
@@ -87,11 +87,9 @@ bool              lightSensorOk = false;
 bool notecardConfigure();
 bool defineTemplates();
 void runSampleCycle();
-static void    stashPendingAlert(const char *type, float tc, float lx,
-                                 bool door, uint32_t dsec, bool tv, uint32_t epoch);
-static void    updateAlertCooldown(const char *type, uint32_t t);
-static uint8_t alertTypeToBit(const char *type);
-static uint8_t recomputeAlertTypeMask();
+static void updateAlertCooldown(const char *type, uint32_t t);
+static void raiseAlert(const char *type, float tc, float lx,
+                       bool door, uint32_t dsec, bool tv, uint32_t now);
 
 // ===========================================================================
 // setup() — runs fresh on every wake from Notecard-controlled sleep
@@ -149,6 +147,12 @@ void setup() {
     if (!state.notecard_configured) state.notecard_configured = notecardConfigure();
     if (!state.templates_defined)   state.templates_defined   = defineTemplates();
 
+    // Start a new outbox generation, recovering any Notes spilled before the
+    // state was lost. Retried every wake, like the steps above, until the
+    // meta Note is read; until then readings and alerts wait unstamped in the
+    // outbox ring rather than take a generation that may be reused.
+    if (!state.outbox.ready) outboxBegin(state.outbox);
+
     // Pull any updated environment variables from Notehub on every wake.
     fetchEnvOverrides();
 
@@ -272,6 +276,9 @@ bool defineTemplates() {
         // Cumulative drop counters — observable in Notehub without a separate channel
         JAddNumberToObject(body, "dropped_readings", 24);
         JAddNumberToObject(body, "dropped_alerts",   24);
+        // Outbox dedup key (see outbox.h): generation + per-generation sequence
+        JAddNumberToObject(body, "boot",             24);
+        JAddNumberToObject(body, "seq",              24);
 
         J *rsp = notecard.requestAndResponse(req);
         if (rsp == NULL) {
@@ -301,10 +308,10 @@ bool defineTemplates() {
 // ===========================================================================
 // updateAlertCooldown — advance the per-type last-alert timestamp
 // ===========================================================================
-// Called after every successful alert send (first attempt or ring-buffer
-// retry) so the cooldown state is always consistent with what has actually
-// been enqueued. Keeping cooldown timestamps current prevents the same alert
-// type from firing again as a duplicate within the same wake cycle.
+// Called by raiseAlert() once an alert has been sent or held in the outbox,
+// so the cooldown state is always consistent with what will be delivered.
+// Keeping cooldown timestamps current prevents the same alert type from
+// firing again as a duplicate within the same wake cycle.
 static void updateAlertCooldown(const char *type, uint32_t t) {
     if (strcmp(type, "temp_excursion_high") == 0)
         state.last_temp_high_alert_time = t;
@@ -317,119 +324,30 @@ static void updateAlertCooldown(const char *type, uint32_t t) {
 }
 
 // ===========================================================================
-// alertTypeToBit — map an alert type string to its ALERT_BIT_* bitmask flag
-// ===========================================================================
-static uint8_t alertTypeToBit(const char *type) {
-    if (strcmp(type, "temp_excursion_high") == 0)  return ALERT_BIT_TEMP_HIGH;
-    if (strcmp(type, "temp_excursion_low") == 0)   return ALERT_BIT_TEMP_LOW;
-    if (strcmp(type, "door_open_timeout") == 0)    return ALERT_BIT_DOOR_TIMEOUT;
-    if (strcmp(type, "sensor_disagreement") == 0)  return ALERT_BIT_SENSOR_DISAGREE;
-    return 0;
-}
-
-// ===========================================================================
-// recomputeAlertTypeMask — derive pending_alert_type_mask from ring contents
+// raiseAlert — send an alert and start its cooldown once it is in the outbox
 // ===========================================================================
-// Scans every live entry in the pending_alerts ring and returns the OR of
-// their type bits. Call this after any mutation of the ring (stash or dequeue)
-// to guarantee the mask is accurate. An OR-only approach leaves stale bits
-// when an entry is evicted on ring-full overwrite (the dropped entry's type
-// bit stays set even though no entry of that type remains in the ring), which
-// can permanently suppress future alerts of that type.
-static uint8_t recomputeAlertTypeMask() {
-    uint8_t mask = 0;
-    for (uint8_t i = 0; i < state.pending_alert_count; i++) {
-        uint8_t slot = (state.pending_alert_head + i) % PENDING_RING_CAP;
-        mask |= alertTypeToBit(state.pending_alerts[slot].type);
-    }
-    return mask;
-}
-
-// ===========================================================================
-// stashPendingAlert — enqueue a failed alert payload into the ring buffer
-// ===========================================================================
-// Appends to the FIFO ring. When the ring is full the oldest entry is
-// overwritten and dropped_alerts is incremented. The original trigger epoch
-// is preserved in the entry so audit lineage survives retry delays.
-// Cooldown state is NOT advanced here; the caller withholds the cooldown
-// update on send failure so the alert remains eligible for retry without
-// waiting through a full cooldown window. pending_alert_type_mask is
-// recomputed from scratch after every ring mutation so that a dropped entry's
-// type bit is cleared when it no longer has a live entry in the ring.
-static void stashPendingAlert(const char *type, float tc, float lx,
-                              bool door, uint32_t dsec, bool tv, uint32_t epoch) {
-    uint8_t tail = (state.pending_alert_head + state.pending_alert_count)
-                   % PENDING_RING_CAP;
-    strncpy(state.pending_alerts[tail].type, type, PENDING_ALERT_TYPE_LEN - 1);
-    state.pending_alerts[tail].type[PENDING_ALERT_TYPE_LEN - 1] = '\0';
-    state.pending_alerts[tail].temp_c        = tc;
-    state.pending_alerts[tail].lux           = lx;
-    state.pending_alerts[tail].door_open     = door;
-    state.pending_alerts[tail].door_open_sec = dsec;
-    state.pending_alerts[tail].time_valid    = tv;
-    state.pending_alerts[tail].epoch         = epoch;
-    if (state.pending_alert_count < PENDING_RING_CAP) {
-        state.pending_alert_count++;
+// A held alert will be replayed, so it starts the cooldown exactly like a
+// sent one; this is what stops a condition that persists across an outage
+// from queueing a duplicate alert on every wake. Only a dropped alert leaves
+// the cooldown alone, so the rule fires again on the next wake.
+static void raiseAlert(const char *type, float tc, float lx,
+                       bool door, uint32_t dsec, bool tv, uint32_t now) {
+    if (sendAlert(type, tc, lx, door, dsec, tv, now) != OUTBOX_DROPPED) {
+        updateAlertCooldown(type, now);
     } else {
-        // Ring is full — overwrite oldest entry and count the loss.
-        state.pending_alert_head = (state.pending_alert_head + 1) % PENDING_RING_CAP;
         state.dropped_alerts++;
     }
-    // Recompute the mask from current ring contents so that a type bit is
-    // cleared when its last entry was just overwritten. An OR-only update
-    // would leave the dropped entry's bit set, suppressing future alerts of
-    // that type even though no entry of that type remains in the ring.
-    state.pending_alert_type_mask = recomputeAlertTypeMask();
 }
 
 // ===========================================================================
-// runSampleCycle — per-wake logic: retry pending → read → evaluate → record
+// runSampleCycle — per-wake logic: read → evaluate → record → replay held
 // ===========================================================================
 void runSampleCycle() {
-    // Resolve current time first so it is available both for the ring-buffer
-    // retry blocks below (cooldown updates) and for the alert evaluation later.
+    // Resolve current time first; it anchors the door timer, the alert
+    // cooldowns and the sample_epoch / event_epoch body fields.
     uint32_t now        = getEpochTime();
     bool     time_valid = (now > 0);
 
-    // --- Retry pending alerts (FIFO; drain until one fails or buffer empty) ---
-    // Alerts are retried before new sensor data is collected to prioritise
-    // excursion notification. For each successfully retried alert the matching
-    // cooldown timestamp is advanced to now, preventing the same alert type
-    // from firing again during this wake if the condition is still active.
-    // now is preferred over pa.epoch so that the cooldown is anchored at retry
-    // time; if now is not yet valid (time not synced) pa.epoch is used instead.
-    while (state.pending_alert_count > 0) {
-        PendingAlert &pa = state.pending_alerts[state.pending_alert_head];
-        if (!sendAlert(pa.type, pa.temp_c, pa.lux, pa.door_open,
-                       pa.door_open_sec, pa.time_valid, pa.epoch)) {
-            break;  // Notecard still unreachable; leave remainder in buffer.
-        }
-        updateAlertCooldown(pa.type, now > 0 ? now : pa.epoch);
-        state.pending_alert_head =
-            (state.pending_alert_head + 1) % PENDING_RING_CAP;
-        state.pending_alert_count--;
-        // Recompute the mask from the remaining ring contents. An AND-NOT clear
-        // of just the delivered type's bit would be wrong when two entries of
-        // the same type were queued — it would clear the bit while the second
-        // entry still waits. Scanning the live ring after every dequeue gives
-        // the exact set of types that still have a pending entry.
-        state.pending_alert_type_mask = recomputeAlertTypeMask();
-    }
-
-    // --- Retry pending readings (only after templates are confirmed) ---
-    if (state.templates_defined) {
-        while (state.pending_read_count > 0) {
-            PendingReading &pr = state.pending_reads[state.pending_read_head];
-            if (!sendReading(pr.temp_c, pr.lux, pr.door_open,
-                             pr.door_open_sec, pr.time_valid, pr.sample_epoch)) {
-                break;  // Notecard still unreachable; leave remainder in buffer.
-            }
-            state.pending_read_head =
-                (state.pending_read_head + 1) % PENDING_RING_CAP;
-            state.pending_read_count--;
-        }
-    }
-
     // --- Read sensors ---
     float temp_c = readTemperatureC();
     float lux    = readLightLux();
@@ -452,16 +370,9 @@ void runSampleCycle() {
         if (state.door_open_since > 0 && now > 0 && now >= state.door_open_since) {
             uint32_t open_sec = now - state.door_open_since;
             if (open_sec >= state.door_alert_min * 60 &&
-                !(state.pending_alert_type_mask & ALERT_BIT_DOOR_TIMEOUT) &&
                 (now - state.last_door_timeout_alert_time) >= state.alert_cooldown_sec) {
-                if (sendAlert("door_open_timeout", temp_c, lux, door,
-                              open_sec, time_valid, now)) {
-                    updateAlertCooldown("door_open_timeout", now);
-                } else {
-                    // Enqueue failed — do not advance cooldown; stash for retry.
-                    stashPendingAlert("door_open_timeout", temp_c, lux,
-                                      door, open_sec, time_valid, now);
-                }
+                raiseAlert("door_open_timeout", temp_c, lux, door,
+                           open_sec, time_valid, now);
             }
         }
     } else {
@@ -481,15 +392,9 @@ void runSampleCycle() {
     // always-on-lamp units without a firmware rebuild.
     bool light_on = (!isnan(lux) && lux > state.lux_threshold);
     if (light_on && !door && now > 0) {
-        if (!(state.pending_alert_type_mask & ALERT_BIT_SENSOR_DISAGREE) &&
-            (now - state.last_sensor_disagree_alert_time) >= state.alert_cooldown_sec) {
-            if (sendAlert("sensor_disagreement", temp_c, lux, false,
-                          0, time_valid, now)) {
-                updateAlertCooldown("sensor_disagreement", now);
-            } else {
-                stashPendingAlert("sensor_disagreement", temp_c, lux,
-                                  false, 0, time_valid, now);
-            }
+        if ((now - state.last_sensor_disagree_alert_time) >= state.alert_cooldown_sec) {
+            raiseAlert("sensor_disagreement", temp_c, lux, false,
+                       0, time_valid, now);
         }
     }
 
@@ -498,57 +403,34 @@ void runSampleCycle() {
     // low-temp alert on the same sample cycle.
     if (!isnan(temp_c) && now > 0) {
         if (temp_c > state.temp_high_c &&
-            !(state.pending_alert_type_mask & ALERT_BIT_TEMP_HIGH) &&
             (now - state.last_temp_high_alert_time) >= state.alert_cooldown_sec) {
-            if (sendAlert("temp_excursion_high", temp_c, lux, door,
-                          door_sec, time_valid, now)) {
-                updateAlertCooldown("temp_excursion_high", now);
-            } else {
-                stashPendingAlert("temp_excursion_high", temp_c, lux,
-                                  door, door_sec, time_valid, now);
-            }
+            raiseAlert("temp_excursion_high", temp_c, lux, door,
+                       door_sec, time_valid, now);
         }
         if (temp_c < state.temp_low_c &&
-            !(state.pending_alert_type_mask & ALERT_BIT_TEMP_LOW) &&
             (now - state.last_temp_low_alert_time) >= state.alert_cooldown_sec) {
-            if (sendAlert("temp_excursion_low", temp_c, lux, door,
-                          door_sec, time_valid, now)) {
-                updateAlertCooldown("temp_excursion_low", now);
-            } else {
-                stashPendingAlert("temp_excursion_low", temp_c, lux,
-                                  door, door_sec, time_valid, now);
-            }
+            raiseAlert("temp_excursion_low", temp_c, lux, door,
+                       door_sec, time_valid, now);
         }
     }
 
     // --- Per-sample reading Note ---
-    // sendReading() is only called when the template is confirmed; free-form JSON
-    // sent before note.template is applied would corrupt the binary schema.
-    // When templates are not yet defined — or when note.add fails — the sample is
-    // buffered into the FIFO ring so no reading is silently lost. sample_epoch is
-    // captured now (at sensor-read time) and preserved through retries so that
-    // the body always carries the authoritative original sample timestamp.
-    bool sent = false;
-    if (state.templates_defined) {
-        sent = sendReading(temp_c, lux, door, door_sec, time_valid, now);
+    // Free-form JSON sent before note.template is applied would corrupt the
+    // binary schema, so until the template is confirmed the reading is held
+    // without a send attempt. sample_epoch is captured now (at sensor-read
+    // time) and preserved through replay so that the body always carries the
+    // authoritative original sample timestamp.
+    OutboxResult reading = sendReading(temp_c, lux, door, door_sec, time_valid,
+                                       now, !state.templates_defined);
+    if (reading == OUTBOX_DROPPED) {
+        state.dropped_readings++;
     }
-    if (!sent) {
-        // Enqueue into the FIFO ring buffer for retry next wake. When full,
-        // the oldest entry is overwritten and dropped_readings is incremented.
-        uint8_t tail = (state.pending_read_head + state.pending_read_count)
-                       % PENDING_RING_CAP;
-        state.pending_reads[tail].temp_c        = temp_c;
-        state.pending_reads[tail].lux           = lux;
-        state.pending_reads[tail].door_open     = door;
-        state.pending_reads[tail].door_open_sec = door_sec;
-        state.pending_reads[tail].time_valid    = time_valid;
-        state.pending_reads[tail].sample_epoch  = now;
-        if (state.pending_read_count < PENDING_RING_CAP) {
-            state.pending_read_count++;
-        } else {
-            state.pending_read_head =
-                (state.pending_read_head + 1) % PENDING_RING_CAP;
-            state.dropped_readings++;
-        }
+
+    // --- Replay held Notes ---
+    // A reading that was just sent proves the Notecard is reachable and the
+    // template exists, so replay anything held on earlier wakes now, in
+    // one pass, oldest first. Each replayed Note keeps its original boot/seq.
+    if (reading == OUTBOX_SENT && outboxPending(state.outbox) > 0) {
+        outboxFlush(state.outbox);
     }
 }
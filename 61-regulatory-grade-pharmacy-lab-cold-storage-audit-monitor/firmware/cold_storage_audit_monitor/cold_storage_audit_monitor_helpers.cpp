@@ -176,95 +176,71 @@ uint32_t getEpochTime() {
 }
 
 // ===========================================================================
-// sendReading — enqueue one per-sample templated Note
+// sendReading — enqueue one per-sample templated Note through the outbox
 // ===========================================================================
-// Retries up to three times to survive transient Notecard/I2C faults.
-// Returns true on success (and resets the drop counters now that they have
-// been reported in the Note body). Returns false when all retries fail;
-// the caller is responsible for persisting the payload and accounting for
-// the loss.
+// outboxAdd() retries note.add up to three times to survive transient
+// Notecard/I2C faults and holds the Note for replay if they all fail.
+// The drop counters are reset once a reading carrying them is sent or
+// held, since either way they will reach Notehub.
 //
 // sample_epoch: UTC epoch captured at sensor-read time. Written as an explicit
-// body field so retried Notes (whose Notecard envelope reflects retry time)
+// body field so replayed Notes (whose Notecard envelope reflects replay time)
 // still carry the authoritative original sample timestamp for audit lineage.
 // Pass 0 together with time_valid:false when the Notecard RTC has not yet
 // synced — downstream systems can distinguish pre-sync data explicitly.
-bool sendReading(float temp_c, float lux, bool door_open,
-                 uint32_t door_open_sec, bool time_valid, uint32_t sample_epoch) {
-    for (int attempt = 0; attempt < 3; attempt++) {
-        if (attempt > 0) delay(250);
-
-        J *req = notecard.newRequest("note.add");
-        JAddStringToObject(req, "file", NOTEFILE_READING);
-        J *body = JAddObjectToObject(req, "body");
+OutboxResult sendReading(float temp_c, float lux, bool door_open,
+                         uint32_t door_open_sec, bool time_valid,
+                         uint32_t sample_epoch, bool hold_only) {
+    J *body = JCreateObject();
+    if (body != NULL) {
         JAddNumberToObject(body, "temp_c",
                            (double)(isnan(temp_c) ? SENTINEL_NO_DATA : temp_c));
         JAddNumberToObject(body, "lux",
                            (double)(isnan(lux) ? SENTINEL_LUX_NO_DATA : lux));
         JAddBoolToObject(body,   "door_open",         door_open);
         JAddNumberToObject(body, "door_open_sec",     (int)door_open_sec);
-        // Authoritative sample time for audit lineage. On first-attempt sends
-        // this matches the Notecard envelope time; on retried sends it preserves
-        // the original sample epoch despite the envelope reflecting retry time.
         JAddNumberToObject(body, "sample_epoch",      (double)sample_epoch);
         JAddBoolToObject(body,   "time_valid",        time_valid);
         // Cumulative drop counters — visible in Notehub without a separate channel
         JAddNumberToObject(body, "dropped_readings",  (double)state.dropped_readings);
         JAddNumberToObject(body, "dropped_alerts",    (double)state.dropped_alerts);
-        // Reading Notes ride the regular outbound cadence; no sync:true needed.
+    }
 
-        J *rsp = notecard.requestAndResponse(req);
-        if (rsp == NULL) {
-#if ENABLE_DEBUG
-            Serial.print("[WARN] sendReading: no response (attempt ");
-            Serial.print(attempt + 1); Serial.println(")");
-#endif
-            continue;
-        }
-        if (notecard.responseError(rsp)) {
-#if ENABLE_DEBUG
-            Serial.print("[WARN] sendReading: "); Serial.println(JGetString(rsp, "err"));
-#endif
-            notecard.deleteResponse(rsp);
-            continue;
-        }
-        notecard.deleteResponse(rsp);
-        // Success: clear accumulated drop counters now that they have been reported.
+    // Reading Notes ride the regular outbound cadence; no sync:true needed.
+    OutboxResult result = hold_only
+                          ? outboxHold(state.outbox, NOTEFILE_READING, false, body)
+                          : outboxAdd(state.outbox, NOTEFILE_READING, false, body);
+    if (result != OUTBOX_DROPPED) {
         state.dropped_readings = 0;
         state.dropped_alerts   = 0;
-        return true;
     }
 #if ENABLE_DEBUG
-    Serial.println("[ERR] sendReading: all retries failed");
+    if (result == OUTBOX_QUEUED)  Serial.println("[WARN] sendReading: held for replay");
+    if (result == OUTBOX_SPILLED) Serial.println("[WARN] sendReading: spilled for replay");
+    if (result == OUTBOX_DROPPED) Serial.println("[ERR] sendReading: dropped");
 #endif
-    return false;
+    return result;
 }
 
 // ===========================================================================
-// sendAlert — enqueue an immediate-sync alert Note
+// sendAlert — enqueue an immediate-sync alert Note through the outbox
 // ===========================================================================
 // sync:true tells the Notecard to open a cellular session immediately rather
-// than waiting for the next scheduled outbound window. Retries up to three
-// times to survive transient faults.
-// Returns true on success; false when all retries are exhausted.
-// On false the caller must NOT advance the cooldown timestamp (keeping the
-// alert eligible for retry) and should persist the payload in AppState.
+// than waiting for the next scheduled outbound window; a held alert keeps
+// sync:true when it is replayed.
+// On OUTBOX_DROPPED the caller must NOT advance the cooldown timestamp
+// (keeping the alert eligible on the next wake).
 //
 // event_epoch: the UTC epoch when the alert condition was first detected.
-// note.add has no timestamp-override field, so the Notecard stamps a retried
-// Note with retry time in the envelope. event_epoch is always written as an
+// note.add has no timestamp-override field, so the Notecard stamps a replayed
+// Note with replay time in the envelope. event_epoch is always written as an
 // explicit body field so downstream audit queries can use the original trigger
-// time regardless of whether this is a first-attempt or retried send.
-bool sendAlert(const char *alert_type, float temp_c, float lux,
-               bool door_open, uint32_t door_open_sec, bool time_valid,
-               uint32_t event_epoch) {
-    for (int attempt = 0; attempt < 3; attempt++) {
-        if (attempt > 0) delay(250);
-
-        J *req = notecard.newRequest("note.add");
-        JAddStringToObject(req, "file", NOTEFILE_ALERT);
-        JAddBoolToObject(req, "sync", true);
-        J *body = JAddObjectToObject(req, "body");
+// time regardless of whether this is a first-attempt or replayed send.
+OutboxResult sendAlert(const char *alert_type, float temp_c, float lux,
+                       bool door_open, uint32_t door_open_sec, bool time_valid,
+                       uint32_t event_epoch) {
+    J *body = JCreateObject();
+    if (body != NULL) {
         JAddStringToObject(body, "alert",         alert_type);
         JAddNumberToObject(body, "temp_c",
                            (double)(isnan(temp_c) ? SENTINEL_NO_DATA : temp_c));
@@ -273,34 +249,16 @@ bool sendAlert(const char *alert_type, float temp_c, float lux,
         JAddBoolToObject(body,   "door_open",      door_open);
         JAddNumberToObject(body, "door_open_sec",  (int)door_open_sec);
         JAddBoolToObject(body,   "time_valid",     time_valid);
-        // Authoritative trigger time for audit lineage. On first-attempt sends
-        // this matches the Notecard envelope time; on retried sends it
-        // preserves the original event epoch despite the envelope reflecting
-        // retry time.
         JAddNumberToObject(body, "event_epoch",    (double)event_epoch);
-
-        J *rsp = notecard.requestAndResponse(req);
-        if (rsp == NULL) {
-#if ENABLE_DEBUG
-            Serial.print("[WARN] sendAlert: no response (attempt ");
-            Serial.print(attempt + 1); Serial.println(")");
-#endif
-            continue;
-        }
-        if (notecard.responseError(rsp)) {
-#if ENABLE_DEBUG
-            Serial.print("[WARN] sendAlert: "); Serial.println(JGetString(rsp, "err"));
-#endif
-            notecard.deleteResponse(rsp);
-            continue;
-        }
-        notecard.deleteResponse(rsp);
-        return true;
     }
+
+    OutboxResult result = outboxAdd(state.outbox, NOTEFILE_ALERT, true, body);
 #if ENABLE_DEBUG
-    Serial.println("[ERR] sendAlert: all retries failed");
+    if (result == OUTBOX_QUEUED)  Serial.println("[WARN] sendAlert: held for replay");
+    if (result == OUTBOX_SPILLED) Serial.println("[WARN] sendAlert: spilled for replay");
+    if (result == OUTBOX_DROPPED) Serial.println("[ERR] sendAlert: dropped");
 #endif
-    return false;
+    return result;
 }
 
 // ===========================================================================
@@ -23,6 +23,8 @@
 #include <Adafruit_VEML7700.h>
 #include <Wire.h>
 
+#include "outbox.h"
+
 // Set to 1 for bench bring-up; 0 for deployment (Serial off, no Notecard debug stream).
 #ifndef ENABLE_DEBUG
 #define ENABLE_DEBUG 0
@@ -51,10 +53,6 @@
 // Notecard NotePayload segment identifier
 #define STATE_SEG_ID "STOR"
 
-// Capacity (including '\0') of the pending alert-type string.
-// "sensor_disagreement" is the longest type (19 chars); 24 provides headroom.
-#define PENDING_ALERT_TYPE_LEN 24
-
 // State magic + version guard. The high 16 bits (0xC5A0) are a fixed sentinel
 // (Cold Storage Audit); the low 16 bits are the schema version counter.
 // Increment the low 16 bits whenever any of the following change:
@@ -64,53 +62,7 @@
 //   • note.template schema (fields or types)
 // A mismatch on restore forces full re-initialisation, clearing
 // notecard_configured and templates_defined so the updated config is applied.
-#define STATE_MAGIC_VERSION 0xC5A00003UL
-
-// Capacity of the persisted pending-note ring buffers (readings and alerts).
-// 4 slots covers four consecutive Notecard-unreachable wakes before the oldest
-// unsent entry is overwritten. This is a deliberate design trade-off: the
-// dropped_readings / dropped_alerts counters embedded in every successfully
-// sent reading Note make any lost entries observable in Notehub. Increase
-// PENDING_RING_CAP if the deployment environment expects longer connectivity
-// gaps; the AppState struct (and therefore flash usage) grows proportionally.
-#define PENDING_RING_CAP 4
-
-// Bitmask flags for tracking which alert types have an undelivered entry in the
-// pending_alerts ring. Used to suppress duplicate stashing while a send-failed
-// alert of the same type is already queued for retry.
-#define ALERT_BIT_TEMP_HIGH 0x01u
-#define ALERT_BIT_TEMP_LOW 0x02u
-#define ALERT_BIT_DOOR_TIMEOUT 0x04u
-#define ALERT_BIT_SENSOR_DISAGREE 0x08u
-
-// ---------------------------------------------------------------------------
-// Pending-note element types
-// ---------------------------------------------------------------------------
-
-struct PendingReading
-{
-    float temp_c;
-    float lux;
-    bool door_open;
-    uint32_t door_open_sec;
-    bool time_valid;
-    uint32_t sample_epoch; // UTC epoch at sample time; 0 if time was not yet synced
-};
-
-// A pending alert preserves the original event epoch so a retried Note can
-// include it in the body for audit lineage. note.add has no timestamp-override
-// field, so the Notecard stamps a retried Note with retry time in the envelope;
-// event_epoch carries the authoritative original trigger time.
-struct PendingAlert
-{
-    char type[PENDING_ALERT_TYPE_LEN];
-    float temp_c;
-    float lux;
-    bool door_open;
-    uint32_t door_open_sec;
-    bool time_valid;
-    uint32_t epoch; // UTC epoch when the alert condition was first detected
-};
+#define STATE_MAGIC_VERSION 0xC5A00006UL
 
 // ---------------------------------------------------------------------------
 // Application state — serialised into Notecard flash across sleep cycles via
@@ -149,37 +101,17 @@ struct AppState
     bool notecard_configured;
     bool templates_defined;
 
-    // Cumulative note.add failure counters. Included in every successfully
-    // sent reading Note so losses are visible in Notehub; reset to 0 after
-    // each successful send.
+    // Cumulative lost-Note counters: Notes the outbox could neither send nor
+    // hold. Included in every reading Note so losses are visible in Notehub;
+    // reset to 0 once a reading carrying them is sent or held.
     uint32_t dropped_readings;
     uint32_t dropped_alerts;
 
-    // Pending reading ring buffer. FIFO: pending_read_head is the next slot to
-    // dequeue; pending_read_count is the number of valid entries (0..PENDING_RING_CAP).
-    // When the ring is full the oldest entry is overwritten and dropped_readings
-    // is incremented. Readings are buffered whenever a send fails or templates
-    // are not yet confirmed; retries only proceed once templates_defined = true.
-    PendingReading pending_reads[PENDING_RING_CAP];
-    uint8_t pending_read_head;
-    uint8_t pending_read_count;
-
-    // Pending alert ring buffer. Same FIFO semantics as the reading buffer.
-    // Each entry preserves the original event epoch for body-field audit lineage.
-    // Alert cooldown timestamps are NOT advanced on a failed send, so the alert
-    // remains eligible without waiting through a full cooldown window.
-    PendingAlert pending_alerts[PENDING_RING_CAP];
-    uint8_t pending_alert_head;
-    uint8_t pending_alert_count;
-
-    // Bitmask of ALERT_BIT_* flags. A set bit means at least one undelivered
-    // entry of that alert type is currently in pending_alerts. The mask is
-    // recomputed from scratch by scanning ring contents after every stash or
-    // dequeue operation — never updated with OR-only writes, which would leave
-    // stale bits when an entry is overwritten on ring-full or dequeued without
-    // being sent. Only entries actually present in the live ring contribute
-    // a set bit.
-    uint8_t pending_alert_type_mask;
+    // Readings and alerts whose note.add failed wait in the outbox: the first
+    // few in its ring here, the rest in its .dbx spill on the Notecard. See
+    // outbox.h. Alert cooldowns advance once an alert is sent or held, so a
+    // held alert is never raised a second time while it waits.
+    Outbox outbox;
 };
 
 // ---------------------------------------------------------------------------
@@ -202,22 +134,22 @@ float readLightLux();
 bool readDoorOpen();
 uint32_t getEpochTime();
 
-// Both return true when the Note was successfully enqueued by the Notecard,
-// false when all retry attempts were exhausted.
+// Both send through the outbox (see outbox.h) and return whether the Note was
+// sent, held for replay, or dropped.
 //
-// sendReading: on false, push the payload (including sample_epoch) into the
-//   pending reading ring buffer (pending_reads) for retry at the start of
-//   the next wake.
-// sendAlert:   on false, the caller must NOT advance the cooldown timestamp
-//   (so the alert remains eligible for retry without waiting a full window)
-//   and should push the payload into the pending alert ring buffer.
+// sendReading: when hold_only is true (template not yet confirmed) the
+//   reading is held without a send attempt and replayed once the template
+//   exists. sample_epoch is the UTC epoch at sample time.
+// sendAlert:   on OUTBOX_DROPPED the caller must NOT advance the cooldown
+//   timestamp, so the alert remains eligible on the next wake.
 //   event_epoch is the UTC epoch when the alert condition was first detected;
 //   it is always included as a body field so audit lineage is preserved even
-//   when the Note is retried and stamped with retry time in the envelope.
-bool sendReading(float temp_c, float lux, bool door_open,
-                 uint32_t door_open_sec, bool time_valid, uint32_t sample_epoch);
-bool sendAlert(const char *alert_type, float temp_c, float lux,
-               bool door_open, uint32_t door_open_sec, bool time_valid,
-               uint32_t event_epoch);
+//   when the Note is replayed and stamped with replay time in the envelope.
+OutboxResult sendReading(float temp_c, float lux, bool door_open,
+                         uint32_t door_open_sec, bool time_valid,
+                         uint32_t sample_epoch, bool hold_only);
+OutboxResult sendAlert(const char *alert_type, float temp_c, float lux,
+                       bool door_open, uint32_t door_open_sec, bool time_valid,
+                       uint32_t event_epoch);
 
 void goToSleep();
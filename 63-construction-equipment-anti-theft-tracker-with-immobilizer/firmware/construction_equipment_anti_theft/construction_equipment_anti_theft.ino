@@ -6,7 +6,8 @@
 //
 // Features:
 //   - Periodic GPS heartbeat (cadence adapts to motion and time-of-day)
-//   - Geofence breach alert: equipment outside configured job-site boundary
+//   - Geofence breach alert: equipment outside every configured job-site fence
+//     (polygons and circles synced incrementally from fence.db)
 //   - After-hours motion alert: vibration/movement at night, engine confirmed off
 //   - Inbound immobilize command delivered via Notehub (immobilize.qi)
 //   - Relay assertion on next key-on when immobilize command is staged
@@ -64,6 +65,10 @@
 // ─── Globals ─────────────────────────────────────────────────────────────────
 Notecard notecard;
 AppState g_state;
+GeoStore g_geo;
+// True once g_geo holds a complete copy of fence.db — restored from the sleep
+// payload or rebuilt by a full sync.  Until then fences are not evaluated.
+static bool g_geo_ready = false;
 
 // Forward declaration
 static void runCycle();
@@ -131,6 +136,15 @@ void setup()
     if (restored) {
         restored &= NotePayloadGetSegment(&payload, kStateSegID,
                                           &g_state, sizeof(g_state));
+        // The fence store travels in its own variable-length segment holding
+        // only the fences in use.  A missing or corrupt image just means a full
+        // fence.db resync on this wake.
+        uint8_t *img     = NULL;
+        uint32_t img_len = 0;
+        g_geo_ready = restored &&
+                      NotePayloadFindSegment(&payload, kGeoSegID, &img, &img_len) &&
+                      img_len <= GEO_IMAGE_MAX &&
+                      geoDecode(&g_geo, img, (uint16_t)img_len);
         NotePayloadFree(&payload);
     }
     if (!restored) {
@@ -203,6 +217,23 @@ static void runCycle()
               "retrying failed steps next wake.");
     }
 
+    // ── Sync job-site fences (delta-only via note.changes tracker) ────────────
+    // Runs before the env-var block so an env-driven home fence update below
+    // lands on top of a freshly rebuilt store.
+    if (syncFences(notecard, g_geo, !g_geo_ready)) {
+        g_geo_ready = true;
+        if (g_geo.dirty) {
+            g_geo.dirty = false;
+            LOG("[APP] Fence store updated — ");
+            LOG(g_geo.count);
+            LOG(" fences, ");
+            LOG(g_geo.nverts);
+            LOGLN(" polygon vertices.");
+        }
+    } else {
+        LOGLN("[APP] WARN: fence.db sync failed — retrying next wake.");
+    }
+
     // ── Pull updated env vars on every wake (delta-only via env.get `time`) ──
     // When Notehub has new values, also reissue hub.set so the Notecard's
     // internal outbound/inbound session windows reflect the updated cadence.
@@ -219,6 +250,7 @@ static void runCycle()
                 LOGLN("[APP] ERROR: fence persistence failed after env update — "
                       "coordinates are in RAM only until next successful write.");
             }
+            storeHomeFence(g_geo, g_state);
         }
         LOGLN("[APP] Env vars updated — hub cadence reapplied.");
     }
@@ -367,10 +399,14 @@ static void runCycle()
     // error, blocking auto-anchor across all subsequent ATTN wakes until a clean
     // cold-boot re-read succeeds — this prevents a transient I2C failure from
     // silently re-homing the fence to a thief's current location.
-    if (!g_state.fence_set && g_state.fence_confirmed_absent && got_fix) {
+    // Job-site fences synced from fence.db take the home fence's place, so the
+    // anchor is also skipped once any fence is known.
+    if (!g_state.fence_set && g_state.fence_confirmed_absent && got_fix &&
+        g_geo_ready && g_geo.count == 0) {
         g_state.fence_lat = cur_lat;
         g_state.fence_lon = cur_lon;
         g_state.fence_set = true;
+        storeHomeFence(g_geo, g_state);
         if (saveFenceToFlash(notecard, g_state)) {
             LOGLN("[APP] Home geofence anchored at first GPS fix — saved to flash.");
         } else {
@@ -379,16 +415,23 @@ static void runCycle()
         }
     }
 
-    // Geofence evaluation.
-    // fence_ok: -1 = unknown (no valid GPS fix or fence not yet anchored),
+    // Geofence evaluation against every fence in the store; in-fence means
+    // inside any one of them.
+    // fence_ok: -1 = unknown (no valid GPS fix, no fences, or fence store not
+    //                yet synced),
     //            0 = geofence breach, 1 = in-fence.
     // Defaulting to -1 prevents a GNSS outage (antenna fault, indoor storage)
-    // from being silently reported as "in-fence" in tracker.qo and masking theft.
+    // from being silently reported as "in-fence" in tracker.qo and masking theft,
+    // and a half-synced store from raising a false breach.
     int8_t fence_ok = -1;
-    if (got_fix && g_state.fence_set) {
-        float dist = haversineDistanceM(g_state.fence_lat, g_state.fence_lon,
-                                        cur_lat, cur_lon);
-        fence_ok = (dist <= g_state.fence_radius_m) ? 1 : 0;
+    if (got_fix && g_geo_ready && g_geo.count > 0) {
+        int site = geoFind(&g_geo, geoE7(cur_lat), geoE7(cur_lon));
+        fence_ok = (site >= 0) ? 1 : 0;
+        if (site >= 0) {
+            LOG("[APP] In fence '");
+            LOG(g_geo.fence[site].name);
+            LOGLN("'.");
+        }
         // alertDue() allows the first-ever breach alert even before a valid epoch
         // is available (last_geofence_alert_s == 0). Subsequent alerts require
         // cooldown_s to elapse using eff_time (epoch with fix_time as fallback).
@@ -485,6 +528,14 @@ static void runCycle()
         LOGLN("[APP] ERROR: NotePayloadAddSegment failed — "
               "state will not persist across sleep.");
     }
+    // An incomplete store is not saved, so the next wake rebuilds it in full.
+    static uint8_t geo_image[GEO_IMAGE_MAX];
+    if (g_geo_ready) {
+        uint16_t geo_len = geoEncode(&g_geo, geo_image);
+        if (!NotePayloadAddSegment(&save, kGeoSegID, geo_image, geo_len)) {
+            LOGLN("[APP] WARN: fence store not saved — full fence.db resync next wake.");
+        }
+    }
     // Retry NotePayloadSaveAndSleep once on transient Notecard-side failure before
     // falling through to the bench-mode delay below.
     bool slept = false;
@@ -15,6 +15,7 @@
 #include <math.h>
 
 const char kStateSegID[] = "APP";
+const char kGeoSegID[]   = "GEO";
 
 // ─── Internal helper: checked request/response ────────────────────────────────
 // Sends a request via requestAndResponse() and validates both the I/O result
@@ -651,18 +652,6 @@ bool isAfterHours(uint32_t epoch, int8_t start_h, int8_t end_h)
     return (hour >= start_h && hour < end_h);
 }
 
-// ─── Haversine great-circle distance (meters) ────────────────────────────────
-float haversineDistanceM(double lat1, double lon1, double lat2, double lon2)
-{
-    const double R = 6371000.0;
-    double dLat = (lat2 - lat1) * M_PI / 180.0;
-    double dLon = (lon2 - lon1) * M_PI / 180.0;
-    double a = sin(dLat / 2) * sin(dLat / 2)
-             + cos(lat1 * M_PI / 180.0) * cos(lat2 * M_PI / 180.0)
-             * sin(dLon / 2) * sin(dLon / 2);
-    return (float)(R * 2.0 * atan2(sqrt(a), sqrt(1.0 - a)));
-}
-
 // ─── Geofence flash persistence ───────────────────────────────────────────────
 // Writes the commissioned fence center and radius to a named note in fence.db so
 // the coordinates survive a full power loss.  On the next cold boot, the firmware
@@ -679,7 +668,7 @@ bool saveFenceToFlash(Notecard &nc, const AppState &s)
     for (int attempt = 0; attempt < kMaxAttempts; attempt++) {
         J *req = nc.newRequest("note.update");
         JAddStringToObject(req, "file", FENCE_NOTEFILE);
-        JAddStringToObject(req, "note", "home");
+        JAddStringToObject(req, "note", FENCE_HOME_NOTE);
         J *body = JAddObjectToObject(req, "body");
         JAddNumberToObject(body, "lat",    s.fence_lat);
         JAddNumberToObject(body, "lon",    s.fence_lon);
@@ -717,7 +706,7 @@ bool loadFenceFromFlash(Notecard &nc, AppState &s, bool &io_error)
     for (int attempt = 0; attempt < kMaxAttempts; attempt++) {
         J *req = nc.newRequest("note.get");
         JAddStringToObject(req, "file", FENCE_NOTEFILE);
-        JAddStringToObject(req, "note", "home");
+        JAddStringToObject(req, "note", FENCE_HOME_NOTE);
         J *rsp = nc.requestAndResponse(req);
 
         if (rsp == NULL) {
@@ -796,6 +785,114 @@ bool loadFenceFromFlash(Notecard &nc, AppState &s, bool &io_error)
     return false;
 }
 
+// Mirrors the AppState home circle into the fence store under the same name
+// saveFenceToFlash() uses, so the later fence.db sync finds it unchanged.
+bool storeHomeFence(GeoStore &g, const AppState &s)
+{
+    if (!s.fence_set) return true;
+    GeoResult r = geoStoreCircle(&g, FENCE_HOME_NOTE,
+                                 geoE7(s.fence_lat), geoE7(s.fence_lon),
+                                 (uint32_t)lroundf(s.fence_radius_m));
+    if (r == GEO_INVALID || r == GEO_FULL) {
+        LOGLN("[APP] WARN: home fence not stored — radius out of range or fence store full.");
+        return false;
+    }
+    return true;
+}
+
+// ─── Fence store sync ─────────────────────────────────────────────────────────
+// Each fence.db Note is one fence; its Note ID is the fence name (first 15
+// characters).  Body is either
+//   {"points":[[lat,lon],[lat,lon],...]}   polygon, 3–64 vertices, decimal degrees
+//   {"lat":..,"lon":..,"radius":..}         circle, radius in meters (the "home" shape)
+// Operators add, edit and delete job-site Notes from the Notehub API; they reach
+// the Notecard on the next inbound sync.
+//
+// note.changes with a tracker returns only Notes changed since the previous
+// call, deletions included, so a wake with no fence edits costs one small
+// request instead of re-reading every polygon.  A malformed fence is logged and
+// skipped; it is picked up again if the Note is edited.
+static GeoResult applyFenceNote(GeoStore &g, const char *id, J *note)
+{
+    if (JGetBool(note, "deleted")) {
+        geoErase(&g, id);
+        return GEO_STORED;
+    }
+    J *body = JGetObject(note, "body");
+    if (body == NULL) return GEO_INVALID;
+
+    J *pts = JGetArray(body, "points");
+    if (pts != NULL) {
+        // One extra slot so a ring closed on its first vertex still fits.
+        int32_t lat[GEO_MAX_POLY_VERTS + 1];
+        int32_t lon[GEO_MAX_POLY_VERTS + 1];
+        int n = 0;
+        for (J *pt = pts->child; pt != NULL; pt = pt->next) {
+            J *a = pt->child;
+            J *b = (a != NULL) ? a->next : NULL;
+            if (n > GEO_MAX_POLY_VERTS || b == NULL || !JIsNumber(a) || !JIsNumber(b)) {
+                return GEO_INVALID;
+            }
+            lat[n] = geoE7(JNumberValue(a));
+            lon[n] = geoE7(JNumberValue(b));
+            n++;
+        }
+        return geoStorePolygon(&g, id, lat, lon, (uint8_t)n);
+    }
+    if (JIsPresent(body, "radius")) {
+        double lat = JGetNumber(body, "lat");
+        double lon = JGetNumber(body, "lon");
+        double r   = JGetNumber(body, "radius");
+        // 0,0 is treated as corrupt, as in loadFenceFromFlash().
+        if ((lat == 0.0 && lon == 0.0) || r < 1.0) return GEO_INVALID;
+        return geoStoreCircle(&g, id, geoE7(lat), geoE7(lon), (uint32_t)lround(r));
+    }
+    return GEO_INVALID;
+}
+
+bool syncFences(Notecard &nc, GeoStore &g, bool full)
+{
+    if (full) geoInit(&g);
+    // Bounded so a file full of changes cannot hold the host awake; whatever
+    // remains is read on the next wake.
+    const int kMaxRequests = GEO_MAX_FENCES / GEO_SYNC_BATCH + 2;
+    for (int r = 0; r < kMaxRequests; r++) {
+        J *req = nc.newRequest("note.changes");
+        JAddStringToObject(req, "file",    FENCE_NOTEFILE);
+        JAddStringToObject(req, "tracker", GEO_SYNC_TRACKER);
+        JAddNumberToObject(req, "max",     GEO_SYNC_BATCH);
+        JAddBoolToObject(req, "deleted", true);
+        if (full && r == 0) JAddBoolToObject(req, "start", true);
+        J *rsp = nc.requestAndResponse(req);
+        if (rsp == NULL) return false;
+        if (JGetObjectItem(rsp, "err")) {
+            // fence.db does not exist until a fence is first saved: an empty store.
+            const char *err_str = JGetString(rsp, "err");
+            bool absent = (err_str != NULL &&
+                           (strstr(err_str, "does not exist") != NULL ||
+                            strstr(err_str, "not found")      != NULL));
+            if (!absent && err_str) { LOG("[APP] WARN: fence.db sync: "); LOGLN(err_str); }
+            nc.deleteResponse(rsp);
+            return absent;
+        }
+        int n = 0;
+        J *notes = JGetObject(rsp, "notes");
+        for (J *note = notes ? notes->child : NULL; note != NULL; note = note->next, n++) {
+            const char *id = note->string ? note->string : "";
+            GeoResult res = applyFenceNote(g, id, note);
+            if (res == GEO_INVALID || res == GEO_FULL) {
+                LOG("[APP] WARN: fence '");
+                LOG(id);
+                LOGLN(res == GEO_FULL ? "' skipped — fence store full."
+                                      : "' rejected — malformed or out of range.");
+            }
+        }
+        nc.deleteResponse(rsp);
+        if (n < GEO_SYNC_BATCH) break;
+    }
+    return true;
+}
+
 // ─── Periodic heartbeat ───────────────────────────────────────────────────────
 bool sendHeartbeat(Notecard &nc, const AppState &s,
                    double lat, double lon, bool loc_valid,
@@ -13,6 +13,7 @@
 
 #pragma once
 #include <Notecard.h>
+#include "geofence_store.h"
 
 // ─── Debug serial ────────────────────────────────────────────────────────────
 // Define DEBUG_SERIAL as 1 before including this header (or via compiler -D
@@ -82,7 +83,15 @@ static inline bool alertDue(uint32_t eff_time, uint32_t last_ts, uint32_t cooldo
 // fence.db persists the commissioned home-fence coordinates in Notecard flash.
 // This is independent of the NotePayload sleep state so a power-loss/reconnect
 // during a theft event cannot silently re-home the fence to the thief's location.
+// The same file carries the job-site fences operators add from Notehub: one Note
+// per fence, keyed by fence name.  Every Note in it, "home" included, is a
+// permitted area; the equipment is in-fence when inside any of them.
 #define FENCE_NOTEFILE     "fence.db"
+#define FENCE_HOME_NOTE    "home"
+// note.changes tracker for fence.db, so each wake reads only fences that were
+// added, edited or deleted since the last sync, GEO_SYNC_BATCH Notes per request.
+#define GEO_SYNC_TRACKER   "geo"
+#define GEO_SYNC_BATCH     8
 
 // Compact template port numbers — required for Notecard for Skylo satellite path.
 #define TRACKER_PORT   50
@@ -164,6 +173,7 @@ struct AppState {
 };
 
 extern const char kStateSegID[];
+extern const char kGeoSegID[];     // NotePayload segment carrying the GeoStore image
 
 // ─── Function declarations ────────────────────────────────────────────────────
 // Notecard configuration and note emission
@@ -252,6 +262,16 @@ bool saveFenceToFlash(Notecard &nc, const AppState &s);
 //                      Caller must NOT allow GPS auto-anchor — see AppState::fence_confirmed_absent.
 // Retries up to 3 times on transport failures before returning with io_error == true.
 bool loadFenceFromFlash(Notecard &nc, AppState &s, bool &io_error);
+// storeHomeFence mirrors the AppState home circle into the fence store so an
+// env-var or auto-anchor change applies on this wake, before fence.db syncs
+// it back.  Returns false if the geometry is rejected (e.g. radius > 50 km).
+bool storeHomeFence(GeoStore &g, const AppState &s);
+// syncFences applies fence.db changes to the store via note.changes.  full
+// resets the tracker and rebuilds the store from every Note in the file — used
+// when no store image survived sleep.  Returns false on a Notecard error;
+// after a failed full sync the store is incomplete and must not be used for
+// breach decisions until a later sync succeeds.
+bool syncFences(Notecard &nc, GeoStore &g, bool full);
 
 // Sensor reads (all return safe defaults on Notecard error)
 // last_state: the ignition state persisted from the previous wake (g_state.last_ignition_on).
@@ -271,7 +291,6 @@ uint32_t getEpochTime(Notecard &nc);
 
 // Utility
 bool  isAfterHours(uint32_t epoch, int8_t start_h, int8_t end_h);
-float haversineDistanceM(double lat1, double lon1, double lat2, double lon2);
 
 // Relay
 void assertRelay();
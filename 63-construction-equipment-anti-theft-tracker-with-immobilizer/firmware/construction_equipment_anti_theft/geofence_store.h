@@ -0,0 +1,492 @@
+/***************************************************************************
+  geofence_store.h
+
+  Multi-fence geofence store: dozens of job-site polygons and circles, each
+  keyed by the name of the .db Note it was synced from, checked against a
+  GNSS fix without any per-check trigonometry.
+
+  Each fence is stored in its own local frame: an origin in 1e-7 degrees
+  (the circle centre, or the polygon's first vertex) and, for polygons,
+  vertices as whole metres east/north of that origin.  A check first
+  rejects every fence whose bounding box (also in 1e-7 degrees) misses the
+  fix, which is integer compares only; a fence that survives gets the fix
+  projected into its frame with one multiply per axis (the cosine is
+  computed once, when the fence is stored) and a crossing-number
+  point-in-polygon test.  Over a job site the projection is accurate to
+  well under a metre, below the vertex rounding and GNSS error.
+
+  Limits: fences must lie between 85 degrees S and N, must not span the
+  antimeridian, and a polygon must fit within GEO_MAX_EXTENT_M of its first
+  vertex.  Names longer than GEO_NAME_LEN - 1 characters are truncated.
+
+  The store serializes to a compact CRC-checked image holding only the
+  fences in use, so the firmware can carry it across sleep; bounding boxes,
+  cosines and areas are rebuilt on load.
+
+  Pure arithmetic with no Notecard or Arduino dependencies, so the host
+  benchmark in sim/ exercises exactly this code.  All functions are
+  static inline.
+***************************************************************************/
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+// ─── Capacity ─────────────────────────────────────────────────────────────────
+// Polygon vertices share one pool, so a store can hold many small sites or a
+// few detailed ones.  RAM is about 56 bytes per fence plus 4 per vertex.
+#ifndef GEO_MAX_FENCES
+#define GEO_MAX_FENCES      32
+#endif
+#ifndef GEO_MAX_VERTICES
+#define GEO_MAX_VERTICES   384
+#endif
+#define GEO_MAX_POLY_VERTS  64      // per polygon
+#define GEO_NAME_LEN        16      // including the terminating NUL
+#define GEO_MAX_EXTENT_M    30000   // vertex offsets are int16 metres
+#define GEO_MAX_RADIUS_M    50000
+#define GEO_MAX_LAT_E7      850000000L
+
+#if GEO_MAX_FENCES > 255
+#error "GEO_MAX_FENCES must fit in a uint8_t"
+#endif
+
+#define GEO_CIRCLE   1
+#define GEO_POLYGON  2
+
+// Metres per 1e-7 degree of latitude (mean Earth radius 6 371 km).
+#define GEO_M_PER_E7     0.0111194926f
+#define GEO_E7_TO_RAD    1.7453292519943295e-9f
+
+enum GeoResult {
+    GEO_STORED,       // fence added or replaced; store is dirty
+    GEO_UNCHANGED,    // identical fence already stored; store left clean
+    GEO_FULL,         // no room; any existing fence of that name is kept
+    GEO_INVALID       // malformed or out-of-range geometry
+};
+
+struct GeoVertex {
+    int16_t x;        // metres east of the fence origin
+    int16_t y;        // metres north of the fence origin
+};
+
+struct GeoFence {
+    char     name[GEO_NAME_LEN];
+    uint8_t  type;            // GEO_CIRCLE or GEO_POLYGON
+    uint8_t  nverts;          // polygon vertex count
+    uint16_t first;           // polygon's first vertex in GeoStore::vert
+    int32_t  lat0;            // origin, 1e-7 degrees
+    int32_t  lon0;
+    uint32_t radius_m;        // circle only
+    // Derived by geoPrepare(); not serialized.
+    int32_t  min_lat, max_lat, min_lon, max_lon;   // bounding box, 1e-7 degrees
+    float    kx;              // metres per 1e-7 degree of longitude at lat0
+    float    area_m2;
+};
+
+struct GeoStore {
+    uint8_t   count;
+    bool      dirty;          // changed since the last save
+    uint16_t  nverts;         // vertex pool in use
+    GeoFence  fence[GEO_MAX_FENCES];
+    GeoVertex vert[GEO_MAX_VERTICES];
+};
+
+static inline void geoInit(GeoStore *s)
+{
+    memset(s, 0, sizeof(*s));
+}
+
+static inline int32_t geoE7(double deg)
+{
+    return (int32_t)lround(deg * 1e7);
+}
+
+static inline int geoIndex(const GeoStore *s, const char *name)
+{
+    for (uint8_t i = 0; i < s->count; i++) {
+        if (strncmp(s->fence[i].name, name, GEO_NAME_LEN - 1) == 0) return i;
+    }
+    return -1;
+}
+
+// ─── Derived fields ───────────────────────────────────────────────────────────
+// Fills in the bounding box, longitude scale and area from the stored
+// geometry.  The box is rounded outward so it always contains the fence.
+static inline void geoPrepare(const GeoStore *s, GeoFence *f)
+{
+    f->kx = GEO_M_PER_E7 * cosf((float)f->lat0 * GEO_E7_TO_RAD);
+
+    float x0, x1, y0, y1;
+    if (f->type == GEO_CIRCLE) {
+        float r = (float)f->radius_m;
+        x0 = y0 = -r;
+        x1 = y1 = r;
+        f->area_m2 = 3.14159265f * r * r;
+    } else {
+        const GeoVertex *v = &s->vert[f->first];
+        x0 = x1 = v[0].x;
+        y0 = y1 = v[0].y;
+        float twice = 0.0f;
+        for (uint8_t i = 0, j = f->nverts - 1; i < f->nverts; j = i++) {
+            if (v[i].x < x0) x0 = v[i].x;
+            if (v[i].x > x1) x1 = v[i].x;
+            if (v[i].y < y0) y0 = v[i].y;
+            if (v[i].y > y1) y1 = v[i].y;
+            twice += (float)v[j].x * v[i].y - (float)v[i].x * v[j].y;
+        }
+        f->area_m2 = fabsf(twice) * 0.5f;
+    }
+    f->min_lat = f->lat0 + (int32_t)floorf(y0 / GEO_M_PER_E7) - 1;
+    f->max_lat = f->lat0 + (int32_t)ceilf(y1 / GEO_M_PER_E7) + 1;
+    f->min_lon = f->lon0 + (int32_t)floorf(x0 / f->kx) - 1;
+    f->max_lon = f->lon0 + (int32_t)ceilf(x1 / f->kx) + 1;
+}
+
+// ─── Point tests ──────────────────────────────────────────────────────────────
+static inline bool geoInBox(const GeoFence *f, int32_t lat, int32_t lon)
+{
+    return lat >= f->min_lat && lat <= f->max_lat &&
+           lon >= f->min_lon && lon <= f->max_lon;
+}
+
+// Projects a fix into the fence's frame.  Only call once the fix is known to
+// be near the fence (e.g. inside its box), so the deltas cannot overflow.
+static inline void geoLocal(const GeoFence *f, int32_t lat, int32_t lon,
+                            float *x, float *y)
+{
+    *x = (float)(lon - f->lon0) * f->kx;
+    *y = (float)(lat - f->lat0) * GEO_M_PER_E7;
+}
+
+// Exact containment test in the fence's frame, without the box pre-check.
+static inline bool geoTestLocal(const GeoStore *s, const GeoFence *f, float px, float py)
+{
+    if (f->type == GEO_CIRCLE) {
+        float r = (float)f->radius_m;
+        return px * px + py * py <= r * r;
+    }
+    const GeoVertex *v = &s->vert[f->first];
+    bool inside = false;
+    for (uint8_t i = 0, j = f->nverts - 1; i < f->nverts; j = i++) {
+        float yi = v[i].y, yj = v[j].y;
+        if ((yi > py) != (yj > py)) {
+            float xi = v[i].x, xj = v[j].x;
+            if (px < (xj - xi) * (py - yi) / (yj - yi) + xi) inside = !inside;
+        }
+    }
+    return inside;
+}
+
+static inline bool geoContains(const GeoStore *s, uint8_t idx, int32_t lat, int32_t lon)
+{
+    const GeoFence *f = &s->fence[idx];
+    if (!geoInBox(f, lat, lon)) return false;
+    float px, py;
+    geoLocal(f, lat, lon, &px, &py);
+    return geoTestLocal(s, f, px, py);
+}
+
+// Returns the fence containing the fix, or -1 when it is outside all of them.
+// Where fences overlap, the smallest wins, so a yard drawn inside a larger
+// site is reported as the yard.
+static inline int geoFind(const GeoStore *s, int32_t lat, int32_t lon)
+{
+    int   best = -1;
+    float best_area = 0.0f;
+    for (uint8_t i = 0; i < s->count; i++) {
+        const GeoFence *f = &s->fence[i];
+        if (!geoInBox(f, lat, lon)) continue;
+        if (best >= 0 && f->area_m2 >= best_area) continue;
+        float px, py;
+        geoLocal(f, lat, lon, &px, &py);
+        if (geoTestLocal(s, f, px, py)) {
+            best = i;
+            best_area = f->area_m2;
+        }
+    }
+    return best;
+}
+
+// True when the fix is inside the fence or within margin_m of its edge.
+// Used as exit hysteresis so GNSS jitter at a boundary does not flap.
+static inline bool geoNear(const GeoStore *s, uint8_t idx, int32_t lat, int32_t lon,
+                           float margin_m)
+{
+    const GeoFence *f = &s->fence[idx];
+    int32_t mlat = (int32_t)(margin_m / GEO_M_PER_E7) + 1;
+    int32_t mlon = (int32_t)(margin_m / f->kx) + 1;
+    if (lat < f->min_lat - mlat || lat > f->max_lat + mlat ||
+        lon < f->min_lon - mlon || lon > f->max_lon + mlon) {
+        return false;
+    }
+    float px, py;
+    geoLocal(f, lat, lon, &px, &py);
+    if (f->type == GEO_CIRCLE) {
+        float r = (float)f->radius_m + margin_m;
+        return px * px + py * py <= r * r;
+    }
+    if (geoTestLocal(s, f, px, py)) return true;
+    const GeoVertex *v = &s->vert[f->first];
+    float m2 = margin_m * margin_m;
+    for (uint8_t i = 0, j = f->nverts - 1; i < f->nverts; j = i++) {
+        float ax = v[j].x, ay = v[j].y;
+        float bx = (float)v[i].x - ax, by = (float)v[i].y - ay;
+        float qx = px - ax, qy = py - ay;
+        float len2 = bx * bx + by * by;
+        float t = (len2 > 0.0f) ? (qx * bx + qy * by) / len2 : 0.0f;
+        if (t < 0.0f) t = 0.0f;
+        if (t > 1.0f) t = 1.0f;
+        float dx = qx - t * bx, dy = qy - t * by;
+        if (dx * dx + dy * dy <= m2) return true;
+    }
+    return false;
+}
+
+// ─── Editing ──────────────────────────────────────────────────────────────────
+// Removes a fence and closes the gap it leaves in the vertex pool.
+static inline bool geoErase(GeoStore *s, const char *name)
+{
+    int idx = geoIndex(s, name);
+    if (idx < 0) return false;
+    GeoFence *f = &s->fence[idx];
+    if (f->type == GEO_POLYGON && f->nverts) {
+        uint16_t first = f->first, n = f->nverts;
+        memmove(&s->vert[first], &s->vert[first + n],
+                (size_t)(s->nverts - first - n) * sizeof(GeoVertex));
+        s->nverts = (uint16_t)(s->nverts - n);
+        for (uint8_t i = 0; i < s->count; i++) {
+            GeoFence *g = &s->fence[i];
+            if (g->type == GEO_POLYGON && g->first > first) g->first = (uint16_t)(g->first - n);
+        }
+    }
+    memmove(&s->fence[idx], &s->fence[idx + 1],
+            (size_t)(s->count - idx - 1) * sizeof(GeoFence));
+    s->count--;
+    memset(&s->fence[s->count], 0, sizeof(GeoFence));
+    s->dirty = true;
+    return true;
+}
+
+static inline bool geoValidOrigin(int32_t lat, int32_t lon)
+{
+    return lat >= -GEO_MAX_LAT_E7 && lat <= GEO_MAX_LAT_E7 &&
+           lon >= -1800000000L && lon <= 1800000000L;
+}
+
+static inline void geoSetName(GeoFence *f, const char *name)
+{
+    memset(f->name, 0, GEO_NAME_LEN);
+    for (uint8_t i = 0; i < GEO_NAME_LEN - 1 && name[i]; i++) f->name[i] = name[i];
+}
+
+static inline GeoResult geoStoreCircle(GeoStore *s, const char *name,
+                                       int32_t lat, int32_t lon, uint32_t radius_m)
+{
+    if (!geoValidOrigin(lat, lon) || radius_m == 0 || radius_m > GEO_MAX_RADIUS_M) {
+        return GEO_INVALID;
+    }
+    int idx = geoIndex(s, name);
+    if (idx >= 0) {
+        const GeoFence *f = &s->fence[idx];
+        if (f->type == GEO_CIRCLE && f->lat0 == lat && f->lon0 == lon &&
+            f->radius_m == radius_m) {
+            return GEO_UNCHANGED;
+        }
+        geoErase(s, name);
+    } else if (s->count >= GEO_MAX_FENCES) {
+        return GEO_FULL;
+    }
+    GeoFence *f = &s->fence[s->count++];
+    memset(f, 0, sizeof(*f));
+    geoSetName(f, name);
+    f->type     = GEO_CIRCLE;
+    f->lat0     = lat;
+    f->lon0     = lon;
+    f->radius_m = radius_m;
+    geoPrepare(s, f);
+    s->dirty = true;
+    return GEO_STORED;
+}
+
+// Stores a polygon given as n vertices in 1e-7 degrees.  A closing vertex
+// equal to the first, and consecutive duplicates, are dropped.
+static inline GeoResult geoStorePolygon(GeoStore *s, const char *name,
+                                        const int32_t *lat, const int32_t *lon, uint8_t n)
+{
+    if (n < 3 || !geoValidOrigin(lat[0], lon[0])) return GEO_INVALID;
+
+    GeoFence  tmp;
+    GeoVertex v[GEO_MAX_POLY_VERTS];
+    memset(&tmp, 0, sizeof(tmp));
+    tmp.lat0 = lat[0];
+    tmp.lon0 = lon[0];
+    float kx = GEO_M_PER_E7 * cosf((float)lat[0] * GEO_E7_TO_RAD);
+    uint8_t m = 0;
+    for (uint8_t i = 0; i < n; i++) {
+        if (!geoValidOrigin(lat[i], lon[i])) return GEO_INVALID;
+        // Difference in double: lon - lon0 can exceed int32 for a bad input.
+        double dx = ((double)lon[i] - lon[0]) * kx;
+        double dy = ((double)lat[i] - lat[0]) * GEO_M_PER_E7;
+        if (fabs(dx) > GEO_MAX_EXTENT_M || fabs(dy) > GEO_MAX_EXTENT_M) return GEO_INVALID;
+        GeoVertex p = { (int16_t)lround(dx), (int16_t)lround(dy) };
+        if (m && p.x == v[m - 1].x && p.y == v[m - 1].y) continue;
+        if (m >= GEO_MAX_POLY_VERTS) return GEO_INVALID;
+        v[m++] = p;
+    }
+    while (m > 1 && v[m - 1].x == v[0].x && v[m - 1].y == v[0].y) m--;
+    if (m < 3) return GEO_INVALID;
+
+    int idx = geoIndex(s, name);
+    uint16_t freed = 0;
+    if (idx >= 0) {
+        const GeoFence *f = &s->fence[idx];
+        if (f->type == GEO_POLYGON) {
+            if (f->lat0 == tmp.lat0 && f->lon0 == tmp.lon0 && f->nverts == m &&
+                memcmp(&s->vert[f->first], v, m * sizeof(GeoVertex)) == 0) {
+                return GEO_UNCHANGED;
+            }
+            freed = f->nverts;
+        }
+    } else if (s->count >= GEO_MAX_FENCES) {
+        return GEO_FULL;
+    }
+    if ((uint32_t)s->nverts - freed + m > GEO_MAX_VERTICES) return GEO_FULL;
+    if (idx >= 0) geoErase(s, name);
+
+    GeoFence *f = &s->fence[s->count++];
+    *f = tmp;
+    geoSetName(f, name);
+    f->type   = GEO_POLYGON;
+    f->nverts = m;
+    f->first  = s->nverts;
+    memcpy(&s->vert[s->nverts], v, m * sizeof(GeoVertex));
+    s->nverts = (uint16_t)(s->nverts + m);
+    geoPrepare(s, f);
+    s->dirty = true;
+    return GEO_STORED;
+}
+
+// ─── Serialization ────────────────────────────────────────────────────────────
+// Image, little-endian:
+//   u16 magic  u8 version  u8 fence count
+//   per fence: name[16]  u8 type  u8 nverts  i32 lat0  i32 lon0
+//              then u32 radius (circle) or nverts x { i16 x, i16 y } (polygon)
+//   u16 CRC-16/CCITT-FALSE over everything before it
+#define GEO_IMAGE_MAGIC     0x4647u   // "GF"
+#define GEO_IMAGE_VERSION   1
+#define GEO_FENCE_HDR_LEN   (GEO_NAME_LEN + 10)
+#define GEO_IMAGE_MAX       (4 + GEO_MAX_FENCES * (GEO_FENCE_HDR_LEN + 4) + GEO_MAX_VERTICES * 4 + 2)
+
+static inline uint16_t geoCrc(const uint8_t *p, uint16_t len)
+{
+    uint16_t crc = 0xFFFF;
+    while (len--) {
+        crc ^= (uint16_t)(*p++) << 8;
+        for (uint8_t b = 0; b < 8; b++) {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+static inline void geoPut16(uint8_t *p, uint16_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static inline uint16_t geoGet16(const uint8_t *p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static inline void geoPut32(uint8_t *p, uint32_t v)
+{
+    geoPut16(p, (uint16_t)v);
+    geoPut16(p + 2, (uint16_t)(v >> 16));
+}
+
+static inline uint32_t geoGet32(const uint8_t *p)
+{
+    return (uint32_t)geoGet16(p) | ((uint32_t)geoGet16(p + 2) << 16);
+}
+
+// Returns the image length, at most GEO_IMAGE_MAX.
+static inline uint16_t geoEncode(const GeoStore *s, uint8_t *out)
+{
+    geoPut16(out, GEO_IMAGE_MAGIC);
+    out[2] = GEO_IMAGE_VERSION;
+    out[3] = s->count;
+    uint8_t *p = out + 4;
+    for (uint8_t i = 0; i < s->count; i++) {
+        const GeoFence *f = &s->fence[i];
+        memcpy(p, f->name, GEO_NAME_LEN);
+        p[GEO_NAME_LEN]     = f->type;
+        p[GEO_NAME_LEN + 1] = f->nverts;
+        geoPut32(p + GEO_NAME_LEN + 2, (uint32_t)f->lat0);
+        geoPut32(p + GEO_NAME_LEN + 6, (uint32_t)f->lon0);
+        p += GEO_FENCE_HDR_LEN;
+        if (f->type == GEO_CIRCLE) {
+            geoPut32(p, f->radius_m);
+            p += 4;
+        } else {
+            const GeoVertex *v = &s->vert[f->first];
+            for (uint8_t k = 0; k < f->nverts; k++, p += 4) {
+                geoPut16(p,     (uint16_t)v[k].x);
+                geoPut16(p + 2, (uint16_t)v[k].y);
+            }
+        }
+    }
+    geoPut16(p, geoCrc(out, (uint16_t)(p - out)));
+    return (uint16_t)(p - out + 2);
+}
+
+// Loads an image written by geoEncode().  Returns false, leaving the store
+// empty, for a truncated, corrupt or other-version image.
+static inline bool geoDecode(GeoStore *s, const uint8_t *in, uint16_t len)
+{
+    geoInit(s);
+    if (len < 6 || geoGet16(in) != GEO_IMAGE_MAGIC || in[2] != GEO_IMAGE_VERSION ||
+        in[3] > GEO_MAX_FENCES || geoGet16(in + len - 2) != geoCrc(in, (uint16_t)(len - 2))) {
+        return false;
+    }
+    const uint8_t *p   = in + 4;
+    const uint8_t *end = in + len - 2;
+    for (uint8_t i = 0; i < in[3]; i++) {
+        if (end - p < GEO_FENCE_HDR_LEN) break;
+        GeoFence *f = &s->fence[i];
+        memcpy(f->name, p, GEO_NAME_LEN);
+        f->name[GEO_NAME_LEN - 1] = '\0';
+        f->type   = p[GEO_NAME_LEN];
+        f->nverts = p[GEO_NAME_LEN + 1];
+        f->lat0   = (int32_t)geoGet32(p + GEO_NAME_LEN + 2);
+        f->lon0   = (int32_t)geoGet32(p + GEO_NAME_LEN + 6);
+        p += GEO_FENCE_HDR_LEN;
+        if (f->type == GEO_CIRCLE) {
+            if (end - p < 4) break;
+            f->radius_m = geoGet32(p);
+            f->nverts   = 0;
+            p += 4;
+        } else if (f->type == GEO_POLYGON && f->nverts >= 3 &&
+                   end - p >= f->nverts * 4 &&
+                   s->nverts + f->nverts <= GEO_MAX_VERTICES) {
+            f->first = s->nverts;
+            for (uint8_t k = 0; k < f->nverts; k++, p += 4) {
+                s->vert[s->nverts].x   = (int16_t)geoGet16(p);
+                s->vert[s->nverts++].y = (int16_t)geoGet16(p + 2);
+            }
+        } else {
+            break;
+        }
+        geoPrepare(s, f);
+        s->count++;
+    }
+    if (p != end || s->count != in[3]) {
+        geoInit(s);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,442 @@
+// geofence_bench.cpp — host benchmark for the multi-fence geofence store.
+//
+// Builds a contractor's fence set the way fence.db would deliver it: irregular
+// job-site polygons and a few circles (the "home" shape) scattered across a
+// metro area, then times three ways of answering "is this fix inside any
+// fence?" for a stream of fixes, half near a site and half anywhere:
+//   haversine — the original approach, one great-circle distance per fence
+//               (each site reduced to its circumscribed circle)
+//   projected — geoFind()'s local-frame tests on every fence, no pre-filter
+//   geoFind   — bounding-box pre-filter, then the local-frame test
+// and reports checks per second at 8 and 32 fences.  Host speed does not
+// carry over to the Cygnet; the ratios do.
+//
+// It also reports the store's footprint: RAM, and the serialized image that
+// rides in the NotePayload across each sleep, next to the fence.db JSON it
+// replaces re-reading.
+//
+// Correctness checks, exit 1 on failure: geoFind() agrees with a double-
+// precision reference on the unrounded polygons except within a few metres
+// of an edge; the image round-trips and rejects corruption; re-storing an
+// identical fence leaves the store clean; erasing a fence compacts the
+// vertex pool without disturbing the others; a full store keeps the old
+// fence; geoNear() honours its margin.
+//
+// Build and run from this directory:
+//   g++ -O2 -std=c++11 -I../firmware/construction_equipment_anti_theft geofence_bench.cpp -o geofence_bench
+//   ./geofence_bench
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <vector>
+
+#include "geofence_store.h"
+
+// ─── Scenario ────────────────────────────────────────────────────────────────
+static const double CENTER_LAT   = 39.74;      // a metro area, 80 km across
+static const double CENTER_LON   = -104.99;
+static const double REGION_KM    = 80.0;
+static const unsigned N_QUERIES  = 200000;
+static const unsigned N_REPEATS  = 10;         // timing passes over the queries
+static const double EDGE_TOL_M   = 3.0;        // vertex rounding + projection
+
+static const double R_EARTH = 6371000.0;
+static const double DEG     = M_PI / 180.0;
+
+struct SrcFence {
+    char   name[GEO_NAME_LEN];
+    bool   circle;
+    double lat, lon, radius_m;          // circle, or polygon centroid + max radius
+    std::vector<double> plat, plon;     // polygon vertices, degrees
+};
+
+static unsigned g_seed = 12345;
+static double frand()
+{
+    g_seed = g_seed * 1103515245u + 12345u;
+    return (double)((g_seed >> 8) & 0xFFFFFF) / 16777216.0;
+}
+
+static double metresToLat(double m)              { return m / (R_EARTH * DEG); }
+static double metresToLon(double m, double lat)  { return m / (R_EARTH * DEG * cos(lat * DEG)); }
+
+// An irregular star-shaped polygon: a site boundary following property lines.
+static SrcFence makePolygon(unsigned id)
+{
+    SrcFence f;
+    snprintf(f.name, sizeof(f.name), "site-%02u", id);
+    f.circle   = false;
+    f.lat      = CENTER_LAT + metresToLat((frand() - 0.5) * REGION_KM * 1000.0);
+    f.lon      = CENTER_LON + metresToLon((frand() - 0.5) * REGION_KM * 1000.0, CENTER_LAT);
+    double r   = 150.0 + frand() * 1350.0;
+    unsigned n = 5 + (unsigned)(frand() * 16.0);      // 5..20 vertices
+    f.radius_m = 0.0;
+    for (unsigned k = 0; k < n; k++) {
+        double a  = 2.0 * M_PI * (k + 0.3 * frand()) / n;
+        double rr = r * (0.55 + 0.45 * frand());
+        f.plat.push_back(f.lat + metresToLat(rr * sin(a)));
+        f.plon.push_back(f.lon + metresToLon(rr * cos(a), f.lat));
+        if (rr > f.radius_m) f.radius_m = rr;
+    }
+    return f;
+}
+
+static SrcFence makeCircle(unsigned id)
+{
+    SrcFence f;
+    snprintf(f.name, sizeof(f.name), id ? "yard-%02u" : "home", id);
+    f.circle   = true;
+    f.lat      = CENTER_LAT + metresToLat((frand() - 0.5) * REGION_KM * 1000.0);
+    f.lon      = CENTER_LON + metresToLon((frand() - 0.5) * REGION_KM * 1000.0, CENTER_LAT);
+    f.radius_m = (double)(int)(100.0 + frand() * 400.0);
+    return f;
+}
+
+static std::vector<SrcFence> makeFences(unsigned n)
+{
+    std::vector<SrcFence> v;
+    unsigned circles = n / 4;
+    for (unsigned i = 0; i < circles; i++) v.push_back(makeCircle(i));
+    for (unsigned i = circles; i < n; i++) v.push_back(makePolygon(i));
+    return v;
+}
+
+static GeoResult storeSrc(GeoStore *s, const SrcFence &f)
+{
+    if (f.circle) {
+        return geoStoreCircle(s, f.name, geoE7(f.lat), geoE7(f.lon), (uint32_t)f.radius_m);
+    }
+    int32_t lat[GEO_MAX_POLY_VERTS], lon[GEO_MAX_POLY_VERTS];
+    for (size_t k = 0; k < f.plat.size(); k++) {
+        lat[k] = geoE7(f.plat[k]);
+        lon[k] = geoE7(f.plon[k]);
+    }
+    return geoStorePolygon(s, f.name, lat, lon, (uint8_t)f.plat.size());
+}
+
+// ─── Reference and baseline ──────────────────────────────────────────────────
+static double haversineM(double lat1, double lon1, double lat2, double lon2)
+{
+    double dLat = (lat2 - lat1) * DEG;
+    double dLon = (lon2 - lon1) * DEG;
+    double a = sin(dLat / 2) * sin(dLat / 2) +
+               cos(lat1 * DEG) * cos(lat2 * DEG) * sin(dLon / 2) * sin(dLon / 2);
+    return R_EARTH * 2.0 * atan2(sqrt(a), sqrt(1.0 - a));
+}
+
+// Double-precision containment on the unrounded vertices, and distance from
+// the fix to the fence edge, both in a local frame at the fix.
+static bool refInside(const SrcFence &f, double lat, double lon, double *edge_m)
+{
+    if (f.circle) {
+        double d = haversineM(f.lat, f.lon, lat, lon);
+        *edge_m = fabs(d - f.radius_m);
+        return d <= f.radius_m;
+    }
+    double kx = R_EARTH * DEG * cos(lat * DEG), ky = R_EARTH * DEG;
+    size_t n = f.plat.size();
+    bool inside = false;
+    double best = 1e18;
+    for (size_t i = 0, j = n - 1; i < n; j = i++) {
+        double xi = (f.plon[i] - lon) * kx, yi = (f.plat[i] - lat) * ky;
+        double xj = (f.plon[j] - lon) * kx, yj = (f.plat[j] - lat) * ky;
+        if ((yi > 0) != (yj > 0) && 0 < (xj - xi) * (0 - yi) / (yj - yi) + xi) inside = !inside;
+        double bx = xi - xj, by = yi - yj, len2 = bx * bx + by * by;
+        double t = len2 > 0 ? (-xj * bx - yj * by) / len2 : 0;
+        if (t < 0) t = 0;
+        if (t > 1) t = 1;
+        double dx = xj + t * bx, dy = yj + t * by;
+        double d = sqrt(dx * dx + dy * dy);
+        if (d < best) best = d;
+    }
+    *edge_m = best;
+    return inside;
+}
+
+struct Query {
+    double  lat, lon;
+    int32_t lat7, lon7;
+};
+
+static std::vector<Query> makeQueries(const std::vector<SrcFence> &fences, unsigned n)
+{
+    std::vector<Query> q(n);
+    for (unsigned i = 0; i < n; i++) {
+        double lat, lon;
+        if (i & 1) {
+            const SrcFence &f = fences[(unsigned)(frand() * fences.size()) % fences.size()];
+            double r = (f.radius_m + 500.0) * frand(), a = 2.0 * M_PI * frand();
+            lat = f.lat + metresToLat(r * sin(a));
+            lon = f.lon + metresToLon(r * cos(a), f.lat);
+        } else {
+            lat = CENTER_LAT + metresToLat((frand() - 0.5) * REGION_KM * 1000.0);
+            lon = CENTER_LON + metresToLon((frand() - 0.5) * REGION_KM * 1000.0, CENTER_LAT);
+        }
+        q[i].lat  = lat;
+        q[i].lon  = lon;
+        q[i].lat7 = geoE7(lat);
+        q[i].lon7 = geoE7(lon);
+    }
+    return q;
+}
+
+static double nowSecs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static volatile long g_sink;
+
+static double timeHaversine(const std::vector<SrcFence> &fences, const std::vector<Query> &q)
+{
+    long hits = 0;
+    double t0 = nowSecs();
+    for (unsigned r = 0; r < N_REPEATS; r++) {
+        for (size_t i = 0; i < q.size(); i++) {
+            for (size_t k = 0; k < fences.size(); k++) {
+                if (haversineM(fences[k].lat, fences[k].lon, q[i].lat, q[i].lon) <= fences[k].radius_m) {
+                    hits++;
+                    break;
+                }
+            }
+        }
+    }
+    g_sink = hits;
+    return (double)q.size() * N_REPEATS / (nowSecs() - t0);
+}
+
+static double timeProjected(const GeoStore *s, const std::vector<Query> &q)
+{
+    long hits = 0;
+    double t0 = nowSecs();
+    for (unsigned r = 0; r < N_REPEATS; r++) {
+        for (size_t i = 0; i < q.size(); i++) {
+            for (uint8_t k = 0; k < s->count; k++) {
+                const GeoFence *f = &s->fence[k];
+                // Same projection as geoLocal(), in double so far fixes cannot overflow.
+                float px = (float)(((double)q[i].lon7 - f->lon0) * f->kx);
+                float py = (float)(((double)q[i].lat7 - f->lat0) * GEO_M_PER_E7);
+                if (geoTestLocal(s, f, px, py)) {
+                    hits++;
+                    break;
+                }
+            }
+        }
+    }
+    g_sink = hits;
+    return (double)q.size() * N_REPEATS / (nowSecs() - t0);
+}
+
+static double timeFind(const GeoStore *s, const std::vector<Query> &q)
+{
+    long hits = 0;
+    double t0 = nowSecs();
+    for (unsigned r = 0; r < N_REPEATS; r++) {
+        for (size_t i = 0; i < q.size(); i++) {
+            if (geoFind(s, q[i].lat7, q[i].lon7) >= 0) hits++;
+        }
+    }
+    g_sink = hits;
+    return (double)q.size() * N_REPEATS / (nowSecs() - t0);
+}
+
+// Size of one fence.db Note body as the Notehub API would send it.
+static size_t noteJsonBytes(const SrcFence &f)
+{
+    char buf[64];
+    if (f.circle) {
+        return (size_t)snprintf(buf, sizeof(buf), "{\"lat\":%.6f,\"lon\":%.6f,\"radius\":%.0f}",
+                                f.lat, f.lon, f.radius_m);
+    }
+    size_t n = strlen("{\"points\":[]}");
+    for (size_t k = 0; k < f.plat.size(); k++) {
+        n += (size_t)snprintf(buf, sizeof(buf), "[%.6f,%.6f]", f.plat[k], f.plon[k]) + (k ? 1 : 0);
+    }
+    return n;
+}
+
+// ─── Checks ──────────────────────────────────────────────────────────────────
+static int failures = 0;
+static void check(bool ok, const char *what)
+{
+    if (!ok) {
+        printf("FAIL: %s\n", what);
+        failures++;
+    }
+}
+
+int main()
+{
+    static GeoStore store, loaded, other;
+    static uint8_t  image[GEO_IMAGE_MAX];
+
+    printf("Geofence checks per second (host; %u fixes x %u passes, half near a site)\n\n",
+           N_QUERIES, N_REPEATS);
+    printf("%-8s %9s %12s %12s %12s %10s\n", "fences", "vertices", "haversine", "projected", "geoFind",
+           "speedup");
+
+    const unsigned sizes[] = { 8, 32 };
+    for (unsigned si = 0; si < 2; si++) {
+        g_seed = 1000 + sizes[si];
+        std::vector<SrcFence> fences = makeFences(sizes[si]);
+        geoInit(&store);
+        for (size_t k = 0; k < fences.size(); k++) {
+            check(storeSrc(&store, fences[k]) == GEO_STORED, "fence stored");
+        }
+        std::vector<Query> q = makeQueries(fences, N_QUERIES);
+        double hv = timeHaversine(fences, q);
+        double pj = timeProjected(&store, q);
+        double gf = timeFind(&store, q);
+        printf("%-8u %9u %10.2fM %10.2fM %10.2fM %9.0fx\n", sizes[si], store.nverts,
+               hv / 1e6, pj / 1e6, gf / 1e6, gf / hv);
+    }
+
+    // ── Agreement with the double-precision reference (32 fences) ─────────────
+    g_seed = 1032;
+    std::vector<SrcFence> fences = makeFences(32);
+    geoInit(&store);
+    for (size_t k = 0; k < fences.size(); k++) storeSrc(&store, fences[k]);
+    std::vector<Query> q = makeQueries(fences, N_QUERIES);
+    unsigned inside = 0, disagree = 0, far_disagree = 0;
+    double worst_edge = 0.0;
+    for (size_t i = 0; i < q.size(); i++) {
+        int  got = geoFind(&store, q[i].lat7, q[i].lon7);
+        bool ref = false;
+        double near_edge = 1e18;
+        for (size_t k = 0; k < fences.size(); k++) {
+            double e;
+            if (refInside(fences[k], q[i].lat, q[i].lon, &e)) ref = true;
+            if (e < near_edge) near_edge = e;
+        }
+        if (ref) inside++;
+        if ((got >= 0) != ref) {
+            disagree++;
+            if (near_edge > worst_edge) worst_edge = near_edge;
+            if (near_edge > EDGE_TOL_M) far_disagree++;
+        }
+    }
+    printf("\nAgreement with a double-precision test on the unrounded fences: %u of %u fixes inside,\n"
+           "%u disagreements, all within %.1f m of an edge.\n",
+           inside, N_QUERIES, disagree, worst_edge);
+    check(far_disagree == 0, "geoFind agrees with the reference away from edges");
+
+    // ── Footprint ────────────────────────────────────────────────────────────
+    printf("\nFootprint\n");
+    printf("  RAM: GeoStore %zu bytes (%u fences, %u-vertex pool), GeoFence %zu bytes\n",
+           sizeof(GeoStore), (unsigned)GEO_MAX_FENCES, (unsigned)GEO_MAX_VERTICES, sizeof(GeoFence));
+    printf("  %-34s %8s %12s %14s\n", "store contents", "image", "as base64", "fence.db JSON");
+    {
+        geoInit(&other);
+        other.count = 0;
+        SrcFence home = makeCircle(0);
+        storeSrc(&other, home);
+        uint16_t len = geoEncode(&other, image);
+        printf("  %-34s %7uB %11uB %13zuB\n", "home circle only (as before)", len,
+               (unsigned)((len + 2) / 3 * 4), noteJsonBytes(home));
+    }
+    const unsigned counts[] = { 8, 16, 32 };
+    for (unsigned ci = 0; ci < 3; ci++) {
+        g_seed = 2000 + counts[ci];
+        std::vector<SrcFence> set = makeFences(counts[ci]);
+        geoInit(&other);
+        size_t json = 0;
+        for (size_t k = 0; k < set.size(); k++) {
+            storeSrc(&other, set[k]);
+            json += noteJsonBytes(set[k]);
+        }
+        uint16_t len = geoEncode(&other, image);
+        char label[48];
+        snprintf(label, sizeof(label), "%u fences, %u vertices", counts[ci], other.nverts);
+        printf("  %-34s %7uB %11uB %13zuB\n", label, len, (unsigned)((len + 2) / 3 * 4), json);
+    }
+    printf("  Image is carried in the sleep payload; a wake with no fence.db changes reads\n"
+           "  one empty note.changes response instead of the JSON column.\n\n");
+
+    // ── Round trip and corruption ────────────────────────────────────────────
+    uint16_t len = geoEncode(&store, image);
+    check(len <= GEO_IMAGE_MAX, "image within GEO_IMAGE_MAX");
+    check(geoDecode(&loaded, image, len), "image decodes");
+    check(loaded.count == store.count && loaded.nverts == store.nverts, "round trip keeps counts");
+    bool same = true;
+    for (size_t i = 0; i < q.size(); i++) {
+        if (geoFind(&store, q[i].lat7, q[i].lon7) != geoFind(&loaded, q[i].lat7, q[i].lon7)) same = false;
+    }
+    check(same, "round trip keeps every answer");
+    image[len / 2] ^= 0x40;
+    check(!geoDecode(&loaded, image, len) && loaded.count == 0, "corrupt image rejected");
+    check(!geoDecode(&loaded, image, (uint16_t)(len - 3)), "truncated image rejected");
+
+    // ── Editing ──────────────────────────────────────────────────────────────
+    store.dirty = false;
+    check(storeSrc(&store, fences[20]) == GEO_UNCHANGED && !store.dirty, "identical fence leaves store clean");
+
+    // Erase a polygon in the middle of the pool; the rest must answer as a store
+    // built without it.
+    const char *gone = fences[12].name;
+    check(geoErase(&store, gone), "erase");
+    geoInit(&other);
+    for (size_t k = 0; k < fences.size(); k++) {
+        if (k != 12) storeSrc(&other, fences[k]);
+    }
+    same = store.nverts == other.nverts;
+    for (size_t i = 0; i < q.size() && same; i++) {
+        int a = geoFind(&store, q[i].lat7, q[i].lon7);
+        int b = geoFind(&other, q[i].lat7, q[i].lon7);
+        if ((a < 0) != (b < 0) || (a >= 0 && strcmp(store.fence[a].name, other.fence[b].name) != 0)) same = false;
+    }
+    check(same, "erase compacts the pool without disturbing other fences");
+
+    // Editing a polygon in place replaces its vertices.
+    SrcFence moved = fences[20];
+    for (size_t k = 0; k < moved.plat.size(); k++) moved.plat[k] += metresToLat(5000.0);
+    check(storeSrc(&store, moved) == GEO_STORED && geoIndex(&store, moved.name) >= 0, "edit in place");
+
+    // Fill the store; an oversize replacement must keep the old fence.
+    while (store.count < GEO_MAX_FENCES) {
+        SrcFence c = makeCircle(100 + store.count);
+        check(storeSrc(&store, c) == GEO_STORED, "fill with circles");
+    }
+    SrcFence extra = makePolygon(99);
+    check(storeSrc(&store, extra) == GEO_FULL, "full store refuses a new fence");
+    SrcFence big = fences[30];
+    big.plat.clear();
+    big.plon.clear();
+    for (unsigned k = 0; k < GEO_MAX_POLY_VERTS; k++) {
+        double a = 2.0 * M_PI * k / GEO_MAX_POLY_VERTS;
+        big.plat.push_back(big.lat + metresToLat(800.0 * sin(a)));
+        big.plon.push_back(big.lon + metresToLon(800.0 * cos(a), big.lat));
+    }
+    unsigned used_before = store.nverts;
+    GeoResult br = storeSrc(&store, big);
+    if (br == GEO_FULL) {
+        check(geoIndex(&store, big.name) >= 0 && store.nverts == used_before, "full pool keeps the old fence");
+    }
+
+    // ── Exit hysteresis ──────────────────────────────────────────────────────
+    geoInit(&other);
+    int32_t sq_lat[4], sq_lon[4];
+    const double sq[4][2] = { { 0, 0 }, { 0, 200 }, { 200, 200 }, { 200, 0 } };
+    for (unsigned k = 0; k < 4; k++) {
+        sq_lat[k] = geoE7(CENTER_LAT + metresToLat(sq[k][0]));
+        sq_lon[k] = geoE7(CENTER_LON + metresToLon(sq[k][1], CENTER_LAT));
+    }
+    geoStorePolygon(&other, "square", sq_lat, sq_lon, 4);
+    int32_t out_lat = geoE7(CENTER_LAT + metresToLat(100.0));
+    int32_t out_lon = geoE7(CENTER_LON + metresToLon(-10.0, CENTER_LAT));
+    check(geoFind(&other, out_lat, out_lon) < 0, "10 m outside is outside");
+    check(geoNear(&other, 0, out_lat, out_lon, 25.0f), "10 m outside is near at 25 m margin");
+    check(!geoNear(&other, 0, out_lat, out_lon, 5.0f), "10 m outside is not near at 5 m margin");
+
+    if (failures) {
+        printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("All checks passed.\n");
+    return 0;
+}
@@ -79,6 +79,9 @@
 // Notecard state payload segment tag
 static const char STATE_SEG_ID[] = "HIVE";
 
+// Notecard inbound sync cadence (minutes) — weekly, to fit the satellite budget
+#define HUB_INBOUND_MIN               10080
+
 // ---------------------------------------------------------------------------
 // Global sensor and Notecard objects (also referenced by helpers.cpp via extern)
 // ---------------------------------------------------------------------------
@@ -86,6 +89,21 @@ Notecard        notecard;
 HX711           scale;
 Adafruit_SHT31  sht31;
 
+// ===========================================================================
+// resetWindow — clear the summary-window accumulators; the caller sets
+// last_report_epoch.  Alert cooldowns and the hub cadence survive.
+// ===========================================================================
+static void resetWindow(HiveState &st) {
+    st.weight_kg.reset();
+    st.temp_c.reset();
+    st.humidity_pct.reset();
+    st.zcr.reset();
+    st.rms.reset();
+    st.peak.reset();
+    st.audio_sampled = false;
+    st.sample_count  = 0;
+}
+
 // ===========================================================================
 // setup() — full application runs here each wake cycle; loop() is unreachable
 // ===========================================================================
@@ -110,10 +128,8 @@ void setup() {
         NotePayloadFree(&payload);
     }
     if (!restored) {
-        memset(&st, 0, sizeof(st));
-        st.first_boot      = true;
-        st.weight_first_kg = -1.0f;  // sentinel: no reading yet this window
-        st.weight_last_kg  = -1.0f;
+        memset(&st, 0, sizeof(st));  // empty accumulators, expired cooldowns
+        st.first_boot = true;
     }
 
     // ---- One-time Notecard configuration on true cold boot ---------------
@@ -124,11 +140,11 @@ void setup() {
     if (st.first_boot) {
         if (configOk && defineTemplates()) {
             st.first_boot = false;
-            // Seed stored_outbound_min with the default so the cadence
-            // re-alignment block below does not issue a redundant hub.set
-            // on this same wake (notecardConfigure already set outbound to
-            // DEFAULT_REPORT_INTERVAL_HR * 60 minutes).
-            st.stored_outbound_min = (uint16_t)(DEFAULT_REPORT_INTERVAL_HR * 60u);
+            // Seed the cached cadence with the default so the re-alignment
+            // block below does not issue a redundant hub.set on this same
+            // wake (notecardConfigure already set outbound to
+            // DEFAULT_REPORT_INTERVAL_HR * 60 minutes, inbound weekly).
+            st.hub.confirm(DEFAULT_REPORT_INTERVAL_HR * 60u, HUB_INBOUND_MIN);
         }
         // If any step failed, leave first_boot = true; retry next wake.
     }
@@ -186,20 +202,8 @@ void setup() {
     st.last_reset_token = resetSeen ? 1u : 0u;
 
     if (forceReset) {
-        st.weight_sum_kg       = 0.0f;
-        st.weight_first_kg     = -1.0f;
-        st.weight_last_kg      = -1.0f;
-        st.weight_sample_count = 0;
-        st.temp_sum_c          = 0.0f;
-        st.humidity_sum_pct    = 0.0f;
-        st.temp_valid_count    = 0;
-        st.zcr_sum             = 0.0f;
-        st.rms_sum             = 0.0f;
-        st.peak_sum            = 0.0f;
-        st.audio_sample_count  = 0;
-        st.audio_sampled       = false;
-        st.sample_count        = 0;
-        st.last_report_epoch   = 0;
+        resetWindow(st);
+        st.last_report_epoch = 0;
 #ifdef DEBUG_SERIAL
         Serial.println("[APP] reset_state=1 (0→1 transition): summary window cleared; time anchor will re-establish on next card.time");
 #endif
@@ -209,23 +213,14 @@ void setup() {
     // hub.set is sent on first boot in notecardConfigure(); after that,
     // env var changes to report_interval_hr must be reflected here so the
     // Notecard's outbound sync timer stays aligned with the summary cadence.
-    // stored_outbound_min is only updated when the Notecard confirms the request
-    // without an err field; a rejected or failed hub.set leaves stored_outbound_min
-    // unchanged so the next wake retries automatically.
-    uint16_t desiredOutbound = (uint16_t)reportHr * 60u;
-    if (st.stored_outbound_min != desiredOutbound) {
-        J *syncReq = notecard.newRequest("hub.set");
-        JAddStringToObject(syncReq, "mode",     "periodic");
-        JAddNumberToObject(syncReq, "outbound", desiredOutbound);
-        JAddNumberToObject(syncReq, "inbound",  10080);
-        J *syncRsp = notecard.requestAndResponse(syncReq);
-        if (syncRsp != NULL) {
-            const char *syncErr = JGetString(syncRsp, "err");
-            if (!syncErr || !*syncErr) {
-                st.stored_outbound_min = desiredOutbound;
-            }
-            notecard.deleteResponse(syncRsp);
-        }
+    // accelHubCadence() only issues hub.set when the cadence differs from
+    // st.hub, and only updates st.hub when the Notecard accepts the request;
+    // a rejected or failed hub.set leaves it unchanged so the next wake retries.
+    if (!accelHubCadence(notecard, &st.hub, (uint32_t)reportHr * 60u,
+                         HUB_INBOUND_MIN, NULL)) {
+#ifdef DEBUG_SERIAL
+        Serial.println("[APP] hub.set cadence update failed — retrying next wake");
+#endif
     }
 
     // ---- Initialise sensors ----------------------------------------------
@@ -252,7 +247,7 @@ void setup() {
     }
     scale.power_down();    // cut ~1.5 mA HX711 idle draw for sleep period
 
-    float temp_c = -9999.0f, humidity_pct = -9999.0f;
+    float temp_c = ACCEL_SENTINEL, humidity_pct = ACCEL_SENTINEL;
     bool  tempValid = readTempHumidity(temp_c, humidity_pct);
 
     // Audio variables — populated after window-expiry evaluation below.
@@ -299,20 +294,8 @@ void setup() {
         if (st.last_report_epoch == 0) {
             // Anchor: discard pre-anchor data; current readings will seed the
             // new window in the accumulation block below.
-            st.weight_sum_kg       = 0.0f;
-            st.weight_first_kg     = -1.0f;
-            st.weight_last_kg      = -1.0f;
-            st.weight_sample_count = 0;
-            st.temp_sum_c          = 0.0f;
-            st.humidity_sum_pct    = 0.0f;
-            st.temp_valid_count    = 0;
-            st.zcr_sum             = 0.0f;
-            st.rms_sum             = 0.0f;
-            st.peak_sum            = 0.0f;
-            st.audio_sample_count  = 0;
-            st.audio_sampled       = false;
-            st.sample_count        = 0;
-            st.last_report_epoch   = now;
+            resetWindow(st);
+            st.last_report_epoch = now;
         } else if (now - st.last_report_epoch >= (uint32_t)(reportHr * 3600u)) {
             // Window expired: send the frozen previous-window snapshot.
             // sample_count == 0 means nothing accumulated this window (e.g.
@@ -321,20 +304,8 @@ void setup() {
             // expiry indefinitely.
             bool sent = (st.sample_count == 0) || sendSummary(st);
             if (sent) {
-                st.weight_sum_kg       = 0.0f;
-                st.weight_first_kg     = -1.0f;
-                st.weight_last_kg      = -1.0f;
-                st.weight_sample_count = 0;
-                st.temp_sum_c          = 0.0f;
-                st.humidity_sum_pct    = 0.0f;
-                st.temp_valid_count    = 0;
-                st.zcr_sum             = 0.0f;
-                st.rms_sum             = 0.0f;
-                st.peak_sum            = 0.0f;
-                st.audio_sample_count  = 0;
-                st.audio_sampled       = false;
-                st.sample_count        = 0;
-                st.last_report_epoch   = now;
+                resetWindow(st);
+                st.last_report_epoch = now;
                 // accumulateThisWake stays true; current readings seed the new window.
             } else {
                 // sendSummary() failed — preserve frozen snapshot for retry.
@@ -359,7 +330,7 @@ void setup() {
     // readAudioFeatures() returns false when the signal is implausible (DC
     // offset outside the mid-rail band, > 30 % samples at ADC rail, or RMS
     // below the minimum threshold).  audioAttempted is set regardless of
-    // validity so a persistently bad sensor emits -9999 in the summary
+    // validity so a persistently bad sensor emits ACCEL_SENTINEL in the summary
     // rather than retrying every 15 minutes for the rest of the window.
     if (!st.audio_sampled) {
         audioAttempted = true;
@@ -373,63 +344,61 @@ void setup() {
     // ---- Accumulate into summary-window aggregates -----------------------
     if (accumulateThisWake) {
         if (weightValid) {
-            st.weight_sum_kg += weight_kg;
-            st.weight_last_kg = weight_kg;
-            if (st.weight_first_kg < 0.0f) st.weight_first_kg = weight_kg;
-            st.weight_sample_count++;
+            st.weight_kg.add(weight_kg);
         }
         if (tempValid) {
-            st.temp_sum_c       += temp_c;
-            st.humidity_sum_pct += humidity_pct;
-            st.temp_valid_count++;          // count only good reads so avg stays unbiased
+            // Only good reads are added, so the averages stay unbiased.
+            st.temp_c.add(temp_c);
+            st.humidity_pct.add(humidity_pct);
         }
         if (audioAttempted) {
             // Mark as attempted regardless of validity — a persistently bad
-            // sensor shows -9999 in the summary rather than retrying every
+            // sensor shows ACCEL_SENTINEL in the summary rather than retrying every
             // wake for the rest of the window.
             st.audio_sampled = true;
         }
         if (audioValid) {
-            st.zcr_sum  += zcr_mean;
-            st.rms_sum  += rms_mean;
-            st.peak_sum += peak_mean;
-            st.audio_sample_count++;
+            st.zcr.add(zcr_mean);
+            st.rms.add(rms_mean);
+            st.peak.add(peak_mean);
         }
         st.sample_count++;
     }
 
     // ---- Evaluate alert rules --------------------------------------------
+    // st.alerts.ready() is false while now == 0, so no alert fires before the
+    // first valid card.time (see the time-sync note above).  Each cooldown is
+    // only marked on confirmed delivery so that a transient note.add failure
+    // is retried on the next wake.
+    const uint32_t cooldownSec = (uint32_t)(ALERT_COOLDOWN_MIN * 60u);
 
     // Rule 1: significant weight loss — swarm, theft, or starvation.
-    // weight_first_kg < 0.0f means no prior valid reading exists this window;
-    // a reading of exactly 0.0 kg (empty or removed platform) is valid.
-    // Cooldown timestamp is only advanced on confirmed delivery so that a
-    // transient note.add failure is retried on the next wake.
-    if (now > 0 && weightValid && st.weight_first_kg >= 0.0f) {
-        float drop = st.weight_first_kg - weight_kg;
-        if (drop >= weightDrop &&
-            now - st.alert_weight_ts > (uint32_t)(ALERT_COOLDOWN_MIN * 60u)) {
+    // An empty weight accumulator means no prior valid reading exists this
+    // window; a reading of exactly 0.0 kg (empty or removed platform) is valid.
+    if (weightValid && !st.weight_kg.empty()) {
+        float drop = st.weight_kg.first - weight_kg;
+        if (drop >= weightDrop && st.alerts.ready(ALERT_WEIGHT, now, cooldownSec)) {
             if (sendAlert("weight_drop", drop, weight_kg)) {
-                st.alert_weight_ts = now;
+                st.alerts.mark(ALERT_WEIGHT, now);
             }
         }
     }
 
     // Rule 2: brood temperature outside viable range — chilling or overheating
-    if (now > 0 && tempValid && (temp_c < tempLow || temp_c > tempHigh) &&
-        now - st.alert_temp_ts > (uint32_t)(ALERT_COOLDOWN_MIN * 60u)) {
+    if (tempValid && (temp_c < tempLow || temp_c > tempHigh) &&
+        st.alerts.ready(ALERT_TEMP, now, cooldownSec)) {
         if (sendAlert("temp_anomaly", temp_c, humidity_pct)) {
-            st.alert_temp_ts = now;
+            st.alerts.mark(ALERT_TEMP, now);
         }
     }
 
     // Rule 3: acoustic behavioral anomaly — ZCR exceeds baseline; specific cause
     //          requires physical inspection (see §9 Limitations in README.md).
     //          Only evaluated on the one wake cycle per window when audio was sampled.
-    if (now > 0 && audioValid && zcr_mean > (float)audioZcr &&
-        now - st.alert_audio_ts > (uint32_t)(ALERT_COOLDOWN_MIN * 60u)) {
+    if (audioValid && zcr_mean > (float)audioZcr &&
+        st.alerts.ready(ALERT_AUDIO, now, cooldownSec)) {
         if (sendAlert("audio_anomaly", zcr_mean, rms_mean)) {
-            st.alert_audio_ts = now;
+            st.alerts.mark(ALERT_AUDIO, now);
         }
     }
 
@@ -10,17 +10,18 @@
     defineTemplates()   — registers compact Note templates for
                           hive_summary.qo (port 10) and hive_alert.qo
                           (port 11); required for Skylo NTN operation.
-    fetchEnvOverrides() — pulls operator thresholds from Notehub env vars,
-                          applies individual range clamps, then validates the
-                          temp_low_c / temp_high_c pair together before storing.
+    fetchEnvOverrides() — pulls operator thresholds from Notehub env vars
+                          through an accel_core.h env schema (per-variable
+                          range checks), then validates the temp_low_c /
+                          temp_high_c pair together before storing.
     readWeightKg()      — HX711 10-sample average; sleeps chip after read.
     readTempHumidity()  — SHT31-D single I2C measurement with NaN guard.
     readAudioFeatures() — two-pass ZCR/RMS/peak extraction over 12 × 256
                           samples; per-window DC offset computed from data,
                           ZCR derived from measured wall-clock time.
     sendAlert()         — note.add with sync:true; retries once on failure.
-    sendSummary()       — daily aggregated Note; uses safeAvg() sentinels.
-    safeAvg()           — returns -9999.0 when count == 0.
+    sendSummary()       — daily aggregated Note; empty AccelStat fields
+                          report the ACCEL_SENTINEL (-9999).
 ***************************************************************************/
 
 #include <Arduino.h>
@@ -190,7 +191,29 @@ void fetchEnvOverrides(uint16_t &sampleMin, uint16_t &reportHr,
                        float &calibration, float &zeroOffsetKg,
                        bool &resetSeen) {
     resetSeen = false;
+
+    // Temp thresholds are parsed into locals first; the pair is validated
+    // together below before committing them.
+    float newTempLow  = tempLow;   // start from caller-supplied value (default)
+    float newTempHigh = tempHigh;  // start from caller-supplied value (default)
+
+    // Each override is applied only when inside its range; anything else
+    // keeps the caller's value (compile-time default).
+    const AccelEnvVar schema[] = {
+        { "sample_interval_min",  ACCEL_ENV_U16,   0,                                     1.0f,   1440.0f, &sampleMin },
+        { "report_interval_hr",   ACCEL_ENV_U16,   0,                                     1.0f,    168.0f, &reportHr },
+        { "weight_alert_kg_drop", ACCEL_ENV_FLOAT, ACCEL_ENV_LO_OPEN | ACCEL_ENV_HI_OPEN, 0.0f,     50.0f, &weightDropKg },
+        { "temp_low_c",           ACCEL_ENV_FLOAT, ACCEL_ENV_LO_OPEN | ACCEL_ENV_HI_OPEN, 0.0f,     50.0f, &newTempLow },
+        { "temp_high_c",          ACCEL_ENV_FLOAT, ACCEL_ENV_LO_OPEN | ACCEL_ENV_HI_OPEN, 0.0f,     50.0f, &newTempHigh },
+        { "audio_zcr_alert",      ACCEL_ENV_U16,   0,                                   100.0f,   5000.0f, &audioZcr },
+        { "hx711_calibration",    ACCEL_ENV_FLOAT, ACCEL_ENV_LO_OPEN | ACCEL_ENV_HI_OPEN, 100.0f, 100000.0f, &calibration },
+        { "hx711_zero_offset_kg", ACCEL_ENV_FLOAT, ACCEL_ENV_HI_OPEN,                     0.0f,    250.0f, &zeroOffsetKg },
+    };
+
     J *req = notecard.newRequest("env.get");
+    J *names = JAddArrayToObject(req, "names");
+    accelEnvNames(names, schema);
+    JAddItemToArray(names, JCreateString("reset_state"));
     J *rsp = notecard.requestAndResponse(req);
     if (rsp == NULL) return;
     const char *envErr = JGetString(rsp, "err");
@@ -199,35 +222,25 @@ void fetchEnvOverrides(uint16_t &sampleMin, uint16_t &reportHr,
     J *body = JGetObject(rsp, "body");
     if (body != NULL) {
         const char *v;
-        if ((v = JGetString(body, "sample_interval_min")) && *v) {
-            uint16_t n = (uint16_t)atoi(v);
-            if (n >= 1 && n <= 1440) sampleMin = n;
-        }
-        if ((v = JGetString(body, "report_interval_hr")) && *v) {
-            uint16_t n = (uint16_t)atoi(v);
-            if (n >= 1 && n <= 168) reportHr = n;
-        }
-        if ((v = JGetString(body, "weight_alert_kg_drop")) && *v) {
-            float f = strtof(v, NULL);
-            if (f > 0.0f && f < 50.0f) weightDropKg = f;
+        uint32_t rejected = accelEnvApply(body, schema);
+#ifdef DEBUG_SERIAL
+        for (size_t i = 0; i < sizeof(schema) / sizeof(schema[0]); i++) {
+            if (rejected & (1UL << i)) {
+                Serial.print("[APP] env: ");
+                Serial.print(schema[i].name);
+                Serial.print(" out of range, ignored: ");
+                Serial.println(JGetString(body, schema[i].name));
+            }
         }
-        // Parse temp thresholds into locals first; validate the pair together
-        // before committing them.  Raising temp_low_c in Notehub without also
-        // updating temp_high_c is a valid operator action, but if it produces a
-        // band where newTempLow >= newTempHigh the alert rule
+#else
+        (void)rejected;
+#endif
+        // Raising temp_low_c in Notehub without also updating temp_high_c is a
+        // valid operator action, but if it produces a band where
+        // newTempLow >= newTempHigh the alert rule
         //   (temp_c < tempLow || temp_c > tempHigh)
         // becomes permanently true for every reading.  Reject the whole override
         // set and keep the caller's values (compile-time defaults) instead.
-        float newTempLow  = tempLow;   // start from caller-supplied value (default)
-        float newTempHigh = tempHigh;  // start from caller-supplied value (default)
-        if ((v = JGetString(body, "temp_low_c")) && *v) {
-            float f = strtof(v, NULL);
-            if (f > 0.0f && f < 50.0f) newTempLow = f;
-        }
-        if ((v = JGetString(body, "temp_high_c")) && *v) {
-            float f = strtof(v, NULL);
-            if (f > 0.0f && f < 50.0f) newTempHigh = f;
-        }
         if (newTempLow < newTempHigh) {
             tempLow  = newTempLow;
             tempHigh = newTempHigh;
@@ -241,18 +254,6 @@ void fetchEnvOverrides(uint16_t &sampleMin, uint16_t &reportHr,
 #endif
             // tempLow / tempHigh unchanged; caller's defaults remain in effect.
         }
-        if ((v = JGetString(body, "audio_zcr_alert")) && *v) {
-            uint16_t n = (uint16_t)atoi(v);
-            if (n >= 100 && n <= 5000) audioZcr = n;
-        }
-        if ((v = JGetString(body, "hx711_calibration")) && *v) {
-            float f = strtof(v, NULL);
-            if (f > 100.0f && f < 100000.0f) calibration = f;
-        }
-        if ((v = JGetString(body, "hx711_zero_offset_kg")) && *v) {
-            float f = strtof(v, NULL);
-            if (f >= 0.0f && f < 250.0f) zeroOffsetKg = f;
-        }
         // Commissioning reset: report the raw env var state to the caller.
         // resetSeen = true means reset_state is currently "1" in Notehub.
         // The caller compares resetSeen against HiveState::last_reset_token to
@@ -454,9 +455,9 @@ bool readAudioFeatures(float &zcr_mean, float &rms_mean, float &peak_mean) {
 // Returns true only when the Notecard acknowledges without error.
 // ===========================================================================
 bool sendAlert(const char *alertType, float value1, float value2) {
-    // Read battery voltage once; use -9999 sentinel so downstream consumers
+    // Read battery voltage once; use the sentinel so downstream consumers
     // can distinguish a failed read from a legitimately-low real measurement.
-    int batt_mv = -9999;
+    int batt_mv = (int)ACCEL_SENTINEL;
     {
         J *rsp = notecard.requestAndResponse(notecard.newRequest("card.voltage"));
         if (rsp != NULL) {
@@ -508,9 +509,9 @@ bool sendAlert(const char *alertType, float value1, float value2) {
 // Returns true only when the Notecard acknowledges without error.
 // ===========================================================================
 bool sendSummary(const HiveState &st) {
-    // Read battery voltage once; use -9999 sentinel so downstream consumers
+    // Read battery voltage once; use the sentinel so downstream consumers
     // can distinguish a failed read from a legitimately-low real measurement.
-    int batt_mv = -9999;
+    int batt_mv = (int)ACCEL_SENTINEL;
     {
         J *rsp = notecard.requestAndResponse(notecard.newRequest("card.voltage"));
         if (rsp != NULL) {
@@ -522,11 +523,10 @@ bool sendSummary(const HiveState &st) {
         }
     }
 
-    float weight_avg   = safeAvg(st.weight_sum_kg, st.weight_sample_count);
-    // Both weight sentinels are -1.0f; >= 0.0f confirms a valid reading exists,
-    // including a true-zero reading for an empty or removed platform.
-    float weight_delta = (st.weight_first_kg >= 0.0f && st.weight_last_kg >= 0.0f)
-                         ? (st.weight_last_kg - st.weight_first_kg) : -9999.0f;
+    // An empty accumulator reports ACCEL_SENTINEL; a true-zero reading for an
+    // empty or removed platform is still a valid sample.
+    float weight_avg   = st.weight_kg.avg();
+    float weight_delta = st.weight_kg.delta();
 
     // Attempt note.add up to two times on the same wake cycle.
     for (int attempt = 0; attempt < 2; attempt++) {
@@ -537,12 +537,12 @@ bool sendSummary(const HiveState &st) {
         if (body != NULL) {
             JAddNumberToObject(body, "weight_kg",    weight_avg);
             JAddNumberToObject(body, "weight_delta", weight_delta);
-            JAddNumberToObject(body, "temp_c_avg",   safeAvg(st.temp_sum_c,      st.temp_valid_count));
-            JAddNumberToObject(body, "humidity_avg", safeAvg(st.humidity_sum_pct, st.temp_valid_count));
-            // audio_sample_count is 0 or 1 per window (snapshot taken once daily)
-            JAddNumberToObject(body, "zcr_avg",      (int)safeAvg(st.zcr_sum,    st.audio_sample_count));
-            JAddNumberToObject(body, "rms_avg",      safeAvg(st.rms_sum,         st.audio_sample_count));
-            JAddNumberToObject(body, "peak_avg",     safeAvg(st.peak_sum,        st.audio_sample_count));
+            JAddNumberToObject(body, "temp_c_avg",   st.temp_c.avg());
+            JAddNumberToObject(body, "humidity_avg", st.humidity_pct.avg());
+            // Audio stats hold 0 or 1 sample per window (snapshot taken once daily)
+            JAddNumberToObject(body, "zcr_avg",      (int)st.zcr.avg());
+            JAddNumberToObject(body, "rms_avg",      st.rms.avg());
+            JAddNumberToObject(body, "peak_avg",     st.peak.avg());
             JAddNumberToObject(body, "samples",      st.sample_count);
             JAddNumberToObject(body, "batt_mv",      batt_mv);
         }
@@ -558,9 +558,9 @@ bool sendSummary(const HiveState &st) {
                 Serial.println(err);
             } else {
                 Serial.print("[APP] Summary sent — samples: "); Serial.print(st.sample_count);
-                Serial.print("  zcr_avg: ");  Serial.print(safeAvg(st.zcr_sum,  st.audio_sample_count));
-                Serial.print("  rms_avg: ");  Serial.print(safeAvg(st.rms_sum,  st.audio_sample_count), 4);
-                Serial.print("  peak_avg: "); Serial.println(safeAvg(st.peak_sum, st.audio_sample_count), 4);
+                Serial.print("  zcr_avg: ");  Serial.print(st.zcr.avg());
+                Serial.print("  rms_avg: ");  Serial.print(st.rms.avg(), 4);
+                Serial.print("  peak_avg: "); Serial.println(st.peak.avg(), 4);
             }
 #endif
             notecard.deleteResponse(rsp);
@@ -569,10 +569,3 @@ bool sendSummary(const HiveState &st) {
     }
     return false;
 }
-
-// ===========================================================================
-// safeAvg — returns -9999.0 sentinel so downstream can detect missing data
-// ===========================================================================
-float safeAvg(float sum, uint16_t count) {
-    return (count > 0) ? (sum / (float)count) : -9999.0f;
-}
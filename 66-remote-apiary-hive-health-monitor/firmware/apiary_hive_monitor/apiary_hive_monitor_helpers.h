@@ -22,6 +22,7 @@
 #include <Notecard.h>
 #include <HX711.h>
 #include <Adafruit_SHT31.h>
+#include "accel_core.h"
 
 // ---------------------------------------------------------------------------
 // Debug output — uncomment to enable Serial.print statements during bench
@@ -35,31 +36,33 @@
 // ---------------------------------------------------------------------------
 // Persisted state shared between .ino and helpers
 // ---------------------------------------------------------------------------
+// Alert types, indexing HiveState::alerts.
+enum HiveAlert {
+    ALERT_WEIGHT,
+    ALERT_TEMP,
+    ALERT_AUDIO,
+    ALERT_KINDS
+};
+
 struct HiveState {
-    float    weight_sum_kg;
-    float    weight_first_kg;    // first valid weight reading of the window; -1.0f = none yet
-    float    weight_last_kg;     // most recent valid weight reading; -1.0f = none yet
-    float    temp_sum_c;
-    float    humidity_sum_pct;
-    float    zcr_sum;
-    float    rms_sum;
-    float    peak_sum;
+    AccelStat<float> weight_kg;     // first/last give the window's weight delta
+    AccelStat<float> temp_c;        // successful SHT31-D reads only (avoids biasing avg on failures)
+    AccelStat<float> humidity_pct;
+    AccelStat<float> zcr;           // audio: at most one snapshot per window
+    AccelStat<float> rms;
+    AccelStat<float> peak;
     uint16_t sample_count;       // all sensor samples accumulated
-    uint16_t weight_sample_count;
-    uint16_t temp_valid_count;   // successful SHT31-D reads (avoids biasing avg on failures)
-    uint16_t stored_outbound_min; // last hub.set outbound value; reissue hub.set when changed
+    AccelCadence hub;            // last hub.set cadence; reissue hub.set when changed
 
-    uint32_t alert_weight_ts;    // epoch of last weight alert (debounce)
-    uint32_t alert_temp_ts;
-    uint32_t alert_audio_ts;
+    AccelCooldown<ALERT_KINDS> alerts;  // epoch of last alert per HiveAlert (debounce)
 
     uint32_t last_report_epoch;  // epoch of last daily summary
 
     bool     first_boot;
 
     // Audio is captured once per summary window (brief daily snippet).
-    // These fields track whether the snapshot has already been taken this window.
-    uint16_t audio_sample_count; // 0 before snapshot; 1 after
+    // zcr/rms/peak hold the snapshot if it was valid; this flag records that
+    // it was attempted, so a dead microphone is not retried every wake.
     bool     audio_sampled;      // true once audio captured this window
 
     // Edge-trigger state for the reset_state env var.
@@ -114,7 +117,7 @@ bool readTempHumidity(float &temp_c, float &humidity_pct);
 // outside mid-rail band, > 30 % samples at ADC rail, or RMS below the minimum
 // threshold — indicating a floating input, disconnected mic, or dead/shorted
 // capsule).  Outputs are zeroed and the caller should treat the result as
-// missing data (the -9999 sentinel path via safeAvg in sendSummary).
+// missing data (the ACCEL_SENTINEL path via AccelStat::avg in sendSummary).
 bool readAudioFeatures(float &zcr_mean, float &rms_mean, float &peak_mean);
 
 // Emit an immediate Note with sync:true to bypass outbound timer.
@@ -126,6 +129,3 @@ bool sendAlert(const char *alertType, float value1, float value2);
 // Returns true on success; false on failure (caller should not reset
 // last_report_epoch so the next wake retries the send).
 bool sendSummary(const HiveState &st);
-
-// Safe average: returns -9999.0 sentinel if count == 0
-float safeAvg(float sum, uint16_t count);
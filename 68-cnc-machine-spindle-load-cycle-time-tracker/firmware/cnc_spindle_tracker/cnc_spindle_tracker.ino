@@ -1,15 +1,16 @@
 // cnc_spindle_tracker.ino — CNC Machine Spindle Load & Cycle Time Tracker
 //
-// Reads CNC controller telemetry via Modbus TCP (OPTA Ethernet), accumulates
-// hourly OEE-component statistics, and routes events to Notehub via Blues
-// Wireless for OPTA (cellular).
+// Reads telemetry from up to MAX_CNC_MACHINES CNC controllers via pooled,
+// pipelined Modbus TCP (OPTA Ethernet), computes per-machine, per-shift OEE
+// on-device from cycle-state transitions, and routes shift records and events
+// to Notehub via Blues Wireless for OPTA (cellular).
 //
 // Hardware: Arduino OPTA RS485 + Blues Wireless for OPTA
 // Blues docs: https://dev.blues.io
 // Wireless for OPTA quickstart: https://dev.blues.io/quickstart/wireless-for-opta-quickstart/
 //
 // Dependencies (Arduino Library Manager):
-//   Blues Wireless Notecard (note-arduino), ArduinoModbus, ArduinoRS485
+//   Blues Wireless Notecard (note-arduino)
 //   Arduino Mbed OS Opta Boards (board package — includes Ethernet.h)
 
 #include "cnc_spindle_tracker_helpers.h"
@@ -42,51 +43,31 @@ static const IPAddress LOCAL_IP(192, 168, 250, 10);
 // ---------------------------------------------------------------------------
 // Globals accessible to cnc_spindle_tracker_helpers.cpp (extern in .h)
 // ---------------------------------------------------------------------------
-Config      cfg;
-WindowStats g_window;
-uint8_t     g_lastCycleState    = 0xFF;   // force-init on first sample
-uint32_t    g_lastCycleStartMs  = 0;
-bool        g_modbusConnected   = false;
-uint32_t    g_envLastModTime    = 0;      // incremental env.get
+Config       cfg;
+MachineState g_machines[MAX_CNC_MACHINES];   // per-machine window + edge trackers
+uint32_t     g_envLastModTime    = 0;        // incremental env.get
+bool         g_clockValid        = false;    // card.time has returned network time
+uint32_t     g_clockEpoch        = 0;
+uint32_t     g_clockMillis       = 0;
+int32_t      g_utcOffsetMin      = 0;
+uint32_t     g_shiftStartEpoch   = 0;        // 0 = shift start not yet known
 
 // ---------------------------------------------------------------------------
 // Globals local to this translation unit
 // ---------------------------------------------------------------------------
-static uint16_t g_lastAlarmCode      = 0;
-static uint32_t g_lastSpindleAlertMs = 0;
-// g_spindleAlertArmed starts false so the very first qualifying overload fires
-// immediately rather than being blocked until millis() has counted past
-// SPINDLE_ALERT_COOLDOWN_MS from epoch (which would suppress alerts for the
-// first 30 minutes after every boot).
-static bool     g_spindleAlertArmed  = false;
-
 // Alarm-event ring buffer: replaces the old single-slot g_alarmPending so that
 // multiple distinct alarm-code transitions observed during a comms outage are
-// queued rather than overwritten. One event is drained per evaluateAlerts()
-// call; the head entry stays in place until sendAlarm() succeeds. On overflow
-// the oldest slot is silently evicted and logged to Serial.
+// queued rather than overwritten. Shared by all machines; each entry carries
+// its machine index in the stored Sample. One event is drained per
+// ALARM_RETRY_MS from loop(); the head entry stays in place until sendAlarm()
+// succeeds. On overflow the oldest slot is silently evicted and logged to Serial.
 static PendingAlarm g_alarmFifo[ALARM_FIFO_SIZE] = {};
 static uint8_t      g_alarmFifoHead              = 0;
 static uint8_t      g_alarmFifoTail              = 0;
 
-// Cycle-count register baseline for per-window delta computation.
-// On the first valid sample we record the baseline without adding a delta;
-// the explicit `…Initialized` flag avoids any collision with a real register
-// value of 0xFFFF (which a high-throughput controller will eventually reach
-// at counter wrap — using a magic sentinel would silently drop the wrap delta).
-// Persists across report windows — do not reset in resetWindow().
-static bool         g_cycleCountInitialized      = false;
-static uint16_t     g_lastCycleCount             = 0;
-
-// Operator-ID change tracking. First sample establishes the baseline without
-// emitting an event (no prior state to report as "previous"); the explicit
-// flag means a real operator_id of 0xFFFF is not mistaken for "uninitialized".
-// Persists across report windows.
-static bool         g_operatorIdInitialized      = false;
-static uint16_t     g_lastOperatorId             = 0;
-
-static uint32_t g_lastSampleMs       = 0;
 static uint32_t g_lastReportMs       = 0;
+static uint32_t g_lastAlarmRetryMs   = 0;
+static uint32_t g_lastShiftCheckMs   = 0;
 
 // ---------------------------------------------------------------------------
 // setup
@@ -102,13 +83,20 @@ void setup() {
 #endif
 
     // Load compile-time defaults into config.
-    cfg.sampleMs           = (uint32_t)DEFAULT_SAMPLE_MINUTES * 60000UL;
+    cfg.sampleMs           = DEFAULT_POLL_MS;
     cfg.reportMs           = (uint32_t)DEFAULT_REPORT_MINUTES  * 60000UL;
     cfg.modbusPort         = DEFAULT_MODBUS_PORT;
     cfg.modbusUnitId       = DEFAULT_MODBUS_UNIT_ID;
     cfg.regSpindleLoad     = DEFAULT_REG_SPINDLE_LOAD;
     cfg.spindleOverloadPct = DEFAULT_SPINDLE_OVERLOAD_PCT;
     cfg.expectedCycleSec   = DEFAULT_EXPECTED_CYCLE_SEC;
+    cfg.microStopMs        = (uint32_t)DEFAULT_MICRO_STOP_SEC * 1000UL;
+    cfg.shiftCount         = oeeParseShiftStarts(DEFAULT_SHIFT_STARTS, cfg.shiftStartsMin);
+    cfg.machineCount       = 0;   // modbusPoolBegin() fills the default target
+
+    for (uint8_t m = 0; m < MAX_CNC_MACHINES; m++) {
+        resetMachineState(m);
+    }
 
     // Bring up OPTA Ethernet with static IP (default subnet 255.255.255.0).
     // Allow 1 s for PHY auto-negotiation before attempting any connections.
@@ -121,17 +109,16 @@ void setup() {
     notecard.begin();
 
     // Configure hub — blocks until hub.set succeeds so the device never enters
-    // the main loop in an unconfigured state. Then pull env-var overrides
-    // (which may adjust cadence), then register templates.
+    // the main loop in an unconfigured state. Build the Modbus pool with the
+    // default target, then pull env-var overrides (which may replace the
+    // machine list or adjust cadence), then register templates. Connections
+    // open lazily from modbusService().
     notecardConfigure(PRODUCT_UID);
+    modbusPoolBegin();
     fetchEnvOverrides();
     defineTemplates();
+    syncClock();
 
-    // Attempt initial Modbus TCP connection to CNC controller.
-    modbusConnect();
-
-    memset(&g_window, 0, sizeof(g_window));
-    g_lastSampleMs = millis();
     g_lastReportMs = millis();
 
     usbSerial.println("[APP] CNC Spindle Tracker started.");
@@ -143,32 +130,62 @@ void setup() {
 void loop() {
     const uint32_t now = millis();
 
-    // Poll CNC holding registers on sample cadence.
-    if (now - g_lastSampleMs >= cfg.sampleMs) {
-        g_lastSampleMs = now;
+    // Pump the Modbus pool: issues each machine's poll on its own cadence and
+    // collects pipelined responses. Every decoded sample is consumed here, in
+    // arrival order, so no cycle-state edge is lost between loop() passes.
+    modbusService();
+    Sample s;
+    while (modbusNextSample(s)) {
+        accumulateSample(s);
+        evaluateAlerts(s);
+    }
 
-        if (!g_modbusConnected) {
-            modbusConnect();
+    // Drain the alarm FIFO: attempt one delivery per ALARM_RETRY_MS to clear
+    // the backlog without stalling the Modbus pool with back-to-back I²C
+    // transactions. The head entry stays put until sendAlarm() succeeds.
+    if (g_alarmFifoHead != g_alarmFifoTail && now - g_lastAlarmRetryMs >= ALARM_RETRY_MS) {
+        g_lastAlarmRetryMs = now;
+        const PendingAlarm &front = g_alarmFifo[g_alarmFifoHead];
+        if (sendAlarm(front.alertType, front.sample)) {
+            g_alarmFifoHead = (g_alarmFifoHead + 1u) % ALARM_FIFO_SIZE;
         }
+    }
 
-        Sample s;
-        if (pollCnc(s)) {
-            accumulateSample(s);
-            evaluateAlerts(s);
+    // Shift boundary: once a second, compare the current shift's start with
+    // the one being accumulated and close every machine's shift on a change.
+    if (g_clockValid && now - g_lastShiftCheckMs >= 1000UL) {
+        g_lastShiftCheckMs = now;
+        const uint32_t epoch = g_clockEpoch + (now - g_clockMillis) / 1000UL;
+        const uint32_t start = oeeShiftStart(epoch, g_utcOffsetMin,
+                                             cfg.shiftStartsMin, cfg.shiftCount);
+        if (g_shiftStartEpoch == 0) {
+            // First valid clock since boot: adopt the shift in progress. Its
+            // record covers only the part observed since power-up.
+            g_shiftStartEpoch = start;
+        } else if (start != g_shiftStartEpoch) {
+            closeShift(start);
         }
     }
 
-    // Emit hourly summary Note and reset rolling window.
+    // Housekeeping each report interval: resync the clock, pick up env-var
+    // changes and scrap counts, and retry any shift record that failed to send.
     if (now - g_lastReportMs >= cfg.reportMs) {
         g_lastReportMs = now;
-        sendSummary();
-
-        // Re-fetch env vars each report window; pick up threshold or cadence changes.
+        syncClock();
         fetchEnvOverrides();
+        fetchQualityCounts();
+        for (uint8_t m = 0; m < cfg.machineCount; m++) {
+            MachineState &ms = g_machines[m];
+            if (ms.pendingValid &&
+                sendShift(m, ms.pendingShiftStart, ms.pendingWindow, ms.pendingOee)) {
+                ms.pendingValid = false;
+            }
+        }
     }
 
-    // Yield to RTOS scheduler and Ethernet stack between deadlines.
-    delay(50);
+    // Yield to RTOS scheduler and Ethernet stack. Kept short: edge timing is
+    // quantised to the poll period plus this delay.
+    delay(5);
 }
 
 // ---------------------------------------------------------------------------
@@ -194,63 +211,114 @@ static void alarmFifoPush(const char *type, const Sample &s) {
     g_alarmFifoTail = (g_alarmFifoTail + 1u) % ALARM_FIFO_SIZE;
 }
 
+// ---------------------------------------------------------------------------
+// closeShift
+// ---------------------------------------------------------------------------
+// Emit every machine's shift record and start the next shift. A record that
+// fails to send is parked and retried each report interval; a parked record
+// still unsent when the following shift closes is dropped (logged) rather
+// than merged, since combining shifts would corrupt both.
+static void closeShift(uint32_t nextShiftStart) {
+    for (uint8_t m = 0; m < cfg.machineCount; m++) {
+        MachineState &ms = g_machines[m];
+        if (ms.pendingValid &&
+            !sendShift(m, ms.pendingShiftStart, ms.pendingWindow, ms.pendingOee)) {
+            usbSerial.print("[APP] Machine ");
+            usbSerial.print(m);
+            usbSerial.println(" previous shift record dropped — still unsent.");
+        }
+        ms.pendingValid = false;
+        if (!sendShift(m, g_shiftStartEpoch, ms.window, ms.oee)) {
+            ms.pendingValid      = true;
+            ms.pendingShiftStart = g_shiftStartEpoch;
+            ms.pendingWindow     = ms.window;
+            ms.pendingOee        = ms.oee;
+        }
+        resetWindow(m);
+    }
+    g_shiftStartEpoch = nextShiftStart;
+}
+
 // ---------------------------------------------------------------------------
 // accumulateSample
 // ---------------------------------------------------------------------------
 static void accumulateSample(const Sample &s) {
-    const uint32_t now     = millis();
+    MachineState  &ms      = g_machines[s.machine];
+    WindowStats   &w       = ms.window;
+    // Receive timestamp, taken when handleFrame() decodes the reply inside
+    // modbusService(). Replies that arrive while loop() is blocked on Notecard
+    // I/O sit in the socket until the next pass, so the timestamp can lag the
+    // controller by that long and the next few samples land close together.
+    const uint32_t now     = s.timestampMs;
     const bool     running = (s.cycleState == 1);
+    // Time observed since this machine's previous sample. Summing the
+    // measured deltas keeps the shift's total right across a late pass, where
+    // crediting a fixed poll period per sample would not.
+    const uint32_t dtMs    = oeeSampleDt(now, ms.lastSampleMs, ms.lastSampleValid,
+                                         cfg.sampleMs);
+    ms.lastSampleMs    = now;
+    ms.lastSampleValid = true;
 
-    g_window.validSamples++;
-    g_window.operatorId = s.operatorId;
+    w.validSamples++;
+    w.operatorId = s.operatorId;
 
     if (running) {
-        g_window.spindleSum      += s.spindleLoadPct;
-        g_window.feedOverrideSum += s.feedOverridePct;
-        if (s.spindleLoadPct > g_window.spindlePeak) {
-            g_window.spindlePeak = s.spindleLoadPct;
+        w.spindleSum      += s.spindleLoadPct;
+        w.feedOverrideSum += s.feedOverridePct;
+        if (s.spindleLoadPct > w.spindlePeak) {
+            w.spindlePeak = s.spindleLoadPct;
         }
-        g_window.runSamples++;
-        g_window.runMinutes  += (cfg.sampleMs / 60000UL);
-    } else {
-        g_window.idleMinutes += (cfg.sampleMs / 60000UL);
+        w.runSamples++;
     }
 
+    // --- OEE time buckets ---
+    // Each successful poll credits the time since the previous one to run,
+    // micro-stop or downtime. A gap longer than OEE_MAX_GAP_POLLS poll
+    // periods (failed polls, a dropped connection) is unobserved and credits
+    // only the cap.
+    oeeAccrue(ms.oee, ms.oeeTracker, running, s.cycleState == 3,
+              dtMs, cfg.microStopMs);
+
     // --- Controller-authoritative cycle count (primary for cycle_count field) ---
     // Accumulate a per-window delta directly from the cycleCount holding register.
     // Unsigned 16-bit subtraction handles counter wrap (65535→0) correctly;
     // a controller reset that drops the counter by more than 32767 cannot be
     // distinguished from a natural wrap and would inflate one window's delta —
     // an accepted corner case given the rarity of mid-session resets on CNC
-    // controllers.
-    if (!g_cycleCountInitialized) {
+    // controllers. The explicit `…Initialized` flag avoids any collision with a
+    // real register value of 0xFFFF at counter wrap.
+    if (!ms.cycleCountInitialized) {
         // First valid sample: record the baseline without adding a delta yet.
-        g_lastCycleCount        = s.cycleCount;
-        g_cycleCountInitialized = true;
+        ms.lastCycleCount        = s.cycleCount;
+        ms.cycleCountInitialized = true;
     } else {
-        const uint16_t delta = (uint16_t)(s.cycleCount - g_lastCycleCount);
-        g_lastCycleCount = s.cycleCount;
-        g_window.windowCycleCountDelta += (uint32_t)delta;
+        const uint16_t delta = (uint16_t)(s.cycleCount - ms.lastCycleCount);
+        ms.lastCycleCount = s.cycleCount;
+        w.windowCycleCountDelta += (uint32_t)delta;
+        oeeAttribute(ms.oee, s.operatorId, running ? dtMs : 0, delta);
     }
 
-    // --- Edge-timing cycle tracking (heuristic — avg_cycle_sec only) ---
+    // --- Edge-timing cycle tracking (avg_cycle_sec and the histogram) ---
     // Detect cycle-start/end via cycleState transitions. This count is NOT
     // used as the authoritative cycle_count (the register delta above is
-    // published for that); it exists solely to measure average cycle wall-clock
-    // duration. Short cycles that complete within one sample interval are missed
-    // here but are still captured by the register delta above.
-    if (g_lastCycleState != s.cycleState) {
-        if (!running && g_lastCycleState == 1) {
+    // published for that); it exists solely to measure cycle wall-clock
+    // duration. At the default 500 ms poll the start/stop edges are resolved
+    // to within one poll period; cycles shorter than that are still captured
+    // by the register delta above.
+    if (ms.lastCycleState != s.cycleState) {
+        if (!running && ms.lastCycleState == 1) {
             // running → idle: a cycle just finished.
-            if (g_lastCycleStartMs > 0) {
-                g_window.totalCycleMs += (now - g_lastCycleStartMs);
-                g_window.cyclesCompleted++;
+            if (ms.lastCycleStartMs > 0) {
+                const uint32_t cycleMs = now - ms.lastCycleStartMs;
+                w.totalCycleMs += cycleMs;
+                w.cyclesCompleted++;
+                oeeCycleCompleted(ms.oee, cycleMs, cfg.expectedCycleSec * 1000UL);
             }
         } else if (running) {
             // idle → running: a new cycle just started.
-            g_lastCycleStartMs = now;
+            ms.lastCycleStartMs = now;
         }
-        g_lastCycleState = s.cycleState;
+        ms.lastCycleState = s.cycleState;
     }
 }
 
@@ -258,31 +326,22 @@ static void accumulateSample(const Sample &s) {
 // evaluateAlerts
 // ---------------------------------------------------------------------------
 static void evaluateAlerts(const Sample &s) {
+    MachineState  &ms      = g_machines[s.machine];
     const uint32_t now     = millis();
     const bool     running = (s.cycleState == 1);
 
-    // Drain the alarm FIFO: attempt one delivery per poll to clear the backlog
-    // without stalling the Modbus read loop with back-to-back I²C transactions.
-    // The head entry stays put until sendAlarm() succeeds.
-    if (!alarmFifoEmpty()) {
-        const PendingAlarm &front = g_alarmFifo[g_alarmFifoHead];
-        if (sendAlarm(front.alertType, front.sample)) {
-            g_alarmFifoHead = (g_alarmFifoHead + 1u) % ALARM_FIFO_SIZE;
-        }
-    }
-
     // Spindle overload: only meaningful while actively cutting.
     // The cooldown timestamp is always advanced before the send so that a
     // sustained overload during a comms outage adds at most one entry to the
     // FIFO per cooldown window rather than flooding it.
-    // g_spindleAlertArmed bypasses the timestamp check on the very first
+    // ms.spindleAlertArmed bypasses the timestamp check on the very first
     // qualifying overload, avoiding a 30-minute blind spot after boot.
     if (running &&
         s.spindleLoadPct > cfg.spindleOverloadPct &&
-        (!g_spindleAlertArmed || (now - g_lastSpindleAlertMs) >= SPINDLE_ALERT_COOLDOWN_MS))
+        (!ms.spindleAlertArmed || (now - ms.lastSpindleAlertMs) >= SPINDLE_ALERT_COOLDOWN_MS))
     {
-        g_spindleAlertArmed  = true;
-        g_lastSpindleAlertMs = now;   // advance first — prevents FIFO flood
+        ms.spindleAlertArmed  = true;
+        ms.lastSpindleAlertMs = now;   // advance first — prevents FIFO flood
         if (!sendAlarm("spindle_overload", s)) {
             alarmFifoPush("spindle_overload", s);
         }
@@ -292,40 +351,40 @@ static void evaluateAlerts(const Sample &s) {
     // one nonzero code changing to another). Avoids paging every sample for
     // the duration of a latched alarm.
     //
-    // State tracking (g_lastAlarmCode, g_window.alarmCount) is updated
+    // State tracking (ms.lastAlarmCode, ms.window.alarmCount) is updated
     // immediately — independent of whether the Note queues — so a comm outage
     // cannot cause the summary to undercount real alarm transitions. Failed
     // deliveries are buffered in the FIFO and retried on subsequent polls.
-    if (s.alarmCode != g_lastAlarmCode) {
+    if (s.alarmCode != ms.lastAlarmCode) {
         if (s.alarmCode != 0) {
-            g_window.alarmCount++;
-            g_lastAlarmCode = s.alarmCode;
+            ms.window.alarmCount++;
+            ms.lastAlarmCode = s.alarmCode;
             if (!sendAlarm("cnc_alarm", s)) {
                 alarmFifoPush("cnc_alarm", s);
             }
         } else {
             // Alarm cleared — advance tracker; no alert to send.
-            g_lastAlarmCode = s.alarmCode;
+            ms.lastAlarmCode = s.alarmCode;
         }
     }
 
     // Operator-ID change: emit a cnc_operator.qo event on any login/logout
     // transition (operator_id == 0 conventionally means no operator logged in).
-    // g_lastOperatorId is updated immediately so future changes are always
+    // ms.lastOperatorId is updated immediately so future changes are always
     // detected regardless of whether the event Note is delivered. Events are
     // best-effort and sampled at the poll interval: a comms outage can drop a
     // transition Note, and any change that occurs and reverts between two
     // consecutive polls is invisible to the firmware. The hourly summary
     // snapshot captures only the most recently observed operator ID at window
     // close — not a complete record of all transitions within the window.
-    if (!g_operatorIdInitialized) {
+    if (!ms.operatorIdInitialized) {
         // First observation: record baseline without emitting an event
         // (there is no prior state to report as "previous ID").
-        g_lastOperatorId        = s.operatorId;
-        g_operatorIdInitialized = true;
-    } else if (s.operatorId != g_lastOperatorId) {
-        const uint16_t prevId = g_lastOperatorId;
-        g_lastOperatorId = s.operatorId;
-        sendOperatorChange(prevId, s.operatorId);
+        ms.lastOperatorId        = s.operatorId;
+        ms.operatorIdInitialized = true;
+    } else if (s.operatorId != ms.lastOperatorId) {
+        const uint16_t prevId = ms.lastOperatorId;
+        ms.lastOperatorId = s.operatorId;
+        sendOperatorChange(s.machine, prevId, s.operatorId);
     }
 }
@@ -4,8 +4,9 @@
 //
 // All functions declared in cnc_spindle_tracker_helpers.h are implemented here.
 // Globals that must be shared with the .ino are declared extern in the shared
-// header; objects used exclusively within this file (Modbus TCP client and CNC
-// server IP) are kept static to avoid polluting the sketch namespace.
+// header; objects used exclusively within this file (Modbus TCP connection pool
+// and default CNC server IP) are kept static to avoid polluting the sketch
+// namespace.
 //
 // Hardware: Arduino OPTA RS485 + Blues Wireless for OPTA
 // Blues docs: https://dev.blues.io
@@ -13,15 +14,43 @@
 #include "cnc_spindle_tracker_helpers.h"
 
 // ---------------------------------------------------------------------------
-// Modbus TCP objects — private to this translation unit.
-// EthernetClient must outlive ModbusTCPClient; both are file-scope so they
-// share the same program lifetime.
+// Modbus TCP connection pool — private to this translation unit.
+//
+// ArduinoModbus's ModbusTCPClient is built on libmodbus and blocks for one
+// transaction at a time, so it cannot keep several requests in flight or
+// service more than one controller without stalling the others. The pool
+// below speaks Modbus TCP (MBAP framing, function 0x03) directly over
+// EthernetClient instead: each machine holds up to MODBUS_MAX_INFLIGHT
+// outstanding requests on its pooled connection, and responses are matched
+// back to the requesting machine by the MBAP transaction ID, so they may
+// arrive in any order. The framing and matching live in
+// cnc_spindle_tracker_modbus.h; this file owns the sockets.
 // ---------------------------------------------------------------------------
-static EthernetClient  _ethClient;
-static ModbusTCPClient _modbusTCPClient(_ethClient);
+struct ModbusConn {
+    EthernetClient client;
+    IPAddress      ip;
+    uint16_t       port;
+    bool           connected;
+    uint32_t       nextConnectMs;
+    uint8_t        timeouts;          // consecutive; reset by any good frame
+    uint8_t        rx[MODBUS_RX_BUF_SIZE];
+    uint16_t       rxLen;
+};
+
+static ModbusConn _conns[MAX_CNC_MACHINES];
+static uint8_t    _connCount = 0;
+static ModbusPoll _polls[MAX_CNC_MACHINES];         // per-machine transactions
+static uint32_t   _nextPollMs[MAX_CNC_MACHINES];
+static uint16_t   _nextTid = 1;
+
+// Decoded samples awaiting loop(). Same head/tail ring convention as the
+// alarm FIFO in the .ino; evicts the oldest sample on overflow.
+static Sample  _sampleQueue[SAMPLE_QUEUE_SIZE];
+static uint8_t _sampleHead = 0;
+static uint8_t _sampleTail = 0;
 
 // Static IP of the CNC Modbus TCP server on the private point-to-point subnet.
-// Adjust to match the CNC controller's network configuration before flashing.
+// Used as the single default target when the `cnc_hosts` env var is unset.
 // The default (192.168.250.1) pairs with the OPTA local IP (192.168.250.10)
 // defined in the .ino. See README §4 for network-configuration guidance.
 static const IPAddress _DEFAULT_CNC_IP(192, 168, 250, 1);
@@ -69,41 +98,73 @@ void notecardConfigure(const char *productUid) {
 // ---------------------------------------------------------------------------
 // defineTemplates
 // ---------------------------------------------------------------------------
-// Register fixed-length templates for all three Notefiles.
+// Register fixed-length templates for all three outbound Notefiles.
 // Type hints: 14.1 = 4-byte float; 14 = 4-byte signed int; 12 = 2-byte signed int;
+// 11 = 1-byte signed int;
 // string fields: the exemplar string's character count sets the allocated record
 // width (the Notecard truncates notes.add values to that length). Max 255 chars.
 void defineTemplates(void) {
-    // cnc_summary.qo — hourly OEE-component roll-up
+    // cnc_shift.qo — one OEE record per machine per shift
     {
         J *req = notecard.newRequest("note.template");
         if (req == NULL) {
-            usbSerial.println("[NOTECARD] cnc_summary.qo template allocation failed.");
+            usbSerial.println("[NOTECARD] cnc_shift.qo template allocation failed.");
         } else {
-            JAddStringToObject(req, "file", "cnc_summary.qo");
-            JAddNumberToObject(req, "port", 50);
+            JAddStringToObject(req, "file", "cnc_shift.qo");
+            JAddNumberToObject(req, "port", 53);
             J *body = JAddObjectToObject(req, "body");
+            // 11 = 1-byte signed int; machine index into the cnc_hosts list.
+            JAddNumberToObject(body, "machine",          11);
+            // UTC epoch of the scheduled shift start; 0 if the Notecard had no
+            // network time when the shift began.
+            JAddNumberToObject(body, "shift_start",      14);
+            // Time buckets in minutes; 12 = 2-byte signed int covers any shift.
+            JAddNumberToObject(body, "run_min",          12);
+            JAddNumberToObject(body, "down_min",         12);
+            JAddNumberToObject(body, "micro_stop_min",   12);
+            JAddNumberToObject(body, "alarm_min",        12);
+            JAddNumberToObject(body, "stops",            12);
+            JAddNumberToObject(body, "micro_stops",      12);
+            // 14 = 4-byte signed int; a fast cell can exceed 32767 parts or
+            // valid samples (500 ms × 8 h = 57600) in one shift.
+            JAddNumberToObject(body, "cycle_count",      14);
+            JAddNumberToObject(body, "scrap",            14);
+            JAddNumberToObject(body, "ideal_cycle_sec",  14);
+            JAddNumberToObject(body, "avg_cycle_sec",    14.1);
+            // OEE factors as 0–1 ratios; -9999 when undefined for the shift.
+            JAddNumberToObject(body, "availability",     14.1);
+            JAddNumberToObject(body, "performance",      14.1);
+            JAddNumberToObject(body, "quality",          14.1);
+            JAddNumberToObject(body, "oee",              14.1);
+            // Cycle-time histogram, bins as % of ideal: <50, 50–80, 80–95,
+            // 95–105, 105–120, 120–150, 150–200, ≥200.
+            char key[16];
+            for (uint8_t i = 0; i < OEE_HIST_BINS; i++) {
+                snprintf(key, sizeof(key), "hist_%u", (unsigned)i);
+                JAddNumberToObject(body, key, 12);
+            }
+            // Per-operator breakdown; op<n>_id is -1 for an unused slot.
+            for (uint8_t i = 0; i < OEE_MAX_OPERATORS; i++) {
+                snprintf(key, sizeof(key), "op%u_id", (unsigned)i);
+                JAddNumberToObject(body, key, 14);
+                snprintf(key, sizeof(key), "op%u_run_min", (unsigned)i);
+                JAddNumberToObject(body, key, 12);
+                snprintf(key, sizeof(key), "op%u_cycles", (unsigned)i);
+                JAddNumberToObject(body, key, 14);
+            }
             JAddNumberToObject(body, "spindle_pct_mean",       14.1);
             JAddNumberToObject(body, "spindle_pct_peak",       14.1);
             // feed-rate override mean (0–150 % of programmed rate), not
             // engineering-unit feed rate — see README §9 for explanation.
             JAddNumberToObject(body, "feed_override_pct_mean", 14.1);
-            JAddNumberToObject(body, "run_min",          12);
-            JAddNumberToObject(body, "idle_min",         12);
-            // 14 = 4-byte signed int; the per-window delta is a uint32_t that
-            // can exceed 32767 (the 2-byte signed limit of type 12) on high-
-            // throughput machines, so use the 4-byte type for safe encoding.
-            JAddNumberToObject(body, "cycle_count",      14);
-            // 14.1 = 4-byte float; supports avg cycle times above 32767 s (~9 h)
-            JAddNumberToObject(body, "avg_cycle_sec",    14.1);
-            // 14 = 4-byte signed int; safely represents the full uint16 range (0–65535)
-            // without sign-extension corruption for values above 32767.
-            JAddNumberToObject(body, "operator_id",      14);
             JAddNumberToObject(body, "alarm_count",      12);
-            // valid_samples == 0 signals a total comm outage for the window
-            JAddNumberToObject(body, "valid_samples",    12);
+            // valid_samples == 0 signals a total comm outage for the shift
+            JAddNumberToObject(body, "valid_samples",    14);
+            // Polls not sent because the machine's requests were all still
+            // in flight; > 0 means the controller can't keep up with poll_ms.
+            JAddNumberToObject(body, "skipped_polls",    14);
             if (!notecard.sendRequest(req)) {
-                usbSerial.println("[NOTECARD] cnc_summary.qo template registration failed.");
+                usbSerial.println("[NOTECARD] cnc_shift.qo template registration failed.");
             }
         }
     }
@@ -122,6 +183,7 @@ void defineTemplates(void) {
             // truncate all alert_type values beyond 2 characters. The longest
             // alert type ("modbus_unreachable") is 18 characters; 32 gives headroom.
             JAddStringToObject(body, "alert_type",  "xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx");
+            JAddNumberToObject(body, "machine",     11);
             // 14 = 4-byte signed int; safely represents alarm codes and operator IDs
             // in the full uint16 range (0–65535) without overflow above 32767.
             JAddNumberToObject(body, "alarm_code",  14);
@@ -146,6 +208,7 @@ void defineTemplates(void) {
             J *body = JAddObjectToObject(req, "body");
             // 14 = 4-byte signed int; safely represents operator IDs across the
             // full uint16 range (0–65535) without sign-extension above 32767.
+            JAddNumberToObject(body, "machine",          11);
             JAddNumberToObject(body, "operator_id",      14);
             JAddNumberToObject(body, "prev_operator_id", 14);
             if (!notecard.sendRequest(req)) {
@@ -155,6 +218,62 @@ void defineTemplates(void) {
     }
 }
 
+// ---------------------------------------------------------------------------
+// parseCncHosts
+// ---------------------------------------------------------------------------
+// Parse the `cnc_hosts` env var: comma-separated "ip[:port][/unit]" entries,
+// e.g. "192.168.250.1,192.168.250.2:5020,192.168.250.3/2". Missing port and
+// unit fall back to cfg.modbusPort / cfg.modbusUnitId. Returns the number of
+// targets written to out, or 0 if any entry is malformed or the list is too
+// long — a partially applied machine list would silently renumber machines.
+static uint8_t parseCncHosts(const char *list, CncTarget *out) {
+    char buf[256];
+    if (strlen(list) >= sizeof(buf)) return 0;
+    strcpy(buf, list);
+
+    uint8_t count = 0;
+    char   *save  = NULL;
+    for (char *tok = strtok_r(buf, ", ", &save); tok != NULL;
+         tok = strtok_r(NULL, ", ", &save)) {
+        if (count >= MAX_CNC_MACHINES) return 0;
+
+        CncTarget t;
+        t.port   = cfg.modbusPort;
+        t.unitId = cfg.modbusUnitId;
+
+        char *endp;
+        char *unit = strchr(tok, '/');
+        if (unit != NULL) {
+            *unit++ = '\0';
+            unsigned long ul = strtoul(unit, &endp, 10);
+            if (endp == unit || *endp != '\0' || ul < 1 || ul > 247) return 0;
+            t.unitId = (uint8_t)ul;
+        }
+        char *port = strchr(tok, ':');
+        if (port != NULL) {
+            *port++ = '\0';
+            unsigned long ul = strtoul(port, &endp, 10);
+            if (endp == port || *endp != '\0' || ul < 1 || ul > 65535) return 0;
+            t.port = (uint16_t)ul;
+        }
+        if (!t.ip.fromString(tok)) return 0;
+        out[count++] = t;
+    }
+    return count;
+}
+
+static bool cncTargetsEqual(const CncTarget *next, uint8_t nextCount) {
+    if (nextCount != cfg.machineCount) return false;
+    for (uint8_t m = 0; m < nextCount; m++) {
+        if (!(next[m].ip == cfg.machines[m].ip) ||
+            next[m].port   != cfg.machines[m].port ||
+            next[m].unitId != cfg.machines[m].unitId) {
+            return false;
+        }
+    }
+    return true;
+}
+
 // ---------------------------------------------------------------------------
 // fetchEnvOverrides
 // ---------------------------------------------------------------------------
@@ -209,13 +328,15 @@ void fetchEnvOverrides(void) {
     unsigned long ul;
     float         fv;
 
-    val = JGetString(env, "sample_minutes");
+    // poll_ms: per-machine poll period. The 100 ms floor keeps a full
+    // MAX_CNC_MACHINES cell within what the pool can pipeline on one segment.
+    val = JGetString(env, "poll_ms");
     if (val && val[0] != '\0') {
         ul = strtoul(val, &endp, 10);
-        if (endp != val && *endp == '\0' && ul >= 1 && ul <= 1440) {
-            cfg.sampleMs = (uint32_t)ul * 60000UL;
+        if (endp != val && *endp == '\0' && ul >= 100 && ul <= 60000) {
+            cfg.sampleMs = (uint32_t)ul;
         } else {
-            usbSerial.println("[ENV] sample_minutes invalid (1-1440), ignored.");
+            usbSerial.println("[ENV] poll_ms invalid (100-60000), ignored.");
         }
     }
 
@@ -251,17 +372,13 @@ void fetchEnvOverrides(void) {
         }
     }
 
-    // modbus_port: changing port requires a reconnect so the live TCP session
-    // uses the new address rather than continuing on the old port until failure.
+    // modbus_port / modbus_unit_id: defaults for cnc_hosts entries that omit
+    // ":port" or "/unit" (and for the single compile-time default target).
     val = JGetString(env, "modbus_port");
     if (val && val[0] != '\0') {
         ul = strtoul(val, &endp, 10);
         if (endp != val && *endp == '\0' && ul >= 1 && ul <= 65535) {
-            if ((uint16_t)ul != cfg.modbusPort) {
-                cfg.modbusPort    = (uint16_t)ul;
-                g_modbusConnected = false;   // force reconnect with new port on next poll
-                usbSerial.println("[ENV] modbus_port changed — will reconnect.");
-            }
+            cfg.modbusPort = (uint16_t)ul;
         } else {
             usbSerial.println("[ENV] modbus_port invalid (1-65535), ignored.");
         }
@@ -279,6 +396,43 @@ void fetchEnvOverrides(void) {
         }
     }
 
+    // cnc_hosts: the machine list. Any change to the resolved target list —
+    // including one caused by a new modbus_port / modbus_unit_id default —
+    // rebuilds the connection pool. Open shifts are flushed first so data
+    // gathered under the old machine numbering is not attributed to the new.
+    {
+        CncTarget next[MAX_CNC_MACHINES];
+        uint8_t   nextCount = 0;
+        bool      haveList  = true;
+        val = JGetString(env, "cnc_hosts");
+        if (val && val[0] != '\0') {
+            nextCount = parseCncHosts(val, next);
+            if (nextCount == 0) {
+                usbSerial.println("[ENV] cnc_hosts invalid (ip[:port][/unit],... "
+                                  "too long or malformed), ignored.");
+                haveList = false;
+            }
+        } else {
+            next[0].ip     = _DEFAULT_CNC_IP;
+            next[0].port   = cfg.modbusPort;
+            next[0].unitId = cfg.modbusUnitId;
+            nextCount      = 1;
+        }
+        if (haveList && !cncTargetsEqual(next, nextCount)) {
+            for (uint8_t m = 0; m < cfg.machineCount; m++) {
+                const MachineState &ms = g_machines[m];
+                if (ms.window.validSamples > 0) {
+                    sendShift(m, g_shiftStartEpoch, ms.window, ms.oee);
+                }
+            }
+            for (uint8_t m = 0; m < nextCount; m++) cfg.machines[m] = next[m];
+            cfg.machineCount = nextCount;
+            for (uint8_t m = 0; m < MAX_CNC_MACHINES; m++) resetMachineState(m);
+            modbusPoolBegin();
+            usbSerial.println("[ENV] cnc_hosts changed — connection pool rebuilt.");
+        }
+    }
+
     // reg_spindle_load: base address of the contiguous six-register block.
     // Upper bound 65529 ensures the last register (base + 5) stays within the
     // 16-bit Modbus address space.
@@ -312,34 +466,39 @@ void fetchEnvOverrides(void) {
         }
     }
 
-    // Cross-validate sample/report cadence.
-    //
-    // run_min and idle_min are accumulated by adding cfg.sampleMs/60000 on
-    // every poll. Two invariants must hold for the reported totals to be
-    // meaningful:
-    //   (a) sample_minutes <= report_minutes  — otherwise a single poll can
-    //       add more minutes to the accumulator than the entire report window.
-    //   (b) report_minutes % sample_minutes == 0 — otherwise the run+idle
-    //       total will not equal the window duration even when the machine is
-    //       continuously active, because the last partial sample never lands
-    //       exactly on the report boundary.
-    //
-    // Invariant (a) is enforced by clamping sampleMs down to reportMs.
-    // Invariant (b) is advisory; a warning is logged but the values are
-    // accepted because the approximation is small and operator-chosen cadences
-    // (e.g. 5/45) are still useful in practice.
-    if (cfg.sampleMs > cfg.reportMs) {
-        cfg.sampleMs = cfg.reportMs;
-        usbSerial.println("[ENV] sample_minutes clamped to report_minutes — "
-                          "a sample interval longer than the report window "
-                          "would overcount run/idle minutes.");
-    }
-    if (cfg.reportMs % cfg.sampleMs != 0) {
-        usbSerial.println("[ENV] WARNING: report_minutes is not a whole-number "
-                          "multiple of sample_minutes — run/idle totals in "
-                          "cnc_summary.qo will be approximate. Prefer cadences "
-                          "where report_minutes divides sample_minutes evenly "
-                          "(e.g. sample=5, report=60).");
+    // micro_stop_sec: stops shorter than this count against Performance
+    // (micro-stops), longer ones against Availability (downtime).
+    val = JGetString(env, "micro_stop_sec");
+    if (val && val[0] != '\0') {
+        ul = strtoul(val, &endp, 10);
+        if (endp != val && *endp == '\0' && ul >= 1 && ul <= 3600) {
+            cfg.microStopMs = (uint32_t)ul * 1000UL;
+        } else {
+            usbSerial.println("[ENV] micro_stop_sec invalid (1-3600), ignored.");
+        }
+    }
+
+    // shift_starts: local shift start times. Takes effect at the next shift
+    // boundary check; the shift in progress is closed if its start moved.
+    val = JGetString(env, "shift_starts");
+    if (val && val[0] != '\0') {
+        uint16_t starts[OEE_MAX_SHIFTS];
+        const uint8_t n = oeeParseShiftStarts(val, starts);
+        if (n > 0) {
+            cfg.shiftCount = n;
+            for (uint8_t i = 0; i < n; i++) cfg.shiftStartsMin[i] = starts[i];
+        } else {
+            usbSerial.println("[ENV] shift_starts invalid (HH:MM,... up to 4), ignored.");
+        }
+    }
+
+    // Cross-validate poll cadence against the micro-stop threshold. Stop
+    // time is credited in whole poll periods, so a poll period at or above
+    // micro_stop_sec would classify every stop as downtime.
+    if (cfg.sampleMs >= cfg.microStopMs) {
+        cfg.sampleMs = cfg.microStopMs / 2;
+        usbSerial.println("[ENV] poll_ms clamped below micro_stop_sec — a "
+                          "longer poll would make every stop downtime.");
     }
 
     notecard.deleteResponse(rsp);
@@ -358,157 +517,449 @@ void fetchEnvOverrides(void) {
 }
 
 // ---------------------------------------------------------------------------
-// modbusConnect
+// Modbus pool internals
 // ---------------------------------------------------------------------------
-bool modbusConnect(void) {
-    if (_modbusTCPClient.begin(_DEFAULT_CNC_IP, cfg.modbusPort)) {
-        usbSerial.println("[MODBUS] Connected to CNC controller.");
-        g_modbusConnected = true;
+
+// Raise modbus_unreachable for one machine, rate-limited to once per report
+// window. lastModbusErrArmed starts false so the first failure fires
+// immediately rather than being gated for one full report window while
+// millis() counts up from zero past cfg.reportMs.
+static void reportUnreachable(uint8_t m) {
+    MachineState &ms = g_machines[m];
+    if (ms.lastModbusErrArmed && (millis() - ms.lastModbusErrMs < cfg.reportMs)) {
+        return;
+    }
+    Sample empty = {};
+    empty.machine = m;
+    if (sendAlarm("modbus_unreachable", empty)) {
+        ms.lastModbusErrArmed = true;
+        ms.lastModbusErrMs    = millis();
+    }
+}
+
+// Close a connection, abandon its in-flight transactions and schedule a
+// reconnect. Invalidates any in-progress cycle on the machines it serves —
+// the timing gap makes elapsed time meaningless and would fabricate a
+// spuriously long completion.
+static void connDrop(uint8_t c, const char *why) {
+    ModbusConn &conn = _conns[c];
+    conn.client.stop();
+    conn.connected     = false;
+    conn.timeouts      = 0;
+    conn.rxLen         = 0;
+    conn.nextConnectMs = millis() + MODBUS_RECONNECT_BACKOFF_MS;
+
+    usbSerial.print("[MODBUS] ");
+    usbSerial.print(conn.ip);
+    usbSerial.print(": ");
+    usbSerial.println(why);
+
+    for (uint8_t m = 0; m < cfg.machineCount; m++) {
+        if (_polls[m].conn != c) continue;
+        modbusPollAbandon(_polls[m]);
+        g_machines[m].lastCycleStartMs = 0;
+        g_machines[m].lastCycleState   = 0xFF;
+        reportUnreachable(m);
+    }
+}
+
+// Open the connection if it is down and its backoff has elapsed. The connect
+// itself blocks inside the Ethernet stack, so it is capped at
+// MODBUS_CONNECT_TIMEOUT_MS; the backoff bounds how often a powered-off
+// controller can stall the loop.
+static bool connEnsure(uint8_t c) {
+    ModbusConn &conn = _conns[c];
+    if (conn.connected) {
+        if (conn.client.connected()) return true;
+        connDrop(c, "connection closed by peer.");
+        return false;
+    }
+    if ((int32_t)(millis() - conn.nextConnectMs) < 0) return false;
+
+    conn.client.setConnectionTimeout(MODBUS_CONNECT_TIMEOUT_MS);
+    if (conn.client.connect(conn.ip, conn.port)) {
+        conn.connected = true;
+        conn.timeouts  = 0;
+        conn.rxLen     = 0;
+        usbSerial.print("[MODBUS] Connected to ");
+        usbSerial.println(conn.ip);
         return true;
     }
-    usbSerial.println("[MODBUS] Connection failed — CNC unreachable.");
-    g_modbusConnected = false;
+    connDrop(c, "connection failed — CNC unreachable.");
     return false;
 }
 
-// ---------------------------------------------------------------------------
-// pollCnc
-// ---------------------------------------------------------------------------
-// Read all 6 CNC registers in one Modbus TCP transaction.
-bool pollCnc(Sample &s) {
-    s.valid = false;
-
-    // Rate-limit modbus_unreachable alarms to once per report window.
-    // Declared static so the limit spans repeated pollCnc() calls.
-    // lastModbusErrArmed starts false so the first failure fires immediately
-    // rather than being gated for one full report window (default 60 min) while
-    // millis() counts up from zero past cfg.reportMs.
-    static uint32_t lastModbusErrMs    = 0;
-    static bool     lastModbusErrArmed = false;
-
-    // All 6 demo registers are contiguous starting at regSpindleLoad.
-    // One requestFrom() is ~6× faster than six individual reads.
-    const uint16_t regBase = cfg.regSpindleLoad;
-    const int      qty     = 6;
-
-    if (!_modbusTCPClient.requestFrom(cfg.modbusUnitId, HOLDING_REGISTERS, (int)regBase, qty)) {
-        // Retry once: reconnect then re-poll.
-        usbSerial.println("[MODBUS] Read error — reconnecting...");
-        if (!modbusConnect() ||
-            !_modbusTCPClient.requestFrom(cfg.modbusUnitId, HOLDING_REGISTERS, (int)regBase, qty)) {
-
-            // Invalidate any in-progress cycle — the timing gap makes elapsed
-            // time meaningless and would fabricate a spuriously long completion.
-            g_lastCycleStartMs = 0;
-            g_lastCycleState   = 0xFF;
-
-            if (!lastModbusErrArmed || (millis() - lastModbusErrMs >= cfg.reportMs)) {
-                Sample empty = {};
-                if (sendAlarm("modbus_unreachable", empty)) {
-                    lastModbusErrArmed = true;
-                    lastModbusErrMs    = millis();
-                }
-            }
-            return false;
+// Queue a Read Holding Registers request for machine m on its pooled
+// connection. Returns false when the machine's in-flight budget is used up
+// or the write fails. A poll skipped for want of a slot is not queued; it is
+// counted in the shift record's skipped_polls so a controller that cannot
+// keep up with poll_ms shows as such rather than as a quiet machine.
+static bool sendReadRequest(uint8_t m) {
+    ModbusPoll &p    = _polls[m];
+    ModbusConn &conn = _conns[p.conn];
+
+    ModbusInFlight *slot = modbusSlotFree(p);
+    if (slot == NULL) {
+        WindowStats &w = g_machines[m].window;
+        if (w.skippedPolls++ == 0) {
+            usbSerial.print("[MODBUS] Machine ");
+            usbSerial.print(m);
+            usbSerial.println(" poll skipped — previous requests still in flight.");
         }
+        return false;
     }
 
-    // Guard: verify the full register block is available before decoding.
-    // A short or malformed TCP response must be discarded — reading beyond
-    // what was received returns -1 values that silently corrupt telemetry.
-    if (_modbusTCPClient.available() < qty) {
-        usbSerial.println("[MODBUS] Short response — discarding.");
-        g_lastCycleStartMs = 0;
-        g_lastCycleState   = 0xFF;
-        if (!lastModbusErrArmed || (millis() - lastModbusErrMs >= cfg.reportMs)) {
-            Sample empty = {};
-            if (sendAlarm("modbus_unreachable", empty)) {
-                lastModbusErrArmed = true;
-                lastModbusErrMs    = millis();
-            }
-        }
+    // 0 is never issued, so a zeroed slot cannot match a reply.
+    if (_nextTid == 0) _nextTid = 1;
+    const uint16_t tid = _nextTid++;
+    uint8_t adu[MODBUS_READ_REQ_LEN];
+    modbusEncodeRead(adu, tid, p.unitId, cfg.regSpindleLoad);
+    if (conn.client.write(adu, sizeof(adu)) != sizeof(adu)) {
+        connDrop(p.conn, "write failed.");
         return false;
     }
+    modbusSlotArm(p, slot, tid, millis());
+    return true;
+}
+
+static void sampleQueuePush(const Sample &s) {
+    if (((_sampleTail + 1u) % SAMPLE_QUEUE_SIZE) == _sampleHead) {
+        _sampleHead = (_sampleHead + 1u) % SAMPLE_QUEUE_SIZE;
+        usbSerial.println("[MODBUS] Sample queue full — oldest sample dropped.");
+    }
+    _sampleQueue[_sampleTail] = s;
+    _sampleTail = (_sampleTail + 1u) % SAMPLE_QUEUE_SIZE;
+}
+
+// Decode one complete ADU. Replies with a foreign protocol ID, an unknown
+// transaction ID (late replies to requests already timed out) or the wrong
+// unit ID are ignored; exception responses and short register blocks are
+// logged and discarded without touching machine state.
+static void handleFrame(uint8_t c, const uint8_t *f, uint16_t len) {
+    ModbusDecoded     d;
+    const ModbusReply rc = modbusMatchReply(_polls, cfg.machineCount, c, f, len, d);
+    switch (rc) {
+    case MODBUS_REPLY_PROTOCOL:
+        usbSerial.println("[MODBUS] Non-Modbus protocol ID — discarding.");
+        return;
+    case MODBUS_REPLY_UNIT:
+        usbSerial.print("[MODBUS] Reply from unit ");
+        usbSerial.print(f[6]);
+        usbSerial.println(" does not match the unit polled — discarding.");
+        return;
+    case MODBUS_REPLY_UNMATCHED:
+        return;
+    default:
+        break;
+    }
+    _conns[c].timeouts = 0;
 
+    if (rc == MODBUS_REPLY_EXCEPTION) {
+        usbSerial.print("[MODBUS] Machine ");
+        usbSerial.print(d.machine);
+        usbSerial.print(" exception code ");
+        usbSerial.println(d.exCode);
+        return;
+    }
+    if (rc == MODBUS_REPLY_SHORT) {
+        usbSerial.println("[MODBUS] Short response — discarding.");
+        return;
+    }
+    if (rc != MODBUS_REPLY_OK) return;
+
+    const uint16_t *reg = d.reg;
+    Sample s = {};
     // Registers use 0.1-unit scaling for percentages (demo map convention).
-    int16_t rawSpindle      = (int16_t)_modbusTCPClient.read();
     // Register N+1 is the feed-rate override (0–150 % of the programmed feed
     // rate), NOT actual feed rate in engineering units (mm/min or in/min).
     // Engineering-unit feed rate is not routinely available over Modbus TCP on
     // most CNC controllers; see README §9 for the full explanation.
-    int16_t rawFeedOverride = (int16_t)_modbusTCPClient.read();
-    s.alarmCode  = (uint16_t)_modbusTCPClient.read();
-    s.cycleState = (uint8_t)(_modbusTCPClient.read() & 0x00FF);
-    s.cycleCount = (uint16_t)_modbusTCPClient.read();
-    s.operatorId = (uint16_t)_modbusTCPClient.read();
-
-    s.spindleLoadPct  = rawSpindle      / 10.0f;  // e.g. 714  → 71.4 %
-    s.feedOverridePct = rawFeedOverride / 10.0f;  // e.g. 1000 → 100.0 % of programmed rate
-    s.valid = true;
+    s.spindleLoadPct  = (int16_t)reg[0] / 10.0f;  // e.g. 714  → 71.4 %
+    s.feedOverridePct = (int16_t)reg[1] / 10.0f;  // e.g. 1000 → 100.0 % of programmed rate
+    s.alarmCode       = reg[2];
+    s.cycleState      = (uint8_t)(reg[3] & 0x00FF);
+    s.cycleCount      = reg[4];
+    s.operatorId      = reg[5];
+    s.machine         = d.machine;
+    s.timestampMs     = millis();
+    s.valid           = true;
+    sampleQueuePush(s);
+}
+
+// Drain whatever the socket has buffered and split it into ADUs using the
+// MBAP length field. A length outside the legal range means the stream has
+// lost framing; the only safe recovery is to drop and reopen the socket.
+static void connReceive(uint8_t c) {
+    ModbusConn &conn = _conns[c];
+    while (conn.connected && conn.client.available() > 0) {
+        const int n = conn.client.read(&conn.rx[conn.rxLen],
+                                       sizeof(conn.rx) - conn.rxLen);
+        if (n <= 0) break;
+        conn.rxLen += (uint16_t)n;
+
+        for (;;) {
+            const int frameLen = modbusFrameLen(conn.rx, conn.rxLen);
+            if (frameLen < 0) {
+                connDrop(c, "MBAP framing lost — reconnecting.");
+                return;
+            }
+            if (frameLen == 0) break;
+            handleFrame(c, conn.rx, (uint16_t)frameLen);
+            memmove(conn.rx, &conn.rx[frameLen], conn.rxLen - frameLen);
+            conn.rxLen -= frameLen;
+        }
+    }
+}
+
+// Abandon requests that have outlived MODBUS_RESPONSE_TIMEOUT_MS. A run of
+// MODBUS_MAX_TIMEOUTS with no good frame in between drops the connection.
+static void connExpire(uint8_t c) {
+    ModbusConn    &conn = _conns[c];
+    const uint32_t now  = millis();
+    for (uint8_t m = 0; m < cfg.machineCount; m++) {
+        if (_polls[m].conn != c) continue;
+        const uint8_t expired = modbusPollExpire(_polls[m], now);
+        if (expired == 0) continue;
+        usbSerial.print("[MODBUS] Machine ");
+        usbSerial.print(m);
+        usbSerial.println(" response timeout.");
+        conn.timeouts += expired;
+        if (conn.timeouts >= MODBUS_MAX_TIMEOUTS) {
+            connDrop(c, "repeated timeouts — reconnecting.");
+            return;
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// modbusPoolBegin
+// ---------------------------------------------------------------------------
+// Group cfg.machines into one pooled connection per distinct IP:port and
+// stagger the machines' first polls across one poll period so a full cell
+// does not burst every request in the same loop() pass.
+void modbusPoolBegin(void) {
+    for (uint8_t c = 0; c < _connCount; c++) {
+        _conns[c].client.stop();
+    }
+    _connCount  = 0;
+    _sampleHead = _sampleTail = 0;
+
+    if (cfg.machineCount == 0) {
+        cfg.machines[0].ip     = _DEFAULT_CNC_IP;
+        cfg.machines[0].port   = cfg.modbusPort;
+        cfg.machines[0].unitId = cfg.modbusUnitId;
+        cfg.machineCount       = 1;
+    }
+
+    const uint32_t now = millis();
+    for (uint8_t m = 0; m < cfg.machineCount; m++) {
+        const CncTarget &t = cfg.machines[m];
+        uint8_t c = 0;
+        while (c < _connCount && !(_conns[c].ip == t.ip && _conns[c].port == t.port)) {
+            c++;
+        }
+        if (c == _connCount) {
+            ModbusConn &conn   = _conns[_connCount++];
+            conn.ip            = t.ip;
+            conn.port          = t.port;
+            conn.connected     = false;
+            conn.nextConnectMs = now;
+            conn.timeouts      = 0;
+            conn.rxLen         = 0;
+        }
+        modbusPollInit(_polls[m], c, t.unitId);
+        _nextPollMs[m] = now + (cfg.sampleMs * m) / cfg.machineCount;
+    }
+
+    usbSerial.print("[MODBUS] Pool: ");
+    usbSerial.print(cfg.machineCount);
+    usbSerial.print(" machine(s) on ");
+    usbSerial.print(_connCount);
+    usbSerial.println(" connection(s).");
+}
+
+// ---------------------------------------------------------------------------
+// modbusService
+// ---------------------------------------------------------------------------
+void modbusService(void) {
+    for (uint8_t c = 0; c < _connCount; c++) {
+        if (!connEnsure(c)) continue;
+        connReceive(c);
+        if (_conns[c].connected) connExpire(c);
+    }
+
+    const uint32_t now = millis();
+    for (uint8_t m = 0; m < cfg.machineCount; m++) {
+        if ((int32_t)(now - _nextPollMs[m]) < 0) continue;
+        // Advance on a fixed grid so the poll rate does not drift with loop
+        // latency; resynchronise if we have fallen more than a period behind.
+        _nextPollMs[m] += cfg.sampleMs;
+        if ((int32_t)(now - _nextPollMs[m]) >= 0) {
+            _nextPollMs[m] = now + cfg.sampleMs;
+        }
+        if (_conns[_polls[m].conn].connected) {
+            sendReadRequest(m);
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// modbusNextSample
+// ---------------------------------------------------------------------------
+bool modbusNextSample(Sample &s) {
+    if (_sampleHead == _sampleTail) return false;
+    s = _sampleQueue[_sampleHead];
+    _sampleHead = (_sampleHead + 1u) % SAMPLE_QUEUE_SIZE;
     return true;
 }
 
 // ---------------------------------------------------------------------------
-// sendSummary
+// sendShift
 // ---------------------------------------------------------------------------
-void sendSummary(void) {
+// Queue one cnc_shift.qo record. Takes the counters explicitly (rather than
+// reading g_machines) so a parked record from an earlier shift can be retried
+// after the live counters have been reset. Returns true once queued.
+bool sendShift(uint8_t machine, uint32_t shiftStart,
+               const WindowStats &w, const OeeStats &o) {
     // cycle_count: controller-authoritative delta from the cycleCount register.
-    // Captures short cycles that complete within a single sample interval,
-    // and is not subject to the edge-detection gaps of the state-transition
-    // heuristic below.
-    const uint32_t cycles     = g_window.windowCycleCountDelta;
-    const float spindleMean   = (g_window.runSamples > 0)
-                                ? g_window.spindleSum  / g_window.runSamples
-                                : 0.0f;
-    const float feedOverrideMean = (g_window.runSamples > 0)
-                                   ? g_window.feedOverrideSum / g_window.runSamples
+    const uint32_t cycles       = w.windowCycleCountDelta;
+    const uint32_t idealCycleMs = cfg.expectedCycleSec * 1000UL;
+    const OeeRatios r           = oeeCompute(o, cycles, idealCycleMs);
+
+    const float spindleMean      = (w.runSamples > 0)
+                                   ? w.spindleSum / w.runSamples
+                                   : 0.0f;
+    const float feedOverrideMean = (w.runSamples > 0)
+                                   ? w.feedOverrideSum / w.runSamples
+                                   : 0.0f;
+    // avg_cycle_sec: mean of edge-timed cycles (cycleState 1 → non-1). Float
+    // so very long jobs (> 32767 s ≈ 9 h) are represented correctly.
+    const float avgCycleSec      = (w.cyclesCompleted > 0)
+                                   ? (float)(w.totalCycleMs / w.cyclesCompleted) / 1000.0f
                                    : 0.0f;
-    // avg_cycle_sec: edge-timing heuristic derived from detected running→idle
-    // cycleState transitions. Uses float so very long jobs (> 32767 s ≈ 9 h)
-    // are represented correctly, matching the 14.1 (4-byte float) template
-    // type. Short cycles completed within one sample interval are not captured
-    // here, so this value may be 0 even when cycle_count > 0.
-    const uint32_t edgeCycles = g_window.cyclesCompleted;
-    const float avgCycleSec   = (edgeCycles > 0)
-                                ? (float)(g_window.totalCycleMs / edgeCycles) / 1000.0f
-                                : 0.0f;
 
     J *req = notecard.newRequest("note.add");
     if (req == NULL) {
-        usbSerial.println("[APP] Summary note allocation failed — window retained.");
-        return;
+        usbSerial.println("[APP] Shift note allocation failed.");
+        return false;
     }
-    JAddStringToObject(req, "file", "cnc_summary.qo");
+    JAddStringToObject(req, "file", "cnc_shift.qo");
     J *body = JAddObjectToObject(req, "body");
+    JAddNumberToObject(body, "machine",          (int)machine);
+    JAddNumberToObject(body, "shift_start",      (double)shiftStart);
+    JAddNumberToObject(body, "run_min",          (int)(o.runMs       / 60000UL));
+    JAddNumberToObject(body, "down_min",         (int)(o.downMs      / 60000UL));
+    JAddNumberToObject(body, "micro_stop_min",   (int)(o.microStopMs / 60000UL));
+    JAddNumberToObject(body, "alarm_min",        (int)(o.alarmMs     / 60000UL));
+    JAddNumberToObject(body, "stops",            (int)o.stops);
+    JAddNumberToObject(body, "micro_stops",      (int)o.microStops);
+    JAddNumberToObject(body, "cycle_count",      (double)cycles);
+    JAddNumberToObject(body, "scrap",            (double)o.scrap);
+    JAddNumberToObject(body, "ideal_cycle_sec",  (double)cfg.expectedCycleSec);
+    JAddNumberToObject(body, "avg_cycle_sec",    avgCycleSec);
+    JAddNumberToObject(body, "availability",     r.availability);
+    JAddNumberToObject(body, "performance",      r.performance);
+    JAddNumberToObject(body, "quality",          r.quality);
+    JAddNumberToObject(body, "oee",              r.oee);
+    char key[16];
+    for (uint8_t i = 0; i < OEE_HIST_BINS; i++) {
+        snprintf(key, sizeof(key), "hist_%u", (unsigned)i);
+        JAddNumberToObject(body, key, (int)o.hist[i]);
+    }
+    for (uint8_t i = 0; i < OEE_MAX_OPERATORS; i++) {
+        const OeeOperator &op = o.ops[i];
+        snprintf(key, sizeof(key), "op%u_id", (unsigned)i);
+        JAddNumberToObject(body, key, op.used ? (int)op.id : -1);
+        snprintf(key, sizeof(key), "op%u_run_min", (unsigned)i);
+        JAddNumberToObject(body, key, (int)(op.runMs / 60000UL));
+        snprintf(key, sizeof(key), "op%u_cycles", (unsigned)i);
+        JAddNumberToObject(body, key, (double)op.cycles);
+    }
     JAddNumberToObject(body, "spindle_pct_mean",       spindleMean);
-    JAddNumberToObject(body, "spindle_pct_peak",       g_window.spindlePeak);
+    JAddNumberToObject(body, "spindle_pct_peak",       w.spindlePeak);
     JAddNumberToObject(body, "feed_override_pct_mean", feedOverrideMean);
-    JAddNumberToObject(body, "run_min",          (int)g_window.runMinutes);
-    JAddNumberToObject(body, "idle_min",         (int)g_window.idleMinutes);
-    JAddNumberToObject(body, "cycle_count",      (int)cycles);
-    JAddNumberToObject(body, "avg_cycle_sec",    avgCycleSec);
-    JAddNumberToObject(body, "operator_id",      (int)g_window.operatorId);
-    JAddNumberToObject(body, "alarm_count",      (int)g_window.alarmCount);
-    // valid_samples == 0 means every Modbus poll failed this window;
+    JAddNumberToObject(body, "alarm_count",      (int)w.alarmCount);
+    // valid_samples == 0 means every Modbus poll failed this shift;
     // downstream analytics use this to distinguish a comm outage from
     // true zero activity (CNC powered and idle).
-    JAddNumberToObject(body, "valid_samples",    (int)g_window.validSamples);
+    JAddNumberToObject(body, "valid_samples",    (double)w.validSamples);
+    JAddNumberToObject(body, "skipped_polls",    (double)w.skippedPolls);
 
-    if (notecard.sendRequest(req)) {
-        usbSerial.print("[APP] Summary queued: ");
-        usbSerial.print(cycles);
-        usbSerial.print(" cycles (reg), ");
-        usbSerial.print(edgeCycles);
-        usbSerial.print(" edge-timed, ");
-        usbSerial.print(g_window.runMinutes);
-        usbSerial.print(" run min, ");
-        usbSerial.print(g_window.validSamples);
-        usbSerial.println(" valid samples.");
-        resetWindow();
-    } else {
-        // Leave window intact so accumulated data is not lost on a transient
-        // I²C failure; the next report boundary will retry with combined stats.
-        usbSerial.println("[APP] Summary send failed — window retained for next attempt.");
+    if (!notecard.sendRequest(req)) {
+        usbSerial.print("[APP] Machine ");
+        usbSerial.print(machine);
+        usbSerial.println(" shift record send failed.");
+        return false;
+    }
+    usbSerial.print("[APP] Machine ");
+    usbSerial.print(machine);
+    usbSerial.print(" shift queued: ");
+    usbSerial.print(cycles);
+    usbSerial.print(" parts, OEE ");
+    usbSerial.println(r.oee, 3);
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// syncClock
+// ---------------------------------------------------------------------------
+// Refresh the wall clock from card.time. The Notecard reports an error until
+// it has network time; callers keep the previous sync (if any) in that case.
+bool syncClock(void) {
+    J *req = notecard.newRequest("card.time");
+    if (req == NULL) return false;
+    J *rsp = notecard.requestAndResponse(req);
+    if (rsp == NULL) return false;
+
+    const char *errStr = JGetString(rsp, "err");
+    const uint32_t t   = (uint32_t)JGetNumber(rsp, "time");
+    if ((errStr != NULL && errStr[0] != '\0') || t == 0) {
+        notecard.deleteResponse(rsp);
+        return false;
+    }
+    g_clockEpoch   = t;
+    g_clockMillis  = millis();
+    // "minutes" is the local offset from UTC derived from the cell location.
+    g_utcOffsetMin = JGetInt(rsp, "minutes");
+    g_clockValid   = true;
+    notecard.deleteResponse(rsp);
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// fetchQualityCounts
+// ---------------------------------------------------------------------------
+// Drain cnc_quality.qi: each inbound Note {"machine": n, "scrap": k} from a
+// CMM, vision system or operator terminal adds k rejected parts to machine
+// n's current shift. Bounded per call so a large backlog cannot stall polling.
+void fetchQualityCounts(void) {
+    for (uint8_t i = 0; i < 16; i++) {
+        J *req = notecard.newRequest("note.get");
+        if (req == NULL) return;
+        JAddStringToObject(req, "file", "cnc_quality.qi");
+        JAddBoolToObject(req, "delete", true);
+        J *rsp = notecard.requestAndResponse(req);
+        if (rsp == NULL) return;
+
+        // An err here is normally "no notes available" — the queue is empty.
+        const char *errStr = JGetString(rsp, "err");
+        if (errStr != NULL && errStr[0] != '\0') {
+            notecard.deleteResponse(rsp);
+            return;
+        }
+        J *body = JGetObject(rsp, "body");
+        const int machine = (body != NULL) ? JGetInt(body, "machine") : -1;
+        const int scrap   = (body != NULL) ? JGetInt(body, "scrap")   : 0;
+        if (machine >= 0 && machine < cfg.machineCount && scrap > 0) {
+            g_machines[machine].oee.scrap += (uint32_t)scrap;
+            usbSerial.print("[OEE] Machine ");
+            usbSerial.print(machine);
+            usbSerial.print(" scrap +");
+            usbSerial.println(scrap);
+        } else {
+            usbSerial.println("[OEE] cnc_quality.qi note ignored (bad machine or scrap).");
+        }
+        notecard.deleteResponse(rsp);
     }
 }
 
@@ -531,11 +982,14 @@ bool sendAlarm(const char *alertType, const Sample &s) {
         JAddBoolToObject(req, "sync", true);
         J *body = JAddObjectToObject(req, "body");
         JAddStringToObject(body, "alert_type",  alertType);
+        JAddNumberToObject(body, "machine",     (int)s.machine);
         JAddNumberToObject(body, "alarm_code",  (int)s.alarmCode);
         JAddNumberToObject(body, "spindle_pct", s.spindleLoadPct);
         JAddNumberToObject(body, "operator_id", (int)s.operatorId);
         if (notecard.sendRequest(req)) {
-            usbSerial.print("[ALARM] ");
+            usbSerial.print("[ALARM] Machine ");
+            usbSerial.print(s.machine);
+            usbSerial.print(": ");
             usbSerial.println(alertType);
             return true;
         }
@@ -553,12 +1007,11 @@ bool sendAlarm(const char *alertType, const Sample &s) {
 // Emits a cnc_operator.qo Note immediately (sync) when the operator_id
 // register transitions. Events are best-effort: a failed send is logged but
 // not buffered for retry here because only current state is meaningful for a
-// "who is logged in" signal. The hourly cnc_summary.qo captures the most
-// recently observed operator ID as a window-close snapshot — it does not
-// reconstruct the full sequence of transitions that occurred mid-window, and
-// any change that occurs and reverts between consecutive polls is never
-// recorded.
-void sendOperatorChange(uint16_t prevId, uint16_t newId) {
+// "who is logged in" signal. The cnc_shift.qo record carries per-operator run
+// time and parts for the shift, built from every sample rather than from these
+// events, so a dropped event does not lose attribution. Any change that occurs
+// and reverts between consecutive polls is never recorded.
+void sendOperatorChange(uint8_t machine, uint16_t prevId, uint16_t newId) {
     J *req = notecard.newRequest("note.add");
     if (req == NULL) {
         usbSerial.println("[OPERATOR] note.add allocation failed — event dropped.");
@@ -567,10 +1020,13 @@ void sendOperatorChange(uint16_t prevId, uint16_t newId) {
     JAddStringToObject(req, "file", "cnc_operator.qo");
     JAddBoolToObject(req, "sync", true);
     J *body = JAddObjectToObject(req, "body");
+    JAddNumberToObject(body, "machine",          (int)machine);
     JAddNumberToObject(body, "operator_id",      (int)newId);
     JAddNumberToObject(body, "prev_operator_id", (int)prevId);
     if (notecard.sendRequest(req)) {
-        usbSerial.print("[OPERATOR] ID change: ");
+        usbSerial.print("[OPERATOR] Machine ");
+        usbSerial.print(machine);
+        usbSerial.print(" ID change: ");
         usbSerial.print(prevId);
         usbSerial.print(" -> ");
         usbSerial.println(newId);
@@ -582,12 +1038,25 @@ void sendOperatorChange(uint16_t prevId, uint16_t newId) {
 // ---------------------------------------------------------------------------
 // resetWindow
 // ---------------------------------------------------------------------------
-void resetWindow(void) {
-    memset(&g_window, 0, sizeof(g_window));
-    // g_lastCycleState, g_lastCycleCount, g_cycleCountInitialized,
-    // g_lastOperatorId, and g_operatorIdInitialized are intentionally NOT reset
-    // here — they persist across report windows so that:
+void resetWindow(uint8_t machine) {
+    memset(&g_machines[machine].window, 0, sizeof(WindowStats));
+    memset(&g_machines[machine].oee,    0, sizeof(OeeStats));
+    // The edge, cycle-count baseline, operator and open-stop trackers in
+    // MachineState are intentionally NOT reset here — they persist across
+    // shifts so that:
     //   - the first sample of a new window does not trigger spurious edge detections,
     //   - the register-delta baseline remains valid across the window boundary, and
-    //   - operator-ID changes are tracked continuously across hourly summaries.
+    //   - operator-ID changes are tracked continuously across shifts, and
+    //   - a stop spanning a shift change is classified once, by its full length.
+}
+
+// ---------------------------------------------------------------------------
+// resetMachineState
+// ---------------------------------------------------------------------------
+// Full reset for a machine slot — at boot and whenever cnc_hosts renumbers
+// the machine list. lastCycleState = 0xFF forces edge re-init on the next
+// sample.
+void resetMachineState(uint8_t machine) {
+    memset(&g_machines[machine], 0, sizeof(MachineState));
+    g_machines[machine].lastCycleState = 0xFF;
 }
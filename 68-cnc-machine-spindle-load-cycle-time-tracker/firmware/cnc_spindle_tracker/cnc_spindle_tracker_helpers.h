@@ -12,8 +12,9 @@
 #pragma once
 
 #include <Notecard.h>
-#include <ArduinoModbus.h>
 #include <Ethernet.h>
+#include "cnc_spindle_tracker_modbus.h"
+#include "cnc_spindle_tracker_oee.h"
 
 // Serial alias — defined once here so both the .ino and the .cpp use the same port.
 #define usbSerial Serial
@@ -21,7 +22,9 @@
 // ---------------------------------------------------------------------------
 // Compile-time defaults — all overridable via Notehub environment variables.
 // ---------------------------------------------------------------------------
-#define DEFAULT_SAMPLE_MINUTES       1
+// Per-machine poll period. Sub-second polling lets on-device edge detection
+// resolve cycle start/stop on 20–40 s cycles; override via `poll_ms`.
+#define DEFAULT_POLL_MS              500
 #define DEFAULT_REPORT_MINUTES       60
 #define DEFAULT_MODBUS_PORT          502
 #define DEFAULT_MODBUS_UNIT_ID       1
@@ -30,25 +33,66 @@
 // Override via the `reg_spindle_load` Notehub env var.
 #define DEFAULT_REG_SPINDLE_LOAD     256
 #define DEFAULT_SPINDLE_OVERLOAD_PCT 90.0f   // spindle load % alert threshold
-#define DEFAULT_EXPECTED_CYCLE_SEC   120     // ideal cycle time (OEE dashboard)
+#define DEFAULT_EXPECTED_CYCLE_SEC   120     // ideal cycle time (OEE Performance)
 // 30-minute de-dup window prevents repeat pages on a sustained spindle overload.
 #define SPINDLE_ALERT_COOLDOWN_MS    (30UL * 60UL * 1000UL)
 // Depth of the alarm-event ring buffer used to survive transient I²C outages.
 // Sized for the worst realistic burst of distinct alarm-code transitions;
 // evicts the oldest slot on overflow (logged to Serial).
 #define ALARM_FIFO_SIZE              8
+// Minimum spacing between alarm-FIFO retry attempts. Decoupled from the poll
+// rate so sub-second polling does not turn a Notecard outage into a stream of
+// blocking I²C retries.
+#define ALARM_RETRY_MS               5000
+
+// ---------------------------------------------------------------------------
+// Multi-controller Modbus TCP pool
+// ---------------------------------------------------------------------------
+// Machines per gateway. Each machine is one (IP, port, unit ID) target from the
+// `cnc_hosts` env var; targets that share an IP:port share one pooled TCP
+// connection (e.g. a Modbus gateway fronting several controllers by unit ID).
+#define MAX_CNC_MACHINES             12
+// The per-machine in-flight budget (MODBUS_MAX_INFLIGHT) and response timeout
+// are defined with the protocol core in cnc_spindle_tracker_modbus.h.
+// Consecutive timeouts on one connection before the socket is dropped and
+// reopened — catches a half-open TCP session the stack has not noticed yet.
+#define MODBUS_MAX_TIMEOUTS          3
+// Upper bound on one EthernetClient::connect(). The controllers sit on the
+// OPTA's own switched subnet, where a live one completes the TCP handshake in
+// a few milliseconds; a powered-off one would otherwise hold loop() for the
+// stack's default connect timeout.
+#define MODBUS_CONNECT_TIMEOUT_MS    250
+// Delay before reconnecting a dropped connection, so a powered-off controller
+// costs at most one MODBUS_CONNECT_TIMEOUT_MS stall per backoff period.
+#define MODBUS_RECONNECT_BACKOFF_MS  5000
+// Decoded samples waiting for loop() to consume. Sized for one full round of
+// pipelined responses from every machine between two loop() passes.
+#define SAMPLE_QUEUE_SIZE            (MAX_CNC_MACHINES * 2)
 
 // ---------------------------------------------------------------------------
 // Shared data structures
 // ---------------------------------------------------------------------------
+// One polled CNC controller. The machine index (position in Config::machines)
+// is carried in every Note as `machine` so downstream analytics can key on it.
+struct CncTarget {
+    IPAddress ip;
+    uint16_t  port;
+    uint8_t   unitId;
+};
+
 struct Config {
-    uint32_t sampleMs;           // milliseconds between Modbus polls
+    uint32_t sampleMs;           // milliseconds between Modbus polls (per machine)
     uint32_t reportMs;           // milliseconds between summary Notes
-    uint16_t modbusPort;
-    uint8_t  modbusUnitId;
+    uint16_t modbusPort;         // default port for cnc_hosts entries without ":port"
+    uint8_t  modbusUnitId;       // default unit ID for cnc_hosts entries without "/unit"
+    uint8_t  machineCount;
+    CncTarget machines[MAX_CNC_MACHINES];
     uint16_t regSpindleLoad;     // base address of contiguous six-register block
     float    spindleOverloadPct;
-    uint32_t expectedCycleSec;   // reserved; not transmitted in any Note
+    uint32_t expectedCycleSec;   // ideal door-to-door cycle time for OEE Performance
+    uint32_t microStopMs;        // stops shorter than this are micro-stops
+    uint8_t  shiftCount;
+    uint16_t shiftStartsMin[OEE_MAX_SHIFTS];   // local minutes after midnight, sorted
 };
 
 struct Sample {
@@ -63,6 +107,8 @@ struct Sample {
     uint8_t  cycleState;         // 0=idle, 1=running, 2=hold, 3=alarm
     uint16_t cycleCount;
     uint16_t operatorId;
+    uint8_t  machine;            // index into cfg.machines
+    uint32_t timestampMs;        // millis() when the response was received
     bool     valid;
 };
 
@@ -79,28 +125,61 @@ struct WindowStats {
     float    spindlePeak;
     float    feedOverrideSum;    // sum of feed-rate override samples while running (0–150 %)
     uint32_t validSamples;       // total successful Modbus reads in this window
+    uint32_t skippedPolls;       // polls not sent: in-flight budget used up
     uint32_t runSamples;         // samples taken while cycle state == 1
-    uint32_t runMinutes;
-    uint32_t idleMinutes;
     uint32_t windowCycleCountDelta; // per-window sum of cycleCount register deltas (primary count)
     uint32_t cyclesCompleted;    // edge-transition count — heuristic used only for avg_cycle_sec
     uint32_t totalCycleMs;       // cumulative in-cycle time (for avg_cycle_sec heuristic)
-    uint16_t operatorId;         // most recently observed operator ID (snapshot for hourly summary)
+    uint16_t operatorId;         // most recently observed operator ID (snapshot at shift close)
     uint16_t alarmCount;         // CNC alarm-code transitions observed in window
 };
 
+// MachineState: everything tracked per polled controller. The window and OEE
+// counters are reset at each shift boundary; the edge/baseline trackers
+// persist across shifts. A shift record that fails to send is parked in the
+// pending* fields and retried on each report tick until the next shift closes.
+struct MachineState {
+    WindowStats window;
+    OeeStats    oee;
+    OeeTracker  oeeTracker;
+    bool        pendingValid;
+    uint32_t    pendingShiftStart;
+    WindowStats pendingWindow;
+    OeeStats    pendingOee;
+    uint8_t  lastCycleState;         // 0xFF forces edge re-init on next sample
+    uint32_t lastCycleStartMs;       // 0 = no cycle start observed
+    uint16_t lastAlarmCode;
+    uint32_t lastSpindleAlertMs;
+    bool     spindleAlertArmed;
+    bool     cycleCountInitialized;
+    uint16_t lastCycleCount;
+    bool     lastSampleValid;        // lastSampleMs holds a previous sample
+    uint32_t lastSampleMs;           // receive time of the previous sample
+    bool     operatorIdInitialized;
+    uint16_t lastOperatorId;
+    uint32_t lastModbusErrMs;        // modbus_unreachable rate limit
+    bool     lastModbusErrArmed;
+};
+
 // ---------------------------------------------------------------------------
 // Globals defined in cnc_spindle_tracker.ino and accessed by the helper .cpp.
-// Objects used exclusively inside the .cpp (Modbus client, CNC server IP) are
-// kept static there and are not declared here.
+// Objects used exclusively inside the .cpp (Modbus connection pool, default
+// CNC server IP) are kept static there and are not declared here.
 // ---------------------------------------------------------------------------
-extern Notecard    notecard;
-extern Config      cfg;
-extern WindowStats g_window;
-extern uint8_t     g_lastCycleState;
-extern uint32_t    g_lastCycleStartMs;
-extern bool        g_modbusConnected;
-extern uint32_t    g_envLastModTime;
+extern Notecard     notecard;
+extern Config       cfg;
+extern MachineState g_machines[MAX_CNC_MACHINES];
+extern uint32_t     g_envLastModTime;
+// Wall clock from card.time: epoch at the millis() of the last sync, plus the
+// local UTC offset for shift boundaries. g_clockValid is false until the
+// Notecard has network time.
+extern bool         g_clockValid;
+extern uint32_t     g_clockEpoch;
+extern uint32_t     g_clockMillis;
+extern int32_t      g_utcOffsetMin;
+// UTC epoch of the start of the shift being accumulated; 0 until the clock is
+// first valid (the first record after boot then covers a partial shift).
+extern uint32_t     g_shiftStartEpoch;
 
 // ---------------------------------------------------------------------------
 // Helper function prototypes.
@@ -110,9 +189,19 @@ extern uint32_t    g_envLastModTime;
 void notecardConfigure(const char *productUid);
 void defineTemplates(void);
 void fetchEnvOverrides(void);
-bool modbusConnect(void);
-bool pollCnc(Sample &s);
-void sendSummary(void);
+// (Re)build the connection pool from cfg.machines, closing any open sockets.
+// Populates a single default target when cfg.machineCount is 0.
+void modbusPoolBegin(void);
+// Non-blocking pool pump: (re)connects, issues due polls, reads responses and
+// expires timed-out transactions. Call on every loop() pass.
+void modbusService(void);
+// Pop the oldest decoded sample; false when the queue is empty.
+bool modbusNextSample(Sample &s);
+bool syncClock(void);
+void fetchQualityCounts(void);
+bool sendShift(uint8_t machine, uint32_t shiftStart,
+               const WindowStats &w, const OeeStats &o);
 bool sendAlarm(const char *alertType, const Sample &s);
-void sendOperatorChange(uint16_t prevId, uint16_t newId);
-void resetWindow(void);
+void sendOperatorChange(uint8_t machine, uint16_t prevId, uint16_t newId);
+void resetWindow(uint8_t machine);
+void resetMachineState(uint8_t machine);
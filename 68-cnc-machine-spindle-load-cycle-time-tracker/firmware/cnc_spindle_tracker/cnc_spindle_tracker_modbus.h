@@ -0,0 +1,204 @@
+// cnc_spindle_tracker_modbus.h
+// Transport-independent core of the Modbus TCP connection pool for the CNC
+// Machine Spindle Load & Cycle Time Tracker.
+//
+// MBAP request encoding, stream framing, reply matching and per-machine
+// in-flight bookkeeping. Nothing here touches a socket, millis(), Serial or
+// global state — the helper .cpp owns the EthernetClient connections and
+// passes bytes and timestamps in — so the same code is exercised on the host
+// by the check in sim/.
+//
+// Hardware: Arduino OPTA RS485 + Blues Wireless for OPTA
+// Blues docs: https://dev.blues.io
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+// ---------------------------------------------------------------------------
+// Tunables
+// ---------------------------------------------------------------------------
+// Requests allowed in flight per machine, matched to their responses by MBAP
+// transaction ID. The budget is per machine rather than per connection, so
+// one slow unit ID behind a gateway cannot use up the slots its neighbours on
+// the same socket need. Lets a slow controller keep polling without
+// serialising behind each round trip.
+#define MODBUS_MAX_INFLIGHT          2
+// A request with no response after this long is abandoned and its slot freed.
+#define MODBUS_RESPONSE_TIMEOUT_MS   1000
+
+// ---------------------------------------------------------------------------
+// Protocol constants
+// ---------------------------------------------------------------------------
+#define MBAP_HEADER_LEN          7      // tid(2) proto(2) len(2) unit(1)
+#define MBAP_PROTOCOL_MODBUS     0x0000
+#define MODBUS_FC_READ_HOLDING   0x03
+#define MODBUS_REG_BLOCK_QTY     6      // load, feed, alarm, state, count, operator_id
+#define MODBUS_READ_REQ_LEN      12     // MBAP header + 5-byte PDU
+#define MODBUS_RX_BUF_SIZE       260    // largest legal ADU
+
+// ---------------------------------------------------------------------------
+// Per-machine transaction state
+// ---------------------------------------------------------------------------
+struct ModbusInFlight {
+    bool     used;
+    uint16_t tid;
+    uint16_t seq;          // per-machine poll sequence — discards stale replies
+    uint32_t sentMs;
+};
+
+struct ModbusPoll {
+    uint8_t        conn;         // pooled connection this machine is reached on
+    uint8_t        unitId;
+    uint16_t       pollSeq;      // sequence of the latest request sent
+    uint16_t       appliedSeq;   // sequence of the latest reply applied
+    ModbusInFlight inflight[MODBUS_MAX_INFLIGHT];
+};
+
+static inline void modbusPollInit(ModbusPoll &p, uint8_t conn, uint8_t unitId) {
+    memset(&p, 0, sizeof(p));
+    p.conn   = conn;
+    p.unitId = unitId;
+}
+
+// Free slot in the machine's in-flight budget, or NULL when it is used up.
+static inline ModbusInFlight *modbusSlotFree(ModbusPoll &p) {
+    for (uint8_t i = 0; i < MODBUS_MAX_INFLIGHT; i++) {
+        if (!p.inflight[i].used) return &p.inflight[i];
+    }
+    return NULL;
+}
+
+static inline void modbusSlotArm(ModbusPoll &p, ModbusInFlight *slot,
+                                 uint16_t tid, uint32_t nowMs) {
+    slot->used   = true;
+    slot->tid    = tid;
+    slot->seq    = ++p.pollSeq;
+    slot->sentMs = nowMs;
+}
+
+// Abandon every request on the machine, e.g. when its connection drops.
+static inline void modbusPollAbandon(ModbusPoll &p) {
+    memset(p.inflight, 0, sizeof(p.inflight));
+}
+
+// Free the slots that have outlived MODBUS_RESPONSE_TIMEOUT_MS. Returns how
+// many were freed.
+static inline uint8_t modbusPollExpire(ModbusPoll &p, uint32_t nowMs) {
+    uint8_t expired = 0;
+    for (uint8_t i = 0; i < MODBUS_MAX_INFLIGHT; i++) {
+        ModbusInFlight &slot = p.inflight[i];
+        if (!slot.used || nowMs - slot.sentMs < MODBUS_RESPONSE_TIMEOUT_MS) continue;
+        slot.used = false;
+        expired++;
+    }
+    return expired;
+}
+
+// ---------------------------------------------------------------------------
+// Encoding and framing
+// ---------------------------------------------------------------------------
+// Read Holding Registers ADU for the six-register block at base.
+static inline void modbusEncodeRead(uint8_t adu[MODBUS_READ_REQ_LEN],
+                                    uint16_t tid, uint8_t unitId, uint16_t base) {
+    adu[0]  = (uint8_t)(tid >> 8);
+    adu[1]  = (uint8_t)tid;
+    adu[2]  = (uint8_t)(MBAP_PROTOCOL_MODBUS >> 8);
+    adu[3]  = (uint8_t)MBAP_PROTOCOL_MODBUS;
+    adu[4]  = 0x00;                       // length: unit + 5-byte PDU
+    adu[5]  = 0x06;
+    adu[6]  = unitId;
+    adu[7]  = MODBUS_FC_READ_HOLDING;
+    adu[8]  = (uint8_t)(base >> 8);
+    adu[9]  = (uint8_t)base;
+    adu[10] = 0x00;
+    adu[11] = MODBUS_REG_BLOCK_QTY;
+}
+
+// Length of the complete ADU at the front of a receive buffer: 0 while more
+// bytes are needed, -1 when the MBAP length field is outside the legal range
+// and the stream has lost framing.
+static inline int modbusFrameLen(const uint8_t *rx, uint16_t rxLen) {
+    if (rxLen < MBAP_HEADER_LEN) return 0;
+    const uint16_t pduLen = ((uint16_t)rx[4] << 8) | rx[5];
+    if (pduLen < 2 || pduLen > MODBUS_RX_BUF_SIZE - 6) return -1;
+    const uint16_t frameLen = 6 + pduLen;
+    return rxLen < frameLen ? 0 : frameLen;
+}
+
+// ---------------------------------------------------------------------------
+// Reply matching
+// ---------------------------------------------------------------------------
+enum ModbusReply {
+    MODBUS_REPLY_OK,          // reg[] holds the decoded register block
+    MODBUS_REPLY_PROTOCOL,    // MBAP protocol ID is not Modbus
+    MODBUS_REPLY_UNMATCHED,   // no request in flight on this connection has the tid
+    MODBUS_REPLY_UNIT,        // tid matches, but the unit ID is not the one polled
+    MODBUS_REPLY_EXCEPTION,   // exception response; exCode holds the code
+    MODBUS_REPLY_SHORT,       // wrong function code or incomplete register block
+    MODBUS_REPLY_STALE,       // reply to an older poll than one already applied
+};
+
+struct ModbusDecoded {
+    uint8_t  machine;         // index into the polls array; valid unless
+                              // PROTOCOL, UNMATCHED or UNIT
+    uint8_t  exCode;
+    uint16_t reg[MODBUS_REG_BLOCK_QTY];
+};
+
+// Match one complete ADU received on connection conn against the requests in
+// flight for the machines on that connection, free the request's slot and
+// decode the register block. Replies with a foreign protocol ID, an unknown
+// transaction ID (late replies to requests already timed out) or a unit ID
+// other than the one polled leave every slot untouched — a misrouted reply
+// must not be credited to the machine that happens to share its tid.
+static inline ModbusReply modbusMatchReply(ModbusPoll *polls, uint8_t count,
+                                           uint8_t conn, const uint8_t *f,
+                                           uint16_t len, ModbusDecoded &out) {
+    const uint16_t proto = ((uint16_t)f[2] << 8) | f[3];
+    if (proto != MBAP_PROTOCOL_MODBUS) return MODBUS_REPLY_PROTOCOL;
+
+    const uint16_t tid = ((uint16_t)f[0] << 8) | f[1];
+    ModbusPoll     *p    = NULL;
+    ModbusInFlight *slot = NULL;
+    for (uint8_t m = 0; m < count && slot == NULL; m++) {
+        if (polls[m].conn != conn) continue;
+        for (uint8_t i = 0; i < MODBUS_MAX_INFLIGHT; i++) {
+            if (polls[m].inflight[i].used && polls[m].inflight[i].tid == tid) {
+                p           = &polls[m];
+                slot        = &polls[m].inflight[i];
+                out.machine = m;
+                break;
+            }
+        }
+    }
+    if (slot == NULL) return MODBUS_REPLY_UNMATCHED;
+    if (f[6] != p->unitId) return MODBUS_REPLY_UNIT;
+
+    const uint16_t seq = slot->seq;
+    slot->used = false;
+
+    const uint8_t fc = f[7];
+    if (fc == (MODBUS_FC_READ_HOLDING | 0x80)) {
+        out.exCode = len > 8 ? f[8] : 0;
+        return MODBUS_REPLY_EXCEPTION;
+    }
+    // Guard: verify the full register block is present before decoding. A
+    // short or malformed response must be discarded — decoding past the end
+    // would silently corrupt telemetry.
+    if (fc != MODBUS_FC_READ_HOLDING || len < 9 + 2 * MODBUS_REG_BLOCK_QTY ||
+        f[8] != 2 * MODBUS_REG_BLOCK_QTY) {
+        return MODBUS_REPLY_SHORT;
+    }
+    // A reply to an older poll arriving after a newer one has been applied
+    // would step the edge detector backwards in time.
+    if ((int16_t)(seq - p->appliedSeq) <= 0) return MODBUS_REPLY_STALE;
+    p->appliedSeq = seq;
+
+    const uint8_t *r = &f[9];
+    for (uint8_t i = 0; i < MODBUS_REG_BLOCK_QTY; i++) {
+        out.reg[i] = ((uint16_t)r[2 * i] << 8) | r[2 * i + 1];
+    }
+    return MODBUS_REPLY_OK;
+}
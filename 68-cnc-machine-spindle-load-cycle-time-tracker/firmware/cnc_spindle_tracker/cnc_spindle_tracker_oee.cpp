@@ -0,0 +1,182 @@
+// cnc_spindle_tracker_oee.cpp
+// On-device OEE engine for the CNC Machine Spindle Load & Cycle Time Tracker.
+//
+// OEE follows the standard six-big-losses breakdown, restricted to what the
+// controller's Modbus registers can observe:
+//   planned time   = run + micro-stops + downtime (observed time only — polls
+//                    that fail are neither credited nor counted as downtime)
+//   operating time = run + micro-stops
+//   Availability   = operating / planned
+//   Performance    = ideal cycle × parts / operating
+//   Quality        = (parts − scrap) / parts
+// Micro-stops therefore reduce Performance, not Availability, which is how
+// short part-swap and chip-clear gaps are normally attributed.
+//
+// Hardware: Arduino OPTA RS485 + Blues Wireless for OPTA
+// Blues docs: https://dev.blues.io
+
+#include "cnc_spindle_tracker_oee.h"
+
+// Upper edges of the histogram bins, percent of ideal cycle time.
+static const uint16_t _HIST_EDGES_PCT[OEE_HIST_BINS - 1] = {
+    50, 80, 95, 105, 120, 150, 200
+};
+
+// ---------------------------------------------------------------------------
+// oeeSampleDt
+// ---------------------------------------------------------------------------
+uint32_t oeeSampleDt(uint32_t nowMs, uint32_t lastMs, bool haveLast, uint32_t sampleMs) {
+    if (!haveLast) return sampleMs;
+    const uint32_t dtMs  = nowMs - lastMs;
+    const uint32_t capMs = sampleMs * OEE_MAX_GAP_POLLS;
+    return dtMs < capMs ? dtMs : capMs;
+}
+
+// ---------------------------------------------------------------------------
+// oeeAccrue
+// ---------------------------------------------------------------------------
+void oeeAccrue(OeeStats &o, OeeTracker &t, bool running, bool alarm,
+               uint32_t dtMs, uint32_t microStopMs) {
+    if (running) {
+        // A stop that ended under the threshold is a micro-stop. Long stops
+        // were already moved into downMs when they crossed the threshold.
+        if (t.stopAccumMs > 0 && !t.stopIsLong) {
+            o.microStops++;
+            o.microStopMs += t.stopAccumMs;
+        }
+        t.stopAccumMs = 0;
+        t.stopIsLong  = false;
+        o.runMs += dtMs;
+        return;
+    }
+
+    if (alarm) {
+        o.alarmMs += dtMs;
+    }
+    if (t.stopIsLong) {
+        o.downMs += dtMs;
+        return;
+    }
+    t.stopAccumMs += dtMs;
+    if (t.stopAccumMs >= microStopMs) {
+        // Crossed the threshold: the whole stop so far becomes downtime and
+        // the rest of it accrues there directly, in whichever shift it lands.
+        o.stops++;
+        o.downMs     += t.stopAccumMs;
+        t.stopAccumMs = 0;
+        t.stopIsLong  = true;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// oeeCycleCompleted
+// ---------------------------------------------------------------------------
+void oeeCycleCompleted(OeeStats &o, uint32_t cycleMs, uint32_t idealCycleMs) {
+    if (idealCycleMs == 0) return;
+    const uint32_t pct = (uint32_t)(((uint64_t)cycleMs * 100u) / idealCycleMs);
+    uint8_t bin = 0;
+    while (bin < OEE_HIST_BINS - 1 && pct >= _HIST_EDGES_PCT[bin]) {
+        bin++;
+    }
+    if (o.hist[bin] < 0xFFFF) o.hist[bin]++;
+}
+
+// ---------------------------------------------------------------------------
+// oeeAttribute
+// ---------------------------------------------------------------------------
+void oeeAttribute(OeeStats &o, uint16_t operatorId, uint32_t runMs, uint32_t cycles) {
+    OeeOperator *slot = NULL;
+    for (uint8_t i = 0; i < OEE_MAX_OPERATORS; i++) {
+        if (o.ops[i].used && o.ops[i].id == operatorId) { slot = &o.ops[i]; break; }
+        if (!o.ops[i].used && slot == NULL)             { slot = &o.ops[i]; }
+    }
+    if (slot == NULL) {
+#ifndef OEE_HOST
+        Serial.println("[OEE] Operator slots full — sample not attributed.");
+#endif
+        return;
+    }
+    if (!slot->used) {
+        slot->used = true;
+        slot->id   = operatorId;
+    }
+    slot->runMs  += runMs;
+    slot->cycles += cycles;
+}
+
+// ---------------------------------------------------------------------------
+// oeeCompute
+// ---------------------------------------------------------------------------
+OeeRatios oeeCompute(const OeeStats &o, uint32_t cycleCount, uint32_t idealCycleMs) {
+    OeeRatios r = { OEE_SENTINEL, OEE_SENTINEL, OEE_SENTINEL, OEE_SENTINEL };
+    const uint32_t operatingMs = o.runMs + o.microStopMs;
+    const uint32_t plannedMs   = operatingMs + o.downMs;
+
+    if (plannedMs > 0) {
+        r.availability = (float)operatingMs / (float)plannedMs;
+    }
+    // Not clamped to 1.0: Performance above 100 % means expected_cycle_sec is
+    // set slower than the machine actually runs, which the dashboard should see.
+    if (operatingMs > 0 && idealCycleMs > 0) {
+        r.performance = (float)((double)idealCycleMs * cycleCount / operatingMs);
+    }
+    if (cycleCount > 0) {
+        const uint32_t scrap = (o.scrap < cycleCount) ? o.scrap : cycleCount;
+        r.quality = (float)(cycleCount - scrap) / (float)cycleCount;
+    }
+    if (r.availability != OEE_SENTINEL && r.performance != OEE_SENTINEL &&
+        r.quality != OEE_SENTINEL) {
+        r.oee = r.availability * r.performance * r.quality;
+    }
+    return r;
+}
+
+// ---------------------------------------------------------------------------
+// oeeParseShiftStarts
+// ---------------------------------------------------------------------------
+uint8_t oeeParseShiftStarts(const char *list, uint16_t *startsMin) {
+    uint8_t     count = 0;
+    const char *p     = list;
+    while (*p != '\0') {
+        while (*p == ' ' || *p == ',') p++;
+        if (*p == '\0') break;
+        if (count >= OEE_MAX_SHIFTS) return 0;
+
+        char *endp;
+        const unsigned long hh = strtoul(p, &endp, 10);
+        if (endp == p || *endp != ':' || hh > 23) return 0;
+        p = endp + 1;
+        const unsigned long mm = strtoul(p, &endp, 10);
+        if (endp == p || mm > 59) return 0;
+        p = endp;
+        if (*p != '\0' && *p != ',' && *p != ' ') return 0;
+
+        // Insertion sort — at most OEE_MAX_SHIFTS entries.
+        const uint16_t v = (uint16_t)(hh * 60 + mm);
+        uint8_t i = count++;
+        while (i > 0 && startsMin[i - 1] > v) {
+            startsMin[i] = startsMin[i - 1];
+            i--;
+        }
+        startsMin[i] = v;
+    }
+    return count;
+}
+
+// ---------------------------------------------------------------------------
+// oeeShiftStart
+// ---------------------------------------------------------------------------
+uint32_t oeeShiftStart(uint32_t epochUtc, int32_t utcOffsetMin,
+                       const uint16_t *startsMin, uint8_t count) {
+    const int64_t  local    = (int64_t)epochUtc + (int64_t)utcOffsetMin * 60;
+    const int64_t  dayStart = local - (local % 86400);
+    const uint16_t nowMin   = (uint16_t)((local % 86400) / 60);
+
+    // Latest start at or before now; before the first start of the day the
+    // current shift is the previous day's last one (e.g. a 22:00 night shift).
+    int64_t start = dayStart - 86400 + (int64_t)startsMin[count - 1] * 60;
+    for (uint8_t i = 0; i < count; i++) {
+        if (startsMin[i] <= nowMin) start = dayStart + (int64_t)startsMin[i] * 60;
+    }
+    return (uint32_t)(start - (int64_t)utcOffsetMin * 60);
+}
@@ -0,0 +1,114 @@
+// cnc_spindle_tracker_oee.h
+// On-device OEE engine for the CNC Machine Spindle Load & Cycle Time Tracker.
+//
+// Turns the high-rate cycle-state samples produced by the Modbus pool into a
+// per-shift OEE record: availability, performance and quality, a cycle-time
+// histogram, micro-stop accounting and a per-operator breakdown. Everything
+// here is plain arithmetic on caller-supplied values — no Notecard, Modbus or
+// global-state access — so the .ino owns when samples and shift boundaries
+// are applied and the helper .cpp owns how the record is sent. Defining
+// OEE_HOST builds it without Arduino, for the check in sim/.
+//
+// Hardware: Arduino OPTA RS485 + Blues Wireless for OPTA
+// Blues docs: https://dev.blues.io
+
+#pragma once
+
+#ifdef OEE_HOST
+#include <stdint.h>
+#include <stdlib.h>
+#else
+#include <Arduino.h>
+#endif
+
+// ---------------------------------------------------------------------------
+// Compile-time defaults — overridable via Notehub environment variables.
+// ---------------------------------------------------------------------------
+// Shift start times, local wall-clock minutes after midnight. Override via the
+// `shift_starts` env var ("06:00,14:00,22:00").
+#define DEFAULT_SHIFT_STARTS         "06:00,14:00,22:00"
+#define OEE_MAX_SHIFTS               4
+// A non-running gap shorter than this is a micro-stop (a Performance loss —
+// part swap, chip clear, quick probe) rather than downtime (an Availability
+// loss). Override via `micro_stop_sec`.
+#define DEFAULT_MICRO_STOP_SEC       120
+// Operators tracked per machine per shift. Samples for a further operator ID
+// in the same shift are not attributed to any slot (logged to Serial).
+#define OEE_MAX_OPERATORS            4
+// Cycle-time histogram bins, as a percentage of the ideal cycle time. N edges
+// give N+1 bins: <50, 50–80, 80–95, 95–105, 105–120, 120–150, 150–200, ≥200 %.
+#define OEE_HIST_BINS                8
+// Sentinel for ratios that are undefined in a shift (no run time, no parts).
+// Matches the SUMMARY_INVALID_SENTINEL convention used across Blues designs.
+#define OEE_SENTINEL                 -9999.0f
+// Each sample credits the time since the machine's previous sample, capped at
+// this many poll periods. The gap covers a loop() pass held up by Notecard
+// I/O; anything longer is an observation gap (timeouts, a dropped
+// connection) and is not booked as run or stop time.
+#define OEE_MAX_GAP_POLLS            8
+
+// ---------------------------------------------------------------------------
+// Data structures
+// ---------------------------------------------------------------------------
+struct OeeOperator {
+    bool     used;
+    uint16_t id;
+    uint32_t runMs;
+    uint32_t cycles;             // cycle-count register delta while logged in
+};
+
+// OeeStats: one machine's counters for the current shift. Zeroed at every
+// shift boundary (resetWindow()).
+struct OeeStats {
+    uint32_t runMs;              // time in cycleState == 1
+    uint32_t downMs;             // stops at or beyond the micro-stop threshold
+    uint32_t microStopMs;        // stops shorter than the micro-stop threshold
+    uint32_t alarmMs;            // time in cycleState == 3 (subset of stop time)
+    uint16_t microStops;
+    uint16_t stops;              // stops that crossed the micro-stop threshold
+    uint32_t scrap;              // rejected parts reported via cnc_quality.qi
+    uint16_t hist[OEE_HIST_BINS];
+    OeeOperator ops[OEE_MAX_OPERATORS];
+};
+
+// OeeTracker: the open stop, if any. Persists across shift boundaries so a
+// stop spanning a shift change is classified once, by its full length.
+struct OeeTracker {
+    uint32_t stopAccumMs;        // length so far of a stop still under threshold
+    bool     stopIsLong;         // stop has crossed the threshold — accrue to downMs
+};
+
+struct OeeRatios {
+    float availability;          // operating / planned
+    float performance;           // ideal × count / operating
+    float quality;               // (count − scrap) / count
+    float oee;                   // product; sentinel if any factor is undefined
+};
+
+// ---------------------------------------------------------------------------
+// Function prototypes
+// ---------------------------------------------------------------------------
+// Milliseconds a sample received at nowMs credits: the time since the
+// machine's previous sample at lastMs, capped at OEE_MAX_GAP_POLLS poll
+// periods. The first sample (haveLast false) credits one poll period.
+uint32_t oeeSampleDt(uint32_t nowMs, uint32_t lastMs, bool haveLast, uint32_t sampleMs);
+// Credit dtMs of observed machine state. On a stop → run transition the open
+// stop is closed as a micro-stop if it never crossed microStopMs.
+void oeeAccrue(OeeStats &o, OeeTracker &t, bool running, bool alarm,
+               uint32_t dtMs, uint32_t microStopMs);
+// Record one edge-timed cycle in the histogram.
+void oeeCycleCompleted(OeeStats &o, uint32_t cycleMs, uint32_t idealCycleMs);
+// Attribute run time and counted parts to an operator slot.
+void oeeAttribute(OeeStats &o, uint16_t operatorId, uint32_t runMs, uint32_t cycles);
+// Availability × Performance × Quality from the shift counters. cycleCount is
+// the controller's register delta for the shift (WindowStats).
+OeeRatios oeeCompute(const OeeStats &o, uint32_t cycleCount, uint32_t idealCycleMs);
+
+// Parse "HH:MM[,HH:MM...]" into sorted minutes-after-midnight. Returns the
+// number of starts, or 0 if the list is malformed or has more than
+// OEE_MAX_SHIFTS entries.
+uint8_t oeeParseShiftStarts(const char *list, uint16_t *startsMin);
+// UTC epoch of the start of the shift containing epochUtc, given the local
+// UTC offset and the sorted shift starts.
+uint32_t oeeShiftStart(uint32_t epochUtc, int32_t utcOffsetMin,
+                       const uint16_t *startsMin, uint8_t count);
@@ -0,0 +1,368 @@
+// modbus_pool_check.cpp — host check for the Modbus TCP pool core.
+//
+// Runs the firmware's MBAP encoding, framing and reply matching
+// (cnc_spindle_tracker_modbus.h) against a fake gateway socket that fronts
+// several controllers by unit ID on one TCP connection, the case the pool
+// exists for.  The driver below does what modbusService() does each loop()
+// pass — poll on a fixed grid, drain the socket, expire old requests — with
+// the EthernetClient swapped for the fake.  The gateway answers each unit
+// after its own latency and hands bytes back in random-sized chunks, so
+// replies are split across reads, coalesced into one read and returned out
+// of order.  Cases:
+//   framing     — request bytes match the spec, split and coalesced frames
+//                 are reassembled, an illegal MBAP length is reported as lost
+//   matching    — replies from several units on one socket, in any order, land
+//                 on the machine that sent the transaction ID
+//   stale       — a reply overtaken by a newer one for the same machine is
+//                 discarded instead of stepping the edge detector backwards
+//   timeouts    — a silent unit's requests expire, a late reply is ignored,
+//                 and its in-flight budget filling up skips only its own polls
+//   headers     — foreign protocol ID and wrong unit ID are rejected without
+//                 freeing the slot; exception and short replies free it
+// Exits 1 on any failure.
+//
+// Build and run from this directory:
+//   g++ -O2 -std=c++11 -I../firmware/cnc_spindle_tracker modbus_pool_check.cpp -o modbus_pool_check
+//   ./modbus_pool_check
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cnc_spindle_tracker_modbus.h"
+
+static int failures = 0;
+
+static void check(bool ok, const char *what)
+{
+    if (!ok) {
+        printf("FAIL: %s\n", what);
+        failures++;
+    }
+}
+
+// Deterministic chunk sizes and latencies.
+static uint32_t rngState = 12345;
+static uint32_t rng()
+{
+    rngState = rngState * 1103515245u + 12345u;
+    return (rngState >> 16) & 0x7FFF;
+}
+
+// ─── Fake gateway socket ─────────────────────────────────────────────────────
+// One TCP connection to a Modbus gateway.  write() takes request ADUs; each
+// is answered after the latency its unit ID returns, with the register block
+// {unit, seq, 0, 1, seq, unit} so a reply can be traced to its request.
+// read() hands back what is due, at most a random chunk at a time.
+#define MAX_PENDING 64
+
+struct PendingReply {
+    uint32_t dueMs;
+    uint8_t  adu[9 + 2 * MODBUS_REG_BLOCK_QTY];
+    uint16_t len;
+};
+
+struct FakeGateway {
+    uint32_t (*latencyMs)(uint8_t unit, uint16_t nth);
+    PendingReply pending[MAX_PENDING];
+    uint8_t      pendingCount;
+    uint16_t     requests[256];          // per unit, requests seen
+    uint8_t      out[4096];              // due bytes not yet read
+    uint16_t     outLen;
+
+    void write(const uint8_t *adu, uint16_t len, uint32_t nowMs)
+    {
+        check(len == MODBUS_READ_REQ_LEN, "request ADU is 12 bytes");
+        const uint8_t unit = adu[6];
+        const uint16_t nth = requests[unit]++;
+        const uint32_t lat = latencyMs(unit, nth);
+        if (lat == 0 || pendingCount == MAX_PENDING) return;   // silent unit
+
+        PendingReply &r = pending[pendingCount++];
+        r.dueMs = nowMs + lat;
+        memcpy(r.adu, adu, 7);           // echo tid, protocol and unit
+        r.adu[4] = 0;
+        r.adu[5] = 3 + 2 * MODBUS_REG_BLOCK_QTY;
+        r.adu[7] = MODBUS_FC_READ_HOLDING;
+        r.adu[8] = 2 * MODBUS_REG_BLOCK_QTY;
+        const uint16_t reg[MODBUS_REG_BLOCK_QTY] = { unit, nth, 0, 1, nth, unit };
+        for (uint8_t i = 0; i < MODBUS_REG_BLOCK_QTY; i++) {
+            r.adu[9 + 2 * i]  = (uint8_t)(reg[i] >> 8);
+            r.adu[10 + 2 * i] = (uint8_t)reg[i];
+        }
+        r.len = sizeof(r.adu);
+    }
+
+    // Move replies that are due onto the wire, earliest first.
+    void pump(uint32_t nowMs)
+    {
+        for (;;) {
+            int best = -1;
+            for (uint8_t i = 0; i < pendingCount; i++) {
+                if ((int32_t)(nowMs - pending[i].dueMs) < 0) continue;
+                if (best < 0 || (int32_t)(pending[i].dueMs - pending[best].dueMs) < 0) best = i;
+            }
+            if (best < 0) return;
+            memcpy(&out[outLen], pending[best].adu, pending[best].len);
+            outLen += pending[best].len;
+            pending[best] = pending[--pendingCount];
+        }
+    }
+
+    int read(uint8_t *buf, uint16_t space)
+    {
+        uint16_t n = 1 + rng() % 40;
+        if (n > outLen) n = outLen;
+        if (n > space) n = space;
+        memcpy(buf, out, n);
+        memmove(out, &out[n], outLen - n);
+        outLen -= n;
+        return n;
+    }
+};
+
+// ─── Pool driver ─────────────────────────────────────────────────────────────
+// The socket-facing half of cnc_spindle_tracker_helpers.cpp, minus Serial
+// and Notecard calls.  Every machine sits on connection 0.
+#define MACHINES  4
+#define POLL_MS   250     // poll_ms; fast enough that a slow unit fills its budget
+
+struct MachineStats {
+    uint32_t sent, ok, stale, expired, skipped;
+    uint16_t lastSeq;         // reg[1] of the last reply applied
+    bool     backwards;
+};
+
+struct Pool {
+    FakeGateway *gw;
+    ModbusPoll   polls[MACHINES];
+    uint32_t     nextPollMs[MACHINES];
+    uint8_t      rx[MODBUS_RX_BUF_SIZE];
+    uint16_t     rxLen;
+    uint16_t     nextTid;
+    uint32_t     unmatched;
+    bool         framingLost;
+    MachineStats st[MACHINES];
+
+    void begin(FakeGateway *g, const uint8_t *units, uint32_t nowMs)
+    {
+        memset(this, 0, sizeof(*this));
+        gw      = g;
+        nextTid = 1;
+        for (uint8_t m = 0; m < MACHINES; m++) {
+            modbusPollInit(polls[m], 0, units[m]);
+            nextPollMs[m] = nowMs + (POLL_MS * m) / MACHINES;
+        }
+    }
+
+    void handleFrame(const uint8_t *f, uint16_t len)
+    {
+        ModbusDecoded d;
+        const ModbusReply rc = modbusMatchReply(polls, MACHINES, 0, f, len, d);
+        if (rc == MODBUS_REPLY_UNMATCHED) { unmatched++; return; }
+        if (rc == MODBUS_REPLY_STALE) { st[d.machine].stale++; return; }
+        if (rc != MODBUS_REPLY_OK) return;
+        MachineStats &s = st[d.machine];
+        check(d.reg[0] == polls[d.machine].unitId, "reply credited to the machine that polled its unit");
+        if (s.ok > 0 && (int16_t)(d.reg[1] - s.lastSeq) <= 0) s.backwards = true;
+        s.lastSeq = d.reg[1];
+        s.ok++;
+    }
+
+    void service(uint32_t nowMs)
+    {
+        gw->pump(nowMs);
+        while (gw->outLen > 0) {
+            rxLen += (uint16_t)gw->read(&rx[rxLen], sizeof(rx) - rxLen);
+            for (;;) {
+                const int frameLen = modbusFrameLen(rx, rxLen);
+                if (frameLen < 0) { framingLost = true; return; }
+                if (frameLen == 0) break;
+                handleFrame(rx, (uint16_t)frameLen);
+                memmove(rx, &rx[frameLen], rxLen - frameLen);
+                rxLen -= frameLen;
+            }
+        }
+        for (uint8_t m = 0; m < MACHINES; m++) {
+            st[m].expired += modbusPollExpire(polls[m], nowMs);
+        }
+        for (uint8_t m = 0; m < MACHINES; m++) {
+            if ((int32_t)(nowMs - nextPollMs[m]) < 0) continue;
+            nextPollMs[m] += POLL_MS;
+            ModbusInFlight *slot = modbusSlotFree(polls[m]);
+            if (slot == NULL) { st[m].skipped++; continue; }
+            if (nextTid == 0) nextTid = 1;
+            const uint16_t tid = nextTid++;
+            uint8_t adu[MODBUS_READ_REQ_LEN];
+            modbusEncodeRead(adu, tid, polls[m].unitId, 256);
+            gw->write(adu, sizeof(adu), nowMs);
+            modbusSlotArm(polls[m], slot, tid, nowMs);
+            st[m].sent++;
+        }
+    }
+};
+
+// ─── Framing ─────────────────────────────────────────────────────────────────
+static void checkFraming()
+{
+    uint8_t adu[MODBUS_READ_REQ_LEN];
+    modbusEncodeRead(adu, 0x1234, 7, 0x0100);
+    const uint8_t want[MODBUS_READ_REQ_LEN] = {
+        0x12, 0x34, 0x00, 0x00, 0x00, 0x06, 0x07, 0x03, 0x01, 0x00, 0x00, 0x06
+    };
+    check(memcmp(adu, want, sizeof(want)) == 0, "read request encodes per the MBAP spec");
+
+    // A 21-byte reply needs every byte before it counts as a frame.
+    uint8_t f[21] = { 0x00, 0x01, 0x00, 0x00, 0x00, 0x0F, 0x01, 0x03, 0x0C };
+    bool early = false;
+    for (uint16_t n = 0; n < sizeof(f); n++) {
+        if (modbusFrameLen(f, n) != 0) early = true;
+    }
+    check(!early, "partial frame waits for more bytes");
+    check(modbusFrameLen(f, sizeof(f)) == 21, "complete frame length from MBAP header");
+
+    // Two frames in one read: the first is reported, the rest stays buffered.
+    uint8_t two[42];
+    memcpy(two, f, 21);
+    memcpy(&two[21], f, 21);
+    check(modbusFrameLen(two, sizeof(two)) == 21, "coalesced frames split at the first");
+
+    uint8_t bad[7] = { 0x00, 0x01, 0x00, 0x00, 0x01, 0x00, 0x01 };   // length 256
+    check(modbusFrameLen(bad, sizeof(bad)) < 0, "oversized MBAP length loses framing");
+    bad[4] = 0; bad[5] = 1;
+    check(modbusFrameLen(bad, sizeof(bad)) < 0, "undersized MBAP length loses framing");
+}
+
+// ─── Header checks ───────────────────────────────────────────────────────────
+static void buildReply(uint8_t *f, uint16_t tid, uint8_t unit)
+{
+    memset(f, 0, 21);
+    f[0] = (uint8_t)(tid >> 8); f[1] = (uint8_t)tid;
+    f[5] = 15; f[6] = unit; f[7] = MODBUS_FC_READ_HOLDING; f[8] = 12;
+}
+
+static void checkHeaders()
+{
+    ModbusPoll polls[2];
+    modbusPollInit(polls[0], 0, 1);
+    modbusPollInit(polls[1], 0, 2);
+    ModbusInFlight *s0 = modbusSlotFree(polls[0]);
+    modbusSlotArm(polls[0], s0, 10, 0);
+    ModbusInFlight *s1 = modbusSlotFree(polls[1]);
+    modbusSlotArm(polls[1], s1, 11, 0);
+
+    uint8_t f[21];
+    ModbusDecoded d;
+
+    buildReply(f, 10, 1);
+    f[3] = 0x01;
+    check(modbusMatchReply(polls, 2, 0, f, 21, d) == MODBUS_REPLY_PROTOCOL && s0->used,
+          "foreign protocol ID rejected, slot kept");
+
+    buildReply(f, 10, 2);
+    check(modbusMatchReply(polls, 2, 0, f, 21, d) == MODBUS_REPLY_UNIT && s0->used && s1->used,
+          "reply from another unit rejected, both slots kept");
+
+    buildReply(f, 10, 1);
+    check(modbusMatchReply(polls, 2, 1, f, 21, d) == MODBUS_REPLY_UNMATCHED && s0->used,
+          "tid from another connection unmatched");
+
+    buildReply(f, 10, 1);
+    check(modbusMatchReply(polls, 2, 0, f, 21, d) == MODBUS_REPLY_OK && d.machine == 0 && !s0->used,
+          "matching reply accepted and slot freed");
+
+    buildReply(f, 11, 2);
+    f[5] = 3; f[7] = 0x83; f[8] = 0x02;
+    check(modbusMatchReply(polls, 2, 0, f, 9, d) == MODBUS_REPLY_EXCEPTION && d.exCode == 2 && !s1->used,
+          "exception reply frees its slot");
+
+    modbusSlotArm(polls[1], s1, 12, 0);
+    buildReply(f, 12, 2);
+    f[5] = 9; f[8] = 6;
+    check(modbusMatchReply(polls, 2, 0, f, 15, d) == MODBUS_REPLY_SHORT && !s1->used,
+          "short register block discarded");
+
+    // A zeroed slot must not match tid 0.
+    buildReply(f, 0, 1);
+    check(modbusMatchReply(polls, 2, 0, f, 21, d) == MODBUS_REPLY_UNMATCHED, "free slots never match");
+}
+
+// ─── Gateway scenarios ───────────────────────────────────────────────────────
+// Unit 1 answers quickly; unit 2 at varying speed, so some replies overtake
+// the one before; unit 3 within the timeout but more slowly than two poll
+// periods, so its budget fills; unit 4 never answers.
+static uint32_t cellLatency(uint8_t unit, uint16_t nth)
+{
+    switch (unit) {
+    case 1:  return 5 + rng() % 40;
+    case 2:  return (nth % 4 == 0) ? 700 : 40 + rng() % 60;
+    case 3:  return 400 + rng() % 500;
+    default: return 0;
+    }
+}
+
+static void checkGateway()
+{
+    static FakeGateway gw;
+    memset(&gw, 0, sizeof(gw));
+    gw.latencyMs = cellLatency;
+
+    static Pool pool;
+    const uint8_t units[MACHINES] = { 1, 2, 3, 4 };
+    pool.begin(&gw, units, 0);
+
+    const uint32_t runMs = 10UL * 60 * 1000;
+    for (uint32_t t = 0; t <= runMs; t += 5) pool.service(t);
+
+    printf("%-7s %-5s %6s %6s %6s %7s %7s\n", "machine", "unit", "sent", "ok", "stale", "expired", "skipped");
+    for (uint8_t m = 0; m < MACHINES; m++) {
+        const MachineStats &s = pool.st[m];
+        printf("%-7u %-5u %6u %6u %6u %7u %7u\n", (unsigned)m, (unsigned)units[m],
+               (unsigned)s.sent, (unsigned)s.ok, (unsigned)s.stale,
+               (unsigned)s.expired, (unsigned)s.skipped);
+    }
+    printf("late replies ignored: %u\n\n", (unsigned)pool.unmatched);
+
+    const uint32_t polls = runMs / POLL_MS;
+    const MachineStats *s = pool.st;
+    check(!pool.framingLost, "framing held across random chunking");
+    check(s[0].skipped == 0 && s[0].expired == 0 && s[0].ok + 1 >= polls,
+          "fast unit answers every poll");
+    check(s[1].stale > 0, "overtaken replies are seen as stale");
+    check(s[1].skipped == 0 && s[1].ok + s[1].stale + 2 >= s[1].sent,
+          "varying unit loses only stale replies");
+    check(s[2].ok > 0 && s[2].skipped > 0, "slow unit fills its own budget");
+    check(s[3].ok == 0 && s[3].skipped > 0 && s[3].expired + MODBUS_MAX_INFLIGHT >= s[3].sent,
+          "silent unit's requests all expire");
+    bool backwards = false;
+    for (uint8_t m = 0; m < MACHINES; m++) backwards |= s[m].backwards;
+    check(!backwards, "no machine applies a reply older than one already applied");
+    check(s[0].sent + 1 >= polls && s[1].sent + 1 >= polls,
+          "a stalled neighbour does not cost other units their polls");
+
+    // Late replies to expired requests: a unit slower than the timeout.
+    static FakeGateway late;
+    memset(&late, 0, sizeof(late));
+    late.latencyMs = [](uint8_t unit, uint16_t) -> uint32_t {
+        return unit == 1 ? MODBUS_RESPONSE_TIMEOUT_MS + 200 : 20;
+    };
+    pool.begin(&late, units, 0);
+    for (uint32_t t = 0; t <= 60000; t += 5) pool.service(t);
+    check(pool.st[0].ok == 0 && pool.st[0].expired > 0 && pool.unmatched > 0,
+          "replies after the timeout are ignored");
+    check(pool.st[1].ok + 1 >= 60000 / POLL_MS, "timeouts on one unit leave the others untouched");
+}
+
+int main()
+{
+    checkFraming();
+    checkHeaders();
+    checkGateway();
+
+    if (failures) {
+        printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("All checks passed.\n");
+    return 0;
+}
@@ -0,0 +1,298 @@
+// oee_check.cpp — host check for the on-device OEE engine.
+//
+// Builds cnc_spindle_tracker_oee.cpp without Arduino (OEE_HOST) and replays
+// the cases the shift record depends on:
+//   shift list   — "HH:MM" lists parse sorted, malformed or oversized lists
+//                  are rejected
+//   shift start  — the shift containing a UTC epoch, for offsets either side
+//                  of UTC, on a boundary, and before the first start of the
+//                  local day (wraps to the previous day's last shift)
+//   accrual      — stops under micro_stop_sec are micro-stops, longer ones
+//                  are downtime from their start, and a stop spanning a shift
+//                  change is classified once
+//   sample time  — crediting the measured time between samples keeps run
+//                  time whole across loop() passes held up by Notecard I/O,
+//                  where one poll period per sample loses it, and an outage
+//                  credits only OEE_MAX_GAP_POLLS poll periods
+//   ratios       — A × P × Q, sentinels when a factor has no basis, scrap
+//                  above the count clamps Quality at 0
+// Exits 1 on any failure.
+//
+// Build and run from this directory:
+//   g++ -O2 -std=c++11 -DOEE_HOST -I../firmware/cnc_spindle_tracker oee_check.cpp ../firmware/cnc_spindle_tracker/cnc_spindle_tracker_oee.cpp -o oee_check
+//   ./oee_check
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "cnc_spindle_tracker_oee.h"
+
+static int failures = 0;
+
+static void check(bool ok, const char *what)
+{
+    if (!ok) {
+        printf("FAIL: %s\n", what);
+        failures++;
+    }
+}
+
+static bool near(float a, float b)
+{
+    return fabsf(a - b) < 1e-4f;
+}
+
+// ─── Shift list ──────────────────────────────────────────────────────────────
+static void checkParse()
+{
+    uint16_t s[OEE_MAX_SHIFTS];
+    check(oeeParseShiftStarts("06:00,14:00,22:00", s) == 3 &&
+          s[0] == 360 && s[1] == 840 && s[2] == 1320, "default list");
+    check(oeeParseShiftStarts("22:00, 6:30 ,14:00", s) == 3 &&
+          s[0] == 390 && s[1] == 840 && s[2] == 1320, "unsorted list with spaces is sorted");
+    check(oeeParseShiftStarts("07:00", s) == 1 && s[0] == 420, "single shift");
+    check(oeeParseShiftStarts("24:00", s) == 0, "hour out of range");
+    check(oeeParseShiftStarts("06:60", s) == 0, "minute out of range");
+    check(oeeParseShiftStarts("06-00", s) == 0, "missing colon");
+    check(oeeParseShiftStarts("06:00x", s) == 0, "trailing junk");
+    check(oeeParseShiftStarts("00:00,06:00,12:00,18:00,21:00", s) == 0, "more than OEE_MAX_SHIFTS");
+    check(oeeParseShiftStarts("", s) == 0, "empty list");
+}
+
+// ─── Shift start ─────────────────────────────────────────────────────────────
+struct ShiftCase {
+    const char *what;
+    int32_t     utcOffsetMin;
+    int32_t     localMin;       // local wall clock on the reference day
+    int32_t     expectMin;      // expected shift start, same scale (may be < 0)
+};
+
+static void checkShiftStart()
+{
+    // 2026-10-19 00:00 UTC; each case is placed relative to local midnight
+    // of that date, so the UTC date differs from the local one in several.
+    const uint32_t day = 1792368000;
+    uint16_t starts[OEE_MAX_SHIFTS];
+    const uint8_t n = oeeParseShiftStarts("06:00,14:00,22:00", starts);
+
+    const ShiftCase cases[] = {
+        { "UTC-5 07:00 -> 06:00",                   -300,        7 * 60,   6 * 60 },
+        { "UTC-5 on the 14:00 boundary",            -300,       14 * 60,  14 * 60 },
+        { "UTC-5 21:59 -> 14:00",                   -300,  21 * 60 + 59,  14 * 60 },
+        { "UTC-5 23:30 -> 22:00 (UTC next day)",    -300,  23 * 60 + 30,  22 * 60 },
+        { "UTC-5 03:00 -> previous day 22:00",      -300,        3 * 60,  -2 * 60 },
+        { "UTC+5:30 05:59 -> previous day 22:00",    330,   5 * 60 + 59,  -2 * 60 },
+        { "UTC+5:30 00:00 -> previous day 22:00",    330,             0,  -2 * 60 },
+        { "UTC 22:00 boundary",                        0,       22 * 60,  22 * 60 },
+    };
+
+    printf("%-38s %12s %12s\n", "shift start", "expected", "got");
+    for (unsigned i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        const ShiftCase &c = cases[i];
+        const int64_t  localMidnightUtc = (int64_t)day - (int64_t)c.utcOffsetMin * 60;
+        const uint32_t epoch  = (uint32_t)(localMidnightUtc + (int64_t)c.localMin * 60);
+        const uint32_t expect = (uint32_t)(localMidnightUtc + (int64_t)c.expectMin * 60);
+        const uint32_t got    = oeeShiftStart(epoch, c.utcOffsetMin, starts, n);
+        printf("%-38s %12u %12u\n", c.what, (unsigned)expect, (unsigned)got);
+        check(got == expect, c.what);
+    }
+
+    const uint8_t one = oeeParseShiftStarts("07:00", starts);
+    const uint32_t e  = day + 6 * 3600;
+    check(oeeShiftStart(e, 0, starts, one) == day - 17 * 3600,
+          "single shift before its start wraps to yesterday");
+    check(oeeShiftStart(day + 7 * 3600, 0, starts, one) == day + 7 * 3600,
+          "single shift on its start");
+    printf("\n");
+}
+
+// ─── Accrual ─────────────────────────────────────────────────────────────────
+static void feed(OeeStats &o, OeeTracker &t, bool running, bool alarm,
+                 uint32_t ms, uint32_t stepMs, uint32_t microStopMs)
+{
+    for (uint32_t done = 0; done < ms; done += stepMs) {
+        oeeAccrue(o, t, running, alarm, stepMs, microStopMs);
+    }
+}
+
+static void checkAccrue()
+{
+    const uint32_t micro = 120000;
+    OeeStats   o;
+    OeeTracker t;
+    memset(&o, 0, sizeof(o));
+    memset(&t, 0, sizeof(t));
+
+    feed(o, t, true,  false, 600000, 500, micro);   // 10 min run
+    feed(o, t, false, false,  60000, 500, micro);   // 1 min part swap
+    feed(o, t, true,  false, 600000, 500, micro);
+    feed(o, t, false, true,  300000, 500, micro);   // 5 min alarm stop
+    feed(o, t, true,  false,    500, 500, micro);
+    check(o.runMs == 1200500, "run time");
+    check(o.microStops == 1 && o.microStopMs == 60000, "short stop is a micro-stop");
+    check(o.stops == 1 && o.downMs == 300000, "long stop is downtime from its start");
+    check(o.alarmMs == 300000, "alarm time");
+
+    // A 3 min stop starting 1 min before a shift change: the first shift
+    // sees stop time still under threshold; the second books all 3 min.
+    memset(&o, 0, sizeof(o));
+    feed(o, t, false, false, 60000, 500, micro);
+    check(o.downMs == 0 && o.microStopMs == 0, "open stop not booked before the boundary");
+    memset(&o, 0, sizeof(o));                       // resetWindow(): tracker kept
+    feed(o, t, false, false, 120000, 500, micro);
+    feed(o, t, true,  false,    500, 500, micro);
+    check(o.stops == 1 && o.downMs == 180000 && o.microStops == 0,
+          "stop spanning a shift change is classified once, by its full length");
+}
+
+// ─── Sample time ─────────────────────────────────────────────────────────────
+// One machine polled every sampleMs from a loop() that runs every 5 ms but
+// blocks for stallMs once per stallEveryMs (env.get, note.add, card.time).
+// Polls are only sent and replies only stamped while loop() runs, as in
+// modbusService(); a stalled poll is sent on the first pass after the stall.
+// The machine is running throughout, so run time should equal the time
+// observed since the first sample.
+static uint32_t replay(uint32_t sampleMs, uint32_t stallMs, uint32_t stallEveryMs,
+                       uint32_t silentFrom, uint32_t silentTo, bool measured,
+                       uint32_t *observedMs, uint32_t *samples)
+{
+    const uint32_t durationMs = 3600000, latencyMs = 20, passMs = 5;
+    OeeStats   o;
+    OeeTracker t;
+    memset(&o, 0, sizeof(o));
+    memset(&t, 0, sizeof(t));
+
+    uint32_t nextPoll = 0, replyAt = 0, first = 0, last = 0, n = 0;
+    bool     pending = false, haveLast = false;
+    for (uint32_t now = 0; now < durationMs; now += passMs) {
+        if (stallEveryMs && now % stallEveryMs == 0 && now > 0) {
+            now += stallMs;                          // loop() blocked on the Notecard
+        }
+        if (pending && now >= replyAt) {
+            pending = false;
+            const uint32_t dt = measured ? oeeSampleDt(now, last, haveLast, sampleMs) : sampleMs;
+            if (!haveLast) first = now;
+            last     = now;
+            haveLast = true;
+            oeeAccrue(o, t, true, false, dt, 120000);
+            n++;
+        }
+        if (now >= nextPoll) {
+            nextPoll += sampleMs;
+            if ((int32_t)(now - nextPoll) >= 0) nextPoll = now + sampleMs;
+            if (!(now >= silentFrom && now < silentTo)) {
+                pending = true;
+                replyAt = now + latencyMs;
+            }
+        }
+    }
+    *observedMs = last - first + sampleMs;
+    *samples    = n;
+    return o.runMs;
+}
+
+static void checkSampleTime()
+{
+    check(oeeSampleDt(12345, 0, false, 500) == 500, "first sample credits one poll period");
+    check(oeeSampleDt(10480, 10000, true, 500) == 480, "measured delta");
+    check(oeeSampleDt(10000, 10000, true, 500) == 0, "coalesced sample credits nothing more");
+    check(oeeSampleDt(5, 0xFFFFFFF0u, true, 500) == 21, "millis() wrap");
+    check(oeeSampleDt(70000, 10000, true, 500) == 500 * OEE_MAX_GAP_POLLS, "gap is capped");
+
+    printf("%-34s %10s %10s %10s %8s\n", "replay (1 h running)", "samples", "observed", "run_min", "error");
+    struct Case {
+        const char *what;
+        uint32_t    stallMs, stallEveryMs, silentFrom, silentTo;
+        bool        measured;
+    } cases[] = {
+        { "no stalls, fixed period",         0,     0, 0, 0, false },
+        { "no stalls, measured",             0,     0, 0, 0, true  },
+        { "2.5 s stall / min, fixed period", 2500, 60000, 0, 0, false },
+        { "2.5 s stall / min, measured",     2500, 60000, 0, 0, true  },
+    };
+    for (unsigned i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        const Case &c = cases[i];
+        uint32_t observed, n;
+        const uint32_t run = replay(500, c.stallMs, c.stallEveryMs, c.silentFrom, c.silentTo,
+                                    c.measured, &observed, &n);
+        const double err = 100.0 * ((double)run - observed) / observed;
+        printf("%-34s %10u %10.2f %10.2f %7.2f%%\n", c.what, (unsigned)n,
+               observed / 60000.0, run / 60000.0, err);
+        if (c.measured) {
+            check(run <= observed && observed - run <= 500,
+                  "measured credit covers the observed time");
+        } else if (c.stallMs) {
+            check(run + 60000 < observed, "fixed credit loses stalled time (regression reference)");
+        }
+    }
+
+    // 10 min with no replies (controller off the network): only the cap is
+    // credited across the outage.
+    uint32_t observed, n;
+    const uint32_t run = replay(500, 0, 0, 1200000, 1800000, true, &observed, &n);
+    printf("%-34s %10u %10.2f %10.2f\n\n", "10 min outage, measured", (unsigned)n,
+           observed / 60000.0, run / 60000.0);
+    const uint32_t outageMs = 1800000 - 1200000;
+    check(observed - run >= outageMs - 500 * OEE_MAX_GAP_POLLS - 500 &&
+          observed - run <= outageMs, "outage credits only the cap");
+}
+
+// ─── Ratios ──────────────────────────────────────────────────────────────────
+static void checkCompute()
+{
+    OeeStats o;
+    memset(&o, 0, sizeof(o));
+
+    OeeRatios r = oeeCompute(o, 0, 120000);
+    check(r.availability == OEE_SENTINEL && r.performance == OEE_SENTINEL &&
+          r.quality == OEE_SENTINEL && r.oee == OEE_SENTINEL, "empty shift is all sentinels");
+
+    // 8 h planned: 6 h run, 30 min micro-stops, 90 min down; 180 parts at a
+    // 2 min ideal cycle, 9 scrapped.
+    o.runMs       = 6 * 3600000u;
+    o.microStopMs = 30 * 60000u;
+    o.downMs      = 90 * 60000u;
+    o.scrap       = 9;
+    r = oeeCompute(o, 180, 120000);
+    printf("%-22s %8s %8s %8s %8s\n", "oeeCompute", "A", "P", "Q", "OEE");
+    printf("%-22s %8.4f %8.4f %8.4f %8.4f\n", "  8 h shift", r.availability,
+           r.performance, r.quality, r.oee);
+    check(near(r.availability, 390.0f / 480.0f), "availability");
+    check(near(r.performance, 360.0f / 390.0f), "performance");
+    check(near(r.quality, 171.0f / 180.0f), "quality");
+    check(near(r.oee, r.availability * r.performance * r.quality), "oee is A × P × Q");
+
+    r = oeeCompute(o, 0, 120000);
+    check(r.availability != OEE_SENTINEL && r.quality == OEE_SENTINEL &&
+          r.oee == OEE_SENTINEL, "no parts: quality and oee are sentinels");
+    r = oeeCompute(o, 180, 0);
+    check(r.performance == OEE_SENTINEL && r.oee == OEE_SENTINEL,
+          "no ideal cycle: performance is a sentinel");
+    o.scrap = 500;
+    r = oeeCompute(o, 180, 120000);
+    check(r.quality == 0.0f && r.oee == 0.0f, "scrap above the count clamps quality at 0");
+
+    memset(&o, 0, sizeof(o));
+    o.downMs = 3600000;
+    r = oeeCompute(o, 0, 120000);
+    check(r.availability == 0.0f && r.performance == OEE_SENTINEL,
+          "all downtime: availability 0, performance undefined");
+    printf("\n");
+}
+
+int main()
+{
+    checkParse();
+    checkShiftStart();
+    checkAccrue();
+    checkSampleTime();
+    checkCompute();
+
+    if (failures) {
+        printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("All checks passed.\n");
+    return 0;
+}
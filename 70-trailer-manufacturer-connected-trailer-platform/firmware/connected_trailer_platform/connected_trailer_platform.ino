@@ -7,11 +7,21 @@
   tracking via the Notecard's built-in GNSS. Two additional channels are wired
   into the data pipeline as integration-point stubs pending the vendor
   engineering described in README §9: J2497 reefer telemetry (Serial1) and
-  TPMS tire pressure (SoftwareSerial D5/D6) — each parses a simplified POC
+  TPMS tire pressure (LPUART1) — each parses a simplified POC
   frame format that no production hardware produces. The trailer state machine
   drives the Notehub sync cadence.
 
-  Power model — dwell-capable host sleep:
+  Power model — always-on UART capture (default):
+    The host stays powered and dwells in Stop mode between sample cycles with
+    Serial1 (J2497) and tpmsSerial (TPMS, LPUART1) armed as wakeup sources.
+    Each incoming byte is buffered by the core's UART interrupt and the CPU
+    returns to Stop; the frame parsers run only when uartFrameReady() reports
+    a complete frame, and the full sample cycle runs every sampleIntervalSec
+    as measured by the RTC (millis() does not advance in Stop). No reefer or
+    TPMS frame is missed between samples. PersistState stays in RAM; the
+    Notecard sleep payload is still restored on a cold boot.
+
+  Power model — dwell-capable host sleep (-DHOST_POWER_CUT_SLEEP):
     The Notecard for Skylo controls host power via the ATTN line on the
     Notecarrier CX. After each sample cycle the host serialises PersistState
     into the Notecard and calls NotePayloadSaveAndSleep(), which issues
@@ -61,8 +71,11 @@
 ***************************************************************************/
 
 #include <Arduino.h>
-#include <SoftwareSerial.h>
 #include <Notecard.h>
+#ifndef HOST_POWER_CUT_SLEEP
+#include <STM32LowPower.h>
+#include <STM32RTC.h>
+#endif
 
 // Paste your Notehub ProductUID between the quotes below. Must be defined
 // before #include "trailer_sensors.h" so the header's #ifndef guard picks it up.
@@ -79,7 +92,7 @@
 // =========================================================================
 
 Notecard       notecard;
-SoftwareSerial tpmsSerial(PIN_TPMS_RX, PIN_TPMS_TX);
+HardwareSerial tpmsSerial(PIN_TPMS_RX, PIN_TPMS_TX);  // LPUART1
 Config         g_cfg;           // reset to compiled defaults at the start of
                                 // each fetchEnvOverrides() call; not persisted
 Sensors        g_sensors;       // freshly initialised (−9999 sentinels) each
@@ -102,9 +115,19 @@ static const char *kAlertNames[ALERT_COUNT] = {
 // only when nowEpoch == 0 (Notecard has not yet acquired a time lock).
 // The epoch-based values in g_ps (lastAlertEpoch[], doorOpenTransitStartEpoch)
 // are the primary cooldown mechanism and persist correctly across wakes.
+// In the always-on capture mode the host is not reset between samples, but
+// millis() is frozen while the core is in Stop, so these fallbacks only count
+// awake time there.
 static uint32_t g_lastAlertMs[ALERT_COUNT] = {};
 static uint32_t g_doorOpenTransitStartMs   = 0;
 
+#ifndef HOST_POWER_CUT_SLEEP
+// RTC (LSE-clocked, keeps running in Stop) provides the sample cadence while
+// the core dwells; g_nextSampleRtc is the RTC second the next cycle is due.
+static STM32RTC &g_rtc           = STM32RTC::getInstance();
+static uint32_t  g_nextSampleRtc = 0;
+#endif
+
 // =========================================================================
 // Utility helpers
 // =========================================================================
@@ -613,9 +636,16 @@ void setup() {
     for (uint32_t t0 = millis(); !usbSerial && (millis() - t0) < 3000; ) {}
 #endif
 
-    // Initialise hardware on every wakeup (peripherals are re-powered each time).
+    // Initialise hardware on every wakeup (peripherals are re-powered each time
+    // under HOST_POWER_CUT_SLEEP; once per power-on in capture mode).
     Serial1.begin(REEFER_BAUD);
     tpmsSerial.begin(TPMS_BAUD);
+#ifndef HOST_POWER_CUT_SLEEP
+    g_rtc.setClockSource(STM32RTC::LSE_CLOCK);
+    g_rtc.begin();
+    LowPower.begin();
+    setupUartCapture();
+#endif
     pinMode(PIN_DOOR, INPUT_PULLUP);
     analogReadResolution(12);
 
@@ -676,11 +706,13 @@ void setup() {
     for (int i = 0; i < NUM_TPMS_POS; i++)
         g_sensors.tpmsPsi[i] = g_ps.tpmsPsiLast[i];
 
+#ifdef HOST_POWER_CUT_SLEEP
     // Post-wakeup UART drain window. Both UART peripherals were offline while
     // the host was powered down; this window captures frames arriving in the
     // first WAKE_UART_DRAIN_MS milliseconds after Serial1 and tpmsSerial are
     // re-initialised. Additional drains run between Notecard I2C calls inside
     // runSampleCycle() to recover bytes arriving during blocking transactions.
+    // Not needed in capture mode: the UARTs never stop receiving.
     {
         uint32_t drainUntil = millis() + WAKE_UART_DRAIN_MS;
         while (millis() < drainUntil) {
@@ -688,6 +720,7 @@ void setup() {
             drainTpmsUart();
         }
     }
+#endif
 
     uint32_t nowEpoch = notecardEpoch();
     drainReeferUart(); drainTpmsUart();  // drain during card.time I2C call
@@ -698,8 +731,46 @@ void setup() {
         g_ps.summaryWindowStartEpoch = nowEpoch;
 
     runSampleCycle(nowEpoch);
+#ifndef HOST_POWER_CUT_SLEEP
+    g_nextSampleRtc = g_rtc.getEpoch() + g_cfg.sampleIntervalSec;
+#endif
 }
 
+#ifndef HOST_POWER_CUT_SLEEP
+// loop() — always-on capture mode. Dwells in Stop until the next sample is
+// due, waking fully only to parse complete UART frames, then runs one sample
+// cycle with the same env refresh and epoch handling setup() performs.
+void loop() {
+    for (;;) {
+        if (uartFrameReady()) {
+            drainReeferUart();
+            drainTpmsUart();
+        }
+        int32_t remaining = (int32_t)(g_nextSampleRtc - g_rtc.getEpoch());
+        if (remaining <= 0) break;
+        // Returns early on any UART byte (the interrupt has already buffered
+        // it); a partial frame simply re-enters Stop on the next iteration.
+        LowPower.deepSleep((uint32_t)remaining * 1000UL);
+    }
+
+    fetchEnvOverrides();
+    drainReeferUart(); drainTpmsUart();  // drain during env.get I2C call
+
+    uint32_t nowEpoch = notecardEpoch();
+    drainReeferUart(); drainTpmsUart();  // drain during card.time I2C call
+    if (g_ps.summaryWindowStartEpoch == 0 && nowEpoch != 0)
+        g_ps.summaryWindowStartEpoch = nowEpoch;
+
+    runSampleCycle(nowEpoch);
+    drainReeferUart(); drainTpmsUart();
+
+    // Schedule from the due time rather than "now" so the cadence does not
+    // drift by the length of each sample cycle; resync if a cycle overran.
+    g_nextSampleRtc += g_cfg.sampleIntervalSec;
+    if ((int32_t)(g_nextSampleRtc - g_rtc.getEpoch()) <= 0)
+        g_nextSampleRtc = g_rtc.getEpoch() + g_cfg.sampleIntervalSec;
+}
+#else
 // loop() runs once per wakeup: drains both UART channels a final time,
 // serialises PersistState into the Notecard, and calls NotePayloadSaveAndSleep()
 // to schedule the next wakeup and cut host power. If ATTN is not wired for
@@ -731,3 +802,4 @@ void loop() {
 #endif
     delay(g_cfg.sampleIntervalSec * 1000UL);
 }
+#endif
@@ -6,12 +6,13 @@
   All functions operate on globals declared extern in trailer_sensors.h and
   defined in connected_trailer_platform.ino.
 
-  Power model: the host is powered off between sample cycles via the Notecard's
-  ATTN signal. drainReeferUart() and drainTpmsUart() are called during the
-  WAKE_UART_DRAIN_MS window at the start of each wakeup and between blocking
-  Notecard I2C calls within the sample cycle. Bytes that arrive while the host
-  is off are lost; the drain window and inter-call drains capture bytes arriving
-  during the host-on period.
+  Power model: by default the host dwells in Stop mode between sample cycles
+  with both UARTs armed as wakeup sources (setupUartCapture()); the core's
+  UART interrupts buffer every byte and drainReeferUart() / drainTpmsUart()
+  run whenever uartFrameReady() reports a complete frame, plus between
+  blocking Notecard I2C calls within the sample cycle. Under
+  -DHOST_POWER_CUT_SLEEP the host is powered off between cycles instead and
+  the drains run during the WAKE_UART_DRAIN_MS window after each wakeup.
 
   J2497 state:
     drainReeferUart() sets g_ps.j2497Commissioned = true on the first accepted
@@ -26,6 +27,11 @@
 *******************************************************************************/
 #include "trailer_sensors.h"
 #include <math.h>   // logf
+#ifndef HOST_POWER_CUT_SLEEP
+#include <STM32LowPower.h>
+#include <stm32yyxx_ll_lpuart.h>
+#include <stm32yyxx_ll_rcc.h>
+#endif
 
 // =========================================================================
 // Door-edge interrupt state
@@ -52,6 +58,57 @@ void setupDoorInterrupt() {
     attachInterrupt(digitalPinToInterrupt(PIN_DOOR), doorISR, CHANGE);
 }
 
+// =========================================================================
+// Always-on UART capture
+// =========================================================================
+
+#ifndef HOST_POWER_CUT_SLEEP
+// Wakeup callback for both UARTs. Intentionally empty: the byte that caused
+// the wakeup has already been stored in the RX ring buffer by the core's UART
+// interrupt handler. The dwell loop in loop() decides whether the CPU stays
+// awake (complete frame or sample due) or returns to Stop.
+static void uartWakeCb() {}
+
+// Keep LPUART1 (TPMS) receiving in Stop mode. LowPower.enableWakeupFrom()
+// configures only the UART it is given, so nothing else sets UESM on this
+// one. Without it the LPUART stops with the core and TPMS bytes sent during
+// the dwell are lost. WUS = RXNE wakes the core on each received byte, which
+// the core's LPUART1 interrupt then stores in the RX ring buffer; WUS can only
+// be written with the LPUART disabled. The LPUART1 wakeup reaches the core on
+// EXTI direct line 31, which is unmasked out of reset. The kernel clock must
+// also run in Stop: the LSE does, and any other source is HSI16, which UCESM
+// keeps requested.
+static void armTpmsStopMode() {
+    LL_LPUART_Disable(LPUART1);
+    LL_LPUART_SetWKUPType(LPUART1, LL_LPUART_WAKEUP_ON_RXNE);
+    LL_LPUART_Enable(LPUART1);
+    if (LL_RCC_GetLPUARTClockSource(LL_RCC_LPUART1_CLKSOURCE) !=
+        LL_RCC_LPUART1_CLKSOURCE_LSE) {
+        LL_LPUART_EnableClockInStopMode(LPUART1);
+    }
+    LL_LPUART_EnableInStopMode(LPUART1);
+    LL_LPUART_EnableIT_WKUP(LPUART1);
+}
+
+// Arm Serial1 and tpmsSerial as Stop-mode wakeup sources. LowPower tracks a
+// single UART for its Stop-mode clock configuration, so it is given USART1
+// (J2497), which needs HSI16 requested on wakeup and therefore selects Stop 1.
+// LPUART1 (TPMS) is armed explicitly by armTpmsStopMode().
+void setupUartCapture() {
+    LowPower.enableWakeupFrom(&Serial1, uartWakeCb);
+    armTpmsStopMode();
+}
+#else
+void setupUartCapture() {}
+#endif
+
+// A partial frame stays buffered until its remaining bytes arrive; the parsers
+// only consume whole frames, so waking for less would just re-enter Stop.
+bool uartFrameReady() {
+    return Serial1.available() >= (int)REEFER_PKT_LEN ||
+           tpmsSerial.available() >= TPMS_FRAME_LEN;
+}
+
 // =========================================================================
 // J2497 PLC modem UART drain
 // =========================================================================
@@ -97,7 +154,7 @@ void drainReeferUart() {
 // TPMS receiver UART drain
 // =========================================================================
 
-// Drain the TPMS SoftwareSerial and update per-position pressure readings.
+// Drain the TPMS LPUART and update per-position pressure readings.
 // Called on every loop() iteration to collect packets as they arrive (typically
 // one per tire every 60–180 s). Valid frames reset the stale counter for that
 // position; the stale counter is incremented once per summary window in
@@ -6,17 +6,19 @@
   Keeping constants, structs, and enums here eliminates duplication and lets
   the Arduino build system compile the two translation units independently.
 
-  Power model: the host (Cygnet STM32L433 on Notecarrier CX) is powered off
-  between sample cycles via the Notecard's card.attn ATTN signal. setup() runs
-  on every wakeup; loop() serialises PersistState via NotePayloadSaveAndSleep()
-  and hands control back to the Notecard until the next scheduled wake.
-  PersistState carries all inter-sample context (accumulators, alert cooldowns,
-  door state, TPMS last-known pressures, summary window epoch) across the
-  host-off sleep interval.
+  Power model: by default the host (Cygnet STM32L433 on Notecarrier CX) stays
+  powered between sample cycles and dwells in Stop mode with both UARTs armed
+  as wakeup sources, so every J2497 and TPMS byte is captured into the UART RX
+  ring buffers while the CPU sleeps (see UART capture mode below). Building
+  with -DHOST_POWER_CUT_SLEEP restores the original model: the host is powered
+  off between sample cycles via the Notecard's card.attn ATTN signal, setup()
+  runs on every wakeup, and loop() serialises PersistState via
+  NotePayloadSaveAndSleep(). In either mode PersistState carries all
+  inter-sample context (accumulators, alert cooldowns, door state, TPMS
+  last-known pressures, summary window epoch).
 *******************************************************************************/
 #pragma once
 #include <Arduino.h>
-#include <SoftwareSerial.h>
 
 // ---- Product UID -------------------------------------------------------
 #ifndef PRODUCT_UID
@@ -30,19 +32,42 @@
 // ASCII characters, matching the pattern used by other Blues reference apps.
 #define STATE_SEG_ID "TRLR"
 
-// ---- Post-wakeup UART drain window (ms) --------------------------------
-// After hardware re-initialisation each wake, both UART channels are drained
-// for this many milliseconds before the sample cycle begins. At 9600 baud an
-// 8-byte J2497 frame takes ~8 ms; 250 ms accommodates ~3 complete frames and
-// several TPMS packets if a gateway is transmitting near the wake boundary.
+// ---- UART capture mode --------------------------------------------------
+// Default (HOST_POWER_CUT_SLEEP not defined): always-on capture. Between
+// sample cycles loop() calls LowPower.deepSleep() with both UARTs enabled as
+// Stop-mode wakeup sources:
+//   - TPMS on LPUART1, clocked from the 32.768 kHz LSE at 9600 baud and
+//     armed for Stop-mode reception (UESM, wakeup on RXNE) by
+//     setupUartCapture(), which keeps receiving in Stop 2;
+//   - J2497 on USART1, which requests HSI16 on a start bit and therefore
+//     limits the dwell to Stop 1 (a few µA more than Stop 2).
+// Each received byte is stored by the core's UART interrupt into the RX ring
+// buffer and the CPU goes straight back to Stop; the frame parsers and all
+// Notecard traffic only run when a complete frame is buffered or a sample is
+// due. STM32L4 DMA is not clocked in Stop modes, so interrupt-per-byte into
+// the core ring buffer is the lowest-power capture path the part supports.
+//
+// With -DHOST_POWER_CUT_SLEEP the legacy ATTN power-cut sleep is used: bytes
+// that arrive while the host is off are lost, and after each wake both UARTs
+// are drained for WAKE_UART_DRAIN_MS before the sample cycle begins. At 9600
+// baud an 8-byte J2497 frame takes ~8 ms; 250 ms accommodates ~3 complete
+// frames and several TPMS packets.
 #define WAKE_UART_DRAIN_MS  250u
 
 // ---- Pin assignments (Notecarrier CX dual 16-pin header) ---------------
 #define PIN_THERM_1   A0   // front cargo-air thermistor divider wiper
 #define PIN_THERM_2   A1   // rear cargo-air thermistor divider wiper
 #define PIN_DOOR      D9   // N.C. reed switch; INPUT_PULLUP — LOW = door open
-#define PIN_TPMS_RX   D6   // SoftwareSerial RX ← TPMS receiver TX
-#define PIN_TPMS_TX   D5   // SoftwareSerial TX → TPMS receiver RX
+// TPMS receiver on LPUART1. Nothing in this repo confirms where PA2/PA3 land
+// on the Notecarrier CX header; check the Cygnet pinout before wiring. If
+// they are not broken out, build with -DPIN_TPMS_RX=PB10 -DPIN_TPMS_TX=PB11,
+// the STM32L433's other LPUART1 pair, wired to wherever those reach.
+#ifndef PIN_TPMS_RX
+#define PIN_TPMS_RX   PA3  // LPUART1 RX ← TPMS receiver TX
+#endif
+#ifndef PIN_TPMS_TX
+#define PIN_TPMS_TX   PA2  // LPUART1 TX → TPMS receiver RX
+#endif
 
 // ---- Thermistor parameters ---------------------------------------------
 #define THERM_SERIES_OHM  10000.0f  // divider series resistor (Ω)
@@ -55,13 +80,11 @@
 // Simplified POC frame: [0xAA][0x55][setHi][setLo][actHi][actLo][status][xorCk]
 // Temperatures: signed 16-bit, 0.1 °F LSB.
 //
-// drainReeferUart() is called during the WAKE_UART_DRAIN_MS window after each
-// wakeup and between blocking Notecard I2C calls within the sample cycle. In
-// the sleep architecture the host is powered off between samples; frames that
+// drainReeferUart() is called whenever a complete frame is buffered during the
+// Stop-mode dwell and between blocking Notecard I2C calls within the sample
+// cycle, so every frame is parsed. Under -DHOST_POWER_CUT_SLEEP it instead
+// runs during the WAKE_UART_DRAIN_MS window after each wakeup; frames that
 // arrive while the host is off are lost (the UART peripheral has no power).
-// At wakeup the drain window catches frames arriving in the first 250 ms;
-// subsequent drains within the sample cycle recover any bytes arriving during
-// Notecard I2C transactions.
 //
 // The reefer_sensor_loss alert is gated by g_ps.j2497Commissioned: it fires
 // only once the firmware has received at least one valid J2497 frame, so a
@@ -79,16 +102,14 @@
 #define REEFER_PKT_LEN   8        // bytes per frame (including 2-byte header)
 #define REEFER_MISS_MAX  3        // consecutive wake cycles with no frame → alert
 
-// ---- TPMS receiver (SoftwareSerial) ------------------------------------
+// ---- TPMS receiver (hardware LPUART1) ----------------------------------
 // Simplified POC frame: [0xCC][posID][pressHi][pressLo][tempC][xorCk]
 // Pressure: unsigned 16-bit, 0.1 PSI LSB. posID 0–3.
 //
-// drainTpmsUart() is called during the WAKE_UART_DRAIN_MS window and between
-// Notecard I2C calls within each sample cycle. SoftwareSerial requires the CPU
-// to be active (bit-banging); it cannot receive while the host is powered off
-// during the sleep interval. Frames arriving between wakes are lost. The drain
-// window catches frames that happen to arrive within the first 250 ms after
-// wakeup; subsequent drains within the sample cycle capture any late arrivals.
+// TPMS uses LPUART1 rather than SoftwareSerial: bit-banged reception needs an
+// active CPU, whereas LPUART1 at 9600 baud runs from the LSE and keeps
+// receiving in Stop 2. drainTpmsUart() is called on the same schedule as
+// drainReeferUart().
 //
 // The most recent valid pressure per position is latched in g_sensors.tpmsPsi[]
 // AND persisted in g_ps.tpmsPsiLast[] so the correct last-known value is
@@ -309,7 +330,7 @@ struct PersistState {
 extern Config         g_cfg;
 extern Sensors        g_sensors;
 extern PersistState   g_ps;
-extern SoftwareSerial tpmsSerial;
+extern HardwareSerial tpmsSerial;
 // g_reeferFrameReceived removed: reefer frame freshness is now tracked by
 // the persisted g_ps.reeferFrameSeen field (see PersistState above).
 
@@ -332,7 +353,7 @@ void setupDoorInterrupt();
 // is parsed.
 void drainReeferUart();
 
-// Drain the TPMS SoftwareSerial and update g_sensors.tpmsPsi[] / stale counts.
+// Drain the TPMS LPUART and update g_sensors.tpmsPsi[] / stale counts.
 // Call on every loop() iteration to collect packets as they arrive.
 void drainTpmsUart();
 
@@ -344,6 +365,15 @@ void drainTpmsUart();
 // next wake's call to updateReeferMissCount().
 void updateReeferMissCount();
 
+// Arm Serial1 (J2497) and tpmsSerial (TPMS) as Stop-mode wakeup sources.
+// Call once in setup() after both ports are begun and LowPower.begin() has
+// run. Not used under -DHOST_POWER_CUT_SLEEP.
+void setupUartCapture();
+
+// True when either UART holds at least one complete frame's worth of bytes,
+// i.e. the dwell loop should wake fully and run the parsers.
+bool uartFrameReady();
+
 // Read both cargo-air thermistors (16-sample average) into g_sensors.
 void readThermistors();
 
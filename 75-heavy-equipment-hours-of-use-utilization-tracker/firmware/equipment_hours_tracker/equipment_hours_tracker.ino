@@ -10,7 +10,8 @@
  * On each 30-second wake the host: restores persisted state, fetches env vars,
  * samples accelerometer for 2 s at 104 Hz, classifies vibration as IDLE /
  * RUNNING / TRANSPORT using RMS + coefficient-of-variation (CV = σ/μ),
- * updates the engine-hour meter, emits state-change events immediately and
+ * updates the engine-hour meter, places the latest GPS fix among the job sites
+ * synced from sites.db, emits state-change events immediately and
  * daily summaries on schedule, then sleeps via card.attn host power gating.
  *
  * Classifier rationale: diesel idle at 700 RPM → ~11.7 Hz periodic vibration
@@ -21,6 +22,7 @@
  *   equipment_hours_tracker.ino      — setup / loop / orchestration (this file)
  *   equipment_hours_tracker_helpers.h — types, constants, externs, prototypes
  *   equipment_hours_tracker_helpers.cpp — global definitions + helper implementations
+ *   geofence_store.h                 — job-site polygon/circle store (header-only)
  *
  * Dependencies (install via Arduino Library Manager):
  *   Blues Wireless Notecard (note-arduino) — pin current stable release
@@ -52,7 +54,7 @@ void setup() {
     // Notecard may not be ready to accept commands immediately after host
     // power-up.  A single immediate attempt that fails looks identical to a
     // genuine cold boot, which would zero g_s and permanently lose all
-    // persisted hour totals and pending events.  Retry with increasing backoff
+    // persisted hour totals.  Retry with increasing backoff
     // before concluding that no payload exists.
     for (int attempt = 0; attempt < 5 && !restored; attempt++) {
         if (attempt > 0) delay(250 * attempt);  // 250, 500, 750, 1000 ms
@@ -60,11 +62,20 @@ void setup() {
     }
     if (restored) {
         restored &= NotePayloadGetSegment(&payload, SEG_ID, &g_s, sizeof(g_s));
-        NotePayloadFree(&payload);  // release whether or not the segment parse succeeded
+        // The job-site store has its own variable-length segment; a missing or
+        // corrupt image just means a full sites.db resync on this wake.
+        uint8_t *img = NULL;
+        uint32_t img_len = 0;
+        g_geo_ready = restored &&
+                      NotePayloadFindSegment(&payload, GEO_SEG_ID, &img, &img_len) &&
+                      img_len <= GEO_IMAGE_MAX &&
+                      geoDecode(&g_geo, img, (uint16_t)img_len);
+        NotePayloadFree(&payload);  // release whether or not the segment parse succeeded  // release whether or not the segment parse succeeded
     }
 
     if (!restored || !g_s.configured) {
         memset(&g_s, 0, sizeof(g_s));
+        g_geo_ready = false;   // site tracker state is unknown after a cold boot
         // Only mark configured after every required request is confirmed by
         // the Notecard — a transient cold-boot I²C miss must not leave the
         // device permanently misconfigured on subsequent wakes.
@@ -78,10 +89,15 @@ void setup() {
         }
     }
 
+    // New outbox generation; recovers events spilled before the host lost its
+    // state, so they are still replayed. Retried every wake until the meta
+    // Note is read; until then events wait unstamped in the outbox ring.
+    if (!g_s.outbox.ready && !outboxBegin(g_s.outbox))
+        Serial.println("[BOOT] Outbox not started — will retry on next wake");
+
     // Seed runtime globals from last-good env reads before issuing env.get so
     // that a transient miss leaves previously-applied tuning and fence intact.
     fetchEnvOverrides();
-    applyGeofenceIfChanged();
 
     if (!sox.begin_I2C()) {
         Serial.println("[IMU] Not found — check SDA/SCL/VCC wiring");
@@ -100,15 +116,39 @@ void setup() {
     EquipState new_state = classifyVibration();
     updateHourAccumulator(now);  // credit actual elapsed time to prev_state before updating it
 
-    // ── Event delivery — drain backlog, then handle any new transition ────────
-    //
-    // Drain one backlogged event per wake (oldest first).  New transitions
-    // added later in this wake are enqueued after existing entries, preserving
-    // FIFO ordering across retries.
-    if (g_s.evq_count > 0) {
-        Serial.print("[EVENT] retrying "); Serial.println(g_s.evq[g_s.evq_head].tag);
-        sendNextPendingEvent();
+    // ── Job sites — sync sites.db, then place the latest GPS fix ──────────────
+    // Runs before event handling so an engine event on this wake is tagged
+    // with the site the machine is on.  Sites are not evaluated until the
+    // store holds a complete copy of sites.db, so a half-synced store cannot
+    // report a false site_exit.
+    bool sync_due = !g_geo_ready || now == 0 ||
+                    now - g_s.last_site_sync_epoch >= SITE_SYNC_MIN * 60u;
+    if (sync_due) {
+        if (syncSites(!g_geo_ready)) {
+            g_geo_ready = true;
+            g_s.last_site_sync_epoch = now;
+        } else {
+            Serial.println("[GEO] sites.db sync failed — retrying next wake");
+        }
     }
+    if (g_geo_ready) {
+        applyGeofenceIfChanged();
+        if (g_geo.dirty) {
+            Serial.print("[GEO] ");
+            Serial.print(g_geo.count);
+            Serial.print(" sites, ");
+            Serial.print(g_geo.nverts);
+            Serial.println(" polygon vertices");
+        }
+        checkSite();
+        g_geo.dirty = false;
+    }
+
+    // ── Event delivery — replay held events, then handle any new transition ──
+    //
+    // Events held on earlier wakes go out first, so a new transition on
+    // this wake normally follows them into the Notecard queue.
+    flushEvents();
 
     if (new_state != g_s.prev_state) {
         const char *tag;
@@ -136,27 +176,20 @@ void setup() {
         // ── Decouple classified state from event-delivery state ───────────────
         // Advance prev_state immediately so updateHourAccumulator() on the next
         // wake always credits the correct bucket — independent of whether the
-        // note.add is acknowledged this wake.  The ring-buffer record carries
-        // the event payload until the Notecard confirms delivery, eliminating
+        // note.add is acknowledged this wake.  A failed note.add spills the
+        // event to the outbox, which replays it on a later wake, eliminating
         // both skewed hour totals and duplicate transition events on retry.
         g_s.prev_state = new_state;
 
-        // Enqueue the transition record.  Do NOT clear run_session_start until
-        // the record is safely in the ring buffer: if the buffer is full the
-        // event is dropped, but preserving run_session_start lets the next
-        // session-close event recompute an approximate duration rather than
-        // silently discarding the session entirely.  prev_state has already
-        // advanced so the hour accumulator is unaffected by delivery outcome.
-        if (enqueueEvent(tag, now, session_min, g_s.run_h_total)) {
-            // Record is in the ring buffer; now safe to close the session window
-            // (the duration is already captured in the pending record).
+        // Do NOT clear run_session_start unless the event was sent or held:
+        // a dropped event (outbox ring and spill both unavailable) is counted
+        // in event_drop_count by sendEvent(), and preserving run_session_start
+        // lets the next session-close event recompute an approximate duration
+        // rather than silently discarding the session entirely.  prev_state has
+        // already advanced so the hour accumulator is unaffected by delivery
+        // outcome.
+        if (sendEvent(tag, now, session_min, g_s.run_h_total, g_s.site) != OUTBOX_DROPPED) {
             if (session_closing) g_s.run_session_start = 0;
-            sendNextPendingEvent();
-        } else {
-            // Ring buffer full — enqueueEvent() already logged a warning.
-            // Increment the overflow counter so the fault is surfaced in the
-            // next summary note sent to Notehub.
-            g_s.evq_overflow_count++;
         }
     }
 
@@ -170,7 +203,7 @@ void setup() {
             g_s.run_h_today        = 0.0f;
             g_s.transport_h_today  = 0.0f;
             g_s.last_summary_epoch = now;
-            g_s.evq_overflow_count = 0;   // reset after fault count is reported in cloud
+            g_s.event_drop_count   = 0;   // reset after fault count is reported in cloud
         }
     }
 
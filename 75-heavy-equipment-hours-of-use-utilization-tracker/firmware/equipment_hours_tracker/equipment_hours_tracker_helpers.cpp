@@ -15,6 +15,10 @@ Adafruit_LSM6DSOX sox;
 PersistState g_s;
 const char SEG_ID[] = "EQHRS";
 
+GeoStore g_geo;
+bool g_geo_ready = false;
+const char GEO_SEG_ID[] = "GEO";
+
 // Runtime env overrides — static initialisers provide the compile-time defaults,
 // but fetchEnvOverrides() seeds these from g_s.applied_* on every wake before
 // calling env.get, so a transient miss never reverts a previously-applied value.
@@ -205,7 +209,7 @@ bool defineTemplates(void)
     JAddNumberToObject(body, "run_h_total", 14.1);
     JAddNumberToObject(body, "transport_h", 14.1);
     JAddNumberToObject(body, "bat_v", 12.1);
-    JAddNumberToObject(body, "fault_ct", 12); // event-queue overflow counter (2-byte int)
+    JAddNumberToObject(body, "fault_ct", 12); // events dropped since last summary (2-byte int)
     JAddNumberToObject(body, "_lat", 14.1);
     JAddNumberToObject(body, "_lon", 14.1);
     if (!checkedRequest(req))
@@ -215,7 +219,8 @@ bool defineTemplates(void)
     // successful note.add to request prompt delivery.
     // The sample string for "event" must be the longest value that will ever be
     // stored so the compact template reserves exactly the right number of bytes.
-    // "transport_start" (15 chars) is the longest of the four event names.
+    // "transport_start" (15 chars) is the longest of the event names; "site"
+    // reserves the full GEO_NAME_LEN - 1 characters of a site name.
     // 14.1 = 4-byte IEEE-754 float; 14 = 4-byte signed integer (fits Unix epoch).
     req = notecard.newRequest("note.template");
     JAddStringToObject(req, "file", "equip_event.qo");
@@ -223,9 +228,12 @@ bool defineTemplates(void)
     JAddStringToObject(req, "format", "compact");
     body = JAddObjectToObject(req, "body");
     JAddStringToObject(body, "event", "transport_start"); // longest event name
+    JAddStringToObject(body, "site", "123456789012345");  // longest site name
     JAddNumberToObject(body, "session_min", 14.1);
     JAddNumberToObject(body, "run_h_total", 14.1);
     JAddNumberToObject(body, "epoch", 14); // 4-byte int: Unix transition timestamp (s)
+    JAddNumberToObject(body, "boot", 14);  // outbox dedup key (outbox.h): generation
+    JAddNumberToObject(body, "seq", 14);   //   and sequence within it
     JAddNumberToObject(body, "_lat", 14.1);
     JAddNumberToObject(body, "_lon", 14.1);
     if (!checkedRequest(req))
@@ -428,42 +436,23 @@ void fetchEnvOverrides(void)
     }
 }
 
-// ── Geofence — reconfigure Notecard if env-var fence parameters have changed ──
+// ── Geofence — mirror the env-var fence into the job-site store ───────────────
 // Three env vars must ALL be set together: geofence_lat, geofence_lon, and
 // geofence_radius_m.  Leaving lat/lon at the default 0,0 while setting a
 // non-zero radius is treated as misconfigured and the fence is not applied.
 //
-// The fence centre (lat/lon) AND radius are persisted in PersistState so that
-// a radius-only change is detected and re-applied on the next wake.
-//
-// When geofence_radius_m is set to 0 after a fence was active, this function
-// explicitly re-issues card.location.mode without lat/lon/max parameters, which
-// removes the geofence configuration from the Notecard.  Without this explicit
-// clear, a previously-applied fence would remain active even after the operator
-// sets geofence_radius_m=0.
-//
-// Cached state (fence_lat / fence_lon / fence_radius_m / fence_was_active) is
-// only updated after the Notecard confirms the request so that a transient
-// failure causes a retry on the next wake rather than silently sticking.
+// The fence is a circle named GEO_ENV_FENCE in g_geo, evaluated by
+// checkSite() alongside the sites.db polygons, so it produces the same
+// site_enter / site_exit events.  Called every wake after syncSites(): an
+// unchanged fence is a no-op, and a full sites.db rebuild (which starts from
+// an empty store) gets the fence back on the same wake.  Setting
+// geofence_radius_m to 0 removes it.
 void applyGeofenceIfChanged(void)
 {
     if (g_fence_radius_m == 0)
     {
-        if (g_s.fence_was_active)
-        {
-            // Re-apply periodic mode without fence parameters to clear the fence.
-            J *req = notecard.newRequest("card.location.mode");
-            JAddStringToObject(req, "mode", "periodic");
-            JAddNumberToObject(req, "seconds", GPS_PERIOD_SECONDS);
-            if (checkedRequest(req))
-            {
-                g_s.fence_was_active = false;
-                g_s.fence_lat = 0.0f;
-                g_s.fence_lon = 0.0f;
-                g_s.fence_radius_m = 0;
-                Serial.println("[GEO] Fence cleared");
-            }
-        }
+        if (geoErase(&g_geo, GEO_ENV_FENCE))
+            Serial.println("[GEO] Fence cleared");
         return;
     }
 
@@ -480,25 +469,10 @@ void applyGeofenceIfChanged(void)
         return;
     }
 
-    // Skip if all three cached values match — avoids redundant Notecard calls.
-    if (fabsf(g_fence_lat - g_s.fence_lat) < 0.0001f &&
-        fabsf(g_fence_lon - g_s.fence_lon) < 0.0001f &&
-        g_fence_radius_m == g_s.fence_radius_m)
-        return;
-
-    J *req = notecard.newRequest("card.location.mode");
-    JAddStringToObject(req, "mode", "periodic");
-    JAddNumberToObject(req, "seconds", GPS_PERIOD_SECONDS);
-    JAddNumberToObject(req, "lat", g_fence_lat);
-    JAddNumberToObject(req, "lon", g_fence_lon);
-    JAddNumberToObject(req, "max", (int)g_fence_radius_m);
-    JAddNumberToObject(req, "minutes", 2); // confirm outside fence for 2 min
-    if (checkedRequest(req))
-    {
-        g_s.fence_lat = g_fence_lat;
-        g_s.fence_lon = g_fence_lon;
-        g_s.fence_radius_m = g_fence_radius_m;
-        g_s.fence_was_active = true;
+    GeoResult r = geoStoreCircle(&g_geo, GEO_ENV_FENCE, geoE7(g_fence_lat),
+                                 geoE7(g_fence_lon), g_fence_radius_m);
+    if (r == GEO_STORED)
+    {
         Serial.print("[GEO] Fence: lat=");
         Serial.print(g_fence_lat, 5);
         Serial.print(" lon=");
@@ -506,6 +480,169 @@ void applyGeofenceIfChanged(void)
         Serial.print(" r=");
         Serial.println(g_fence_radius_m);
     }
+    else if (r != GEO_UNCHANGED)
+    {
+        Serial.println("[GEO] Fence not stored — site store full or fence out of range");
+    }
+}
+
+// ── Job-site sync — apply sites.db changes to the store ───────────────────────
+// Each sites.db Note is one site; its Note ID is the site name (first 15
+// characters, reported in equip_event.qo).  Body is either
+//   {"points":[[lat,lon],[lat,lon],...]}   polygon, 3–64 vertices, decimal degrees
+//   {"lat":..,"lon":..,"radius":..}         circle, radius in meters
+//
+// note.changes with a tracker returns only Notes added, edited or deleted
+// since the previous call, so a routine sync with no site edits is one small
+// local request.  full resets the tracker and rebuilds the store from every
+// Note — used when no store image survived sleep.  A malformed site is logged
+// and skipped until its Note is edited.  Returns false on a Notecard error;
+// after a failed full sync the store is incomplete and is not evaluated.
+static GeoResult applySiteNote(const char *id, J *note)
+{
+    if (JGetBool(note, "deleted"))
+    {
+        geoErase(&g_geo, id);
+        return GEO_STORED;
+    }
+    J *body = JGetObject(note, "body");
+    if (!body)
+        return GEO_INVALID;
+
+    J *pts = JGetArray(body, "points");
+    if (pts)
+    {
+        // One extra slot so a ring closed on its first vertex still fits.
+        int32_t lat[GEO_MAX_POLY_VERTS + 1];
+        int32_t lon[GEO_MAX_POLY_VERTS + 1];
+        int n = 0;
+        for (J *pt = pts->child; pt; pt = pt->next)
+        {
+            J *a = pt->child;
+            J *b = a ? a->next : NULL;
+            if (n > GEO_MAX_POLY_VERTS || !b || !JIsNumber(a) || !JIsNumber(b))
+                return GEO_INVALID;
+            lat[n] = geoE7(JNumberValue(a));
+            lon[n] = geoE7(JNumberValue(b));
+            n++;
+        }
+        return geoStorePolygon(&g_geo, id, lat, lon, (uint8_t)n);
+    }
+    if (JIsPresent(body, "radius"))
+    {
+        double lat = JGetNumber(body, "lat");
+        double lon = JGetNumber(body, "lon");
+        double r = JGetNumber(body, "radius");
+        // 0,0 is the same "not configured" sentinel the env-var fence uses.
+        if ((lat == 0.0 && lon == 0.0) || r < 1.0)
+            return GEO_INVALID;
+        return geoStoreCircle(&g_geo, id, geoE7(lat), geoE7(lon), (uint32_t)lround(r));
+    }
+    return GEO_INVALID;
+}
+
+bool syncSites(bool full)
+{
+    if (full)
+        geoInit(&g_geo);
+    // Bounded so a file full of changes cannot hold the host awake; whatever
+    // remains is read on the next sync.
+    const int kMaxRequests = GEO_MAX_FENCES / GEO_SYNC_BATCH + 2;
+    for (int r = 0; r < kMaxRequests; r++)
+    {
+        J *req = notecard.newRequest("note.changes");
+        JAddStringToObject(req, "file", SITES_NOTEFILE);
+        JAddStringToObject(req, "tracker", GEO_SYNC_TRACKER);
+        JAddNumberToObject(req, "max", GEO_SYNC_BATCH);
+        JAddBoolToObject(req, "deleted", true);
+        if (full && r == 0)
+            JAddBoolToObject(req, "start", true);
+        J *rsp = notecard.requestAndResponse(req);
+        if (!rsp)
+            return false;
+        const char *err = JGetString(rsp, "err");
+        if (err && *err != '\0')
+        {
+            // sites.db does not exist until the first site is added: no sites.
+            bool absent = (strstr(err, "does not exist") != NULL ||
+                           strstr(err, "not found") != NULL);
+            if (!absent)
+            {
+                Serial.print("[GEO] sites.db sync: ");
+                Serial.println(err);
+            }
+            notecard.deleteResponse(rsp);
+            return absent;
+        }
+        int n = 0;
+        J *notes = JGetObject(rsp, "notes");
+        for (J *note = notes ? notes->child : NULL; note; note = note->next, n++)
+        {
+            const char *id = note->string ? note->string : "";
+            // The env-var fence owns its name; a sites.db Note cannot replace it.
+            GeoResult res = (strcmp(id, GEO_ENV_FENCE) == 0) ? GEO_INVALID
+                                                             : applySiteNote(id, note);
+            if (res == GEO_INVALID || res == GEO_FULL)
+            {
+                Serial.print("[GEO] site '");
+                Serial.print(id);
+                Serial.println(res == GEO_FULL ? "' skipped — site store full"
+                                               : "' rejected — malformed, out of range or reserved name");
+            }
+        }
+        notecard.deleteResponse(rsp);
+        if (n < GEO_SYNC_BATCH)
+            break;
+    }
+    return true;
+}
+
+// ── Job-site check — one evaluation per new GPS fix ───────────────────────────
+// card.location returns the Notecard's last fix without starting GNSS, so
+// this costs one local request per wake and only does work when the 15-minute
+// periodic fix has moved on or the sites changed.  The fix is placed in the
+// smallest containing site; a machine already in a site stays there until it
+// is more than SITE_EXIT_MARGIN_M outside it.  A change of site sends site_exit for the
+// old one and site_enter for the new one, stamped with the fix time.
+void checkSite(void)
+{
+    J *rsp = notecard.requestAndResponse(notecard.newRequest("card.location"));
+    if (!rsp)
+        return;
+    const char *err = JGetString(rsp, "err");
+    bool has_fix = (!err || *err == '\0') && JIsPresent(rsp, "lat") && JIsPresent(rsp, "lon");
+    double lat = JGetNumber(rsp, "lat");
+    double lon = JGetNumber(rsp, "lon");
+    uint32_t fix_time = (uint32_t)JGetNumber(rsp, "time");
+    notecard.deleteResponse(rsp);
+    // Re-evaluate an old fix only when the sites themselves changed.
+    if (!has_fix || (fix_time == g_s.last_fix_time && !g_geo.dirty))
+        return;
+
+    int32_t lat7 = geoE7(lat), lon7 = geoE7(lon);
+    int idx = geoFind(&g_geo, lat7, lon7);
+    int cur = g_s.site[0] ? geoIndex(&g_geo, g_s.site) : -1;
+    if (cur >= 0 && idx < 0 && geoNear(&g_geo, (uint8_t)cur, lat7, lon7, SITE_EXIT_MARGIN_M))
+        idx = cur;
+    const char *site = (idx >= 0) ? g_geo.fence[idx].name : "";
+
+    if (strncmp(site, g_s.site, GEO_NAME_LEN) != 0)
+    {
+        Serial.print("[GEO] site '");
+        Serial.print(g_s.site);
+        Serial.print("' → '");
+        Serial.print(site);
+        Serial.println("'");
+        // An event the Notecard doesn't take is held and replayed on a
+        // later wake; its seq still places it before the enter that follows.
+        if (g_s.site[0])
+            sendEvent("site_exit", fix_time, 0.0f, g_s.run_h_total, g_s.site);
+        if (site[0])
+            sendEvent("site_enter", fix_time, 0.0f, g_s.run_h_total, site);
+        strncpy(g_s.site, site, sizeof(g_s.site) - 1);
+        g_s.site[sizeof(g_s.site) - 1] = '\0';
+    }
+    g_s.last_fix_time = fix_time;
 }
 
 // ── Vibration classifier ──────────────────────────────────────────────────────
@@ -589,104 +726,63 @@ void updateHourAccumulator(uint32_t now)
         g_s.last_sample_epoch = now;
 }
 
-// ── Pending-event ring-buffer helpers ─────────────────────────────────────────
-
-// Adds a new transition record to the tail of the ring buffer.
-// If the buffer is already full (PENDING_QUEUE_DEPTH consecutive wakes without
-// a Notecard acknowledgement), the overflow is logged and the new record is
-// dropped rather than overwriting the oldest billable evidence.
-// Returns true if the event was successfully enqueued.
-bool enqueueEvent(const char *tag, uint32_t epoch,
-                  float session_min, float run_h_total)
+// ── State-change events ───────────────────────────────────────────────────────
+
+// Sends one state-change event through the outbox.  The event is queued with
+// sync:true so a billing record doesn't wait for the next scheduled outbound
+// window; a held event keeps that flag when it is replayed.  "epoch" is the
+// transition time captured when the event was raised, so a replay carries the
+// original value, and boot/seq (added by the outbox) let the downstream route
+// drop the duplicate a lost I²C acknowledgement can produce.  An event that is
+// neither sent nor held is counted in event_drop_count and reported as
+// fault_ct in the next summary.
+OutboxResult sendEvent(const char *tag, uint32_t epoch,
+                       float session_min, float run_h_total,
+                       const char *site)
 {
-    if (g_s.evq_count >= PENDING_QUEUE_DEPTH)
+    J *body = JCreateObject();
+    if (body)
     {
-        Serial.print("[EVENT] queue full — dropping ");
-        Serial.println(tag);
-        return false;
+        JAddStringToObject(body, "event", tag);
+        JAddStringToObject(body, "site", site);
+        JAddNumberToObject(body, "session_min", session_min);
+        JAddNumberToObject(body, "run_h_total", run_h_total);
+        JAddNumberToObject(body, "epoch", (JNUMBER)epoch); // transition timestamp
     }
-    uint8_t tail = (g_s.evq_head + g_s.evq_count) % PENDING_QUEUE_DEPTH;
-    PendingEvent &e = g_s.evq[tail];
-    strncpy(e.tag, tag, sizeof(e.tag) - 1);
-    e.tag[sizeof(e.tag) - 1] = '\0';
-    e.epoch = epoch;
-    e.session_min = session_min;
-    e.run_h_total = run_h_total;
-    g_s.evq_count++;
-    return true;
+    OutboxResult result = outboxAdd(g_s.outbox, "equip_event.qo", true, body);
+    switch (result)
+    {
+    case OUTBOX_SENT:
+        Serial.print("[EVENT] ");
+        break;
+    case OUTBOX_QUEUED:
+        Serial.print("[EVENT] held for replay: ");
+        break;
+    case OUTBOX_SPILLED:
+        Serial.print("[EVENT] spilled for replay: ");
+        break;
+    default:
+        Serial.print("[EVENT] dropped: ");
+        g_s.event_drop_count++;
+        break;
+    }
+    Serial.println(tag);
+    return result;
 }
 
-// Attempts to deliver the oldest pending event (ring-buffer head) to the
-// Notecard.  On success the head pointer advances and the count decrements.
-// Returns true if the queue was empty (nothing to send) or the oldest event
-// was successfully acknowledged.  Returns false if the send failed; the head
-// is not advanced and the event will be retried on the next wake.
-bool sendNextPendingEvent(void)
+// Replays events held on earlier wakes, oldest first, up to
+// OUTBOX_FLUSH_MAX per wake.  outboxFlush() stops at the first request the
+// Notecard doesn't answer, so an unreachable Notecard costs one request.
+void flushEvents(void)
 {
-    if (g_s.evq_count == 0)
-        return true;
-
-    PendingEvent &e = g_s.evq[g_s.evq_head];
-
-    // note.add on a .qo Notefile is a pure append — the Notecard API does not
-    // provide a deduplication field for outgoing queue notes.  Omit sync:true
-    // to decouple local note acceptance from the network session.  A lost I²C
-    // ACK (note accepted by the Notecard but the host never received the reply)
-    // will cause the host to retry on the next wake, producing a duplicate
-    // entry in the Notecard's queue.  This is an acknowledged edge case: the
-    // ring-buffer design ensures at-least-once delivery; the "epoch" field
-    // transmitted in each event body is the Unix timestamp of the actual state
-    // transition, captured when the event was enqueued.  Server-side
-    // deduplication on the downstream route (keying on epoch + tag) is the
-    // recommended mitigation for billing-critical deployments because a
-    // retransmitted duplicate will carry the same epoch and event tag as the
-    // original.  A separate hub.sync call below requests prompt delivery
-    // without tying it to the note.add retry logic.
-    for (int attempt = 0; attempt < 2; attempt++)
-    {
-        J *req = notecard.newRequest("note.add");
-        JAddStringToObject(req, "file", "equip_event.qo");
-        J *body = JAddObjectToObject(req, "body");
-        JAddStringToObject(body, "event", e.tag);
-        JAddNumberToObject(body, "session_min", e.session_min);
-        JAddNumberToObject(body, "run_h_total", e.run_h_total);
-        JAddNumberToObject(body, "epoch", (JNUMBER)e.epoch); // transition timestamp
-        J *rsp = notecard.requestAndResponse(req);
-        if (!rsp)
-        {
-            Serial.print("[EVENT] no response (attempt ");
-            Serial.print(attempt + 1);
-            Serial.println(")");
-            continue;
-        }
-        const char *err = JGetString(rsp, "err");
-        bool ok = (!err || *err == '\0');
-        if (!ok)
-        {
-            Serial.print("[EVENT] err: ");
-            Serial.println(err);
-        }
-        notecard.deleteResponse(rsp);
-        if (ok)
-        {
-            Serial.print("[EVENT] ");
-            Serial.println(e.tag);
-            g_s.evq_head = (g_s.evq_head + 1) % PENDING_QUEUE_DEPTH;
-            g_s.evq_count--;
-            // Request prompt delivery as a separate fire-and-forget call so
-            // time-critical billing events are not held until the next
-            // scheduled outbound window.  Delivery is ultimately the
-            // Notecard's responsibility; this call failing is non-fatal.
-            J *syncReq = notecard.newRequest("hub.sync");
-            J *syncRsp = notecard.requestAndResponse(syncReq);
-            if (syncRsp)
-                notecard.deleteResponse(syncRsp);
-            return true;
-        }
-    }
-    Serial.print("[EVENT] failed to queue ");
-    Serial.println(e.tag);
-    return false;
+    if (outboxPending(g_s.outbox) == 0)
+        return;
+    uint32_t replayed = outboxFlush(g_s.outbox);
+    Serial.print("[EVENT] replayed ");
+    Serial.print(replayed);
+    Serial.print(", ");
+    Serial.print(outboxPending(g_s.outbox));
+    Serial.println(" still held");
 }
 
 // ── Daily summary — queued for next outbound sync ─────────────────────────────
@@ -705,7 +801,7 @@ bool sendSummary(void)
         JAddNumberToObject(body, "run_h_total", g_s.run_h_total);
         JAddNumberToObject(body, "transport_h", g_s.transport_h_today);
         JAddNumberToObject(body, "bat_v", bat_v);
-        JAddNumberToObject(body, "fault_ct", g_s.evq_overflow_count);
+        JAddNumberToObject(body, "fault_ct", g_s.event_drop_count);
         J *rsp = notecard.requestAndResponse(req);
         if (!rsp)
         {
@@ -774,10 +870,17 @@ float getBatteryVoltage(void)
 // jumper in place, SAMPLE_INTERVAL_SEC later the Cygnet powers up and re-enters
 // setup().  Without the jumper the host stays powered and loop() takes over as
 // the (higher-power) fallback path.
+//
+// The job-site store rides in a second, variable-length segment holding only
+// the sites in use.  An incomplete store (sites.db sync failed this wake) is
+// not saved, so the next wake rebuilds it in full.
 void goToSleep(void)
 {
+    static uint8_t geo_image[GEO_IMAGE_MAX];
     NotePayloadDesc payload = {0, 0, 0};
     NotePayloadAddSegment(&payload, SEG_ID, &g_s, sizeof(g_s));
+    if (g_geo_ready)
+        NotePayloadAddSegment(&payload, GEO_SEG_ID, geo_image, geoEncode(&g_geo, geo_image));
     NotePayloadSaveAndSleep(&payload, SAMPLE_INTERVAL_SEC, NULL);
     delay(15000); // should not return; loop() retries setup() as fallback
 }
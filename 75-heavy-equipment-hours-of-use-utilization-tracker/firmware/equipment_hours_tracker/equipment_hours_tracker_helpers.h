@@ -14,6 +14,8 @@
 #include <math.h>
 #include <string.h>   // strncpy, memset
 #include <stdio.h>    // snprintf
+#include "geofence_store.h"
+#include "outbox.h"
 
 #ifndef PRODUCT_UID
 #define PRODUCT_UID ""  // replace with your Notehub ProductUID
@@ -41,12 +43,21 @@
 #define GEOFENCE_RADIUS_MIN_M  50u
 #define GEOFENCE_RADIUS_MAX_M  50000u
 
-// ── Pending-event queue depth ─────────────────────────────────────────────────
-// A ring buffer of this depth tolerates PENDING_QUEUE_DEPTH consecutive wakes
-// with no Notecard acknowledgement (~2 min at 30 s per wake for depth 4) before
-// an overflow drop is logged.  Even depth 2 eliminates the single-slot overwrite
-// window; depth 4 is chosen as an inexpensive safety margin.
-#define PENDING_QUEUE_DEPTH    4
+// ── Job sites ─────────────────────────────────────────────────────────────────
+// Every Note in sites.db is one job site, keyed by site name: a polygon or a
+// circle, edited from the Notehub API.  The env-var fence above joins them in
+// the same store under the reserved name "env".  Sites are read incrementally
+// through a note.changes tracker, GEO_SYNC_BATCH Notes per request, at most
+// once per SITE_SYNC_MIN (sites.db only changes on the 8-hour inbound sync).
+#define SITES_NOTEFILE         "sites.db"
+#define GEO_ENV_FENCE          "env"
+#define GEO_SYNC_TRACKER       "geo"
+#define GEO_SYNC_BATCH         8
+#define SITE_SYNC_MIN          60
+// A machine inside a site is not counted as leaving it until its fix is more
+// than this far outside the boundary, so GPS jitter at the edge cannot
+// produce site_exit / site_enter pairs.
+#define SITE_EXIT_MARGIN_M     25.0f
 
 // ── Compile-time option: disable the Notecard's internal motion subsystem ─────
 // The external LSM6DSOX handles all vibration classification, so the Notecard
@@ -67,14 +78,6 @@ typedef enum : uint8_t {
     ST_TRANSPORT = 2    // bursty low-frequency vibration (road transport)
 } EquipState;
 
-// ── Pending event (one slot in the delivery ring buffer) ──────────────────────
-struct PendingEvent {
-    char     tag[18];          // longest tag "transport_start" = 15 chars + null
-    uint32_t epoch;            // Unix timestamp of the state transition; transmitted in equip_event.qo body for server-side dedup
-    float    session_min;      // session duration captured at transition time
-    float    run_h_total;      // run_h_total snapshot captured at transition time
-};
-
 // ── Persisted state (Notecard flash, survives power-gate sleep) ───────────────
 struct PersistState {
     bool       configured;
@@ -86,12 +89,12 @@ struct PersistState {
     uint32_t   last_summary_epoch;
     uint32_t   last_sample_epoch;     // epoch at end of previous wake (elapsed-time calc)
 
-    // Geofence — mirrors the last values successfully applied to the Notecard;
-    // used by applyGeofenceIfChanged() to detect whether a Notecard call is needed.
-    float      fence_lat;
-    float      fence_lon;
-    uint32_t   fence_radius_m;
-    bool       fence_was_active;
+    // Job site — the site the last GPS fix placed the machine in ("" when
+    // outside every site), the card.location fix time it was evaluated
+    // against, and when sites.db was last synced.
+    char       site[GEO_NAME_LEN];
+    uint32_t   last_fix_time;
+    uint32_t   last_site_sync_epoch;
 
     // Last-good env reads — seeded into the runtime globals on every wake so a
     // transient env.get miss leaves previously-applied tuning and fence parameters
@@ -104,14 +107,12 @@ struct PersistState {
     float      applied_env_fence_lon;        // last good lon read from env
     uint32_t   applied_env_fence_radius_m;   // last good radius read from env (0 = no fence)
 
-    // Pending-event ring buffer — replaces single-slot design so that a second
-    // state transition before the first note.add is acknowledged does not silently
-    // overwrite and drop the older record.  All four event types are preserved in
-    // FIFO order; delivery is attempted oldest-first on each wake.
-    uint8_t      evq_head;              // index of the oldest queued event
-    uint8_t      evq_count;             // number of events currently in the queue
-    PendingEvent evq[PENDING_QUEUE_DEPTH];
-    uint32_t     evq_overflow_count;    // incremented when a transition record is dropped due to a full queue; reported in next summary
+    // State-change events go through the outbox (outbox.h): an event whose
+    // note.add fails is held in its 4-slot ring here, or spilled to
+    // outbox.dbx on the Notecard once the ring is full, and replayed on a
+    // later wake with its original boot/seq.
+    Outbox       outbox;
+    uint32_t     event_drop_count;      // events neither sent nor held since the last summary; reported as fault_ct
 };
 
 // ── Hardware objects ──────────────────────────────────────────────────────────
@@ -122,6 +123,11 @@ extern Adafruit_LSM6DSOX sox;
 extern PersistState g_s;
 extern const char   SEG_ID[];
 
+// ── Job-site store — carried across sleep in its own payload segment ──────────
+extern GeoStore     g_geo;
+extern bool         g_geo_ready;   // holds a complete copy of sites.db
+extern const char   GEO_SEG_ID[];
+
 // ── Runtime env overrides — re-seeded from applied_* fields on every wake ─────
 extern float    g_vib_run_mg;
 extern float    g_vib_cv_max;
@@ -138,11 +144,14 @@ bool       notecardConfigure(void);
 bool       defineTemplates(void);
 void       fetchEnvOverrides(void);
 void       applyGeofenceIfChanged(void);
+bool       syncSites(bool full);
+void       checkSite(void);
 EquipState classifyVibration(void);
 void       updateHourAccumulator(uint32_t now);
-bool       enqueueEvent(const char *tag, uint32_t epoch,
-                        float session_min, float run_h_total);
-bool       sendNextPendingEvent(void);
+OutboxResult sendEvent(const char *tag, uint32_t epoch,
+                       float session_min, float run_h_total,
+                       const char *site);
+void       flushEvents(void);
 bool       sendSummary(void);
 uint32_t   getEpoch(void);
 float      getBatteryVoltage(void);
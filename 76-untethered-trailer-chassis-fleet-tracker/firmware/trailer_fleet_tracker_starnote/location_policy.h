@@ -0,0 +1,297 @@
+/*******************************************************************************
+ * location_policy.h
+ *
+ * Adaptive GNSS duty-cycle and position-reporting policy for a moving asset.
+ *
+ * The host hands every new fix (or the lack of one) to locPolicyUpdate(),
+ * which returns two decisions:
+ *
+ *   - the GNSS fix interval to request from card.location.mode next.  It is
+ *     speed-adaptive (aim for one fix every `spacing_m` of travel), drops to
+ *     the floor when the course is changing, stretches while the asset is
+ *     flagged moving but is not getting anywhere (gate queue, yard shuffle,
+ *     chassis rolling on a ship), and backs off exponentially in poor-sky
+ *     locations, judged by time-to-fix and by fix attempts that produce
+ *     nothing;
+ *   - whether this fix is worth a position Note: only when the asset has
+ *     moved `report_m` since the last report, turned `report_heading_deg`,
+ *     or been silent for `max_report_secs`.
+ *
+ * Pure arithmetic with no Notecard or Arduino dependencies, so the host
+ * simulator in sim/ replays recorded tracks through exactly this code.  All
+ * state lives in LocPolicyState, a POD that is persisted inside AppState
+ * across sleep.  All functions are static inline.
+ ******************************************************************************/
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+// ---------------------------------------------------------------------------
+// Tunables.  locPolicyDefaults() fills in the LOC_DEFAULT_* values; the
+// firmware then applies its env-var overrides.
+// ---------------------------------------------------------------------------
+typedef struct {
+    uint32_t min_fix_secs;        // fix interval floor (turns, first fix)
+    uint32_t max_fix_secs;        // fix interval ceiling under good sky
+    uint32_t max_backoff_secs;    // fix interval ceiling under poor sky
+    uint32_t spacing_m;           // target travel between fixes
+    uint32_t report_m;            // report once displaced this far ...
+    uint16_t report_heading_deg;  // ... or turned this much ...
+    uint32_t max_report_secs;     // ... or silent this long
+    uint16_t poor_ttff_secs;      // a fix slower than this counts as poor sky
+} LocPolicyConfig;
+
+// Defaults tuned with sim/location_policy_sim.cpp.  The good-sky ceiling is
+// the 15-minute cadence the firmware used before, so the policy never
+// samples a moving asset less often than that unless the sky is poor.
+#define LOC_DEFAULT_MIN_FIX_SECS      300
+#define LOC_DEFAULT_MAX_FIX_SECS      900
+#define LOC_DEFAULT_MAX_BACKOFF_SECS  3600
+#define LOC_DEFAULT_SPACING_M         12000
+#define LOC_DEFAULT_REPORT_M          2000
+#define LOC_DEFAULT_REPORT_HEADING    40
+#define LOC_DEFAULT_MAX_REPORT_SECS   3600
+#define LOC_DEFAULT_POOR_TTFF_SECS    90
+
+static inline void locPolicyDefaults(LocPolicyConfig *c)
+{
+    c->min_fix_secs       = LOC_DEFAULT_MIN_FIX_SECS;
+    c->max_fix_secs       = LOC_DEFAULT_MAX_FIX_SECS;
+    c->max_backoff_secs   = LOC_DEFAULT_MAX_BACKOFF_SECS;
+    c->spacing_m          = LOC_DEFAULT_SPACING_M;
+    c->report_m           = LOC_DEFAULT_REPORT_M;
+    c->report_heading_deg = LOC_DEFAULT_REPORT_HEADING;
+    c->max_report_secs    = LOC_DEFAULT_MAX_REPORT_SECS;
+    c->poor_ttff_secs     = LOC_DEFAULT_POOR_TTFF_SECS;
+}
+
+// Displacements below this are GPS jitter; no course is derived from them.
+#define LOC_COURSE_MIN_M        150.0f
+
+// Below this smoothed ground speed the asset is moving but going nowhere.
+#define LOC_STATIONARY_MPS      0.5f
+
+// Poor-sky backoff doubles the interval per level, up to max_backoff_secs.
+#define LOC_BACKOFF_MAX_LEVEL   4
+
+// Fix-interval granularity; keeps small speed changes from reissuing
+// card.location.mode on every wake.
+#define LOC_INTERVAL_STEP_SECS  60
+
+#define LOC_COURSE_NONE         (-1)
+
+#define LOC_REPORT_NONE         0
+#define LOC_REPORT_FIRST        1   // first fix of the trip
+#define LOC_REPORT_DISTANCE     2
+#define LOC_REPORT_HEADING      3
+#define LOC_REPORT_TIMEOUT      4
+
+// ---------------------------------------------------------------------------
+// Persisted state.  sizeof(LocPolicyState) == 52 bytes.
+// ---------------------------------------------------------------------------
+typedef struct {
+    float    fix_lat;             // last accepted fix
+    float    fix_lon;
+    uint32_t fix_time;            // its epoch; 0 = none this trip
+    float    rpt_lat;             // last reported position
+    float    rpt_lon;
+    uint32_t rpt_time;            // epoch of the last report (trip start before one)
+    uint32_t checked_at;          // last fix or last counted miss
+    uint32_t base_secs;           // speed-derived fix interval, before backoff
+    uint32_t interval_secs;       // current fix interval, after backoff
+    float    speed_mps;           // smoothed ground speed
+    int16_t  course_deg;          // course over the last fix leg, LOC_COURSE_NONE if unknown
+    int16_t  rpt_course_deg;      // course when last reported
+    uint16_t ttff_avg_secs;       // smoothed time to fix, 0 = unknown
+    uint8_t  backoff;             // poor-sky level, 0..LOC_BACKOFF_MAX_LEVEL
+    uint8_t  rpt_valid;           // 1 once a position was reported this trip
+    uint16_t fixes;               // trip counters, for diagnostics
+    uint16_t misses;
+} LocPolicyState;
+
+typedef struct {
+    float    lat;
+    float    lon;
+    uint32_t time;                // fix epoch
+    uint16_t ttff_secs;           // acquisition time, 0 = unknown
+} LocFix;
+
+typedef struct {
+    uint8_t  report;              // LOC_REPORT_*
+    uint8_t  interval_changed;    // 1: reissue card.location.mode
+    uint32_t interval_secs;
+} LocDecision;
+
+// ---------------------------------------------------------------------------
+// Geometry — equirectangular projection about the first point.  Legs are at
+// most a few tens of kilometres, where this is within 0.1% of haversine and
+// needs one cosf() instead of five trig calls.
+// ---------------------------------------------------------------------------
+#define LOC_EARTH_RADIUS_M   6371000.0f
+#define LOC_DEG_TO_RAD       0.017453292f
+
+static inline void locProject(float lat0, float lon0, float lat, float lon,
+                              float *out_x, float *out_y)
+{
+    float dlon = lon - lon0;
+    if (dlon > 180.0f)  dlon -= 360.0f;
+    if (dlon < -180.0f) dlon += 360.0f;
+    *out_x = dlon * LOC_DEG_TO_RAD * LOC_EARTH_RADIUS_M * cosf(lat0 * LOC_DEG_TO_RAD);
+    *out_y = (lat - lat0) * LOC_DEG_TO_RAD * LOC_EARTH_RADIUS_M;
+}
+
+static inline float locDistanceM(float lat0, float lon0, float lat1, float lon1)
+{
+    float x, y;
+    locProject(lat0, lon0, lat1, lon1, &x, &y);
+    return sqrtf(x * x + y * y);
+}
+
+// Course from point 0 to point 1, 0..359 degrees clockwise from north.
+static inline int16_t locCourseDeg(float lat0, float lon0, float lat1, float lon1)
+{
+    float x, y;
+    locProject(lat0, lon0, lat1, lon1, &x, &y);
+    int16_t deg = (int16_t)lroundf(atan2f(x, y) / LOC_DEG_TO_RAD);
+    return (int16_t)((deg + 360) % 360);
+}
+
+static inline uint16_t locCourseDiff(int16_t a, int16_t b)
+{
+    int16_t d = (int16_t)(a > b ? a - b : b - a);
+    return (uint16_t)(d > 180 ? 360 - d : d);
+}
+
+// ---------------------------------------------------------------------------
+// Policy
+// ---------------------------------------------------------------------------
+
+// Starts a trip: no fix, nothing reported, interval at the floor so the
+// first fixes establish speed and course quickly.  The smoothed TTFF is kept;
+// the poor-sky level is not — the asset has left wherever earned it.
+static inline void locPolicyStart(LocPolicyState *s, const LocPolicyConfig *c,
+                                  uint32_t now)
+{
+    uint16_t ttff = s->ttff_avg_secs;
+    memset(s, 0, sizeof(*s));
+    s->ttff_avg_secs  = ttff;
+    s->rpt_time       = now;
+    s->checked_at     = now;
+    s->base_secs      = c->min_fix_secs;
+    s->interval_secs  = c->min_fix_secs;
+    s->course_deg     = LOC_COURSE_NONE;
+    s->rpt_course_deg = LOC_COURSE_NONE;
+}
+
+static inline uint32_t locClampInterval(uint32_t v, uint32_t lo, uint32_t hi)
+{
+    if (v < lo) v = lo;
+    if (v > hi) v = hi;
+    v = (v + LOC_INTERVAL_STEP_SECS / 2) / LOC_INTERVAL_STEP_SECS * LOC_INTERVAL_STEP_SECS;
+    return v ? v : LOC_INTERVAL_STEP_SECS;
+}
+
+// Folds one wake into the policy.  `fix` is the Notecard's latest fix, or
+// NULL when it has none; a fix that is not newer than the last one accepted
+// counts as "nothing new".  A fix attempt that produced nothing is charged
+// as a miss once the latest fix is more than two intervals old, and then at
+// most once every two intervals, so frequent host wakes do not escalate the
+// backoff.  Before the first report of a trip, fixes older than the trip
+// start (the Notecard's cached fix from the previous trip) are ignored.
+static inline LocDecision locPolicyUpdate(LocPolicyState *s, const LocPolicyConfig *c,
+                                          const LocFix *fix, uint32_t now)
+{
+    LocDecision d = { LOC_REPORT_NONE, 0, s->interval_secs };
+    uint16_t turn = 0;
+
+    if (fix && fix->time > s->fix_time && (s->rpt_valid || fix->time >= s->rpt_time) &&
+        (fix->lat != 0.0f || fix->lon != 0.0f)) {
+        if (s->fix_time) {
+            float    dist = locDistanceM(s->fix_lat, s->fix_lon, fix->lat, fix->lon);
+            uint32_t dt   = fix->time - s->fix_time;
+            float    v    = dist / (float)dt;
+            s->speed_mps  = (s->fixes > 1) ? 0.5f * (s->speed_mps + v) : v;
+            if (dist >= LOC_COURSE_MIN_M) {
+                int16_t course = locCourseDeg(s->fix_lat, s->fix_lon, fix->lat, fix->lon);
+                if (s->course_deg != LOC_COURSE_NONE) turn = locCourseDiff(course, s->course_deg);
+                s->course_deg = course;
+            }
+        }
+        if (fix->ttff_secs) {
+            s->ttff_avg_secs = s->ttff_avg_secs
+                ? (uint16_t)((3u * s->ttff_avg_secs + fix->ttff_secs) / 4u)
+                : fix->ttff_secs;
+            if (fix->ttff_secs > c->poor_ttff_secs) {
+                if (s->backoff < LOC_BACKOFF_MAX_LEVEL) s->backoff++;
+            } else if (fix->ttff_secs <= c->poor_ttff_secs / 2) {
+                s->backoff = 0;
+            } else if (s->backoff) {
+                s->backoff--;
+            }
+        } else if (s->backoff) {
+            s->backoff--;
+        }
+        s->fix_lat    = fix->lat;
+        s->fix_lon    = fix->lon;
+        s->fix_time   = fix->time;
+        s->checked_at = now;
+        if (s->fixes < 0xFFFF) s->fixes++;
+
+        // Reporting
+        if (!s->rpt_valid) {
+            d.report = LOC_REPORT_FIRST;
+        } else {
+            float moved = locDistanceM(s->rpt_lat, s->rpt_lon, fix->lat, fix->lon);
+            if (moved >= (float)c->report_m) {
+                d.report = LOC_REPORT_DISTANCE;
+            } else if (moved >= LOC_COURSE_MIN_M && s->course_deg != LOC_COURSE_NONE &&
+                       s->rpt_course_deg != LOC_COURSE_NONE &&
+                       locCourseDiff(s->course_deg, s->rpt_course_deg) >= c->report_heading_deg) {
+                d.report = LOC_REPORT_HEADING;
+            } else if (now - s->rpt_time >= c->max_report_secs) {
+                d.report = LOC_REPORT_TIMEOUT;
+            }
+        }
+
+        // Next interval: one fix per spacing_m at the current speed, the
+        // floor while turning, doubling while moving in place.
+        uint32_t base;
+        if (s->fixes < 2 || turn >= c->report_heading_deg / 2) {
+            base = c->min_fix_secs;
+        } else if (s->speed_mps < LOC_STATIONARY_MPS) {
+            base = s->base_secs * 2;
+        } else {
+            base = (uint32_t)((float)c->spacing_m / s->speed_mps);
+        }
+        s->base_secs = locClampInterval(base, c->min_fix_secs, c->max_fix_secs);
+    } else {
+        uint32_t since = now - s->checked_at;
+        if (since > 2 * s->interval_secs) {
+            if (s->backoff < LOC_BACKOFF_MAX_LEVEL) s->backoff++;
+            if (s->misses < 0xFFFF) s->misses++;
+            s->checked_at = now;
+        }
+    }
+
+    uint32_t next = s->base_secs;
+    for (uint8_t i = 0; i < s->backoff && next < c->max_backoff_secs; ++i) next *= 2;
+    next = locClampInterval(next, c->min_fix_secs, c->max_backoff_secs);
+
+    d.interval_changed = (next != s->interval_secs);
+    d.interval_secs    = next;
+    s->interval_secs   = next;
+    return d;
+}
+
+// Records that the fix last passed to locPolicyUpdate() was delivered as a
+// position Note.
+static inline void locPolicyReported(LocPolicyState *s, uint32_t now)
+{
+    s->rpt_lat        = s->fix_lat;
+    s->rpt_lon        = s->fix_lon;
+    s->rpt_time       = now;
+    s->rpt_course_deg = s->course_deg;
+    s->rpt_valid      = 1;
+}
@@ -22,10 +22,16 @@
     1. Restores the persisted AppState from Notecard flash.
     2. Queries the Notecard accelerometer for moving / stopped status.
     3. Detects PARKED→MOVING (departed) and MOVING→PARKED (arrived) transitions.
-    4. On a transition, enqueues an event note and drains the pending FIFO;
+    4. On a transition, sends an event note through the outbox (outbox.h),
+       which spills it for replay on a later wake if note.add fails;
        gps_valid=1 when a valid GNSS fix is available, gps_valid=0 otherwise.
-    5. While MOVING, queues a GPS position note every `moving_ping_mins`
-       (suppressed when no valid GNSS fix is available).
+    5. While MOVING, hands the latest GNSS fix to the location policy
+       (location_policy.h), which sets the next fix interval from speed,
+       course and sky conditions, and adds each new fix to the track buffer
+       (track_buffer.h).  The buffered track is queued, simplified to within
+       `track_error_m` and delta-encoded, as one trailer_track.qo per batch:
+       just before the next expected outbound sync, after `moving_ping_mins`,
+       or on arrival.
     6. While PARKED, queues an alive heartbeat every `heartbeat_hours`;
        gps_valid indicates whether the embedded location is a confirmed fix.
     7. Saves state back to Notecard flash and puts the host to sleep.
@@ -113,6 +119,7 @@ void setup()
         state.parked_check_secs = DEFAULT_PARKED_CHECK_SECS;
         state.moving_ping_secs  = DEFAULT_MOVING_PING_SECS;
         state.heartbeat_secs    = DEFAULT_HEARTBEAT_SECS;
+        state.track_error_m     = DEFAULT_TRACK_ERROR_M;
         if (time_ok && now > 0) state.parked_since = now;
 
         config_complete = false;
@@ -140,6 +147,7 @@ void setup()
         state.parked_check_secs = DEFAULT_PARKED_CHECK_SECS;
         state.moving_ping_secs  = DEFAULT_MOVING_PING_SECS;
         state.heartbeat_secs    = DEFAULT_HEARTBEAT_SECS;
+        state.track_error_m     = DEFAULT_TRACK_ERROR_M;
         if (time_ok && now > 0) state.parked_since = now;
 
         config_complete = false;
@@ -154,6 +162,12 @@ void setup()
         }
     }
 
+    // New outbox generation; recovers events spilled before the host state
+    // was lost, so they are still replayed.  Retried every wake until the
+    // meta Note is read; until then transition events wait unstamped in the
+    // outbox ring.
+    if (config_complete && !state.outbox.ready) outboxBegin(state.outbox);
+
     // ── Gate all tracking on successful Notecard configuration ──────────────
     uint32_t sleep_secs;
 
@@ -192,12 +206,12 @@ void setup()
 #endif
         }
 
-        // ── Drain stale pending events from prior wakes ──────────────────────
-        // Events queued by a prior transition that failed to deliver survive
-        // sleep in the FIFO.  Drain in FIFO order before evaluating new
-        // transitions so that event ordering is always preserved.  Stops at
-        // the first failed delivery; remaining events are retried next wake.
-        drainPendingQueue(state);
+        // ── Replay events held on prior wakes ────────────────────────────────
+        // Events whose note.add failed survive sleep in the outbox.  Replay
+        // them, oldest first, before evaluating new transitions so that event
+        // ordering is preserved.  Stops at the first failed delivery; the
+        // rest are retried next wake.
+        flushTransitionEvents(state);
 
         // ── Read current motion status from Notecard accelerometer ────────────
         bool moving    = false;
@@ -226,30 +240,28 @@ void setup()
                 uint8_t cap_gps_valid = 0;
                 captureGnssState(cap_lat, cap_lon, cap_gps_valid);
 
-                // Enable periodic GPS acquisition for the moving phase.
-                // Explicit mode switch enforces GPS-off-while-parked
-                // independent of the Notecard's implicit periodic-mode
-                // motion-gating, which is not guaranteed for the Starnote
-                // for Iridium's combined GPS hardware path.
+                // Enable periodic GPS acquisition for the moving phase at the
+                // policy's starting interval.  Explicit mode switch enforces
+                // GPS-off-while-parked independent of the Notecard's implicit
+                // periodic-mode motion-gating, which is not guaranteed for the
+                // Starnote for Iridium's combined GPS hardware path.
                 {
-                    J *loc = notecard.newRequest("card.location.mode");
-                    if (loc) {
-                        JAddStringToObject(loc, "mode",    "periodic");
-                        JAddNumberToObject(loc, "seconds",
-                                           (double)state.moving_ping_secs);
-                        sendAndCheck(loc, "card.location.mode periodic");
-                    }
+                    LocPolicyConfig cfg;
+                    locPolicyConfigFor(state, cfg);
+                    locPolicyStart(&state.loc, &cfg, (time_ok && now > 0) ? now : 0U);
+                    setGnssPeriod(state, state.loc.interval_secs);
                 }
 #ifdef usbSerial
-                usbSerial.println("[departed] GPS enabled (periodic)");
+                usbSerial.print("[departed] GPS enabled (periodic ");
+                usbSerial.print(state.loc.interval_secs);
+                usbSerial.println("s)");
 #endif
 
                 state.current_state = STATE_MOVING;
-                if (time_ok && now > 0) state.last_location_at = now;
 
-                enqueuePendingEvent(state, EVENT_DEPARTED, dwell_h,
-                                    (time_ok && now > 0) ? now : 0U,
-                                    cap_lat, cap_lon, cap_gps_valid);
+                sendTransitionEvent(state, EVENT_DEPARTED, dwell_h,
+                                    cap_gps_valid, cap_lat, cap_lon,
+                                    (time_ok && now > 0) ? now : 0U);
 
             } else if (prev == STATE_MOVING && !moving) {
                 // ── MOVING → PARKED (Arrived) ──────────────────────────────
@@ -257,12 +269,22 @@ void setup()
                 usbSerial.println("[arrived] trailer stopped");
 #endif
                 // Capture arrival GNSS state WHILE GPS is still in periodic
-                // mode — the cached fix is within one moving_ping_secs interval
-                // of the actual stop.  Must be done before disabling GPS below.
+                // mode — the cached fix is within one GNSS period of the
+                // actual stop.  Must be done before disabling GPS below.
                 float   cap_lat = 0.0f, cap_lon = 0.0f;
                 uint8_t cap_gps_valid = 0;
                 captureGnssState(cap_lat, cap_lon, cap_gps_valid);
 
+                // Close the trip's track with the final fix.  A batch that
+                // fails to queue stays buffered and is retried while parked.
+                {
+                    LocFix fix;
+                    if (readGnssFix(fix) && fix.time > state.loc.fix_time) {
+                        bufferTrackFix(state, fix);
+                    }
+                    flushTrack(state);
+                }
+
                 // Disable GPS for the parked phase.  Re-enabled on the next
                 // PARKED→MOVING departure.  Explicit mode switch matches the
                 // corresponding enable in the departure branch above.
@@ -270,7 +292,9 @@ void setup()
                     J *loc = notecard.newRequest("card.location.mode");
                     if (loc) {
                         JAddStringToObject(loc, "mode", "off");
-                        sendAndCheck(loc, "card.location.mode off");
+                        if (sendAndCheck(loc, "card.location.mode off")) {
+                            state.gps_period_secs = 0;
+                        }
                     }
                 }
 #ifdef usbSerial
@@ -286,9 +310,9 @@ void setup()
                     state.parked_since_needs_init = 1;
                 }
 
-                enqueuePendingEvent(state, EVENT_ARRIVED, 0.0f,
-                                    (time_ok && now > 0) ? now : 0U,
-                                    cap_lat, cap_lon, cap_gps_valid);
+                sendTransitionEvent(state, EVENT_ARRIVED, 0.0f,
+                                    cap_gps_valid, cap_lat, cap_lon,
+                                    (time_ok && now > 0) ? now : 0U);
             }
 
         } else {
@@ -297,21 +321,55 @@ void setup()
 #endif
         }
 
-        // ── Attempt immediate delivery of any newly-queued event ─────────────
-        drainPendingQueue(state);
-
         // ── Steady-state behavior ─────────────────────────────────────────────
         if (state.current_state == STATE_MOVING) {
-            if (time_ok && now > 0 &&
-                now >= state.last_location_at + state.moving_ping_secs) {
+            if (time_ok && now > 0) {
+                // The policy sets the GNSS period until the next fix; every
+                // fix it accepts goes into the track buffer.  The period is
+                // re-applied whenever it differs from what the Notecard last
+                // accepted, so a failed card.location.mode heals next wake.
+                LocPolicyConfig cfg;
+                locPolicyConfigFor(state, cfg);
+                LocFix fix;
+                bool have_fix = readGnssFix(fix);
+                uint32_t prev_fix = state.loc.fix_time;
+                LocDecision d = locPolicyUpdate(&state.loc, &cfg,
+                                                have_fix ? &fix : NULL, now);
+                if (state.loc.fix_time != prev_fix) {
+                    bufferTrackFix(state, fix);
+                    locPolicyReported(&state.loc, now);
+                }
+                if (state.gps_period_secs != d.interval_secs) {
 #ifdef usbSerial
-                usbSerial.println("[location] queuing position note");
+                    usbSerial.print("[location] GNSS period ");
+                    usbSerial.print(d.interval_secs);
+                    usbSerial.print("s (backoff ");
+                    usbSerial.print(state.loc.backoff);
+                    usbSerial.println(")");
 #endif
-                if (sendLocationNote()) {
-                    state.last_location_at = now;
+                    setGnssPeriod(state, d.interval_secs);
+                }
+
+                // Queue the batch once it reaches moving_ping_secs, or when
+                // the next outbound sync falls before the next wake so the
+                // points ride that sync instead of waiting for the one after.
+                if (state.track.count > 0) {
+                    uint32_t next_wake = state.loc.interval_secs;
+                    if (next_wake == 0 || next_wake > MOVING_WAKE_MAX_SECS) {
+                        next_wake = MOVING_WAKE_MAX_SECS;
+                    }
+                    uint32_t since_sync = 0;
+                    bool due =
+                        trackAgeSecs(&state.track, now) >= state.moving_ping_secs ||
+                        (secsSinceOutboundSync(since_sync) &&
+                         since_sync % TRACK_SYNC_SECS + next_wake >= TRACK_SYNC_SECS);
+                    if (due) flushTrack(state);
                 }
             }
         } else {
+            // Retry a final trip batch that failed to queue on arrival.
+            if (state.track.count > 0) flushTrack(state);
+
             if (time_ok && now > 0 &&
                 now >= state.last_heartbeat_at + state.heartbeat_secs) {
                 float volt = 0.0f;
@@ -332,9 +390,14 @@ void setup()
         }
 
         // ── Compute sleep interval ────────────────────────────────────────────
-        sleep_secs = (state.current_state == STATE_MOVING)
-                     ? state.moving_ping_secs
-                     : state.parked_check_secs;
+        if (state.current_state == STATE_MOVING) {
+            sleep_secs = state.loc.interval_secs;
+            if (sleep_secs == 0 || sleep_secs > MOVING_WAKE_MAX_SECS) {
+                sleep_secs = MOVING_WAKE_MAX_SECS;
+            }
+        } else {
+            sleep_secs = state.parked_check_secs;
+        }
 
         if (state.current_state == STATE_PARKED &&
             state.last_heartbeat_at > 0 && time_ok && now > 0) {
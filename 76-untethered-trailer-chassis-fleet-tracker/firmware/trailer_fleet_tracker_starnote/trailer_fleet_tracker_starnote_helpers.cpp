@@ -155,6 +155,8 @@ bool notecardConfigure()
 //
 // The _lat / _lon / _time keywords instruct the Notecard to embed the current
 // GPS fix and timestamp from its internal state into each compact note.
+// trailer_track.qo carries its points in the binary payload instead (see
+// track_buffer.h for the layout); "length" reserves room for it.
 //
 // Returns true only after all three templates are confirmed by the Notecard
 // so that config_version is not committed on a partial failure.
@@ -178,20 +180,10 @@ bool defineTemplates()
     JAddNumberToObject(body, "lat",       14.1);  // TFLOAT32: GPS lat at transition
     JAddNumberToObject(body, "lon",       14.1);  // TFLOAT32: GPS lon at transition
     JAddNumberToObject(body, "evt_time",  14);    // TINT32: Unix epoch at transition
+    JAddNumberToObject(body, "boot",      14);    // TINT32: outbox generation (outbox.h)
+    JAddNumberToObject(body, "seq",       14);    // TINT32: outbox sequence within it
     if (!sendAndCheck(req, "note.template " NOTEFILE_EVENT)) return false;
 
-    // trailer_location.qo — periodic GPS position while moving
-    req = notecard.newRequest("note.template");
-    if (!req) return false;
-    JAddStringToObject(req, "file",   NOTEFILE_LOCATION);
-    JAddNumberToObject(req, "port",   PORT_LOCATION);
-    JAddStringToObject(req, "format", "compact");
-    body = JAddObjectToObject(req, "body");
-    JAddNumberToObject(body, "_lat",  14.1);
-    JAddNumberToObject(body, "_lon",  14.1);
-    JAddNumberToObject(body, "_time", 14);
-    if (!sendAndCheck(req, "note.template " NOTEFILE_LOCATION)) return false;
-
     // trailer_heartbeat.qo — periodic alive check while parked
     req = notecard.newRequest("note.template");
     if (!req) return false;
@@ -206,6 +198,17 @@ bool defineTemplates()
     JAddNumberToObject(body, "_time",     14);
     if (!sendAndCheck(req, "note.template " NOTEFILE_HEARTBEAT)) return false;
 
+    // trailer_track.qo — batched, simplified GPS track while moving
+    req = notecard.newRequest("note.template");
+    if (!req) return false;
+    JAddStringToObject(req, "file",   NOTEFILE_TRACK);
+    JAddNumberToObject(req, "port",   PORT_TRACK);
+    JAddStringToObject(req, "format", "compact");
+    JAddNumberToObject(req, "length", TRACK_PAYLOAD_MAX);
+    body = JAddObjectToObject(req, "body");
+    JAddNumberToObject(body, "points", 21);       // TUINT8: points in the payload
+    if (!sendAndCheck(req, "note.template " NOTEFILE_TRACK)) return false;
+
     return true;
 }
 
@@ -216,10 +219,9 @@ bool defineTemplates()
 // failure or a Notecard-reported error (e.g. no Notehub session yet), so the
 // caller can decide whether to record the poll timestamp or schedule a retry.
 //
-// moving_ping_secs is committed to `s` immediately when changed so it takes
-// effect on the host's next wake.  If the trailer is currently MOVING, the
-// matching card.location.mode call is issued right away; if parked, it is
-// applied on the next PARKED→MOVING departure by the state-machine code.
+// All values are committed to `s` immediately so they take effect on the
+// host's next wake.  None of them touches card.location.mode: the GNSS period
+// is chosen by the location policy on every moving wake.
 // ===========================================================================
 bool fetchEnvOverrides(AppState &s)
 {
@@ -245,33 +247,21 @@ bool fetchEnvOverrides(AppState &s)
             if (v >= 1 && v <= 60) s.parked_check_secs = v * 60;
         }
 
-        // moving_ping_mins: GPS report interval while moving (5–60 min).
-        // The stored value is updated immediately so it takes effect on the
-        // host's next wake and on the next PARKED→MOVING transition.
-        // If the trailer is currently MOVING (GPS in periodic mode), also
-        // re-sync card.location.mode right away so the Notecard's acquisition
-        // cadence matches the new interval without waiting for a transition.
-        // When parked (GPS off), the new period is applied automatically by
-        // the PARKED→MOVING departure code — no action needed here.
+        // moving_ping_mins: oldest fix a track batch may hold before it is
+        // queued (5–60 min).  Batches are otherwise closed just before the
+        // next expected outbound sync.
         val = JGetString(env, "moving_ping_mins");
         if (val && val[0]) {
             uint32_t v = (uint32_t)strtoul(val, NULL, 10);
-            if (v >= 5 && v <= 60) {
-                uint32_t new_secs = v * 60;
-                if (new_secs != s.moving_ping_secs) {
-                    s.moving_ping_secs = new_secs;
-                    if (s.current_state == STATE_MOVING) {
-                        J *loc = notecard.newRequest("card.location.mode");
-                        if (loc) {
-                            JAddStringToObject(loc, "mode",    "periodic");
-                            JAddNumberToObject(loc, "seconds", (double)new_secs);
-                            sendAndCheck(loc, "card.location.mode (env update)");
-                            // Failure is acceptable: the correct period will be
-                            // re-applied on the next PARKED→MOVING transition.
-                        }
-                    }
-                }
-            }
+            if (v >= 5 && v <= 60) s.moving_ping_secs = v * 60;
+        }
+
+        // track_error_m: how far the uploaded track may stray from the
+        // buffered fixes when it is simplified (10–500 m).
+        val = JGetString(env, "track_error_m");
+        if (val && val[0]) {
+            uint32_t v = (uint32_t)strtoul(val, NULL, 10);
+            if (v >= 10 && v <= 500) s.track_error_m = v;
         }
 
         // heartbeat_hours: alive-ping interval while parked (1–24 hr)
@@ -376,13 +366,92 @@ bool hasValidGnssFix()
     return (lat != 0.0 || lon != 0.0);
 }
 
+// Read the Notecard's latest GNSS fix for the location policy.
+//
+// Returns false when there is no fix (zero lat/lon or no fix time) or the
+// request fails.  ttff_secs is taken from the card.location status string,
+// e.g. "GPS updated (58 sec, 41dB SNR, 9 sats) ...", where the figure is
+// the time the last acquisition took; it is left 0 when the status does not
+// carry one, and the policy then judges the sky by missed fixes alone.
+bool readGnssFix(LocFix &out_fix)
+{
+    memset(&out_fix, 0, sizeof(out_fix));
+
+    J *req = notecard.newRequest("card.location");
+    if (!req) return false;
+    J *rsp = notecard.requestAndResponse(req);
+    if (!rsp) return false;
+
+    const char *err = JGetString(rsp, "err");
+    if (err && err[0]) {
+        notecard.deleteResponse(rsp);
+        return false;
+    }
+
+    double   lat  = JGetNumber(rsp, "lat");
+    double   lon  = JGetNumber(rsp, "lon");
+    uint32_t time = (uint32_t)JGetInt(rsp, "time");
+    const char *status  = JGetString(rsp, "status");
+    const char *updated = status ? strstr(status, "updated (") : NULL;
+    if (updated) {
+        unsigned long secs = strtoul(updated + 9, NULL, 10);
+        out_fix.ttff_secs = (uint16_t)(secs > 0xFFFF ? 0xFFFF : secs);
+    }
+    notecard.deleteResponse(rsp);
+
+    if ((lat == 0.0 && lon == 0.0) || time == 0) return false;
+    out_fix.lat  = (float)lat;
+    out_fix.lon  = (float)lon;
+    out_fix.time = time;
+    return true;
+}
+
+// Apply a GNSS period with card.location.mode periodic and record it in
+// s.gps_period_secs.  On failure the recorded period is left unchanged, so
+// the next moving wake retries.
+bool setGnssPeriod(AppState &s, uint32_t secs)
+{
+    J *loc = notecard.newRequest("card.location.mode");
+    if (!loc) return false;
+    JAddStringToObject(loc, "mode",    "periodic");
+    JAddNumberToObject(loc, "seconds", (double)secs);
+    if (!sendAndCheck(loc, "card.location.mode periodic")) return false;
+    s.gps_period_secs = secs;
+    return true;
+}
+
+// Seconds since the Notecard last completed a sync, from hub.sync.status.
+// Returns false when the request fails or no sync has completed since boot.
+bool secsSinceOutboundSync(uint32_t &out_secs)
+{
+    J *req = notecard.newRequest("hub.sync.status");
+    if (!req) return false;
+    J *rsp = notecard.requestAndResponse(req);
+    if (!rsp) return false;
+
+    const char *err = JGetString(rsp, "err");
+    bool ok = !(err && err[0]) && JIsPresent(rsp, "completed");
+    if (ok) out_secs = (uint32_t)JGetInt(rsp, "completed");
+    notecard.deleteResponse(rsp);
+    return ok;
+}
+
+// Location policy tunables: compiled-in defaults. Every accepted fix is
+// buffered for the track, so only the policy's fix interval is applied; its
+// per-fix report decision is not used.
+void locPolicyConfigFor(const AppState &s, LocPolicyConfig &out_cfg)
+{
+    locPolicyDefaults(&out_cfg);
+    out_cfg.max_report_secs = s.moving_ping_secs;
+}
+
 // Capture the Notecard's current GNSS state for transition event stamping.
 //
 // Distinct from hasValidGnssFix(): returns the raw lat/lon values so callers
-// can persist them in the pending-event queue.  Called once per detected
-// transition; the stored values are passed through every delivery attempt so
-// retried departure/arrival notes carry the detection-time location and epoch
-// — not the GPS state at retry time.
+// write them into the event body.  Called once per detected transition; a
+// note held in the outbox is replayed with that body unchanged, so a
+// retried departure/arrival note carries the detection-time location and
+// epoch — not the GPS state at retry time.
 //
 // Calling context and GPS mode at capture time:
 //   PARKED→MOVING (departure): called before GPS is re-enabled, so GPS mode
@@ -390,12 +459,12 @@ bool hasValidGnssFix()
 //     from the prior trip, which may be stale after a long dwell.  gps_valid
 //     is still 1 if a fix exists; its freshness is bounded by the prior trip.
 //   MOVING→PARKED (arrival): called while GPS is still in periodic mode, so
-//     the cached fix is within one moving_ping_secs interval of the actual stop.
+//     the cached fix is within one GNSS period of the actual stop.
 //
 // card.location always returns the last cached fix regardless of GPS mode
 // (periodic or off); no additional GPS-on time is incurred by this call.
 // Timestamp accuracy is bounded by parked_check_secs (departures) or
-// moving_ping_secs (arrivals).  On this hardware GPS is provided by the
+// MOVING_WAKE_MAX_SECS (arrivals).  On this hardware GPS is provided by the
 // Starnote for Iridium's combined Iridium+GPS antenna; the standard
 // card.location API returns the fix transparently.
 //
@@ -433,87 +502,123 @@ void captureGnssState(float &out_lat, float &out_lon, uint8_t &out_gps_valid)
 // Note emission
 // ===========================================================================
 
-// Send a transition event (departed / arrived) with sync:true.
+// Send a transition event (departed / arrived) with sync:true through the
+// outbox.
 //
 // All location and time fields are passed in from values captured at
 // transition detection time (the wake where the state change was observed),
 // via captureGnssState / getEpoch in setup().  No GPS state queries are made
-// inside this function so that retried events always carry the original
-// detection-time location and timestamp, not whatever the Notecard happens to
-// have cached at retry time.  Timestamp accuracy is bounded by
-// parked_check_secs (departures) or moving_ping_secs (arrivals).
-// Transition events are never suppressed; the receiver uses gps_valid to
-// distinguish a confirmed location (1) from a no-fix placeholder (0).
-//
-// Retries up to three times so a transient I²C hiccup or busy Notecard does
-// not silently drop the highest-value business event.
-// Returns true only when the Notecard confirms a successful queue operation.
-bool sendTransitionEvent(uint8_t type, float dwell_hours,
-                          uint8_t gps_valid, float lat, float lon,
-                          uint32_t evt_epoch)
+// inside this function, and a note.add that fails holds the finished body in
+// the outbox, so a replay on a later wake carries the original detection-time
+// location and timestamp, not whatever the Notecard has cached by then.
+// Timestamp accuracy is bounded by parked_check_secs (departures) or
+// MOVING_WAKE_MAX_SECS (arrivals).  Transition events are never suppressed;
+// the receiver uses gps_valid to distinguish a confirmed location (1) from a
+// no-fix placeholder (0), and drops the duplicate a lost I²C acknowledgement
+// can produce by boot/seq (added by the outbox).
+OutboxResult sendTransitionEvent(AppState &s, uint8_t type, float dwell_hours,
+                                 uint8_t gps_valid, float lat, float lon,
+                                 uint32_t evt_epoch)
 {
-#ifdef usbSerial
-    usbSerial.print("[event] type=");
-    usbSerial.print(type);
-    usbSerial.print(" gps_valid=");
-    usbSerial.println(gps_valid);
-#endif
-
-    for (int attempt = 0; attempt < 3; ++attempt) {
-        if (attempt > 0) delay(500);
-
-        J *req = notecard.newRequest("note.add");
-        if (!req) continue;
-        JAddStringToObject(req, "file", NOTEFILE_EVENT);
-        JAddBoolToObject(req, "sync", true);
-        J *body = JAddObjectToObject(req, "body");
+    J *body = JCreateObject();
+    if (body) {
         JAddNumberToObject(body, "type",      (double)type);
         JAddNumberToObject(body, "dwell_h",   (double)dwell_hours);
         JAddNumberToObject(body, "gps_valid", (double)gps_valid);
-        // lat, lon, evt_time are written explicitly from the values captured
-        // at transition time — not from the Notecard's current GPS state.
         JAddNumberToObject(body, "lat",       (double)lat);
         JAddNumberToObject(body, "lon",       (double)lon);
         JAddNumberToObject(body, "evt_time",  (double)evt_epoch);
-        J *rsp = notecard.requestAndResponse(req);
-        if (!rsp) continue;
-
-        const char *err = JGetString(rsp, "err");
-        bool ok = !(err && err[0]);
-        notecard.deleteResponse(rsp);
-        if (ok) return true;
     }
+    OutboxResult result = outboxAdd(s.outbox, NOTEFILE_EVENT, true, body);
 
 #ifdef usbSerial
-    usbSerial.println("[event] failed to queue transition note after 3 attempts");
+    usbSerial.print("[event] type=");
+    usbSerial.print(type);
+    usbSerial.print(" gps_valid=");
+    usbSerial.print(gps_valid);
+    usbSerial.println(result == OUTBOX_SENT    ? " queued" :
+                      result == OUTBOX_QUEUED  ? " held for replay" :
+                      result == OUTBOX_SPILLED ? " spilled for replay" :
+                                                 " dropped");
 #endif
-    return false;
+    return result;
 }
 
-// Queue a GPS position note for batched cellular (or Iridium satellite) delivery.
-// Suppressed when no valid GNSS fix is available; last_location_at is not
-// advanced on suppression so the note is retried on the next moving-state wake.
-bool sendLocationNote()
+// Replay transition events held on earlier wakes, oldest first, up to
+// OUTBOX_FLUSH_MAX per wake.  Called before the motion state machine so a
+// new transition follows the older events into the Notecard queue.
+void flushTransitionEvents(AppState &s)
 {
-    if (!hasValidGnssFix()) {
+    if (outboxPending(s.outbox) == 0) return;
+    uint32_t drained = outboxFlush(s.outbox);
 #ifdef usbSerial
-        usbSerial.println("[location] no valid GNSS fix; note suppressed");
+    usbSerial.print("[event] replayed ");
+    usbSerial.print(drained);
+    usbSerial.print(" held event(s); ");
+    usbSerial.print(outboxPending(s.outbox));
+    usbSerial.println(" still waiting");
+#else
+    (void)drained;
 #endif
-        return false;
-    }
+}
 
-    J *req = notecard.newRequest("note.add");
-    if (!req) return false;
-    JAddStringToObject(req, "file", NOTEFILE_LOCATION);
-    JAddObjectToObject(req, "body");
+// Add a fix accepted by the location policy to the track buffer.  When every
+// buffered point is significant the batch is queued early to make room; if
+// that fails too, the oldest point is given up so the newest is never lost.
+void bufferTrackFix(AppState &s, const LocFix &fix)
+{
+    float tol = (float)s.track_error_m;
+    if (trackAppend(&s.track, fix.lat, fix.lon, fix.time, tol)) return;
+#ifdef usbSerial
+    usbSerial.println("[track] buffer full of significant points; queuing early");
+#endif
+    if (!flushTrack(s)) trackDropOldest(&s.track);
+    trackAppend(&s.track, fix.lat, fix.lon, fix.time, tol);
+}
 
-    J *rsp = notecard.requestAndResponse(req);
-    if (!rsp) return false;
+// Queue the buffered fixes as trailer_track.qo Notes for batched cellular
+// (or Iridium satellite) delivery.  The buffer is simplified to within
+// track_error_m and delta-encoded into the binary payload; a batch that does
+// not fit TRACK_PAYLOAD_MAX continues in a second Note.  Points leave the
+// buffer only once the Notecard has accepted the Note carrying them, so a
+// failed note.add is retried, with any newer fixes, on a later wake.
+bool flushTrack(AppState &s)
+{
+    while (s.track.count > 0) {
+        uint8_t  buf[TRACK_PAYLOAD_MAX];
+        uint8_t  points = 0;
+        uint16_t len = trackEncode(&s.track, (float)s.track_error_m,
+                                   buf, sizeof(buf), &points);
+        if (!len) return false;
 
-    const char *err = JGetString(rsp, "err");
-    bool ok = !(err && err[0]);
-    notecard.deleteResponse(rsp);
-    return ok;
+        J *req = notecard.newRequest("note.add");
+        if (!req) return false;
+        JAddStringToObject(req, "file", NOTEFILE_TRACK);
+        J *body = JAddObjectToObject(req, "body");
+        JAddNumberToObject(body, "points", (double)points);
+        if (!JAddBinaryToObject(req, "payload", buf, len)) {
+            JDelete(req);
+            return false;
+        }
+
+        J *rsp = notecard.requestAndResponse(req);
+        if (!rsp) return false;
+
+        const char *err = JGetString(rsp, "err");
+        bool ok = !(err && err[0]);
+        notecard.deleteResponse(rsp);
+        if (!ok) return false;
+
+#ifdef usbSerial
+        usbSerial.print("[track] queued ");
+        usbSerial.print(points);
+        usbSerial.print(" points in ");
+        usbSerial.print(len);
+        usbSerial.println(" bytes");
+#endif
+        trackConsume(&s.track, points);
+    }
+    return true;
 }
 
 // Queue a parked heartbeat note carrying the current LiPo voltage.
@@ -536,76 +641,3 @@ bool sendHeartbeatNote(float volt)
     notecard.deleteResponse(rsp);
     return ok;
 }
-
-// ===========================================================================
-// enqueuePendingEvent — push a transition event onto the FIFO ring buffer.
-//
-// All location/time fields must be supplied from values captured at
-// transition detection time (via captureGnssState and getEpoch in setup())
-// so that every delivery attempt carries the detection-time metadata rather
-// than whatever the Notecard's GPS state happens to be at retry time.
-//
-// Returns true when the event was added, false when the FIFO is full.
-// A full FIFO (PENDING_QUEUE_DEPTH consecutive undelivered events) indicates
-// a persistent Notecard communication failure; the oldest queued event is
-// retained in its position and the new one is dropped with a log line.  In
-// normal operation the FIFO drains to empty on every wake and never exceeds
-// a depth of 2.
-// ===========================================================================
-bool enqueuePendingEvent(AppState &s, uint8_t type, float dwell_h,
-                          uint32_t event_epoch, float event_lat,
-                          float event_lon, uint8_t gps_valid)
-{
-    if (s.pending_count >= PENDING_QUEUE_DEPTH) {
-#ifdef usbSerial
-        usbSerial.println("[event] pending queue full; event dropped");
-#endif
-        return false;
-    }
-    uint8_t tail = (s.pending_head + s.pending_count) % PENDING_QUEUE_DEPTH;
-    PendingEvent &slot  = s.pending_events[tail];
-    slot.type           = type;
-    slot.gps_valid      = gps_valid;
-    slot._pad[0]        = 0;
-    slot._pad[1]        = 0;
-    slot.dwell_h        = dwell_h;
-    slot.event_epoch    = event_epoch;
-    slot.event_lat      = event_lat;
-    slot.event_lon      = event_lon;
-    s.pending_count++;
-    return true;
-}
-
-// ===========================================================================
-// drainPendingQueue — attempt to deliver all queued transition events.
-//
-// Processes the FIFO from head (oldest) toward tail (newest).  Each
-// successful delivery dequeues the head event and advances to the next.
-// Draining stops at the first failed delivery so that events are never
-// delivered out of order; the failed event remains at the head for retry
-// on the next wake.
-//
-// Called twice per wake cycle: once before the motion state machine (drains
-// any stale events from prior wakes) and once after (immediately attempts
-// delivery of any event just enqueued by a fresh state transition).
-// ===========================================================================
-void drainPendingQueue(AppState &s)
-{
-    while (s.pending_count > 0) {
-        PendingEvent &e = s.pending_events[s.pending_head];
-        float dh = (e.type == EVENT_DEPARTED) ? e.dwell_h : 0.0f;
-#ifdef usbSerial
-        usbSerial.print("[event] draining pending event type=");
-        usbSerial.println(e.type);
-#endif
-        if (!sendTransitionEvent(e.type, dh,
-                                  e.gps_valid, e.event_lat, e.event_lon,
-                                  e.event_epoch)) {
-            break;
-        }
-        e.type    = 0;
-        e.dwell_h = 0.0f;
-        s.pending_head = (s.pending_head + 1) % PENDING_QUEUE_DEPTH;
-        s.pending_count--;
-    }
-}
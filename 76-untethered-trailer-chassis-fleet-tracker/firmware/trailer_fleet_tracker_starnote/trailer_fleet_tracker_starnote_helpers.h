@@ -11,6 +11,10 @@
 
 #include <Notecard.h>
 
+#include "location_policy.h"
+#include "outbox.h"
+#include "track_buffer.h"
+
 // ---------------------------------------------------------------------------
 // Product UID — copy from Notehub → Project Settings → ProductUID
 // ---------------------------------------------------------------------------
@@ -32,13 +36,14 @@
 // Notefiles (all compact-templated for satellite efficiency)
 // ---------------------------------------------------------------------------
 #define NOTEFILE_EVENT      "trailer_event.qo"
-#define NOTEFILE_LOCATION   "trailer_location.qo"
 #define NOTEFILE_HEARTBEAT  "trailer_heartbeat.qo"
+#define NOTEFILE_TRACK      "trailer_track.qo"
 
-// Compact template port numbers (required for compact format; unique per project)
+// Compact template port numbers (required for compact format; unique per project).
+// Port 51 belonged to trailer_location.qo, replaced by trailer_track.qo in v4.
 #define PORT_EVENT          50
-#define PORT_LOCATION       51
 #define PORT_HEARTBEAT      52
+#define PORT_TRACK          53
 
 // ---------------------------------------------------------------------------
 // State constants
@@ -53,9 +58,16 @@
 // Firmware defaults — all overridable via Notehub environment variables
 // ---------------------------------------------------------------------------
 #define DEFAULT_PARKED_CHECK_SECS   300     //  5 min: motion poll cadence when parked
-#define DEFAULT_MOVING_PING_SECS    900     // 15 min: GPS report cadence when moving
+#define DEFAULT_MOVING_PING_SECS    3600    //  1 hr:  oldest fix a track batch may hold
+#define DEFAULT_TRACK_ERROR_M       50      // 50 m:   track simplification error bound
 #define DEFAULT_HEARTBEAT_SECS      21600   //  6 hr:  alive-ping cadence when parked
 
+// Longest host sleep while moving.  The GNSS fix interval chosen by the
+// location policy (location_policy.h) can stretch past this under poor sky,
+// but card.motion is still checked at least this often so arrival detection
+// keeps its 15-minute bound.
+#define MOVING_WAKE_MAX_SECS        900
+
 // Voltage-variable outbound sync (hub.set voutbound) — reduces cellular
 // activity on a low or depleted solar battery.  notecardConfigure() issues
 // `card.voltage {"mode":"lipo"}` which sets the bucket thresholds to:
@@ -66,6 +78,11 @@
 // Env-var poll interval: check Notehub for updated thresholds once per hour
 #define ENV_POLL_SECS       3600
 
+// Outbound sync interval on a charged battery (VOUTBOUND_PROFILE "high").
+// Track batches are closed just before the next expected sync, so batching
+// adds no delay beyond what the outbound cadence already imposes.
+#define TRACK_SYNC_SECS     3600
+
 // Increment whenever a firmware update changes Notecard configuration or note
 // templates.  The persisted config_version field is compared on every wake; a
 // mismatch triggers a full re-configure so Notecard-side settings stay in sync
@@ -80,33 +97,25 @@
 //           auto-populated keywords replaced with explicit lat/lon/evt_time
 //           fields written from the stored capture.  AppState layout changed —
 //           any restored v1 payload is treated as first-boot.
-#define FIRMWARE_CONFIG_VERSION   2
-
-// ---------------------------------------------------------------------------
-// Pending-event FIFO — persisted inside AppState so in-flight transition
-// events survive sleep and are retried in FIFO order until the Notecard
-// confirms receipt.  Using a queue rather than a single slot prevents a new
-// transition from overwriting an undelivered prior event (e.g. a failed
-// DEPARTED immediately followed by an ARRIVED before the first retry lands).
-// ---------------------------------------------------------------------------
-#define PENDING_QUEUE_DEPTH  4
-
-// One slot in the pending-event ring buffer.
-// sizeof(PendingEvent) == 20 bytes.
-// gps_valid, event_epoch, event_lat, and event_lon are captured once at
-// transition time (not at retry time) so that every delivery attempt for a
-// given transition event carries the correct original location and timestamp,
-// regardless of how much GPS state has changed between the transition and the
-// eventual successful delivery.
-typedef struct {
-    uint8_t  type;          // 0=none, EVENT_DEPARTED, or EVENT_ARRIVED
-    uint8_t  gps_valid;     // 1=valid fix captured at transition time, 0=no fix
-    uint8_t  _pad[2];       // explicit alignment padding; always 0
-    float    dwell_h;       // hours parked before departure (0.0 for arrivals)
-    uint32_t event_epoch;   // Unix epoch captured at transition time (0=unknown)
-    float    event_lat;     // GPS latitude captured at transition time
-    float    event_lon;     // GPS longitude captured at transition time
-} PendingEvent;
+// v2 → v3: adaptive location policy.  AppState gains the persisted
+//           LocPolicyState, the applied GNSS period and report_distance_m;
+//           last_location_at is replaced by the policy's own report time.
+//           moving_ping_secs now bounds the silence between position reports
+//           rather than setting the GNSS cadence.
+// v3 → v4: batched track upload.  Every accepted fix goes into a persisted
+//           TrackBuffer and is queued, Douglas-Peucker-simplified and
+//           delta-encoded, as one trailer_track.qo per batch;
+//           trailer_location.qo is no longer written.  report_distance_m is
+//           replaced by track_error_m, and moving_ping_secs now bounds the
+//           age of a batch.
+// v4 → v5: transition events go through the durable outbox (outbox.h).
+//           The PendingEvent FIFO is replaced by the outbox indices, and
+//           trailer_event.qo gains the boot/seq dedup fields.
+// v5 → v6: the outbox gains a ready flag; outboxBegin() is retried every
+//           wake until it has read the outbox meta Note.
+// v6 → v7: the outbox holds its first failed Notes in a ring in the state
+//           before it spills any to the Notecard.
+#define FIRMWARE_CONFIG_VERSION   7
 
 // ---------------------------------------------------------------------------
 // Persisted application state (saved to Notecard flash across sleep cycles)
@@ -115,23 +124,22 @@ typedef struct {
     uint8_t      config_version;          // re-configure when != FIRMWARE_CONFIG_VERSION
     uint8_t      current_state;           // STATE_PARKED or STATE_MOVING
     uint8_t      parked_since_needs_init; // 1: parked_since not yet set with a valid epoch
-    uint8_t      pending_head;            // ring-buffer read index (0–PENDING_QUEUE_DEPTH-1)
-    uint8_t      pending_count;           // number of events currently in the FIFO
-    uint8_t      _reserved[3];            // alignment padding to reach 8-byte boundary; always 0
+    uint8_t      _reserved[5];            // alignment padding to reach 8-byte boundary; always 0
     uint32_t     parked_since;            // Unix epoch when trailer last parked (dwell calc)
-    uint32_t     last_location_at;        // Unix epoch of last trailer_location.qo
+    uint32_t     gps_period_secs;         // period last applied by card.location.mode (0 = off)
     uint32_t     last_heartbeat_at;       // Unix epoch of last trailer_heartbeat.qo
     uint32_t     last_env_poll_at;        // Unix epoch of last env.get call
     uint32_t     parked_check_secs;       // from env var parked_check_mins
     uint32_t     moving_ping_secs;        // from env var moving_ping_mins
     uint32_t     heartbeat_secs;          // from env var heartbeat_hours
-    // Pending transition-event FIFO.  Physical state is committed at the
-    // moment of a PARKED↔MOVING transition regardless of whether the
-    // corresponding note.add succeeds.  Events are queued here and drained
-    // in FIFO order on every wake until the Notecard confirms acceptance.
-    // A FIFO prevents a new transition from overwriting an undelivered prior
-    // event — e.g. a failed DEPARTED immediately followed by an ARRIVED.
-    PendingEvent pending_events[PENDING_QUEUE_DEPTH]; // ring buffer; head at pending_head
+    uint32_t     track_error_m;           // from env var track_error_m
+    LocPolicyState loc;                   // adaptive GNSS duty cycle (moving only)
+    TrackBuffer  track;                   // fixes not yet queued in a trailer_track.qo
+    // Transition events the Notecard didn't accept are held in the outbox
+    // (its ring here, then its spill on the Notecard) and replayed in order
+    // on later wakes.  Physical state is committed at the moment of a
+    // PARKED↔MOVING transition regardless of delivery.
+    Outbox       outbox;
 } AppState;
 
 // ---------------------------------------------------------------------------
@@ -151,13 +159,15 @@ bool     isMoving(bool &out_moving);
 bool     getEpoch(uint32_t &out_time);
 bool     getBatteryVoltage(float &out_volt);
 bool     hasValidGnssFix();
+bool     readGnssFix(LocFix &out_fix);
+bool     setGnssPeriod(AppState &s, uint32_t secs);
+bool     secsSinceOutboundSync(uint32_t &out_secs);
+void     locPolicyConfigFor(const AppState &s, LocPolicyConfig &out_cfg);
 void     captureGnssState(float &out_lat, float &out_lon, uint8_t &out_gps_valid);
-bool     sendTransitionEvent(uint8_t type, float dwell_hours,
-                              uint8_t gps_valid, float lat, float lon,
-                              uint32_t evt_epoch);
-bool     sendLocationNote();
+OutboxResult sendTransitionEvent(AppState &s, uint8_t type, float dwell_hours,
+                                 uint8_t gps_valid, float lat, float lon,
+                                 uint32_t evt_epoch);
+void     flushTransitionEvents(AppState &s);
+void     bufferTrackFix(AppState &s, const LocFix &fix);
+bool     flushTrack(AppState &s);
 bool     sendHeartbeatNote(float volt);
-bool     enqueuePendingEvent(AppState &s, uint8_t type, float dwell_h,
-                              uint32_t event_epoch, float event_lat,
-                              float event_lon, uint8_t gps_valid);
-void     drainPendingQueue(AppState &s);
@@ -0,0 +1,601 @@
+// location_policy_sim.cpp — replays GPS tracks through the adaptive location
+// policy and the track buffer, and compares them with the fixed moving_ping
+// cadence they replace.
+//
+// For every moving second of every trip the simulator knows the true
+// position, whether card.motion reports "moving", and the sky view at the
+// antenna.  Three policies drive the same simulated Notecard GNSS:
+//
+//   fixed     — the original firmware: card.location.mode periodic every
+//               900 s, a host wake every 900 s, and a trailer_location.qo on
+//               every wake that finds a cached fix.
+//   adaptive  — location_policy.h with one position Note per report, the
+//               host waking every min(fix interval, 900 s).
+//   track     — the current firmware: the same policy and fix spacing,
+//               every fix buffered in track_buffer.h and queued as a
+//               simplified trailer_track.qo batch, exactly as flushTrack()
+//               packs it.
+//
+// The GNSS model starts an acquisition at each period; it succeeds after a
+// time-to-fix drawn for the sky class, or gives up after GNSS_TIMEOUT_S.  It
+// reports fix attempts, GNSS on-time (the energy proxy), position Notes and
+// their body bytes, and two errors against the true track:
+//
+//   route error — distance from each true position to the polyline through
+//                 the reported fixes (how faithfully the trip is drawn);
+//   live error  — distance from each true position to the newest fix
+//                 Notehub has at that moment (how far off the dispatcher's
+//                 map is).  Notes reach Notehub at the next hourly outbound
+//                 sync.
+//
+// Seconds with no sky view are left out of both errors: no policy can see
+// them, and a twelve-day crossing would otherwise swamp every other leg.
+//
+// With no arguments it replays a built-in, deterministic 30-day itinerary
+// for a drayage chassis (port / highway / urban legs, terminal queues and an
+// ocean crossing stowed below deck).  A recorded track can be replayed
+// instead:
+//
+//   ./location_policy_sim track.csv
+//
+// with one "epoch,lat,lon[,moving[,sky]]" line per fix; sky is 0 open,
+// 1 urban, 2 container stacks, 3 no sky.  Gaps longer than 10 minutes split
+// trips; shorter gaps are interpolated to 1 s.
+//
+// Build and run from this directory:
+//   g++ -O2 -std=c++11 -I../firmware/trailer_fleet_tracker_starnote location_policy_sim.cpp -o location_policy_sim
+//   ./location_policy_sim
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <vector>
+
+#include "location_policy.h"
+#include "track_buffer.h"
+
+// ---------------------------------------------------------------------------
+// Model constants
+// ---------------------------------------------------------------------------
+static const uint32_t FIXED_PING_S   = 900;   // DEFAULT_MOVING_PING_SECS before the policy
+static const uint32_t MAX_WAKE_S     = 900;   // host wake ceiling while moving (arrival detection)
+static const uint32_t GNSS_TIMEOUT_S = 180;   // acquisition abandoned after this long
+static const double   FIX_NOISE_M    = 5.0;   // 1-sigma horizontal fix error
+static const uint32_t TRIP_GAP_S     = 600;   // CSV gap that splits trips
+static const uint32_t OUTBOUND_S     = 3600;  // VOUTBOUND_PROFILE "high:60"
+static const uint32_t POINT_NOTE_B   = 12;    // per-fix Note body: _lat, _lon, _time
+static const uint32_t TRACK_BATCH_S  = 3600;  // DEFAULT_MOVING_PING_SECS: oldest buffered fix
+static const float    TRACK_ERROR_M  = 50.0f; // DEFAULT_TRACK_ERROR_M
+
+enum Sky { SKY_OPEN, SKY_URBAN, SKY_STACKS, SKY_NONE };
+
+// Time-to-fix range and failure probability per sky class, for a periodic
+// (hot/warm start) acquisition.
+static const struct { uint32_t ttff_lo, ttff_hi; double fail; } kSky[] = {
+    {  4,  30, 0.01 },   // open
+    { 20,  90, 0.10 },   // urban canyon
+    { 60, 170, 0.50 },   // container stacks / terminal cranes
+    {  0,   0, 1.00 },   // below deck
+};
+
+struct Sample {
+    double  lat, lon;
+    uint8_t moving;
+    uint8_t sky;
+};
+
+struct Trip {
+    uint32_t            start;   // epoch of samples[0]
+    std::vector<Sample> s;       // one per second
+};
+
+// ---------------------------------------------------------------------------
+// Deterministic PRNG (xorshift32) so every run prints the same numbers.
+// ---------------------------------------------------------------------------
+static uint32_t g_rng = 0x5EED1234u;
+
+static uint32_t rnd() {
+    g_rng ^= g_rng << 13;
+    g_rng ^= g_rng >> 17;
+    g_rng ^= g_rng << 5;
+    return g_rng;
+}
+static double rndUnit()                     { return (rnd() >> 8) * (1.0 / 16777216.0); }
+static double rndRange(double lo, double hi) { return lo + (hi - lo) * rndUnit(); }
+static double rndGauss() {
+    double u = rndUnit() + 1e-12, v = rndUnit();
+    return sqrt(-2.0 * log(u)) * cos(2.0 * M_PI * v);
+}
+
+// ---------------------------------------------------------------------------
+// Geometry in double precision (the reference, independent of the policy's
+// float projection).
+// ---------------------------------------------------------------------------
+static const double R_EARTH = 6371000.0;
+static const double D2R     = M_PI / 180.0;
+
+static void project(double lat0, double lon0, double lat, double lon, double *x, double *y) {
+    double dlon = lon - lon0;
+    if (dlon > 180.0)  dlon -= 360.0;
+    if (dlon < -180.0) dlon += 360.0;
+    *x = dlon * D2R * R_EARTH * cos(lat0 * D2R);
+    *y = (lat - lat0) * D2R * R_EARTH;
+}
+
+static double distM(double lat0, double lon0, double lat1, double lon1) {
+    double x, y;
+    project(lat0, lon0, lat1, lon1, &x, &y);
+    return sqrt(x * x + y * y);
+}
+
+// Distance from p to segment a-b, in a plane tangent at p.
+static double segDistM(double plat, double plon, double alat, double alon,
+                       double blat, double blon) {
+    double ax, ay, bx, by;
+    project(plat, plon, alat, alon, &ax, &ay);
+    project(plat, plon, blat, blon, &bx, &by);
+    double dx = bx - ax, dy = by - ay;
+    double len2 = dx * dx + dy * dy;
+    double t = len2 > 0.0 ? -(ax * dx + ay * dy) / len2 : 0.0;
+    if (t < 0.0) t = 0.0;
+    if (t > 1.0) t = 1.0;
+    double cx = ax + t * dx, cy = ay + t * dy;
+    return sqrt(cx * cx + cy * cy);
+}
+
+// ---------------------------------------------------------------------------
+// Built-in itinerary
+// ---------------------------------------------------------------------------
+struct Walker {
+    double  lat, lon, heading;   // heading in degrees
+    uint32_t t;
+    Trip   *trip;
+};
+
+static void step(Walker &w, double speed, uint8_t moving, uint8_t sky) {
+    double h = w.heading * D2R;
+    w.lat += speed * cos(h) / R_EARTH / D2R;
+    w.lon += speed * sin(h) / (R_EARTH * cos(w.lat * D2R)) / D2R;
+    Sample s = { w.lat, w.lon, moving, sky };
+    w.trip->s.push_back(s);
+    w.t++;
+}
+
+// Interstate: ~27 m/s with gentle bends and the odd interchange.
+static void highway(Walker &w, uint32_t secs) {
+    double turn_rate = 0.0;
+    uint32_t seg_left = 0;
+    for (uint32_t i = 0; i < secs; ++i) {
+        if (!seg_left) {
+            seg_left = (uint32_t)rndRange(300, 1500);
+            double r = rndUnit();
+            turn_rate = r < 0.55 ? 0.0 : (r < 0.9 ? rndRange(-0.03, 0.03) : rndRange(-0.12, 0.12));
+        }
+        seg_left--;
+        w.heading += turn_rate;
+        step(w, 27.0 + rndGauss() * 1.0, 1, SKY_OPEN);
+    }
+}
+
+// Urban drayage: 400–900 m blocks, right-angle turns, signal stops.
+static void urban(Walker &w, uint32_t secs) {
+    uint32_t i = 0;
+    while (i < secs) {
+        double block = rndRange(400, 900);
+        double v = rndRange(9, 15);
+        for (double d = 0; d < block && i < secs; d += v, ++i) step(w, v, 1, SKY_URBAN);
+        uint32_t stop = rnd() % 3 == 0 ? (uint32_t)rndRange(20, 70) : 0;
+        for (uint32_t k = 0; k < stop && i < secs; ++k, ++i) step(w, 0.0, 1, SKY_URBAN);
+        if (rnd() % 2) w.heading += (rnd() % 2) ? 90.0 : -90.0;
+    }
+}
+
+// Terminal gate queue / yard: creeping in place under the stacks.
+static void yard(Walker &w, uint32_t secs) {
+    uint32_t i = 0;
+    while (i < secs) {
+        uint32_t wait = (uint32_t)rndRange(120, 600);
+        for (uint32_t k = 0; k < wait && i < secs; ++k, ++i) step(w, 0.0, 1, SKY_STACKS);
+        uint32_t creep = (uint32_t)rndRange(5, 25);
+        for (uint32_t k = 0; k < creep && i < secs; ++k, ++i) step(w, 2.0, 1, SKY_STACKS);
+        if (rnd() % 4 == 0) w.heading += rndRange(-90, 90);
+    }
+}
+
+// Ocean leg, stowed below deck: rolling (so card.motion says moving) with no
+// sky at all.
+static void ocean(Walker &w, uint32_t secs) {
+    for (uint32_t i = 0; i < secs; ++i) {
+        if (i % 3600 == 0) w.heading += rndRange(-2, 2);
+        step(w, 9.5, 1, SKY_NONE);
+    }
+}
+
+static void beginTrip(std::vector<Trip> &trips, Walker &w) {
+    trips.push_back(Trip());
+    trips.back().start = w.t;
+    w.trip = &trips.back();
+}
+
+static void park(Walker &w, uint32_t secs) { w.t += secs; }
+
+static std::vector<Trip> builtinItinerary() {
+    std::vector<Trip> trips;
+    trips.reserve(128);
+    Walker w = { 33.75, -118.22, 0.0, 1767225600u, NULL };   // Port of Los Angeles
+
+    for (int day = 0; day < 30; ++day) {
+        if (day >= 10 && day < 22) {
+            // Days 10–21: one ocean crossing, loaded below deck.
+            if (day == 10) {
+                beginTrip(trips, w);
+                yard(w, 3 * 3600);
+                w.heading = 250.0;
+                ocean(w, 11 * 86400 + 20 * 3600);
+                yard(w, 2 * 3600);
+                park(w, 86400 - (3 * 3600 + 20 * 3600 + 2 * 3600) % 86400);
+            }
+            continue;
+        }
+        // Port run: terminal queue, urban, highway out and back, urban.
+        park(w, (uint32_t)rndRange(4, 7) * 3600);
+        beginTrip(trips, w);
+        yard(w, (uint32_t)rndRange(1800, 7200));
+        urban(w, (uint32_t)rndRange(1200, 2400));
+        w.heading = rndRange(0, 360);
+        highway(w, (uint32_t)rndRange(2 * 3600, 4 * 3600));
+        urban(w, (uint32_t)rndRange(1200, 2400));
+        park(w, (uint32_t)rndRange(1, 3) * 3600);          // drop at a warehouse
+        beginTrip(trips, w);
+        urban(w, (uint32_t)rndRange(900, 1800));
+        w.heading += 180.0;
+        highway(w, (uint32_t)rndRange(2 * 3600, 4 * 3600));
+        urban(w, (uint32_t)rndRange(900, 1800));
+        yard(w, (uint32_t)rndRange(1800, 3600));
+        park(w, 6 * 3600);
+        // Realign to whole days so the itinerary spans 30 days.
+        uint32_t into = (w.t - 1767225600u) % 86400;
+        if (into) park(w, 86400 - into);
+    }
+    return trips;
+}
+
+// ---------------------------------------------------------------------------
+// CSV replay
+// ---------------------------------------------------------------------------
+static std::vector<Trip> loadCsv(const char *path) {
+    std::vector<Trip> trips;
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        perror(path);
+        exit(2);
+    }
+    char line[256];
+    bool have_prev = false;
+    uint32_t pt = 0;
+    Sample prev = { 0, 0, 1, SKY_OPEN };
+    while (fgets(line, sizeof(line), f)) {
+        unsigned long t;
+        double lat, lon;
+        int moving = 1, sky = SKY_OPEN;
+        int n = sscanf(line, "%lu,%lf,%lf,%d,%d", &t, &lat, &lon, &moving, &sky);
+        if (n < 3) continue;                                   // header or blank
+        Sample s = { lat, lon, (uint8_t)(moving != 0), (uint8_t)(sky < 0 || sky > 3 ? 0 : sky) };
+        if (!have_prev || t <= pt || t - pt > TRIP_GAP_S || !s.moving) {
+            if (s.moving) {
+                trips.push_back(Trip());
+                trips.back().start = (uint32_t)t;
+                trips.back().s.push_back(s);
+            }
+        } else {
+            for (uint32_t k = 1; k < t - pt; ++k) {
+                double a = (double)k / (double)(t - pt);
+                Sample m = { prev.lat + a * (lat - prev.lat), prev.lon + a * (lon - prev.lon),
+                             s.moving, prev.sky };
+                trips.back().s.push_back(m);
+            }
+            trips.back().s.push_back(s);
+        }
+        have_prev = s.moving;
+        pt = (uint32_t)t;
+        prev = s;
+    }
+    fclose(f);
+    return trips;
+}
+
+// ---------------------------------------------------------------------------
+// Policies
+// ---------------------------------------------------------------------------
+struct Report {
+    uint32_t sent;       // epoch the Note was queued
+    uint32_t fix_time;   // epoch of the fix it carries
+    double   lat, lon;
+};
+
+struct Result {
+    uint32_t attempts, fixes, gnss_on_s, notes, bytes, wakes;
+    uint32_t sky_attempts[4], sky_on_s[4];
+    std::vector<float> route_err, live_err;
+};
+
+// Simulated Notecard GNSS for one trip.
+struct Gnss {
+    const Trip *trip;
+    uint32_t    period, next_attempt;
+    bool        have;
+    LocFix      last;      // newest fix; lat/lon as the Notecard reports them
+    double      lat, lon;  // same, double precision for error accounting
+
+    void setPeriod(uint32_t now, uint32_t p) {
+        period = p;
+        next_attempt = now;   // card.location.mode restarts the schedule
+    }
+
+    // Runs acquisitions scheduled up to `now`.
+    void advance(uint32_t now, Result &r) {
+        uint32_t end = trip->start + (uint32_t)trip->s.size();
+        while (next_attempt <= now && next_attempt < end) {
+            uint32_t t0 = next_attempt;
+            next_attempt += period;
+            const Sample &at = trip->s[t0 - trip->start];
+            r.attempts++;
+            r.sky_attempts[at.sky]++;
+            if (rndUnit() < kSky[at.sky].fail) {
+                r.gnss_on_s += GNSS_TIMEOUT_S;
+                r.sky_on_s[at.sky] += GNSS_TIMEOUT_S;
+                continue;
+            }
+            uint32_t ttff = (uint32_t)rndRange(kSky[at.sky].ttff_lo, kSky[at.sky].ttff_hi);
+            uint32_t tf   = t0 + ttff;
+            r.gnss_on_s  += ttff;
+            r.sky_on_s[at.sky] += ttff;
+            if (tf >= end) continue;
+            const Sample &p = trip->s[tf - trip->start];
+            double e = FIX_NOISE_M * rndGauss(), n = FIX_NOISE_M * rndGauss();
+            lat = p.lat + n / R_EARTH / D2R;
+            lon = p.lon + e / (R_EARTH * cos(p.lat * D2R)) / D2R;
+            last.lat = (float)lat;
+            last.lon = (float)lon;
+            last.time = tf;
+            last.ttff_secs = (uint16_t)ttff;
+            have = true;
+            r.fixes++;
+        }
+    }
+};
+
+// Position Notes are not sync:true; Notehub sees them at the next outbound
+// sync (voutbound "high" on a charged battery).
+static uint32_t delivered(uint32_t sent) {
+    return (sent / OUTBOUND_S + 1) * OUTBOUND_S;
+}
+
+static void scoreTrip(const Trip &trip, const std::vector<Report> &rep, Result &r) {
+    if (rep.empty()) return;
+    // Live error: newest report sent by t.  Route error: polyline through the
+    // reported fixes, in fix-time order, between the first and last of them.
+    std::vector<Report> byFix(rep);
+    std::sort(byFix.begin(), byFix.end(),
+              [](const Report &a, const Report &b) { return a.fix_time < b.fix_time; });
+    size_t live = 0, seg = 0;
+    for (size_t i = 0; i < trip.s.size(); ++i) {
+        uint32_t t = trip.start + (uint32_t)i;
+        const Sample &p = trip.s[i];
+        while (live + 1 < rep.size() && delivered(rep[live + 1].sent) <= t) live++;
+        if (p.sky == SKY_NONE) continue;   // unobservable by any policy
+        if (delivered(rep[0].sent) <= t) r.live_err.push_back((float)distM(p.lat, p.lon, rep[live].lat, rep[live].lon));
+        if (t < byFix.front().fix_time || t > byFix.back().fix_time) continue;
+        while (seg + 1 < byFix.size() && byFix[seg + 1].fix_time < t) seg++;
+        const Report &a = byFix[seg];
+        const Report &b = byFix[seg + 1 < byFix.size() ? seg + 1 : seg];
+        r.route_err.push_back((float)segDistM(p.lat, p.lon, a.lat, a.lon, b.lat, b.lon));
+    }
+}
+
+static Result runFixed(const std::vector<Trip> &trips) {
+    Result r = {};
+    for (const Trip &trip : trips) {
+        std::vector<Report> rep;
+        Gnss g = { &trip, 0, 0, false, {}, 0, 0 };
+        g.setPeriod(trip.start, FIXED_PING_S);
+        uint32_t end = trip.start + (uint32_t)trip.s.size();
+        for (uint32_t now = trip.start + FIXED_PING_S; now < end; now += FIXED_PING_S) {
+            r.wakes++;
+            g.advance(now, r);
+            if (g.have) {   // sendLocationNote(): any non-zero cached fix
+                Report x = { now, g.last.time, g.lat, g.lon };
+                rep.push_back(x);
+                r.notes++;
+                r.bytes += POINT_NOTE_B;
+            }
+        }
+        g.advance(end - 1, r);
+        scoreTrip(trip, rep, r);
+    }
+    return r;
+}
+
+static Result runAdaptive(const std::vector<Trip> &trips, const LocPolicyConfig &cfg,
+                          uint32_t reasons[5]) {
+    Result r = {};
+    LocPolicyState st;
+    memset(&st, 0, sizeof(st));
+    for (const Trip &trip : trips) {
+        std::vector<Report> rep;
+        Gnss g = { &trip, 0, 0, false, {}, 0, 0 };
+        locPolicyStart(&st, &cfg, trip.start);
+        g.setPeriod(trip.start, st.interval_secs);
+        uint32_t end = trip.start + (uint32_t)trip.s.size();
+        uint32_t now = trip.start;
+        for (;;) {
+            now += std::min(st.interval_secs, MAX_WAKE_S);
+            if (now >= end) break;
+            r.wakes++;
+            g.advance(now, r);
+            LocDecision d = locPolicyUpdate(&st, &cfg, g.have ? &g.last : NULL, now);
+            if (d.report) {
+                Report x = { now, g.last.time, g.lat, g.lon };
+                rep.push_back(x);
+                r.notes++;
+                r.bytes += POINT_NOTE_B;
+                reasons[d.report]++;
+                locPolicyReported(&st, now);
+            }
+            if (d.interval_changed) g.setPeriod(now + d.interval_secs, d.interval_secs);
+        }
+        g.advance(end - 1, r);
+        scoreTrip(trip, rep, r);
+    }
+    return r;
+}
+
+// Queues one trailer_track.qo from the buffer, as flushTrack() does.  The
+// payload is decoded again so the score uses exactly what Notehub receives.
+static void flushTrack(TrackBuffer &tb, uint32_t now, std::vector<Report> &rep, Result &r) {
+    while (tb.count) {
+        uint8_t  buf[TRACK_PAYLOAD_MAX];
+        uint8_t  n = 0;
+        uint16_t len = trackEncode(&tb, TRACK_ERROR_M, buf, sizeof(buf), &n);
+        TrackPoint pts[TRACK_MAX_POINTS];
+        if (!len || trackDecode(buf, len, pts, TRACK_MAX_POINTS) != n) {
+            fprintf(stderr, "track payload failed to round-trip\n");
+            exit(1);
+        }
+        for (uint8_t k = 0; k < n; ++k) {
+            Report x = { now, pts[k].time, pts[k].lat, pts[k].lon };
+            rep.push_back(x);
+        }
+        r.notes++;
+        r.bytes += len + 1;   // payload plus the points field
+        trackConsume(&tb, n);
+    }
+}
+
+// Adaptive GNSS duty cycle as above, but every accepted fix goes into the
+// track buffer and is uploaded in simplified batches.
+static Result runTrack(const std::vector<Trip> &trips, const LocPolicyConfig &cfg,
+                       uint32_t *points) {
+    Result r = {};
+    LocPolicyState st;
+    memset(&st, 0, sizeof(st));
+    for (const Trip &trip : trips) {
+        std::vector<Report> rep;
+        TrackBuffer tb;
+        trackInit(&tb);
+        Gnss g = { &trip, 0, 0, false, {}, 0, 0 };
+        locPolicyStart(&st, &cfg, trip.start);
+        g.setPeriod(trip.start, st.interval_secs);
+        uint32_t end = trip.start + (uint32_t)trip.s.size();
+        uint32_t now = trip.start;
+        for (;;) {
+            now += std::min(st.interval_secs, MAX_WAKE_S);
+            if (now >= end) break;
+            r.wakes++;
+            g.advance(now, r);
+            uint32_t prev_fix = st.fix_time;
+            LocDecision d = locPolicyUpdate(&st, &cfg, g.have ? &g.last : NULL, now);
+            if (st.fix_time != prev_fix) {
+                if (!trackAppend(&tb, g.last.lat, g.last.lon, g.last.time, TRACK_ERROR_M)) {
+                    flushTrack(tb, now, rep, r);
+                    trackAppend(&tb, g.last.lat, g.last.lon, g.last.time, TRACK_ERROR_M);
+                }
+                locPolicyReported(&st, now);
+            }
+            if (d.interval_changed) g.setPeriod(now + d.interval_secs, d.interval_secs);
+            // Close the batch when it is old enough, or when the next
+            // outbound sync will happen before the host wakes again.
+            uint32_t next_wake = std::min(st.interval_secs, MAX_WAKE_S);
+            if (tb.count && (trackAgeSecs(&tb, now) >= TRACK_BATCH_S ||
+                             now % OUTBOUND_S + next_wake >= OUTBOUND_S)) {
+                flushTrack(tb, now, rep, r);
+            }
+        }
+        // Arrival: the newest fix joins the final batch.
+        g.advance(end - 1, r);
+        if (g.have) trackAppend(&tb, g.last.lat, g.last.lon, g.last.time, TRACK_ERROR_M);
+        flushTrack(tb, end - 1, rep, r);
+        *points += (uint32_t)rep.size();
+        scoreTrip(trip, rep, r);
+    }
+    return r;
+}
+
+// ---------------------------------------------------------------------------
+// Report
+// ---------------------------------------------------------------------------
+static float pct(std::vector<float> v, double p) {
+    if (v.empty()) return 0.0f;
+    size_t k = (size_t)(p * (v.size() - 1));
+    std::nth_element(v.begin(), v.begin() + k, v.end());
+    return v[k];
+}
+
+static double meanOf(const std::vector<float> &v) {
+    double s = 0;
+    for (float x : v) s += x;
+    return v.empty() ? 0.0 : s / v.size();
+}
+
+static void row(const char *name, const Result &r) {
+    printf("%-9s %9u %7u %9.1f %7u %7u %9.0f %8.0f %9.0f %8.0f\n", name, r.attempts, r.fixes,
+           r.gnss_on_s / 3600.0, r.notes, r.bytes, meanOf(r.route_err), pct(r.route_err, 0.95),
+           pct(r.live_err, 0.5), pct(r.live_err, 0.95));
+}
+
+int main(int argc, char **argv) {
+    std::vector<Trip> trips = argc > 1 ? loadCsv(argv[1]) : builtinItinerary();
+
+    uint64_t moving_s = 0;
+    for (const Trip &t : trips) moving_s += t.s.size();
+    printf("%s: %zu trips, %.1f moving hours\n\n", argc > 1 ? argv[1] : "built-in 30-day itinerary",
+           trips.size(), moving_s / 3600.0);
+    if (!moving_s) return 1;
+
+    LocPolicyConfig cfg;
+    locPolicyDefaults(&cfg);
+
+    g_rng = 0x5EED1234u;
+    Result fixed = runFixed(trips);
+    g_rng = 0x5EED1234u;
+    uint32_t reasons[5] = {0, 0, 0, 0, 0};
+    Result adaptive = runAdaptive(trips, cfg, reasons);
+    g_rng = 0x5EED1234u;
+    uint32_t track_points = 0;
+    Result track = runTrack(trips, cfg, &track_points);
+
+    printf("                                GNSS                     route err (m)    live err (m)\n");
+    printf("policy     attempts   fixes   on (h)   notes   bytes      mean      p95    median      p95\n");
+    row("fixed", fixed);
+    row("adaptive", adaptive);
+    row("track", track);
+
+    static const char *const kSkyName[] = { "open sky", "urban", "stacks", "below deck" };
+    printf("\nfix attempts / GNSS on-time (h) by sky at the antenna:\n");
+    for (int k = 0; k < 4; ++k) {
+        printf("  %-10s  fixed %5u / %5.1f   adaptive %5u / %5.1f   track %5u / %5.1f\n",
+               kSkyName[k], fixed.sky_attempts[k], fixed.sky_on_s[k] / 3600.0,
+               adaptive.sky_attempts[k], adaptive.sky_on_s[k] / 3600.0,
+               track.sky_attempts[k], track.sky_on_s[k] / 3600.0);
+    }
+
+    printf("\nadaptive reports: %u first, %u distance, %u heading, %u timeout\n",
+           reasons[LOC_REPORT_FIRST], reasons[LOC_REPORT_DISTANCE],
+           reasons[LOC_REPORT_HEADING], reasons[LOC_REPORT_TIMEOUT]);
+    printf("host wakes while moving: fixed %u, adaptive %u, track %u\n",
+           fixed.wakes, adaptive.wakes, track.wakes);
+    const Result *const vs[] = { &adaptive, &track };
+    for (int k = 0; k < 2; ++k) {
+        printf("%-8s vs fixed: GNSS on-time %+.0f%%, notes %+.0f%%, bytes %+.0f%%\n",
+               k ? "track" : "adaptive",
+               100.0 * ((double)vs[k]->gnss_on_s / fixed.gnss_on_s - 1.0),
+               100.0 * ((double)vs[k]->notes / fixed.notes - 1.0),
+               100.0 * ((double)vs[k]->bytes / fixed.bytes - 1.0));
+    }
+    printf("track: %u of %u fixes kept at %.0f m, %.1f points and %.0f bytes per note\n",
+           track_points, track.fixes, TRACK_ERROR_M, (double)track_points / track.notes,
+           (double)track.bytes / track.notes);
+    return 0;
+}
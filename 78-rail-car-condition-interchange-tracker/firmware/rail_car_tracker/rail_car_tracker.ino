@@ -37,8 +37,9 @@ DallasTemperature tankTempSensor(&oneWireBus);
 #endif
 PersistState    state;
 
-// sampleMin published by setup() so loop() uses the same interval for sleep.
-static uint32_t g_sampleMin = SAMPLE_INTERVAL_MIN_DEFAULT;
+// Sleep interval published by setup() so loop() uses it: sampleMin, or
+// TRACK_WAKE_MIN while moving.
+static uint32_t g_sleepMin = SAMPLE_INTERVAL_MIN_DEFAULT;
 
 // True only after setup() has successfully run NotePayloadRetrieveAfterSleep so
 // that `state` reflects either the previously persisted payload or a known
@@ -155,6 +156,7 @@ void setup() {
     uint32_t sampleMin           = SAMPLE_INTERVAL_MIN_DEFAULT;
     uint32_t reportMin           = REPORT_INTERVAL_MIN_DEFAULT;
     uint32_t locationIntervalMin = LOCATION_INTERVAL_MIN_DEFAULT;
+    float    trackErrorM         = TRACK_ERROR_M_DEFAULT;
     float    shockThreshG        = SHOCK_THRESHOLD_G_DEFAULT;
     uint32_t shockCoolMin        = SHOCK_COOLDOWN_MIN_DEFAULT;
     float    pressMaxPsi         = PRESSURE_MAX_PSI_DEFAULT;
@@ -162,9 +164,9 @@ void setup() {
     float    tankTempMinC        = TANK_TEMP_MIN_C_DEFAULT;
     float    tankTempMaxC        = TANK_TEMP_MAX_C_DEFAULT;
     fetchEnvOverrides(sampleMin, reportMin, shockThreshG, shockCoolMin,
-                      locationIntervalMin,
+                      locationIntervalMin, trackErrorM,
                       pressMaxPsi, pressDropPsi, tankTempMinC, tankTempMaxC);
-    g_sampleMin = sampleMin;
+    g_sleepMin = sampleMin;
 
     // ── Initialize sensors ────────────────────────────────────────────────────
     bool adxlOk = adxl345Begin();
@@ -235,6 +237,16 @@ void setup() {
         }
     }
 
+    // ── Wake interval ─────────────────────────────────────────────────────────
+    // wakeMin is how long the host actually slept: TRACK_WAKE_MIN while the
+    // car was moving, sampleMin otherwise. The elapsed-time accumulators below
+    // add wakeMin so summary and cooldown windows stay in real minutes. While
+    // moving, the next sleep is shortened to the GPS fix period so every fix
+    // reaches the track buffer; once stopped the host is back on sampleMin.
+    uint32_t wakeMin = state.lastSleepMin ? state.lastSleepMin : sampleMin;
+    g_sleepMin = (moving && sampleMin > TRACK_WAKE_MIN) ? TRACK_WAKE_MIN : sampleMin;
+    state.lastSleepMin = g_sleepMin;
+
     // ── Accumulate into persistent state ──────────────────────────────────────
     // peakShockG: track highest valid G in the window (ignore NAN from failed bursts).
     if (!isnan(peakG) && peakG > state.peakShockG) state.peakShockG = peakG;
@@ -243,15 +255,15 @@ void setup() {
     if (!isnan(peakG) && peakG >= shockThreshG)    state.shockWindowCount++;
     // elapsedMin accumulates actual minutes so a runtime change to sampleMin
     // does not retroactively shift the summary window boundary.
-    state.elapsedMin += sampleMin;
+    state.elapsedMin += wakeMin;
     // shockCooldownRemMin: monotonic countdown (minutes) that gates shock alerts
     // without requiring absolute time from card.time or GPS sync. Cap at
     // shockCoolMin before decrementing so any legacy epoch value that may be
     // stored in this field from older firmware is clamped to a sane range within
     // one wake cycle, then decrements normally from that point forward.
     if (state.shockCooldownRemMin > shockCoolMin) state.shockCooldownRemMin = shockCoolMin;
-    state.shockCooldownRemMin = (state.shockCooldownRemMin > sampleMin)
-                                ? state.shockCooldownRemMin - sampleMin : 0;
+    state.shockCooldownRemMin = (state.shockCooldownRemMin > wakeMin)
+                                ? state.shockCooldownRemMin - wakeMin : 0;
 
     // ── Alert: high-G shock impact ────────────────────────────────────────────
     // Fires when the monotonic countdown reaches zero (shockCooldownRemMin == 0).
@@ -350,43 +362,62 @@ void setup() {
     }
 #endif // TANK_CAR (tank temp alerts)
 
-    // ── Location note: motion-state change and in-motion cadence ─────────────
-    // Provides the continuous position stream needed for downstream interchange
-    // detection and geofencing. Fires on two independent triggers:
+    // ── Track and location notes ──────────────────────────────────────────────
+    // Provides the position stream needed for downstream interchange detection
+    // and geofencing.
     //
-    //   1. Motion-state edge (stopped ↔ moving): captures yard arrival and
-    //      departure events. The edge is detected on the host's wake cadence —
-    //      a transition that occurs between wakes is reported on the next wake,
-    //      up to sample_interval_min minutes later. Once detected, a hub.sync
-    //      is requested immediately within the same wake so the note reaches
-    //      Notehub without waiting for the next scheduled outbound window.
-    //   2. While moving, every locationIntervalMin minutes: fills the gaps
-    //      between periodic status summaries with a dense-enough position
-    //      record for interchange-boundary determination.
+    //   • Track: while moving, every new GPS fix goes into the persisted track
+    //     buffer (track_buffer.h). The buffer is queued as railcar_track.qo
+    //     notes, Douglas-Peucker-simplified to within trackErrorM and
+    //     delta-encoded, just before the next expected outbound sync, once its
+    //     oldest fix is locationIntervalMin old, or on a motion-state edge.
+    //   • Location: on a motion-state edge (stopped ↔ moving) a single
+    //     railcar_location.qo captures yard arrival and departure. The edge is
+    //     detected on the host's wake cadence, and a hub.sync is requested
+    //     immediately within the same wake so the note — and the track batch
+    //     queued just before it — reach Notehub without waiting for the next
+    //     scheduled outbound window.
     //
     // lastMovingState and locationElapsedMin are only updated on a successful
     // note send, so transient Notecard failures are automatically retried on
     // the next wake without losing the triggering event.
-    state.locationElapsedMin += sampleMin;
-    bool motionEdge  = wakeFromSleep && (moving != state.lastMovingState);
-    bool locationDue = moving && (state.locationElapsedMin >= locationIntervalMin);
+    state.locationElapsedMin += wakeMin;
+    bool motionEdge = wakeFromSleep && (moving != state.lastMovingState);
+
+    if (moving || motionEdge) {
+        // On the stopping edge this closes the trip with the final fix.
+        float    fixLat = 0.0f, fixLon = 0.0f;
+        uint32_t fixTime = 0;
+        if (readGpsFix(fixLat, fixLon, fixTime)) {
+            bufferTrackFix(fixLat, fixLon, fixTime, trackErrorM);
+        }
+    }
 
-    if (motionEdge || locationDue) {
+    if (state.track.count > 0) {
+        bool trackDue = motionEdge || (state.locationElapsedMin >= locationIntervalMin);
+        uint32_t sinceSync = 0;
+        if (!trackDue && secsSinceLastSync(sinceSync)) {
+            // The next outbound sync falls before the next wake: queue now so
+            // the batch rides that sync instead of waiting for the one after.
+            trackDue = (sinceSync % (TRACK_SYNC_MIN * 60U)) + g_sleepMin * 60U
+                       >= TRACK_SYNC_MIN * 60U;
+        }
+        if (trackDue && flushTrack(trackErrorM)) state.locationElapsedMin = 0;
+    } else {
+        state.locationElapsedMin = 0;
+    }
+
+    if (motionEdge) {
         if (sendLocationNote(coupled, moving)) {
-            state.locationElapsedMin = 0;
-            if (motionEdge) {
-                state.lastMovingState = moving;
-                syncNeeded = true; // hub.sync requested this wake on yard arrival / departure
-            }
-            debugSerial.print("[location] sent (");
-            debugSerial.print(motionEdge ? "motion change" : "cadence");
-            debugSerial.println(")");
+            state.lastMovingState = moving;
+            syncNeeded = true; // hub.sync requested this wake on yard arrival / departure
+            debugSerial.println("[location] sent (motion change)");
         }
-        // On failure: locationElapsedMin preserved; motionEdge re-detected next wake
-        // because lastMovingState is not advanced on failure.
+        // On failure: motionEdge re-detected next wake because lastMovingState
+        // is not advanced on failure.
     } else {
-        // No edge, no cadence fire: keep the latch current so steady-state
-        // operation does not accumulate a stale motionEdge on future wakes.
+        // No edge: keep the latch current so steady-state operation does not
+        // accumulate a stale motionEdge on future wakes.
         state.lastMovingState = moving;
     }
 
@@ -468,7 +499,7 @@ void loop() {
                     debugSerial.println(attempt);
                     delay(500);
                 }
-                sleepOk = NotePayloadSaveAndSleep(&savePayload, g_sampleMin * 60U, NULL);
+                sleepOk = NotePayloadSaveAndSleep(&savePayload, g_sleepMin * 60U, NULL);
             }
         }
     } else {
@@ -491,7 +522,7 @@ void loop() {
             J *req = notecard.newRequest("card.attn");
             if (req != NULL) {
                 JAddStringToObject(req, "mode",    "sleep");
-                JAddNumberToObject(req, "seconds", (double)(g_sampleMin * 60U));
+                JAddNumberToObject(req, "seconds", (double)(g_sleepMin * 60U));
                 J *rsp = notecard.requestAndResponse(req);
                 if (rsp != NULL) {
                     const char *err = JGetString(rsp, "err");
@@ -506,7 +537,7 @@ void loop() {
             // interrupts, drawing ~1–2 mA instead of ~10 mA in active run mode.
             // (__WFI is a CMSIS intrinsic available on all Cortex-M targets.)
             debugSerial.println("[error] card.attn failed — entering WFI fail-safe sleep");
-            uint32_t deadlineMs = millis() + (g_sampleMin * 60UL * 1000UL);
+            uint32_t deadlineMs = millis() + (g_sleepMin * 60UL * 1000UL);
             while ((int32_t)(deadlineMs - millis()) > 0) {
                 __WFI();
             }
@@ -516,5 +547,5 @@ void loop() {
 
     // card.attn cuts host power; this line is reached only when the
     // Notecarrier CX is not gating host power via ATTN (e.g. bench testing).
-    delay(g_sampleMin * 60UL * 1000UL);
+    delay(g_sleepMin * 60UL * 1000UL);
 }
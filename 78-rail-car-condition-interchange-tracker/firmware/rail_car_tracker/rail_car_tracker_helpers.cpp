@@ -56,20 +56,22 @@ bool configureNotecard() {
 }
 
 // ─────────────────────────────────────────────────────────────────────────────
-// defineTemplates — register compact note.template for all three Notefiles
+// defineTemplates — register compact note.template for all four Notefiles
 //
 // "compact" format is required for satellite (NTN/Skylo) transmission; it
 // strips metadata and dramatically reduces per-note wire size.
 //
-// All three templates declare _lat/_lon/_ltime as reserved compact fields.
-// The Notecard injects the last known GPS fix into these fields when the
-// note is queued, if a fix is available. Before the first fix is acquired,
-// these fields may be absent or zero — the host never needs to query
-// card.location or supply coordinates directly.
+// The status, alert and location templates declare _lat/_lon/_ltime as
+// reserved compact fields. The Notecard injects the last known GPS fix into
+// these fields when the note is queued, if a fix is available. Before the
+// first fix is acquired, these fields may be absent or zero. The track
+// template instead carries host-buffered fixes in a binary payload (layout in
+// track_buffer.h); "length" reserves room for it.
 //
 //   Port 10 — railcar_status.qo  : periodic condition summary
 //   Port 11 — railcar_alert.qo   : edge-triggered alert notes
-//   Port 12 — railcar_location.qo: dedicated position stream
+//   Port 12 — railcar_location.qo: position at each motion-state change
+//   Port 13 — railcar_track.qo   : batched, simplified route while moving
 //
 // Returns false if any template registration reports an error.
 // ─────────────────────────────────────────────────────────────────────────────
@@ -151,10 +153,8 @@ bool defineTemplates() {
     }
 
     // ── Location note template (port 12) ──────────────────────────────────────
-    // Compact, low-byte-count note for the dedicated position stream.
-    // Fired on motion-state transitions (stopped ↔ moving) and while moving
-    // at the configured location_interval_min cadence. The small body keeps
-    // satellite airtime cost negligible even at a 30-minute transmit rate.
+    // Compact, low-byte-count note fired on motion-state transitions
+    // (stopped ↔ moving); the route in between travels in railcar_track.qo.
     // _lat/_lon/_ltime are injected from the last known Notecard GPS fix when
     // available; before the first fix is acquired these fields may be absent
     // or zero. moving and coupled give downstream interchange-detection
@@ -185,6 +185,32 @@ bool defineTemplates() {
         }
     }
 
+    // ── Track note template (port 13) ─────────────────────────────────────────
+    // One note per batch of buffered fixes: the point count in the body, the
+    // simplified, delta-encoded points in the payload.
+    {
+        J *req = notecard.newRequest("note.template");
+        JAddStringToObject(req, "file",   FILE_TRACK);
+        JAddNumberToObject(req, "port",   13);
+        JAddStringToObject(req, "format", "compact");
+        JAddNumberToObject(req, "length", TRACK_PAYLOAD_MAX);
+        J *body = JAddObjectToObject(req, "body");
+        JAddNumberToObject(body, "points", TUINT8);
+        J *rsp = notecard.requestAndResponse(req);
+        if (rsp != NULL) {
+            const char *err = JGetString(rsp, "err");
+            if (err && *err) {
+                debugSerial.print("[warn] note.template track: ");
+                debugSerial.println(err);
+                ok = false;
+            }
+            notecard.deleteResponse(rsp);
+        } else {
+            debugSerial.println("[warn] note.template track: no response");
+            ok = false;
+        }
+    }
+
     return ok;
 }
 
@@ -304,8 +330,9 @@ bool applyGPSMotionGate() {
 // Recognised environment variables:
 //   sample_interval_min   — host wake interval (5–60 min)
 //   report_interval_min   — status summary cadence (sampleMin–1440 min)
-//   location_interval_min — max gap between location notes while moving
+//   location_interval_min — oldest fix a track batch may hold while moving
 //                           (sampleMin–240 min)
+//   track_error_m         — track simplification error bound (10–500 m)
 //   shock_threshold_g     — impact alert threshold (0.5–20 G)
 //   shock_cooldown_min    — minimum gap between shock alerts (1–60 min)
 //   pressure_max_psi      — tank overpressure alert (1–25 PSI; TANK_CAR only)
@@ -315,7 +342,7 @@ bool applyGPSMotionGate() {
 // ─────────────────────────────────────────────────────────────────────────────
 void fetchEnvOverrides(uint32_t &sampleMin, uint32_t &reportMin,
                        float &shockThreshG, uint32_t &shockCoolMin,
-                       uint32_t &locationIntervalMin,
+                       uint32_t &locationIntervalMin, float &trackErrorM,
                        float &pressMaxPsi, float &pressDropPsi,
                        float &tankTempMinC, float &tankTempMaxC) {
     J *rsp = notecard.requestAndResponse(notecard.newRequest("env.get"));
@@ -344,6 +371,8 @@ void fetchEnvOverrides(uint32_t &sampleMin, uint32_t &reportMin,
         reportMin           = (uint32_t)constrain(atol(v), sampleMin, 1440);
     if ((v = JGetString(body, "location_interval_min")) && *v)
         locationIntervalMin = (uint32_t)constrain(atol(v), sampleMin, 240);
+    if ((v = JGetString(body, "track_error_m")) && *v)
+        trackErrorM         = constrain(atof(v), 10.0f, 500.0f);
     if ((v = JGetString(body, "shock_threshold_g")) && *v)
         shockThreshG        = constrain(atof(v), 0.5f, 20.0f);
     if ((v = JGetString(body, "shock_cooldown_min")) && *v)
@@ -554,24 +583,18 @@ bool sendSummary(float pressurePsi, float tankTempC, bool coupled, bool moving)
 // ─────────────────────────────────────────────────────────────────────────────
 // sendLocationNote — emit a compact position snapshot to FILE_LOCATION
 //
-// Provides the dedicated position stream needed for interchange-detection and
-// geofencing. Called on two triggers:
-//
-//   1. Motion-state transition (stopped ↔ moving): captures yard arrival and
-//      departure events with an immediate hub.sync so the timestamp reaches
-//      Notehub before the car moves out of connectivity range.
-//
-//   2. While moving, every location_interval_min minutes: fills the gap
-//      between periodic status summaries with a continuous position record
-//      dense enough for downstream interchange-boundary detection.
+// Called on each motion-state transition (stopped ↔ moving) to capture yard
+// arrival and departure events with an immediate hub.sync so the timestamp
+// reaches Notehub before the car moves out of connectivity range. The route
+// between transitions is carried by railcar_track.qo (see flushTrack).
 //
 // Body contains only moving and coupled; _lat/_lon/_ltime are injected by
 // the Notecard template engine from the last known GPS fix when available;
 // before the first fix is acquired those fields may be absent or zero.
 //
 // Returns true if the note was accepted by the Notecard without error.
-// Callers must only reset locationElapsedMin and advance lastMovingState on
-// a true return so that failed sends are retried on the next wake.
+// Callers must only advance lastMovingState on a true return so that failed
+// sends are retried on the next wake.
 // ─────────────────────────────────────────────────────────────────────────────
 bool sendLocationNote(bool coupled, bool moving) {
     J *req = notecard.newRequest("note.add");
@@ -596,3 +619,113 @@ bool sendLocationNote(bool coupled, bool moving) {
     notecard.deleteResponse(rsp);
     return true;
 }
+
+// ─────────────────────────────────────────────────────────────────────────────
+// readGpsFix — latest Notecard GPS fix from card.location
+//
+// Returns false when the request fails or the Notecard has no fix yet (zero
+// lat/lon or no fix time). With the motion-gated GPS the fix may be the one
+// cached before the car stopped; callers compare fixTime against
+// state.lastTrackFixTime to skip fixes already buffered.
+// ─────────────────────────────────────────────────────────────────────────────
+bool readGpsFix(float &lat, float &lon, uint32_t &fixTime) {
+    J *rsp = notecard.requestAndResponse(notecard.newRequest("card.location"));
+    if (rsp == NULL) return false;
+    const char *err = JGetString(rsp, "err");
+    if (err && *err) {
+        notecard.deleteResponse(rsp);
+        return false;
+    }
+    double la = JGetNumber(rsp, "lat");
+    double lo = JGetNumber(rsp, "lon");
+    fixTime   = (uint32_t)JGetInt(rsp, "time");
+    notecard.deleteResponse(rsp);
+    if ((la == 0.0 && lo == 0.0) || fixTime == 0) return false;
+    lat = (float)la;
+    lon = (float)lo;
+    return true;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// bufferTrackFix — add a new fix to the persisted track buffer
+//
+// Fixes not newer than state.lastTrackFixTime are ignored. When every
+// buffered point is significant the batch is queued early to make room; if
+// that fails too, the oldest point is given up so the newest is never lost.
+// ─────────────────────────────────────────────────────────────────────────────
+void bufferTrackFix(float lat, float lon, uint32_t fixTime, float trackErrorM) {
+    if (fixTime <= state.lastTrackFixTime) return;
+    if (!trackAppend(&state.track, lat, lon, fixTime, trackErrorM)) {
+        debugSerial.println("[track] buffer full of significant points — queuing early");
+        if (!flushTrack(trackErrorM)) trackDropOldest(&state.track);
+        trackAppend(&state.track, lat, lon, fixTime, trackErrorM);
+    }
+    state.lastTrackFixTime = fixTime;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// flushTrack — queue the track buffer as railcar_track.qo notes
+//
+// The buffer is simplified with Douglas-Peucker to within trackErrorM and
+// delta-encoded into the note's binary payload; a batch that does not fit
+// TRACK_PAYLOAD_MAX continues in a second note. Points leave the buffer only
+// once the Notecard has accepted the note carrying them, so a failed
+// note.add is retried, with any newer fixes, on a later wake.
+//
+// Returns true when the buffer is empty.
+// ─────────────────────────────────────────────────────────────────────────────
+bool flushTrack(float trackErrorM) {
+    while (state.track.count > 0) {
+        uint8_t  buf[TRACK_PAYLOAD_MAX];
+        uint8_t  points = 0;
+        uint16_t len = trackEncode(&state.track, trackErrorM, buf, sizeof(buf), &points);
+        if (len == 0) return false;
+
+        J *req = notecard.newRequest("note.add");
+        JAddStringToObject(req, "file", FILE_TRACK);
+        J *body = JAddObjectToObject(req, "body");
+        JAddNumberToObject(body, "points", points);
+        if (!JAddBinaryToObject(req, "payload", buf, len)) {
+            JDelete(req);
+            debugSerial.println("[warn] note.add track: payload encode failed");
+            return false;
+        }
+        J *rsp = notecard.requestAndResponse(req);
+        if (rsp == NULL) {
+            debugSerial.println("[warn] note.add track: no response");
+            return false;
+        }
+        const char *err = JGetString(rsp, "err");
+        if (err && *err) {
+            debugSerial.print("[warn] note.add track: ");
+            debugSerial.println(err);
+            notecard.deleteResponse(rsp);
+            return false;
+        }
+        notecard.deleteResponse(rsp);
+
+        debugSerial.print("[track] sent ");
+        debugSerial.print(points);
+        debugSerial.print(" points in ");
+        debugSerial.print(len);
+        debugSerial.println(" bytes");
+        trackConsume(&state.track, points);
+    }
+    return true;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// secsSinceLastSync — seconds since the Notecard last completed a sync
+//
+// From hub.sync.status "completed". Returns false when the request fails or
+// no sync has completed since the Notecard booted.
+// ─────────────────────────────────────────────────────────────────────────────
+bool secsSinceLastSync(uint32_t &secs) {
+    J *rsp = notecard.requestAndResponse(notecard.newRequest("hub.sync.status"));
+    if (rsp == NULL) return false;
+    const char *err = JGetString(rsp, "err");
+    bool ok = !(err && *err) && JIsPresent(rsp, "completed");
+    if (ok) secs = (uint32_t)JGetInt(rsp, "completed");
+    notecard.deleteResponse(rsp);
+    return ok;
+}
@@ -17,6 +17,8 @@
 #include <Wire.h>
 #include <Notecard.h>
 
+#include "track_buffer.h"
+
 // ── Hardware profile: tank car vs. intermodal / flat car ─────────────────────
 // Uncomment the following line when deploying on a tank car fitted with an
 // Adafruit MPRLS pressure sensor and DS18B20 cargo-temperature probe. Leave it
@@ -64,7 +66,8 @@
 // ── Defaults (all overridable via Notehub environment variables) ──────────────
 #define SAMPLE_INTERVAL_MIN_DEFAULT    15
 #define REPORT_INTERVAL_MIN_DEFAULT   240    // 4 hours between status summaries
-#define LOCATION_INTERVAL_MIN_DEFAULT  30    // max gap (min) between location notes while moving
+#define LOCATION_INTERVAL_MIN_DEFAULT 120    // oldest fix (min) a track batch may hold while moving
+#define TRACK_ERROR_M_DEFAULT          25.0f // track simplification error bound (m)
 #define SHOCK_THRESHOLD_G_DEFAULT      2.5f  // G above which impact windows are counted
 #define SHOCK_COOLDOWN_MIN_DEFAULT     5     // min between consecutive shock alerts
 #define PRESSURE_MAX_PSI_DEFAULT       20.0f // tank overpressure alert threshold (PSI abs)
@@ -75,7 +78,19 @@
 // ── Notefiles ─────────────────────────────────────────────────────────────────
 #define FILE_STATUS    "railcar_status.qo"    // periodic condition summary
 #define FILE_ALERT     "railcar_alert.qo"     // edge-triggered alert notes
-#define FILE_LOCATION  "railcar_location.qo"  // dedicated position stream
+#define FILE_LOCATION  "railcar_location.qo"  // position at each motion-state change
+#define FILE_TRACK     "railcar_track.qo"     // batched, simplified route while moving
+
+// ── Track sampling ────────────────────────────────────────────────────────────
+// While moving, the host wakes at the GPS fix period (see
+// configureMotionAndGPS) instead of sample_interval_min so every fix reaches
+// the track buffer.
+#define TRACK_WAKE_MIN   5
+
+// Outbound sync interval on a charged battery (voutbound "high" in
+// configureNotecard). A track batch is closed just before the next expected
+// sync so batching adds no delay beyond what the outbound cadence imposes.
+#define TRACK_SYNC_MIN   120
 
 // ── NotePayload segment ID ────────────────────────────────────────────────────
 // 4-character tag (NP_SEGTYPE_LEN) identifying the PersistState segment within
@@ -102,12 +117,12 @@
 // hub.set (PRODUCT_UID, sync policy) is applied unconditionally every boot and
 // does NOT require a CONFIG_VERSION bump to take effect.
 //
-//   Standard (non-TANK_CAR) builds : CONFIG_VERSION = 4
-//   TANK_CAR builds                : CONFIG_VERSION = 104
+//   Standard (non-TANK_CAR) builds : CONFIG_VERSION = 5
+//   TANK_CAR builds                : CONFIG_VERSION = 105
 //
-#define CONFIG_VERSION_BASE  4
+#define CONFIG_VERSION_BASE  5
 #ifdef TANK_CAR
-#define CONFIG_VERSION  104
+#define CONFIG_VERSION  105
 #else
 #define CONFIG_VERSION  CONFIG_VERSION_BASE
 #endif
@@ -152,9 +167,10 @@ typedef struct {
     // ── Fields added in CONFIG_VERSION 2 ─────────────────────────────────────
     bool     lastMovingState;     // motion state on the last wake that successfully sent a
                                   //   railcar_location.qo note (edge-change latch for retry)
-    uint32_t locationElapsedMin;  // minutes since the last railcar_location.qo note was
-                                  //   emitted; reset to 0 on a successful send; continues
-                                  //   accumulating when a send fails so the next wake retries
+    uint32_t locationElapsedMin;  // minutes since the track buffer was last emptied into
+                                  //   railcar_track.qo notes (railcar_location.qo cadence
+                                  //   before CONFIG_VERSION 5); keeps accumulating when a
+                                  //   send fails so the next wake retries
     // ── Fields added in CONFIG_VERSION 4 ─────────────────────────────────────
     bool     lastTankTempLow;     // true: cargo temp below tank_temp_min_c AND alert sent;
                                   //   cleared when temp returns above threshold to re-arm.
@@ -162,6 +178,12 @@ typedef struct {
     bool     lastTankTempHigh;    // true: cargo temp above tank_temp_max_c AND alert sent;
                                   //   cleared when temp drops below threshold to re-arm.
                                   //   Unused (always false) in non-TANK_CAR builds.
+    // ── Fields added in CONFIG_VERSION 5 ─────────────────────────────────────
+    uint32_t lastSleepMin;        // minutes the host slept before this wake; added to the
+                                  //   elapsed-time accumulators (0 = unknown → sampleMin)
+    uint32_t lastTrackFixTime;    // epoch of the newest fix added to the track buffer, so
+                                  //   a cached fix is never buffered twice across batches
+    TrackBuffer track;            // fixes not yet queued in a railcar_track.qo note
 } PersistState;
 
 // ── Shared globals (defined in rail_car_tracker.ino) ─────────────────────────
@@ -181,7 +203,7 @@ bool  configureMotionAndGPS();
 bool  applyGPSMotionGate();
 void  fetchEnvOverrides(uint32_t &sampleMin, uint32_t &reportMin,
                         float &shockThreshG, uint32_t &shockCoolMin,
-                        uint32_t &locationIntervalMin,
+                        uint32_t &locationIntervalMin, float &trackErrorM,
                         float &pressMaxPsi, float &pressDropPsi,
                         float &tankTempMinC, float &tankTempMaxC);
 bool  readCouplerState();
@@ -189,5 +211,9 @@ float readPeakShockG();
 bool  sendAlert(const char *alertType, float value);
 bool  sendSummary(float pressurePsi, float tankTempC, bool coupled, bool moving);
 bool  sendLocationNote(bool coupled, bool moving);
+bool  readGpsFix(float &lat, float &lon, uint32_t &fixTime);
+void  bufferTrackFix(float lat, float lon, uint32_t fixTime, float trackErrorM);
+bool  flushTrack(float trackErrorM);
+bool  secsSinceLastSync(uint32_t &secs);
 bool  adxl345Begin();
 bool  adxl345ReadG(float &gx, float &gy, float &gz);
@@ -0,0 +1,323 @@
+/*******************************************************************************
+ * track_buffer.h
+ *
+ * On-device track buffer for a moving asset: collects GNSS fixes between
+ * uploads, thins them with Douglas-Peucker under an error bound, and packs
+ * the survivors into one delta-encoded binary payload per track Note.
+ *
+ * Simplification is done online: when the buffer fills, it is simplified in
+ * place and only the points the route actually needs stay resident, so a
+ * straight highway run can span far more fixes than TRACK_MAX_POINTS.  The
+ * buffer only reports "full" when every buffered point is significant, at
+ * which point the caller should upload.
+ *
+ * Payload layout (little-endian), version TRACK_PAYLOAD_VERSION:
+ *
+ *   u8   version
+ *   u8   point count n
+ *   i32  lat  of point 0, 1e-5 degrees
+ *   i32  lon  of point 0, 1e-5 degrees
+ *   u32  time of point 0, epoch seconds
+ *   n-1 x { zigzag varint dlat, zigzag varint dlon, varint dt }
+ *
+ * 1e-5 degrees is 1.1 m, well inside GNSS error.  A typical kept point costs
+ * 5-7 bytes against 12 for a templated lat/lon/time Note body, before the
+ * per-Note overhead that batching removes entirely.
+ *
+ * Pure arithmetic with no Notecard or Arduino dependencies, so host tools
+ * can replay tracks through exactly this code.  TrackBuffer is a POD that
+ * can be persisted across sleep.  All functions are static inline.
+ ******************************************************************************/
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+// Resident points.  The simplifier's keep-set is a 32-bit mask.
+#ifndef TRACK_MAX_POINTS
+#define TRACK_MAX_POINTS  24
+#endif
+
+#if TRACK_MAX_POINTS > 32 || TRACK_MAX_POINTS < 3
+#error "TRACK_MAX_POINTS must be between 3 and 32"
+#endif
+
+#define TRACK_PAYLOAD_VERSION  1
+
+// Fixed header (version, count, absolute first point) and worst-case size of
+// one delta record (two 5-byte zigzag varints and one 5-byte varint).
+#define TRACK_HEADER_LEN   14
+#define TRACK_DELTA_MAX    15
+
+// Payload ceiling for one Note.  Kept under a single satellite packet; a
+// batch that does not fit is split and the remainder goes in the next Note.
+#ifndef TRACK_PAYLOAD_MAX
+#define TRACK_PAYLOAD_MAX  200
+#endif
+
+#define TRACK_EARTH_RADIUS_M  6371000.0f
+#define TRACK_DEG_TO_RAD      0.017453292519943295f
+
+typedef struct {
+    float    lat;
+    float    lon;
+    uint32_t time;
+} TrackPoint;
+
+typedef struct {
+    uint8_t    count;
+    uint8_t    reserved[3];
+    TrackPoint pt[TRACK_MAX_POINTS];
+} TrackBuffer;
+
+static inline void trackInit(TrackBuffer *b)
+{
+    memset(b, 0, sizeof(*b));
+}
+
+// ---------------------------------------------------------------------------
+// Geometry.  Equirectangular projection about a reference point; accurate to
+// well under a metre over the few tens of km one batch spans.
+// ---------------------------------------------------------------------------
+static inline void trackProject(const TrackPoint *ref, const TrackPoint *p,
+                                float *x, float *y)
+{
+    float k = cosf(ref->lat * TRACK_DEG_TO_RAD);
+    *x = (p->lon - ref->lon) * TRACK_DEG_TO_RAD * TRACK_EARTH_RADIUS_M * k;
+    *y = (p->lat - ref->lat) * TRACK_DEG_TO_RAD * TRACK_EARTH_RADIUS_M;
+}
+
+// Distance from p to the segment a-b, in metres.
+static inline float trackSegmentDistM(const TrackPoint *a, const TrackPoint *b,
+                                      const TrackPoint *p)
+{
+    float bx, by, px, py;
+    trackProject(a, b, &bx, &by);
+    trackProject(a, p, &px, &py);
+    float len2 = bx * bx + by * by;
+    float t = (len2 > 0.0f) ? (px * bx + py * by) / len2 : 0.0f;
+    if (t < 0.0f) t = 0.0f;
+    if (t > 1.0f) t = 1.0f;
+    float dx = px - t * bx;
+    float dy = py - t * by;
+    return sqrtf(dx * dx + dy * dy);
+}
+
+// ---------------------------------------------------------------------------
+// Douglas-Peucker, iterative with an explicit range stack so stack use is
+// bounded regardless of the track's shape.  Simplifies the buffer in place,
+// always keeping the first and last points, and returns the new count.
+// ---------------------------------------------------------------------------
+static inline uint8_t trackSimplify(TrackBuffer *b, float tol_m)
+{
+    uint8_t n = b->count;
+    if (n < 3) return n;
+
+    uint32_t keep = (1UL << 0) | (1UL << (n - 1));
+    uint8_t  lo[TRACK_MAX_POINTS];
+    uint8_t  hi[TRACK_MAX_POINTS];
+    uint8_t  sp = 0;
+    lo[sp] = 0;
+    hi[sp] = (uint8_t)(n - 1);
+    sp++;
+
+    while (sp > 0) {
+        sp--;
+        uint8_t i = lo[sp];
+        uint8_t j = hi[sp];
+        float   worst = 0.0f;
+        uint8_t at = 0;
+        for (uint8_t k = (uint8_t)(i + 1); k < j; k++) {
+            float d = trackSegmentDistM(&b->pt[i], &b->pt[j], &b->pt[k]);
+            if (d > worst) {
+                worst = d;
+                at = k;
+            }
+        }
+        if (at && worst > tol_m) {
+            keep |= (1UL << at);
+            if (at - i > 1) { lo[sp] = i;  hi[sp] = at; sp++; }
+            if (j - at > 1) { lo[sp] = at; hi[sp] = j;  sp++; }
+        }
+    }
+
+    uint8_t out = 0;
+    for (uint8_t k = 0; k < n; k++) {
+        if (keep & (1UL << k)) b->pt[out++] = b->pt[k];
+    }
+    b->count = out;
+    return out;
+}
+
+// Appends a fix.  Fixes that are not newer than the last buffered one are
+// ignored (returns true).  When the buffer is full it is simplified first;
+// returns false if no point could be dropped, in which case the caller must
+// upload (trackEncode/trackConsume) or trackDropOldest() before retrying.
+static inline bool trackAppend(TrackBuffer *b, float lat, float lon,
+                               uint32_t time, float tol_m)
+{
+    if (b->count && time <= b->pt[b->count - 1].time) return true;
+    if (b->count >= TRACK_MAX_POINTS && trackSimplify(b, tol_m) >= TRACK_MAX_POINTS) {
+        return false;
+    }
+    TrackPoint *p = &b->pt[b->count++];
+    p->lat  = lat;
+    p->lon  = lon;
+    p->time = time;
+    return true;
+}
+
+// Removes the first n points (those just uploaded).
+static inline void trackConsume(TrackBuffer *b, uint8_t n)
+{
+    if (n >= b->count) {
+        b->count = 0;
+        return;
+    }
+    memmove(&b->pt[0], &b->pt[n], (size_t)(b->count - n) * sizeof(TrackPoint));
+    b->count = (uint8_t)(b->count - n);
+}
+
+// Last resort when an upload keeps failing: give up the oldest point.
+static inline void trackDropOldest(TrackBuffer *b)
+{
+    trackConsume(b, 1);
+}
+
+// Age of the batch: seconds from its first point to `now`.
+static inline uint32_t trackAgeSecs(const TrackBuffer *b, uint32_t now)
+{
+    if (!b->count || now < b->pt[0].time) return 0;
+    return now - b->pt[0].time;
+}
+
+// ---------------------------------------------------------------------------
+// Encoding
+// ---------------------------------------------------------------------------
+static inline int32_t trackE5(float deg)
+{
+    return (int32_t)lroundf(deg * 100000.0f);
+}
+
+static inline void trackPut32(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+static inline uint32_t trackGet32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) |
+           ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static inline uint8_t trackPutVarint(uint8_t *p, uint32_t v)
+{
+    uint8_t n = 0;
+    while (v >= 0x80) {
+        p[n++] = (uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    p[n++] = (uint8_t)v;
+    return n;
+}
+
+static inline uint8_t trackGetVarint(const uint8_t *p, uint16_t avail, uint32_t *v)
+{
+    uint32_t r = 0;
+    for (uint8_t n = 0; n < 5 && n < avail; n++) {
+        r |= (uint32_t)(p[n] & 0x7F) << (7 * n);
+        if (!(p[n] & 0x80)) {
+            *v = r;
+            return (uint8_t)(n + 1);
+        }
+    }
+    return 0;
+}
+
+static inline uint32_t trackZigzag(int32_t v)
+{
+    return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+
+static inline int32_t trackUnzigzag(uint32_t v)
+{
+    return (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+}
+
+// Simplifies the buffer and encodes as many points as fit in `max` bytes.
+// Returns the payload length (0 if the buffer is empty or max is too small)
+// and sets *points to the number of points encoded; pass that count to
+// trackConsume() once the Note has been queued.
+static inline uint16_t trackEncode(TrackBuffer *b, float tol_m,
+                                   uint8_t *out, uint16_t max, uint8_t *points)
+{
+    *points = 0;
+    trackSimplify(b, tol_m);
+    if (!b->count || max < TRACK_HEADER_LEN) return 0;
+
+    int32_t lat = trackE5(b->pt[0].lat);
+    int32_t lon = trackE5(b->pt[0].lon);
+    uint32_t t  = b->pt[0].time;
+    out[0] = TRACK_PAYLOAD_VERSION;
+    trackPut32(out + 2,  (uint32_t)lat);
+    trackPut32(out + 6,  (uint32_t)lon);
+    trackPut32(out + 10, t);
+    uint16_t len = TRACK_HEADER_LEN;
+    uint8_t  n = 1;
+
+    for (; n < b->count; n++) {
+        uint8_t rec[TRACK_DELTA_MAX];
+        int32_t nlat = trackE5(b->pt[n].lat);
+        int32_t nlon = trackE5(b->pt[n].lon);
+        uint8_t r = 0;
+        r += trackPutVarint(rec + r, trackZigzag(nlat - lat));
+        r += trackPutVarint(rec + r, trackZigzag(nlon - lon));
+        r += trackPutVarint(rec + r, b->pt[n].time - t);
+        if (len + r > max) break;
+        memcpy(out + len, rec, r);
+        len = (uint16_t)(len + r);
+        lat = nlat;
+        lon = nlon;
+        t   = b->pt[n].time;
+    }
+    out[1] = n;
+    *points = n;
+    return len;
+}
+
+// Decodes a payload written by trackEncode() into out[] (at most `max`
+// points).  Returns the point count, or 0 for a truncated, malformed or
+// other-version payload.  Used by host tools; the firmware only encodes.
+static inline uint8_t trackDecode(const uint8_t *in, uint16_t len,
+                                  TrackPoint *out, uint8_t max)
+{
+    if (len < TRACK_HEADER_LEN || in[0] != TRACK_PAYLOAD_VERSION) return 0;
+    uint8_t n = in[1];
+    if (n == 0 || n > max) return 0;
+
+    int32_t  lat = (int32_t)trackGet32(in + 2);
+    int32_t  lon = (int32_t)trackGet32(in + 6);
+    uint32_t t   = trackGet32(in + 10);
+    uint16_t pos = TRACK_HEADER_LEN;
+    for (uint8_t k = 0; k < n; k++) {
+        if (k > 0) {
+            uint32_t v[3];
+            for (uint8_t f = 0; f < 3; f++) {
+                uint8_t used = trackGetVarint(in + pos, (uint16_t)(len - pos), &v[f]);
+                if (!used) return 0;
+                pos = (uint16_t)(pos + used);
+            }
+            lat += trackUnzigzag(v[0]);
+            lon += trackUnzigzag(v[1]);
+            t   += v[2];
+        }
+        out[k].lat  = (float)lat / 100000.0f;
+        out[k].lon  = (float)lon / 100000.0f;
+        out[k].time = t;
+    }
+    return (pos == len) ? n : 0;
+}
@@ -7,7 +7,9 @@
  *
  * Accumulates readings across wake cycles, transmits periodic summaries to
  * Notehub, and sends immediate alerts for low SoC, high battery temperature,
- * and excessive load draw.
+ * and excessive load draw.  Once per day it also pulls the MPPT's 30-day
+ * history and the SmartShunt's history counters over the VE.Direct HEX
+ * protocol and forwards any new days as templated history Notes.
  *
  * Board:    Blues Notecarrier CX (onboard Cygnet STM32L433 host)
  * Notecard: NOTE-MBGLW (cellular) or NOTE-NBGLWX (Skylo NTN satellite) in M.2 slot
@@ -19,7 +21,7 @@
  *
  * Source is split across three modules:
  *   solar_battery_controller.ino            — orchestration (this file)
- *   solar_battery_controller_helpers.*      — VE.Direct UART frame parser
+ *   solar_battery_controller_helpers.*      — VE.Direct text parser + HEX client
  *   solar_battery_controller_notecard_helpers.* — Notecard I/O, PersistState,
  *                                                  all configuration constants
  *
@@ -64,8 +66,12 @@
 #endif
 
 // VE.Direct UART pins
-// Serial1 (RX = CX header RX pin, TX unused) → SmartShunt
-// D9 / SoftwareSerial → SmartSolar MPPT
+// Serial1 (RX/TX = CX header RX/TX pins) → SmartShunt
+// D9 RX / D10 TX SoftwareSerial → SmartSolar MPPT
+//
+// The TX lines carry VE.Direct HEX Get requests.  If a TX line is left
+// unconnected the HEX read times out and that device falls back to the text
+// broadcast, so RX-only installations keep working unchanged.
 //
 // NOTE: SoftwareSerial is used here because the Cygnet's second hardware UART
 // is not exposed at a convenient position on the standard CX header for the
@@ -74,7 +80,7 @@
 // to avoid SoftwareSerial's interrupt-latency sensitivity.  See README §4
 // for wiring details and the trade-off discussion.
 #define MPPT_RX_PIN     D9    // SoftwareSerial RX for SmartSolar MPPT
-#define MPPT_TX_PIN     D10   // SoftwareSerial TX (not driven — leave NC)
+#define MPPT_TX_PIN     D10   // SoftwareSerial TX → MPPT VE.Direct RX (HEX requests)
 #define VED_BAUD        19200
 
 // ---------------------------------------------------------------------------
@@ -107,6 +113,8 @@ static void  accumulate(const VEDirectData &shunt, const VEDirectData &mppt);
 static void  checkAndSendAlerts(const VEDirectData &shunt, const VEDirectData &mppt);
 static void  checkHarvestDeficit();
 static void  resetAccumulators();
+static uint16_t wakesPerHistoryPull(uint32_t sample_sec);
+static bool  pullDailyHistory(bool shunt_hex, bool mppt_hex);
 
 // ---------------------------------------------------------------------------
 // setup() — entry point after every wake (cold boot or ATTN-triggered)
@@ -150,6 +158,8 @@ void setup() {
         state.report_interval_min  = DEFAULT_REPORT_INTERVAL_MIN;
         state.harvest_deficit_days = 0.0f;
         state.ttg_min              = -1;
+        // history_countdown = 0 and history_seq_valid = false (via memset):
+        // the first wake with a HEX-capable MPPT backfills all stored days.
         // last_outbound_min / last_inbound_min default to 0, so the
         // applyHubSetIfChanged() call later in this block and the call after
         // fetchEnvOverrides() will both issue hub.set on first boot.
@@ -236,9 +246,13 @@ void setup() {
     mpptSerial.begin(VED_BAUD);
 
     VEDirectData shunt, mppt;
-    // Allow up to 3 s per device — they broadcast every ~1 s
-    bool shunt_ok = readVEDirectFrame(Serial1,    shunt, 3000);
-    bool mppt_ok  = readVEDirectFrame(mpptSerial, mppt,  3000);
+    // Prefer HEX Gets (tens of ms per device).  Fall back to the text
+    // broadcast — up to 3 s per device, one frame every ~1 s — when the
+    // device does not answer, e.g. its TX line is not wired.
+    bool shunt_hex = readVEDirectHex(Serial1, shunt, VED_DEV_SHUNT);
+    bool shunt_ok  = shunt_hex || readVEDirectFrame(Serial1, shunt, 3000);
+    bool mppt_hex  = readVEDirectHex(mpptSerial, mppt, VED_DEV_MPPT);
+    bool mppt_ok   = mppt_hex || readVEDirectFrame(mpptSerial, mppt, 3000);
 
     if (!shunt_ok) Serial.println(F("[warn] No VE.Direct frame from SmartShunt"));
     if (!mppt_ok)  Serial.println(F("[warn] No VE.Direct frame from SmartSolar MPPT"));
@@ -274,6 +288,18 @@ void setup() {
         }
     }
 
+    // -------------------------------------------------------------------------
+    // Daily VE.Direct HEX history pull.  Left due (countdown at 0) after a
+    // failed send so the next wake retries; already-sent days are skipped by
+    // day sequence number so a retry never duplicates records.
+    // -------------------------------------------------------------------------
+    if (state.history_countdown > 0) state.history_countdown--;
+    if (state.history_countdown == 0 && (shunt_hex || mppt_hex)) {
+        if (pullDailyHistory(shunt_hex, mppt_hex)) {
+            state.history_countdown = wakesPerHistoryPull(state.sample_interval_sec);
+        }
+    }
+
     state.boot_count++;
 
     // -------------------------------------------------------------------------
@@ -308,6 +334,66 @@ static uint16_t samplesPerWindow(uint32_t report_min, uint32_t sample_sec) {
     return (uint16_t)max(1UL, (report_sec + sample_sec - 1) / sample_sec);
 }
 
+// ---------------------------------------------------------------------------
+// wakesPerHistoryPull — sample wakes per HISTORY_PULL_INTERVAL_SEC (≥ 1).
+// ---------------------------------------------------------------------------
+static uint16_t wakesPerHistoryPull(uint32_t sample_sec) {
+    return (uint16_t)max(1UL, HISTORY_PULL_INTERVAL_SEC / sample_sec);
+}
+
+// ---------------------------------------------------------------------------
+// pullDailyHistory — forward new MPPT history days and the SmartShunt
+// history counters.
+//
+// Day 1 (yesterday) is the newest completed MPPT record; its day_seq tells us
+// how many days have closed since last_history_seq.  Days are sent oldest
+// first so last_history_seq only ever advances, and it is only advanced after
+// each Note is confirmed queued.  The first pull after a clean init backfills
+// every stored day (up to VED_HISTORY_DAYS).
+//
+// Returns false on any Notecard failure so the caller keeps the pull due.
+// ---------------------------------------------------------------------------
+static bool pullDailyHistory(bool shunt_hex, bool mppt_hex) {
+    bool ok = true;
+
+    if (mppt_hex) {
+        VEDHistoryDay newest;
+        if (readMpptHistoryDay(mpptSerial, 1, newest)) {
+            uint16_t pending = VED_HISTORY_DAYS;
+            if (state.history_seq_valid) {
+                pending = (uint16_t)(newest.day_seq - state.last_history_seq);
+                if (pending > VED_HISTORY_DAYS) pending = VED_HISTORY_DAYS;
+            }
+            for (int d = pending; d >= 1 && ok; d--) {
+                VEDHistoryDay rec = newest;
+                if (d > 1 && !readMpptHistoryDay(mpptSerial, (uint8_t)d, rec)) {
+                    continue;   // MPPT holds fewer days than requested
+                }
+                if (state.history_seq_valid &&
+                    (int16_t)(rec.day_seq - state.last_history_seq) <= 0) {
+                    continue;   // already sent
+                }
+                if (sendMpptHistory(rec)) {
+                    state.last_history_seq  = rec.day_seq;
+                    state.history_seq_valid = true;
+                } else {
+                    ok = false;
+                }
+            }
+        } else {
+            Serial.println(F("[warn] MPPT history day 1 not readable"));
+        }
+    }
+
+    if (shunt_hex && ok) {
+        VEDShuntHistory hist;
+        if (readShuntHistory(Serial1, hist)) {
+            ok = sendShuntHistory(hist);
+        }
+    }
+    return ok;
+}
+
 // ---------------------------------------------------------------------------
 // accumulate — add one set of readings to the current summary window
 // ---------------------------------------------------------------------------
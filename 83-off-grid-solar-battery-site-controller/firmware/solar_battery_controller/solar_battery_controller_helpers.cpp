@@ -14,6 +14,9 @@
   The checksum byte makes the sum of all frame bytes (including the newline
   after Checksum) equal zero modulo 256. We verify the checksum here.
   A failed checksum discards the frame and waits for the next one.
+
+  Also implements the VE.Direct HEX client (vedHexGet and the register-set
+  readers built on it) used for fast per-wake reads and daily history pulls.
 ***************************************************************************/
 
 #include "solar_battery_controller_helpers.h"
@@ -205,3 +208,193 @@ bool readVEDirectFrame(Stream &serial, VEDirectData &out, uint32_t timeout_ms) {
     // Timed out without a complete, valid frame.
     return false;
 }
+
+// =========================================================================
+// VE.Direct HEX protocol
+//
+// Frame format (ASCII hex, one line per message):
+//   ':' <cmd nibble> <payload bytes as 2 hex digits each> <checksum> '\n'
+// The checksum byte makes (cmd + Σ payload bytes + checksum) == 0x55 mod 256.
+// A Get payload is <reg id, little-endian><flags>; the reply echoes the same
+// three bytes followed by the register value, also little-endian.
+// =========================================================================
+
+static const char HEX_DIGITS[] = "0123456789ABCDEF";
+
+static int hexNibble(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return -1;
+}
+
+static void writeHexByte(Stream &serial, uint8_t b) {
+    serial.write(HEX_DIGITS[b >> 4]);
+    serial.write(HEX_DIGITS[b & 0x0F]);
+}
+
+static uint16_t le16(const uint8_t *p) {
+    return (uint16_t)(p[0] | ((uint16_t)p[1] << 8));
+}
+
+static uint32_t le32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) |
+           ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// Reads a 16- or 32-bit register into *out.  Narrower replies are
+// zero-extended; `is_signed` sign-extends a 16-bit reply.
+static bool hexGetInt(Stream &serial, uint16_t reg, bool is_signed, int32_t *out) {
+    uint8_t buf[4];
+    int n = vedHexGet(serial, reg, buf, sizeof(buf));
+    if (n == 1) { *out = buf[0]; return true; }
+    if (n == 2) {
+        uint16_t u = le16(buf);
+        *out = is_signed ? (int32_t)(int16_t)u : (int32_t)u;
+        return true;
+    }
+    if (n == 4) { *out = (int32_t)le32(buf); return true; }
+    return false;
+}
+
+int vedHexGet(Stream &serial, uint16_t reg, uint8_t *data, uint8_t max_len,
+              uint32_t timeout_ms) {
+    // Send ":7<reg lo><reg hi>00<chk>\n"
+    uint8_t reg_lo = (uint8_t)(reg & 0xFF);
+    uint8_t reg_hi = (uint8_t)(reg >> 8);
+    uint8_t chk    = (uint8_t)(0x55 - VED_HEX_CMD_GET - reg_lo - reg_hi);
+    serial.write(':');
+    serial.write(HEX_DIGITS[VED_HEX_CMD_GET]);
+    writeHexByte(serial, reg_lo);
+    writeHexByte(serial, reg_hi);
+    writeHexByte(serial, 0x00);
+    writeHexByte(serial, chk);
+    serial.write('\n');
+
+    // Reply parser state.  `bytes` holds reg id, flags, value and checksum.
+    uint8_t bytes[3 + VED_HEX_MAX_DATA + 1];
+    uint8_t nbytes  = 0;
+    int     cmd     = -1;
+    int     hi      = -1;     // pending high nibble
+    bool    in_msg  = false;
+    bool    overrun = false;
+
+    uint32_t deadline = millis() + timeout_ms;
+    while (millis() < deadline) {
+        if (!serial.available()) {
+            delay(1);
+            continue;
+        }
+        char c = (char)serial.read();
+
+        if (c == ':') {
+            in_msg = true; cmd = -1; hi = -1; nbytes = 0; overrun = false;
+            continue;
+        }
+        if (!in_msg) continue;          // text-protocol bytes between replies
+
+        if (c == '\n' || c == '\r') {
+            in_msg = false;
+            if (cmd != VED_HEX_CMD_GET || hi >= 0 || overrun || nbytes < 4) continue;
+
+            uint8_t sum = (uint8_t)cmd;
+            for (uint8_t i = 0; i < nbytes; i++) sum += bytes[i];
+            if (sum != 0x55) continue;  // corrupted — keep waiting
+            if (bytes[0] != reg_lo || bytes[1] != reg_hi) continue;
+            if (bytes[2] != 0x00) return -1;   // flags: unknown / unsupported
+
+            uint8_t len = nbytes - 4;   // minus reg id, flags, checksum
+            if (len > max_len) len = max_len;
+            memcpy(data, &bytes[3], len);
+            return len;
+        }
+
+        int v = hexNibble(c);
+        if (v < 0) { in_msg = false; continue; }   // not a HEX line after all
+        if (cmd < 0) { cmd = v; continue; }
+        if (hi < 0) { hi = v; continue; }
+        if (nbytes < sizeof(bytes)) {
+            bytes[nbytes++] = (uint8_t)((hi << 4) | v);
+        } else {
+            overrun = true;
+        }
+        hi = -1;
+    }
+    return -1;
+}
+
+bool readVEDirectHex(Stream &serial, VEDirectData &out, VEDDeviceKind kind) {
+    memset(&out, 0, sizeof(out));
+    out.bat_temp_c = -99.0f;
+    out.ttg_min    = -1;
+    out.soc_pct    = -1.0f;
+
+    int32_t v;
+    if (kind == VED_DEV_SHUNT) {
+        if (!hexGetInt(serial, VED_REG_BAT_V, false, &v)) return false;
+        out.bat_v = v / 100.0f;
+        if (hexGetInt(serial, VED_REG_BAT_I, true,  &v)) out.bat_a = v / 1000.0f;
+        if (hexGetInt(serial, VED_REG_BAT_P, true,  &v)) out.bat_w = (float)v;
+        // 0xFFFF on SoC / temperature / TTG means "not available"; keep the
+        // same sentinels the text parser leaves for "---".
+        if (hexGetInt(serial, VED_REG_SOC, false, &v) && v != 0xFFFF) {
+            out.soc_pct = v / 100.0f;
+        }
+        if (hexGetInt(serial, VED_REG_BAT_TEMP, false, &v) && v != 0xFFFF) {
+            out.bat_temp_c = v / 100.0f - 273.15f;
+        }
+        if (hexGetInt(serial, VED_REG_TTG, false, &v) && v != 0xFFFF) {
+            out.ttg_min = v;
+        }
+    } else {
+        if (!hexGetInt(serial, VED_REG_DEVICE_STATE, false, &v)) return false;
+        out.cs = (int16_t)v;
+        if (hexGetInt(serial, VED_REG_PV_V,        false, &v)) out.pv_v      = v / 100.0f;
+        if (hexGetInt(serial, VED_REG_PV_P,        false, &v)) out.pv_w      = v / 100.0f;
+        if (hexGetInt(serial, VED_REG_YIELD_TODAY, false, &v)) out.yield_kwh = v / 100.0f;
+        if (hexGetInt(serial, VED_REG_CHARGER_ERR, false, &v)) out.err       = (int8_t)v;
+    }
+    out.valid = true;
+    return true;
+}
+
+bool readMpptHistoryDay(Stream &serial, uint8_t day, VEDHistoryDay &out) {
+    if (day > VED_HISTORY_DAYS) return false;
+    uint8_t buf[VED_HEX_MAX_DATA];
+    int n = vedHexGet(serial, VED_REG_HISTORY_DAY0 + day, buf, sizeof(buf));
+    if (n < 33) return false;
+
+    // Layout: reserved(1) yield(4) consumed(4) vmax(2) vmin(2) errdb(4)
+    //         bulk(2) abs(2) float(2) pmax(4) imax(2) vpvmax(2) day_seq(2)
+    out.yield_kwh    = le32(&buf[1])  / 100.0f;
+    out.consumed_kwh = le32(&buf[5])  / 100.0f;
+    out.bat_v_max    = le16(&buf[9])  / 100.0f;
+    out.bat_v_min    = le16(&buf[11]) / 100.0f;
+    out.err          = buf[13];
+    out.bulk_min     = le16(&buf[17]);
+    out.abs_min      = le16(&buf[19]);
+    out.float_min    = le16(&buf[21]);
+    out.max_pv_w     = le32(&buf[23]);
+    out.max_bat_a    = le16(&buf[27]) / 10.0f;
+    out.max_pv_v     = le16(&buf[29]) / 100.0f;
+    out.day_seq      = le16(&buf[31]);
+    return true;
+}
+
+bool readShuntHistory(Stream &serial, VEDShuntHistory &out) {
+    memset(&out, 0, sizeof(out));
+    int32_t v;
+    if (!hexGetInt(serial, VED_REG_H_DEEPEST, true, &v)) return false;
+    out.deepest_ah = v / 10.0f;
+    if (hexGetInt(serial, VED_REG_H_LAST,       true,  &v)) out.last_ah         = v / 10.0f;
+    if (hexGetInt(serial, VED_REG_H_AVERAGE,    true,  &v)) out.avg_ah          = v / 10.0f;
+    if (hexGetInt(serial, VED_REG_H_CYCLES,     false, &v)) out.cycles          = (uint32_t)v;
+    if (hexGetInt(serial, VED_REG_H_FULL_DIS,   false, &v)) out.full_discharges = (uint32_t)v;
+    if (hexGetInt(serial, VED_REG_H_CUM_AH,     true,  &v)) out.cum_ah          = v / 10.0f;
+    if (hexGetInt(serial, VED_REG_H_MIN_V,      true,  &v)) out.min_v           = v / 100.0f;
+    if (hexGetInt(serial, VED_REG_H_MAX_V,      true,  &v)) out.max_v           = v / 100.0f;
+    if (hexGetInt(serial, VED_REG_H_SINCE_FULL, false, &v)) out.since_full_s    = (uint32_t)v;
+    if (hexGetInt(serial, VED_REG_H_DIS_KWH,    false, &v)) out.dis_kwh         = v / 100.0f;
+    if (hexGetInt(serial, VED_REG_H_CHG_KWH,    false, &v)) out.chg_kwh         = v / 100.0f;
+    return true;
+}
@@ -4,7 +4,8 @@
 
   Encapsulates VE.Direct UART frame parsing for the
   solar_battery_controller project. Handles both Victron SmartShunt
-  (battery-side metrics) and SmartSolar MPPT (solar-side metrics).
+  (battery-side metrics) and SmartSolar MPPT (solar-side metrics), over
+  either the 1 Hz text broadcast or on-demand HEX protocol register Gets.
 ***************************************************************************/
 
 #pragma once
@@ -89,3 +90,139 @@ struct VEDirectData {
 // Returns true if a valid frame was parsed; false on timeout.
 // -------------------------------------------------------------------------
 bool readVEDirectFrame(Stream &serial, VEDirectData &out, uint32_t timeout_ms = 3000);
+
+// =========================================================================
+// VE.Direct HEX protocol — on-demand register reads
+//
+// The HEX protocol shares the same 19200-baud wire as the text broadcast
+// but is request/response: the host writes a ":<cmd><payload><checksum>\n"
+// line on the device's RX pin and the device answers within a few tens of
+// milliseconds, interleaving the reply with (and briefly pausing) its text
+// frames.  A single Get round-trip is ~10–20 ms versus waiting up to 1 s for
+// the next text frame, and it exposes registers the text protocol never
+// broadcasts (MPPT daily history, SmartShunt history counters).
+//
+// HEX requires the host TX line to be wired to VE.Direct pin 2 (device RX).
+// 3.3 V host logic is accepted by the device's RX input directly.  When TX is
+// not wired the first Get times out after VED_HEX_TIMEOUT_MS and the caller
+// falls back to readVEDirectFrame().
+// =========================================================================
+
+#define VED_HEX_CMD_GET       0x7
+#define VED_HEX_TIMEOUT_MS    150   // per-register reply timeout; covers a text
+                                    // frame already in flight when Get is sent
+#define VED_HEX_MAX_DATA      36    // largest reply payload (MPPT history day = 33 B)
+
+// SmartShunt / BMV registers (VE.Direct HEX protocol, BMV-7xx appendix)
+#define VED_REG_BAT_V         0xED8D  // un16, 0.01 V
+#define VED_REG_BAT_I         0xED8C  // sn32, 0.001 A
+#define VED_REG_BAT_P         0xED8E  // sn16, 1 W
+#define VED_REG_SOC           0x0FFF  // un16, 0.01 %
+#define VED_REG_BAT_TEMP      0xEDEC  // un16, 0.01 K (0xFFFF = no sensor)
+#define VED_REG_TTG           0x0FFE  // un16, 1 min  (0xFFFF = infinite)
+
+// SmartShunt history registers (all 32-bit)
+#define VED_REG_H_DEEPEST     0x0300  // sn32, 0.1 Ah — deepest discharge
+#define VED_REG_H_LAST        0x0301  // sn32, 0.1 Ah — last discharge
+#define VED_REG_H_AVERAGE     0x0302  // sn32, 0.1 Ah — average discharge
+#define VED_REG_H_CYCLES      0x0303  // un32 — charge cycles
+#define VED_REG_H_FULL_DIS    0x0304  // un32 — full discharges
+#define VED_REG_H_CUM_AH      0x0305  // sn32, 0.1 Ah — cumulative Ah drawn
+#define VED_REG_H_MIN_V       0x0306  // sn32, 0.01 V
+#define VED_REG_H_MAX_V       0x0307  // sn32, 0.01 V
+#define VED_REG_H_SINCE_FULL  0x0308  // un32, 1 s — time since last full charge
+#define VED_REG_H_DIS_KWH     0x0310  // un32, 0.01 kWh — discharged energy
+#define VED_REG_H_CHG_KWH     0x0311  // un32, 0.01 kWh — charged energy
+
+// SmartSolar MPPT registers (BlueSolar/SmartSolar HEX appendix)
+#define VED_REG_PV_V          0xEDBB  // un16, 0.01 V
+#define VED_REG_PV_P          0xEDBC  // un32, 0.01 W
+#define VED_REG_DEVICE_STATE  0x0201  // un8 — same codes as the text CS field
+#define VED_REG_CHARGER_ERR   0xEDDA  // un8 — same codes as the text ERR field
+#define VED_REG_YIELD_TODAY   0xEDD3  // un16, 0.01 kWh (text H20)
+#define VED_REG_HISTORY_DAY0  0x1050  // + day (0 = today … 30), 33-byte block
+
+#define VED_HISTORY_DAYS      30      // completed days held by the MPPT
+
+// Which register set readVEDirectHex() should poll.
+enum VEDDeviceKind : uint8_t {
+    VED_DEV_SHUNT = 0,
+    VED_DEV_MPPT  = 1,
+};
+
+// -------------------------------------------------------------------------
+// VEDHistoryDay — one decoded MPPT daily history record (register 0x1050+n).
+// -------------------------------------------------------------------------
+struct VEDHistoryDay {
+    uint16_t day_seq;        // device's running day sequence number
+    float    yield_kwh;      // solar yield for the day
+    float    consumed_kwh;   // load-output consumption (0 on models without load output)
+    float    bat_v_max;      // V
+    float    bat_v_min;      // V
+    uint16_t bulk_min;       // minutes spent in Bulk
+    uint16_t abs_min;        // minutes spent in Absorption
+    uint16_t float_min;      // minutes spent in Float
+    uint32_t max_pv_w;       // peak panel power, W
+    float    max_bat_a;      // peak battery current, A
+    float    max_pv_v;       // peak panel voltage, V
+    uint8_t  err;            // most recent error code logged that day (0 = none)
+};
+
+// -------------------------------------------------------------------------
+// VEDShuntHistory — SmartShunt lifetime history counters.
+// -------------------------------------------------------------------------
+struct VEDShuntHistory {
+    float    deepest_ah;
+    float    last_ah;
+    float    avg_ah;
+    uint32_t cycles;
+    uint32_t full_discharges;
+    float    cum_ah;
+    float    min_v;
+    float    max_v;
+    uint32_t since_full_s;
+    float    dis_kwh;
+    float    chg_kwh;
+};
+
+// -------------------------------------------------------------------------
+// vedHexGet()
+//
+// Sends a HEX Get for `reg` and waits up to `timeout_ms` for the matching
+// reply.  Text-protocol lines, async (0xA) messages and replies for other
+// registers are skipped.  Returns the number of value bytes copied into
+// `data` (little-endian, as on the wire), or -1 on timeout, checksum
+// failure, or a non-zero flags byte (unknown / unsupported register).
+// -------------------------------------------------------------------------
+int vedHexGet(Stream &serial, uint16_t reg, uint8_t *data, uint8_t max_len,
+              uint32_t timeout_ms = VED_HEX_TIMEOUT_MS);
+
+// -------------------------------------------------------------------------
+// readVEDirectHex()
+//
+// Fills the same VEDirectData fields as readVEDirectFrame() using HEX Gets.
+// The first register of each set (battery voltage for the shunt, device
+// state for the MPPT) is mandatory: if it does not answer, the function
+// returns false immediately so the caller can fall back to the text frame
+// without paying a timeout per register.  Remaining registers are optional
+// and keep their sentinel defaults when unsupported.
+// -------------------------------------------------------------------------
+bool readVEDirectHex(Stream &serial, VEDirectData &out, VEDDeviceKind kind);
+
+// -------------------------------------------------------------------------
+// readMpptHistoryDay()
+//
+// Reads one daily history record.  `day` 0 is today (still accumulating),
+// 1 is yesterday, up to VED_HISTORY_DAYS.  Returns false on timeout or when
+// the MPPT has no record for that day.
+// -------------------------------------------------------------------------
+bool readMpptHistoryDay(Stream &serial, uint8_t day, VEDHistoryDay &out);
+
+// -------------------------------------------------------------------------
+// readShuntHistory()
+//
+// Reads the SmartShunt history counters.  Returns false if the first
+// register does not answer; individual counters that are unsupported on
+// older firmware are left at 0.
+// -------------------------------------------------------------------------
+bool readShuntHistory(Stream &serial, VEDShuntHistory &out);
@@ -2,8 +2,9 @@
   solar_battery_controller_notecard_helpers - Notecard & Configuration
   for Off-Grid Solar Battery Site Controller
 
-  Implements all Notecard I/O: hub.set, note.template, env.get, and both
-  outbound note.add paths (periodic summary and immediate alert).
+  Implements all Notecard I/O: hub.set, note.template, env.get, and the
+  outbound note.add paths (periodic summary, immediate alert, and the daily
+  VE.Direct history records).
 
   Both note.add paths use requestAndResponse() so the Notecard response
   err field is inspected before callers may update alert state or reset
@@ -70,48 +71,92 @@ void notecardFirstBoot() {
 }
 
 // ---------------------------------------------------------------------------
-// defineTemplates — registers fixed-width Note templates to minimise
-// on-wire payload size over the lifetime of the deployment.
-// Retries up to 5 times to survive a transient I2C or Notecard-ready hiccup
-// at cold boot.
-//
-// Returns true when the template is confirmed registered.  The caller should
-// store the result in state.templates_confirmed and call this function again
-// on the next wake until it returns true, so a transient failure at first
-// boot or a shape change after a firmware update (which bumps STATE_VERSION
-// and clears the flag) is always recovered automatically.
+// Template body builders — one per templated Notefile.  Kept separate from the
+// retry loop so each attempt can rebuild the request from scratch (note-arduino
+// frees req on every requestAndResponse call).
 // ---------------------------------------------------------------------------
-bool defineTemplates() {
-    bool registered = false;
-    for (int attempt = 0; attempt < 5 && !registered; attempt++) {
+static void summaryTemplateBody(J *body) {
+    JAddNumberToObject(body, "bat_v",      14.1);  // 4-byte float, 1 decimal
+    JAddNumberToObject(body, "bat_a",      14.1);
+    JAddNumberToObject(body, "bat_w",      14.1);
+    JAddNumberToObject(body, "soc_pct",    14.1);
+    JAddNumberToObject(body, "bat_temp_c", 14.1);
+    JAddNumberToObject(body, "pv_v",       14.1);
+    JAddNumberToObject(body, "pv_w",       14.1);
+    JAddNumberToObject(body, "yield_kwh",  14.1);
+    JAddNumberToObject(body, "load_w",     14.1);
+    JAddNumberToObject(body, "ttg_min",    14);    // 4-byte int
+    JAddNumberToObject(body, "cs",         12);    // 2-byte int
+}
+
+static void mpptHistoryTemplateBody(J *body) {
+    JAddNumberToObject(body, "day_seq",      12);    // 2-byte int
+    JAddNumberToObject(body, "yield_kwh",    14.1);
+    JAddNumberToObject(body, "consumed_kwh", 14.1);
+    JAddNumberToObject(body, "bat_v_max",    14.1);
+    JAddNumberToObject(body, "bat_v_min",    14.1);
+    JAddNumberToObject(body, "bulk_min",     12);
+    JAddNumberToObject(body, "abs_min",      12);
+    JAddNumberToObject(body, "float_min",    12);
+    JAddNumberToObject(body, "max_pv_w",     14);
+    JAddNumberToObject(body, "max_bat_a",    14.1);
+    JAddNumberToObject(body, "max_pv_v",     14.1);
+    JAddNumberToObject(body, "err",          11);    // 1-byte int
+}
+
+static void shuntHistoryTemplateBody(J *body) {
+    JAddNumberToObject(body, "deepest_ah",   14.1);
+    JAddNumberToObject(body, "last_ah",      14.1);
+    JAddNumberToObject(body, "avg_ah",       14.1);
+    JAddNumberToObject(body, "cycles",       14);
+    JAddNumberToObject(body, "full_dis",     14);
+    JAddNumberToObject(body, "cum_ah",       14.1);
+    JAddNumberToObject(body, "min_v",        14.1);
+    JAddNumberToObject(body, "max_v",        14.1);
+    JAddNumberToObject(body, "since_full_s", 14);
+    JAddNumberToObject(body, "dis_kwh",      14.1);
+    JAddNumberToObject(body, "chg_kwh",      14.1);
+}
+
+// Registers one template, retrying up to 5 times.
+static bool registerTemplate(const char *file, int port, void (*fill)(J *body)) {
+    for (int attempt = 0; attempt < 5; attempt++) {
         if (attempt > 0) delay(2000);
         J *req = notecard.newRequest("note.template");
         if (!req) continue;
-        JAddStringToObject(req, "file", "solar_summary.qo");
-        JAddNumberToObject(req, "port", 50);
-        J *body = JAddObjectToObject(req, "body");
-        JAddNumberToObject(body, "bat_v",      14.1);  // 4-byte float, 1 decimal
-        JAddNumberToObject(body, "bat_a",      14.1);
-        JAddNumberToObject(body, "bat_w",      14.1);
-        JAddNumberToObject(body, "soc_pct",    14.1);
-        JAddNumberToObject(body, "bat_temp_c", 14.1);
-        JAddNumberToObject(body, "pv_v",       14.1);
-        JAddNumberToObject(body, "pv_w",       14.1);
-        JAddNumberToObject(body, "yield_kwh",  14.1);
-        JAddNumberToObject(body, "load_w",     14.1);
-        JAddNumberToObject(body, "ttg_min",    14);    // 4-byte int
-        JAddNumberToObject(body, "cs",         12);    // 2-byte int
+        JAddStringToObject(req, "file", file);
+        JAddNumberToObject(req, "port", port);
+        fill(JAddObjectToObject(req, "body"));
         J *rsp = notecard.requestAndResponse(req);
         if (rsp) {
             const char *err = JGetString(rsp, "err");
-            registered = (!err || !*err);
+            bool ok = (!err || !*err);
             notecard.deleteResponse(rsp);
+            if (ok) return true;
         }
     }
-    if (!registered) {
-        Serial.println(F("[warn] note.template solar_summary.qo failed after retries"));
-    }
-    return registered;
+    Serial.print(F("[warn] note.template failed after retries: "));
+    Serial.println(file);
+    return false;
+}
+
+// ---------------------------------------------------------------------------
+// defineTemplates — registers fixed-width Note templates to minimise
+// on-wire payload size over the lifetime of the deployment.
+// Retries up to 5 times per template to survive a transient I2C or
+// Notecard-ready hiccup at cold boot.
+//
+// Returns true when every template is confirmed registered.  The caller should
+// store the result in state.templates_confirmed and call this function again
+// on the next wake until it returns true, so a transient failure at first
+// boot or a shape change after a firmware update (which bumps STATE_VERSION
+// and clears the flag) is always recovered automatically.
+// ---------------------------------------------------------------------------
+bool defineTemplates() {
+    bool ok = registerTemplate("solar_summary.qo", 50, summaryTemplateBody);
+    ok &= registerTemplate("solar_history.qo", 51, mpptHistoryTemplateBody);
+    ok &= registerTemplate("shunt_history.qo", 52, shuntHistoryTemplateBody);
+    return ok;
 }
 
 // ---------------------------------------------------------------------------
@@ -415,3 +460,71 @@ bool sendSummary() {
     }
     return ok;
 }
+
+// ---------------------------------------------------------------------------
+// addHistoryNote — shared note.add tail for the two history Notefiles.
+// Consumes req.  Returns true only when the Notecard confirms the Note queued.
+// ---------------------------------------------------------------------------
+static bool addHistoryNote(J *req, const char *file) {
+    J *rsp = notecard.requestAndResponse(req);
+    if (!rsp) {
+        Serial.print(F("[warn] note.add no response: "));
+        Serial.println(file);
+        return false;
+    }
+    const char *err = JGetString(rsp, "err");
+    bool ok = (!err || !*err);
+    if (!ok) {
+        Serial.print(F("[warn] note.add "));
+        Serial.print(file);
+        Serial.print(F(" error: "));
+        Serial.println(err);  // log before deleteResponse
+    }
+    notecard.deleteResponse(rsp);
+    return ok;
+}
+
+// ---------------------------------------------------------------------------
+// sendMpptHistory — one solar_history.qo Note per completed MPPT day.
+// ---------------------------------------------------------------------------
+bool sendMpptHistory(const VEDHistoryDay &day) {
+    J *req = notecard.newRequest("note.add");
+    if (!req) return false;
+    JAddStringToObject(req, "file", "solar_history.qo");
+    J *body = JAddObjectToObject(req, "body");
+    JAddNumberToObject(body, "day_seq",      day.day_seq);
+    JAddNumberToObject(body, "yield_kwh",    day.yield_kwh);
+    JAddNumberToObject(body, "consumed_kwh", day.consumed_kwh);
+    JAddNumberToObject(body, "bat_v_max",    day.bat_v_max);
+    JAddNumberToObject(body, "bat_v_min",    day.bat_v_min);
+    JAddNumberToObject(body, "bulk_min",     day.bulk_min);
+    JAddNumberToObject(body, "abs_min",      day.abs_min);
+    JAddNumberToObject(body, "float_min",    day.float_min);
+    JAddNumberToObject(body, "max_pv_w",     (double)day.max_pv_w);
+    JAddNumberToObject(body, "max_bat_a",    day.max_bat_a);
+    JAddNumberToObject(body, "max_pv_v",     day.max_pv_v);
+    JAddNumberToObject(body, "err",          day.err);
+    return addHistoryNote(req, "solar_history.qo");
+}
+
+// ---------------------------------------------------------------------------
+// sendShuntHistory — one shunt_history.qo Note per daily history pull.
+// ---------------------------------------------------------------------------
+bool sendShuntHistory(const VEDShuntHistory &hist) {
+    J *req = notecard.newRequest("note.add");
+    if (!req) return false;
+    JAddStringToObject(req, "file", "shunt_history.qo");
+    J *body = JAddObjectToObject(req, "body");
+    JAddNumberToObject(body, "deepest_ah",   hist.deepest_ah);
+    JAddNumberToObject(body, "last_ah",      hist.last_ah);
+    JAddNumberToObject(body, "avg_ah",       hist.avg_ah);
+    JAddNumberToObject(body, "cycles",       (double)hist.cycles);
+    JAddNumberToObject(body, "full_dis",     (double)hist.full_discharges);
+    JAddNumberToObject(body, "cum_ah",       hist.cum_ah);
+    JAddNumberToObject(body, "min_v",        hist.min_v);
+    JAddNumberToObject(body, "max_v",        hist.max_v);
+    JAddNumberToObject(body, "since_full_s", (double)hist.since_full_s);
+    JAddNumberToObject(body, "dis_kwh",      hist.dis_kwh);
+    JAddNumberToObject(body, "chg_kwh",      hist.chg_kwh);
+    return addHistoryNote(req, "shunt_history.qo");
+}
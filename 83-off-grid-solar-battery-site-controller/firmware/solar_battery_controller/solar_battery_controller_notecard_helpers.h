@@ -13,6 +13,7 @@
 
 #pragma once
 #include <Notecard.h>
+#include "solar_battery_controller_helpers.h"
 
 // ---------------------------------------------------------------------------
 // Default thresholds (all overridable via Notehub environment variables)
@@ -38,6 +39,11 @@
 // Persisted in PersistState so the cooldown survives sleep cycles.
 #define ALERT_COOLDOWN_SAMPLES  2U
 
+// VE.Direct HEX history pull cadence.  Daily history only changes at the
+// MPPT's day rollover, so it is read once per 24 h worth of sample wakes
+// (96 at the default 15-min interval) rather than on every wake.
+#define HISTORY_PULL_INTERVAL_SEC  86400UL
+
 // Summary sentinel values — emitted for every template field even when no
 // valid samples were collected in the window.  Using explicit out-of-physical-
 // range constants keeps the fixed-schema template fully populated so downstream
@@ -60,7 +66,7 @@
 // PersistState layout guard — bump STATE_VERSION whenever the struct changes
 // so stale flash content from a prior layout is detected and discarded cleanly.
 #define STATE_MAGIC    0x534F4C52UL  // ASCII "SOLR"
-#define STATE_VERSION  5
+#define STATE_VERSION  6
 
 // NotePayload state segment ID (must be exactly 4 characters)
 #define STATE_SEG_ID  "SOLR"
@@ -121,10 +127,22 @@ struct PersistState {
     uint32_t last_outbound_min;
     uint32_t last_inbound_min;
 
-    // Indicates that note.template for solar_summary.qo was confirmed registered
-    // by the Notecard.  Cleared on a clean init (magic/version mismatch) so that
-    // a firmware update that bumps STATE_VERSION re-registers on the next boot.
+    // Indicates that note.template for solar_summary.qo, solar_history.qo and
+    // shunt_history.qo was confirmed registered by the Notecard.  Cleared on a
+    // clean init (magic/version mismatch) so that a firmware update that bumps
+    // STATE_VERSION re-registers on the next boot.
     bool     templates_confirmed;
+
+    // Daily VE.Direct HEX history pull.
+    //   history_countdown — sample wakes until the next pull; 0 = due now (also
+    //                       left at 0 after a failed send so the next wake retries).
+    //   last_history_seq  — MPPT day_seq of the newest solar_history.qo record
+    //                       confirmed queued; only newer days are sent.
+    //   history_seq_valid — false until the first record is sent, which
+    //                       triggers a one-time backfill of all stored days.
+    uint16_t history_countdown;
+    uint16_t last_history_seq;
+    bool     history_seq_valid;
 };
 
 // ---------------------------------------------------------------------------
@@ -135,10 +153,11 @@ struct PersistState {
 // accelerometer to reduce idle draw.
 void notecardFirstBoot();
 
-// Register fixed-width Note templates to minimise on-wire payload size over
-// the lifetime of the deployment.  Returns true when the template is confirmed
-// registered; callers should persist templates_confirmed and retry on the next
-// boot if this returns false.
+// Register fixed-width Note templates (solar_summary.qo, solar_history.qo,
+// shunt_history.qo) to minimise on-wire payload size over the lifetime of the
+// deployment.  Returns true when every template is confirmed registered;
+// callers should persist templates_confirmed and retry on the next boot if
+// this returns false.
 bool defineTemplates();
 
 // Issue hub.set on every boot when PRODUCT_UID is configured so that a
@@ -170,3 +189,13 @@ bool sendAlert(const char *alert, float v1, float v2, float v3);
 // only on a Notecard I/O failure; callers must not reset accumulators on a
 // false return so the window data is preserved for the next attempt.
 bool sendSummary();
+
+// Push one MPPT daily history record as a templated solar_history.qo Note.
+// Not sync:true — history rides the next scheduled outbound session.
+// Returns true only after the Note is confirmed queued; callers must not
+// advance last_history_seq on a false return.
+bool sendMpptHistory(const VEDHistoryDay &day);
+
+// Push the SmartShunt history counters as a templated shunt_history.qo Note.
+// Returns true only after the Note is confirmed queued.
+bool sendShuntHistory(const VEDShuntHistory &hist);
@@ -91,7 +91,7 @@ void setup() {
     // Without this guard a cold-boot I²C race causes
     // NotePayloadRetrieveAfterSleep() to return false, and the wake is
     // misclassified as first_boot — wiping prev_pin_mask, daily_opens, the
-    // pending retry queue, and any not-yet-emitted summary state. Transient
+    // outbox indices, and any not-yet-emitted summary state. Transient
     // bus unavailability must be distinguished from a genuine absence of a
     // saved payload. If the probe succeeds, a subsequent false from
     // NotePayloadRetrieveAfterSleep is a real cold boot; if it fails after
@@ -170,11 +170,17 @@ void setup() {
     initNotecard(PRODUCT_UID, state.outbound_min, state.inbound_min);
     defineTemplates();
 
+    // New outbox generation; recovers open events spilled before the host
+    // state was lost, so they are still replayed. Retried every wake until
+    // the meta Note is read; until then open events wait unstamped in the
+    // outbox ring.
+    if (!state.outbox.ready) outboxBegin(state.outbox);
+
     // Fetch env overrides on every wake — thresholds and cadences may have
     // changed since the last inbound sync.
     fetchEnvOverrides(state);
 
-    // ── Replay any pill_open.qo events that failed on the previous wake ───
+    // ── Replay any pill_open.qo events held on earlier wakes ──────────────
     replayPendingOpenEvents(state);
 
     // ── Day rollover check ────────────────────────────────────────────────
@@ -231,12 +237,10 @@ void setup() {
 
     for (uint8_t i = 0; i < NUM_COMPARTMENTS; i++) {
         if (newly_opened & (1u << i)) {
-            if (!emitOpenEvent(i, post_poll_mask, newly_opened)) {
-                // note.add failed after all retries — persist this event in
-                // the ring buffer so it can be replayed on the next wake with
-                // its original context intact.
-                enqueuePendingEvent(state, i, post_poll_mask, newly_opened);
-            }
+            // A note.add that fails after all retries is held in the
+            // outbox and replayed on a later wake with its original context
+            // intact.
+            emitOpenEvent(state, i, post_poll_mask, newly_opened);
         }
     }
 
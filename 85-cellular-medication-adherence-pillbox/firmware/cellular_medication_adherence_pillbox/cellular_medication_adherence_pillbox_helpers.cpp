@@ -226,85 +226,13 @@ void fetchEnvOverrides(PillboxState &s) {
 }
 
 // ════════════════════════════════════════════════════════════════════════════
-// emitOpenEvent — send an immediate Note when a compartment lid is opened
-//
-// sync:true bypasses the outbound timer; the radio wakes within ~15–60 s.
-//
-// day_mask  — cumulative bitmask of all compartments opened today (including
-//             this one); identical across all events emitted in the same wake.
-// poll_mask — bitmask of compartments detected open in this specific wake.
-//             More than one bit set indicates a potential refill event. The
-//             original poll_mask is preserved in the ring buffer and replayed
-//             as-is so the refill-detection heuristic works on retried events.
-//
-// Returns true on confirmed enqueue; false after all retry attempts.
-// On failure the caller should call enqueuePendingEvent() to preserve the
-// event for replay on the next wake.
-// ════════════════════════════════════════════════════════════════════════════
-bool emitOpenEvent(uint8_t idx, uint8_t day_mask, uint8_t poll_mask) {
-    const uint8_t MAX_ATTEMPTS = 3;
-    for (uint8_t attempt = 0; attempt < MAX_ATTEMPTS; attempt++) {
-        J *req = notecard.newRequest("note.add");
-        if (!req) {
-#ifdef usbSerial
-            usbSerial.println("[open] note.add alloc failed");
-#endif
-            delay(50);
-            continue;
-        }
-        JAddStringToObject(req, "file", NOTEFILE_OPEN);
-        JAddBoolToObject  (req, "sync", true);
-        J *body = JAddObjectToObject(req, "body");
-        JAddNumberToObject(body, "compartment",      (int)(idx + 1)); // 1–7
-        JAddStringToObject(body, "label",            kDayLabel[idx]);
-        JAddNumberToObject(body, "day_opens_mask",   (int)day_mask);
-        JAddNumberToObject(body, "opened_this_poll", (int)poll_mask);
-
-        J *rsp = notecard.requestAndResponse(req);
-        if (!rsp) {
-#ifdef usbSerial
-            usbSerial.print("[open] no response, attempt ");
-            usbSerial.println(attempt + 1);
-#endif
-            delay(50);
-            continue;
-        }
-        bool ok = !notecard.responseError(rsp);
-        notecard.deleteResponse(rsp);
-        if (ok) {
-#ifdef usbSerial
-            usbSerial.print("[open] compartment=");
-            usbSerial.print(idx + 1);
-            usbSerial.print(" (");
-            usbSerial.print(kDayLabel[idx]);
-            usbSerial.print(") day_mask=0b");
-            usbSerial.print(day_mask, BIN);
-            usbSerial.print(" poll_mask=0b");
-            usbSerial.println(poll_mask, BIN);
-#endif
-            return true;
-        }
-#ifdef usbSerial
-        usbSerial.print("[open] note.add error, attempt ");
-        usbSerial.println(attempt + 1);
-#endif
-        delay(50);
-    }
-#ifdef usbSerial
-    usbSerial.print("[open] note.add failed after all retries: compartment=");
-    usbSerial.println(idx + 1);
-#endif
-    return false;
-}
-
-// ════════════════════════════════════════════════════════════════════════════
-// emitPendingOverflowDiag — emit a pill_diag.qo when the pending retry queue
-// overflows or fully drains after an overflow episode.
+// emitPendingOverflowDiag — emit a pill_diag.qo when an open event is dropped
+// or when the outbox fully drains after a drop episode.
 //
-// overflow_count — number of events dropped since the last queue drain.
-// drained        — true when called after the queue empties following an
-//                  overflow episode; false when called at the moment the first
-//                  overflow in an episode occurs.
+// overflow_count — number of events dropped since the last outbox drain.
+// drained        — true when called after the outbox empties following a
+//                  drop episode; false when called at the moment the first
+//                  drop in an episode occurs.
 //
 // Uses sendRequest (fire-and-forget) intentionally: this is called from an
 // error path where the Notecard may also be degraded. The Note will be
@@ -324,82 +252,88 @@ static void emitPendingOverflowDiag(uint8_t overflow_count, bool drained) {
 }
 
 // ════════════════════════════════════════════════════════════════════════════
-// enqueuePendingEvent — push a failed open event onto the retry ring buffer
+// emitOpenEvent — send an immediate Note when a compartment lid is opened
+//
+// sync:true bypasses the outbound timer; the radio wakes within ~15–60 s.
 //
-// Stores the full per-event context (compartment, day_mask, poll_mask) so
-// each record can be replayed and removed individually. When the queue is
-// full the oldest entry is evicted and pending_overflow is incremented,
-// making the data loss explicit rather than silent. Callers can monitor
-// pending_overflow in diagnostics to detect sustained Notecard failures.
+// day_mask  — cumulative bitmask of all compartments opened today (including
+//             this one); identical across all events emitted in the same wake.
+// poll_mask — bitmask of compartments detected open in this specific wake.
+//             More than one bit set indicates a potential refill event. A
+//             held event is replayed with its original body, so the
+//             refill-detection heuristic works on retried events.
+//
+// The Note goes through the outbox (outbox.h): note.add is tried three times
+// and a Note that still fails is held for replay by
+// replayPendingOpenEvents() on a later wake. boot/seq (added by the outbox)
+// let the downstream route drop the duplicate a lost I²C acknowledgement can
+// produce. An event that is neither sent nor held is counted in
+// open_dropped and surfaced with a pill_diag.qo on the first drop.
 // ════════════════════════════════════════════════════════════════════════════
-void enqueuePendingEvent(PillboxState &s, uint8_t idx,
-                         uint8_t day_mask, uint8_t poll_mask) {
-    if (s.pending_count >= PENDING_QUEUE_CAPACITY) {
-        // Queue full: evict the oldest entry (shift left) to make room.
-        bool first_overflow = (s.pending_overflow == 0);
-        s.pending_overflow++;
-        memmove(&s.pending_queue[0], &s.pending_queue[1],
-                (PENDING_QUEUE_CAPACITY - 1) * sizeof(PendingOpenEvent));
-        s.pending_count = PENDING_QUEUE_CAPACITY - 1;
+OutboxResult emitOpenEvent(PillboxState &s, uint8_t idx,
+                           uint8_t day_mask, uint8_t poll_mask) {
+    J *body = JCreateObject();
+    if (body) {
+        JAddNumberToObject(body, "compartment",      (int)(idx + 1)); // 1–7
+        JAddStringToObject(body, "label",            kDayLabel[idx]);
+        JAddNumberToObject(body, "day_opens_mask",   (int)day_mask);
+        JAddNumberToObject(body, "opened_this_poll", (int)poll_mask);
+    }
+    OutboxResult result = outboxAdd(s.outbox, NOTEFILE_OPEN, true, body);
+
 #ifdef usbSerial
-        usbSerial.print("[open] WARN: pending queue overflow — oldest event dropped."
-                        " total_overflow=");
-        usbSerial.println(s.pending_overflow);
+    usbSerial.print(result == OUTBOX_SENT    ? "[open] compartment=" :
+                    result == OUTBOX_QUEUED  ? "[open] held for replay: compartment=" :
+                    result == OUTBOX_SPILLED ? "[open] spilled for replay: compartment=" :
+                                               "[open] WARN: dropped: compartment=");
+    usbSerial.print(idx + 1);
+    usbSerial.print(" (");
+    usbSerial.print(kDayLabel[idx]);
+    usbSerial.print(") day_mask=0b");
+    usbSerial.print(day_mask, BIN);
+    usbSerial.print(" poll_mask=0b");
+    usbSerial.println(poll_mask, BIN);
 #endif
-        // Surface the data loss to Notehub on the first overflow in an
-        // episode. Best-effort: the Notecard may also be degraded, but the
-        // Note is queued in Notecard flash and will be delivered once
-        // connectivity is restored.
-        if (first_overflow) {
-            emitPendingOverflowDiag(s.pending_overflow, false);
+
+    if (result == OUTBOX_DROPPED) {
+        bool first_drop = (s.open_dropped == 0);
+        if (s.open_dropped < 0xFF) s.open_dropped++;
+        // Surface the data loss to Notehub on the first drop in an episode.
+        // Best-effort: the Notecard may also be degraded, but the Note is
+        // queued in Notecard flash and will be delivered once connectivity
+        // is restored.
+        if (first_drop) {
+            emitPendingOverflowDiag(s.open_dropped, false);
         }
     }
-    s.pending_queue[s.pending_count].compartment = idx;
-    s.pending_queue[s.pending_count].day_mask    = day_mask;
-    s.pending_queue[s.pending_count].poll_mask   = poll_mask;
-    s.pending_count++;
+    return result;
 }
 
 // ════════════════════════════════════════════════════════════════════════════
-// replayPendingOpenEvents — retry queued pill_open.qo events from prior wakes
+// replayPendingOpenEvents — replay pill_open.qo events held on prior wakes
 //
-// Iterates the ring buffer in FIFO order. Each record carries its original
-// per-event context, so day_mask and poll_mask accurately reflect the wake
-// when the lid was actually detected. Successfully replayed records are
-// removed; still-failing records are compacted to the front of the queue.
-// pending_overflow is cleared once the queue fully drains.
+// outboxFlush() replays the ring, then the spill, oldest first, up to
+// OUTBOX_FLUSH_MAX per wake, stopping at the first Note the Notecard still
+// refuses. Each Note
+// carries its original body, so day_mask and poll_mask reflect the wake when
+// the lid was actually detected. open_dropped is cleared once the outbox
+// fully drains.
 // ════════════════════════════════════════════════════════════════════════════
 void replayPendingOpenEvents(PillboxState &s) {
-    if (s.pending_count == 0) return;
+    if (outboxPending(s.outbox) > 0) {
 #ifdef usbSerial
-    usbSerial.print("[open] replaying ");
-    usbSerial.print(s.pending_count);
-    usbSerial.println(" pending event(s)");
+        usbSerial.print("[open] replaying ");
+        usbSerial.print(outboxPending(s.outbox));
+        usbSerial.println(" held event(s)");
 #endif
-    uint8_t write_idx = 0;
-    for (uint8_t i = 0; i < s.pending_count; i++) {
-        // Copy the record before any compaction shift moves it.
-        const PendingOpenEvent e = s.pending_queue[i];
-        if (emitOpenEvent(e.compartment, e.day_mask, e.poll_mask)) {
-            // Successfully replayed — advance i without advancing write_idx,
-            // which effectively removes this entry from the queue.
-        } else {
-            // Still failing — compact to the front so the queue stays dense.
-            if (write_idx != i) {
-                s.pending_queue[write_idx] = e;
-            }
-            write_idx++;
-        }
+        outboxFlush(s.outbox);
     }
-    s.pending_count = write_idx;
-    if (s.pending_count == 0) {
-        if (s.pending_overflow > 0) {
-            // Queue drained after an overflow episode — emit a cloud-visible
-            // summary Note so the total drop count is recorded in Notehub
-            // before the counter is cleared.
-            emitPendingOverflowDiag(s.pending_overflow, true);
-        }
-        s.pending_overflow = 0; // queue fully drained; reset overflow counter
+    if (outboxPending(s.outbox) == 0 && s.open_dropped > 0) {
+        // Outbox drained after a drop episode — emit a cloud-visible summary
+        // Note so the total drop count is recorded in Notehub before the
+        // counter is cleared.
+        emitPendingOverflowDiag(s.open_dropped, true);
+        s.open_dropped = 0;
     }
 }
 
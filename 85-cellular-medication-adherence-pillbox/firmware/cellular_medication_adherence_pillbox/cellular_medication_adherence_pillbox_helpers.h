@@ -14,6 +14,8 @@
 #include <Notecard.h>
 #include <string.h>
 
+#include "outbox.h"
+
 // ── Debug output ─────────────────────────────────────────────────────────────
 // Comment out this line for production/battery builds. When undefined every
 // usbSerial.print call is compiled out, keeping each 30-second wake tight.
@@ -53,32 +55,14 @@
 // ── Notefiles ────────────────────────────────────────────────────────────────
 #define NOTEFILE_OPEN    "pill_open.qo"    // immediate open event, sync:true
 #define NOTEFILE_SUMMARY "pill_summary.qo" // daily adherence summary, templated
-#define NOTEFILE_DIAG    "pill_diag.qo"    // pending-event queue overflow diagnostic
+#define NOTEFILE_DIAG    "pill_diag.qo"    // dropped open-event diagnostic
 
 // ── Persistent state ─────────────────────────────────────────────────────────
 // Segment IDs in note-c are 4-character identifiers (NP_SEGTYPE_LEN == 4).
 // Use a full 4-character ID per the documented contract; Blues sample code
 // follows the same convention ("GLOB", "TEMP", "VOLT", etc.).
 #define STATE_SEG_ID          "PILL"
-#define PILLBOX_STATE_VERSION   5   // increment whenever PillboxState layout changes
-
-// Maximum number of failed pill_open.qo events buffered across wakes. When
-// the queue is full the oldest entry is evicted and pending_overflow is
-// incremented so the loss is visible rather than silent. A pill_diag.qo Note
-// is emitted to Notehub on the first overflow and again when the queue drains,
-// providing cloud-visible evidence of any adherence data loss.
-// 28 slots = four worst-case 7-compartment wakes.
-#define PENDING_QUEUE_CAPACITY 28
-
-// Per-event record stored when a pill_open.qo note.add fails after all retry
-// attempts. Preserving the original per-event context (day_mask, poll_mask)
-// means each event can be replayed and cleared individually, keeping
-// duplicates and multi-wake failures independently identifiable.
-struct PendingOpenEvent {
-    uint8_t compartment;  // 0-based index (0..NUM_COMPARTMENTS-1)
-    uint8_t day_mask;     // daily_opens bitmask at the moment the lid was detected open
-    uint8_t poll_mask;    // opened_this_poll bitmask from that specific wake
-};
+#define PILLBOX_STATE_VERSION   8   // increment whenever PillboxState layout changes
 
 // State persisted across sleep cycles via NotePayloadSaveAndSleep. The
 // Notecard stores this struct in its own flash and returns it on the next
@@ -96,14 +80,13 @@ struct PillboxState {
     uint16_t inbound_min;        // Notecard inbound sync cadence, minutes
     bool     summary_pending;    // true when prev_day_opens has not yet been summarized
 
-    // Ring buffer of failed pill_open.qo events. Each record preserves its
-    // own per-event context so duplicates and multi-wake failures remain
-    // individually identifiable on replay. Overflow is explicit (not silent):
-    // pending_overflow increments whenever the oldest entry is evicted to make
-    // room. The counter is cleared once the queue fully drains.
-    PendingOpenEvent pending_queue[PENDING_QUEUE_CAPACITY];
-    uint8_t          pending_count;    // occupied slots (0..PENDING_QUEUE_CAPACITY)
-    uint8_t          pending_overflow; // events dropped due to full queue
+    // pill_open.qo events whose note.add fails are held in the outbox (its
+    // ring here, then its spill on the Notecard) with their original body
+    // and replayed on later wakes. Loss is explicit (not silent):
+    // open_dropped counts events that were neither sent nor held, and is
+    // cleared once the outbox fully drains.
+    Outbox   outbox;
+    uint8_t  open_dropped;       // open events dropped since the last drain
 };
 
 // ── Notecard instance ────────────────────────────────────────────────────────
@@ -118,9 +101,8 @@ void     initNotecard(const char *product_uid, uint16_t outbound_min,
 void     defineTemplates();
 void     fetchEnvOverrides(PillboxState &s);
 uint8_t  sampleCompartments();
-bool     emitOpenEvent(uint8_t idx, uint8_t day_mask, uint8_t poll_mask);
-void     enqueuePendingEvent(PillboxState &s, uint8_t idx,
-                             uint8_t day_mask, uint8_t poll_mask);
+OutboxResult emitOpenEvent(PillboxState &s, uint8_t idx,
+                           uint8_t day_mask, uint8_t poll_mask);
 void     replayPendingOpenEvents(PillboxState &s);
 bool     emitDailySummary(uint8_t opens_mask);
 uint32_t utcDayAndHour(uint32_t *hour_out);
@@ -0,0 +1,112 @@
+/*
+  outbox.h
+
+  Durable outbox for Notes that must not be lost when note.add fails.
+
+  Every Note sent through the outbox is stamped with two body fields that
+  together form its dedup key:
+    boot — outbox generation, incremented on every cold boot of the host
+    seq  — per-generation sequence number, incremented for every Note
+  A Note whose note.add fails is held in a small ring in the Outbox struct,
+  which lives in the host state, so it is kept even while the Notecard can't
+  be reached at all. Only when the ring is full does a Note go to a
+  local-only Notefile on the Notecard (OUTBOX_FILE, a .dbx that never syncs).
+  outboxFlush() replays the ring, then the spill, oldest first. Replay is
+  at-least-once: a Note replayed just before a power cut can be replayed
+  again on the next wake, with the same boot/seq, so downstream consumers
+  drop duplicates by (device, boot, seq).
+
+  The spill costs the host only a few indices however many Notes are
+  waiting. The same indices are mirrored in a meta Note in the spill file,
+  so a cold boot (state lost) still finds and replays everything that was
+  spilled; Notes still in the ring are lost with the host state.
+
+  This file and outbox.cpp are copied unchanged into each sketch that uses
+  them (Arduino builds one sketch folder at a time); keep the copies
+  identical. The sketch provides the global Notecard object, `notecard`.
+*/
+#pragma once
+
+#include <Notecard.h>
+
+// Local-only spill Notefile and its meta Note.
+#define OUTBOX_FILE        "outbox.dbx"
+#define OUTBOX_META_NOTE   "meta"
+
+// Notes held in the host state before any are spilled, and the largest
+// unformatted body a ring slot holds; a larger body goes straight to the
+// spill. Each slot costs the sleep payload 256 bytes.
+#ifndef OUTBOX_RING_MAX
+#define OUTBOX_RING_MAX    4
+#endif
+#define OUTBOX_NOTEFILE_MAX 24
+#define OUTBOX_BODY_MAX    230
+
+// Most Notes the spill holds. When it is full a new Note is dropped rather
+// than an older one evicted, so a replay never has a hole in the middle.
+#ifndef OUTBOX_SPILL_MAX
+#define OUTBOX_SPILL_MAX   64
+#endif
+
+// Most held Notes replayed by one outboxFlush(), bounding awake time after
+// a long outage; the remainder are replayed on following wakes.
+#ifndef OUTBOX_FLUSH_MAX
+#define OUTBOX_FLUSH_MAX   8
+#endif
+
+struct OutboxEntry
+{
+    char    file[OUTBOX_NOTEFILE_MAX];  // target Notefile
+    uint8_t sync;
+    uint8_t stamped;                    // body already carries boot/seq
+    char    body[OUTBOX_BODY_MAX];      // unformatted JSON
+};
+
+struct Outbox
+{
+    uint32_t boot;      // generation, stamped as "boot"
+    uint32_t next_seq;  // stamped as "seq" on the next Note
+    uint32_t head;      // oldest spilled Note still to replay
+    uint32_t tail;      // next spill slot; head == tail means nothing spilled
+    uint32_t dropped;   // Notes neither sent nor held, since cold boot
+    uint8_t  ready;     // set once outboxBegin() has read the meta Note
+    uint8_t  ring_head; // oldest Note in ring[]
+    uint8_t  ring_count;
+    OutboxEntry ring[OUTBOX_RING_MAX];
+};
+
+enum OutboxResult
+{
+    OUTBOX_SENT,        // note.add succeeded
+    OUTBOX_QUEUED,      // note.add failed; held in the ring for replay
+    OUTBOX_SPILLED,     // note.add failed and the ring is full; spilled for replay
+    OUTBOX_DROPPED      // neither sent nor held (ring full and spill unavailable or full)
+};
+
+// Call after notecard.begin() on every wake until it succeeds, starting from
+// a zeroed Outbox on a cold boot. Recovers the spill indices from the meta
+// Note, starts a new generation and stamps any Notes already held in the
+// ring. Returns false, leaving ready clear, if the meta Note couldn't be read
+// or rewritten; until then Notes are held in the ring unstamped, nothing is
+// spilled and the meta Note is never touched, so a Notecard that is
+// unreachable or busy at boot can't orphan the spill or reuse dedup keys.
+bool outboxBegin(Outbox &ob);
+
+// Stamps body with boot/seq and sends it to file, holding it for replay if
+// note.add fails. Before outboxBegin() has succeeded the Note is only held,
+// unstamped. Takes ownership of body.
+OutboxResult outboxAdd(Outbox &ob, const char *file, bool sync, J *body);
+
+// Stamps body and holds it without trying to send it — for Notes that can't
+// be sent yet, e.g. before their template is registered. Takes ownership of
+// body.
+OutboxResult outboxHold(Outbox &ob, const char *file, bool sync, J *body);
+
+// Replays held Notes oldest first — the ring, then the spill — up to
+// OUTBOX_FLUSH_MAX, stopping at the first that fails. Call it after a
+// note.add has just succeeded, so a flush is only attempted while the
+// Notecard is known to be reachable. Returns the number of Notes replayed;
+// 0 before outboxBegin() has succeeded.
+uint32_t outboxFlush(Outbox &ob);
+
+inline uint32_t outboxPending(const Outbox &ob) { return ob.ring_count + (ob.tail - ob.head); }
@@ -3,30 +3,117 @@
   characteristic callbacks for post_discharge_vitals_hub.
 
   Implements the enrolled-device identity gate (BLE bonding primary,
-  MAC allow-list secondary), the four data callbacks, and the connect /
-  disconnect / scan callbacks.  Calls initBLE() once from setup().
+  MAC allow-list secondary), the four data callbacks, the connect /
+  disconnect / scan callbacks, and the per-link session table that lets up
+  to BLE_CENTRAL_LINKS devices be served at once.  Bonded devices are
+  subscribed from a GATT handle cache on reconnect (see gatt_cache.h), kept
+  in InternalFS.  Calls initBLE() once from setup(); the main loop drives the
+  links through bleReleaseDevice() and bleServiceLinks().
 ***************************************************************************/
 
+#include <InternalFileSystem.h>
 #include "ble_central.h"
 #include "ble_parsers.h"
+#include "gatt_cache.h"
 #include "notecard_helpers.h"   // for notecard extern + sendCommissioningNote
 
+using namespace Adafruit_LittleFS_Namespace;
+
+// ─── Cacheable client service ─────────────────────────────────────────────────
+// BLEClientService learns its connection handle and handle range in
+// discover(); restore() sets both from the GATT cache instead, so the
+// characteristics under it can be bound without any ATT traffic.  _conn_hdl
+// and _hdl_range are protected members of the BSP class.
+class CachedClientService : public BLEClientService {
+public:
+    CachedClientService(uint16_t uuid16) : BLEClientService(uuid16) {}
+
+    void restore(uint16_t connHandle, uint16_t start, uint16_t end) {
+        _conn_hdl               = connHandle;
+        _hdl_range.start_handle = start;
+        _hdl_range.end_handle   = end;
+    }
+};
+
 // ─── BLE client service + characteristic objects ──────────────────────────────
 // Declared at module scope so the nRF52 BLE stack can register them.
 // .begin() on each is called in initBLE() after Bluefruit.begin().
 
-static BLEClientService        s_weightSvc   (0x181D);
+static CachedClientService     s_weightSvc   (0x181D);
 static BLEClientCharacteristic s_weightChar  (0x2A9D);  // Weight Measurement (indicate)
 
-static BLEClientService        s_bpSvc       (0x1810);
+static CachedClientService     s_bpSvc       (0x1810);
 static BLEClientCharacteristic s_bpChar      (0x2A35);  // Blood Pressure Measurement (indicate)
 
-static BLEClientService        s_pulseOxSvc  (0x1822);
+static CachedClientService     s_pulseOxSvc  (0x1822);
 static BLEClientCharacteristic s_pulseOxChar (0x2A5E);  // PLX Spot-Check Measurement (indicate)
 
-static BLEClientService        s_hrSvc       (0x180D);
+static CachedClientService     s_hrSvc       (0x180D);
 static BLEClientCharacteristic s_hrChar      (0x2A37);  // Heart Rate Measurement (notify)
 
+// Generic Attribute Service / Service Changed, one pair per device type so
+// every open link can hold its own subscription.  A Service Changed
+// indication means the peer's attribute table moved: its cache entry is
+// dropped and the link is rediscovered.
+static CachedClientService     s_weightGattSvc  (0x1801);
+static BLEClientCharacteristic s_weightScChar   (0x2A05);
+static CachedClientService     s_bpGattSvc      (0x1801);
+static BLEClientCharacteristic s_bpScChar       (0x2A05);
+static CachedClientService     s_pulseOxGattSvc (0x1801);
+static BLEClientCharacteristic s_pulseOxScChar  (0x2A05);
+static CachedClientService     s_hrGattSvc      (0x1801);
+static BLEClientCharacteristic s_hrScChar       (0x2A05);
+
+// ─── Per-link session table ───────────────────────────────────────────────────
+// One entry per open Central link, plus the link statistics.  The BSP
+// dispatches connect, security, disconnect and data callbacks one at a time
+// from its callback task, so the callbacks never race each other; the main
+// loop also writes the table, so state changes on both sides are made inside
+// noInterrupts()/interrupts() sections.
+//
+//   SECURING    — connected; pairing / bond re-encryption in progress
+//   SUBSCRIBED  — CCCD written (after discovery, or at once from the GATT
+//                 cache); waiting for a measurement
+//   CLOSING     — disconnect requested; waiting for the disconnect callback
+
+enum LinkState : uint8_t { LINK_FREE, LINK_SECURING, LINK_SUBSCRIBED, LINK_CLOSING };
+
+struct CentralLink {
+    uint16_t     conn_handle;
+    LinkState    state;
+    VitalsDevice device;    // bound GATT client; DEV_NONE until subscribed
+    VitalsDevice hint;      // service seen in the advertisement that led here
+    uint32_t     start_ms;  // connect callback time — watchdog and latency base
+    bool         measured;  // at least one plausible reading delivered
+    bool         counted;   // already counted in s_stats.subscribed
+    bool         cached;    // subscribed from the GATT cache, not discovery
+    GattCacheEntry gatt;    // peer identity + handles: cached, or being learned
+};
+
+static CentralLink  s_links[BLE_CENTRAL_LINKS];
+static uint8_t      s_openLinks = 0;
+
+// Connection attempt issued from the scan callback and not yet answered by a
+// connect callback.  The SoftDevice has a single connection initiator, so at
+// most one attempt is pending; bleServiceLinks() cancels it after
+// BLE_CONNECT_TIMEOUT_MS.
+static volatile VitalsDevice s_pendingDevice = DEV_NONE;
+static uint32_t              s_pendingSinceMs = 0;
+
+static BleLinkStats s_stats = {};
+
+// ─── GATT handle cache ────────────────────────────────────────────────────────
+// Loaded from InternalFS in initBLE(); updated by the callbacks; written back
+// by bleServiceLinks() once no link is open, so the flash erase never stalls
+// the loop while a device is waiting to be served.
+#define GATT_CACHE_FILE  "/vitals_gatt.bin"
+
+static GattCache s_gattCache;
+
+// CCCD values; static so they outlive the asynchronous sd_ble_gattc_write().
+static const uint8_t kCccdNotify[2]   = { 0x01, 0x00 };
+static const uint8_t kCccdIndicate[2] = { 0x02, 0x00 };
+
 // ─────────────────────────────────────────────────────────────────────────────
 // COMMISSIONING STATE  (compiled in only when the identity gate is bypassed)
 // ─────────────────────────────────────────────────────────────────────────────
@@ -181,6 +268,74 @@ static bool isIdentifiedDevice(const ble_gap_evt_adv_report_t *report) {
 #endif
 }
 
+// ─────────────────────────────────────────────────────────────────────────────
+// SESSION TABLE HELPERS
+// ─────────────────────────────────────────────────────────────────────────────
+
+static CentralLink *findLink(uint16_t connHandle) {
+    for (uint8_t i = 0; i < BLE_CENTRAL_LINKS; ++i) {
+        if (s_links[i].state != LINK_FREE && s_links[i].conn_handle == connHandle) {
+            return &s_links[i];
+        }
+    }
+    return NULL;
+}
+
+// True when a link is open (or being opened) to a device of this type — its
+// GATT client is then bound to that link and cannot serve a second one.
+static bool deviceBusy(VitalsDevice dev) {
+    if (s_pendingDevice == dev) return true;
+    for (uint8_t i = 0; i < BLE_CENTRAL_LINKS; ++i) {
+        if (s_links[i].state == LINK_FREE) continue;
+        if (s_links[i].device == dev) return true;
+        if (s_links[i].device == DEV_NONE && s_links[i].hint == dev) return true;
+    }
+    return false;
+}
+
+// True when the GATT client for this type is bound to an open link other
+// than `self`.
+static bool clientInUse(const CentralLink *self, VitalsDevice dev) {
+    for (uint8_t i = 0; i < BLE_CENTRAL_LINKS; ++i) {
+        if (&s_links[i] != self && s_links[i].state != LINK_FREE &&
+            s_links[i].device == dev) return true;
+    }
+    return false;
+}
+
+// Drops the link peer's GATT cache entry — its cached handles proved stale.
+static void forgetGatt(CentralLink *link) {
+    noInterrupts();
+    bool erased = gattCacheErase(&s_gattCache, link->gatt.addr, link->gatt.addr_type);
+    interrupts();
+    if (erased) DBG_PRINT("[BLE] conn=0x%04X GATT cache entry dropped\n", link->conn_handle);
+}
+
+// Records the first plausible measurement on a link for the latency stats.
+// A discovered link's handles are cached at this point rather than at
+// subscription: the measurement proves the subscription works, and by now
+// the descriptor discovery event that carried the CCCD handle has been seen.
+static void noteMeasurement(BLEClientCharacteristic *chr) {
+    CentralLink *link = findLink(chr->connHandle());
+    if (!link || link->measured) return;
+    link->measured = true;
+    const GattCacheEntry &g = link->gatt;
+    if (!link->cached && g.value_handle && g.cccd_handle > g.value_handle &&
+        g.cccd_handle <= g.svc_end) {
+        noInterrupts();
+        gattCacheStore(&s_gattCache, &g);
+        interrupts();
+    }
+    uint32_t latency = millis() - link->start_ms;
+    noInterrupts();
+    s_stats.readings++;
+    s_stats.latency_sum_ms += latency;
+    if (latency > s_stats.latency_max_ms) s_stats.latency_max_ms = latency;
+    interrupts();
+    DBG_PRINT("[BLE] conn=0x%04X first measurement after %lu ms\n",
+              link->conn_handle, (unsigned long)latency);
+}
+
 // ─────────────────────────────────────────────────────────────────────────────
 // BLE CHARACTERISTIC DATA CALLBACKS (SoftDevice task context)
 // ─────────────────────────────────────────────────────────────────────────────
@@ -191,7 +346,7 @@ static bool isIdentifiedDevice(const ble_gap_evt_adv_report_t *report) {
 // malformed or noncompliant device cannot inject impossible readings or trip
 // alert thresholds.
 
-static void weightDataCallback(BLEClientCharacteristic * /*chr*/,
+static void weightDataCallback(BLEClientCharacteristic *chr,
                                 uint8_t *data, uint16_t len) {
     float kg = parseWeightKg(data, len);
     if (kg < 0.0f) return;  // parse error or unsuccessful sentinel
@@ -202,9 +357,10 @@ static void weightDataCallback(BLEClientCharacteristic * /*chr*/,
     g_weight.prev_kg = g_last_weight_kg;
     g_weight.kg      = kg;
     g_weight.valid   = true;
+    noteMeasurement(chr);
 }
 
-static void bpDataCallback(BLEClientCharacteristic * /*chr*/,
+static void bpDataCallback(BLEClientCharacteristic *chr,
                             uint8_t *data, uint16_t len) {
     int16_t sys, dia, pulse;
     parseBpMmhg(data, len, &sys, &dia, &pulse);
@@ -218,9 +374,10 @@ static void bpDataCallback(BLEClientCharacteristic * /*chr*/,
     g_bp.diastolic = dia;
     g_bp.pulse_bpm = pulse;
     g_bp.valid     = true;
+    noteMeasurement(chr);
 }
 
-static void spo2DataCallback(BLEClientCharacteristic * /*chr*/,
+static void spo2DataCallback(BLEClientCharacteristic *chr,
                               uint8_t *data, uint16_t len) {
     int16_t sp, pulse;
     parseSpO2(data, len, &sp, &pulse);
@@ -232,9 +389,10 @@ static void spo2DataCallback(BLEClientCharacteristic * /*chr*/,
     g_spo2.spo2_pct  = sp;
     g_spo2.pulse_bpm = pulse;
     g_spo2.valid     = true;
+    noteMeasurement(chr);
 }
 
-static void hrDataCallback(BLEClientCharacteristic * /*chr*/,
+static void hrDataCallback(BLEClientCharacteristic *chr,
                             uint8_t *data, uint16_t len) {
     uint16_t hr = parseHeartRate(data, len);
     if (hr == 0) return;  // parse error
@@ -244,6 +402,7 @@ static void hrDataCallback(BLEClientCharacteristic * /*chr*/,
     }
     g_activity.heart_rate_bpm = hr;
     g_activity.valid          = true;
+    noteMeasurement(chr);
 }
 
 // ─────────────────────────────────────────────────────────────────────────────
@@ -252,65 +411,259 @@ static void hrDataCallback(BLEClientCharacteristic * /*chr*/,
 // Called from bleSecuredCallback once the link is encrypted, and from
 // bleConnectCallback in the rare case where the link is already secured when
 // the connection event fires.  Always runs over an encrypted link.
-// Discovers which of the four target service types is present, subscribes to
-// the appropriate characteristic, and sets g_oneshot_conn_handle or
-// g_hrConnHandle.  Disconnects and returns false on any failure so the
-// caller can abort cleanly without leaving a stale Central slot.
+//
+// Fast path — a bonded device with a GATT cache entry: the client objects are
+// bound to the cached handles and the CCCD is written at once, one ATT
+// request in place of a full discovery.  The write is checked when its
+// response arrives (bleEventCallback); a stale entry is also caught by a
+// Service Changed indication or by the link closing without a measurement.
+// Each drops the entry, so the next connection rediscovers.
+//
+// Full discovery otherwise: finds which of the four target service types is
+// present, subscribes to the appropriate characteristic, and binds the link
+// to that device type.  The service seen in the advertisement is tried
+// first, so a typical link costs one service discovery rather than up to
+// four.  Types whose GATT client is already bound to another open link are
+// skipped.  Once subscribed, the peer's Service Changed characteristic is
+// subscribed too, so later cache hits are covered.
+//
+// Disconnects and returns false on any failure so the caller can abort
+// cleanly without leaving a stale link.
 
-static bool doDiscoverAndSubscribe(uint16_t connHandle) {
-    if (s_weightSvc.discover(connHandle)) {
-        DBG_PRINTLN("[BLE] Weight scale — subscribing");
-        s_weightChar.setIndicateCallback(weightDataCallback);
-        if (!s_weightChar.discover() ||
-            !s_weightChar.enableIndicate()) {
-            DBG_PRINTLN("[BLE] Weight: subscription failed — disconnecting");
-            Bluefruit.disconnect(connHandle);
-            return false;
-        }
-        g_oneshot_conn_handle = connHandle;
-
-    } else if (s_bpSvc.discover(connHandle)) {
-        DBG_PRINTLN("[BLE] Blood pressure cuff — subscribing");
-        s_bpChar.setIndicateCallback(bpDataCallback);
-        if (!s_bpChar.discover() ||
-            !s_bpChar.enableIndicate()) {
-            DBG_PRINTLN("[BLE] BP: subscription failed — disconnecting");
-            Bluefruit.disconnect(connHandle);
-            return false;
-        }
-        g_oneshot_conn_handle = connHandle;
-
-    } else if (s_pulseOxSvc.discover(connHandle)) {
-        DBG_PRINTLN("[BLE] Pulse oximeter — subscribing");
-        s_pulseOxChar.setIndicateCallback(spo2DataCallback);
-        if (!s_pulseOxChar.discover() ||
-            !s_pulseOxChar.enableIndicate()) {
-            DBG_PRINTLN("[BLE] SpO2: subscription failed — disconnecting");
-            Bluefruit.disconnect(connHandle);
-            return false;
-        }
-        g_oneshot_conn_handle = connHandle;
-
-    } else if (s_hrSvc.discover(connHandle)) {
-        DBG_PRINTLN("[BLE] Activity band (Heart Rate Service) — subscribing");
-        s_hrChar.setNotifyCallback(hrDataCallback);
-        if (!s_hrChar.discover() ||
-            !s_hrChar.enableNotify()) {
-            DBG_PRINTLN("[BLE] HR: subscription failed — disconnecting");
-            Bluefruit.disconnect(connHandle);
-            return false;
-        }
-        g_hrConnHandle = connHandle;
+struct DeviceClient {
+    CachedClientService                  *svc;
+    BLEClientCharacteristic              *chr;
+    uint16_t                              chr_uuid;
+    BLEClientCharacteristic::notify_cb_t  cb;
+    bool                                  indicate;  // else notify
+    CachedClientService                  *gattSvc;   // Service Changed client
+    BLEClientCharacteristic              *scChr;
+    const char                           *name;
+};
+
+static const DeviceClient s_clients[DEV_TYPE_COUNT] = {
+    { &s_weightSvc,  &s_weightChar,  0x2A9D, weightDataCallback, true,
+      &s_weightGattSvc,  &s_weightScChar,  "Weight scale" },
+    { &s_bpSvc,      &s_bpChar,      0x2A35, bpDataCallback,     true,
+      &s_bpGattSvc,      &s_bpScChar,      "Blood pressure cuff" },
+    { &s_pulseOxSvc, &s_pulseOxChar, 0x2A5E, spo2DataCallback,   true,
+      &s_pulseOxGattSvc, &s_pulseOxScChar, "Pulse oximeter" },
+    { &s_hrSvc,      &s_hrChar,      0x2A37, hrDataCallback,     false,
+      &s_hrGattSvc,      &s_hrScChar,      "Activity band (Heart Rate Service)" },
+};
+
+static void serviceChangedCallback(BLEClientCharacteristic *chr, uint8_t *data, uint16_t len);
+
+// Binds chr to a cached value handle, as its own discover() would have.
+static void assignCached(BLEClientCharacteristic *chr, uint16_t uuid16,
+                         bool indicate, uint16_t valueHandle) {
+    ble_gattc_char_t gc = {};
+    gc.uuid.type             = BLE_UUID_TYPE_BLE;
+    gc.uuid.uuid             = uuid16;
+    gc.char_props.indicate   = indicate;
+    gc.char_props.notify     = !indicate;
+    gc.handle_decl           = valueHandle - 1;
+    gc.handle_value          = valueHandle;
+    chr->assign(&gc);
+}
+
+static void markSubscribed(CentralLink *link, VitalsDevice dev, bool cached) {
+    uint32_t elapsed = millis() - link->start_ms;
+    noInterrupts();
+    link->device = dev;
+    link->cached = cached;
+    link->state  = LINK_SUBSCRIBED;
+    if (!link->counted) {
+        link->counted = true;
+        s_stats.subscribed++;
+        s_stats.subscribe_sum_ms += elapsed;
+        if (cached) s_stats.cached++;
+    }
+    interrupts();
+    DBG_PRINT("[BLE] conn=0x%04X subscribed %s after %lu ms\n", link->conn_handle,
+              cached ? "from GATT cache" : "by discovery", (unsigned long)elapsed);
+}
+
+static bool subscribeFromCache(CentralLink *link) {
+    GattCacheEntry e;
+    noInterrupts();
+    GattCacheEntry *hit = gattCacheFind(&s_gattCache, link->gatt.addr, link->gatt.addr_type);
+    if (hit) e = *hit;
+    interrupts();
+    if (!hit || e.device >= DEV_TYPE_COUNT || clientInUse(link, (VitalsDevice)e.device)) {
+        return false;
+    }
 
+    const DeviceClient &c = s_clients[e.device];
+    DBG_PRINT("[BLE] %s — subscribing from GATT cache conn=0x%04X\n", c.name, link->conn_handle);
+    c.svc->restore(link->conn_handle, e.svc_start, e.svc_end);
+    assignCached(c.chr, c.chr_uuid, c.indicate, e.value_handle);
+    if (c.indicate) c.chr->setIndicateCallback(c.cb);
+    else            c.chr->setNotifyCallback(c.cb);
+
+    // The peer keeps a bonded client's Service Changed CCCD across
+    // connections, so binding the value handle is enough to receive it.
+    if (e.sc_handle) {
+        c.gattSvc->restore(link->conn_handle, e.sc_handle - 1, e.sc_handle + 1);
+        assignCached(c.scChr, 0x2A05, true, e.sc_handle);
+        c.scChr->setIndicateCallback(serviceChangedCallback);
+    }
+
+    link->gatt   = e;
+    link->cached = true;   // before the write, so its response is recognized
+    ble_gattc_write_params_t wp = {};
+    wp.write_op = BLE_GATT_OP_WRITE_REQ;
+    wp.handle   = e.cccd_handle;
+    wp.len      = 2;
+    wp.p_value  = c.indicate ? kCccdIndicate : kCccdNotify;
+    if (sd_ble_gattc_write(link->conn_handle, &wp) != NRF_SUCCESS) {
+        link->cached = false;
+        return false;
+    }
+    markSubscribed(link, (VitalsDevice)e.device, true);
+    return true;
+}
+
+static bool subscribe(CentralLink *link, VitalsDevice dev) {
+    const DeviceClient &c = s_clients[dev];
+    DBG_PRINT("[BLE] %s — subscribing conn=0x%04X\n", c.name, link->conn_handle);
+
+    // The CCCD handle is picked out of the descriptor discovery response by
+    // bleEventCallback — the BSP does not expose it — so note the service
+    // range it must fall in first.
+    ble_gattc_handle_range_t range = c.svc->getHandleRange();
+    noInterrupts();
+    link->gatt.svc_start    = range.start_handle;
+    link->gatt.svc_end      = range.end_handle;
+    link->gatt.value_handle = 0;
+    link->gatt.cccd_handle  = 0;
+    link->gatt.sc_handle    = 0;
+    interrupts();
+
+    bool ok;
+    if (c.indicate) {
+        c.chr->setIndicateCallback(c.cb);
+        ok = c.chr->discover() && c.chr->enableIndicate();
     } else {
-        // Not one of our target service types — free the Central slot immediately.
-        DBG_PRINTLN("[BLE] Unknown service set — disconnecting");
-        Bluefruit.disconnect(connHandle);
+        c.chr->setNotifyCallback(c.cb);
+        ok = c.chr->discover() && c.chr->enableNotify();
+    }
+    if (!ok) {
+        DBG_PRINT("[BLE] %s: subscription failed — disconnecting\n", c.name);
         return false;
     }
+    link->gatt.device       = dev;
+    link->gatt.value_handle = c.chr->valueHandle();
+    markSubscribed(link, dev, false);
+
+    // Optional: a peer without a Service Changed characteristic never moves
+    // its handles while bonded, per the Core spec.
+    c.scChr->setIndicateCallback(serviceChangedCallback);
+    if (c.gattSvc->discover(link->conn_handle) && c.scChr->discover() &&
+        c.scChr->enableIndicate()) {
+        link->gatt.sc_handle = c.scChr->valueHandle();
+    }
     return true;
 }
 
+static bool discoverAndSubscribe(CentralLink *link) {
+    // Advertised type first, then the rest in table order.
+    VitalsDevice order[DEV_TYPE_COUNT];
+    uint8_t n = 0;
+    if (link->hint != DEV_NONE) order[n++] = link->hint;
+    for (uint8_t d = 0; d < DEV_TYPE_COUNT; ++d) {
+        if (d != link->hint) order[n++] = (VitalsDevice)d;
+    }
+
+    for (uint8_t i = 0; i < n; ++i) {
+        VitalsDevice dev = order[i];
+        if (clientInUse(link, dev) || !s_clients[dev].svc->discover(link->conn_handle)) continue;
+        if (subscribe(link, dev)) return true;
+        link->state = LINK_CLOSING;
+        Bluefruit.disconnect(link->conn_handle);
+        return false;
+    }
+
+    // Not one of our target service types — free the link immediately.
+    DBG_PRINTLN("[BLE] Unknown service set — disconnecting");
+    link->state = LINK_CLOSING;
+    Bluefruit.disconnect(link->conn_handle);
+    return false;
+}
+
+static bool doDiscoverAndSubscribe(uint16_t connHandle) {
+    CentralLink *link = findLink(connHandle);
+    if (!link) {
+        Bluefruit.disconnect(connHandle);
+        return false;
+    }
+    if (subscribeFromCache(link)) return true;
+    return discoverAndSubscribe(link);
+}
+
+// Service Changed indication (callback task): the peer's attribute table has
+// moved, so the handles this link was subscribed with — cached or just
+// discovered — may be stale.  Drop the cache entry and rediscover on the
+// same link, while the device is still connected, instead of losing its
+// reading.  The rediscovered handles are cached again on the first
+// measurement.
+static void serviceChangedCallback(BLEClientCharacteristic *chr,
+                                   uint8_t * /*data*/, uint16_t /*len*/) {
+    CentralLink *link = findLink(chr->connHandle());
+    if (!link || link->state != LINK_SUBSCRIBED) return;
+    DBG_PRINT("[BLE] conn=0x%04X Service Changed — rediscovering\n", link->conn_handle);
+    forgetGatt(link);
+    noInterrupts();
+    link->hint   = link->device;
+    link->device = DEV_NONE;
+    link->cached = false;
+    link->state  = LINK_SECURING;
+    interrupts();
+    discoverAndSubscribe(link);
+}
+
+// Raw SoftDevice events, seen after the BSP's own handling (BLE task).
+// Used for the two things the BSP's client classes do not surface: the CCCD
+// handle found by descriptor discovery, and the response to the CCCD write
+// issued from the cache.
+static void bleEventCallback(ble_evt_t *evt) {
+    switch (evt->header.evt_id) {
+    case BLE_GATTC_EVT_DESC_DISC_RSP: {
+        const ble_gattc_evt_t &g = evt->evt.gattc_evt;
+        CentralLink *link = findLink(g.conn_handle);
+        if (!link || link->cached || link->gatt.cccd_handle || !link->gatt.svc_end) break;
+        for (uint16_t i = 0; i < g.params.desc_disc_rsp.count; ++i) {
+            const ble_gattc_desc_t &d = g.params.desc_disc_rsp.descs[i];
+            if (d.uuid.type == BLE_UUID_TYPE_BLE &&
+                d.uuid.uuid == BLE_UUID_DESCRIPTOR_CLIENT_CHAR_CONFIG &&
+                d.handle > link->gatt.svc_start && d.handle <= link->gatt.svc_end) {
+                link->gatt.cccd_handle = d.handle;
+                break;
+            }
+        }
+        break;
+    }
+    case BLE_GATTC_EVT_WRITE_RSP: {
+        const ble_gattc_evt_t &g = evt->evt.gattc_evt;
+        CentralLink *link = findLink(g.conn_handle);
+        if (!link || !link->cached || g.params.write_rsp.handle != link->gatt.cccd_handle) break;
+        if (g.gatt_status != BLE_GATT_STATUS_SUCCESS) {
+            // The cached handle no longer names a writable CCCD.  Drop the
+            // entry and close: the device reconnects while it is still
+            // advertising and is rediscovered then.
+            DBG_PRINT("[BLE] conn=0x%04X cached CCCD write rejected (0x%04X) — disconnecting\n",
+                      g.conn_handle, g.gatt_status);
+            forgetGatt(link);
+            link->state = LINK_CLOSING;
+            Bluefruit.disconnect(g.conn_handle);
+        }
+        break;
+    }
+    default:
+        break;
+    }
+}
+
 // ─────────────────────────────────────────────────────────────────────────────
 // BLE SECURITY CALLBACKS
 // ─────────────────────────────────────────────────────────────────────────────
@@ -407,20 +760,52 @@ static void bleSecuredCallback(uint16_t connHandle) {
 // bleSecuredCallback will not fire again; discovery is driven directly from
 // this callback instead.
 //
-// Any failure disconnects immediately to free the single Central slot.
+// The link is entered in the session table before anything else, so the
+// per-link watchdog in bleServiceLinks() covers it even if the security
+// negotiation hangs, and scanning resumes at once while a link remains free —
+// the SoftDevice stops the scanner when it starts a connection attempt.
+//
+// Any failure disconnects immediately to free the link.
 static void bleConnectCallback(uint16_t connHandle) {
-    // Record connection start time for the measurement timeout watchdog in
-    // loop().  Set before requestPairing() so the watchdog fires even if the
-    // security negotiation hangs.
-    g_active_conn_handle = connHandle;
-    g_conn_start_ms      = millis();
-    DBG_PRINT("[BLE] Connected 0x%04X\n", connHandle);
-
+    CentralLink *link = NULL;
+    for (uint8_t i = 0; i < BLE_CENTRAL_LINKS && !link; ++i) {
+        if (s_links[i].state == LINK_FREE) link = &s_links[i];
+    }
+    VitalsDevice hint = s_pendingDevice;
+    s_pendingDevice   = DEV_NONE;
     BLEConnection *conn = Bluefruit.Connection(connHandle);
-    if (!conn) {
+    if (!link || !conn) {
+        // No free entry cannot happen while Bluefruit.begin() reserves
+        // BLE_CENTRAL_LINKS central connections; refuse rather than run an
+        // untracked link.
         Bluefruit.disconnect(connHandle);
         return;
     }
+    // Bond identity: for a Privacy-enabled device the SoftDevice has already
+    // resolved the RPA to the identity address; it keys the GATT cache.
+    ble_gap_addr_t peer = conn->getPeerAddr();
+    noInterrupts();
+    link->conn_handle = connHandle;
+    link->device      = DEV_NONE;
+    link->hint        = hint;
+    link->start_ms    = millis();
+    link->measured    = false;
+    link->counted     = false;
+    link->cached      = false;
+    memset(&link->gatt, 0, sizeof(link->gatt));
+    memcpy(link->gatt.addr, peer.addr, 6);
+    link->gatt.addr_type = peer.addr_type;
+    link->state       = LINK_SECURING;
+    s_openLinks++;
+    s_stats.links++;
+    if (s_openLinks > s_stats.max_concurrent) s_stats.max_concurrent = s_openLinks;
+    interrupts();
+    DBG_PRINT("[BLE] Connected 0x%04X (%u/%u links)\n",
+              connHandle, s_openLinks, (unsigned)BLE_CENTRAL_LINKS);
+
+    if (s_openLinks < BLE_CENTRAL_LINKS && !Bluefruit.Scanner.isRunning()) {
+        Bluefruit.Scanner.start(0);
+    }
 
     if (conn->secured()) {
         // Link already secured before our callback ran (peripheral-initiated).
@@ -455,12 +840,29 @@ static void bleConnectCallback(uint16_t connHandle) {
     // Discovery deferred to bleSecuredCallback.
 }
 
-// Called on disconnect.  The scanner restarts automatically because
-// restartOnDisconnect(true) was set in initBLE().
+// Called on disconnect.  Frees the link's session entry; a subscribed link
+// that closes without having delivered a measurement counts as a missed
+// reading.  The scanner restarts automatically (if all links were in use)
+// because restartOnDisconnect(true) was set in initBLE().
 static void bleDisconnectCallback(uint16_t connHandle, uint8_t reason) {
-    if (connHandle == g_hrConnHandle)        g_hrConnHandle        = BLE_CONN_HANDLE_INVALID;
-    if (connHandle == g_oneshot_conn_handle) g_oneshot_conn_handle = BLE_CONN_HANDLE_INVALID;
-    if (connHandle == g_active_conn_handle)  g_active_conn_handle  = BLE_CONN_HANDLE_INVALID;
+    CentralLink *link = findLink(connHandle);
+    if (link) {
+        bool missed = (link->device != DEV_NONE && !link->measured);
+        if (missed) {
+            DBG_PRINT("[BLE] %s closed without a measurement\n", s_clients[link->device].name);
+            // A cached subscription that never delivered may be on stale
+            // handles the peer did not report; rediscover next time.
+            if (link->cached) forgetGatt(link);
+        }
+        noInterrupts();
+        if (missed) s_stats.missed++;
+        if (s_openLinks > 0) s_openLinks--;
+        link->state       = LINK_FREE;
+        link->device      = DEV_NONE;
+        link->hint        = DEV_NONE;
+        link->conn_handle = BLE_CONN_HANDLE_INVALID;
+        interrupts();
+    }
     DBG_PRINT("[BLE] Disconnected conn=0x%04X reason=0x%02X\n", connHandle, reason);
 #if ALLOW_UNENROLLED_DEVICES_FOR_DEV
     if (s_pairingPendingHandle == connHandle) {
@@ -482,7 +884,9 @@ static void bleDisconnectCallback(uint16_t connHandle, uint8_t reason) {
 
 // Called for each advertisement packet seen during a scan.
 // Connects only to identified devices (bonded IRK-resolved or MAC-listed)
-// that advertise one of the four target service UUIDs.
+// that advertise one of the four target service UUIDs, and only when a link
+// is free, no other connection attempt is pending, and no device of the same
+// type is already connected.
 // With ALLOW_UNENROLLED_DEVICES_FOR_DEV=1, the identity gate is bypassed.
 static void bleScanCallback(ble_gap_evt_adv_report_t *report) {
     // Reject devices not passing the identity gate before inspecting services.
@@ -507,19 +911,28 @@ static void bleScanCallback(ble_gap_evt_adv_report_t *report) {
     // that would flood activity.qo.
     bool hr_due = (millis() - g_last_hr_sample_ms >= HR_SAMPLE_INTERVAL_MS);
 
-    if (Bluefruit.Scanner.checkReportForService(report, s_weightSvc)  ||
-        Bluefruit.Scanner.checkReportForService(report, s_bpSvc)      ||
-        Bluefruit.Scanner.checkReportForService(report, s_pulseOxSvc) ||
-        (hr_due && Bluefruit.Scanner.checkReportForService(report, s_hrSvc))) {
+    VitalsDevice dev = DEV_NONE;
+    for (uint8_t d = 0; d < DEV_TYPE_COUNT && dev == DEV_NONE; ++d) {
+        if (d == DEV_HR && !hr_due) continue;
+        if (Bluefruit.Scanner.checkReportForService(report, *s_clients[d].svc)) {
+            dev = (VitalsDevice)d;
+        }
+    }
+
+    if (dev != DEV_NONE && s_pendingDevice == DEV_NONE &&
+        s_openLinks < BLE_CENTRAL_LINKS && !deviceBusy(dev)) {
 #if ALLOW_UNENROLLED_DEVICES_FOR_DEV
         // Claim the commissioning slot before calling connect so that any
         // subsequent scan callback firing in the same window (for a different
         // nearby device) sees the lock immediately.
         s_commissioningSlotTaken = true;
 #endif
+        s_pendingSinceMs = millis();
+        s_pendingDevice  = dev;
         if (!Bluefruit.Central.connect(report)) {
             // connect() failed synchronously — release any held state and
             // resume scanning so the hub does not stall permanently.
+            s_pendingDevice = DEV_NONE;
 #if ALLOW_UNENROLLED_DEVICES_FOR_DEV
             s_commissioningSlotTaken = false;
 #endif
@@ -530,13 +943,53 @@ static void bleScanCallback(ble_gap_evt_adv_report_t *report) {
     }
 }
 
+// ─────────────────────────────────────────────────────────────────────────────
+// GATT CACHE PERSISTENCE
+// ─────────────────────────────────────────────────────────────────────────────
+// The whole table is one small file, rewritten on change.  A missing, corrupt
+// or other-version file just means every device is discovered in full once.
+
+static void gattCacheLoad() {
+    gattCacheInit(&s_gattCache);
+    uint8_t buf[GATT_CACHE_IMAGE_MAX];
+    File file(InternalFS);
+    if (!file.open(GATT_CACHE_FILE, FILE_O_READ)) return;
+    uint16_t len = (uint16_t)file.read(buf, sizeof(buf));
+    file.close();
+    if (!gattCacheDecode(&s_gattCache, buf, len)) {
+        DBG_PRINTLN("[BLE] GATT cache file invalid — discarding");
+        InternalFS.remove(GATT_CACHE_FILE);
+        return;
+    }
+    DBG_PRINT("[BLE] GATT cache: %u bytes loaded\n", len);
+}
+
+static void gattCacheSave() {
+    uint8_t  buf[GATT_CACHE_IMAGE_MAX];
+    uint16_t len;
+    noInterrupts();
+    len = gattCacheEncode(&s_gattCache, buf);
+    s_gattCache.dirty = false;
+    interrupts();
+
+    // FILE_O_WRITE appends, so replace the file rather than open it.
+    InternalFS.remove(GATT_CACHE_FILE);
+    File file(InternalFS);
+    bool ok = file.open(GATT_CACHE_FILE, FILE_O_WRITE) && file.write(buf, len) == len;
+    file.close();
+    if (!ok) {
+        DBG_PRINTLN("[BLE] GATT cache save failed — will retry");
+        s_gattCache.dirty = true;
+    }
+}
+
 // ─────────────────────────────────────────────────────────────────────────────
 // BLE INITIALIZATION
 // ─────────────────────────────────────────────────────────────────────────────
 
 void initBLE() {
-    // Start as Central only: 0 peripheral slots, 1 central slot
-    Bluefruit.begin(0, 1);
+    // Start as Central only: 0 peripheral slots, one central slot per link
+    Bluefruit.begin(0, BLE_CENTRAL_LINKS);
     Bluefruit.setName("VitalsHub");
     Bluefruit.setTxPower(4);  // +4 dBm — adequate for a bedside room
 
@@ -575,6 +1028,21 @@ void initBLE() {
     s_bpSvc.begin();       s_bpChar.begin();
     s_pulseOxSvc.begin();  s_pulseOxChar.begin();
     s_hrSvc.begin();       s_hrChar.begin();
+    s_weightGattSvc.begin();   s_weightScChar.begin();
+    s_bpGattSvc.begin();       s_bpScChar.begin();
+    s_pulseOxGattSvc.begin();  s_pulseOxScChar.begin();
+    s_hrGattSvc.begin();       s_hrScChar.begin();
+
+    for (uint8_t i = 0; i < BLE_CENTRAL_LINKS; ++i) {
+        s_links[i].conn_handle = BLE_CONN_HANDLE_INVALID;
+        s_links[i].state       = LINK_FREE;
+        s_links[i].device      = DEV_NONE;
+        s_links[i].hint        = DEV_NONE;
+    }
+
+    // Bluefruit.begin() has mounted InternalFS (it keeps the bond keys there).
+    gattCacheLoad();
+    Bluefruit.setEventCallback(bleEventCallback);
 
     Bluefruit.Central.setConnectCallback(bleConnectCallback);
     Bluefruit.Central.setDisconnectCallback(bleDisconnectCallback);
@@ -582,6 +1050,8 @@ void initBLE() {
     // 50% scan duty cycle: 100 ms window every 200 ms interval.
     Bluefruit.Scanner.setRxCallback(bleScanCallback);
     Bluefruit.Scanner.restartOnDisconnect(true);  // resume scanning after disconnect
+                                                   // (bleConnectCallback resumes it
+                                                   // after a connect while a link is free)
     Bluefruit.Scanner.setInterval(BLE_SCAN_INTERVAL, BLE_SCAN_WINDOW);
     Bluefruit.Scanner.useActiveScan(true);         // active scan pulls the complete device name
     Bluefruit.Scanner.start(0);                    // 0 = scan indefinitely
@@ -595,3 +1065,83 @@ void initBLE() {
     sendCommissioningNote("commissioning_mode_active", BLE_CONN_HANDLE_INVALID);
 #endif
 }
+
+// ─────────────────────────────────────────────────────────────────────────────
+// MAIN-LOOP LINK MANAGEMENT
+// ─────────────────────────────────────────────────────────────────────────────
+// Each function snapshots what it needs from the session table inside a
+// critical section and calls into the BSP outside it; the entry is marked
+// CLOSING first so a second request on the next loop() pass is not issued
+// while the disconnect callback is still pending.
+
+void bleReleaseDevice(VitalsDevice dev) {
+    uint16_t h = BLE_CONN_HANDLE_INVALID;
+    noInterrupts();
+    for (uint8_t i = 0; i < BLE_CENTRAL_LINKS; ++i) {
+        if (s_links[i].state == LINK_SUBSCRIBED && s_links[i].device == dev) {
+            s_links[i].state = LINK_CLOSING;
+            h = s_links[i].conn_handle;
+            break;
+        }
+    }
+    interrupts();
+    if (h != BLE_CONN_HANDLE_INVALID) Bluefruit.disconnect(h);
+}
+
+void bleServiceLinks() {
+    const uint32_t now = millis();
+
+    // Measurement timeout watchdog: covers hangs inside security negotiation
+    // or discover(), and devices that subscribe but never send.
+    for (uint8_t i = 0; i < BLE_CENTRAL_LINKS; ++i) {
+        uint16_t h = BLE_CONN_HANDLE_INVALID;
+        noInterrupts();
+        CentralLink &link = s_links[i];
+        if ((link.state == LINK_SECURING || link.state == LINK_SUBSCRIBED) &&
+            now - link.start_ms >= MEASUREMENT_TIMEOUT_MS) {
+            link.state = LINK_CLOSING;
+            h = link.conn_handle;
+        }
+        interrupts();
+        if (h != BLE_CONN_HANDLE_INVALID) {
+            DBG_PRINT("[BLE] Measurement timeout — disconnecting idle peripheral conn=0x%04X\n", h);
+            Bluefruit.disconnect(h);
+        }
+    }
+
+    // Connection attempt to a device that stopped advertising: cancel it so
+    // the scanner, stopped by the attempt, can resume.
+    bool expired = false;
+    noInterrupts();
+    if (s_pendingDevice != DEV_NONE && now - s_pendingSinceMs >= BLE_CONNECT_TIMEOUT_MS) {
+        s_pendingDevice = DEV_NONE;
+        expired         = true;
+    }
+    interrupts();
+    if (expired) {
+        DBG_PRINTLN("[BLE] Connection attempt timed out — resuming scan");
+        sd_ble_gap_connect_cancel();
+#if ALLOW_UNENROLLED_DEVICES_FOR_DEV
+        s_commissioningSlotTaken = false;
+#endif
+        if (!Bluefruit.Scanner.isRunning()) Bluefruit.Scanner.start(0);
+    }
+
+    // Persist GATT cache changes once every link has closed: a flash page
+    // erase blocks this task for tens of milliseconds.
+    if (s_gattCache.dirty && s_openLinks == 0 && s_pendingDevice == DEV_NONE) {
+        gattCacheSave();
+    }
+}
+
+bool bleTakeStats(BleLinkStats *out) {
+    noInterrupts();
+    bool any = (s_stats.links > 0);
+    if (any) {
+        *out = s_stats;
+        s_stats = {};
+        s_stats.max_concurrent = s_openLinks;
+    }
+    interrupts();
+    return any;
+}
@@ -1,9 +1,9 @@
 /***************************************************************************
   ble_central.h — BLE Central declarations for post_discharge_vitals_hub.
 
-  Exposes the four buffered reading structs, the shared connection-state
-  globals (extern'd to post_discharge_vitals_hub.ino), and the initBLE()
-  entry point.  Implementation is in ble_central.cpp.
+  Exposes the four buffered reading structs, the device-type and link
+  statistics types, and the entry points the main loop drives the central
+  links through.  Implementation is in ble_central.cpp.
 ***************************************************************************/
 #pragma once
 
@@ -39,6 +39,32 @@ struct ActivityReading {
     volatile bool valid;
 };
 
+// ─── Device types ────────────────────────────────────────────────────────────
+// One per supported Bluetooth SIG service; each has its own GATT client, so at
+// most one device of each type is connected at a time.
+enum VitalsDevice : uint8_t {
+    DEV_WEIGHT,     // Weight Scale Service (0x181D)
+    DEV_BP,         // Blood Pressure Service (0x1810)
+    DEV_SPO2,       // Pulse Oximeter Service (0x1822)
+    DEV_HR,         // Heart Rate Service (0x180D)
+    DEV_TYPE_COUNT,
+    DEV_NONE = 0xFF
+};
+
+// ─── Link statistics ─────────────────────────────────────────────────────────
+// Accumulated by the connection callbacks and drained by bleTakeStats().
+struct BleLinkStats {
+    uint16_t links;             // links opened
+    uint16_t subscribed;        // links that subscribed to a known device type
+    uint16_t cached;            // ... of which from the GATT cache, without discovery
+    uint16_t readings;          // links that delivered at least one measurement
+    uint16_t missed;            // subscribed links that closed without one
+    uint16_t max_concurrent;    // most links open at once
+    uint32_t subscribe_sum_ms;  // connect → CCCD written, summed over `subscribed`
+    uint32_t latency_sum_ms;    // connect → first measurement, summed over `readings`
+    uint32_t latency_max_ms;
+};
+
 // ─── Extern globals (defined in post_discharge_vitals_hub.ino) ───────────────
 extern WeightReading   g_weight;
 extern BpReading       g_bp;
@@ -46,11 +72,20 @@ extern SpO2Reading     g_spo2;
 extern ActivityReading g_activity;
 
 extern float    g_last_weight_kg;
-extern uint16_t g_hrConnHandle;
-extern uint16_t g_oneshot_conn_handle;
-extern uint16_t g_active_conn_handle;
-extern uint32_t g_conn_start_ms;
 extern uint32_t g_last_hr_sample_ms;
 
-// ─── Entry point ─────────────────────────────────────────────────────────────
+// ─── Entry points ────────────────────────────────────────────────────────────
 void initBLE();
+
+// Disconnects the link to the given device type, if one is open.  Called by
+// the main loop once that device's reading has been consumed.
+void bleReleaseDevice(VitalsDevice dev);
+
+// Per-link watchdog: disconnects any link open MEASUREMENT_TIMEOUT_MS without
+// a reading, and cancels a connection attempt pending BLE_CONNECT_TIMEOUT_MS.
+// Call from loop().
+void bleServiceLinks();
+
+// Copies the statistics accumulated since the last call into out and resets
+// them.  Returns false, leaving out untouched, when no link was opened.
+bool bleTakeStats(BleLinkStats *out);
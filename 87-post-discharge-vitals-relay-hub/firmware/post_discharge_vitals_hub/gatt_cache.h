@@ -0,0 +1,177 @@
+/***************************************************************************
+  gatt_cache.h - GATT handle cache for bonded vitals devices
+
+  Remembers, per bonded peripheral, the attribute handles that a full
+  service / characteristic / descriptor discovery found for its measurement
+  characteristic, so a reconnect can write the CCCD at once instead of
+  rediscovering.  Entries are keyed by the peer's bond identity address
+  (addr + addr_type — the resolved identity for Privacy-enabled devices) and
+  serialized into a small CRC-checked image that ble_central.cpp keeps in
+  InternalFS.
+
+  Pure data-structure code with no BSP dependencies, so the host benchmark
+  in sim/ exercises the same table the firmware uses.  All functions are
+  static inline; include this header once (from ble_central.cpp).
+***************************************************************************/
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+// Bonded devices remembered.  The hub serves one patient's kit, so this is
+// the four device types plus replacements; when full, the entry stored
+// longest ago is evicted.
+#ifndef GATT_CACHE_MAX
+#define GATT_CACHE_MAX  8
+#endif
+
+#define GATT_CACHE_MAGIC    0x4347u   // "GC"
+#define GATT_CACHE_VERSION  1
+
+struct GattCacheEntry {
+    uint8_t  addr[6];         // bond identity address, LSB first (as in ble_gap_addr_t)
+    uint8_t  addr_type;
+    uint8_t  device;          // VitalsDevice the peripheral was subscribed as
+    uint16_t svc_start;       // measurement service handle range
+    uint16_t svc_end;
+    uint16_t value_handle;    // measurement characteristic value
+    uint16_t cccd_handle;     // its Client Characteristic Configuration descriptor
+    uint16_t sc_handle;       // Service Changed (0x2A05) value; 0 if the peer has none
+    uint32_t stamp;           // store order, for eviction; 0 = free slot
+};
+
+struct GattCache {
+    GattCacheEntry entry[GATT_CACHE_MAX];
+    uint32_t       next_stamp;
+    bool           dirty;     // changed since the last save
+};
+
+// Serialized size: 4-byte header, 20 bytes per entry, 2-byte CRC.
+#define GATT_CACHE_ENTRY_LEN  20
+#define GATT_CACHE_IMAGE_MAX  (4 + GATT_CACHE_MAX * GATT_CACHE_ENTRY_LEN + 2)
+
+static inline void gattCacheInit(GattCache *c) {
+    memset(c, 0, sizeof(*c));
+    c->next_stamp = 1;
+}
+
+static inline GattCacheEntry *gattCacheFind(GattCache *c, const uint8_t addr[6],
+                                            uint8_t addr_type) {
+    for (uint8_t i = 0; i < GATT_CACHE_MAX; ++i) {
+        GattCacheEntry *e = &c->entry[i];
+        if (e->stamp && e->addr_type == addr_type && memcmp(e->addr, addr, 6) == 0) return e;
+    }
+    return NULL;
+}
+
+// Inserts or replaces the entry for e->addr / e->addr_type.  Leaves the table
+// clean when an identical entry is already cached, so a device that is
+// rediscovered unchanged costs no flash write.
+static inline void gattCacheStore(GattCache *c, const GattCacheEntry *e) {
+    GattCacheEntry *slot = gattCacheFind(c, e->addr, e->addr_type);
+    if (slot) {
+        GattCacheEntry tmp = *e;
+        tmp.stamp = slot->stamp;
+        if (memcmp(&tmp, slot, sizeof(tmp)) == 0) return;
+    } else {
+        for (uint8_t i = 0; i < GATT_CACHE_MAX; ++i) {
+            if (!c->entry[i].stamp) { slot = &c->entry[i]; break; }
+            if (!slot || c->entry[i].stamp < slot->stamp) slot = &c->entry[i];
+        }
+    }
+    *slot       = *e;
+    slot->stamp = c->next_stamp++;
+    c->dirty    = true;
+}
+
+// Drops the entry for a peer whose cached handles proved stale.
+static inline bool gattCacheErase(GattCache *c, const uint8_t addr[6], uint8_t addr_type) {
+    GattCacheEntry *e = gattCacheFind(c, addr, addr_type);
+    if (!e) return false;
+    memset(e, 0, sizeof(*e));
+    c->dirty = true;
+    return true;
+}
+
+// CRC-16/CCITT-FALSE over the serialized image.
+static inline uint16_t gattCacheCrc(const uint8_t *p, uint16_t len) {
+    uint16_t crc = 0xFFFF;
+    while (len--) {
+        crc ^= (uint16_t)(*p++) << 8;
+        for (uint8_t b = 0; b < 8; ++b) {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+static inline void gattCachePut16(uint8_t *p, uint16_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static inline uint16_t gattCacheGet16(const uint8_t *p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+// Serializes the occupied entries, oldest first, little-endian.  Returns the
+// image length (at most GATT_CACHE_IMAGE_MAX).  Stamps are not stored; they
+// are renumbered in order on load.
+static inline uint16_t gattCacheEncode(const GattCache *c, uint8_t *out) {
+    const GattCacheEntry *order[GATT_CACHE_MAX];
+    uint8_t n = 0;
+    for (uint8_t i = 0; i < GATT_CACHE_MAX; ++i) {
+        if (!c->entry[i].stamp) continue;
+        uint8_t j = n++;
+        while (j > 0 && order[j - 1]->stamp > c->entry[i].stamp) {
+            order[j] = order[j - 1];
+            --j;
+        }
+        order[j] = &c->entry[i];
+    }
+
+    gattCachePut16(out, GATT_CACHE_MAGIC);
+    out[2] = GATT_CACHE_VERSION;
+    out[3] = n;
+    uint8_t *p = out + 4;
+    for (uint8_t i = 0; i < n; ++i, p += GATT_CACHE_ENTRY_LEN) {
+        const GattCacheEntry *e = order[i];
+        memcpy(p, e->addr, 6);
+        p[6] = e->addr_type;
+        p[7] = e->device;
+        gattCachePut16(p + 8,  e->svc_start);
+        gattCachePut16(p + 10, e->svc_end);
+        gattCachePut16(p + 12, e->value_handle);
+        gattCachePut16(p + 14, e->cccd_handle);
+        gattCachePut16(p + 16, e->sc_handle);
+        gattCachePut16(p + 18, 0);  // reserved
+    }
+    gattCachePut16(p, gattCacheCrc(out, (uint16_t)(p - out)));
+    return (uint16_t)(p - out + 2);
+}
+
+// Loads an image written by gattCacheEncode().  Returns false, leaving c
+// empty, for a truncated, corrupt or other-version image.
+static inline bool gattCacheDecode(GattCache *c, const uint8_t *in, uint16_t len) {
+    gattCacheInit(c);
+    if (len < 6 || gattCacheGet16(in) != GATT_CACHE_MAGIC || in[2] != GATT_CACHE_VERSION) return false;
+    uint8_t n = in[3];
+    if (n > GATT_CACHE_MAX || len != 4 + n * GATT_CACHE_ENTRY_LEN + 2) return false;
+    if (gattCacheGet16(in + len - 2) != gattCacheCrc(in, (uint16_t)(len - 2))) return false;
+
+    const uint8_t *p = in + 4;
+    for (uint8_t i = 0; i < n; ++i, p += GATT_CACHE_ENTRY_LEN) {
+        GattCacheEntry *e = &c->entry[i];
+        memcpy(e->addr, p, 6);
+        e->addr_type    = p[6];
+        e->device       = p[7];
+        e->svc_start    = gattCacheGet16(p + 8);
+        e->svc_end      = gattCacheGet16(p + 10);
+        e->value_handle = gattCacheGet16(p + 12);
+        e->cccd_handle  = gattCacheGet16(p + 14);
+        e->sc_handle    = gattCacheGet16(p + 16);
+        e->stamp        = c->next_stamp++;
+    }
+    return true;
+}
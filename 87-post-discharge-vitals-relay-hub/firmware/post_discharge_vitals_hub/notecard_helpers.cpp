@@ -177,6 +177,24 @@ void defineTemplates() {
         JAddNumberToObject(body, "heart_rate_bpm", TINT16);
         sendChecked(req);
     }
+    // BLE link statistics: counts since the previous report, mean
+    // connect-to-subscribe time, and connect-to-first-measurement latency
+    // (mean and worst case)
+    {
+        J *req  = notecard.newRequest("note.template");
+        JAddStringToObject(req, "file", "ble_stats.qo");
+        J *body = JAddObjectToObject(req, "body");
+        JAddNumberToObject(body, "links",            TUINT16);
+        JAddNumberToObject(body, "subscribed",       TUINT16);
+        JAddNumberToObject(body, "cached",           TUINT16);
+        JAddNumberToObject(body, "readings",         TUINT16);
+        JAddNumberToObject(body, "missed",           TUINT16);
+        JAddNumberToObject(body, "max_concurrent",   TUINT8);
+        JAddNumberToObject(body, "subscribe_avg_ms", TUINT32);
+        JAddNumberToObject(body, "latency_avg_ms",   TUINT32);
+        JAddNumberToObject(body, "latency_max_ms",   TUINT32);
+        sendChecked(req);
+    }
     // Alert notes are not templated — their body shape varies by alert type
     // and they are low-frequency, so JSON overhead is negligible.
 }
@@ -413,3 +431,31 @@ void submitActivity(uint16_t hr_bpm) {
         sendVitalNoteChecked("activity.qo", mbody, /*addSync=*/false);
     }
 }
+
+// ─────────────────────────────────────────────────────────────────────────────
+// BLE LINK STATISTICS
+// ─────────────────────────────────────────────────────────────────────────────
+// Diagnostic only, so a single unchecked attempt on the normal outbound
+// cadence: a lost report costs one interval of statistics, not a reading.
+// missed / subscribed is the missed-reading rate.
+
+void submitBleStats(const BleLinkStats &st) {
+    J *req = notecard.newRequest("note.add");
+    if (!req) return;
+    JAddStringToObject(req, "file", "ble_stats.qo");
+    J *body = JAddObjectToObject(req, "body");
+    JAddNumberToObject(body, "links",            st.links);
+    JAddNumberToObject(body, "subscribed",       st.subscribed);
+    JAddNumberToObject(body, "cached",           st.cached);
+    JAddNumberToObject(body, "readings",         st.readings);
+    JAddNumberToObject(body, "missed",           st.missed);
+    JAddNumberToObject(body, "max_concurrent",   st.max_concurrent);
+    JAddNumberToObject(body, "subscribe_avg_ms",
+                       st.subscribed ? (double)(st.subscribe_sum_ms / st.subscribed) : 0.0);
+    JAddNumberToObject(body, "latency_avg_ms",
+                       st.readings ? (double)(st.latency_sum_ms / st.readings) : 0.0);
+    JAddNumberToObject(body, "latency_max_ms",   st.latency_max_ms);
+    notecard.sendRequest(req);
+    DBG_PRINT("[BLE] Stats: %u links, %u subscribed (%u cached), %u readings, %u missed, max %u concurrent\n",
+              st.links, st.subscribed, st.cached, st.readings, st.missed, st.max_concurrent);
+}
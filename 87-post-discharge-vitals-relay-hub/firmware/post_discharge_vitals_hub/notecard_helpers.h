@@ -7,6 +7,7 @@
 
 #include <Notecard.h>
 #include "vitals_config.h"
+#include "ble_central.h"     // for BleLinkStats
 
 // ─── Shared Notecard instance (defined in post_discharge_vitals_hub.ino) ──────
 extern Notecard notecard;
@@ -47,3 +48,6 @@ void submitWeight(float kg, float prev_kg);
 void submitBp(int16_t systolic, int16_t diastolic, int16_t pulse);
 void submitSpO2(int16_t spo2_pct, int16_t pulse);
 void submitActivity(uint16_t hr_bpm);
+
+// Enqueue a ble_stats.qo note summarizing the BLE links since the last report.
+void submitBleStats(const BleLinkStats &st);
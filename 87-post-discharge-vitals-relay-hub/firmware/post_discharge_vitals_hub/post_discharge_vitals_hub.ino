@@ -5,7 +5,8 @@
 
   Host MCU : Adafruit Feather nRF52840 Express (on Notecarrier F)
   Cellular : Blues Notecard Cell+WiFi (NOTE-MBGLW)
-  BLE role : Central — scans for and connects to patient-provided devices
+  BLE role : Central — scans for and connects to patient-provided devices,
+             up to one of each type at a time on concurrent links
 
   Supported BLE device types (Bluetooth SIG standard profiles):
     • Weight scale        — Weight Scale Service (0x181D)
@@ -75,14 +76,7 @@ ActivityReading g_activity = {};
 float g_last_weight_kg = 0.0f;
 
 // ─── Connection state ─────────────────────────────────────────────────────────
-// Connection handle for the active Heart Rate Service peripheral.
-uint16_t g_hrConnHandle        = BLE_CONN_HANDLE_INVALID;
-// Connection handle for the currently connected one-shot peripheral (weight/BP/SpO2).
-uint16_t g_oneshot_conn_handle = BLE_CONN_HANDLE_INVALID;
-// Handle and start time of the currently active connection, used by the
-// measurement timeout watchdog in loop().
-uint16_t g_active_conn_handle  = BLE_CONN_HANDLE_INVALID;
-uint32_t g_conn_start_ms       = 0;
+// Per-link connection state lives in the session table in ble_central.cpp.
 
 // Millisecond timestamp of the most recent HR sample, used to gate reconnection
 // in bleScanCallback.  Initialized so the first connection is never suppressed.
@@ -102,6 +96,9 @@ uint32_t g_last_hr_low_alert_ms  = (uint32_t)(-ALERT_COOLDOWN_MS);
 // Millisecond timestamp of the last env-var fetch
 static uint32_t s_last_env_ms = 0;
 
+// Millisecond timestamp of the last link statistics report
+static uint32_t s_last_stats_ms = 0;
+
 // ─────────────────────────────────────────────────────────────────────────────
 // ARDUINO SETUP
 // ─────────────────────────────────────────────────────────────────────────────
@@ -125,6 +122,7 @@ void setup() {
     s_last_env_ms = millis();
 
     initBLE();
+    s_last_stats_ms = millis();
 
     DBG_PRINTLN("[APP] Post-discharge vitals hub running");
     DBG_PRINT("[APP]  Outbound: %d min  |  Inbound: %d min\n",
@@ -140,9 +138,9 @@ void setup() {
 // ─────────────────────────────────────────────────────────────────────────────
 // The nRF52840 SoftDevice processes BLE events asynchronously and populates
 // the reading structs via the callbacks in ble_central.cpp.  The main loop
-// drains any completed readings into Notecard notes, manages the one-shot
-// disconnect and measurement timeout, and periodically refreshes the threshold
-// env vars.
+// drains any completed readings into Notecard notes, releases each link once
+// its reading is consumed, runs the per-link measurement timeout, and
+// periodically refreshes the threshold env vars and reports link statistics.
 //
 // Each copy-and-clear is wrapped in noInterrupts()/interrupts().  On the
 // Adafruit nRF52 BSP these map to the CMSIS __disable_irq()/__enable_irq()
@@ -164,10 +162,8 @@ void loop() {
         DBG_PRINT("[VITALS] Weight %.2f kg (prev %.2f kg)\n", r.kg, r.prev_kg);
         submitWeight(r.kg, r.prev_kg);
         // Weight scale is one-shot: disconnect after the first indication so
-        // the single Central slot is freed for the next device.
-        if (g_oneshot_conn_handle != BLE_CONN_HANDLE_INVALID) {
-            Bluefruit.disconnect(g_oneshot_conn_handle);
-        }
+        // its link is freed for the next device.
+        bleReleaseDevice(DEV_WEIGHT);
     }
 
     // ── Consume a completed blood pressure reading ───────────────────────────
@@ -179,9 +175,7 @@ void loop() {
         DBG_PRINT("[VITALS] BP %d/%d mmHg  pulse %d bpm\n",
                   r.systolic, r.diastolic, r.pulse_bpm);
         submitBp(r.systolic, r.diastolic, r.pulse_bpm);
-        if (g_oneshot_conn_handle != BLE_CONN_HANDLE_INVALID) {
-            Bluefruit.disconnect(g_oneshot_conn_handle);
-        }
+        bleReleaseDevice(DEV_BP);
     }
 
     // ── Consume a completed SpO2 reading ────────────────────────────────────
@@ -192,9 +186,7 @@ void loop() {
         interrupts();
         DBG_PRINT("[VITALS] SpO2 %d%%  pulse %d bpm\n", r.spo2_pct, r.pulse_bpm);
         submitSpO2(r.spo2_pct, r.pulse_bpm);
-        if (g_oneshot_conn_handle != BLE_CONN_HANDLE_INVALID) {
-            Bluefruit.disconnect(g_oneshot_conn_handle);
-        }
+        bleReleaseDevice(DEV_SPO2);
     }
 
     // ── Consume a completed heart rate reading ───────────────────────────────
@@ -207,27 +199,17 @@ void loop() {
         g_activity.valid  = false;
         interrupts();
         g_last_hr_sample_ms = millis();
-        if (g_hrConnHandle != BLE_CONN_HANDLE_INVALID) {
-            Bluefruit.disconnect(g_hrConnHandle);
-        }
+        bleReleaseDevice(DEV_HR);
         DBG_PRINT("[VITALS] Heart rate %d bpm\n", r.heart_rate_bpm);
         submitActivity(r.heart_rate_bpm);
     }
 
     // ── Measurement timeout watchdog ────────────────────────────────────────
-    // Disconnect any peripheral that has been connected for
-    // MEASUREMENT_TIMEOUT_MS without delivering a reading.  Covers hangs
-    // inside discover() and one-shot devices that subscribe but never send.
-    // Pre-clear g_active_conn_handle before calling disconnect to prevent a
-    // second timeout-triggered disconnect on the next iteration while
-    // bleDisconnectCallback is still pending.
-    if (g_active_conn_handle != BLE_CONN_HANDLE_INVALID &&
-        (millis() - g_conn_start_ms >= MEASUREMENT_TIMEOUT_MS)) {
-        DBG_PRINTLN("[BLE] Measurement timeout — disconnecting idle peripheral");
-        uint16_t h = g_active_conn_handle;
-        g_active_conn_handle = BLE_CONN_HANDLE_INVALID;
-        Bluefruit.disconnect(h);
-    }
+    // Disconnect any link that has been open for MEASUREMENT_TIMEOUT_MS
+    // without being released, and cancel a connection attempt to a device
+    // that stopped advertising.  Each link is timed separately, so a hung
+    // link does not hold up readings arriving on the others.
+    bleServiceLinks();
 
     // ── Periodic env-var refresh (every ENV_POLL_MS, default 2 minutes) ───────
     // env.get is resolved locally by the Notecard — no cellular round-trip.
@@ -239,6 +221,16 @@ void loop() {
         s_last_env_ms = millis();
     }
 
+    // ── Periodic link statistics (every BLE_STATS_INTERVAL_MS) ───────────────
+    // Connect-to-first-measurement latency and missed readings, for tuning
+    // the scan and timeout settings in the field.  Skipped for an interval
+    // with no connections.
+    if (millis() - s_last_stats_ms >= BLE_STATS_INTERVAL_MS) {
+        BleLinkStats st;
+        if (bleTakeStats(&st)) submitBleStats(st);
+        s_last_stats_ms = millis();
+    }
+
     // Yield to the SoftDevice BLE stack.  The 100 ms delay keeps the main loop
     // from spinning and starving the radio task; BLE events continue to arrive
     // via callbacks during this delay.
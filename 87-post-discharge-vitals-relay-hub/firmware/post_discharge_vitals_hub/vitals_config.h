@@ -148,6 +148,23 @@ static const EnrolledDevice ENROLLED_DEVICES[ENROLLED_DEVICE_COUNT] = {
 #define BLE_SCAN_INTERVAL  320   // 200 ms
 #define BLE_SCAN_WINDOW    160   // 100 ms
 
+// ─── Concurrent central links ─────────────────────────────────────────────────
+// One link per supported device type, so a patient who steps on the scale while
+// the BP cuff is still transmitting is served on a second link instead of
+// waiting for the first to close.  Two devices of the same type are never
+// connected at once — each type has one GATT client.
+#define BLE_CENTRAL_LINKS  4
+
+// How long a connection attempt to an advertiser may stay pending before it is
+// cancelled and scanning resumes.  Health devices stop advertising within a
+// few seconds of a measurement, so a longer wait only holds the scanner off.
+#define BLE_CONNECT_TIMEOUT_MS  (3UL * 1000UL)   // 3 seconds
+
+// How often the link statistics (connect-to-first-measurement latency, missed
+// readings) are queued to ble_stats.qo.  Nothing is queued for an interval with
+// no connections.
+#define BLE_STATS_INTERVAL_MS  (60UL * 60UL * 1000UL)   // 1 hour
+
 // ─── HR device reconnect suppression ─────────────────────────────────────────
 // Heart Rate Service devices (e.g. Polar H10) stream notifications continuously
 // while worn; disconnect after the first sample and suppress reconnection for
@@ -166,6 +183,7 @@ static const EnrolledDevice ENROLLED_DEVICES[ENROLLED_DEVICE_COUNT] = {
 // ─── Connection watchdog ──────────────────────────────────────────────────────
 // Maximum time a peripheral may remain connected without delivering a reading.
 // Covers hangs inside discover() and devices that subscribe but never send.
+// Applied to each link separately.
 #define MEASUREMENT_TIMEOUT_MS  (30UL * 1000UL)   // 30 seconds
 
 // ─── Alert note retry ────────────────────────────────────────────────────────
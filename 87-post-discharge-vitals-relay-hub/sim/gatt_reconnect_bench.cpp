@@ -0,0 +1,340 @@
+// gatt_reconnect_bench.cpp — host benchmark for the GATT handle cache.
+//
+// Models the ATT traffic between the hub and each of the four device types,
+// from bond re-encryption to a written CCCD, for the two reconnect paths in
+// ble_central.cpp:
+//   before — full discovery on every connection: primary service by UUID,
+//            characteristic discovery until the measurement characteristic
+//            turns up, descriptor discovery for its CCCD, CCCD write
+//   after  — a cache hit: the CCCD write alone
+// and reports reconnect-to-subscribe time at several connection intervals.
+// Each device's attribute table follows the SIG service layout, behind the
+// GAP, GATT, Device Information and Battery services a typical device has.
+//
+// It then replays a month of reconnects through the firmware's GattCache
+// (gatt_cache.h) — including a device whose firmware update moves its
+// handles, caught by its Service Changed indication — and checks the cache
+// image survives a save/load round trip and rejects a corrupt one.  Exits 1
+// if any check fails.
+//
+// Build and run from this directory:
+//   g++ -O2 -std=c++11 -I../firmware/post_discharge_vitals_hub gatt_reconnect_bench.cpp -o gatt_reconnect_bench
+//   ./gatt_reconnect_bench
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "gatt_cache.h"
+
+// ─── Link timing ─────────────────────────────────────────────────────────────
+// The SoftDevice sends a request in one connection event and the peer's
+// response comes back in the next; the BSP wakes the waiting task and queues
+// the following request for the event after that.  Bond re-encryption
+// (LL_ENC_REQ/RSP, LL_START_ENC_REQ/RSP) takes three events.
+static const unsigned EVENTS_PER_ATT_REQUEST = 2;
+static const unsigned EVENTS_ENCRYPTION      = 3;
+
+// Default ATT_MTU 23: Read By Type returns up to 3 16-bit-UUID characteristic
+// declarations (7 bytes each), Find Information up to 5 descriptors.
+static const unsigned CHARS_PER_READ_BY_TYPE = 3;
+
+static const double CONN_INTERVALS_MS[] = { 7.5, 15.0, 30.0, 50.0 };
+static const unsigned N_INTERVALS = sizeof(CONN_INTERVALS_MS) / sizeof(CONN_INTERVALS_MS[0]);
+
+// ─── Attribute tables ────────────────────────────────────────────────────────
+
+struct CharDef {
+    uint16_t uuid;
+    bool     cccd;   // has a Client Characteristic Configuration descriptor
+};
+
+struct SvcDef {
+    uint16_t uuid;
+    CharDef  chr[5];
+    unsigned n;
+};
+
+struct CharLayout {
+    uint16_t uuid, decl, value, cccd;
+};
+
+struct SvcLayout {
+    uint16_t   uuid, start, end;
+    CharLayout chr[5];
+    unsigned   n;
+};
+
+struct Gatt {
+    SvcLayout svc[8];
+    unsigned  n;
+};
+
+static const SvcDef SVC_GAP     = { 0x1800, { { 0x2A00, false }, { 0x2A01, false }, { 0x2A04, false } }, 3 };
+static const SvcDef SVC_GATT    = { 0x1801, { { 0x2A05, true } }, 1 };
+static const SvcDef SVC_DIS     = { 0x180A, { { 0x2A29, false }, { 0x2A24, false }, { 0x2A25, false },
+                                              { 0x2A26, false } }, 4 };
+static const SvcDef SVC_BATTERY = { 0x180F, { { 0x2A19, true } }, 1 };
+
+struct Device {
+    const char *name;
+    uint8_t     type;        // VitalsDevice
+    uint16_t    svc_uuid;
+    uint16_t    chr_uuid;    // measurement characteristic
+    SvcDef      target;
+};
+
+static const Device DEVICES[] = {
+    { "Weight scale", 0, 0x181D, 0x2A9D,
+      { 0x181D, { { 0x2A9E, false }, { 0x2A9D, true } }, 2 } },
+    { "BP cuff",      1, 0x1810, 0x2A35,
+      { 0x1810, { { 0x2A35, true }, { 0x2A36, true }, { 0x2A49, false } }, 3 } },
+    { "Pulse oximeter", 2, 0x1822, 0x2A5E,
+      { 0x1822, { { 0x2A60, false }, { 0x2A52, true }, { 0x2A5F, true }, { 0x2A5E, true } }, 4 } },
+    { "HR band",      3, 0x180D, 0x2A37,
+      { 0x180D, { { 0x2A37, true }, { 0x2A38, false }, { 0x2A39, false } }, 3 } },
+};
+static const unsigned N_DEVICES = sizeof(DEVICES) / sizeof(DEVICES[0]);
+
+static void addService(Gatt &g, uint16_t &h, const SvcDef &d) {
+    SvcLayout &s = g.svc[g.n++];
+    s.uuid  = d.uuid;
+    s.start = h++;
+    s.n     = d.n;
+    for (unsigned i = 0; i < d.n; ++i) {
+        CharLayout &c = s.chr[i];
+        c.uuid  = d.chr[i].uuid;
+        c.decl  = h++;
+        c.value = h++;
+        c.cccd  = d.chr[i].cccd ? h++ : 0;
+    }
+    s.end = h - 1;
+}
+
+// `extraDis` lengthens the Device Information Service, moving every handle
+// after it — what a peripheral firmware update typically does.
+static Gatt buildGatt(const Device &dev, unsigned extraDis) {
+    Gatt g = {};
+    uint16_t h = 1;
+    SvcDef dis = SVC_DIS;
+    for (unsigned i = 0; i < extraDis && dis.n < 5; ++i) dis.chr[dis.n++] = { 0x2A28, false };
+    addService(g, h, SVC_GAP);
+    addService(g, h, SVC_GATT);
+    addService(g, h, dis);
+    addService(g, h, SVC_BATTERY);
+    addService(g, h, dev.target);
+    return g;
+}
+
+static const SvcLayout *findService(const Gatt &g, uint16_t uuid) {
+    for (unsigned i = 0; i < g.n; ++i) {
+        if (g.svc[i].uuid == uuid) return &g.svc[i];
+    }
+    return NULL;
+}
+
+// ─── Client procedures, counted in ATT requests ──────────────────────────────
+
+struct Discovered {
+    uint16_t svc_start, svc_end, value, cccd, sc_value;
+};
+
+// BLEClientService::discover → one Find By Type Value request.
+static unsigned discoverService(const Gatt &g, uint16_t uuid, const SvcLayout **out) {
+    *out = findService(g, uuid);
+    return 1;
+}
+
+// BLEClientCharacteristic::discover → Read By Type over the service range,
+// continued until the characteristic is found or the range runs out, then
+// one Find Information request for its descriptors.
+static unsigned discoverChar(const SvcLayout &s, uint16_t uuid, const CharLayout **out) {
+    unsigned requests = 0;
+    *out = NULL;
+    for (unsigned i = 0; i < s.n; i += CHARS_PER_READ_BY_TYPE) {
+        ++requests;
+        for (unsigned j = i; j < s.n && j < i + CHARS_PER_READ_BY_TYPE; ++j) {
+            if (s.chr[j].uuid == uuid) *out = &s.chr[j];
+        }
+        if (*out) break;
+    }
+    // Found: one descriptor discovery follows.  Not found: one more Read By
+    // Type is answered with Attribute Not Found.  Either way, one request.
+    return requests + 1;
+}
+
+// Full discovery as the firmware runs it; returns the ATT requests up to the
+// CCCD write response, and (separately) the Service Changed subscription
+// that follows it.
+static unsigned fullDiscovery(const Gatt &g, const Device &dev, Discovered *d,
+                              unsigned *scRequests) {
+    const SvcLayout *s;
+    unsigned requests = discoverService(g, dev.svc_uuid, &s);
+    const CharLayout *c;
+    requests += discoverChar(*s, dev.chr_uuid, &c);
+    requests += 1;  // CCCD write
+    d->svc_start = s->start;
+    d->svc_end   = s->end;
+    d->value     = c->value;
+    d->cccd      = c->cccd;
+
+    const SvcLayout *gs;
+    *scRequests = discoverService(g, 0x1801, &gs);
+    const CharLayout *sc;
+    *scRequests += discoverChar(*gs, 0x2A05, &sc) + 1;
+    d->sc_value = sc->value;
+    return requests;
+}
+
+static double msFor(unsigned requests, double ci) {
+    return (EVENTS_ENCRYPTION + requests * EVENTS_PER_ATT_REQUEST) * ci;
+}
+
+// ─── Checks ──────────────────────────────────────────────────────────────────
+
+static int failures = 0;
+
+static void check(bool ok, const char *what) {
+    if (!ok) {
+        printf("FAIL: %s\n", what);
+        ++failures;
+    }
+}
+
+static GattCacheEntry entryFor(const Device &dev, uint8_t addrLsb, const Discovered &d) {
+    GattCacheEntry e = {};
+    const uint8_t addr[6] = { addrLsb, 0x22, 0x33, 0x44, 0x55, 0xC6 };
+    memcpy(e.addr, addr, 6);
+    e.addr_type    = 1;   // static random
+    e.device       = dev.type;
+    e.svc_start    = d.svc_start;
+    e.svc_end      = d.svc_end;
+    e.value_handle = d.value;
+    e.cccd_handle  = d.cccd;
+    e.sc_handle    = d.sc_value;
+    return e;
+}
+
+int main() {
+    // ── Per-device reconnect-to-subscribe time ──────────────────────────────
+    printf("Reconnect to subscribed (bond re-encryption + ATT requests up to the CCCD write response)\n\n");
+    printf("%-15s %9s %9s", "device", "before", "after");
+    for (unsigned i = 0; i < N_INTERVALS; ++i) printf("   CI %4.1f ms  ", CONN_INTERVALS_MS[i]);
+    printf("\n%-15s %9s %9s", "", "requests", "requests");
+    for (unsigned i = 0; i < N_INTERVALS; ++i) printf("  before  after ");
+    printf("\n");
+
+    double sumBefore = 0, sumAfter = 0;
+    for (unsigned k = 0; k < N_DEVICES; ++k) {
+        const Device &dev = DEVICES[k];
+        Gatt g = buildGatt(dev, 0);
+        Discovered d;
+        unsigned sc;
+        unsigned before = fullDiscovery(g, dev, &d, &sc);
+        unsigned after  = 1;
+        check(d.cccd == d.value + 1, "CCCD follows the measurement value");
+        printf("%-15s %9u %9u", dev.name, before, after);
+        for (unsigned i = 0; i < N_INTERVALS; ++i) {
+            printf("  %6.0f %6.0f ", msFor(before, CONN_INTERVALS_MS[i]), msFor(after, CONN_INTERVALS_MS[i]));
+        }
+        printf("\n");
+        sumBefore += msFor(before, 30.0);
+        sumAfter  += msFor(after, 30.0);
+    }
+    printf("\nAt a 30 ms interval: %.0f ms -> %.0f ms mean (%.1fx faster).\n",
+           sumBefore / N_DEVICES, sumAfter / N_DEVICES, sumBefore / sumAfter);
+    printf("A first connection also subscribes to Service Changed after the CCCD write (4 requests).\n\n");
+
+    // ── A month of reconnects through the firmware cache ────────────────────
+    // Each device reconnects several times a day.  On day 12 the pulse
+    // oximeter's firmware is updated: its handles move and it indicates
+    // Service Changed on the next reconnect.
+    GattCache cache;
+    gattCacheInit(&cache);
+    unsigned extra[N_DEVICES] = {};
+    unsigned connects = 0, hits = 0, misses = 0, stale = 0, saves = 0;
+    unsigned long requests = 0, requestsNoCache = 0;
+    static const unsigned PER_DAY[N_DEVICES] = { 1, 2, 2, 24 };
+
+    for (unsigned day = 0; day < 30; ++day) {
+        if (day == 12) extra[2] = 1;
+        for (unsigned k = 0; k < N_DEVICES; ++k) {
+            const Device &dev = DEVICES[k];
+            for (unsigned r = 0; r < PER_DAY[k]; ++r) {
+                ++connects;
+                Gatt g = buildGatt(dev, extra[k]);
+                Discovered d;
+                unsigned sc;
+                unsigned full = fullDiscovery(g, dev, &d, &sc);
+                requestsNoCache += full;
+
+                GattCacheEntry want = entryFor(dev, (uint8_t)k, d);
+                GattCacheEntry *e = gattCacheFind(&cache, want.addr, want.addr_type);
+                bool changed = e && (e->cccd_handle != d.cccd || e->value_handle != d.value);
+                if (e && !changed) {
+                    ++hits;
+                    requests += 1;
+                    continue;
+                }
+                if (e) {
+                    // Service Changed arrives right after the CCCD write to
+                    // the stale handle: the entry is dropped and the link
+                    // rediscovered.
+                    ++stale;
+                    requests += 1;
+                    check(gattCacheErase(&cache, want.addr, want.addr_type), "stale entry erased");
+                }
+                ++misses;
+                requests += full;
+                gattCacheStore(&cache, &want);
+                if (cache.dirty) {
+                    uint8_t img[GATT_CACHE_IMAGE_MAX];
+                    uint16_t len = gattCacheEncode(&cache, img);
+                    GattCache loaded;
+                    check(gattCacheDecode(&loaded, img, len), "saved image loads");
+                    cache.dirty = false;
+                    ++saves;
+                }
+            }
+        }
+    }
+    printf("30 days, %u reconnects: %u cache hits, %u full discoveries (%u after Service Changed), %u cache saves\n",
+           connects, hits, misses, stale, saves);
+    printf("ATT requests to subscribe: %lu without the cache, %lu with it\n\n",
+           requestsNoCache, requests);
+    check(misses == N_DEVICES + 1 && stale == 1, "one discovery per device plus one after the update");
+
+    // ── Image round trip, corruption and eviction ───────────────────────────
+    uint8_t img[GATT_CACHE_IMAGE_MAX];
+    uint16_t len = gattCacheEncode(&cache, img);
+    GattCache loaded;
+    check(gattCacheDecode(&loaded, img, len), "image decodes");
+    for (unsigned k = 0; k < N_DEVICES; ++k) {
+        const uint8_t addr[6] = { (uint8_t)k, 0x22, 0x33, 0x44, 0x55, 0xC6 };
+        GattCacheEntry *a = gattCacheFind(&cache, addr, 1);
+        GattCacheEntry *b = gattCacheFind(&loaded, addr, 1);
+        check(a && b && a->cccd_handle == b->cccd_handle && a->sc_handle == b->sc_handle &&
+              a->device == b->device, "entry survives the round trip");
+    }
+    img[10] ^= 0x01;
+    check(!gattCacheDecode(&loaded, img, len), "corrupt image rejected");
+    check(!gattCacheDecode(&loaded, img, 3), "truncated image rejected");
+
+    gattCacheInit(&cache);
+    Discovered d = { 30, 40, 33, 34, 10 };
+    for (unsigned i = 0; i < GATT_CACHE_MAX + 2; ++i) {
+        GattCacheEntry e = entryFor(DEVICES[0], (uint8_t)(0x80 + i), d);
+        gattCacheStore(&cache, &e);
+    }
+    const uint8_t oldest[6] = { 0x80, 0x22, 0x33, 0x44, 0x55, 0xC6 };
+    const uint8_t newest[6] = { (uint8_t)(0x80 + GATT_CACHE_MAX + 1), 0x22, 0x33, 0x44, 0x55, 0xC6 };
+    check(!gattCacheFind(&cache, oldest, 1), "oldest entry evicted when full");
+    check(gattCacheFind(&cache, newest, 1) != NULL, "newest entry kept");
+
+    if (failures) {
+        printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("All checks passed.\n");
+    return 0;
+}
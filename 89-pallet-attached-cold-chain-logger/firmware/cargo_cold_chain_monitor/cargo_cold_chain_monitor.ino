@@ -32,13 +32,14 @@
       discarded; fixed-window boundaries are never stretched by a failed send.
     - Appends one compact-templated cargo_log.qo entry per sample cycle for
       a tamper-evident per-sample log.  Each entry carries a monotonic
-      sequence number (seq), a rolling integrity chain hash (chain_crc)
-      computed over all sensor readings, and a boot_seg counter that
-      increments on every cold boot.  seq and chain_crc reset at the start
-      of each boot_seg; downstream systems replay the chain within each
-      boot_seg from seq=1 (seed=0) to detect insertions, deletions, or
-      modifications.  Entries are queued for the regular outbound window
-      (no extra satellite session per sample).
+      sequence number (seq), a 32-bit tag (chain_tag) from a keyed
+      HMAC-SHA256 chain over every logged field, and a boot_seg counter
+      that increments on every cold boot.  seq and the chain reset at the
+      start of each boot_seg; each summary carries the full chain digest as
+      a checkpoint, and tools/chain_verify replays the chain within each
+      boot_seg to detect insertions, deletions, or modifications.  Entries
+      are queued for the regular outbound window (no extra satellite
+      session per sample).
     - Runs a shipment-state model (UNKNOWN → DWELL / IN_TRANSIT / HANDLING)
       derived from consecutive motion counts and interior light level.
       Emits cargo_state.qo (sync:true) on every state transition.  During
@@ -160,13 +161,13 @@ void setup() {
         gState.lux_max  = 0.0f;
         gState.config_version = CONFIG_VERSION;
         gState.shipment_state = SHIP_STATE_UNKNOWN;
-        gState.seq            = 0;
-        gState.chain_crc      = 0;
+        gState.seq            = 0;   // chain_digest is zeroed by the memset
         // Increment and persist the boot-segment counter in Notecard local flash
         // (chain_boot.dbx) so every uncontrolled cold boot produces a distinct,
         // traceable chain-segment boundary in cargo_log.qo.  Must run after
         // notecard.begin() and before the first sendLogEntry().
         loadOrIncrementBootSeg();
+        chainKeyInit();
         notecardConfigure();
         defineTemplates();
     }
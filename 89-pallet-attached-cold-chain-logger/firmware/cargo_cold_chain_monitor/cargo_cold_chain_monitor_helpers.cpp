@@ -277,7 +277,9 @@ void defineTemplates() {
     // ── cargo_data.qo — compact hourly summary ───────────────────────────────
     // "compact" strips location metadata and reduces the on-wire record from
     // ~200 bytes (free JSON) to ~50 bytes.  _time is included so each summary
-    // carries its own audit timestamp.
+    // carries its own audit timestamp.  chain_seg / chain_seq / chain_digest
+    // are the full cargo_log.qo chain digest after the window's last log
+    // entry — the checkpoint a verifier compares its replay against.
     //
     // Field type codes from note-c (<Notecard.h>):
     //   TUINT32  = 24   — 4-byte unsigned integer (epoch, motion count)
@@ -299,6 +301,11 @@ void defineTemplates() {
     JAddNumberToObject(body, "motion_total", TUINT32);
     JAddNumberToObject(body, "motion_valid", TUINT16);
     JAddNumberToObject(body, "samples",      TUINT16);
+    JAddNumberToObject(body, "chain_seg",    TUINT16);
+    JAddNumberToObject(body, "chain_seq",    TUINT32);
+    // 64-char sample → field width 64, one hex digit per nibble of the digest
+    JAddStringToObject(body, "chain_digest",
+                       "________________________________________________________________");
     if (!ncSend(req)) {
         Serial.println("[cargo] cargo_data.qo template failed — will retry on next wake");
         allOk = false;
@@ -307,8 +314,9 @@ void defineTemplates() {
     // ── cargo_log.qo — compact per-sample tamper-evident log ─────────────────
     // One record per sample cycle.  Not synced immediately — entries batch with
     // the regular outbound window (port 51) so no extra satellite session is
-    // consumed per sample.  The chain_crc field lets downstream systems verify
-    // that no records have been inserted, deleted, or modified.
+    // consumed per sample.  The chain_tag field lets downstream systems verify
+    // that no records have been inserted, deleted, or modified; it costs the
+    // same 4 bytes as the CRC it replaced.
     //
     // _time is always written: the valid epoch when available, or 0 as a
     // documented pre-sync sentinel.  Writing 0 (rather than omitting the field)
@@ -335,7 +343,7 @@ void defineTemplates() {
     JAddNumberToObject(body, "motion_valid", TUINT16);   // 1 = card.motion available; 0 = data unavailable
     JAddNumberToObject(body, "state",        TUINT16);   // shipment state (SHIP_STATE_*)
     JAddNumberToObject(body, "boot_seg",     TUINT16);   // boot-segment counter
-    JAddNumberToObject(body, "chain_crc",    TUINT32);   // rolling integrity hash
+    JAddNumberToObject(body, "chain_tag",    TUINT32);   // first 4 bytes of the chain digest
     if (!ncSend(req)) {
         Serial.println("[cargo] cargo_log.qo template failed — will retry on next wake");
         allOk = false;
@@ -747,6 +755,9 @@ void snapshotSummary(uint32_t epoch) {
     gState.pending_motion    = (gState.motion_n > 0)
         ? gState.motion_total : MOTION_INVALID;
     gState.pending_samples   = gState.summary_n;
+    gState.pending_chain_seg = gState.boot_seg;
+    gState.pending_chain_seq = gState.seq;
+    memcpy(gState.pending_chain_digest, gState.chain_digest, CHAIN_DIGEST_LEN);
 }
 
 bool sendPendingSummary() {
@@ -769,6 +780,13 @@ bool sendPendingSummary() {
         JAddNumberToObject(body, "motion_valid", (double)motionValid);
     }
     JAddNumberToObject(body, "samples",      (double)gState.pending_samples);
+    JAddNumberToObject(body, "chain_seg",    (double)gState.pending_chain_seg);
+    JAddNumberToObject(body, "chain_seq",    (double)gState.pending_chain_seq);
+    {
+        char digestHex[2 * CHAIN_DIGEST_LEN + 1];
+        chainDigestHex(gState.pending_chain_digest, digestHex);
+        JAddStringToObject(body, "chain_digest", digestHex);
+    }
 
     bool ok = ncSend(req);
     if (ok) {
@@ -805,33 +823,32 @@ uint32_t currentEpoch() {
 // Tamper-evident per-sample log
 // ===========================================================================
 
-// chainUpdate: djb2-rotate-based hash chain.  Each call mixes the previous
-// hash with the current sample's raw field values to produce a new hash.
-// Float fields are mixed as their IEEE-754 bit patterns so INVALID_F is
-// hashed consistently regardless of sensor availability.  Downstream
-// consumers replay this chain from seq=1 (seed=0) to detect any insertion,
-// deletion, or modification in the remote log.
-static uint32_t chainUpdate(uint32_t prev, uint32_t seq, uint16_t boot_seg,
-                             float temp_c, float rh_pct, float lux,
-                             uint32_t motion, uint8_t state) {
-    #define ROTMIX(h, v) ((h) = (((h) << 5) | ((h) >> 27)) ^ (v))
-    uint32_t h = prev ^ 0x5A827999UL;
-    ROTMIX(h, seq);
-    ROTMIX(h, (uint32_t)boot_seg);
-    uint32_t bits;
-    memcpy(&bits, &temp_c, sizeof(bits)); ROTMIX(h, bits);
-    memcpy(&bits, &rh_pct, sizeof(bits)); ROTMIX(h, bits);
-    memcpy(&bits, &lux,    sizeof(bits)); ROTMIX(h, bits);
-    ROTMIX(h, motion);
-    ROTMIX(h, (uint32_t)state);
-    #undef ROTMIX
-    return h;
+// chainKeyInit: derive the per-device chain key from CHAIN_MASTER_KEY and the
+// Notecard's device UID (hub.get).  Called on cold boot and again before each
+// log entry until it succeeds; the key is then kept in the sleep payload, so
+// warm boots never repeat the request.
+bool chainKeyInit() {
+    if (gState.chain_key_ready) return true;
+    J *rsp = ncQuery(notecard.newRequest("hub.get"));
+    if (!rsp) return false;
+    const char *device = JGetString(rsp, "device");
+    if (device[0]) {
+        chainKeyDerive(gState.chain_key, CHAIN_MASTER_KEY, device);
+        gState.chain_key_ready = true;
+    }
+    notecard.deleteResponse(rsp);
+    return gState.chain_key_ready;
 }
 
 // sendLogEntry: append one per-sample record to cargo_log.qo.
-// seq and chain_crc are advanced before the note.add so the chain represents
-// the physical event sequence.  A failed note.add burns the seq number —
-// the resulting gap in Notehub is itself evidence of a dropped transmission.
+// seq and chain_digest are advanced before the note.add so the chain
+// represents the physical event sequence.  A failed note.add burns the seq
+// number — the resulting gap in Notehub is itself evidence of a dropped
+// transmission, and the verifier resumes at the next summary checkpoint.
+//
+// Without a chain key (the Notecard has not answered hub.get since the cold
+// boot) no entry is written and seq does not advance: the Notecard is
+// unreachable, so the note.add could not succeed either.
 //
 // _time is ALWAYS written.  When a valid epoch is available (now > 0) the
 // real timestamp is used.  When the Notecard has not yet obtained time from
@@ -844,14 +861,27 @@ static uint32_t chainUpdate(uint32_t prev, uint32_t seq, uint16_t boot_seg,
 // motionOk controls the motion_valid flag.  When motionOk is false the motion
 // field is written as 0, but motion_valid is set to 0 so downstream consumers
 // can distinguish "card.motion unavailable" from "no motion occurred" (which
-// would be motion=0, motion_valid=1).  The chain hash uses the raw motion value
-// (0 when unavailable) in both cases so replay is straightforward from the
-// stored fields.
+// would be motion=0, motion_valid=1).  The chain hash uses the motion value
+// as logged (0 when unavailable) and motion_valid itself, so replay is
+// straightforward from the stored fields.
 bool sendLogEntry(uint32_t now, float temp_c, float rh_pct,
                   float lux, uint32_t motion, bool motionOk, uint8_t state) {
+    if (!chainKeyInit()) {
+        Serial.println("[cargo] chain key unavailable — log entry skipped");
+        return false;
+    }
     gState.seq++;
-    gState.chain_crc = chainUpdate(gState.chain_crc, gState.seq, gState.boot_seg,
-                                   temp_c, rh_pct, lux, motion, state);
+    ChainEntry entry;
+    entry.seq          = gState.seq;
+    entry.boot_seg     = gState.boot_seg;
+    entry.time         = now;
+    entry.temp_c       = temp_c;
+    entry.rh_pct       = rh_pct;
+    entry.lux          = lux;
+    entry.motion       = motionOk ? motion : 0U;
+    entry.motion_valid = motionOk ? 1 : 0;
+    entry.state        = state;
+    chainAdvance(gState.chain_key, gState.chain_digest, entry);
 
     J *req = notecard.newRequest("note.add");
     JAddStringToObject(req, "file", NOTE_LOG);
@@ -867,11 +897,11 @@ bool sendLogEntry(uint32_t now, float temp_c, float rh_pct,
     JAddNumberToObject(body, "temp_c",       (double)temp_c);
     JAddNumberToObject(body, "rh_pct",       (double)rh_pct);
     JAddNumberToObject(body, "lux",          (double)lux);
-    JAddNumberToObject(body, "motion",       (double)(motionOk ? motion : 0U));
-    JAddNumberToObject(body, "motion_valid", (double)(motionOk ? 1U : 0U));
+    JAddNumberToObject(body, "motion",       (double)entry.motion);
+    JAddNumberToObject(body, "motion_valid", (double)entry.motion_valid);
     JAddNumberToObject(body, "state",        (double)state);
     JAddNumberToObject(body, "boot_seg",     (double)gState.boot_seg);
-    JAddNumberToObject(body, "chain_crc",    (double)gState.chain_crc);
+    JAddNumberToObject(body, "chain_tag",    (double)chainTag(gState.chain_digest));
 
     bool ok = ncSend(req);
     if (!ok) {
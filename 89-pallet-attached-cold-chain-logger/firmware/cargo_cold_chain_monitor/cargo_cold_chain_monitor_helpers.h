@@ -16,6 +16,7 @@
 #include <Adafruit_MAX31865.h>
 #include <Adafruit_SHT4x.h>
 #include <Adafruit_VEML7700.h>
+#include "chain_hash.h"
 
 // ---------------------------------------------------------------------------
 // Product UID — set this to your Notehub project's ProductUID
@@ -25,6 +26,17 @@
 #pragma message "PRODUCT_UID is not defined. Set it before flashing."
 #endif
 
+// ---------------------------------------------------------------------------
+// Log chain master key — the secret the per-device chain key is derived from
+// (see chain_hash.h).  Keep it out of source control and share it only with
+// the verifier (tools/chain_verify).  Left empty, the chain still detects
+// corruption but anyone can recompute it.
+// ---------------------------------------------------------------------------
+#ifndef CHAIN_MASTER_KEY
+#define CHAIN_MASTER_KEY ""
+#pragma message "CHAIN_MASTER_KEY is not defined. cargo_log.qo chain will be unkeyed."
+#endif
+
 // ---------------------------------------------------------------------------
 // Timing
 // ---------------------------------------------------------------------------
@@ -69,11 +81,14 @@
 // Encoding: OUTBOUND * 100 000 + INBOUND * 100 + SCHEMA_VERSION.
 //
 // Schema history:
+//   6 — cargo_log.qo chain_crc (TUINT32) replaced by chain_tag (TUINT32), the
+//         truncated HMAC-SHA256 chain digest; cargo_data.qo gains the chain
+//         checkpoint fields chain_seg, chain_seq and chain_digest.
 //   5 — added motion_valid (TUINT16) to cargo_log.qo template so unavailable
 //         card.motion is distinguishable from genuine zero motion.
 //   4 — added boot_seg (TUINT16) to cargo_log.qo template.
 // ---------------------------------------------------------------------------
-#define SCHEMA_VERSION   5U
+#define SCHEMA_VERSION   6U
 #define CONFIG_VERSION   ((uint32_t)(OUTBOUND_INTERVAL_MIN) * 100000UL + \
                           (uint32_t)(INBOUND_INTERVAL_MIN)  * 100UL    + \
                           (uint32_t)(SCHEMA_VERSION))
@@ -134,11 +149,11 @@
 
 // ---------------------------------------------------------------------------
 // Persistent state — serialized to Notecard flash across sleep cycles.
-// Segment ID "COL5" — bump this string whenever the struct layout changes
+// Segment ID "COL7" — bump this string whenever the struct layout changes
 // so old payloads force a clean cold-boot re-initialization rather than
 // being deserialized into a mismatched struct.
 // ---------------------------------------------------------------------------
-#define STATE_SEG  "COL6"
+#define STATE_SEG  "COL7"
 
 struct ColdChainState {
     // ── Live rolling aggregates — reset after each summary window closes ──────
@@ -183,6 +198,9 @@ struct ColdChainState {
     float    pending_lux_max;
     uint32_t pending_motion;        // MOTION_INVALID = no valid motion data in window
     uint16_t pending_samples;
+    uint16_t pending_chain_seg;     // chain checkpoint: boot_seg, seq and digest
+    uint32_t pending_chain_seq;     //   after the last log entry of the window
+    uint8_t  pending_chain_digest[CHAIN_DIGEST_LEN];
 
     // ── Orientation baseline ─────────────────────────────────────────────────
     char     baseline_orientation[ORIENT_MAX];
@@ -197,14 +215,19 @@ struct ColdChainState {
     // ── Tamper-evident local log ─────────────────────────────────────────────
     // seq: monotonically incremented before each cargo_log.qo entry.  A gap
     //   in Notehub's seq sequence indicates a missed or dropped entry.
-    // chain_crc: rolling 32-bit hash that chains seq + sensor readings for
-    //   every sample cycle.  Downstream consumers can replay the chain from
-    //   the seed value (0) to verify that no entries have been inserted,
-    //   deleted, or modified in the remote log.  The hash advances even when
-    //   the note.add fails so the chain represents the physical event sequence,
+    // chain_digest: keyed HMAC-SHA256 chain over every log entry (see
+    //   chain_hash.h); all zero at the start of each boot_seg.  Each entry
+    //   carries its first 4 bytes as chain_tag and each summary carries the
+    //   whole digest as a checkpoint.  The digest advances even when the
+    //   note.add fails so the chain represents the physical event sequence,
     //   not just the transmitted subset.
+    // chain_key / chain_key_ready: the per-device chain key, derived from
+    //   CHAIN_MASTER_KEY and the Notecard device UID on cold boot (retried
+    //   before each log entry until the Notecard answers hub.get).
     uint32_t seq;
-    uint32_t chain_crc;
+    uint8_t  chain_digest[CHAIN_DIGEST_LEN];
+    ChainKey chain_key;
+    bool     chain_key_ready;
 
     // ── Shipment-state model ─────────────────────────────────────────────────
     // shipment_state: current state (SHIP_STATE_* codes above).
@@ -233,9 +256,9 @@ struct ColdChainState {
     //   planned-sleep resilience AND to the local Notecard notefile
     //   chain_boot.dbx for cold-boot resilience (power-loss safe).
     //   Included in every cargo_log.qo entry so downstream verifiers can split
-    //   chain verification at boot-segment boundaries.  seq and chain_crc reset
-    //   to 0 at the start of each new boot_seg; each segment's chain is
-    //   independent and replayed from seq=1, seed=0.
+    //   chain verification at boot-segment boundaries.  seq and chain_digest
+    //   reset to 0 at the start of each new boot_seg; each segment's chain is
+    //   independent and replayed from seq=1 and an all-zero digest.
     uint16_t boot_seg;
 
     // ── Pending state-change note ─────────────────────────────────────────────
@@ -299,6 +322,7 @@ bool     sendPendingSummary(void);
 void     resetAccumulators(void);
 uint32_t currentEpoch(void);
 // Tamper-evident per-sample log
+bool     chainKeyInit(void);
 bool     sendLogEntry(uint32_t now, float temp_c, float rh_pct,
                       float lux, uint32_t motion, bool motionOk, uint8_t state);
 // Shipment-state model
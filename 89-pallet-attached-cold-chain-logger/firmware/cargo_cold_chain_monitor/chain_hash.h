@@ -0,0 +1,247 @@
+#pragma once
+// chain_hash.h — keyed hash chain for the tamper-evident cargo_log.qo record.
+//
+// Every log entry advances a 256-bit chain digest:
+//
+//   d[0] = 32 zero bytes                  (start of each boot_seg)
+//   d[n] = HMAC-SHA256(K_dev, d[n-1] || entry[n])
+//
+// where entry[n] is the packed log entry (see chainEntryPack) and K_dev is a
+// per-device key, HMAC-SHA256(CHAIN_MASTER_KEY, Notecard device UID).  Without
+// K_dev nobody can produce a digest that continues the chain, so an edited,
+// inserted or deleted entry can't be covered up by recomputing the chain
+// after it — unlike the 32-bit rolling CRC this replaces.
+//
+// Only the first 4 bytes of d[n] travel with each entry (chain_tag), so a log
+// entry costs the same bytes as before; the full d[n] is published as a
+// checkpoint in every cargo_data.qo summary.  A verifier holding the master
+// key replays each boot_seg from d[0], checks every chain_tag, and compares
+// the full digest at each checkpoint.  After a dropped entry it resumes from
+// the next checkpoint.
+//
+// The STM32L433 on the Cygnet has a CRC unit but no HASH peripheral, so
+// SHA-256 is done in software.  Per entry that's three compression-function
+// calls (the HMAC pads are pre-hashed once per key into ChainKey), well under
+// a millisecond at 80 MHz against a multi-second wake.
+//
+// No Arduino or Notecard dependencies, so the verifier in tools/ builds the
+// same header.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define CHAIN_DIGEST_LEN   32u
+#define CHAIN_ENTRY_LEN    27u
+
+// ── SHA-256 (FIPS 180-4) ───────────────────────────────────────────────────
+
+struct Sha256 {
+    uint32_t h[8];
+    uint8_t  block[64];
+    uint32_t blockLen;
+    uint64_t totalLen;
+};
+
+static inline uint32_t sha256Rotr(uint32_t x, unsigned n) {
+    return (x >> n) | (x << (32u - n));
+}
+
+static inline void sha256Compress(uint32_t h[8], const uint8_t block[64]) {
+    static const uint32_t k[64] = {
+        0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+        0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+        0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+        0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+        0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+        0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+        0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+        0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+    };
+    uint32_t w[64];
+    for (int i = 0; i < 16; i++) {
+        w[i] = ((uint32_t)block[4 * i] << 24) | ((uint32_t)block[4 * i + 1] << 16) |
+               ((uint32_t)block[4 * i + 2] << 8) | (uint32_t)block[4 * i + 3];
+    }
+    for (int i = 16; i < 64; i++) {
+        uint32_t s0 = sha256Rotr(w[i - 15], 7) ^ sha256Rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        uint32_t s1 = sha256Rotr(w[i - 2], 17) ^ sha256Rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+    uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4], f = h[5], g = h[6], hh = h[7];
+    for (int i = 0; i < 64; i++) {
+        uint32_t t1 = hh + (sha256Rotr(e, 6) ^ sha256Rotr(e, 11) ^ sha256Rotr(e, 25)) +
+                      ((e & f) ^ (~e & g)) + k[i] + w[i];
+        uint32_t t2 = (sha256Rotr(a, 2) ^ sha256Rotr(a, 13) ^ sha256Rotr(a, 22)) +
+                      ((a & b) ^ (a & c) ^ (b & c));
+        hh = g; g = f; f = e; e = d + t1;
+        d = c;  c = b; b = a; a = t1 + t2;
+    }
+    h[0] += a; h[1] += b; h[2] += c; h[3] += d;
+    h[4] += e; h[5] += f; h[6] += g; h[7] += hh;
+}
+
+static inline void sha256Init(Sha256 &s) {
+    static const uint32_t iv[8] = {
+        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+        0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+    };
+    memcpy(s.h, iv, sizeof(iv));
+    s.blockLen = 0;
+    s.totalLen = 0;
+}
+
+static inline void sha256Update(Sha256 &s, const uint8_t *p, size_t len) {
+    s.totalLen += len;
+    while (len > 0) {
+        size_t n = 64u - s.blockLen;
+        if (n > len) n = len;
+        memcpy(s.block + s.blockLen, p, n);
+        s.blockLen += (uint32_t)n;
+        p += n;
+        len -= n;
+        if (s.blockLen == 64u) {
+            sha256Compress(s.h, s.block);
+            s.blockLen = 0;
+        }
+    }
+}
+
+static inline void sha256Final(Sha256 &s, uint8_t out[CHAIN_DIGEST_LEN]) {
+    const uint64_t bits = s.totalLen * 8u;
+    const uint8_t  pad  = 0x80;
+    const uint8_t  zero = 0x00;
+    sha256Update(s, &pad, 1);
+    while (s.blockLen != 56u) sha256Update(s, &zero, 1);
+    uint8_t len[8];
+    for (int i = 0; i < 8; i++) len[i] = (uint8_t)(bits >> (56 - 8 * i));
+    sha256Update(s, len, sizeof(len));
+    for (int i = 0; i < 8; i++) {
+        out[4 * i]     = (uint8_t)(s.h[i] >> 24);
+        out[4 * i + 1] = (uint8_t)(s.h[i] >> 16);
+        out[4 * i + 2] = (uint8_t)(s.h[i] >> 8);
+        out[4 * i + 3] = (uint8_t)s.h[i];
+    }
+}
+
+// ── HMAC-SHA256 with pre-hashed pads ───────────────────────────────────────
+
+// SHA-256 states after absorbing key^ipad and key^opad.  Holds everything
+// needed to MAC with the key, so the raw key never has to be kept.
+struct ChainKey {
+    uint32_t inner[8];
+    uint32_t outer[8];
+};
+
+static inline void chainKeySet(ChainKey &k, const uint8_t *key, size_t keyLen) {
+    uint8_t block[64] = {0};
+    if (keyLen > sizeof(block)) {
+        Sha256 s;
+        sha256Init(s);
+        sha256Update(s, key, keyLen);
+        sha256Final(s, block);
+    } else if (keyLen > 0) {
+        memcpy(block, key, keyLen);
+    }
+    Sha256 s;
+    for (int i = 0; i < 64; i++) block[i] ^= 0x36;
+    sha256Init(s);
+    sha256Compress(s.h, block);
+    memcpy(k.inner, s.h, sizeof(k.inner));
+    for (int i = 0; i < 64; i++) block[i] ^= 0x36 ^ 0x5c;
+    sha256Init(s);
+    sha256Compress(s.h, block);
+    memcpy(k.outer, s.h, sizeof(k.outer));
+}
+
+static inline void chainMac(const ChainKey &k, const uint8_t *msg, size_t len,
+                            uint8_t out[CHAIN_DIGEST_LEN]) {
+    Sha256 s;
+    memcpy(s.h, k.inner, sizeof(s.h));
+    s.blockLen = 0;
+    s.totalLen = 64;
+    sha256Update(s, msg, len);
+    uint8_t innerDigest[CHAIN_DIGEST_LEN];
+    sha256Final(s, innerDigest);
+
+    memcpy(s.h, k.outer, sizeof(s.h));
+    s.blockLen = 0;
+    s.totalLen = 64;
+    sha256Update(s, innerDigest, sizeof(innerDigest));
+    sha256Final(s, out);
+}
+
+// K_dev = HMAC-SHA256(master, deviceUid).  An empty master key still gives a
+// valid chain, but one anyone can recompute: set CHAIN_MASTER_KEY before
+// deploying if the log must stand up to deliberate tampering.
+static inline void chainKeyDerive(ChainKey &k, const char *master, const char *deviceUid) {
+    ChainKey m;
+    chainKeySet(m, (const uint8_t *)master, strlen(master));
+    uint8_t devKey[CHAIN_DIGEST_LEN];
+    chainMac(m, (const uint8_t *)deviceUid, strlen(deviceUid), devKey);
+    chainKeySet(k, devKey, sizeof(devKey));
+    memset(devKey, 0, sizeof(devKey));
+}
+
+// ── Log entries ────────────────────────────────────────────────────────────
+
+// The cargo_log.qo fields that are covered by the chain, exactly as logged.
+struct ChainEntry {
+    uint32_t seq;
+    uint16_t boot_seg;
+    uint32_t time;
+    float    temp_c;
+    float    rh_pct;
+    float    lux;
+    uint32_t motion;
+    uint8_t  motion_valid;
+    uint8_t  state;
+};
+
+static inline uint8_t *chainPutU32(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); p[2] = (uint8_t)(v >> 16); p[3] = (uint8_t)(v >> 24);
+    return p + 4;
+}
+
+// Packs e little-endian; floats as their IEEE-754 bits, so INVALID_F hashes
+// the same on the device and in the verifier.  motion_valid and state share
+// the last byte.
+static inline void chainEntryPack(const ChainEntry &e, uint8_t out[CHAIN_ENTRY_LEN]) {
+    uint32_t bits;
+    uint8_t *p = chainPutU32(out, e.seq);
+    *p++ = (uint8_t)e.boot_seg;
+    *p++ = (uint8_t)(e.boot_seg >> 8);
+    p = chainPutU32(p, e.time);
+    memcpy(&bits, &e.temp_c, sizeof(bits)); p = chainPutU32(p, bits);
+    memcpy(&bits, &e.rh_pct, sizeof(bits)); p = chainPutU32(p, bits);
+    memcpy(&bits, &e.lux,    sizeof(bits)); p = chainPutU32(p, bits);
+    p = chainPutU32(p, e.motion);
+    *p = (uint8_t)((e.motion_valid ? 0x80u : 0u) | (e.state & 0x7Fu));
+}
+
+// Advances digest in place over entry e.
+static inline void chainAdvance(const ChainKey &k, uint8_t digest[CHAIN_DIGEST_LEN],
+                                const ChainEntry &e) {
+    uint8_t msg[CHAIN_DIGEST_LEN + CHAIN_ENTRY_LEN];
+    memcpy(msg, digest, CHAIN_DIGEST_LEN);
+    chainEntryPack(e, msg + CHAIN_DIGEST_LEN);
+    chainMac(k, msg, sizeof(msg), digest);
+}
+
+// The per-entry chain_tag: the first 4 bytes of the digest, big-endian, so it
+// reads as the first 8 hex digits of the checkpoint digest.
+static inline uint32_t chainTag(const uint8_t digest[CHAIN_DIGEST_LEN]) {
+    return ((uint32_t)digest[0] << 24) | ((uint32_t)digest[1] << 16) |
+           ((uint32_t)digest[2] << 8) | (uint32_t)digest[3];
+}
+
+// Writes the digest as 64 lowercase hex digits plus a terminator.
+static inline void chainDigestHex(const uint8_t digest[CHAIN_DIGEST_LEN],
+                                  char out[2 * CHAIN_DIGEST_LEN + 1]) {
+    static const char hex[] = "0123456789abcdef";
+    for (unsigned i = 0; i < CHAIN_DIGEST_LEN; i++) {
+        out[2 * i]     = hex[digest[i] >> 4];
+        out[2 * i + 1] = hex[digest[i] & 0x0F];
+    }
+    out[2 * CHAIN_DIGEST_LEN] = '\0';
+}
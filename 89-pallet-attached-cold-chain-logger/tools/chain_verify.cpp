@@ -0,0 +1,518 @@
+// chain_verify.cpp — host verifier for the cargo_log.qo hash chain.
+//
+// Reads Notehub events as newline-delimited JSON (one event per line, e.g.
+// `jq -c '.[]' export.json`), keeps the cargo_log.qo entries and the
+// cargo_data.qo chain checkpoints, and replays each device's chain one
+// boot_seg at a time exactly as the firmware built it (see
+// ../firmware/cargo_cold_chain_monitor/chain_hash.h):
+//
+//   - every entry's chain_tag must match the replayed digest;
+//   - every checkpoint's chain_digest must match the replayed digest at its
+//     chain_seq;
+//   - a seq gap (dropped, or deleted, entry) or a bad tag leaves the replay
+//     unable to vouch for what follows, so it resumes from the next
+//     checkpoint and reports the entries in between as unverified.  A gap is
+//     not proof of tampering, but it is not a clean chain either, so it has
+//     its own exit status.
+//
+// Input is parsed in place from a large read buffer with a small JSON
+// scanner, and only the chained fields of each entry are kept (36 bytes),
+// so exports of millions of entries verify in seconds.  Entries may arrive
+// in any order; each segment is sorted by seq before its replay.
+//
+// Build and run from this directory:
+//   g++ -O2 -std=c++11 chain_verify.cpp -o chain_verify
+//   ./chain_verify -k "$CHAIN_MASTER_KEY" events.ndjson
+//
+// With no file it reads stdin.  The master key can also come from the
+// CHAIN_MASTER_KEY environment variable.  Exit status is 0 when every entry
+// and checkpoint verifies, 1 when any tag or checkpoint fails, 2 on a usage
+// or I/O error, and 3 when nothing fails but entries are missing or
+// unverified.  --allow-gaps turns that last case into 0, for exports known to
+// be incomplete.
+//
+// `./chain_verify --synth N [--tamper] > events.ndjson` writes N entries of a
+// simulated logger (key "bench-key", hourly checkpoints, a few dropped
+// entries), for benchmarking and for checking the verifier itself.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../firmware/cargo_cold_chain_monitor/chain_hash.h"
+
+// ── Records ────────────────────────────────────────────────────────────────
+
+struct LogRecord {
+    ChainEntry entry;
+    uint32_t   tag;
+};
+
+struct Checkpoint {
+    uint32_t seq;
+    uint8_t  digest[CHAIN_DIGEST_LEN];
+};
+
+struct Segment {
+    std::vector<LogRecord>  logs;
+    std::vector<Checkpoint> checkpoints;
+};
+
+typedef std::pair<std::string, uint16_t> SegmentKey;   // device UID, boot_seg
+
+struct Totals {
+    unsigned long long entries, verified, unverified, badTags, missing;
+    unsigned long long checkpointsOk, checkpointsBad, conflicts;
+};
+
+// ── Minimal JSON scanning ──────────────────────────────────────────────────
+// Notehub event lines are flat apart from "body" (and metadata objects the
+// verifier skips), so this handles exactly what it needs: strings, numbers,
+// literals, and skipping nested values.
+
+struct Scan {
+    const char *p;
+};
+
+// A string token, pointing into the line being parsed.
+struct Token {
+    const char *p;
+    size_t      len;
+    bool is(const char *lit) const { return strlen(lit) == len && memcmp(p, lit, len) == 0; }
+};
+
+static void skipWs(Scan &s) {
+    while (*s.p == ' ' || *s.p == '\t' || *s.p == '\r' || *s.p == '\n') s.p++;
+}
+
+// Reads a string token, escapes left as they are: none of the fields the
+// verifier compares contain them.
+static bool readString(Scan &s, Token *out) {
+    if (*s.p != '"') return false;
+    const char *start = ++s.p;
+    while (*s.p && *s.p != '"') {
+        if (*s.p == '\\' && s.p[1]) s.p++;
+        s.p++;
+    }
+    if (*s.p != '"') return false;
+    if (out) { out->p = start; out->len = (size_t)(s.p - start); }
+    s.p++;
+    return true;
+}
+
+static bool skipValue(Scan &s) {
+    skipWs(s);
+    if (*s.p == '"') return readString(s, NULL);
+    if (*s.p == '{' || *s.p == '[') {
+        int depth = 0;
+        do {
+            if (*s.p == '"') {
+                if (!readString(s, NULL)) return false;
+                continue;
+            }
+            if (*s.p == '{' || *s.p == '[') depth++;
+            else if (*s.p == '}' || *s.p == ']') depth--;
+            else if (*s.p == '\0') return false;
+            s.p++;
+        } while (depth > 0);
+        return true;
+    }
+    while (*s.p && *s.p != ',' && *s.p != '}' && *s.p != ']') s.p++;
+    return true;
+}
+
+// Calls onMember(key, scan) for each member of the object at s; onMember
+// consumes the value or returns false to have it skipped.
+template <typename F>
+static bool readObject(Scan &s, F onMember) {
+    skipWs(s);
+    if (*s.p != '{') return false;
+    s.p++;
+    Token key;
+    for (;;) {
+        skipWs(s);
+        if (*s.p == '}') { s.p++; return true; }
+        if (!readString(s, &key)) return false;
+        skipWs(s);
+        if (*s.p != ':') return false;
+        s.p++;
+        skipWs(s);
+        if (!onMember(key, s) && !skipValue(s)) return false;
+        skipWs(s);
+        if (*s.p == ',') s.p++;
+    }
+}
+
+static double readNumber(Scan &s) {
+    char *end;
+    double v = strtod(s.p, &end);
+    s.p = end;
+    return v;
+}
+
+static float readFloat(Scan &s) {
+    char *end;
+    float v = strtof(s.p, &end);   // parse straight to float32, as logged
+    s.p = end;
+    return v;
+}
+
+// ── Event parsing ──────────────────────────────────────────────────────────
+
+struct EventBody {
+    bool       hasTime, hasTag, hasDigest, hasChainSeq, hasSeq;
+    ChainEntry entry;
+    uint32_t   tag;
+    uint16_t   chainSeg;
+    uint32_t   chainSeq;
+    Token      digestHex;
+};
+
+
+static int hexNibble(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+static bool parseDigest(const Token &hex, uint8_t out[CHAIN_DIGEST_LEN]) {
+    if (hex.len != 2 * CHAIN_DIGEST_LEN) return false;
+    for (unsigned i = 0; i < CHAIN_DIGEST_LEN; i++) {
+        int hi = hexNibble(hex.p[2 * i]), lo = hexNibble(hex.p[2 * i + 1]);
+        if (hi < 0 || lo < 0) return false;
+        out[i] = (uint8_t)(hi << 4 | lo);
+    }
+    return true;
+}
+
+static bool readBody(Scan &s, EventBody &b) {
+    return readObject(s, [&b](const Token &k, Scan &v) -> bool {
+        if (*v.p == '"') {
+            if (!k.is("chain_digest")) return false;
+            b.hasDigest = readString(v, &b.digestHex);
+            return b.hasDigest;
+        }
+        if (*v.p != '-' && (*v.p < '0' || *v.p > '9')) return false;
+        if      (k.is("seq"))          { b.entry.seq = (uint32_t)readNumber(v); b.hasSeq = true; }
+        else if (k.is("boot_seg"))     b.entry.boot_seg = (uint16_t)readNumber(v);
+        else if (k.is("_time"))        { b.entry.time = (uint32_t)readNumber(v); b.hasTime = true; }
+        else if (k.is("temp_c"))       b.entry.temp_c = readFloat(v);
+        else if (k.is("rh_pct"))       b.entry.rh_pct = readFloat(v);
+        else if (k.is("lux"))          b.entry.lux = readFloat(v);
+        else if (k.is("motion"))       b.entry.motion = (uint32_t)readNumber(v);
+        else if (k.is("motion_valid")) b.entry.motion_valid = (uint8_t)readNumber(v);
+        else if (k.is("state"))        b.entry.state = (uint8_t)readNumber(v);
+        else if (k.is("chain_tag"))    { b.tag = (uint32_t)readNumber(v); b.hasTag = true; }
+        else if (k.is("chain_seg"))    b.chainSeg = (uint16_t)readNumber(v);
+        else if (k.is("chain_seq"))    { b.chainSeq = (uint32_t)readNumber(v); b.hasChainSeq = true; }
+        else return false;
+        return true;
+    });
+}
+
+// Finds or creates the segment for device / bootSeg.  Exports run one device
+// and segment at a time, so the last segment found is checked first.
+static Segment &segmentFor(std::map<SegmentKey, Segment> &segs, const Token &device,
+                           uint16_t bootSeg) {
+    static SegmentKey last;
+    static Segment   *lastSeg = NULL;
+    if (lastSeg == NULL || last.second != bootSeg ||
+            last.first.size() != device.len ||
+            memcmp(last.first.data(), device.p, device.len) != 0) {
+        last    = SegmentKey(std::string(device.p, device.len), bootSeg);
+        lastSeg = &segs[last];
+    }
+    return *lastSeg;
+}
+
+// Parses one event line into segs.  Returns false for a malformed line.
+static bool parseEvent(const char *line, std::map<SegmentKey, Segment> &segs) {
+    Scan s = { line };
+    Token device = { "", 0 }, file = { "", 0 };
+    EventBody b;
+    memset(&b.entry, 0, sizeof(b.entry));
+    b.hasTime = b.hasTag = b.hasDigest = b.hasChainSeq = b.hasSeq = false;
+    b.tag = 0; b.chainSeg = 0; b.chainSeq = 0;
+    double when = 0;
+
+    bool ok = readObject(s, [&](const Token &k, Scan &v) -> bool {
+        if (k.is("device")) return readString(v, &device);
+        if (k.is("file"))   return readString(v, &file);
+        if (k.is("when"))   { when = readNumber(v); return true; }
+        if (k.is("body"))   return readBody(v, b);
+        return false;
+    });
+    if (!ok) return false;
+
+    // Compact templates move _time into the event's "when".
+    if (!b.hasTime) b.entry.time = (uint32_t)when;
+
+    if (file.is("cargo_log.qo") && b.hasSeq && b.hasTag) {
+        LogRecord r = { b.entry, b.tag };
+        segmentFor(segs, device, b.entry.boot_seg).logs.push_back(r);
+    } else if (file.is("cargo_data.qo") && b.hasChainSeq && b.hasDigest) {
+        Checkpoint c;
+        c.seq = b.chainSeq;
+        if (!parseDigest(b.digestHex, c.digest)) return false;
+        segmentFor(segs, device, b.chainSeg).checkpoints.push_back(c);
+    }
+    return true;
+}
+
+// Reads the input in large blocks and hands each complete line to
+// parseEvent, NUL-terminated in place.
+static bool readEvents(FILE *in, std::map<SegmentKey, Segment> &segs,
+                       unsigned long long *lines, unsigned long long *badLines,
+                       unsigned long long *bytes) {
+    std::vector<char> buf(1 << 20);
+    size_t have = 0;
+    for (;;) {
+        if (have + 1 >= buf.size()) buf.resize(buf.size() * 2);   // one very long line
+        size_t n = fread(&buf[have], 1, buf.size() - have - 1, in);
+        *bytes += n;
+        have += n;
+        bool eof = (n == 0);
+        if (eof && have == 0) break;
+
+        size_t start = 0;
+        for (size_t i = 0; i < have; i++) {
+            if (buf[i] != '\n' && !(eof && i == have - 1)) continue;
+            size_t endLine = (buf[i] == '\n') ? i : i + 1;
+            buf[endLine] = '\0';
+            const char *line = &buf[start];
+            while (*line == ' ' || *line == '\t' || *line == '\r') line++;
+            if (*line) {
+                (*lines)++;
+                if (!parseEvent(line, segs)) (*badLines)++;
+            }
+            start = i + 1;
+        }
+        memmove(&buf[0], &buf[start], have - start);
+        have -= start;
+        if (eof) break;
+    }
+    return !ferror(in);
+}
+
+// ── Replay ─────────────────────────────────────────────────────────────────
+
+static bool sameEntry(const LogRecord &a, const LogRecord &b) {
+    uint8_t pa[CHAIN_ENTRY_LEN], pb[CHAIN_ENTRY_LEN];
+    chainEntryPack(a.entry, pa);
+    chainEntryPack(b.entry, pb);
+    return a.tag == b.tag && memcmp(pa, pb, sizeof(pa)) == 0;
+}
+
+static void verifySegment(const SegmentKey &key, Segment &seg, const ChainKey &ck,
+                          bool verbose, Totals &t) {
+    std::sort(seg.logs.begin(), seg.logs.end(),
+              [](const LogRecord &a, const LogRecord &b) { return a.entry.seq < b.entry.seq; });
+    std::sort(seg.checkpoints.begin(), seg.checkpoints.end(),
+              [](const Checkpoint &a, const Checkpoint &b) { return a.seq < b.seq; });
+
+    uint8_t  digest[CHAIN_DIGEST_LEN] = {0};
+    bool     synced = true;    // digest is the device's digest after entry `pos`
+    uint32_t pos    = 0;
+    size_t   c      = 0;
+    Totals   s;
+    memset(&s, 0, sizeof(s));
+
+    // Checks (synced) or adopts (unsynced) every checkpoint at or before seq.
+    auto applyCheckpoints = [&](uint32_t seq) {
+        for (; c < seg.checkpoints.size() && seg.checkpoints[c].seq <= seq; c++) {
+            const Checkpoint &cp = seg.checkpoints[c];
+            if (cp.seq < pos) continue;       // duplicate of one already applied
+            if (cp.seq > pos) {               // entries before it are missing
+                s.missing += cp.seq - pos;
+                if (verbose) printf("  %s seg %u: seq %lu..%lu missing\n", key.first.c_str(),
+                                    key.second, (unsigned long)(pos + 1), (unsigned long)cp.seq);
+                synced = false;
+            }
+            if (synced) {
+                if (memcmp(cp.digest, digest, CHAIN_DIGEST_LEN) == 0) {
+                    s.checkpointsOk++;
+                } else {
+                    s.checkpointsBad++;
+                    if (verbose) printf("  %s seg %u: checkpoint at seq %lu does not match\n",
+                                        key.first.c_str(), key.second, (unsigned long)cp.seq);
+                }
+            }
+            memcpy(digest, cp.digest, CHAIN_DIGEST_LEN);
+            pos    = cp.seq;
+            synced = true;
+        }
+    };
+
+    applyCheckpoints(0);
+    for (size_t i = 0; i < seg.logs.size(); i++) {
+        const LogRecord &r = seg.logs[i];
+        if (i > 0 && r.entry.seq == seg.logs[i - 1].entry.seq) {
+            if (!sameEntry(r, seg.logs[i - 1])) s.conflicts++;
+            continue;   // at-least-once delivery: identical copies are harmless
+        }
+        s.entries++;
+        applyCheckpoints(r.entry.seq - 1);
+        if (r.entry.seq != pos + 1) {
+            if (r.entry.seq > pos + 1) s.missing += r.entry.seq - pos - 1;
+            if (verbose) printf("  %s seg %u: seq %lu..%lu missing\n", key.first.c_str(),
+                                key.second, (unsigned long)(pos + 1),
+                                (unsigned long)(r.entry.seq - 1));
+            synced = false;
+        }
+        pos = r.entry.seq;
+        if (!synced) {
+            s.unverified++;
+            continue;
+        }
+        chainAdvance(ck, digest, r.entry);
+        if (chainTag(digest) == r.tag) {
+            s.verified++;
+        } else {
+            s.badTags++;
+            synced = false;
+            if (verbose) printf("  %s seg %u: seq %lu chain_tag does not match\n",
+                                key.first.c_str(), key.second, (unsigned long)r.entry.seq);
+        }
+    }
+    applyCheckpoints(UINT32_MAX);
+
+    printf("%s boot_seg %u: %llu entries, %llu verified, %llu unverified, %llu bad, "
+           "%llu missing, checkpoints %llu ok / %llu bad%s\n",
+           key.first.c_str(), key.second, s.entries, s.verified, s.unverified, s.badTags,
+           s.missing, s.checkpointsOk, s.checkpointsBad,
+           s.conflicts ? ", CONFLICTING DUPLICATES" : "");
+
+    t.entries += s.entries;         t.verified += s.verified;
+    t.unverified += s.unverified;   t.badTags += s.badTags;
+    t.missing += s.missing;         t.checkpointsOk += s.checkpointsOk;
+    t.checkpointsBad += s.checkpointsBad;
+    t.conflicts += s.conflicts;
+}
+
+// ── Synthetic export ───────────────────────────────────────────────────────
+
+static int synth(unsigned long n, bool tamper) {
+    const char *device = "dev:864475040000000";
+    ChainKey ck;
+    chainKeyDerive(ck, "bench-key", device);
+
+    uint8_t  digest[CHAIN_DIGEST_LEN] = {0};
+    uint32_t t = 1760000000u;
+    srand(1);
+    for (unsigned long i = 1; i <= n; i++) {
+        ChainEntry e;
+        e.seq          = (uint32_t)i;
+        e.boot_seg     = 1;
+        e.time         = t += 300;
+        e.temp_c       = 4.0f + (float)(rand() % 400) / 100.0f;
+        e.rh_pct       = 55.0f + (float)(rand() % 2000) / 100.0f;
+        e.lux          = (i % 500 == 0) ? -9999.0f : (float)(rand() % 100) / 10.0f;
+        e.motion_valid = (i % 97 != 0);
+        e.motion       = e.motion_valid ? (uint32_t)(rand() % 8) : 0;
+        e.state        = (uint8_t)(1 + (i / 1000) % 3);
+        chainAdvance(ck, digest, e);
+
+        float temp = e.temp_c;
+        if (tamper && i == n / 2) temp += 1.0f;   // an auditor-visible edit
+        bool dropped = (i % 10007 == 0);          // lost in transit
+        if (!dropped) {
+            printf("{\"event\":\"%08lx\",\"device\":\"%s\",\"file\":\"cargo_log.qo\","
+                   "\"when\":%lu,\"body\":{\"seq\":%lu,\"temp_c\":%.9g,\"rh_pct\":%.9g,"
+                   "\"lux\":%.9g,\"motion\":%lu,\"motion_valid\":%u,\"state\":%u,"
+                   "\"boot_seg\":%u,\"chain_tag\":%lu}}\n",
+                   i, device, (unsigned long)e.time, i, (double)temp, (double)e.rh_pct,
+                   (double)e.lux, (unsigned long)e.motion, e.motion_valid, e.state,
+                   e.boot_seg, (unsigned long)chainTag(digest));
+        }
+        if (i % 12 == 0) {
+            char hex[2 * CHAIN_DIGEST_LEN + 1];
+            chainDigestHex(digest, hex);
+            printf("{\"event\":\"c%07lx\",\"device\":\"%s\",\"file\":\"cargo_data.qo\","
+                   "\"when\":%lu,\"body\":{\"samples\":12,\"chain_seg\":1,\"chain_seq\":%lu,"
+                   "\"chain_digest\":\"%s\"}}\n",
+                   i, device, (unsigned long)e.time, i, hex);
+        }
+    }
+    return 0;
+}
+
+// ── Main ───────────────────────────────────────────────────────────────────
+
+static int usage() {
+    fprintf(stderr, "usage: chain_verify [-k master_key] [-v] [--allow-gaps] [events.ndjson]\n"
+                    "       chain_verify --synth N [--tamper]\n");
+    return 2;
+}
+
+int main(int argc, char **argv) {
+    const char *master = getenv("CHAIN_MASTER_KEY");
+    const char *path   = NULL;
+    bool verbose = false, tamper = false, allowGaps = false;
+    long synthN  = -1;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-k") && i + 1 < argc)            master = argv[++i];
+        else if (!strcmp(argv[i], "-v"))                       verbose = true;
+        else if (!strcmp(argv[i], "--synth") && i + 1 < argc)  synthN = atol(argv[++i]);
+        else if (!strcmp(argv[i], "--tamper"))                 tamper = true;
+        else if (!strcmp(argv[i], "--allow-gaps"))             allowGaps = true;
+        else if (argv[i][0] == '-' && argv[i][1])              return usage();
+        else                                                   path = argv[i];
+    }
+    if (synthN >= 0) return synth((unsigned long)synthN, tamper);
+    if (master == NULL) master = "";
+
+    FILE *in = path ? fopen(path, "rb") : stdin;
+    if (in == NULL) {
+        perror(path);
+        return 2;
+    }
+
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+
+    std::map<SegmentKey, Segment> segs;
+    unsigned long long lines = 0, badLines = 0, bytes = 0;
+    bool readOk = readEvents(in, segs, &lines, &badLines, &bytes);
+    if (in != stdin) fclose(in);
+    if (!readOk) {
+        perror(path ? path : "stdin");
+        return 2;
+    }
+
+    Totals t;
+    memset(&t, 0, sizeof(t));
+    std::string keyDevice;
+    ChainKey ck;
+    for (std::map<SegmentKey, Segment>::iterator it = segs.begin(); it != segs.end(); ++it) {
+        if (it->first.first != keyDevice || keyDevice.empty()) {
+            keyDevice = it->first.first;
+            chainKeyDerive(ck, master, keyDevice.c_str());
+        }
+        verifySegment(it->first, it->second, ck, verbose, t);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    double sec = (double)(t1.tv_sec - t0.tv_sec) + (double)(t1.tv_nsec - t0.tv_nsec) / 1e9;
+
+    printf("total: %llu entries in %zu segments, %llu verified, %llu unverified, "
+           "%llu bad, %llu missing, checkpoints %llu ok / %llu bad\n",
+           t.entries, segs.size(), t.verified, t.unverified, t.badTags, t.missing,
+           t.checkpointsOk, t.checkpointsBad);
+    if (badLines) printf("skipped %llu malformed lines\n", badLines);
+    fprintf(stderr, "%llu lines, %.1f MB in %.2f s (%.0f entries/s, %.0f MB/s)\n",
+            lines, (double)bytes / 1e6, sec, sec > 0 ? (double)t.entries / sec : 0.0,
+            sec > 0 ? (double)bytes / 1e6 / sec : 0.0);
+
+    if (t.badTags || t.checkpointsBad || t.conflicts) return 1;
+    if ((t.missing || t.unverified) && !allowGaps) return 3;
+    return 0;
+}
@@ -0,0 +1,346 @@
+/*!
+ *
+ * Written by the Blues Inc. team.
+ *
+ *
+ * Copyright (c) 2022 Blues Inc. MIT License. Use of this source code is
+ * governed by licenses granted by the copyright holder including that found in
+ * the
+ * <a href="https://github.com/blues/app-accelerators/blob/main/LICENSE">LICENSE</a>
+ * file.
+ *
+ */
+
+#include "asset_cache.h"
+
+static void tmpPath(const char *id, char *out, size_t len) {
+  snprintf(out, len, ASSET_DIR "/%s.tmp", id);
+}
+
+bool AssetCache::begin() {
+  if (!sd.exists(ASSET_DIR) && !sd.mkdir(ASSET_DIR)) {
+    return false;
+  }
+
+  // A reset mid-download leaves a .tmp file behind; the asset is fetched
+  // again from its first chunk.
+  File dir;
+  File file;
+  char name[32];
+  char stale[ASSET_QUEUE_LEN][sizeof(name)];
+  uint8_t numStale = 0;
+
+  if (!dir.open(ASSET_DIR)) {
+    return false;
+  }
+  while (file.openNext(&dir, O_RDONLY)) {
+    file.getName(name, sizeof(name));
+    if (strstr(name, ".tmp") != NULL && numStale < ASSET_QUEUE_LEN) {
+      snprintf(stale[numStale++], sizeof(name), "%s", name);
+    }
+    file.close();
+  }
+  dir.close();
+
+  for (uint8_t i = 0; i < numStale; i++) {
+    char path[48];
+    snprintf(path, sizeof(path), ASSET_DIR "/%s", stale[i]);
+    sd.remove(path);
+  }
+  return true;
+}
+
+void AssetCache::setRoute(const char *name) {
+  snprintf(route, sizeof(route), "%s",
+           (name != NULL && *name) ? name : ASSET_DEFAULT_ROUTE);
+}
+
+bool AssetCache::isAsset(const char *value) {
+  if (strncmp(value, ASSET_PREFIX, strlen(ASSET_PREFIX)) != 0) {
+    return false;
+  }
+  const char *id = value + strlen(ASSET_PREFIX);
+  for (uint8_t i = 0; i < ASSET_ID_LEN; i++) {
+    if (!isdigit(id[i]) && (id[i] < 'a' || id[i] > 'f')) {
+      return false;
+    }
+  }
+  return id[ASSET_ID_LEN] == '\0';
+}
+
+void AssetCache::path(const char *value, char *out, size_t len) {
+  snprintf(out, len, ASSET_DIR "/%s.epd", value + strlen(ASSET_PREFIX));
+}
+
+bool AssetCache::has(const char *value) {
+  char file[48];
+  path(value, file, sizeof(file));
+  return sd.exists(file);
+}
+
+void AssetCache::want(const char *value) {
+  if (!isAsset(value) || has(value)) {
+    return;
+  }
+  const char *id = value + strlen(ASSET_PREFIX);
+  if (find(id) >= 0 || queued == ASSET_QUEUE_LEN) {
+    return;
+  }
+  memcpy(queue[queued], id, ASSET_ID_LEN + 1);
+  queued++;
+}
+
+void AssetCache::clearQueue() {
+  queued = 0;
+}
+
+int AssetCache::find(const char *id) const {
+  for (uint8_t i = 0; i < queued; i++) {
+    if (strcmp(queue[i], id) == 0) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+void AssetCache::dequeue(const char *id) {
+  int i = find(id);
+  if (i < 0) {
+    return;
+  }
+  memmove(queue[i], queue[i + 1], (queued - i - 1) * sizeof(queue[0]));
+  queued--;
+}
+
+AssetStatus AssetCache::poll() {
+  // Stop downloading an asset that display_values no longer names.
+  if (active && find(current) < 0) {
+    abort();
+  }
+  if (queued == 0 || (long)(millis() - retryAtMs) < 0) {
+    return ASSET_IDLE;
+  }
+
+  if (!active) {
+    memcpy(current, queue[0], sizeof(current));
+    if (!start()) {
+      dequeue(current);
+      return ASSET_FAILED;
+    }
+  }
+
+  bool fatal = false;
+  if (!fetchChunk(fatal)) {
+    if (fatal || ++attempts >= ASSET_MAX_ATTEMPTS) {
+      abort();
+      dequeue(current);
+      return ASSET_FAILED;
+    }
+    retryAtMs = millis() + ASSET_RETRY_MS;
+    return ASSET_IDLE;
+  }
+  attempts = 0;
+
+  if (chunk < chunks) {
+    return ASSET_PROGRESS;
+  }
+
+  bool ok = finish();
+  dequeue(current);
+  return ok ? ASSET_DONE : ASSET_FAILED;
+}
+
+bool AssetCache::start() {
+  char file[48];
+  tmpPath(current, file, sizeof(file));
+  if (!tmp.open(file, O_WRONLY | O_CREAT | O_TRUNC)) {
+    error = "unable to create download file";
+    return false;
+  }
+
+  sha256Init(&sha);
+  expectedSha[0] = '\0';
+  chunk = 0;
+  chunks = 0;
+  size = 0;
+  written = 0;
+  attempts = 0;
+  literal = 0;
+  repeat = 0;
+  outLen = 0;
+  active = true;
+  return true;
+}
+
+// Fetch, check and decompress chunk number `chunk`. A failure to reach the
+// asset server is retried later; bad content sets fatal.
+bool AssetCache::fetchChunk(bool &fatal) {
+  char name[40];
+  snprintf(name, sizeof(name), "/%s/%u.json", current, chunk);
+
+  J *req = notecard.newRequest("web.get");
+  if (req == NULL) {
+    error = "out of memory";
+    return false;
+  }
+  JAddStringToObject(req, "route", route);
+  JAddStringToObject(req, "name", name);
+
+  J *rsp = notecard.requestAndResponse(req);
+  if (rsp == NULL) {
+    error = "no response from Notecard";
+    return false;
+  }
+  if (notecard.responseError(rsp)) {
+    error = "web.get failed";
+    notecard.deleteResponse(rsp);
+    return false;
+  }
+
+  J *body = JGetObject(rsp, "body");
+  if (JGetInt(rsp, "result") != 200 || body == NULL) {
+    error = "asset server error";
+    notecard.deleteResponse(rsp);
+    return false;
+  }
+
+  fatal = true;
+  int numChunks = JGetInt(body, "chunks");
+  uint32_t assetSize = (uint32_t)JGetNumber(body, "size");
+  const char *hash = JGetString(body, "sha256");
+  const char *data = JGetString(body, "data");
+
+  if (chunk == 0) {
+    // The id is the start of the hash, so a route serving the wrong asset is
+    // caught before anything is written.
+    if (numChunks <= 0 || assetSize == 0 ||
+        strlen(hash) != 2 * SHA256_DIGEST_LEN ||
+        strncmp(hash, current, ASSET_ID_LEN) != 0) {
+      error = "asset does not match its id";
+      notecard.deleteResponse(rsp);
+      return false;
+    }
+    chunks = numChunks;
+    size = assetSize;
+    memcpy(expectedSha, hash, sizeof(expectedSha));
+  } else if (numChunks != chunks || assetSize != size ||
+             strcmp(hash, expectedSha) != 0) {
+    error = "chunk belongs to a different asset";
+    notecard.deleteResponse(rsp);
+    return false;
+  }
+
+  if (JB64DecodeLen(data) > (int)sizeof(chunkBuf)) {
+    error = "chunk too large";
+    notecard.deleteResponse(rsp);
+    return false;
+  }
+  int len = JB64Decode((char *)chunkBuf, data);
+  notecard.deleteResponse(rsp);
+
+  if (!inflate(chunkBuf, len)) {
+    return false;
+  }
+  chunk++;
+  fatal = false;
+  return true;
+}
+
+// PackBits: a header byte n < 128 is followed by n + 1 literal bytes, n > 128
+// by one byte repeated 257 - n times; 128 is a no-op. Runs may span chunks.
+bool AssetCache::inflate(const uint8_t *in, size_t len) {
+  for (size_t i = 0; i < len; i++) {
+    uint8_t b = in[i];
+    uint16_t count = 1;
+
+    if (literal > 0) {
+      literal--;
+    } else if (repeat > 0) {
+      count = repeat;
+      repeat = 0;
+    } else {
+      if (b < 128) {
+        literal = b + 1;
+      } else if (b > 128) {
+        repeat = 257 - b;
+      }
+      continue;
+    }
+
+    if (written + outLen + count > size) {
+      error = "asset larger than its size";
+      return false;
+    }
+    while (count--) {
+      out[outLen++] = b;
+      if (outLen == sizeof(out) && !flush()) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+bool AssetCache::flush() {
+  if (outLen == 0) {
+    return true;
+  }
+  if (tmp.write(out, outLen) != outLen) {
+    error = "SD write failed";
+    return false;
+  }
+  sha256Update(&sha, out, outLen);
+  written += outLen;
+  outLen = 0;
+  return true;
+}
+
+// Verify the download and move it into place. The .tmp file is removed if
+// anything doesn't match.
+bool AssetCache::finish() {
+  if (!flush()) {
+    abort();
+    return false;
+  }
+  if (written != size || literal != 0 || repeat != 0) {
+    error = "asset shorter than its size";
+    abort();
+    return false;
+  }
+
+  uint8_t digest[SHA256_DIGEST_LEN];
+  char hex[2 * SHA256_DIGEST_LEN + 1];
+  sha256Final(&sha, digest);
+  for (uint8_t i = 0; i < SHA256_DIGEST_LEN; i++) {
+    snprintf(&hex[2 * i], 3, "%02x", digest[i]);
+  }
+  if (strcmp(hex, expectedSha) != 0) {
+    error = "asset hash mismatch";
+    abort();
+    return false;
+  }
+
+  char from[48];
+  char to[48];
+  tmpPath(current, from, sizeof(from));
+  snprintf(to, sizeof(to), ASSET_DIR "/%s.epd", current);
+  tmp.close();
+  active = false;
+  if (!sd.rename(from, to)) {
+    error = "unable to rename download";
+    sd.remove(from);
+    return false;
+  }
+  return true;
+}
+
+void AssetCache::abort() {
+  if (!active) {
+    return;
+  }
+  char file[48];
+  tmpPath(current, file, sizeof(file));
+  tmp.close();
+  sd.remove(file);
+  active = false;
+}
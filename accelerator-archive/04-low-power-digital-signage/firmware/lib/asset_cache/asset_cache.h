@@ -0,0 +1,142 @@
+/*!
+ *
+ * Written by the Blues Inc. team.
+ *
+ *
+ * Copyright (c) 2022 Blues Inc. MIT License. Use of this source code is
+ * governed by licenses granted by the copyright holder including that found in
+ * the
+ * <a href="https://github.com/blues/app-accelerators/blob/main/LICENSE">LICENSE</a>
+ * file.
+ *
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <Notecard.h>
+#include <SdFat.h>
+#include "sha256.h"
+
+// Images pushed from the cloud are named by the first ASSET_ID_LEN hex digits
+// of their SHA-256 and referenced from display_values as "asset:<id>". They
+// are cached on the SD card as ASSET_DIR/<id>.epd, so an asset that is
+// already on the card is never downloaded again, whichever display_values
+// entry names it.
+#define ASSET_PREFIX "asset:"
+#define ASSET_ID_LEN 16
+#define ASSET_DIR "/assets"
+
+// Notehub proxy route that serves the chunk files written by
+// scripts/push-asset.py. Override with the asset_route env var.
+#define ASSET_DEFAULT_ROUTE "signage_assets"
+
+// Assets waiting to be downloaded.
+#define ASSET_QUEUE_LEN 8
+
+// Largest decoded chunk accepted (push-asset.py writes 2KB chunks).
+#define ASSET_MAX_CHUNK 3072
+
+// A chunk that can't be fetched is retried after ASSET_RETRY_MS; the asset is
+// dropped after ASSET_MAX_ATTEMPTS failures in a row.
+#define ASSET_RETRY_MS (60 * 1000UL)
+#define ASSET_MAX_ATTEMPTS 10
+
+enum AssetStatus {
+  ASSET_IDLE,     // nothing to download, or waiting to retry
+  ASSET_PROGRESS, // fetched a chunk
+  ASSET_DONE,     // an asset was verified and added to the cache
+  ASSET_FAILED    // an asset was dropped, see lastError()
+};
+
+// Content-addressed image cache filled over web.get.
+//
+// Each asset is an .epd image (see scripts/bmp2epd.py), PackBits-compressed
+// and split into chunks. Chunk n is fetched with
+//
+//   {"req":"web.get","route":"<route>","name":"/<id>/<n>.json"}
+//
+// and its body is
+//
+//   {"chunks":N,"size":S,"sha256":"<64 hex>","data":"<base64 PackBits>"}
+//
+// Chunks are decompressed straight into ASSET_DIR/<id>.tmp, hashing the
+// output as it is written. Once the last chunk is in, the file is renamed to
+// <id>.epd only if its size and SHA-256 match, and the hash starts with the
+// asset's id, so a partial or corrupted download is never displayed.
+//
+// poll() fetches at most one chunk per call, so the display keeps rotating
+// while a large asset trickles in.
+class AssetCache {
+public:
+  AssetCache(Notecard &nc, SdFat &sd) : notecard(nc), sd(sd) {}
+
+  // Create ASSET_DIR and remove downloads interrupted by a reset.
+  bool begin();
+
+  void setRoute(const char *name);
+
+  // True if value is an "asset:<id>" display value.
+  static bool isAsset(const char *value);
+
+  // Path of the cached file for an "asset:<id>" value.
+  static void path(const char *value, char *out, size_t len);
+
+  // True if the asset is fully downloaded.
+  bool has(const char *value);
+
+  // Queue an asset for download unless it is cached or already queued.
+  void want(const char *value);
+
+  // Forget queued assets, e.g. before queueing the ones in new display_values.
+  // A download in progress is kept if it is queued again.
+  void clearQueue();
+
+  // Fetch the next chunk, if any is due.
+  AssetStatus poll();
+
+  bool busy() const { return queued > 0; }
+  // Id of the asset being downloaded, or of the one that just finished.
+  const char *currentId() const { return current; }
+  const char *lastError() const { return error; }
+
+private:
+  int find(const char *id) const;
+  void dequeue(const char *id);
+  bool start();
+  bool fetchChunk(bool &fatal);
+  bool inflate(const uint8_t *in, size_t len);
+  bool flush();
+  bool finish();
+  void abort();
+
+  Notecard &notecard;
+  SdFat &sd;
+  char route[48] = ASSET_DEFAULT_ROUTE;
+
+  char queue[ASSET_QUEUE_LEN][ASSET_ID_LEN + 1];
+  uint8_t queued = 0;
+
+  // Download in progress; it is resumed as long as the asset stays queued.
+  bool active = false;
+  char current[ASSET_ID_LEN + 1] = "";
+  File tmp;
+  Sha256 sha;
+  char expectedSha[2 * SHA256_DIGEST_LEN + 1];
+  uint16_t chunk = 0;
+  uint16_t chunks = 0;
+  uint32_t size = 0;
+  uint32_t written = 0;
+  uint8_t attempts = 0;
+  unsigned long retryAtMs = 0;
+
+  // PackBits state carried across chunk boundaries.
+  int16_t literal = 0;  // literal bytes still to copy
+  int16_t repeat = 0;   // >0: next byte is repeated this many times
+  uint8_t out[256];
+  uint16_t outLen = 0;
+
+  uint8_t chunkBuf[ASSET_MAX_CHUNK + 4];
+
+  const char *error = "";
+};
@@ -0,0 +1,38 @@
+/*!
+ *
+ * Written by the Blues Inc. team.
+ *
+ *
+ * Copyright (c) 2022 Blues Inc. MIT License. Use of this source code is
+ * governed by licenses granted by the copyright holder including that found in
+ * the
+ * <a href="https://github.com/blues/app-accelerators/blob/main/LICENSE">LICENSE</a>
+ * file.
+ *
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SHA256_DIGEST_LEN 32
+
+typedef struct {
+  uint32_t state[8];
+  uint64_t length;   // bytes hashed so far
+  uint8_t block[64];
+  uint8_t used;      // bytes in block
+} Sha256;
+
+void sha256Init(Sha256 *ctx);
+void sha256Update(Sha256 *ctx, const uint8_t *data, size_t len);
+void sha256Final(Sha256 *ctx, uint8_t digest[SHA256_DIGEST_LEN]);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,265 @@
+/*!
+ *
+ * Written by the Blues Inc. team.
+ *
+ *
+ * Copyright (c) 2022 Blues Inc. MIT License. Use of this source code is
+ * governed by licenses granted by the copyright holder including that found in
+ * the
+ * <a href="https://github.com/blues/app-accelerators/blob/main/LICENSE">LICENSE</a>
+ * file.
+ *
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include "Adafruit_ThinkInk.h"
+
+// Size of the framebuffer SRAM on the display board. The Adafruit eInk
+// FeatherWings carry a 32KB chip; the driver's own framebuffer uses the first
+// frameSize() bytes and the frame cache uses the rest.
+#ifndef EPD_SRAM_SIZE
+#define EPD_SRAM_SIZE 32768
+#endif
+
+// Maximum number of rendered frames kept for reuse (limited by EPD_SRAM_SIZE).
+#define FRAME_CACHE_MAX_SLOTS 4
+
+// Header of a pre-decoded image (".epd" file, see scripts/bmp2epd.py). The
+// planes that follow are in the driver's own framebuffer layout, so loading
+// one is a straight copy into SRAM instead of decoding a BMP pixel by pixel.
+// All fields are little-endian.
+#define EPD_IMAGE_MAGIC "EPD1"
+struct __attribute__((packed)) EpdImageHeader {
+  char magic[4];
+  uint16_t width;
+  uint16_t height;
+  uint8_t planes;     // 1: black only, 2: black + color
+  uint8_t flags;
+  uint16_t reserved;
+  uint32_t planeSize; // bytes per plane
+};
+
+struct DirtyRect {
+  int16_t x1, y1, x2, y2; // inclusive; x1 > x2 if nothing changed
+};
+
+// An e-paper panel that remembers what it last showed.
+//
+// The MCP SRAM holds the driver's framebuffer, then a copy of the frame that
+// is on the glass, then up to FRAME_CACHE_MAX_SLOTS previously rendered
+// frames:
+//
+//   [ framebuffer | shown | slot 0 | slot 1 | ... ]
+//
+// refresh() compares the framebuffer with the shown frame and only drives the
+// panel if they differ, which skips the full (~15 s on tricolor panels)
+// waveform whenever a rotation or an env var update produces the same image.
+// restore()/store() let the caller reuse a rendered frame instead of drawing
+// it again, e.g. instead of re-reading a BMP from SD on every rotation.
+//
+// If the SRAM is too small for the shown copy, refresh() falls back to
+// comparing CRCs of the frames, and nothing is cached.
+template <class Panel>
+class FrameCachedEPD : public Panel {
+public:
+  using Panel::Panel;
+
+  // Call after begin().
+  void beginCache() {
+    uint32_t frames = this->use_sram ? EPD_SRAM_SIZE / frameSize() : 0;
+    shadowValid = false;
+    lastCrcValid = false;
+    haveShadow = frames >= 2;
+    numSlots = haveShadow ? frames - 2 : 0;
+    if (numSlots > FRAME_CACHE_MAX_SLOTS) {
+      numSlots = FRAME_CACHE_MAX_SLOTS;
+    }
+    for (uint8_t i = 0; i < FRAME_CACHE_MAX_SLOTS; i++) {
+      slotKey[i] = 0;
+      slotUsed[i] = 0;
+    }
+  }
+
+  uint32_t frameSize() const { return this->buffer1_size + this->buffer2_size; }
+  uint32_t planeSize() const { return this->buffer1_size; }
+  uint8_t cacheSlots() const { return numSlots; }
+  const DirtyRect &lastDirty() const { return dirty; }
+
+  // Write part of a plane (0 = black, 1 = color) straight into the
+  // framebuffer.
+  void writePlane(uint8_t plane, uint32_t offset, uint8_t *buf, uint16_t len) {
+    if (this->use_sram) {
+      this->sram.write((plane ? this->buffer2_addr : this->buffer1_addr) +
+                       offset, buf, len);
+    } else {
+      memcpy((plane ? this->buffer2 : this->buffer1) + offset, buf, len);
+    }
+  }
+
+  // Load the frame previously stored under key into the framebuffer. Returns
+  // false if it isn't cached.
+  bool restore(uint32_t key) {
+    for (uint8_t i = 0; i < numSlots; i++) {
+      if (slotUsed[i] && slotKey[i] == key) {
+        copyFrame(slotAddr(i), 0);
+        slotUsed[i] = ++useCounter;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // Keep a copy of the framebuffer under key, replacing the least recently
+  // used frame.
+  void store(uint32_t key) {
+    if (numSlots == 0) {
+      return;
+    }
+    uint8_t victim = 0;
+    for (uint8_t i = 0; i < numSlots; i++) {
+      if (slotUsed[i] && slotKey[i] == key) {
+        victim = i;
+        break;
+      }
+      if (slotUsed[i] < slotUsed[victim]) {
+        victim = i;
+      }
+    }
+    copyFrame(0, slotAddr(victim));
+    slotKey[victim] = key;
+    slotUsed[victim] = ++useCounter;
+  }
+
+  // Forget every cached frame, e.g. after the content they were rendered
+  // from has changed.
+  void invalidateCache() {
+    for (uint8_t i = 0; i < numSlots; i++) {
+      slotUsed[i] = 0;
+    }
+  }
+
+  // Drive the panel with the framebuffer if it differs from what is shown.
+  // Returns false if the refresh was skipped.
+  bool refresh() {
+    if (haveShadow) {
+      if (shadowValid && !diffShadow()) {
+        return false;
+      }
+      if (!shadowValid) {
+        dirty = {0, 0, (int16_t)(this->width() - 1),
+                 (int16_t)(this->height() - 1)};
+      }
+      this->display();
+      copyFrame(0, shadowAddr());
+      shadowValid = true;
+      return true;
+    }
+
+    uint32_t crc = frameCrc();
+    dirty = {0, 0, (int16_t)(this->width() - 1), (int16_t)(this->height() - 1)};
+    if (lastCrcValid && crc == lastCrc) {
+      dirty.x1 = 1;
+      dirty.x2 = 0;
+      return false;
+    }
+    this->display();
+    lastCrc = crc;
+    lastCrcValid = true;
+    return true;
+  }
+
+private:
+  static const uint16_t CHUNK = 64;
+
+  uint32_t shadowAddr() const { return frameSize(); }
+  uint32_t slotAddr(uint8_t slot) const { return frameSize() * (2 + slot); }
+
+  // Frame at SRAM offset 0 is the framebuffer (buffer1 then buffer2).
+  void copyFrame(uint32_t from, uint32_t to) {
+    uint8_t buf[CHUNK];
+    for (uint32_t off = 0; off < frameSize(); off += CHUNK) {
+      uint16_t n = (frameSize() - off < CHUNK) ? frameSize() - off : CHUNK;
+      this->sram.read(this->buffer1_addr + from + off, buf, n);
+      this->sram.write(this->buffer1_addr + to + off, buf, n);
+    }
+  }
+
+  // Compare the framebuffer with the shown copy and compute the bounding box
+  // of the changed pixels. Returns true if anything changed.
+  bool diffShadow() {
+    uint8_t cur[CHUNK], old[CHUNK];
+    uint16_t rows = this->HEIGHT;
+    if (rows % 8 != 0) {
+      rows += 8 - (rows % 8);
+    }
+    int16_t minCol = INT16_MAX, maxCol = -1, minRow = INT16_MAX, maxRow = -1;
+
+    for (uint32_t off = 0; off < frameSize(); off += CHUNK) {
+      uint16_t n = (frameSize() - off < CHUNK) ? frameSize() - off : CHUNK;
+      this->sram.read(this->buffer1_addr + off, cur, n);
+      this->sram.read(this->buffer1_addr + shadowAddr() + off, old, n);
+      if (memcmp(cur, old, n) == 0) {
+        continue;
+      }
+      for (uint16_t i = 0; i < n; i++) {
+        if (cur[i] == old[i]) {
+          continue;
+        }
+        // Same addressing as Adafruit_EPD::drawPixel(): each byte holds 8
+        // rows of one column, columns stored right to left.
+        uint32_t bit = ((off + i) % planeSize()) * 8;
+        int16_t col = this->WIDTH - 1 - bit / rows;
+        int16_t row = bit % rows;
+        minCol = min(minCol, col);
+        maxCol = max(maxCol, col);
+        minRow = min(minRow, row);
+        maxRow = max(maxRow, (int16_t)(row + 7));
+      }
+    }
+
+    // Unrotated panel coordinates (rotation 0).
+    dirty.x1 = minCol;
+    dirty.x2 = maxCol;
+    dirty.y1 = minRow;
+    dirty.y2 = min(maxRow, (int16_t)(this->HEIGHT - 1));
+    return maxCol >= 0;
+  }
+
+  uint32_t frameCrc() {
+    uint8_t buf[CHUNK];
+    uint32_t crc = 0xFFFFFFFF;
+    for (uint32_t off = 0; off < frameSize(); off += CHUNK) {
+      uint16_t n = (frameSize() - off < CHUNK) ? frameSize() - off : CHUNK;
+      if (this->use_sram) {
+        this->sram.read(this->buffer1_addr + off, buf, n);
+      } else {
+        // buffer2 directly follows buffer1 in the frame, but not in RAM.
+        for (uint16_t i = 0; i < n; i++) {
+          uint32_t at = off + i;
+          buf[i] = at < this->buffer1_size ? this->buffer1[at]
+                                            : this->buffer2[at - this->buffer1_size];
+        }
+      }
+      for (uint16_t i = 0; i < n; i++) {
+        crc ^= buf[i];
+        for (uint8_t b = 0; b < 8; b++) {
+          crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+        }
+      }
+    }
+    return ~crc;
+  }
+
+  bool haveShadow = false;
+  bool shadowValid = false;
+  bool lastCrcValid = false;
+  uint32_t lastCrc = 0;
+  uint8_t numSlots = 0;
+  uint32_t slotKey[FRAME_CACHE_MAX_SLOTS];
+  uint32_t slotUsed[FRAME_CACHE_MAX_SLOTS]; // 0 = empty, else last use
+  uint32_t useCounter = 0;
+  DirtyRect dirty = {1, 0, 0, 0};
+};
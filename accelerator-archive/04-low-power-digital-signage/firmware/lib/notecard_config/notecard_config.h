@@ -24,6 +24,16 @@ extern Notecard notecard;
 #pragma message "PRODUCT_UID is not defined in this example. Please ensure your Notecard has a product identifier set before running this example or define it in code here. More details at https://dev.blues.io/tools-and-sdks/samples/product-uid"
 #endif
 
+// Tune for a long-running app that doesn't need to make
+// immediate display updates.
+void addPeriodicHubSettings(J *req) {
+  JAddStringToObject(req, "mode", "periodic");
+  JAddBoolToObject(req, "align", true);
+  JAddNumberToObject(req, "inbound", 60); // Once an hour
+  // Voltage-variable outbound settings based on battery life
+  JAddStringToObject(req, "voutbound", "usb:60;high:1440;normal:1440;low:10080;0");
+}
+
 void configureNotecard() {
   J *req = notecard.newRequest("hub.set");
   if (req != NULL) {
@@ -32,13 +42,7 @@ void configureNotecard() {
     JAddStringToObject(req, "mode", "continuous");
     JAddBoolToObject(req, "sync", true);
   #else
-    // Tune for a long-running app that doesn't need to make
-    // immediate display updates.
-    JAddStringToObject(req, "mode", "periodic");
-    JAddBoolToObject(req, "align", true);
-    JAddNumberToObject(req, "inbound", 60); // Once an hour
-    // Voltage-variable outbound settings based on battery life
-    JAddStringToObject(req, "voutbound", "usb:60;high:1440;normal:1440;low:10080;0");
+    addPeriodicHubSettings(req);
   #endif
     notecard.sendRequest(req);
   }
@@ -72,4 +76,22 @@ void configureNotecard() {
     JAddBoolToObject(req, "stop", true);
     notecard.sendRequest(req);
   }
-}
\ No newline at end of file
+}
+
+// Asset downloads use web.get, which needs a live connection to Notehub. In
+// periodic mode, stay connected only while assets are downloading.
+void configureAssetDownload(bool downloading) {
+#ifndef DEMO_MODE
+  J *req = notecard.newRequest("hub.set");
+  if (req != NULL) {
+    if (downloading) {
+      JAddStringToObject(req, "mode", "continuous");
+    } else {
+      addPeriodicHubSettings(req);
+    }
+    notecard.sendRequest(req);
+  }
+#else
+  (void)downloading;
+#endif
+}
@@ -17,7 +17,9 @@
 #include "Adafruit_ThinkInk.h"
 #include <SdFat.h>
 #include <Adafruit_ImageReader_EPD.h>
+#include "asset_cache.h"
 #include "display_manager.h"
+#include "frame_cache.h"
 #include "notecard_config.h"
 
 #define EPD_DC      10
@@ -35,12 +37,16 @@
 
 Notecard notecard;
 
-// 2.13" Tricolor EPD with IL0373 chipset
-ThinkInk_213_Tricolor_RW display(EPD_DC, EPD_RESET, EPD_CS, SRAM_CS, EPD_BUSY);
+// 2.13" Tricolor EPD with SSD1680 chipset. FrameCachedEPD keeps the shown
+// frame and recently rendered frames in the display's SRAM.
+FrameCachedEPD<ThinkInk_213_Tricolor_RW> display(EPD_DC, EPD_RESET, EPD_CS,
+                                                 SRAM_CS, EPD_BUSY);
 
 bool usingSD = false;
 SdFat SD;
 Adafruit_ImageReader_EPD reader(SD);
+AssetCache assets(notecard, SD);
+static bool downloadingAssets = false;
 
 // Variables for Env Var polling
 static unsigned long nextPollMs = 0;
@@ -56,7 +62,11 @@ void fetchEnvironmentVariables(applicationState&);
 bool pollEnvVars(void);
 void rotateContent(void);
 void enumerateSDFiles();
-void displayImage(String);
+void queueAssets(void);
+void downloadAssets(void);
+bool showItem(const char *);
+bool displayImage(String);
+bool loadEpdImage(const char *);
 void displayText(const String&);
 void sendNotifyNote(J *);
 
@@ -74,11 +84,17 @@ void setup() {
   notecard.begin();
 
   display.begin(THINKINK_TRICOLOR);
+  display.beginCache();
+  serialDebugOut.print("Frame cache slots: ");
+  serialDebugOut.println(display.cacheSlots());
 
   if(!SD.begin(SD_CS, SD_SCK_MHZ(10))) {
     serialDebugOut.println("SD begin() failed");
   } else {
     usingSD = true;
+    if (!assets.begin()) {
+      serialDebugOut.println("Unable to open the " ASSET_DIR " directory");
+    }
   }
 
   // Notecard configuration for low-power operation
@@ -110,12 +126,18 @@ void loop() {
         sendNotifyNote(body);
       }
 
+      // Frames rendered before the update may show content that has since
+      // changed, so draw everything again.
+      display.invalidateCache();
+      queueAssets();
       rotateContent();
 
       state.variablesUpdated = false;
     }
   }
 
+  downloadAssets();
+
   if (millis() < nextDisplayRotation) {
     return;
   }
@@ -147,25 +169,144 @@ void rotateContent() {
 
     J *item = JGetArrayItem(itemsToDisplay, state.currentDisplayObjectIndex);
 
-    // If the string contains a ".bmp" it's an image to display.
-    // Otherwise, assume it's text.
-    if (strstr(item->valuestring, ".bmp") != NULL) {
+    // An asset that hasn't finished downloading leaves a single item to be
+    // shown again at the next rotation.
+    state.displayUpdated = showItem(item->valuestring);
+    state.currentDisplayObjectIndex++;
+  }
+}
+
+// Images are ".bmp" files or pre-decoded ".epd" files (see
+// scripts/bmp2epd.py). Anything else is text.
+bool isImageFile(const char *value) {
+  return strstr(value, ".bmp") != NULL || strstr(value, ".epd") != NULL;
+}
+
+// FNV-1a hash of a display value, used as its key in the frame cache.
+uint32_t frameKey(const char *value) {
+  uint32_t hash = 2166136261UL;
+  while (*value) {
+    hash = (hash ^ (uint8_t)*value++) * 16777619UL;
+  }
+  return hash;
+}
+
+// Render a display value into the framebuffer, reusing the frame rendered for
+// it last time if it's still cached, then refresh the panel only if the
+// frame differs from what it's already showing. Returns false if nothing was
+// rendered.
+bool showItem(const char *value) {
+  const uint32_t key = frameKey(value);
+
+  if (display.restore(key)) {
+    serialDebugOut.print("Displaying cached frame for ");
+    serialDebugOut.println(value);
+  } else {
+    if (AssetCache::isAsset(value)) {
+      // Assets are content-addressed, so the frame key of a downloaded asset
+      // never refers to stale content.
+      char file[48];
+      AssetCache::path(value, file, sizeof(file));
+      if (!usingSD || !assets.has(value)) {
+        serialDebugOut.print("Asset not downloaded yet: ");
+        serialDebugOut.println(value);
+        return false;
+      }
+      serialDebugOut.print("Displaying asset ");
+      serialDebugOut.println(value);
+      if (!displayImage(file)) {
+        return false;
+      }
+    } else if (isImageFile(value)) {
       serialDebugOut.print("Displaying image ");
-      serialDebugOut.println(item->valuestring);
-      displayImage(item->valuestring);
-    } else if (strcmp(item->valuestring, "") != 0) {
+      serialDebugOut.println(value);
+      if (!displayImage(value)) {
+        return false;
+      }
+    } else if (strcmp(value, "") != 0) {
       serialDebugOut.print("Displaying text ");
-      serialDebugOut.println(item->valuestring);
-      displayText(item->valuestring);
+      serialDebugOut.println(value);
+      displayText(value);
     } else {
       // Clear the Display
       serialDebugOut.println("Clearing Display");
       display.clearBuffer();
-      display.display();
     }
+    display.store(key);
+  }
 
-    state.displayUpdated = true;
-    state.currentDisplayObjectIndex++;
+  if (display.refresh()) {
+    const DirtyRect &r = display.lastDirty();
+    serialDebugOut.print("Refreshed display, changed area ");
+    serialDebugOut.print(r.x1);
+    serialDebugOut.print(",");
+    serialDebugOut.print(r.y1);
+    serialDebugOut.print(" - ");
+    serialDebugOut.print(r.x2);
+    serialDebugOut.print(",");
+    serialDebugOut.println(r.y2);
+  } else {
+    serialDebugOut.println("Display content unchanged, skipping refresh");
+  }
+  return true;
+}
+
+// Queue the assets named in display_values that aren't on the SD card yet.
+void queueAssets() {
+  if (!usingSD || state.displayObject == NULL) {
+    return;
+  }
+
+  assets.clearQueue();
+  J *item;
+  JArrayForEach(item, state.displayObject->child) {
+    assets.want(item->valuestring);
+  }
+}
+
+// Download the next chunk of a queued asset, one per pass through loop() so
+// the display keeps rotating during a long download.
+void downloadAssets() {
+  if (assets.busy() != downloadingAssets) {
+    downloadingAssets = assets.busy();
+    configureAssetDownload(downloadingAssets);
+  }
+  if (!downloadingAssets) {
+    return;
+  }
+
+  AssetStatus status = assets.poll();
+  if (status != ASSET_DONE && status != ASSET_FAILED) {
+    return;
+  }
+
+  J *body = JCreateObject();
+  if (body != NULL)
+  {
+    if (status == ASSET_DONE) {
+      serialDebugOut.print("Downloaded asset ");
+      serialDebugOut.println(assets.currentId());
+      JAddStringToObject(body, "message", "asset downloaded.");
+    } else {
+      serialDebugOut.print("Unable to download asset ");
+      serialDebugOut.print(assets.currentId());
+      serialDebugOut.print(": ");
+      serialDebugOut.println(assets.lastError());
+      JAddStringToObject(body, "message", "unable to download asset.");
+      JAddStringToObject(body, "error", assets.lastError());
+    }
+    JAddStringToObject(body, "asset", assets.currentId());
+    JAddStringToObject(body, "app", "nf4");
+
+    sendNotifyNote(body);
+  }
+
+  // Show a single-item display as soon as its asset arrives, rather than
+  // after the next rotation interval.
+  if (status == ASSET_DONE && !state.displayUpdated &&
+      JGetArraySize(state.displayObject->child) == 1) {
+    state.currentDisplayObjectIndex = 0;
+    rotateContent();
   }
 }
 
@@ -176,6 +317,7 @@ void fetchEnvironmentVariables(applicationState& state) {
   J *names = JAddArrayToObject(req, "names");
   JAddItemToArray(names, JCreateString("display_interval_sec"));
   JAddItemToArray(names, JCreateString("display_values"));
+  JAddItemToArray(names, JCreateString("asset_route"));
 
   J *rsp = notecard.requestAndResponse(req);
   if (rsp != NULL) {
@@ -196,6 +338,8 @@ void fetchEnvironmentVariables(applicationState& state) {
             displayUpdateInterval = vars.displayIntervalSec;
           }
 
+          assets.setRoute(JGetString(body, "asset_route"));
+
           char *displayValues = JGetString(body, "display_values");
           if (strcmp(vars.displayValues.c_str(), displayValues) != 0) {
             vars.displayValues = String(displayValues);
@@ -315,18 +459,76 @@ void displayText(const String& val) {
 
     segment = strtok(NULL, " ");
   }
+}
 
-  display.display();
+// Load a pre-decoded image straight into the framebuffer. Returns false if
+// the file is missing or doesn't match the panel.
+bool loadEpdImage(const char *file) {
+  File img;
+  EpdImageHeader hdr;
+
+  if (!img.open(file, O_RDONLY)) {
+    return false;
+  }
+
+  if (img.read(&hdr, sizeof(hdr)) != sizeof(hdr) ||
+      memcmp(hdr.magic, EPD_IMAGE_MAGIC, 4) != 0 ||
+      hdr.width != display.width() || hdr.height != display.height() ||
+      hdr.planes < 1 || hdr.planes > 2 ||
+      hdr.planeSize != display.planeSize()) {
+    serialDebugOut.println("Image header doesn't match this display.");
+    img.close();
+    return false;
+  }
+
+  // A one-plane image leaves the color plane clear.
+  display.clearBuffer();
+
+  uint8_t buf[128];
+  for (uint8_t plane = 0; plane < hdr.planes; plane++) {
+    for (uint32_t offset = 0; offset < hdr.planeSize; offset += sizeof(buf)) {
+      uint16_t len = min((uint32_t)sizeof(buf), hdr.planeSize - offset);
+      if (img.read(buf, len) != len) {
+        serialDebugOut.println("Image file is truncated.");
+        img.close();
+        return false;
+      }
+      display.writePlane(plane, offset, buf, len);
+    }
+  }
+
+  img.close();
+  return true;
 }
 
-void displayImage(String fileName) {
+// Render an image from the SD card into the framebuffer. Returns false if
+// nothing was rendered.
+bool displayImage(String fileName) {
   Adafruit_Image_EPD img;
   int32_t width  = 0, height = 0;
   ImageReturnCode ret;
   const char *file = fileName.c_str();
 
   if (!usingSD) {
-    return;
+    return false;
+  }
+
+  if (strstr(file, ".epd") != NULL) {
+    if (loadEpdImage(file)) {
+      return true;
+    }
+
+    serialDebugOut.println("Unable to load image.");
+    J *body = JCreateObject();
+    if (body != NULL)
+    {
+      JAddStringToObject(body, "message", "unable to load image.");
+      JAddStringToObject(body, "file", file);
+      JAddStringToObject(body, "app", "nf4");
+
+      sendNotifyNote(body);
+    }
+    return false;
   }
 
   serialDebugOut.print("Querying image size...");
@@ -356,7 +558,21 @@ void displayImage(String fileName) {
     serialDebugOut.print(F("Loading image to canvas..."));
     ret = reader.drawBMP((char *)file, display, 0, 0);
     reader.printStatus(ret);
-    display.display();
+    if (ret == IMAGE_SUCCESS) {
+      return true;
+    }
+
+    // A partly drawn frame must not be cached or shown.
+    J *body = JCreateObject();
+    if (body != NULL)
+    {
+      JAddStringToObject(body, "message", "unable to load image.");
+      JAddStringToObject(body, "file", file);
+      JAddStringToObject(body, "app", "nf4");
+
+      sendNotifyNote(body);
+    }
+    return false;
   } else {
     serialDebugOut.println("Image not found.");
     J *body = JCreateObject();
@@ -368,6 +584,7 @@ void displayImage(String fileName) {
 
         sendNotifyNote(body);
       }
+    return false;
   }
 }
 
@@ -375,6 +592,10 @@ void enumerateSDFiles() {
   File dir;
   File file;
 
+  // The card's files may differ from the ones the cached frames were drawn
+  // from.
+  display.invalidateCache();
+
   if (!dir.open("/")){
     serialDebugOut.println("dir.open failed");
   }
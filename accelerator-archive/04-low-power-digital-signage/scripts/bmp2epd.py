@@ -0,0 +1,132 @@
+#!/usr/bin/env python3
+"""Convert a BMP to a pre-decoded .epd image for the digital signage firmware.
+
+The firmware copies an .epd file's planes straight into the display's
+framebuffer, so the image is shown without decoding the BMP on the device.
+The planes are written in the SSD1680 driver's framebuffer layout for the
+2.13" tricolor FeatherWing (250x122):
+
+  plane 0  black, 1 bit per pixel, 0 = black
+  plane 1  red,   1 bit per pixel, 1 = red (omitted with --mono)
+
+Each pixel is mapped to the nearest of white, black and red (or to black or
+white by brightness with --mono), so start from an image already reduced to
+the panel's palette (see assets/eink-palettes) for the best result.
+
+Usage:
+  ./bmp2epd.py logo.bmp                # writes logo.epd
+  ./bmp2epd.py logo.bmp -o logo.epd --mono
+
+Only the Python standard library is required.
+"""
+
+import argparse
+import os
+import struct
+import sys
+
+MAGIC = b"EPD1"
+PANEL_WIDTH = 250
+PANEL_HEIGHT = 122
+
+WHITE, BLACK, RED = 0, 1, 2
+PALETTE = ((WHITE, (255, 255, 255)), (BLACK, (0, 0, 0)), (RED, (255, 0, 0)))
+
+
+def read_bmp(path):
+    """Return (width, height, rows) with rows[y][x] = (r, g, b), top row first."""
+    with open(path, "rb") as f:
+        data = f.read()
+    if data[:2] != b"BM":
+        raise ValueError("not a BMP file")
+    offset = struct.unpack_from("<I", data, 10)[0]
+    header_size, width, height, _, bpp, compression = struct.unpack_from(
+        "<IiiHHI", data, 14)
+    if compression not in (0, 3):
+        raise ValueError("compressed BMPs are not supported")
+    if bpp not in (1, 4, 8, 24, 32):
+        raise ValueError("unsupported bit depth %d" % bpp)
+
+    palette = []
+    if bpp <= 8:
+        count = struct.unpack_from("<I", data, 46)[0] or (1 << bpp)
+        base = 14 + header_size
+        for i in range(count):
+            b, g, r = data[base + 4 * i:base + 4 * i + 3]
+            palette.append((r, g, b))
+
+    top_down = height < 0
+    height = abs(height)
+    stride = ((width * bpp + 31) // 32) * 4
+    rows = []
+    for row in range(height):
+        src = offset + stride * (row if top_down else height - 1 - row)
+        pixels = []
+        for x in range(width):
+            if bpp >= 24:
+                b, g, r = data[src + x * (bpp // 8):src + x * (bpp // 8) + 3]
+                pixels.append((r, g, b))
+            else:
+                bit = x * bpp
+                index = (data[src + bit // 8] >> (8 - bpp - bit % 8)) & \
+                    ((1 << bpp) - 1)
+                pixels.append(palette[index])
+        rows.append(pixels)
+    return width, height, rows
+
+
+def classify(rgb, mono):
+    r, g, b = rgb
+    if mono:
+        return BLACK if (r * 299 + g * 587 + b * 114) < 128000 else WHITE
+    return min(PALETTE, key=lambda p: sum((a - c) ** 2
+                                          for a, c in zip(rgb, p[1])))[0]
+
+
+def encode(width, height, rows, mono):
+    # Same addressing as Adafruit_EPD::drawPixel() at rotation 0: each byte
+    # holds 8 rows of one column, columns stored right to left.
+    rows8 = (height + 7) // 8 * 8
+    plane_size = width * rows8 // 8
+    black = bytearray(b"\xff" * plane_size)
+    red = bytearray(plane_size)
+    for y in range(height):
+        for x in range(width):
+            color = classify(rows[y][x], mono)
+            addr = ((width - 1 - x) * rows8 + y) // 8
+            mask = 1 << (7 - y % 8)
+            if color == BLACK:
+                black[addr] &= ~mask & 0xFF
+            elif color == RED:
+                red[addr] |= mask
+    planes = [black] if mono else [black, red]
+    header = struct.pack("<4sHHBBHI", MAGIC, width, height, len(planes), 0, 0,
+                         plane_size)
+    return header + b"".join(planes)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("bmp")
+    parser.add_argument("-o", "--output",
+                        help="output file (default: BMP name with .epd)")
+    parser.add_argument("--mono", action="store_true",
+                        help="black and white only (one plane)")
+    args = parser.parse_args()
+
+    try:
+        width, height, rows = read_bmp(args.bmp)
+    except (OSError, ValueError, struct.error) as e:
+        sys.exit("%s: %s" % (args.bmp, e))
+    if (width, height) != (PANEL_WIDTH, PANEL_HEIGHT):
+        sys.exit("%s: image is %dx%d, the display is %dx%d" %
+                 (args.bmp, width, height, PANEL_WIDTH, PANEL_HEIGHT))
+
+    out = args.output or os.path.splitext(args.bmp)[0] + ".epd"
+    with open(out, "wb") as f:
+        f.write(encode(width, height, rows, args.mono))
+    print("wrote %s" % out)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,120 @@
+#!/usr/bin/env python3
+"""Package an image as a content-addressed asset for the digital signage.
+
+The firmware downloads assets named "asset:<id>" in display_values over
+web.get, in chunks, from a Notehub proxy route (signage_assets by default,
+see the asset_route env var). This script writes the files that route
+serves:
+
+  <out>/<id>/0.json, <out>/<id>/1.json, ...
+
+where <id> is the first 16 hex digits of the image's SHA-256. Each file is
+
+  {"chunks": N, "size": S, "sha256": "<64 hex>", "data": "<base64>"}
+
+with the .epd image PackBits-compressed and split into --chunk-size byte
+pieces. Upload <out> to any static web host (S3, GitHub Pages, nginx...) and
+point the route's URL at it. Devices that already have an asset never fetch
+it again, and a device only shows an asset once every chunk has arrived and
+the SHA-256 checks out.
+
+Usage:
+  ./push-asset.py logo.bmp               # converts with bmp2epd.py
+  ./push-asset.py logo.epd -o site/ --mono
+
+Only the Python standard library is required.
+"""
+
+import argparse
+import base64
+import hashlib
+import json
+import os
+import struct
+import sys
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+bmp2epd = __import__("bmp2epd")
+
+ID_LEN = 16
+
+
+def packbits(data):
+    """PackBits (as in TIFF): runs of 3+ equal bytes become a repeat."""
+    out = bytearray()
+    i = 0
+    n = len(data)
+    while i < n:
+        run = 1
+        while i + run < n and run < 128 and data[i + run] == data[i]:
+            run += 1
+        if run >= 3:
+            out += bytes((257 - run, data[i]))
+            i += run
+            continue
+        start = i
+        while i < n and i - start < 128:
+            if i + 2 < n and data[i] == data[i + 1] == data[i + 2]:
+                break
+            i += 1
+        out.append(i - start - 1)
+        out += data[start:i]
+    return bytes(out)
+
+
+def load_epd(path, mono):
+    if path.lower().endswith(".epd"):
+        with open(path, "rb") as f:
+            data = f.read()
+        if data[:4] != bmp2epd.MAGIC:
+            raise ValueError("not an .epd file")
+        return data
+    width, height, rows = bmp2epd.read_bmp(path)
+    if (width, height) != (bmp2epd.PANEL_WIDTH, bmp2epd.PANEL_HEIGHT):
+        raise ValueError("image is %dx%d, the display is %dx%d" %
+                         (width, height, bmp2epd.PANEL_WIDTH,
+                          bmp2epd.PANEL_HEIGHT))
+    return bmp2epd.encode(width, height, rows, mono)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("image", help=".bmp or .epd file")
+    parser.add_argument("-o", "--output", default="assets-site",
+                        help="directory to write the chunk files to "
+                             "(default: assets-site)")
+    parser.add_argument("--mono", action="store_true",
+                        help="convert a BMP to black and white only")
+    parser.add_argument("--chunk-size", type=int, default=2048,
+                        help="compressed bytes per chunk (default: 2048, "
+                             "at most 3072)")
+    args = parser.parse_args()
+
+    if not 0 < args.chunk_size <= 3072:
+        sys.exit("--chunk-size must be between 1 and 3072")
+
+    try:
+        epd = load_epd(args.image, args.mono)
+    except (OSError, ValueError, struct.error) as e:
+        sys.exit("%s: %s" % (args.image, e))
+
+    sha = hashlib.sha256(epd).hexdigest()
+    asset_id = sha[:ID_LEN]
+    packed = packbits(epd)
+    pieces = [packed[i:i + args.chunk_size]
+              for i in range(0, len(packed), args.chunk_size)]
+
+    folder = os.path.join(args.output, asset_id)
+    os.makedirs(folder, exist_ok=True)
+    for n, piece in enumerate(pieces):
+        with open(os.path.join(folder, "%d.json" % n), "w") as f:
+            json.dump({"chunks": len(pieces), "size": len(epd), "sha256": sha,
+                       "data": base64.b64encode(piece).decode("ascii")}, f)
+
+    print("wrote %d chunks to %s (%d bytes, %d compressed)" %
+          (len(pieces), folder, len(epd), len(packed)))
+    print("add to display_values: asset:%s" % asset_id)
+
+
+if __name__ == "__main__":
+    main()
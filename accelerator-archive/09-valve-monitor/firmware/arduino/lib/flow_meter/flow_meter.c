@@ -0,0 +1,130 @@
+//
+// Copyright 2022 Blues Inc.  All rights reserved.
+// Use of this source code is governed by licenses granted by the
+// copyright holder including that found in the LICENSE file.
+//
+
+#include "flow_meter.h"
+
+#include <string.h>
+
+void flowMeterInit(FlowMeter *fm, float mlPerPulse, double totalMl,
+    uint16_t count, uint32_t nowUs)
+{
+    memset(fm, 0, sizeof(*fm));
+    fm->mlPerPulse = mlPerPulse;
+    fm->baseMl = totalMl;
+    fm->lastCount = count;
+    fm->lastUs = nowUs;
+    // Nothing is flowing yet, so start out timing pulses: the first pulses of
+    // a slow leak are too far apart to count over a single interval.
+    fm->reciprocal = true;
+}
+
+// Counting mode: pulses per calculation interval. Accurate to one pulse per
+// interval, which is fine once there are tens of pulses in each one.
+static void updateCounting(FlowMeter *fm, uint16_t pulses, float countHz,
+    uint32_t nowUs)
+{
+    fm->hz = countHz;
+    if (pulses > 0) {
+        fm->periodUs = (uint32_t)(1e6f / countHz);
+        // Close enough to the last pulse for the overdue check after a switch
+        // to reciprocal mode.
+        fm->edgeUs = nowUs;
+    }
+
+    if (countHz < FLOW_METER_RECIPROCAL_HZ) {
+        // The caller enables the capture interrupt from the next interval, so
+        // there is no edge to measure from yet.
+        fm->reciprocal = true;
+        fm->haveEdge = false;
+        fm->edgeStale = false;
+    }
+}
+
+// Reciprocal mode: the rate is the average over the span between the latest
+// two timestamped edges, however many intervals (and pulses) that covers.
+static void updateReciprocal(FlowMeter *fm, const FlowSample *sample,
+    uint32_t nowUs)
+{
+    const bool newEdge = sample->edgeValid &&
+        (!fm->haveEdge || sample->edgeCount != fm->edgeCount);
+
+    if (newEdge) {
+        if (fm->haveEdge && !fm->edgeStale) {
+            const uint16_t pulses = (uint16_t)(sample->edgeCount -
+                fm->edgeCount);
+            const uint32_t spanUs = sample->edgeUs - fm->edgeUs;
+            if (spanUs > 0 && spanUs <= FLOW_METER_IDLE_US) {
+                fm->hz = pulses * 1e6f / spanUs;
+                fm->periodUs = spanUs / pulses;
+            }
+            else {
+                fm->hz = 0;
+            }
+        }
+        // Otherwise this is the first edge of a run: keep the current rate,
+        // which is 0 or the last counting-mode rate, until a second one.
+        fm->edgeCount = sample->edgeCount;
+        fm->edgeUs = sample->edgeUs;
+        fm->haveEdge = true;
+        fm->edgeStale = false;
+        return;
+    }
+
+    const uint32_t elapsedUs = nowUs - fm->edgeUs;
+    if (fm->hz > 0) {
+        if (elapsedUs > FLOW_METER_IDLE_US || (fm->periodUs > 0 &&
+            elapsedUs > FLOW_METER_OVERDUE_PERIODS * fm->periodUs)) {
+            // The run has ended. The next edge starts a new one rather than
+            // averaging across the gap.
+            fm->hz = 0;
+            fm->edgeStale = true;
+        }
+        else if (elapsedUs > fm->periodUs) {
+            // Late, but not yet overdue: the flow is at most one pulse per
+            // elapsed time.
+            fm->hz = 1e6f / elapsedUs;
+        }
+    }
+    else if (fm->haveEdge && elapsedUs > FLOW_METER_IDLE_US) {
+        // A lone pulse with nothing after it. Mark it stale before
+        // elapsedUs can wrap.
+        fm->edgeStale = true;
+    }
+}
+
+void flowMeterUpdate(FlowMeter *fm, const FlowSample *sample, uint32_t nowUs)
+{
+    const uint16_t pulses = (uint16_t)(sample->count - fm->lastCount);
+    const uint32_t intervalUs = nowUs - fm->lastUs;
+    const float countHz = intervalUs > 0 ? pulses * 1e6f / intervalUs : 0;
+
+    fm->lastCount = sample->count;
+    fm->lastUs = nowUs;
+    fm->totalPulses += pulses;
+
+    if (!fm->reciprocal) {
+        updateCounting(fm, pulses, countHz, nowUs);
+    }
+    else if (countHz > 2 * FLOW_METER_RECIPROCAL_HZ) {
+        // Fast enough to count again; the caller disables the capture
+        // interrupt.
+        fm->reciprocal = false;
+        updateCounting(fm, pulses, countHz, nowUs);
+    }
+    else {
+        updateReciprocal(fm, sample, nowUs);
+    }
+}
+
+float flowMeterRate(const FlowMeter *fm)
+{
+    return fm->hz * 60 * fm->mlPerPulse;
+}
+
+double flowMeterTotalMl(const FlowMeter *fm)
+{
+    return fm->baseMl + (double)fm->totalPulses * fm->mlPerPulse;
+}
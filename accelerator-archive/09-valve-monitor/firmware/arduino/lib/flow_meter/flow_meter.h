@@ -0,0 +1,91 @@
+//
+// Copyright 2022 Blues Inc.  All rights reserved.
+// Use of this source code is governed by licenses granted by the
+// copyright holder including that found in the LICENSE file.
+//
+
+#ifndef FLOW_METER_H
+#define FLOW_METER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Below this pulse rate (pulses/s) the meter switches from counting pulses over
+// the calculation interval to timing the interval between pulses. It switches
+// back above twice this rate, so edge timestamps are only ever taken at a few
+// tens of interrupts per second.
+#ifndef FLOW_METER_RECIPROCAL_HZ
+#define FLOW_METER_RECIPROCAL_HZ 20
+#endif
+
+// A run of pulses ends when the next pulse is this many measured periods late.
+// The reported rate then drops to 0, which is what lets the leak filter tell a
+// spinner slowing down from a steady drip.
+#ifndef FLOW_METER_OVERDUE_PERIODS
+#define FLOW_METER_OVERDUE_PERIODS 2
+#endif
+
+// Pulses further apart than this are not treated as flow at all. This is the
+// slowest flow the meter reports (1 pulse per minute).
+#ifndef FLOW_METER_IDLE_US
+#define FLOW_METER_IDLE_US (60UL * 1000 * 1000)
+#endif
+
+// A snapshot of the hardware pulse counter, taken once per calculation
+// interval.
+typedef struct {
+    // Free-running pulse count. Only differences are used, so it may wrap.
+    uint16_t count;
+    // Count and time (in microseconds) of the latest edge timestamped by the
+    // capture interrupt. edgeValid is false while that interrupt is disabled.
+    uint16_t edgeCount;
+    uint32_t edgeUs;
+    bool edgeValid;
+} FlowSample;
+
+typedef struct {
+    float mlPerPulse;
+    // Volume carried over from before the last reset, in mL.
+    double baseMl;
+    uint64_t totalPulses;
+    float hz;
+    uint32_t lastUs;
+    // Measured pulse period, used to decide when the next pulse is overdue.
+    uint32_t periodUs;
+    // Latest edge already used in a reciprocal measurement.
+    uint32_t edgeUs;
+    uint16_t edgeCount;
+    bool haveEdge;
+    // The latest edge ended a run, so no span is measured from it.
+    bool edgeStale;
+    uint16_t lastCount;
+    bool reciprocal;
+} FlowMeter;
+
+// Start measuring from the counter's current value. totalMl is the volume
+// already totalized, e.g. restored from flash.
+void flowMeterInit(FlowMeter *fm, float mlPerPulse, double totalMl,
+    uint16_t count, uint32_t nowUs);
+// Update the rate and total from a new counter snapshot.
+void flowMeterUpdate(FlowMeter *fm, const FlowSample *sample, uint32_t nowUs);
+// Flow rate in mL/min.
+float flowMeterRate(const FlowMeter *fm);
+// Total volume in mL.
+double flowMeterTotalMl(const FlowMeter *fm);
+
+// True while the meter wants edge timestamps, i.e. while the caller should
+// keep the capture interrupt enabled.
+static inline bool flowMeterReciprocal(const FlowMeter *fm)
+{
+    return fm->reciprocal;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FLOW_METER_H
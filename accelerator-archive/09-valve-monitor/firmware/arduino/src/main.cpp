@@ -6,13 +6,18 @@
 
 #include <Notecard.h>
 #include <Wire.h>
+#include <flow_meter.h>
 
 // This is the GPIO pin that will be connected to the Notecard's ATTN pin.
 #define ATTN_INPUT_PIN  PA5
 // This is the GPIO pin that will open the valve.
 #define VALVE_OPEN_PIN  PA4
-// This is the GPIO that will be connected to the flow rate meter.
+// This is the GPIO that will be connected to the flow rate meter. PE9 is
+// TIM1_CH1, so the meter's pulses can clock TIM1 directly.
 #define FLOW_RATE_METER_PIN PE9
+#define FLOW_RATE_METER_TIMER TIM1
+// Volume of liquid per flow meter pulse, in mL.
+#define FLOW_ML_PER_PULSE 2.25f
 
 // Don't keep valve open for longer than 10 minutes to prevent overheating of
 // its solenoid.
@@ -26,6 +31,11 @@
 // too small, its possible we won't have enough sensor data (i.e. pulses) to
 // produce an accurate flow rate measurement.
 #define FLOW_CALC_INTERVAL_MS 500
+// Save the totalized volume to the Notecard every 5 minutes while it's
+// changing, so it survives a reset or power loss.
+#define FLOW_TOTAL_SAVE_MS (5 * 60 * 1000)
+#define FLOW_TOTAL_FILE "flow_total.dbx"
+#define FLOW_TOTAL_NOTE "total"
 
 #define LEAK_THRESHOLD 6
 
@@ -53,11 +63,14 @@ struct AppState {
     uint32_t monitorLastUpdateMs;
     uint32_t lastFlowRateCalcMs;
     uint32_t valveOpenedMs;
-    uint32_t flowLastPulseMs;
     uint32_t lastAlarmMs;
     uint32_t envLastModTime;
-    volatile uint32_t flowMeterPulseCount;
-    uint32_t flowRate;
+    uint32_t lastFlowTotalSaveMs;
+    double savedFlowTotalMl;
+    volatile uint32_t flowEdgeUs;
+    volatile uint16_t flowEdgeCount;
+    volatile bool flowEdgeValid;
+    float flowRate;
     uint32_t flowRateAlarmMin;
     uint32_t flowRateAlarmMax;
     uint32_t leakCount;
@@ -68,6 +81,8 @@ struct AppState {
 
 AppState state = {0};
 Notecard notecard;
+HardwareTimer *flowTimer;
+FlowMeter flowMeter;
 
 void attnISR()
 {
@@ -76,9 +91,119 @@ void attnISR()
     state.attnTriggered = true;
 }
 
-void flowMeterISR()
+// Only enabled while the flow is slow enough to time individual pulses (see
+// FLOW_METER_RECIPROCAL_HZ), so this runs at most a few tens of times a
+// second. At higher rates the pulses are counted by TIM1 alone.
+void flowEdgeISR()
 {
-    ++state.flowMeterPulseCount;
+    state.flowEdgeCount = flowTimer->getCaptureCompare(1);
+    state.flowEdgeUs = micros();
+    state.flowEdgeValid = true;
+}
+
+// Count flow meter pulses in hardware: TIM1 runs in external clock mode 1,
+// clocked by the falling edges on its CH1 input, so the count costs no CPU
+// time. CH1 also captures the count at each edge for flowEdgeISR.
+void flowCounterInit()
+{
+    flowTimer = new HardwareTimer(FLOW_RATE_METER_TIMER);
+    flowTimer->setMode(1, TIMER_INPUT_CAPTURE_FALLING, FLOW_RATE_METER_PIN);
+    flowTimer->setPrescaleFactor(1);
+    flowTimer->setOverflow(0x10000);
+    flowTimer->attachInterrupt(1, flowEdgeISR);
+    flowTimer->resume();
+
+    // setMode() leaves the pin floating; the meter's output needs a pull-up.
+    PinName pin = digitalPinToPinName(FLOW_RATE_METER_PIN);
+    LL_GPIO_SetPinPull(get_GPIO_Port(STM_PORT(pin)), STM_LL_GPIO_PIN(pin),
+        LL_GPIO_PULL_UP);
+
+    // Switch the counter from the APB clock to TI1FP1 (CH1 after the input
+    // filter and polarity set by setMode()). The filter ignores glitches
+    // shorter than 8 timer clocks.
+    LL_TIM_IC_SetFilter(FLOW_RATE_METER_TIMER, LL_TIM_CHANNEL_CH1,
+        LL_TIM_IC_FILTER_FDIV1_N8);
+    LL_TIM_SetTriggerInput(FLOW_RATE_METER_TIMER, LL_TIM_TS_TI1FP1);
+    LL_TIM_SetClockSource(FLOW_RATE_METER_TIMER,
+        LL_TIM_CLOCKSOURCE_EXT_MODE1);
+    LL_TIM_SetCounter(FLOW_RATE_METER_TIMER, 0);
+}
+
+// Enable or disable flowEdgeISR.
+void flowEdgeCapture(bool enable)
+{
+    if (enable) {
+        LL_TIM_ClearFlag_CC1(FLOW_RATE_METER_TIMER);
+        LL_TIM_EnableIT_CC1(FLOW_RATE_METER_TIMER);
+    }
+    else {
+        LL_TIM_DisableIT_CC1(FLOW_RATE_METER_TIMER);
+        state.flowEdgeValid = false;
+    }
+}
+
+// Restore the totalized volume saved by saveFlowTotal(). Returns 0 if there's
+// nothing saved yet.
+double loadFlowTotal()
+{
+    double totalMl = 0;
+
+    J *req = notecard.newRequest("note.get");
+    JAddStringToObject(req, "file", FLOW_TOTAL_FILE);
+    JAddStringToObject(req, "note", FLOW_TOTAL_NOTE);
+    J *rsp = notecard.requestAndResponse(req);
+    if (rsp != NULL) {
+        // An error here is expected on first boot, before anything's been
+        // saved.
+        if (!notecard.responseError(rsp)) {
+            J *body = JGetObject(rsp, "body");
+            if (body != NULL) {
+                totalMl = JGetNumber(body, "total_ml");
+            }
+        }
+        notecard.deleteResponse(rsp);
+    }
+    else {
+        notecard.logDebug("NULL response to note.get for flow total.\n");
+    }
+
+    notecard.logDebugf("Restored flow total: %u mL.\n", (uint32_t)totalMl);
+
+    return totalMl;
+}
+
+// Save the totalized volume to the Notecard's flash. note.update fails until
+// the note exists, so fall back to note.add the first time.
+void saveFlowTotal()
+{
+    double totalMl = flowMeterTotalMl(&flowMeter);
+
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        J *req = notecard.newRequest(attempt == 0 ? "note.update" : "note.add");
+        if (req == NULL) {
+            notecard.logDebug("Failed to create request to save flow total."
+                "\n");
+            return;
+        }
+        JAddStringToObject(req, "file", FLOW_TOTAL_FILE);
+        JAddStringToObject(req, "note", FLOW_TOTAL_NOTE);
+        J *body = JAddObjectToObject(req, "body");
+        JAddNumberToObject(body, "total_ml", totalMl);
+
+        J *rsp = notecard.requestAndResponse(req);
+        if (rsp == NULL) {
+            notecard.logDebug("NULL response saving flow total.\n");
+            return;
+        }
+        bool ok = !notecard.responseError(rsp);
+        notecard.deleteResponse(rsp);
+        if (ok) {
+            state.savedFlowTotalMl = totalMl;
+            return;
+        }
+    }
+
+    notecard.logDebug("Failed to save flow total.\n");
 }
 
 // Arm the ATTN interrupt.
@@ -147,10 +272,10 @@ void handleValveCmd(char *cmd)
 }
 #endif // USE_VALVE == 1
 
-// Publish the system status (flow rate, valve state). If alarmReason is not
+// Publish the system status (flow rate, total volume, valve state). If alarmReason is not
 // NULL, attach the reason to the outbound note and send it to alarm.qo.
 // Otherwise, send the note to data.qo.
-void publishSystemStatus(uint32_t flowRate, const char *alarmReason)
+void publishSystemStatus(float flowRate, const char *alarmReason)
 {
     const char *file;
 
@@ -169,6 +294,8 @@ void publishSystemStatus(uint32_t flowRate, const char *alarmReason)
         J *body = JCreateObject();
         if (body != NULL) {
             JAddNumberToObject(body, "flow_rate", flowRate);
+            JAddNumberToObject(body, "total_ml",
+                flowMeterTotalMl(&flowMeter));
 
         #if USE_VALVE == 1
             if (state.valveOpen) {
@@ -397,8 +524,12 @@ void setup()
     state.valveOpen = 1;
 #endif
 
-    pinMode(FLOW_RATE_METER_PIN, INPUT_PULLUP);
-    attachInterrupt(digitalPinToInterrupt(FLOW_RATE_METER_PIN), flowMeterISR, FALLING);
+    flowCounterInit();
+    state.savedFlowTotalMl = loadFlowTotal();
+    flowMeterInit(&flowMeter, FLOW_ML_PER_PULSE, state.savedFlowTotalMl,
+        LL_TIM_GetCounter(FLOW_RATE_METER_TIMER), micros());
+    flowEdgeCapture(flowMeterReciprocal(&flowMeter));
+    state.lastFlowTotalSaveMs = millis();
 
     // Arm the interrupt, so that we are notified whenever ATTN rises
     attnArm();
@@ -416,11 +547,25 @@ void NoteUserAgentUpdate(J *ua) {
 }
 
 
-// Calculate the flow rate in mL/min.
-uint32_t calculateFlowRate(uint32_t currentMs)
+// Sample the pulse counter and update the flow rate (mL/min) and total.
+void calculateFlowRate()
 {
-    return 60000 * (state.flowMeterPulseCount * 2.25) /
-           (currentMs - state.lastFlowRateCalcMs);
+    FlowSample sample;
+
+    noInterrupts();
+    sample.count = LL_TIM_GetCounter(FLOW_RATE_METER_TIMER);
+    sample.edgeCount = state.flowEdgeCount;
+    sample.edgeUs = state.flowEdgeUs;
+    sample.edgeValid = state.flowEdgeValid;
+    interrupts();
+
+    bool reciprocal = flowMeterReciprocal(&flowMeter);
+    flowMeterUpdate(&flowMeter, &sample, micros());
+    state.flowRate = flowMeterRate(&flowMeter);
+
+    if (flowMeterReciprocal(&flowMeter) != reciprocal) {
+        flowEdgeCapture(flowMeterReciprocal(&flowMeter));
+    }
 }
 
 void checkAlarm(float flowRate)
@@ -519,9 +664,8 @@ void loop()
 
     currentMs = millis();
     if (currentMs - state.lastFlowRateCalcMs >= FLOW_CALC_INTERVAL_MS) {
-        state.flowRate = calculateFlowRate(currentMs);
+        calculateFlowRate();
         state.lastFlowRateCalcMs = currentMs;
-        state.flowMeterPulseCount = 0;
 
     #if USE_VALVE == 1
         if (!state.valveOpen) {
@@ -542,6 +686,14 @@ void loop()
     
     checkAlarm(state.flowRate);
 
+    currentMs = millis();
+    if (currentMs - state.lastFlowTotalSaveMs >= FLOW_TOTAL_SAVE_MS) {
+        state.lastFlowTotalSaveMs = currentMs;
+        if (flowMeterTotalMl(&flowMeter) != state.savedFlowTotalMl) {
+            saveFlowTotal();
+        }
+    }
+
     currentMs = millis();
     // If we received a valve command (open or close), we want to publish the
     // system status immediately in response, regardless of if it's time to do
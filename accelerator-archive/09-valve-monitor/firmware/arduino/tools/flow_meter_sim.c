@@ -0,0 +1,297 @@
+// flow_meter_sim.c
+//
+// Host check of the flow meter's rate math. Generates simulated pulse trains,
+// emulates the Swan's TIM1 pulse counter and CC1 edge capture the way
+// src/main.cpp drives them (a 16-bit count sampled every FLOW_CALC_INTERVAL_MS,
+// edge timestamps only while the meter asks for them), feeds the snapshots to
+// lib/flow_meter unchanged and checks:
+//
+//   - steady rates from one pulse per 20 s up to 400 Hz are reported within
+//     tolerance, in both counting and reciprocal mode
+//   - a drip keeps the rate above 0 (so the leak filter sees it), while a
+//     spinner slowing to a stop drops to 0 within a couple of pulse periods
+//   - pulses more than FLOW_METER_IDLE_US apart are not reported as flow
+//   - the totalized volume matches the pulses generated, across counter wraps
+//
+// Build and run (from this directory):
+//   gcc -O2 -I../lib/flow_meter flow_meter_sim.c ../lib/flow_meter/flow_meter.c
+//       -o flow_meter_sim
+//   ./flow_meter_sim [-v]
+//
+// Exits non-zero if any check fails.
+
+#include "flow_meter.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Must match src/main.cpp.
+#define FLOW_CALC_INTERVAL_MS 500
+#define ML_PER_PULSE 2.25f
+#define LEAK_THRESHOLD 6
+
+#define INTERVAL_US (FLOW_CALC_INTERVAL_MS * 1000UL)
+#define MAX_PULSES 400000
+
+static uint64_t pulses[MAX_PULSES];
+static size_t numPulses;
+static bool verbose;
+static int failures;
+
+// Deterministic jitter so runs are repeatable.
+static uint32_t rngState = 12345;
+static double jitter(double frac)
+{
+    rngState = rngState * 1664525u + 1013904223u;
+    return 1.0 + frac * (((rngState >> 8) / (double)(1 << 24)) * 2.0 - 1.0);
+}
+
+static void addTrain(double startSec, double endSec, double hz, double jit)
+{
+    double t = startSec;
+    while (hz > 0 && numPulses < MAX_PULSES) {
+        t += jitter(jit) / hz;
+        if (t >= endSec) {
+            break;
+        }
+        pulses[numPulses++] = (uint64_t)(t * 1e6);
+    }
+}
+
+// Geometric slow-down from startHz, each period `growth` times the last,
+// until the period passes maxPeriodSec. Returns the time of the last pulse.
+static double addSpinDown(double startSec, double startHz, double growth,
+    double maxPeriodSec)
+{
+    double t = startSec;
+    double period = 1.0 / startHz;
+    while (period < maxPeriodSec && numPulses < MAX_PULSES) {
+        t += period;
+        pulses[numPulses++] = (uint64_t)(t * 1e6);
+        period *= growth;
+    }
+    return t;
+}
+
+typedef struct {
+    double atSec;
+    float rate;
+    bool reciprocal;
+} Reading;
+
+static Reading readings[20000];
+static size_t numReadings;
+
+// Replays pulses[] through the emulated timer for durSec seconds.
+static FlowMeter runMeter(double durSec)
+{
+    FlowMeter fm;
+    FlowSample sample;
+    size_t next = 0;
+    uint64_t captureFromUs = 0;
+    bool captureOn;
+
+    memset(&sample, 0, sizeof(sample));
+    // Start the clock part-way through the 32-bit range so micros() wraps
+    // during long runs, as it does on the device after ~71 minutes.
+    const uint32_t clockBase = 0xFFFFFFFFu - 30u * 1000 * 1000;
+    flowMeterInit(&fm, ML_PER_PULSE, 0, 0, clockBase);
+    captureOn = flowMeterReciprocal(&fm);
+    numReadings = 0;
+
+    for (uint64_t nowUs = INTERVAL_US; nowUs <= (uint64_t)(durSec * 1e6);
+            nowUs += INTERVAL_US) {
+        while (next < numPulses && pulses[next] <= nowUs) {
+            ++next;
+            if (captureOn && pulses[next - 1] > captureFromUs) {
+                // CC1 captures the count at the edge; the ISR adds micros().
+                sample.edgeCount = (uint16_t)next;
+                sample.edgeUs = clockBase + (uint32_t)pulses[next - 1];
+                sample.edgeValid = true;
+            }
+        }
+        sample.count = (uint16_t)next;
+        flowMeterUpdate(&fm, &sample, clockBase + (uint32_t)nowUs);
+
+        // main.cpp: enable CC1 while the meter is in reciprocal mode, and
+        // forget the last edge when disabling it.
+        if (flowMeterReciprocal(&fm) != captureOn) {
+            captureOn = flowMeterReciprocal(&fm);
+            captureFromUs = nowUs;
+            if (!captureOn) {
+                sample.edgeValid = false;
+            }
+        }
+
+        if (numReadings < sizeof(readings) / sizeof(readings[0])) {
+            Reading *r = &readings[numReadings++];
+            r->atSec = nowUs / 1e6;
+            r->rate = flowMeterRate(&fm);
+            r->reciprocal = flowMeterReciprocal(&fm);
+        }
+        if (verbose) {
+            printf("  %8.1f s  %10.2f mL/min  %s\n", nowUs / 1e6,
+                flowMeterRate(&fm), flowMeterReciprocal(&fm) ? "recip" :
+                "count");
+        }
+    }
+    return fm;
+}
+
+static void check(bool ok, const char *what)
+{
+    printf("%-60s %s\n", what, ok ? "ok" : "FAIL");
+    if (!ok) {
+        ++failures;
+    }
+}
+
+static void checkTotal(const FlowMeter *fm, const char *name)
+{
+    char what[96];
+    const double expected = numPulses * (double)ML_PER_PULSE;
+    snprintf(what, sizeof(what), "%s: total %.2f mL (expected %.2f)", name,
+        flowMeterTotalMl(fm), expected);
+    check(fabs(flowMeterTotalMl(fm) - expected) < 1e-6, what);
+}
+
+// Steady train: after the first few periods every reading must be within tol
+// of the true rate.
+static void steady(double hz, double tol)
+{
+    const double periodSec = 1.0 / hz;
+    const double durSec = periodSec * 10 > 60 ? periodSec * 10 : 60;
+    const double trueRate = hz * 60 * ML_PER_PULSE;
+    const double settleSec = 3 * periodSec + 2 * INTERVAL_US / 1e6;
+    double worst = 0;
+    char what[96];
+
+    numPulses = 0;
+    addTrain(0, durSec, hz, 0.02);
+    FlowMeter fm = runMeter(durSec);
+
+    for (size_t i = 0; i < numReadings; ++i) {
+        if (readings[i].atSec < settleSec) {
+            continue;
+        }
+        const double err = fabs(readings[i].rate - trueRate) / trueRate;
+        if (err > worst) {
+            worst = err;
+        }
+    }
+    snprintf(what, sizeof(what), "steady %7.2f Hz (%8.1f mL/min, %s): "
+        "worst error %.1f%%", hz, trueRate, flowMeterReciprocal(&fm) ?
+        "recip" : "count", worst * 100);
+    check(worst <= tol, what);
+    checkTotal(&fm, "  steady");
+}
+
+// Runs of consecutive non-zero readings at or after fromSec, as the leak
+// filter in main.cpp counts them.
+static size_t longestNonZeroRun(double fromSec)
+{
+    size_t run = 0, longest = 0;
+    for (size_t i = 0; i < numReadings; ++i) {
+        if (readings[i].atSec < fromSec) {
+            continue;
+        }
+        run = readings[i].rate > 0 ? run + 1 : 0;
+        if (run > longest) {
+            longest = run;
+        }
+    }
+    return longest;
+}
+
+static double firstZeroAfter(double fromSec)
+{
+    for (size_t i = 0; i < numReadings; ++i) {
+        if (readings[i].atSec >= fromSec && readings[i].rate == 0) {
+            return readings[i].atSec;
+        }
+    }
+    return -1;
+}
+
+int main(int argc, char **argv)
+{
+    char what[96];
+
+    if (argc > 1 && strcmp(argv[1], "-v") == 0) {
+        verbose = true;
+    }
+
+    // Counting mode is quantized to one pulse per interval (2 pulses/s); the
+    // reciprocal estimate only carries the simulated 2% period jitter.
+    steady(0.05, 0.05);
+    steady(0.5, 0.05);
+    steady(2, 0.05);
+    steady(10, 0.05);
+    steady(19, 0.05);
+    steady(30, 0.05);
+    steady(45, 0.07);
+    steady(100, 0.04);
+    steady(400, 0.02);
+
+    // A spinner coasting to a stop in about a second after the valve closes
+    // at t = 10 s. The rate must reach 0 within a couple of pulse periods of
+    // the last pulse, so the leak filter doesn't trip.
+    numPulses = 0;
+    addTrain(0, 10, 100, 0.02);
+    const double lastSec = addSpinDown(10, 100, 1.6, 0.5);
+    runMeter(30);
+    const double zeroSec = firstZeroAfter(lastSec);
+    snprintf(what, sizeof(what), "spin-down: last pulse %.2f s, rate 0 at "
+        "%.2f s", lastSec, zeroSec);
+    check(zeroSec > 0 && zeroSec - lastSec < 1.5, what);
+    snprintf(what, sizeof(what), "spin-down: %u non-zero readings after "
+        "close (< %d)", (unsigned)longestNonZeroRun(10.0), LEAK_THRESHOLD);
+    check(longestNonZeroRun(10.0) < LEAK_THRESHOLD, what);
+
+    // A drip, one pulse every 8 s: too slow to appear in any 500 ms count,
+    // but reported continuously once two pulses have been timed.
+    numPulses = 0;
+    addTrain(0, 120, 0.125, 0.05);
+    runMeter(120);
+    snprintf(what, sizeof(what), "drip 0.125 Hz: longest non-zero run %u "
+        "readings", (unsigned)longestNonZeroRun(0));
+    check(longestNonZeroRun(20.0) >= 150, what);
+
+    // Stray pulses 90 s apart are below the idle limit: never flow.
+    numPulses = 0;
+    addTrain(0, 600, 1.0 / 90, 0);
+    runMeter(600);
+    snprintf(what, sizeof(what), "stray pulses 90 s apart: longest non-zero "
+        "run %u", (unsigned)longestNonZeroRun(0));
+    check(longestNonZeroRun(0) == 0, what);
+
+    // Step from full flow down to a trickle and back.
+    numPulses = 0;
+    addTrain(0, 20, 200, 0.02);
+    addTrain(20, 40, 1, 0.02);
+    addTrain(40, 60, 200, 0.02);
+    FlowMeter fm = runMeter(60);
+    bool stepOk = true;
+    for (size_t i = 0; i < numReadings; ++i) {
+        const double t = readings[i].atSec;
+        const double expect = (t >= 24 && t < 40) ? 60 * ML_PER_PULSE :
+            (t >= 42 ? 200 * 60 * ML_PER_PULSE : -1);
+        if (expect > 0 && fabs(readings[i].rate - expect) / expect > 0.05) {
+            stepOk = false;
+        }
+    }
+    check(stepOk, "step 200 Hz -> 1 Hz -> 200 Hz: settles within 4 s");
+    checkTotal(&fm, "  step");
+
+    // 20 minutes at 100 Hz wraps the 16-bit counter (and micros()) several
+    // times.
+    numPulses = 0;
+    addTrain(0, 1200, 100, 0.02);
+    fm = runMeter(1200);
+    checkTotal(&fm, "wrap: 120000 pulses");
+
+    printf("\n%s\n", failures ? "FAILED" : "all checks passed");
+    return failures ? 1 : 0;
+}
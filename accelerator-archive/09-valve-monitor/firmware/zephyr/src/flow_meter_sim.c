@@ -0,0 +1,42 @@
+// Copyright 2023 Blues Inc.  All rights reserved.
+// Use of this source code is governed by licenses granted by the
+// copyright holder including that found in the LICENSE file.
+
+// Flow meter for native_sim. Drives the emulated flow meter pin with a steady
+// pulse train, so with the valve closed the firmware sees a leak and raises
+// alarms, and the Notecard I/O scheduling can be watched on a Linux host.
+
+#include <zephyr/device.h>
+#include <zephyr/drivers/gpio.h>
+#include <zephyr/drivers/gpio/gpio_emul.h>
+#include <zephyr/init.h>
+#include <zephyr/kernel.h>
+
+// At about 0.5 mL a pulse, 20 Hz is 600 mL/min.
+#ifndef FLOW_METER_SIM_HZ
+#define FLOW_METER_SIM_HZ 20
+#endif
+
+static const struct gpio_dt_spec flowMeterSim =
+    GPIO_DT_SPEC_GET(DT_ALIAS(flow_meter), gpios);
+
+static void flowMeterSimTimerCb(struct k_timer *)
+{
+    static int level = 0;
+
+    level = !level;
+    gpio_emul_input_set(flowMeterSim.port, flowMeterSim.pin, level);
+}
+
+K_TIMER_DEFINE(flowMeterSimTimer, flowMeterSimTimerCb, NULL);
+
+static int flowMeterSimInit(void)
+{
+    // Two edges per pulse.
+    k_timer_start(&flowMeterSimTimer, K_MSEC(500 / FLOW_METER_SIM_HZ),
+                  K_MSEC(500 / FLOW_METER_SIM_HZ));
+
+    return 0;
+}
+
+SYS_INIT(flowMeterSimInit, APPLICATION, 99);
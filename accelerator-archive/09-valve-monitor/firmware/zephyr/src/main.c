@@ -9,6 +9,7 @@
 #include <zephyr/drivers/gpio.h>
 #include <zephyr/drivers/uart.h>
 #include <zephyr/kernel.h>
+#include <zephyr/sys/atomic.h>
 #include <zephyr/sys/util.h>
 #include <zephyr/sys/printk.h>
 #include <zephyr/usb/usb_device.h>
@@ -19,9 +20,17 @@
 // Notecard node-c helper methods
 #include "note_c_hooks.h"
 
+#include "flow_meter.h"
+#include "notecard_io.h"
+#include "scheduler.h"
+
 // Don't keep valve open for longer than 10 minutes to prevent overheating of
 // its solenoid.
 #define MAX_OPEN_S (10 * 60)
+// The intervals below, and the default monitor interval, are multiples of one
+// another, so their timers expire together and the device wakes once for all of
+// them (see schedulerStartTimer).
+
 // Check for environment variable changes every 5 seconds.
 #define ENV_POLL_S 5
 // This value specifies how frequently the alarm conditions should be checked.
@@ -34,9 +43,6 @@
 // too small, its possible we won't have enough sensor data (i.e. pulses) to
 // produce an accurate flow rate measurement.
 #define FLOW_CALC_INTERVAL_MS 500
-// The `lockNotecard` function is a spin lock, and this value is responsible for
-// controlling the polling frequency.
-#define NOTECARD_LOCK_POLLS_MS 10
 // This value serves as a low-pass filter to protect against spurious
 // leak warnings.
 #define LEAK_THRESHOLD 6
@@ -60,39 +66,75 @@ typedef struct {
     uint32_t monitorInterval;
     volatile uint32_t lastFlowRateCalcMs;
     uint32_t envLastModTime;
-    volatile uint32_t flowMeterPulseCount;
+    // Pulses since the last flow rate calculation, taken and cleared in one
+    // step with atomic_set().
+    atomic_t flowMeterPulseCount;
+    // Time of the latest pulse, in microseconds. Read with interrupts locked
+    // together with flowMeterPulseCount.
+    uint32_t flowMeterEdgeUs;
+    bool flowMeterEdgeValid;
+    // Running pulse total, fed to the shared flow meter maths as its counter.
+    uint16_t flowMeterCount;
     volatile uint32_t flowRate;
     volatile uint32_t alarmFlowRate;
     uint32_t flowRateAlarmMin;
     uint32_t flowRateAlarmMax;
     volatile uint32_t leakCount;
-    volatile bool notecardLocked;
-    volatile bool attnTriggered;
     volatile bool publishRequired;
     bool valveOpen;
 } AppState;
 
 AppState state = {0};
 
-// Calculate the flow rate (Q) in mL/min:
+// Flow rate (Q) in mL/min:
 // Datasheet: F=(38*Q)±3%, Q=L/Min, error: ±3%
 // pulse_count = ~0.50mL
-// volume (mL) => (pulse_count * (1/2)(mL))
-// duration (ms) => (now_ms - last_sample_ms)
-// duration (s) => (now_ms - last_sample_ms) / 1000
-// duration (min) => (now_ms - last_sample_ms) / (1000 * 60)
-#define MS_IN_MIN 60000
+// The rate itself comes from the flow meter library shared with the Arduino
+// firmware, which counts pulses at high flow and times the interval between
+// them at low flow, so a slow leak isn't truncated to 0 mL/min.
+#define FLOW_ML_PER_PULSE 0.5f
+
+FlowMeter flowMeterState;
+
+static uint32_t uptimeUs(void)
+{
+    return k_ticks_to_us_floor32(k_uptime_ticks());
+}
 
-static uint32_t calculateFlowRate(uint32_t currentMs)
+// Take the pulses counted since the last call and the latest edge time.
+static void flowMeterSample(FlowSample *sample)
 {
-    return (state.flowMeterPulseCount * MS_IN_MIN * 1) /
-           ((currentMs - state.lastFlowRateCalcMs) * 2);
+    unsigned int key = irq_lock();
+    uint32_t pulses = (uint32_t)atomic_set(&state.flowMeterPulseCount, 0);
+    sample->edgeUs = state.flowMeterEdgeUs;
+    sample->edgeValid = state.flowMeterEdgeValid;
+    irq_unlock(key);
+
+    state.flowMeterCount += (uint16_t)pulses;
+    sample->count = state.flowMeterCount;
+    // Every pulse is timestamped, so the latest edge is the latest pulse.
+    sample->edgeCount = state.flowMeterCount;
+}
+
+// Discard pulses counted so far and measure from now.
+static void flowMeterRestart(void)
+{
+    FlowSample sample;
+
+    // A pulse from before the restart mustn't start the first timed run.
+    state.flowMeterEdgeValid = false;
+    flowMeterSample(&sample);
+    flowMeterInit(&flowMeterState, FLOW_ML_PER_PULSE, 0, sample.count,
+                  uptimeUs());
+    state.flowRate = 0;
+    state.lastFlowRateCalcMs = NoteGetMs();
 }
 
 // Forward declarations
 void updateEnvVars(void);
 void valveToggle(void);
 void publishSystemStatus(bool, uint32_t);
+void processInboundNotes(void);
 
 // BEGIN GPIOS
 
@@ -115,7 +157,9 @@ static const struct gpio_dt_spec flowMeter = GPIO_DT_SPEC_GET_OR(FLOW_METER_NODE
 static struct gpio_callback flowMeterCbData;
 static void flowMeterCb(const struct device *, struct gpio_callback *, uint32_t)
 {
-    ++state.flowMeterPulseCount;
+    atomic_inc(&state.flowMeterPulseCount);
+    state.flowMeterEdgeUs = uptimeUs();
+    state.flowMeterEdgeValid = true;
 }
 
 // ATTN pin
@@ -126,59 +170,84 @@ static void flowMeterCb(const struct device *, struct gpio_callback *, uint32_t)
 
 static const struct gpio_dt_spec attn = GPIO_DT_SPEC_GET_OR(ATTN_NODE, gpios, {0});
 
+// Inbound notes job. Valve commands are as urgent as alarms.
+#if USE_VALVE == 1
+static void inboundJobCb(NotecardIoJob *)
+{
+    processInboundNotes();
+}
+
+NOTECARD_IO_JOB_DEFINE(inboundJob, inboundJobCb, NOTECARD_IO_PRIO_ALARM);
+#endif // USE_VALVE == 1
+
 static struct gpio_callback attnCbData;
 static void attnCb(const struct device *, struct gpio_callback *, uint32_t)
 {
-    // This flag will be read in the main loop. We keep the ISR lean and do all
-    // the logic in the main loop.
-    state.attnTriggered = true;
+    // We keep the ISR lean and read the inbound notes on the Notecard I/O
+    // thread.
+#if USE_VALVE == 1
+    notecardIoSubmit(&inboundJob);
+#endif // USE_VALVE == 1
 }
 
 // END GPIOS
 
 // BEGIN TIMERS
 
-// Env var update timer
-static void envVarUpdateWorkCb(struct k_work *)
+// Env var update timer. Checking for updates can wait for alarms and
+// telemetry.
+static void envVarUpdateJobCb(NotecardIoJob *)
 {
     updateEnvVars();
 }
 
-K_WORK_DEFINE(envVarUpdateWorkItem, envVarUpdateWorkCb);
+NOTECARD_IO_JOB_DEFINE(envVarUpdateJob, envVarUpdateJobCb,
+                       NOTECARD_IO_PRIO_BACKGROUND);
 
 static void envVarUpdateTimerCb(struct k_timer *)
 {
-    k_work_submit(&envVarUpdateWorkItem);
+    notecardIoSubmit(&envVarUpdateJob);
 }
 
 K_TIMER_DEFINE(envVarUpdateTimer, envVarUpdateTimerCb, NULL);
 
 // Publish system status timer
-static void publishSystemStatusWorkCb(struct k_work *)
+static void publishSystemStatusJobCb(NotecardIoJob *)
 {
     publishSystemStatus(false, state.flowRate);
 }
 
-K_WORK_DEFINE(publishSystemStatusWorkItem, publishSystemStatusWorkCb);
+NOTECARD_IO_JOB_DEFINE(publishSystemStatusJob, publishSystemStatusJobCb,
+                       NOTECARD_IO_PRIO_TELEMETRY);
 
 static void publishSystemStatusTimerCb(struct k_timer *)
 {
-    k_work_submit(&publishSystemStatusWorkItem);
+    notecardIoSubmit(&publishSystemStatusJob);
 }
 
 K_TIMER_DEFINE(publishSystemStatusTimer, publishSystemStatusTimerCb, NULL);
 
 // Flow rate calculation timer
-static void flowRateCalcTimerCb(struct k_timer *)
+static void flowRateCalcWorkCb(struct k_work *)
 {
     uint32_t currentMs = NoteGetMs();
-    uint32_t flowRate = calculateFlowRate(currentMs);
+    // After the timer is restarted, its first expiry is aligned with the
+    // others and may come early. Let pulses build up until the next one.
+    if (currentMs - state.lastFlowRateCalcMs < FLOW_CALC_INTERVAL_MS / 2) {
+        return;
+    }
+
+    FlowSample sample;
+    flowMeterSample(&sample);
+    flowMeterUpdate(&flowMeterState, &sample, uptimeUs());
+
+    float rate = flowMeterRate(&flowMeterState);
+    uint32_t flowRate = (uint32_t)(rate + 0.5f);
     if (state.flowRate != flowRate) {
         state.flowRate = flowRate;
         state.publishRequired = true;
     }
     state.lastFlowRateCalcMs = currentMs;
-    state.flowMeterPulseCount = 0;
 
 #if USE_VALVE == 1
     if (!state.valveOpen) {
@@ -187,7 +256,7 @@ static void flowRateCalcTimerCb(struct k_timer *)
          // measurements, a leak alarm will be published. This filter prevents
          // spurious leak alarms shortly after the valve is closed while the
          // flow meter's spinner is still slowing down.
-        if (state.flowRate > 0) {
+        if (rate > 0) {
             ++state.leakCount;
         }
         else {
@@ -197,6 +266,13 @@ static void flowRateCalcTimerCb(struct k_timer *)
 #endif // USE_VALVE == 1
 }
 
+K_WORK_DEFINE(flowRateCalcWorkItem, flowRateCalcWorkCb);
+
+static void flowRateCalcTimerCb(struct k_timer *)
+{
+    schedulerSubmitSensorWork(&flowRateCalcWorkItem);
+}
+
 K_TIMER_DEFINE(flowRateCalcTimer, flowRateCalcTimerCb, NULL);
 
 // Alarm cooldown timer
@@ -208,8 +284,9 @@ static void alarmCooldownTimerCb(struct k_timer *)
 
 K_TIMER_DEFINE(alarmCooldownTimer, alarmCooldownTimerCb, NULL);
 
-// Work item for publishing an alarm.
-static void alarmPublishWorkCb(struct k_work *)
+// Job for publishing an alarm. Alarms are queued ahead of all other Notecard
+// I/O.
+static void alarmPublishJobCb(NotecardIoJob *)
 {
     publishSystemStatus(true, state.alarmFlowRate);
     // This timer limits the frequency of alarms we publish to one every
@@ -220,10 +297,11 @@ static void alarmPublishWorkCb(struct k_work *)
                   K_SECONDS(ALARM_COOLDOWN_S), K_FOREVER);
 }
 
-K_WORK_DEFINE(alarmPublishWorkItem, alarmPublishWorkCb);
+NOTECARD_IO_JOB_DEFINE(alarmPublishJob, alarmPublishJobCb,
+                       NOTECARD_IO_PRIO_ALARM);
 
 // Check alarm timer
-static void checkAlarmTimerCb(struct k_timer *)
+static void checkAlarmWorkCb(struct k_work *)
 {
     // Don't do anything if there's an active alarm.
     if (state.alarmReason != NULL) {
@@ -254,43 +332,58 @@ static void checkAlarmTimerCb(struct k_timer *)
 
     if (reason != NULL) {
         state.alarmReason = reason;
-        // Add an item to the work queue to publish the alarm to Notehub.
-        k_work_submit(&alarmPublishWorkItem);
+        // Queue a job to publish the alarm to Notehub.
+        notecardIoSubmit(&alarmPublishJob);
     }
 }
 
+K_WORK_DEFINE(checkAlarmWorkItem, checkAlarmWorkCb);
+
+static void checkAlarmTimerCb(struct k_timer *)
+{
+    schedulerSubmitSensorWork(&checkAlarmWorkItem);
+}
+
 K_TIMER_DEFINE(checkAlarmTimer, checkAlarmTimerCb, NULL);
 
 #if USE_VALVE == 1
 
-// Valve safety timer (close valve if open too long)
-static void valveSafetyTimerCb(struct k_timer *)
+// Valve safety timer (close valve if open too long). The valve is closed from
+// the Notecard I/O thread, where valve commands are handled too, so the two
+// never toggle the valve at the same time.
+static void valveSafetyJobCb(NotecardIoJob *)
 {
     if (state.valveOpen) {
         valveToggle();
     }
 }
 
+NOTECARD_IO_JOB_DEFINE(valveSafetyJob, valveSafetyJobCb,
+                       NOTECARD_IO_PRIO_ALARM);
+
+static void valveSafetyTimerCb(struct k_timer *)
+{
+    notecardIoSubmit(&valveSafetyJob);
+}
+
 K_TIMER_DEFINE(valveSafetyTimer, valveSafetyTimerCb, NULL);
 
 #endif // USE_VALVE == 1
 
 // END TIMERS
 
-// Attempt to get a lock on the I2C bus. This will spin forever until the lock
-// is released.
+// Notecard locking functions. Requests are made from the Notecard I/O thread
+// once it's started, so the lock is normally uncontended.
+K_MUTEX_DEFINE(notecardMutex);
+
 void lockNotecard(void)
 {
-    while (state.notecardLocked) {
-        NoteDelayMs(NOTECARD_LOCK_POLLS_MS);
-    }
-
-    state.notecardLocked = true;
+    k_mutex_lock(&notecardMutex, K_FOREVER);
 }
 
 void unlockNotecard(void)
 {
-    state.notecardLocked = false;
+    k_mutex_unlock(&notecardMutex);
 }
 
 // Arm the ATTN interrupt.
@@ -298,7 +391,6 @@ void attnArm(void)
 {
     // Once ATTN has triggered, it stays set until explicitly rearmed. Rearm it
     // here. It will trigger again after a change to the watched Notefile.
-    state.attnTriggered = false;
     J *req = NoteNewRequest("card.attn");
     JAddStringToObject(req, "mode", "rearm");
     NoteRequest(req);
@@ -333,18 +425,13 @@ void valveToggle(void)
     k_sleep(K_MSEC(250));  // valve state change cool-down
 
     // Reset variables used to calculate flow rate
-    state.flowRate = 0;
-    state.lastFlowRateCalcMs = NoteGetMs();
-    state.flowMeterPulseCount = 0;
+    flowMeterRestart();
 
     // Restart flow rate, publish, alarm timers
-    k_timer_start(&flowRateCalcTimer, K_MSEC(FLOW_CALC_INTERVAL_MS),
-                  K_MSEC(FLOW_CALC_INTERVAL_MS));
-    k_timer_start(&publishSystemStatusTimer,
-                    K_SECONDS(state.monitorInterval),
-                    K_SECONDS(state.monitorInterval));
-    k_timer_start(&checkAlarmTimer, K_SECONDS(ALARM_CHECK_S),
-                  K_SECONDS(ALARM_CHECK_S));
+    schedulerStartTimer(&flowRateCalcTimer, FLOW_CALC_INTERVAL_MS);
+    schedulerStartTimer(&publishSystemStatusTimer,
+                        state.monitorInterval * MSEC_PER_SEC);
+    schedulerStartTimer(&checkAlarmTimer, ALARM_CHECK_S * MSEC_PER_SEC);
 }
 
 // Handle a valve command from Notehub. Supported commands are "open" and
@@ -438,6 +525,64 @@ void publishSystemStatus(bool alarm, uint32_t flowRate)
     }
 }
 
+#if USE_VALVE == 1
+
+// Handle the notes that arrived in data.qi, which set off the ATTN interrupt.
+// Runs on the Notecard I/O thread.
+void processInboundNotes(void)
+{
+    // Re-arm the ATTN interrupt.
+    attnArm();
+
+    // Process all pending inbound requests.
+    while (true) {
+        // Pop the next available note from data.qi.
+        J *req = NoteNewRequest("note.get");
+        JAddStringToObject(req, "file", "data.qi");
+        JAddBoolToObject(req, "delete", true);
+        J *rsp = NoteRequestResponse(req);
+        if (rsp != NULL) {
+
+            // If an error is returned, this means that no response is
+            // pending. Note that it's expected that this might return
+            // either a "note does not exist" error if there are no
+            // pending inbound notes, or a "file does not exist" error
+            // if the inbound queue hasn't yet been created on the
+            // service.
+            if (NoteResponseError(rsp)) {
+                NoteDeleteResponse(rsp);
+                break;
+            }
+
+            // Get the note's body.
+            J *body = JGetObject(rsp, "body");
+            if (body != NULL) {
+                char *cmd = JGetString(body, "state");
+                if (cmd != NULL && strlen(cmd) != 0) {
+                    handleValveCmd(cmd);
+                    // If we received a valve command (open or close),
+                    // we want to publish the system status immediately
+                    // in response, regardless of if it's time to do so
+                    // based on the monitor interval. This acts as a
+                    // sort of acknowledgment so that the controller
+                    // knows their valve command was received.
+                    publishSystemStatus(false, state.flowRate);
+                }
+                else {
+                    printk("Unable to get valve command from note.\n");
+                }
+            }
+            else {
+                printk("Note body was NULL.\n");
+            }
+        }
+
+        NoteDeleteResponse(rsp);
+    }
+}
+
+#endif // USE_VALVE == 1
+
 void NoteUserAgentUpdate(J *ua) {
     JAddStringToObject(ua, "app", "nf9");
 }
@@ -504,9 +649,8 @@ bool fetchEnvVars(void)
                         // If the monitor interval changed, we need to restart
                         // the timer using the new interval value.
                         k_timer_stop(&publishSystemStatusTimer);
-                        k_timer_start(&publishSystemStatusTimer,
-                                      K_SECONDS(state.monitorInterval),
-                                      K_SECONDS(state.monitorInterval));
+                        schedulerStartTimer(&publishSystemStatusTimer,
+                            state.monitorInterval * MSEC_PER_SEC);
                     }
                 }
 
@@ -589,6 +733,7 @@ void updateEnvVars(void)
 
 void main(void)
 {
+#ifdef CONFIG_USB_DEVICE_STACK
     // Configure USB Serial for Console output.
     const struct device *usb_dev = DEVICE_DT_GET(DT_CHOSEN(zephyr_console));
     uint32_t dtr = 0;
@@ -600,13 +745,15 @@ void main(void)
     // Sleep to wait for a terminal connection.
     k_sleep(K_MSEC(2500));
     uart_line_ctrl_get(usb_dev, UART_LINE_CTRL_DTR, &dtr);
+#endif
 
     // Initialize note-c references.
     NoteSetFnDefault(malloc, free, platform_delay, platform_millis);
     NoteSetFnDebugOutput(noteLogPrint);
 
     NoteSetFnMutex(NULL, NULL, lockNotecard, unlockNotecard);
-#ifdef USE_SERIAL
+#if defined(USE_SERIAL) || defined(CONFIG_BOARD_NATIVE_SIM)
+    // On native_sim, this is the simulated Notecard in note_c_hooks_sim.c.
     NoteSetFnSerial(noteSerialReset, noteSerialTransmit,
                     noteSerialAvailable, noteSerialReceive);
 #else
@@ -693,9 +840,7 @@ void main(void)
     gpio_init_callback(&flowMeterCbData, flowMeterCb, BIT(flowMeter.pin));
     gpio_add_callback(flowMeter.port, &flowMeterCbData);
 
-    state.flowRate = 0;
-    state.lastFlowRateCalcMs = NoteGetMs();
-    state.flowMeterPulseCount = 0;
+    flowMeterRestart();
     printk("Set up flow meter at %s pin %d\n", flowMeter.port->name,
            flowMeter.pin);
 
@@ -733,67 +878,26 @@ void main(void)
 
     fetchEnvVars();
 
-    k_timer_start(&envVarUpdateTimer, K_SECONDS(ENV_POLL_S),
-                  K_SECONDS(ENV_POLL_S));
-    k_timer_start(&publishSystemStatusTimer, K_SECONDS(state.monitorInterval),
-                  K_SECONDS(state.monitorInterval));
-    k_timer_start(&flowRateCalcTimer, K_MSEC(FLOW_CALC_INTERVAL_MS),
-                  K_MSEC(FLOW_CALC_INTERVAL_MS));
-    k_timer_start(&checkAlarmTimer, K_SECONDS(ALARM_CHECK_S),
-                  K_SECONDS(ALARM_CHECK_S));
-
-    while (true) {
-    #if USE_VALVE == 1
-        if (state.attnTriggered) {
-            // Re-arm the ATTN interrupt.
-            attnArm();
-
-            // Process all pending inbound requests.
-            while (true) {
-                // Pop the next available note from data.qi.
-                J *req = NoteNewRequest("note.get");
-                JAddStringToObject(req, "file", "data.qi");
-                JAddBoolToObject(req, "delete", true);
-                J *rsp = NoteRequestResponse(req);
-                if (rsp != NULL) {
-
-                    // If an error is returned, this means that no response is
-                    // pending. Note that it's expected that this might return
-                    // either a "note does not exist" error if there are no
-                    // pending inbound notes, or a "file does not exist" error
-                    // if the inbound queue hasn't yet been created on the
-                    // service.
-                    if (NoteResponseError(rsp)) {
-                        NoteDeleteResponse(rsp);
-                        break;
-                    }
+    // From here on, flow rate calculations and alarm checks run on the sensor
+    // work queue and all Notecard requests are made from the Notecard I/O
+    // thread.
+    if (!schedulerInit()) {
+        printk("Error: schedulerInit failed\n");
+        return;
+    }
+    if (!notecardIoStart()) {
+        printk("Error: notecardIoStart failed\n");
+        return;
+    }
 
-                    // Get the note's body.
-                    J *body = JGetObject(rsp, "body");
-                    if (body != NULL) {
-                        char *cmd = JGetString(body, "state");
-                        if (cmd != NULL && strlen(cmd) != 0) {
-                            handleValveCmd(cmd);
-                            // If we received a valve command (open or close),
-                            // we want to publish the system status immediately
-                            // in response, regardless of if it's time to do so
-                            // based on the monitor interval. This acts as a
-                            // sort of acknowledgment so that the controller
-                            // knows their valve command was received.
-                            publishSystemStatus(false, state.flowRate);
-                        }
-                        else {
-                            printk("Unable to get valve command from note.\n");
-                        }
-                    }
-                    else {
-                        printk("Note body was NULL.\n");
-                    }
-                }
+    schedulerStartTimer(&envVarUpdateTimer, ENV_POLL_S * MSEC_PER_SEC);
+    schedulerStartTimer(&publishSystemStatusTimer,
+                        state.monitorInterval * MSEC_PER_SEC);
+    schedulerStartTimer(&flowRateCalcTimer, FLOW_CALC_INTERVAL_MS);
+    schedulerStartTimer(&checkAlarmTimer, ALARM_CHECK_S * MSEC_PER_SEC);
 
-                NoteDeleteResponse(rsp);
-            }
-        }
-    #endif // USE_VALVE == 1
-    }
+    // Everything runs from timers and the ATTN interrupt from here on.
+    // Between them, the idle thread puts the MCU into the deepest sleep state
+    // that fits (see CONFIG_PM).
+    k_sleep(K_FOREVER);
 }
@@ -0,0 +1,98 @@
+// Copyright 2023 Blues Inc.  All rights reserved.
+// Use of this source code is governed by licenses granted by the
+// copyright holder including that found in the LICENSE file.
+
+// Zephyr headers.
+#include <zephyr/kernel.h>
+
+// Application headers.
+#include "scheduler.h"
+
+// Flow rate calculations and alarm checks run on their own work queue, at a
+// higher priority than the Notecard I/O thread, so they keep to time however
+// long a Notecard transaction takes.
+#ifndef SENSOR_WORK_Q_STACK_SIZE
+#define SENSOR_WORK_Q_STACK_SIZE 2048
+#endif
+
+#ifndef SENSOR_WORK_Q_PRIORITY
+#define SENSOR_WORK_Q_PRIORITY K_PRIO_PREEMPT(5)
+#endif
+
+K_THREAD_STACK_DEFINE(sensorWorkQStack, SENSOR_WORK_Q_STACK_SIZE);
+static struct k_work_q sensorWorkQ;
+static bool initialized = false;
+
+// The time all periodic timers are aligned to.
+static int64_t epochMs;
+
+/**
+ * Start the sensor work queue and set the time periodic timers are aligned to.
+ *
+ * @return True on success and false on failure.
+ */
+bool schedulerInit(void)
+{
+    if (initialized) {
+        printk("schedulerInit: error: Already initialized.\n");
+        return false;
+    }
+
+    const struct k_work_queue_config cfg = {
+        .name = "sensor_work_q"
+    };
+    k_work_queue_init(&sensorWorkQ);
+    k_work_queue_start(&sensorWorkQ, sensorWorkQStack,
+        K_THREAD_STACK_SIZEOF(sensorWorkQStack), SENSOR_WORK_Q_PRIORITY, &cfg);
+
+    epochMs = k_uptime_get();
+    initialized = true;
+
+    printk("schedulerInit: Started sensor work queue.\n");
+
+    return true;
+}
+
+/**
+ * Submit a work item to the sensor work queue. Safe to call from timer
+ * callbacks and interrupts.
+ *
+ * @param item The work item.
+ *
+ * @return True if the item was queued or was already queued and false on
+ *         failure.
+ */
+bool schedulerSubmitSensorWork(struct k_work *item)
+{
+    if (!initialized) {
+        printk("schedulerSubmitSensorWork: error: Called before schedulerInit."
+            "\n");
+        return false;
+    }
+
+    return k_work_submit_to_queue(&sensorWorkQ, item) >= 0;
+}
+
+/**
+ * Start a periodic timer whose expiries fall on multiples of the interval since
+ * schedulerInit. Timers whose intervals are multiples of one another then
+ * expire on the same tick, so the system wakes once for all of them and sleeps
+ * for longer in between. The first expiry is the next multiple after now, so a
+ * timer restarted with a new interval stays aligned.
+ *
+ * @param timer      The timer.
+ * @param intervalMs The timer period, in milliseconds. Must be > 0.
+ */
+void schedulerStartTimer(struct k_timer *timer, uint32_t intervalMs)
+{
+    if (intervalMs == 0) {
+        printk("schedulerStartTimer: error: Called with 0 interval. Must be > 0."
+            "\n");
+        return;
+    }
+
+    int64_t elapsedMs = k_uptime_get() - epochMs;
+    uint32_t delayMs = intervalMs - (uint32_t)(elapsedMs % intervalMs);
+
+    k_timer_start(timer, K_MSEC(delayMs), K_MSEC(intervalMs));
+}
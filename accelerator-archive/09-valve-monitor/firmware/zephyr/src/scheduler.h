@@ -0,0 +1,16 @@
+// Copyright 2023 Blues Inc.  All rights reserved.
+// Use of this source code is governed by licenses granted by the
+// copyright holder including that found in the LICENSE file.
+
+#pragma once
+
+// C standard headers.
+#include <stdint.h>
+#include <stdbool.h>
+
+// Zephyr headers.
+#include <zephyr/kernel.h>
+
+bool schedulerInit(void);
+bool schedulerSubmitSensorWork(struct k_work *item);
+void schedulerStartTimer(struct k_timer *timer, uint32_t intervalMs);
@@ -8,6 +8,7 @@
 #include "Adafruit_BME280.h"
 #include "Adafruit_seesaw.h"
 #include "greenhouse.h"
+#include "zone.h"
 
 #define LIGHT_SENSOR_PIN (A1)
 #define DATA_FILE_NOTIFY "notify.qo"
@@ -51,6 +52,27 @@
 #define APP_NAME    "nf15"
 #endif
 
+// The number of zones, each with its own BME280 and seesaw soil sensor. With more than one zone,
+// each zone's sensors are on their own channel of a TCA9548A I2C multiplexer, and readings are
+// named after the zone, e.g. zone3_soil_temp.
+#ifndef GREENHOUSE_ZONES
+#define GREENHOUSE_ZONES (1)
+#endif
+
+// The address of the first multiplexer. Zones 9-16 are on the multiplexer at the next address, and so on.
+#ifndef ZONE_MUX_ADDRESS
+#define ZONE_MUX_ADDRESS (0x70)
+#endif
+
+// With more than one zone, a monitoring event only includes the zones whose readings moved by more
+// than the sensor's deadband, or whose alert level changed, since they were last sent. Every Nth
+// event includes all zones.
+#ifndef DEFAULT_FULL_REPORT_EVERY
+#define DEFAULT_FULL_REPORT_EVERY (12)
+#endif
+
+#define IS_MULTI_ZONE (GREENHOUSE_ZONES>1)
+
 
 void outputInterval(Stream& out, float vmin, float vmax) {
     out.print('[');
@@ -77,28 +99,30 @@ void outputThresholdAlert(Stream& out, const ThresholdAlert* a) {
 
 Notecard notecard;
 
-Adafruit_BME280 bme280;
-bool bme280Initialized;
-bool bme280Messaged;
-float air_temp;
-float air_humidity;
-float air_pressure;
-AlertIntervals air_temp_intervals;
-AlertIntervals air_humidity_intervals;
-AlertIntervals air_pressure_intervals;
-ThresholdAlert air_temp_alert;
-ThresholdAlert air_humidity_alert;
-ThresholdAlert air_pressure_alert;
-
-Adafruit_seesaw seesaw;
-bool seesawInitialized;
-bool seesawMessaged;
-float soil_temp;
-float soil_moisture;
-AlertIntervals soil_temp_intervals;
-AlertIntervals soil_moisture_intervals;
-ThresholdAlert soil_temp_alert;
-ThresholdAlert soil_moisture_alert;
+Zone zones[GREENHOUSE_ZONES];
+ZoneMux zoneMux(Wire, ZONE_MUX_ADDRESS);
+
+const char* const zoneSensorNames[ZONE_SENSOR_COUNT] = {
+    DATA_FIELD_SOIL_TEMP,
+    DATA_FIELD_SOIL_MOISTURE,
+    DATA_FIELD_AIR_TEMP,
+    DATA_FIELD_AIR_HUMIDITY,
+    DATA_FIELD_AIR_PRESSURE
+};
+
+// The smallest change in each reading that puts a zone in a monitoring event.
+const float defaultDeadband[ZONE_SENSOR_COUNT] = {
+    0.5,        // soil_temp, Celsius
+    10,         // soil_moisture
+    0.5,        // air_temp, Celsius
+    2,          // air_humidity, percent
+    1           // air_pressure, hPa
+};
+
+// The greenhouse-wide alert intervals and deadbands, set from the environment
+AlertIntervals zoneSensorIntervals[ZONE_SENSOR_COUNT];
+float deadband[ZONE_SENSOR_COUNT] = { SENSOR_VALUE_UNDEFINED, SENSOR_VALUE_UNDEFINED,
+    SENSOR_VALUE_UNDEFINED, SENSOR_VALUE_UNDEFINED, SENSOR_VALUE_UNDEFINED };
 
 float light_level;
 AlertIntervals light_level_intervals;
@@ -114,65 +138,124 @@ uint32_t sendReportMs;
 uint32_t pollEnvironmentInterval = DEFAULT_POLL_ENVIRONMENT_INTERVAL;
 uint32_t pollEnvironmentMs;
 int64_t environmentModifiedTime;
+uint32_t fullReportEvery = DEFAULT_FULL_REPORT_EVERY;
+uint32_t reportCount;
+
+/**
+ * @brief The name of a zone's reading, or of an environment variable that configures it.
+ * Unchanged when there's only one zone.
+ */
+const char* zoneName(char* buf, size_t size, int zone, const char* name) {
+    if (!IS_MULTI_ZONE) {
+        return name;
+    }
+    snprintf(buf, size, "zone%d_%s", zone+1, name);
+    return buf;
+}
 
-bool initializeBME280() {
-    if (!bme280Initialized) {
-        unsigned status = bme280.begin();
-        if (!status && !bme280Messaged) {
-            bme280Messaged = true;
+void debugZone(int zone) {
+    if (IS_MULTI_ZONE) {
+        debug.print("zone ");
+        debug.print(zone+1);
+        debug.print(": ");
+    }
+}
+
+bool initializeBME280(int i) {
+    Zone& zone = zones[i];
+    if (!zone.bme280Initialized) {
+        unsigned status = zone.bme280.begin();
+        if (!status && !zone.bme280Messaged) {
+            zone.bme280Messaged = true;
+            debugZone(i);
             debug.println("Could not find a valid BME280 sensor, check wiring, address, sensor ID!");
-            debug.print("SensorID was: 0x"); debug.println(bme280.sensorID(),16);
+            debug.print("SensorID was: 0x"); debug.println(zone.bme280.sensorID(),16);
             debug.print("        ID of 0xFF probably means a bad address, a BMP 180 or BMP 085\n");
             debug.print("   ID of 0x56-0x58 represents a BMP 280,\n");
             debug.print("        ID of 0x60 represents a BME 280.\n");
             debug.print("        ID of 0x61 represents a BME 680.\n");
         }
-        bme280Initialized = status;
+        zone.bme280Initialized = status;
     }
-    return bme280Initialized;
+    return zone.bme280Initialized;
 }
 
-bool initializeSeesaw() {
-    if (!seesawInitialized) {
-        seesawInitialized = seesaw.begin(0x36);
-        if (seesawInitialized) {
+bool initializeSeesaw(int i) {
+    Zone& zone = zones[i];
+    if (!zone.seesawInitialized) {
+        zone.seesawInitialized = zone.seesaw.begin(0x36);
+        if (zone.seesawInitialized) {
+            debugZone(i);
             debug.print("seesaw started! version: ");
-            debug.println(seesaw.getVersion(), HEX);
+            debug.println(zone.seesaw.getVersion(), HEX);
         }
-        else if (!seesawMessaged) {
+        else if (!zone.seesawMessaged) {
+            debugZone(i);
             debug.println("ERROR! seesaw not found");
-            seesawMessaged = true;
+            zone.seesawMessaged = true;
         }
     }
-    return seesawInitialized;
+    return zone.seesawInitialized;
 }
 
-void readBME280() {
-    if (initializeBME280()) {
-        air_temp = bme280.readTemperature();
-        air_humidity = bme280.readHumidity();
-        air_pressure = bme280.readPressure()/100.0; // convert from Pascals hecto-Pascals which is more commonly used when reporting atmospheric pressure
-        bme280Messaged = false; // re-print the message after a successful read should the sensor connection fail
-        if (!isValueSet(air_temp) && !isValueSet(air_humidity) && !isValueSet(air_pressure)) {
-            bme280Initialized = false;
+void readBME280(int i) {
+    Zone& zone = zones[i];
+    if (initializeBME280(i)) {
+        zone.value[ZONE_SENSOR_AIR_TEMP] = zone.bme280.readTemperature();
+        zone.value[ZONE_SENSOR_AIR_HUMIDITY] = zone.bme280.readHumidity();
+        zone.value[ZONE_SENSOR_AIR_PRESSURE] = zone.bme280.readPressure()/100.0; // convert from Pascals hecto-Pascals which is more commonly used when reporting atmospheric pressure
+        zone.bme280Messaged = false; // re-print the message after a successful read should the sensor connection fail
+        if (!isValueSet(zone.value[ZONE_SENSOR_AIR_TEMP]) && !isValueSet(zone.value[ZONE_SENSOR_AIR_HUMIDITY]) && !isValueSet(zone.value[ZONE_SENSOR_AIR_PRESSURE])) {
+            zone.bme280Initialized = false;
         }
     }
     else {
-        air_temp = SENSOR_VALUE_UNDEFINED;
-        air_humidity = SENSOR_VALUE_UNDEFINED;
-        air_pressure = SENSOR_VALUE_UNDEFINED;
+        zone.value[ZONE_SENSOR_AIR_TEMP] = SENSOR_VALUE_UNDEFINED;
+        zone.value[ZONE_SENSOR_AIR_HUMIDITY] = SENSOR_VALUE_UNDEFINED;
+        zone.value[ZONE_SENSOR_AIR_PRESSURE] = SENSOR_VALUE_UNDEFINED;
     }
 }
 
-void readSeesaw() {
-    if (initializeSeesaw()) {
-        soil_temp = seesaw.getTemp();
-        soil_moisture = seesaw.touchRead(0);
-        seesawMessaged = false;
-        if (!isValueSet(soil_temp) && !isValueSet(soil_moisture)) {
-            seesawInitialized = false;
+void readSeesaw(int i) {
+    Zone& zone = zones[i];
+    if (initializeSeesaw(i)) {
+        zone.value[ZONE_SENSOR_SOIL_TEMP] = zone.seesaw.getTemp();
+        zone.value[ZONE_SENSOR_SOIL_MOISTURE] = zone.seesaw.touchRead(0);
+        zone.seesawMessaged = false;
+        if (!isValueSet(zone.value[ZONE_SENSOR_SOIL_TEMP]) && !isValueSet(zone.value[ZONE_SENSOR_SOIL_MOISTURE])) {
+            zone.seesawInitialized = false;
         }
     }
+    else {
+        zone.value[ZONE_SENSOR_SOIL_TEMP] = SENSOR_VALUE_UNDEFINED;
+        zone.value[ZONE_SENSOR_SOIL_MOISTURE] = SENSOR_VALUE_UNDEFINED;
+    }
+}
+
+/**
+ * @brief Connects the zone's sensors to the bus. When the zone can't be reached, its readings are
+ * cleared and its sensors initialized again once it can.
+ */
+bool selectZone(int i) {
+    if (!IS_MULTI_ZONE) {
+        return true;
+    }
+    Zone& zone = zones[i];
+    if (!zoneMux.select(i)) {
+        if (!zone.muxMessaged) {
+            zone.muxMessaged = true;
+            debugZone(i);
+            debug.println("I2C multiplexer not responding, check wiring and address.");
+        }
+        zone.bme280Initialized = false;
+        zone.seesawInitialized = false;
+        for (int s=0; s<ZONE_SENSOR_COUNT; s++) {
+            zone.value[s] = SENSOR_VALUE_UNDEFINED;
+        }
+        return false;
+    }
+    zone.muxMessaged = false;
+    return true;
 }
 
 void readPhotosensor() {
@@ -180,8 +263,15 @@ void readPhotosensor() {
 }
 
 void readSensors() {
-    readBME280();
-    readSeesaw();
+    for (int i=0; i<GREENHOUSE_ZONES; i++) {
+        if (selectZone(i)) {
+            readBME280(i);
+            readSeesaw(i);
+        }
+    }
+    if (IS_MULTI_ZONE) {
+        zoneMux.deselect();
+    }
     readPhotosensor();
 }
 
@@ -218,13 +308,38 @@ void outputSensorReport(Stream& out, const char* name, float value, const Thresh
     out.println();
 }
 
+inline float zoneThreshold(float zoneValue, float value) {
+    return isValueSet(zoneValue) ? zoneValue : value;
+}
+
+/**
+ * @brief The alert intervals for a sensor in a zone. A threshold set for the zone takes the place
+ * of the greenhouse-wide threshold.
+ */
+AlertIntervals zoneAlertIntervals(const Zone& zone, int sensor) {
+    const AlertIntervals& z = zone.intervals[sensor];
+    const AlertIntervals& g = zoneSensorIntervals[sensor];
+    AlertIntervals result;
+    result.normal.vmin = zoneThreshold(z.normal.vmin, g.normal.vmin);
+    result.normal.vmax = zoneThreshold(z.normal.vmax, g.normal.vmax);
+    result.warning.vmin = zoneThreshold(z.warning.vmin, g.warning.vmin);
+    result.warning.vmax = zoneThreshold(z.warning.vmax, g.warning.vmax);
+    return result;
+}
+
 void outputReport(Stream& out) {
     out.println("sensor readings:");
-    outputSensorReport(out, DATA_FIELD_SOIL_TEMP, soil_temp, &soil_temp_alert, &soil_temp_intervals);
-    outputSensorReport(out, DATA_FIELD_SOIL_MOISTURE, soil_moisture, &soil_moisture_alert, &soil_moisture_intervals);
-    outputSensorReport(out, DATA_FIELD_AIR_TEMP, air_temp, &air_temp_alert, &air_temp_intervals);
-    outputSensorReport(out, DATA_FIELD_AIR_PRESSURE, air_pressure, &air_pressure_alert, &air_pressure_intervals);
-    outputSensorReport(out, DATA_FIELD_AIR_HUMIDITY, air_humidity, &air_humidity_alert, &air_humidity_intervals);
+    for (int i=0; i<GREENHOUSE_ZONES; i++) {
+        const Zone& zone = zones[i];
+        if (IS_MULTI_ZONE) {
+            out.print("zone ");
+            out.println(i+1);
+        }
+        for (int s=0; s<ZONE_SENSOR_COUNT; s++) {
+            AlertIntervals intervals = zoneAlertIntervals(zone, s);
+            outputSensorReport(out, zoneSensorNames[s], zone.value[s], &zone.alert[s], &intervals);
+        }
+    }
     outputSensorReport(out, DATA_FIELD_LIGHT_LEVEL, light_level, &light_level_alert, &light_level_intervals);
     out.println();
 }
@@ -256,11 +371,15 @@ void checkAlerts() {
     // the overall alert level
     alertLevel = ALERT_LEVEL_NORMAL;
 
-    updateSensorAlert(soil_temp, &soil_temp_intervals, &soil_temp_alert, &alertLevel);
-    updateSensorAlert(soil_moisture, &soil_moisture_intervals, &soil_moisture_alert, &alertLevel);
-    updateSensorAlert(air_temp, &air_temp_intervals, &air_temp_alert, &alertLevel);
-    updateSensorAlert(air_humidity, &air_humidity_intervals, &air_humidity_alert, &alertLevel);
-    updateSensorAlert(air_pressure, &air_pressure_intervals, &air_pressure_alert, &alertLevel);
+    for (int i=0; i<GREENHOUSE_ZONES; i++) {
+        Zone& zone = zones[i];
+        zone.alertLevel = ALERT_LEVEL_NORMAL;
+        for (int s=0; s<ZONE_SENSOR_COUNT; s++) {
+            AlertIntervals intervals = zoneAlertIntervals(zone, s);
+            updateSensorAlert(zone.value[s], &intervals, &zone.alert[s], &zone.alertLevel);
+        }
+        alertLevel = highestAlertLevel(alertLevel, zone.alertLevel);
+    }
     updateSensorAlert(light_level, &light_level_intervals, &light_level_alert, &alertLevel);
 
     bool wasAlerting = isAlertSequenceOngoing(alertSequence);
@@ -301,17 +420,62 @@ void addSensorValue(J* body, const char* name, float value) {
     }
 }
 
+inline float sensorDeadband(int sensor) {
+    return isValueSet(deadband[sensor]) ? deadband[sensor] : defaultDeadband[sensor];
+}
+
+/**
+ * @brief Determines if a zone's readings have changed enough since they were last sent to be
+ * worth sending again.
+ */
+bool hasZoneChanged(const Zone& zone) {
+    if (zone.alertLevel!=zone.reportedAlertLevel) {
+        return true;
+    }
+    for (int s=0; s<ZONE_SENSOR_COUNT; s++) {
+        float v = zone.value[s];
+        float r = zone.reported[s];
+        if (isValueSet(v)!=isValueSet(r) || (isValueSet(v) && fabs(v-r) > sensorDeadband(s))) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Sends the readings to the monitoring notefile, as a single note for all zones. With more
+ * than one zone, only the zones that changed are included, except in every `fullReportEvery`th note.
+ */
 bool sendMonitorEvent(bool immediate) {
+    bool full = !IS_MULTI_ZONE || fullReportEvery<=1 || (reportCount % fullReportEvery)==0;
+    bool included[GREENHOUSE_ZONES];
+    char name[64];
+
     J *req = notecard.newRequest("note.add");
     JAddStringToObject(req, "file", DATA_FILE_MONITOR);
     J* body = buildNote(req, immediate);
-    addSensorValue(body, DATA_FIELD_SOIL_TEMP, soil_temp);
-    addSensorValue(body, DATA_FIELD_SOIL_MOISTURE, soil_moisture);
-    addSensorValue(body, DATA_FIELD_AIR_TEMP, air_temp);
-    addSensorValue(body, DATA_FIELD_AIR_HUMIDITY, air_humidity);
-    addSensorValue(body, DATA_FIELD_AIR_PRESSURE, air_pressure);
+    for (int i=0; i<GREENHOUSE_ZONES; i++) {
+        const Zone& zone = zones[i];
+        included[i] = full || hasZoneChanged(zone);
+        if (included[i]) {
+            for (int s=0; s<ZONE_SENSOR_COUNT; s++) {
+                addSensorValue(body, zoneName(name, sizeof(name), i, zoneSensorNames[s]), zone.value[s]);
+            }
+        }
+    }
     addSensorValue(body, DATA_FIELD_LIGHT_LEVEL, light_level);
-    return notecard.sendRequest(req);
+    bool success = notecard.sendRequest(req);
+    if (success) {
+        reportCount++;
+        for (int i=0; i<GREENHOUSE_ZONES; i++) {
+            Zone& zone = zones[i];
+            if (included[i]) {
+                memcpy(zone.reported, zone.value, sizeof(zone.reported));
+                zone.reportedAlertLevel = zone.alertLevel;
+            }
+        }
+    }
+    return success;
 }
 
 void buildAlert(J* body, const char* sensor_name, float value, const ThresholdAlert* alert) {
@@ -323,20 +487,52 @@ void buildAlert(J* body, const char* sensor_name, float value, const ThresholdAl
     JAddNumberToObject(r, "value", value);
 }
 
+/**
+ * @brief Adds an object for each zone that is alerting, or that was alerting in the last alert
+ * event, with the zone's alert level and the readings that are out of range. Zones that
+ * aren't alerting are left out to keep the event small.
+ */
+void buildZoneAlerts(J* body) {
+    char name[16];
+    for (int i=0; i<GREENHOUSE_ZONES; i++) {
+        const Zone& zone = zones[i];
+        if (!isAlertLevel(zone.alertLevel) && !zone.alertSent) {
+            continue;
+        }
+        snprintf(name, sizeof(name), "zone%d", i+1);
+        J* z = JAddObjectToObject(body, name);
+        JAddStringToObject(z, DATA_FIELD_ALERT_LEVEL, alertLevelString(zone.alertLevel));
+        for (int s=0; s<ZONE_SENSOR_COUNT; s++) {
+            if (zone.alert[s].threshold!=THRESHOLD_NONE) {
+                buildAlert(z, zoneSensorNames[s], zone.value[s], &zone.alert[s]);
+            }
+        }
+    }
+}
+
 bool sendAlertThresholds(bool immediate) {
     J *req = notecard.newRequest("note.add");
     JAddStringToObject(req, "file", DATA_FILE_ALERT);
 
     J* body = buildNote(req, immediate);
 
-    buildAlert(body, DATA_FIELD_SOIL_TEMP, soil_temp, &soil_temp_alert);
-    buildAlert(body, DATA_FIELD_SOIL_MOISTURE, soil_moisture, &soil_moisture_alert);
-    buildAlert(body, DATA_FIELD_AIR_TEMP, air_temp, &air_temp_alert);
-    buildAlert(body, DATA_FIELD_AIR_HUMIDITY, air_humidity, &air_humidity_alert);
-    buildAlert(body, DATA_FIELD_AIR_PRESSURE, air_pressure, &air_pressure_alert);
+    if (IS_MULTI_ZONE) {
+        buildZoneAlerts(body);
+    }
+    else {
+        for (int s=0; s<ZONE_SENSOR_COUNT; s++) {
+            buildAlert(body, zoneSensorNames[s], zones[0].value[s], &zones[0].alert[s]);
+        }
+    }
     buildAlert(body, DATA_FIELD_LIGHT_LEVEL, light_level, &light_level_alert);
 
-    return notecard.sendRequest(req);
+    bool success = notecard.sendRequest(req);
+    if (success) {
+        for (int i=0; i<GREENHOUSE_ZONES; i++) {
+            zones[i].alertSent = isAlertLevel(zones[i].alertLevel);
+        }
+    }
+    return success;
 }
 
 bool buildAndSendEvents(boolean immediate) {
@@ -370,11 +566,12 @@ void registerNoteTemplate() {
     JAddStringToObject(body, DATA_FIELD_ALERT_SEQUENCE, TSTRINGV);
     JAddStringToObject(body, DATA_FIELD_ALERT_LEVEL, TSTRINGV);
     JAddStringToObject(body, DATA_FIELD_APP, TSTRINGV);
-    JAddNumberToObject(body, DATA_FIELD_SOIL_TEMP, TFLOAT32);
-    JAddNumberToObject(body, DATA_FIELD_SOIL_MOISTURE, TFLOAT32);
-    JAddNumberToObject(body, DATA_FIELD_AIR_TEMP, TFLOAT32);
-    JAddNumberToObject(body, DATA_FIELD_AIR_HUMIDITY, TFLOAT32);
-    JAddNumberToObject(body, DATA_FIELD_AIR_PRESSURE, TFLOAT32);
+    char name[64];
+    for (int i=0; i<GREENHOUSE_ZONES; i++) {
+        for (int s=0; s<ZONE_SENSOR_COUNT; s++) {
+            JAddNumberToObject(body, zoneName(name, sizeof(name), i, zoneSensorNames[s]), TFLOAT32);
+        }
+    }
     JAddNumberToObject(body, DATA_FIELD_LIGHT_LEVEL, TFLOAT32);
 
     J* req = notecard.newCommand("note.template");
@@ -440,9 +637,7 @@ inline bool compare_float(float a, float b, double epsilon=0.0001) {
     return (fabs(a - b) < epsilon);
 }
 
-bool updateIntervalThresholdFromEnvrionment(J* env, J* changed, J* errors, const char* sensor_name, const char* range_name, const char* threshold, float* result) {
-    char varname[256];
-    snprintf(varname, sizeof(varname), "%s_%s_%s", sensor_name, range_name, threshold);
+bool updateValueFromEnvironment(J* env, J* changed, J* errors, const char* varname, float* result) {
     bool success = false;
     float r = SENSOR_VALUE_UNDEFINED;
     const char* value = JGetString(env, varname);
@@ -467,6 +662,12 @@ bool updateIntervalThresholdFromEnvrionment(J* env, J* changed, J* errors, const
     return success;
 }
 
+bool updateIntervalThresholdFromEnvrionment(J* env, J* changed, J* errors, const char* sensor_name, const char* range_name, const char* threshold, float* result) {
+    char varname[256];
+    snprintf(varname, sizeof(varname), "%s_%s_%s", sensor_name, range_name, threshold);
+    return updateValueFromEnvironment(env, changed, errors, varname, result);
+}
+
 // Updates the low and high thresholds for an interval on a sensor
 void updateIntervalFromEnvironment(J* env, J* changed, J* errors,  const char* sensor_name, const char* range_name, Interval* interval) {
     updateIntervalThresholdFromEnvrionment(env, changed, errors, sensor_name, range_name, "low", &interval->vmin);
@@ -489,14 +690,26 @@ void environmentUpdated(J* env) {
     setTaskIntervalFromEnvironment(env, changed, errors, &readSensorsInterval, "monitor_secs", 1000, DEFAULT_POLL_SENSORS_INTERVAL);
     setTaskIntervalFromEnvironment(env, changed, errors, &sendReportInterval, "report_mins", 1000*60, DEFAULT_REPORT_INTERVAL);
 
-    updateAlertThresholdsFromEnvironment(env, changed, errors, DATA_FIELD_SOIL_TEMP, &soil_temp_intervals);
-    updateAlertThresholdsFromEnvironment(env, changed, errors, DATA_FIELD_SOIL_MOISTURE, &soil_moisture_intervals);
+    for (int s=0; s<ZONE_SENSOR_COUNT; s++) {
+        updateAlertThresholdsFromEnvironment(env, changed, errors, zoneSensorNames[s], &zoneSensorIntervals[s]);
+    }
+    updateAlertThresholdsFromEnvironment(env, changed, errors, DATA_FIELD_LIGHT_LEVEL, &light_level_intervals);
 
-    updateAlertThresholdsFromEnvironment(env, changed, errors, DATA_FIELD_AIR_TEMP, &air_temp_intervals);
-    updateAlertThresholdsFromEnvironment(env, changed, errors, DATA_FIELD_AIR_HUMIDITY, &air_humidity_intervals);
-    updateAlertThresholdsFromEnvironment(env, changed, errors, DATA_FIELD_AIR_PRESSURE, &air_pressure_intervals);
+    if (IS_MULTI_ZONE) {
+        // zone3_soil_temp_normal_low etc. override the greenhouse-wide thresholds for one zone
+        char name[64];
+        for (int i=0; i<GREENHOUSE_ZONES; i++) {
+            for (int s=0; s<ZONE_SENSOR_COUNT; s++) {
+                updateAlertThresholdsFromEnvironment(env, changed, errors, zoneName(name, sizeof(name), i, zoneSensorNames[s]), &zones[i].intervals[s]);
+            }
+        }
 
-    updateAlertThresholdsFromEnvironment(env, changed, errors, DATA_FIELD_LIGHT_LEVEL, &light_level_intervals);
+        for (int s=0; s<ZONE_SENSOR_COUNT; s++) {
+            snprintf(name, sizeof(name), "%s_deadband", zoneSensorNames[s]);
+            updateValueFromEnvironment(env, changed, errors, name, &deadband[s]);
+        }
+        setTaskIntervalFromEnvironment(env, changed, errors, &fullReportEvery, "full_report_every", 1, DEFAULT_FULL_REPORT_EVERY);
+    }
 
     char buf[256];
     debug.println("environment updates:");
@@ -0,0 +1,106 @@
+// Copyright 2023 Blues Inc.  All rights reserved.
+// Use of this source code is governed by licenses granted by the
+// copyright holder including that found in the LICENSE file.
+
+#pragma once
+
+#include <Wire.h>
+#include "Adafruit_BME280.h"
+#include "Adafruit_seesaw.h"
+#include "greenhouse.h"
+
+/**
+ * @brief The sensors read in each zone. The light level is read once for the whole greenhouse.
+ */
+enum ZoneSensor {
+    ZONE_SENSOR_SOIL_TEMP,
+    ZONE_SENSOR_SOIL_MOISTURE,
+    ZONE_SENSOR_AIR_TEMP,
+    ZONE_SENSOR_AIR_HUMIDITY,
+    ZONE_SENSOR_AIR_PRESSURE,
+    ZONE_SENSOR_COUNT
+};
+
+/**
+ * @brief One zone of the greenhouse: a BME280 and a seesaw soil sensor, with their readings
+ * and alerts, and the readings last sent to Notehub.
+ */
+struct Zone {
+    Adafruit_BME280 bme280;
+    bool bme280Initialized;
+    bool bme280Messaged;
+
+    Adafruit_seesaw seesaw;
+    bool seesawInitialized;
+    bool seesawMessaged;
+
+    bool muxMessaged;
+
+    float value[ZONE_SENSOR_COUNT];
+    AlertIntervals intervals[ZONE_SENSOR_COUNT];   // overrides the greenhouse-wide intervals where set
+    ThresholdAlert alert[ZONE_SENSOR_COUNT];
+    AlertLevel alertLevel;
+    bool alertSent;                                 // included in the last alert event
+
+    float reported[ZONE_SENSOR_COUNT];              // values in the last monitoring event
+    AlertLevel reportedAlertLevel;
+
+    Zone() : bme280Initialized(false), bme280Messaged(false),
+        seesawInitialized(false), seesawMessaged(false), muxMessaged(false),
+        alertLevel(ALERT_LEVEL_NORMAL), alertSent(false), reportedAlertLevel(ALERT_LEVEL_NORMAL) {
+        for (int i=0; i<ZONE_SENSOR_COUNT; i++) {
+            value[i] = SENSOR_VALUE_UNDEFINED;
+            alert[i] = NORMAL;
+            reported[i] = SENSOR_VALUE_UNDEFINED;
+        }
+    }
+};
+
+/**
+ * @brief Routes the I2C bus to one zone through a chain of TCA9548A multiplexers, 8 zones to a
+ * multiplexer. Multiplexer n is at address `baseAddress+n`, so up to 8 multiplexers give 64 zones,
+ * each with the same sensor addresses.
+ */
+class ZoneMux {
+    TwoWire& wire;
+    uint8_t baseAddress;
+    int selected;           // the selected zone, or -1
+
+    bool setChannels(int mux, uint8_t channels) {
+        wire.beginTransmission(baseAddress+mux);
+        wire.write(channels);
+        return wire.endTransmission()==0;
+    }
+
+public:
+    static const int ZONES_PER_MUX = 8;
+
+    ZoneMux(TwoWire& wire, uint8_t baseAddress) : wire(wire), baseAddress(baseAddress), selected(-1) {}
+
+    /**
+     * @brief Connects the given zone's sensors to the bus, and disconnects the previous zone's.
+     * @return false if the zone's multiplexer didn't respond.
+     */
+    bool select(int zone) {
+        int mux = zone/ZONES_PER_MUX;
+        if (selected>=0 && selected/ZONES_PER_MUX!=mux) {
+            setChannels(selected/ZONES_PER_MUX, 0);
+        }
+        selected = -1;
+        if (!setChannels(mux, 1<<(zone%ZONES_PER_MUX))) {
+            return false;
+        }
+        selected = zone;
+        return true;
+    }
+
+    /**
+     * @brief Disconnects all zones from the bus.
+     */
+    void deselect() {
+        if (selected>=0) {
+            setChannels(selected/ZONES_PER_MUX, 0);
+            selected = -1;
+        }
+    }
+};
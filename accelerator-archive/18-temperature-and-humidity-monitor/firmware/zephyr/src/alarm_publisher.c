@@ -11,12 +11,25 @@
 
 // Application headers.
 #include "alarm_publisher.h"
+#include "notecard_io.h"
+#include "scheduler.h"
+
+// The readings behind an alarm, handed from the sensor work queue to the
+// Notecard I/O thread.
+typedef struct {
+    const char *tempStatus;
+    const char *humidStatus;
+    double temp;
+    double humid;
+} Alarm;
 
 struct AlarmPublisherCtx {
     const Bme280Ctx *bme280Ctx;
     struct k_timer alarmCheckTimer;
     struct k_timer alarmCooldownTimer;
     struct k_work alarmCheckWorkItem;
+    NotecardIoJob alarmJob;
+    Alarm alarm;
     double tempMin;
     double tempMax;
     double humidMin;
@@ -26,6 +39,10 @@ struct AlarmPublisherCtx {
     volatile bool coolingDown;
 };
 
+// Guards the bounds, which are updated on the Notecard I/O thread and checked
+// on the sensor work queue, and the pending alarm.
+static struct k_spinlock alarmLock;
+
 // Forward declarations.
 static void checkAlarm(AlarmPublisherCtx *ctx);
 static bool publishAlarm(const char *tempStatus,
@@ -50,11 +67,11 @@ static void alarmCheckTimerCb(struct k_timer *timer)
 {
     AlarmPublisherCtx *ctx = CONTAINER_OF(timer, AlarmPublisherCtx,
         alarmCheckTimer);
-    k_work_submit(&ctx->alarmCheckWorkItem);
+    schedulerSubmitSensorWork(&ctx->alarmCheckWorkItem);
 }
 
 /**
- * Callback that will be executed by the system workqueue when it's time to
+ * Callback that will be executed by the sensor work queue when it's time to
  * check for alarm conditions.
  *
  * @param item The alarm check work item.
@@ -66,6 +83,29 @@ static void alarmCheckWorkCb(struct k_work *item)
     checkAlarm(ctx);
 }
 
+/**
+ * Callback that will be executed by the Notecard I/O thread when there's an
+ * alarm to publish. Alarms are queued ahead of all other Notecard I/O.
+ *
+ * @param job The alarm job.
+ */
+static void alarmJobCb(NotecardIoJob *job)
+{
+    AlarmPublisherCtx *ctx = CONTAINER_OF(job, AlarmPublisherCtx, alarmJob);
+
+    k_spinlock_key_t key = k_spin_lock(&alarmLock);
+    Alarm alarm = ctx->alarm;
+    k_spin_unlock(&alarmLock, key);
+
+    if (!publishAlarm(alarm.tempStatus, alarm.humidStatus, alarm.temp,
+        alarm.humid)) {
+        printk("alarmJobCb: error: publishAlarm failed.\n");
+        // Let the next check raise the alarm again.
+        k_timer_stop(&ctx->alarmCooldownTimer);
+        ctx->coolingDown = false;
+    }
+}
+
 /**
  * Callback that will be executed when the alarm cooldown timer expires.
  *
@@ -122,6 +162,7 @@ AlarmPublisherCtx *alarmPublisherInit(const Bme280Ctx* bme280Ctx,
     k_timer_init(&ctx->alarmCheckTimer, alarmCheckTimerCb, NULL);
     k_timer_init(&ctx->alarmCooldownTimer, alarmCooldownTimerCb, NULL);
     k_work_init(&ctx->alarmCheckWorkItem, alarmCheckWorkCb);
+    notecardIoJobInit(&ctx->alarmJob, alarmJobCb, NOTECARD_IO_PRIO_ALARM);
 
     printk("alarmPublisherInit: Initialized alarm publisher.\n");
 
@@ -129,8 +170,9 @@ AlarmPublisherCtx *alarmPublisherInit(const Bme280Ctx* bme280Ctx,
 }
 
 /**
- * Start the alarm check timer. Alarm conditions will be checked according to
- * the interval passed to alarmPublisherInit.
+ * Start the alarm check timer. Alarm conditions are checked now and then
+ * according to the interval passed to alarmPublisherInit, aligned with the
+ * other timers (see schedulerStartTimer).
  *
  * @param ctx The publisher context object.
  *
@@ -143,8 +185,13 @@ bool alarmPublisherStart(AlarmPublisherCtx *ctx)
         return false;
     }
 
-    k_timer_start(&ctx->alarmCheckTimer, K_SECONDS(0),
-        K_SECONDS(ctx->checkInterval));
+    if (!schedulerSubmitSensorWork(&ctx->alarmCheckWorkItem)) {
+        printk("alarmPublisherStart: error: schedulerSubmitSensorWork failed."
+            "\n");
+        return false;
+    }
+    schedulerStartTimer(&ctx->alarmCheckTimer,
+        ctx->checkInterval * MSEC_PER_SEC);
     ctx->started = true;
 
     return true;
@@ -212,11 +259,14 @@ bool alarmPublisherUpdateBound(AlarmPublisherCtx* ctx, AlarmBound bound,
     k_timer_stop(&ctx->alarmCooldownTimer);
     ctx->coolingDown = false;
 
+    k_spinlock_key_t key = k_spin_lock(&alarmLock);
     *field = newVal;
+    k_spin_unlock(&alarmLock, key);
 
     if (ctx->started) {
-        k_timer_start(&ctx->alarmCheckTimer, K_SECONDS(0),
-            K_SECONDS(ctx->checkInterval));
+        schedulerSubmitSensorWork(&ctx->alarmCheckWorkItem);
+        schedulerStartTimer(&ctx->alarmCheckTimer,
+            ctx->checkInterval * MSEC_PER_SEC);
     }
 
     return true;
@@ -244,44 +294,56 @@ static void checkAlarm(AlarmPublisherCtx *ctx)
     const char *tempStatus = statusOk;
     const char *humidStatus = statusOk;
 
+    k_spinlock_key_t key = k_spin_lock(&alarmLock);
+    double tempMin = ctx->tempMin;
+    double tempMax = ctx->tempMax;
+    double humidMin = ctx->humidMin;
+    double humidMax = ctx->humidMax;
+    k_spin_unlock(&alarmLock, key);
+
     // We use printf for these alarm logs because printk doesn't support
     // printing doubles.
-    if (temp < ctx->tempMin) {
+    if (temp < tempMin) {
         tempStatus = statusLow;
         printf("checkAlarm: temp is low @ %.2f, min is %.2f.\n", temp,
-            ctx->tempMin);
+            tempMin);
     }
-    else if (temp > ctx->tempMax) {
+    else if (temp > tempMax) {
         tempStatus = statusHigh;
         printf("checkAlarm: temp is high @ %.2f, max is %.2f.\n", temp,
-            ctx->tempMax);
+            tempMax);
     }
 
-    if (humid < ctx->humidMin) {
+    if (humid < humidMin) {
         humidStatus = statusLow;
         printf("checkAlarm: humid is low @ %.2f, min is %.2f.\n", humid,
-            ctx->humidMin);
+            humidMin);
     }
-    else if (humid > ctx->humidMax) {
+    else if (humid > humidMax) {
         humidStatus = statusHigh;
         printf("checkAlarm: humid is high @ %.2f, max is %.2f.\n", humid,
-            ctx->humidMax);
+            humidMax);
     }
 
     // If either status is not "ok".
     if (strcmp(tempStatus, statusOk) || strcmp(humidStatus, statusOk)) {
-        if (!publishAlarm(tempStatus, humidStatus, temp, humid)) {
-            printk("checkAlarm: error: publishAlarm failed.\n");
-            return;
-        }
+        key = k_spin_lock(&alarmLock);
+        ctx->alarm.tempStatus = tempStatus;
+        ctx->alarm.humidStatus = humidStatus;
+        ctx->alarm.temp = temp;
+        ctx->alarm.humid = humid;
+        k_spin_unlock(&alarmLock, key);
 
         // To avoid spamming Notehub about the same alarm condition over and
-        // over, we use a cooldown timer. Once we publish an alarm, this timer
+        // over, we use a cooldown timer. Once we raise an alarm, this timer
         // counts down from ALARM_COOLDOWN_SECONDS. Only once that timer hits
-        // 0 are we allowed to publish another alarm.
+        // 0 are we allowed to raise another alarm. If publishing the alarm
+        // fails, alarmJobCb cuts the cooldown short.
         ctx->coolingDown = true;
         k_timer_start(&ctx->alarmCooldownTimer,
             K_SECONDS(ALARM_COOLDOWN_SECONDS), K_FOREVER);
+
+        notecardIoSubmit(&ctx->alarmJob);
     }
 }
 
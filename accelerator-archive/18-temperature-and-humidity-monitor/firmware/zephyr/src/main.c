@@ -12,7 +12,9 @@
 #include "alarm_publisher.h"
 #include "bme280.h"
 #include "env_updater.h"
+#include "notecard_io.h"
 #include "publisher.h"
+#include "scheduler.h"
 
 // Uncomment this line and replace com.your-company:your-product-name with your
 // ProductUID.
@@ -41,6 +43,9 @@
 #define HUMID_MAX_DEFAULT 70
 #endif
 
+// The intervals below are multiples of one another, so their timers expire
+// together and the device wakes once for all of them (see schedulerStartTimer).
+
 // Read the sensor every 30 seconds.
 #ifndef BME280_READ_INTERVAL
 #define BME280_READ_INTERVAL 30
@@ -70,27 +75,18 @@
 #define OUTBOUND_SYNC_INTERVAL 5
 #endif
 
-#ifndef NOTECARD_LOCK_POLL_INTERVAL
-#define NOTECARD_LOCK_POLL_INTERVAL 10
-#endif
-
-// Notecard locking functions.
-static bool notecardLocked = false;
+// Notecard locking functions. Requests are made from the Notecard I/O thread
+// once it's started, so the lock is normally uncontended.
+K_MUTEX_DEFINE(notecardMutex);
 
-// Attempt to get a lock on the I2C bus. This will spin forever until the lock
-// is released.
 void lockNotecard(void)
 {
-    while (notecardLocked) {
-        NoteDelayMs(NOTECARD_LOCK_POLL_INTERVAL);
-    }
-
-    notecardLocked = true;
+    k_mutex_lock(&notecardMutex, K_FOREVER);
 }
 
 void unlockNotecard(void)
 {
-    notecardLocked = false;
+    k_mutex_unlock(&notecardMutex);
 }
 
 void main(void)
@@ -99,8 +95,14 @@ void main(void)
     NoteSetFnDefault(malloc, free, platform_delay, platform_millis);
     NoteSetFnDebugOutput(noteLogPrint);
     NoteSetFnNoteMutex(lockNotecard, unlockNotecard);
+#ifdef CONFIG_BOARD_NATIVE_SIM
+    // Talk to the simulated Notecard in note_c_hooks_sim.c.
+    NoteSetFnSerial(noteSerialReset, noteSerialTransmit, noteSerialAvailable,
+                    noteSerialReceive);
+#else
     NoteSetFnI2C(NOTE_I2C_ADDR_DEFAULT, NOTE_I2C_MAX_DEFAULT, noteI2cReset,
                  noteI2cTransmit, noteI2cReceive);
+#endif
 
     J *req = NoteNewRequest("hub.set");
     if (PRODUCT_UID[0]) {
@@ -117,6 +119,17 @@ void main(void)
         return;
     }
 
+    // From here on, sensor reads and alarm checks run on the sensor work queue
+    // and all Notecard requests are made from the Notecard I/O thread.
+    if (!schedulerInit()) {
+        printk("schedulerInit failed, aborting.\n");
+        return;
+    }
+    if (!notecardIoStart()) {
+        printk("notecardIoStart failed, aborting.\n");
+        return;
+    }
+
     Bme280Ctx* bme280Ctx;
     if ((bme280Ctx = bme280Init()) == NULL) {
         printk("bme280Init failed, aborting.\n");
@@ -162,9 +175,9 @@ void main(void)
         return;
     }
 
-    while (true) {
-        k_sleep(K_SECONDS(10));
-    }
+    // Everything runs from timers from here on. Between them, the idle thread
+    // puts the MCU into the deepest sleep state that fits (see CONFIG_PM).
+    k_sleep(K_FOREVER);
 }
 
 void NoteUserAgentUpdate(J *ua) {
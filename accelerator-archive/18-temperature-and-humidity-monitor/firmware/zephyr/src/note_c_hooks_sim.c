@@ -0,0 +1,104 @@
+// Notecard hooks for native_sim, where there's no Notecard. They stand in for
+// one on the serial interface: every request gets an empty JSON object back
+// after NOTECARD_SIM_LATENCY_MS, which is enough for the firmware to run and
+// shows how the Notecard I/O thread copes with slow transactions.
+
+#include "note_c_hooks.h"
+
+#include <string.h>
+
+#include <zephyr/kernel.h>
+
+#ifndef NOTECARD_SIM_LATENCY_MS
+#define NOTECARD_SIM_LATENCY_MS 1000
+#endif
+
+#ifndef NOTECARD_SIM_LINE_MAX
+#define NOTECARD_SIM_LINE_MAX 512
+#endif
+
+static char line[NOTECARD_SIM_LINE_MAX];
+static size_t lineLen = 0;
+static const char *reply = NULL;
+static uint32_t replyAtMs = 0;
+
+uint32_t platform_millis(void)
+{
+    return k_uptime_get_32();
+}
+
+void platform_delay(uint32_t ms)
+{
+    k_msleep(ms);
+}
+
+size_t noteLogPrint(const char *message_)
+{
+    if (message_)
+    {
+        printk("%s", message_);
+        return 1;
+    }
+
+    return 0;
+}
+
+// Answer a complete line from note-c. A blank line is note-c resynchronizing
+// and is echoed straight away, a "cmd" expects no reply and anything else is a
+// request.
+static void handleLine(void)
+{
+    line[lineLen] = '\0';
+
+    if (lineLen == 0) {
+        reply = "\r\n";
+        replyAtMs = k_uptime_get_32();
+    }
+    else if (strstr(line, "\"cmd\":") != NULL) {
+        printk("handleLine: %s\n", line);
+        reply = NULL;
+    }
+    else {
+        printk("handleLine: %s\n", line);
+        reply = "{}\r\n";
+        replyAtMs = k_uptime_get_32() + NOTECARD_SIM_LATENCY_MS;
+    }
+
+    lineLen = 0;
+}
+
+bool noteSerialAvailable(void)
+{
+    return reply != NULL && *reply != '\0' &&
+           (int32_t)(k_uptime_get_32() - replyAtMs) >= 0;
+}
+
+char noteSerialReceive(void)
+{
+    if (!noteSerialAvailable()) {
+        return 0;
+    }
+
+    return *reply++;
+}
+
+bool noteSerialReset(void)
+{
+    lineLen = 0;
+    reply = NULL;
+
+    return true;
+}
+
+void noteSerialTransmit(uint8_t *text_, size_t len_, bool flush_)
+{
+    for (size_t i = 0; i < len_; i++)
+    {
+        if (text_[i] == '\n') {
+            handleLine();
+        }
+        else if (text_[i] != '\r' && lineLen < sizeof(line) - 1) {
+            line[lineLen++] = text_[i];
+        }
+    }
+}
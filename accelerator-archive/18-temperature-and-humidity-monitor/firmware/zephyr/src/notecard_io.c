@@ -0,0 +1,165 @@
+// Zephyr headers.
+#include <zephyr/kernel.h>
+
+// Application headers.
+#include "notecard_io.h"
+
+// All Notecard transactions run on this thread, so a slow transaction delays
+// other Notecard I/O but never sensor reads or alarm checks, which run on the
+// higher priority sensor work queue (see scheduler.c).
+#ifndef NOTECARD_IO_STACK_SIZE
+#define NOTECARD_IO_STACK_SIZE 4096
+#endif
+
+#ifndef NOTECARD_IO_THREAD_PRIORITY
+#define NOTECARD_IO_THREAD_PRIORITY K_PRIO_PREEMPT(8)
+#endif
+
+// Each job is queued at most once, so this only needs to hold as many jobs as
+// there are at one priority.
+#ifndef NOTECARD_IO_QUEUE_LEN
+#define NOTECARD_IO_QUEUE_LEN 4
+#endif
+
+// Log how long each job waited and ran. On by default for native_sim, where
+// checking the scheduling is the point of the build.
+#ifndef NOTECARD_IO_TRACE
+#define NOTECARD_IO_TRACE IS_ENABLED(CONFIG_BOARD_NATIVE_SIM)
+#endif
+
+K_MSGQ_DEFINE(alarmQueue, sizeof(NotecardIoJob *), NOTECARD_IO_QUEUE_LEN, 4);
+K_MSGQ_DEFINE(telemetryQueue, sizeof(NotecardIoJob *), NOTECARD_IO_QUEUE_LEN,
+    4);
+K_MSGQ_DEFINE(backgroundQueue, sizeof(NotecardIoJob *), NOTECARD_IO_QUEUE_LEN,
+    4);
+
+// Indexed by NotecardIoPriority.
+static struct k_msgq *const queues[NOTECARD_IO_PRIO_COUNT] = {
+    &alarmQueue,
+    &telemetryQueue,
+    &backgroundQueue
+};
+
+// Counts the jobs across all the queues.
+K_SEM_DEFINE(jobsQueued, 0, K_SEM_MAX_LIMIT);
+
+K_THREAD_STACK_DEFINE(notecardIoStack, NOTECARD_IO_STACK_SIZE);
+static struct k_thread notecardIoThread;
+static bool started = false;
+
+/**
+ * Initialize a job. Must be called before the job is submitted.
+ *
+ * @param job      The job.
+ * @param handler  The function to run on the Notecard I/O thread.
+ * @param priority The priority to queue the job at.
+ */
+void notecardIoJobInit(NotecardIoJob *job, NotecardIoHandler handler,
+    NotecardIoPriority priority)
+{
+    job->handler = handler;
+    job->priority = priority;
+    atomic_clear(&job->queued);
+    job->queuedMs = 0;
+}
+
+/**
+ * Take the next job, highest priority first.
+ *
+ * @return The job, or NULL if none is queued.
+ */
+static NotecardIoJob *nextJob(void)
+{
+    NotecardIoJob *job;
+
+    for (int prio = 0; prio < NOTECARD_IO_PRIO_COUNT; ++prio) {
+        if (k_msgq_get(queues[prio], &job, K_NO_WAIT) == 0) {
+            return job;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * Entry point of the Notecard I/O thread.
+ */
+static void notecardIoThreadFn(void *p1, void *p2, void *p3)
+{
+    while (true) {
+        k_sem_take(&jobsQueued, K_FOREVER);
+
+        NotecardIoJob *job = nextJob();
+        if (job == NULL) {
+            continue;
+        }
+
+        // Clear the flag before running the handler, so the job can be
+        // submitted again while it runs.
+        atomic_clear(&job->queued);
+        uint32_t startMs = k_uptime_get_32();
+        job->handler(job);
+
+        if (NOTECARD_IO_TRACE) {
+            printk("notecardIoThreadFn: priority %d job waited %u ms, ran %u "
+                "ms.\n", job->priority, startMs - job->queuedMs,
+                k_uptime_get_32() - startMs);
+        }
+    }
+}
+
+/**
+ * Start the Notecard I/O thread. From here on, all Notecard requests should be
+ * made from job handlers. Jobs submitted before this are run once the thread
+ * starts.
+ *
+ * @return True on success and false on failure.
+ */
+bool notecardIoStart(void)
+{
+    if (started) {
+        printk("notecardIoStart: error: Already started.\n");
+        return false;
+    }
+
+    k_thread_create(&notecardIoThread, notecardIoStack,
+        K_THREAD_STACK_SIZEOF(notecardIoStack), notecardIoThreadFn, NULL, NULL,
+        NULL, NOTECARD_IO_THREAD_PRIORITY, 0, K_NO_WAIT);
+    k_thread_name_set(&notecardIoThread, "notecard_io");
+    started = true;
+
+    printk("notecardIoStart: Started Notecard I/O thread.\n");
+
+    return true;
+}
+
+/**
+ * Queue a job to run on the Notecard I/O thread. Safe to call from timer
+ * callbacks and interrupts.
+ *
+ * @param job The job.
+ *
+ * @return True if the job was queued and false if it was already queued or
+ *         couldn't be.
+ */
+bool notecardIoSubmit(NotecardIoJob *job)
+{
+    if (job == NULL || job->priority >= NOTECARD_IO_PRIO_COUNT) {
+        printk("notecardIoSubmit: error: Invalid job.\n");
+        return false;
+    }
+    if (!atomic_cas(&job->queued, 0, 1)) {
+        return false;
+    }
+
+    job->queuedMs = k_uptime_get_32();
+    if (k_msgq_put(queues[job->priority], &job, K_NO_WAIT) != 0) {
+        atomic_clear(&job->queued);
+        printk("notecardIoSubmit: error: Queue for priority %d is full.\n",
+            job->priority);
+        return false;
+    }
+    k_sem_give(&jobsQueued);
+
+    return true;
+}
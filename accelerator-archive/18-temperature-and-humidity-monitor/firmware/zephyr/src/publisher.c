@@ -11,16 +11,18 @@
 // Application headers.
 #include "publisher.h"
 #include "bme280.h"
+#include "notecard_io.h"
+#include "scheduler.h"
 
 struct PublisherCtx {
     const Bme280Ctx *bme280Ctx;
-    struct k_work publishWorkItem;
+    NotecardIoJob publishJob;
     struct k_timer publishTimer;
 };
 
 // Forward declarations.
 static void publishTimerCb(struct k_timer *timer);
-static void publishWorkCb(struct k_work *item);
+static void publishJobCb(NotecardIoJob *job);
 
 static bool publish(PublisherCtx* ctx)
 {
@@ -91,7 +93,8 @@ PublisherCtx *publisherInit(const Bme280Ctx *bme280Ctx)
 
     ctx->bme280Ctx = bme280Ctx;
 
-    k_work_init(&ctx->publishWorkItem, publishWorkCb);
+    notecardIoJobInit(&ctx->publishJob, publishJobCb,
+        NOTECARD_IO_PRIO_TELEMETRY);
     k_timer_init(&ctx->publishTimer, publishTimerCb, NULL);
 
     printk("publisherInit: Initialized publisher.\n");
@@ -100,8 +103,9 @@ PublisherCtx *publisherInit(const Bme280Ctx *bme280Ctx)
 }
 
 /**
- * Start the publish timer. A Note will be published periodically according to
- * the interval.
+ * Start the publish timer. A Note is published now and then periodically
+ * according to the interval, aligned with the other timers (see
+ * schedulerStartTimer).
  *
  * @param ctx      The publisher context object.
  * @param interval The publish interval, in seconds.
@@ -119,7 +123,8 @@ bool publisherStart(PublisherCtx *ctx, uint32_t interval)
         return false;
     }
 
-    k_timer_start(&ctx->publishTimer, K_SECONDS(0), K_SECONDS(interval));
+    notecardIoSubmit(&ctx->publishJob);
+    schedulerStartTimer(&ctx->publishTimer, interval * MSEC_PER_SEC);
 
     return true;
 }
@@ -152,17 +157,17 @@ bool publisherStop(PublisherCtx *ctx)
 static void publishTimerCb(struct k_timer *timer)
 {
     PublisherCtx *ctx = CONTAINER_OF(timer, PublisherCtx, publishTimer);
-    k_work_submit(&ctx->publishWorkItem);
+    notecardIoSubmit(&ctx->publishJob);
 }
 
 /**
- * Callback that will be executed by the system workqueue when it's time to
+ * Callback that will be executed by the Notecard I/O thread when it's time to
  * publish.
  *
- * @param item The publish work item.
+ * @param job The publish job.
  */
-static void publishWorkCb(struct k_work *item)
+static void publishJobCb(NotecardIoJob *job)
 {
-    PublisherCtx *ctx = CONTAINER_OF(item, PublisherCtx, publishWorkItem);
+    PublisherCtx *ctx = CONTAINER_OF(job, PublisherCtx, publishJob);
     publish(ctx);
 }
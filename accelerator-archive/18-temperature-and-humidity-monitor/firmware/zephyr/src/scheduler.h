@@ -0,0 +1,12 @@
+#pragma once
+
+// C standard headers.
+#include <stdint.h>
+#include <stdbool.h>
+
+// Zephyr headers.
+#include <zephyr/kernel.h>
+
+bool schedulerInit(void);
+bool schedulerSubmitSensorWork(struct k_work *item);
+void schedulerStartTimer(struct k_timer *timer, uint32_t intervalMs);
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <stdint.h>
+
+#define HOURS_PER_WEEK (24*7)
+
+/**
+ * @brief Weight of the latest hour in the hourly sales rate.
+ */
+#ifndef SALES_RATE_ALPHA
+#define SALES_RATE_ALPHA (0.3f)
+#endif
+
+/**
+ * @brief Weight of the latest hour in the mean sales rate, which stands in for hours of the
+ * week that haven't been seen yet. About a day's memory.
+ */
+#ifndef SALES_MEAN_ALPHA
+#define SALES_MEAN_ALPHA (1.0f/24)
+#endif
+
+/**
+ * @brief How far ahead a stock-out is forecast.
+ */
+#ifndef STOCKOUT_HORIZON_HOURS
+#define STOCKOUT_HORIZON_HOURS (14*24)
+#endif
+
+#define SALES_RATE_UNKNOWN (-1.0f)
+#define STOCKOUT_UNKNOWN (-1.0f)
+
+/**
+ * @brief The sales rate of one dispensing column, as an exponentially weighted moving
+ * average for each hour of the week, so that a busy lunchtime or a quiet weekend is
+ * forecast as such.
+ *
+ * Hours are numbered from the Unix epoch in local time. Sales are counted for the current hour,
+ * and folded into the rate for that hour of the week when the hour ends. Hours while the column
+ * isn't monitored (e.g. during a power failure) are skipped rather than counted as no sales.
+ */
+class SalesModel {
+
+    float hourlyRate[HOURS_PER_WEEK];   // items per hour, or SALES_RATE_UNKNOWN
+    float meanRate;
+    int32_t currentHour;                // the hour being counted, or -1 when not counting
+    uint16_t soldThisHour;
+
+    void closeHour(int32_t hour, uint16_t sold) {
+        float& rate = hourlyRate[hour % HOURS_PER_WEEK];
+        rate = (rate < 0) ? sold : SALES_RATE_ALPHA*sold + (1-SALES_RATE_ALPHA)*rate;
+        meanRate = (meanRate < 0) ? sold : SALES_MEAN_ALPHA*sold + (1-SALES_MEAN_ALPHA)*meanRate;
+    }
+
+public:
+    SalesModel() {
+        reset();
+    }
+
+    void reset() {
+        for (int i=0; i<HOURS_PER_WEEK; i++) {
+            hourlyRate[i] = SALES_RATE_UNKNOWN;
+        }
+        meanRate = SALES_RATE_UNKNOWN;
+        suspend();
+    }
+
+    /**
+     * @brief Stop counting until the next `advance()`. The current hour is discarded.
+     */
+    void suspend() {
+        currentHour = -1;
+        soldThisHour = 0;
+    }
+
+    /**
+     * @brief Moves the model on to the given hour, closing the hours that have ended.
+     */
+    void advance(int32_t hour) {
+        if (currentHour < 0 || hour < currentHour || hour-currentHour > HOURS_PER_WEEK) {
+            // not counting, or the clock jumped
+            currentHour = hour;
+            soldThisHour = 0;
+            return;
+        }
+        while (currentHour < hour) {
+            closeHour(currentHour++, soldThisHour);
+            soldThisHour = 0;
+        }
+    }
+
+    bool isCounting() const { return currentHour >= 0; }
+
+    void recordSales(uint16_t count) {
+        if (isCounting()) {
+            soldThisHour += count;
+        }
+    }
+
+    /**
+     * @brief Takes back sales recorded this hour, when the item count goes back up by less than
+     * a restock.
+     */
+    void correctSales(uint16_t count) {
+        soldThisHour = count < soldThisHour ? soldThisHour-count : 0;
+    }
+
+    /**
+     * @brief The expected sales per hour at the given hour.
+     */
+    float rate(int32_t hour) const {
+        float r = hourlyRate[hour % HOURS_PER_WEEK];
+        if (r < 0) {
+            r = meanRate;
+        }
+        return r < 0 ? 0 : r;
+    }
+
+    /**
+     * @brief Forecasts when the column will be empty by running the hourly rates forward.
+     *
+     * @param items     The number of items in the column.
+     * @param hour      The current hour.
+     * @param fraction  How far through the current hour it is, 0 to 1.
+     * @return The hours until the column is empty, or STOCKOUT_UNKNOWN if that's not
+     *  within STOCKOUT_HORIZON_HOURS.
+     */
+    float hoursToStockout(int16_t items, int32_t hour, float fraction) const {
+        if (items <= 0) {
+            return 0;
+        }
+        float remaining = items;
+        float elapsed = 0;
+        for (int32_t i=0; i<STOCKOUT_HORIZON_HOURS; i++) {
+            float span = i ? 1 : 1-fraction;
+            float r = rate(hour+i);
+            if (r*span >= remaining) {
+                return elapsed + remaining/r;
+            }
+            remaining -= r*span;
+            elapsed += span;
+        }
+        return STOCKOUT_UNKNOWN;
+    }
+};
@@ -7,6 +7,7 @@
 #include "app.h"
 #include "notecard-aux-serial.h"
 #include "notecard-sleep.h"
+#include "sales-model.h"
 #include "vl53l4cd_class.h"
 
 #include <math.h>
@@ -24,6 +25,21 @@
 #define DEFAULT_REPORT_INTERVAL (0)
 #endif
 
+// The shortest interval between reports, used when a column is about to run out.
+#ifndef DEFAULT_REPORT_MIN_INTERVAL
+#define DEFAULT_REPORT_MIN_INTERVAL (1000*60*15)
+#endif
+
+// Reports are sent often enough that about this many arrive before the first forecast stock-out.
+#ifndef REPORTS_BEFORE_STOCKOUT
+#define REPORTS_BEFORE_STOCKOUT (8)
+#endif
+
+// An item count that goes up by less than this is taken as a measurement correction, not a restock.
+#ifndef RESTOCK_MIN_ITEMS
+#define RESTOCK_MIN_ITEMS (2)
+#endif
+
 #ifndef DEFAULT_POLL_ENVIRONMENT_INTERVAL
 #define DEFAULT_POLL_ENVIRONMENT_INTERVAL (1000*60*5)
 #endif
@@ -83,6 +99,10 @@
 #define DATA_FIELD_CHANGES "changes"
 #define DATA_FIELD_DISTANCE "dist_mm"
 #define DATA_FIELD_ITEMS "items"
+#define DATA_FIELD_SOLD "sold"
+#define DATA_FIELD_RESTOCKED "restocked"
+#define DATA_FIELD_STOCKOUT "stockout"
+#define DATA_FIELD_STOCKOUT_HOURS "stockout_hours"
 
 #define COLUMN_NAME_LEN 32
 #define COLUMN_COUNT_MAX 7
@@ -95,6 +115,65 @@
 static uint8_t COLUMN_PINS[] = { D5, D6, D9, D10, D11, D12, D13 };
 static_assert(sizeof(COLUMN_PINS)==COLUMN_COUNT_MAX, "There should be 7 columns max");
 
+/**
+ * @brief The pin connected to the `GPIO1` interrupt output of every ToF sensor. The outputs are
+ * open-drain and active low, so they are wired together: the line is low while any sensor has
+ * a range to collect.
+ */
+#ifndef TOF_INT_PIN
+#define TOF_INT_PIN A0
+#endif
+
+/**
+ * @brief ToF ranging runs in autonomous low-power mode: one TOF_TIMING_BUDGET_MS range every
+ * TOF_INTER_MEASUREMENT_MS, on all sensors at once.
+ */
+#ifndef TOF_TIMING_BUDGET_MS
+#define TOF_TIMING_BUDGET_MS 50
+#endif
+
+#ifndef TOF_INTER_MEASUREMENT_MS
+#define TOF_INTER_MEASUREMENT_MS 200
+#endif
+
+/**
+ * @brief The number of ranges whose median sets the column level.
+ */
+#ifndef TOF_MEDIAN_SAMPLES
+#define TOF_MEDIAN_SAMPLES 5
+#endif
+
+/**
+ * @brief How far the level may move either side of the last median before the sensor
+ * interrupts, when the column's item height isn't configured. Otherwise half an item is used.
+ */
+#ifndef TOF_LEVEL_MARGIN_MM
+#define TOF_LEVEL_MARGIN_MM 10
+#endif
+
+/**
+ * @brief While a column level is steady its sensor doesn't interrupt, so the latest range is
+ * read at this interval to check that the sensor is still responding.
+ */
+#ifndef TOF_HEARTBEAT_MS
+#define TOF_HEARTBEAT_MS (10*1000)
+#endif
+
+// `window` values for VL53L4CD_SetDetectionThresholds(). TOF_INTERRUPT_NEW_SAMPLE is the
+// sensor's default set by InitSensor(), which interrupts on every range.
+#define TOF_INTERRUPT_OUT_OF_WINDOW 2
+#define TOF_INTERRUPT_NEW_SAMPLE 0x20
+
+/**
+ * @brief Set when the ToF interrupt line falls. The line is also checked directly, since
+ * while one sensor holds it low, another sensor becoming ready doesn't produce an edge.
+ */
+volatile bool tofInterrupt = false;
+
+void tofInterruptHandler() {
+    tofInterrupt = true;
+}
+
 #ifndef NOTECARD_SEND_EVENT_TIMEOUT
 #define NOTECARD_SEND_EVENT_TIMEOUT 5
 #endif
@@ -123,6 +202,40 @@ bool sendNotecardEvent(J* body, const char* file, bool sync) {
     return notecard.sendRequestWithRetry(req, NOTECARD_SEND_EVENT_TIMEOUT);
 }
 
+/**
+ * @brief The time from `card.time`, used to place sales in the hour of the week.
+ * `timeEpoch` is zero until the Notecard knows the time.
+ */
+uint32_t timeEpoch;
+uint32_t timeMillis;
+int32_t timeZoneOffset;
+
+/**
+ * @brief Fetches the time and UTC offset from the Notecard.
+ *
+ * @return true the time is known.
+ */
+bool readNotecardTime() {
+    J* rsp = notecard.requestAndResponse(notecard.newRequest("card.time"));
+    if (rsp == NULL) {
+        return false;
+    }
+    if (!notecard.responseError(rsp) && JGetNumber(rsp, "time") > 0) {
+        timeEpoch = (uint32_t)JGetNumber(rsp, "time");
+        timeMillis = millis();
+        timeZoneOffset = JGetInt(rsp, "minutes") * 60;
+    }
+    notecard.deleteResponse(rsp);
+    return timeEpoch != 0;
+}
+
+/**
+ * @brief The current UTC time in seconds, or zero if it isn't known.
+ */
+uint32_t currentTime() {
+    return timeEpoch ? timeEpoch + (millis()-timeMillis)/1000 : 0;
+}
+
 /**
  * @brief Describes an alert condition, which may be active or inactive.
  */
@@ -319,15 +432,45 @@ class DispensingColumn {
     VL53L4CD distanceSensor;
 
     /**
-     * @brief The most recently sampled distance
+     * @brief The median of the last TOF_MEDIAN_SAMPLES ranges.
      */
     VL53L4CD_Result_t distance;
 
+    /**
+     * @brief Ranges collected towards the next median.
+     */
+    VL53L4CD_Result_t samples[TOF_MEDIAN_SAMPLES];
+    uint8_t sampleCount;
+
+    /**
+     * @brief When true, the sensor only interrupts when a range falls outside
+     * [windowLow, windowHigh]. When false, it interrupts on every range and the column is
+     * collecting samples.
+     */
+    bool levelWindowArmed;
+    uint16_t windowLow;
+    uint16_t windowHigh;
+
+    /**
+     * @brief The time the sensor was last checked while the level window is armed.
+     */
+    uint32_t lastHeartbeat;
+
     /**
      * @brief An alert for the ToF sensor going offline.
      */
     ColumnAlert sensorOfflineAlert;
 
+    /**
+     * @brief The sales rate of this column, learned from vend events.
+     */
+    SalesModel sales;
+
+    /**
+     * @brief The forecast hours until this column is empty, or STOCKOUT_UNKNOWN.
+     */
+    float stockoutHours;
+
     /**
      * @brief The time of the last successful read from the distance sensor.
      * Used to set an alert when the sensor is offline. When non-zero, indicates that the sensor
@@ -342,6 +485,8 @@ class DispensingColumn {
 
     void reset() {
         memset(&distance, 0, sizeof(distance));
+        sampleCount = 0;
+        levelWindowArmed = false;
         items.reset();
     }
 
@@ -353,6 +498,7 @@ class DispensingColumn {
     void updateEnabled(bool enabled) {
         this->enabled = enabled;
         if (!enabled) { // sensor is initialized as part of read to handle intermittent bus failures
+            sales.suspend();    // sales aren't seen while the column is off
             reset();
             deinitializeDistanceSensor();
             sensorOnline = false;
@@ -365,15 +511,81 @@ class DispensingColumn {
         //Initialize VL53L4CD satellite component.
         int status = distanceSensor.InitSensor(sensorAddress);
 
-        // Program the highest possible TimingBudget, without enabling the
-        // low power mode. This should give the best accuracy
-        status = status || distanceSensor.VL53L4CD_SetRangeTiming(200, 0);
+        // Autonomous low-power mode. Accuracy comes from the median of several ranges rather
+        // than from a long timing budget.
+        status = status || distanceSensor.VL53L4CD_SetRangeTiming(TOF_TIMING_BUDGET_MS, TOF_INTER_MEASUREMENT_MS);
 
         // Start Measurements
         status = status || distanceSensor.VL53L4CD_StartRanging();
+        sampleCount = 0;
+        levelWindowArmed = false;
         return status;
     }
 
+    /**
+     * @brief Changes which ranges raise the sensor's interrupt.
+     */
+    int setInterruptWindow(uint16_t low, uint16_t high, uint8_t window) {
+        int status = distanceSensor.VL53L4CD_StopRanging();
+        status = status || distanceSensor.VL53L4CD_SetDetectionThresholds(low, high, window);
+        status = status || distanceSensor.VL53L4CD_StartRanging();
+        return status;
+    }
+
+    /**
+     * @brief Interrupt only when the level moves away from the current median, so a steady
+     * column causes no interrupts and no I2C traffic.
+     */
+    void armLevelWindow() {
+        uint16_t margin = columnSize.canHeight ? columnSize.canHeight/2 : TOF_LEVEL_MARGIN_MM;
+        uint16_t d = distance.distance_mm;
+        windowLow = d > margin ? d-margin : 0;
+        windowHigh = d+margin;
+        levelWindowArmed = !setInterruptWindow(windowLow, windowHigh, TOF_INTERRUPT_OUT_OF_WINDOW);
+        lastHeartbeat = millis();
+    }
+
+    /**
+     * @brief Interrupt on every range again and collect a new set of samples.
+     */
+    void startSampling() {
+        sampleCount = 0;
+        if (levelWindowArmed) {
+            levelWindowArmed = false;
+            if (setInterruptWindow(0, 0, TOF_INTERRUPT_NEW_SAMPLE)) {
+                sensorOnline = false;   // re-initialized on the next check
+            }
+        }
+    }
+
+    /**
+     * @brief Adds a range to the samples. Once TOF_MEDIAN_SAMPLES have been collected, the
+     * column state is updated from their median and the level window is armed.
+     */
+    void addSample(const VL53L4CD_Result_t& result) {
+        samples[sampleCount++] = result;
+        if (sampleCount < TOF_MEDIAN_SAMPLES) {
+            return;
+        }
+        sampleCount = 0;
+
+        // insertion sort by distance; TOF_MEDIAN_SAMPLES is small
+        for (uint8_t i = 1; i < TOF_MEDIAN_SAMPLES; i++) {
+            VL53L4CD_Result_t r = samples[i];
+            uint8_t j = i;
+            for (; j > 0 && samples[j-1].distance_mm > r.distance_mm; j--) {
+                samples[j] = samples[j-1];
+            }
+            samples[j] = r;
+        }
+        distance = samples[TOF_MEDIAN_SAMPLES/2];
+        updateColumnState();
+
+        if (!distance.range_status) {
+            armLevelWindow();
+        }
+    }
+
     int deinitializeDistanceSensor() {
         distanceSensor.VL53L4CD_StopRanging();
         distanceSensor.VL53L4CD_Off();
@@ -424,8 +636,50 @@ class DispensingColumn {
         items.fillState = fillState;
 
         if (items.itemCount != prevItems.itemCount || items.fillState != prevItems.fillState) {
-            columnStateChanged(prevItems, items);
+            int sold = 0;
+            int restocked = 0;
+            if (prevItems.isOnline() && items.isOnline() &&
+                prevItems.itemCount != ITEM_COUNT_UNKNOWN && items.itemCount != ITEM_COUNT_UNKNOWN) {
+                int delta = items.itemCount - prevItems.itemCount;
+                updateSalesHour();
+                if (delta < 0) {
+                    sold = -delta;
+                    sales.recordSales(sold);
+                }
+                else if (delta >= RESTOCK_MIN_ITEMS) {
+                    restocked = delta;
+                }
+                else if (delta > 0) {
+                    sales.correctSales(delta);
+                }
+            }
+            updateForecast();
+            columnStateChanged(prevItems, items, sold, restocked);
+        }
+    }
+
+    /**
+     * @brief Moves the sales model on to the current hour. Sales aren't counted until the
+     * time is known.
+     */
+    void updateSalesHour() {
+        uint32_t now = currentTime();
+        if (now) {
+            sales.advance((int32_t)((now + timeZoneOffset) / 3600));
+        }
+    }
+
+    /**
+     * @brief Updates the forecast stock-out time from the item count and sales rate.
+     */
+    void updateForecast() {
+        uint32_t now = currentTime();
+        if (!now || !items.isOnline() || items.itemCount == ITEM_COUNT_UNKNOWN) {
+            stockoutHours = STOCKOUT_UNKNOWN;
+            return;
         }
+        uint32_t local = now + timeZoneOffset;
+        stockoutHours = sales.hoursToStockout(items.itemCount, local / 3600, (local % 3600) / 3600.0f);
     }
 
     /**
@@ -443,6 +697,10 @@ class DispensingColumn {
             JAddNumberToObject(body, DATA_FIELD_DISTANCE, this->distance.distance_mm);
             JAddNumberToObject(body, DATA_FIELD_ITEMS, items.itemCount);
         }
+        if (stockoutHours >= 0) {
+            JAddNumberToObject(body, DATA_FIELD_STOCKOUT, currentTime() + (uint32_t)(stockoutHours*3600));
+            JAddNumberToObject(body, DATA_FIELD_STOCKOUT_HOURS, round(stockoutHours*10)/10);
+        }
         return body;
     }
 
@@ -452,8 +710,10 @@ class DispensingColumn {
      * 
      * @param prev      The previous column state
      * @param current   The current column state
+     * @param sold      The number of items dispensed since the previous state
+     * @param restocked The number of items added since the previous state
      */
-    void columnStateChanged(const DispensingItems& prev, const DispensingItems& current) {
+    void columnStateChanged(const DispensingItems& prev, const DispensingItems& current, int sold, int restocked) {
         char changed[128];
         *changed = 0;
         J* body = buildColumnEvent(current);
@@ -469,13 +729,20 @@ class DispensingColumn {
             JAddStringToObject(body, DATA_FIELD_CHANGES, changed+1);    // skip the initial comma
         }
 
+        if (sold) {
+            JAddNumberToObject(body, DATA_FIELD_SOLD, sold);
+        }
+        if (restocked) {
+            JAddNumberToObject(body, DATA_FIELD_RESTOCKED, restocked);
+        }
+
         if (prev.isOnline() && current.isOnline()) {
             // add a text field with human-readable change details
             const char* text = nullptr;
-            if (prev.fillState != DispensingItems::COLUMN_FULL && current.fillState==DispensingItems::COLUMN_FULL) {
+            if (restocked || (prev.fillState != DispensingItems::COLUMN_FULL && current.fillState==DispensingItems::COLUMN_FULL)) {
                 text = "Column restocked.";
             }
-            else if (prev.itemCount < current.itemCount) {
+            else if (sold) {
                 text = "Item dispensed.";
             }
             if (text) {
@@ -507,9 +774,10 @@ public:
         next(nullptr),
         column(column),
         sensorOfflineAlert(*this, TEXT_SENSOR_OFFLINE, TEXT_SENSOR_ONLINE),
+        stockoutHours(STOCKOUT_UNKNOWN),
         lastSuccessfulRead(0), sensorOnline(false)
     {
-        items.reset();
+        reset();
         setName(nullptr);   // use the default name until configured by the environment
         distanceSensor.begin(); // set XSHUT low
     }
@@ -531,6 +799,7 @@ public:
     }
 
     uint8_t columnNumber() const { return this->column; }
+    float hoursToStockout() const { return stockoutHours; }
     const DispensingItems& currentItems() const { return items; }
     SodaStack& size() { return this->columnSize; }
 
@@ -543,12 +812,41 @@ public:
         return changed;
     }
 
-    bool readDistance() {
-        if (!enabled) {     // nothing to do
+    /**
+     * @brief Collects a range if the sensor has one ready. Called when the ToF interrupt line
+     * is asserted, and so only reads the sensor over I2C when it has something to report.
+     *
+     * @return true a range was collected.
+     */
+    bool collectRange() {
+        if (!enabled || !sensorOnline || !isToFSensorReady(distanceSensor)) {
             return false;
         }
 
-        memset(&distance, 0, sizeof(distance));
+        VL53L4CD_Result_t result;
+        if (readToFSensor(distanceSensor, result)) {
+            return false;
+        }
+        if (result.distance_mm) {
+            lastSuccessfulRead = millis();
+            printSensorReport(columnNumber(), result, debug);
+        }
+        if (levelWindowArmed) {
+            // the level has moved; measure it again
+            startSampling();
+        }
+        addSample(result);
+        return true;
+    }
+
+    /**
+     * @brief Initializes the sensor when needed, checks that it's still responding and raises
+     * or clears the offline alert. Ranges are collected by `collectRange()`.
+     */
+    void checkDistanceSensor() {
+        if (!enabled) {     // nothing to do
+            return;
+        }
 
         if (!sensorOnline) {
             if (!initializeDistanceSensor()) {
@@ -558,29 +856,50 @@ public:
             }
         }
 
-        int error = 1;
         if (sensorOnline) {
-            if (isToFSensorReady(distanceSensor)) {
-                error = readToFSensor(distanceSensor, distance);
+            if (!levelWindowArmed) {
+                // also collects samples when the interrupt line isn't connected
+                collectRange();
+            }
+            else if ((millis()-lastHeartbeat)>=TOF_HEARTBEAT_MS) {
+                lastHeartbeat = millis();
+                VL53L4CD_Result_t result;
+                if (!distanceSensor.VL53L4CD_GetResult(&result) && result.distance_mm) {
+                    lastSuccessfulRead = millis();
+                    if (result.distance_mm < windowLow || result.distance_mm > windowHigh) {
+                        startSampling();    // a missed interrupt
+                    }
+                }
             }
-        }
-        if (!error && distance.distance_mm) {
-            lastSuccessfulRead = millis();
-            printSensorReport(columnNumber(), distance, debug);
         }
 
         bool offlineTimeout = !sensorOnline || (millis()-lastSuccessfulRead)>=DISTANCE_SENSOR_OFFLINE_TIMEOUT_MS;
         bool alertChanged = sensorOfflineAlert.setActive(offlineTimeout);
+        if (sensorOnline) {
+            updateSalesHour();
+            updateForecast();
+        }
+        else {
+            sales.suspend();
+        }
+
         if (alertChanged && offlineTimeout) {
             sensorOnline = false;
             deinitializeDistanceSensor();
             debug.printf("col %d: alert. ToF sensor offline.", columnNumber());
             debug.println();
-        }
-        if ((sensorOnline && !error) || alertChanged) {
+            // back online, the state is updated once a median has been measured
             updateColumnState();
         }
-        return !error;
+    }
+
+    /**
+     * @brief Measures the level again, e.g. after the column sizes have changed.
+     */
+    void resample() {
+        if (enabled && sensorOnline) {
+            startSampling();
+        }
     }
 
     bool sendMonitoringEvent() {
@@ -628,6 +947,7 @@ bool usbPower;
 uint32_t readSensorsInterval = DEFAULT_POLL_SENSORS_INTERVAL;
 uint32_t readSensorsMs;
 uint32_t sendReportInterval = DEFAULT_REPORT_INTERVAL;
+uint32_t reportMinInterval = DEFAULT_REPORT_MIN_INTERVAL;
 uint32_t sendReportMs;
 uint32_t pollEnvironmentInterval = DEFAULT_POLL_ENVIRONMENT_INTERVAL;
 uint32_t pollEnvironmentMs;
@@ -724,6 +1044,30 @@ void sendReport() {
     }
 }
 
+/**
+ * @brief The interval until the next report. Reports are sent every `sendReportInterval` while
+ * no column is forecast to run out soon, and more often as the first stock-out approaches, down
+ * to `reportMinInterval`.
+ */
+uint32_t reportInterval() {
+    float soonest = STOCKOUT_UNKNOWN;
+    for (DispensingColumn* column = columns; column; column = column->next) {
+        float hours = column->hoursToStockout();
+        if (hours > 0 && (soonest < 0 || hours < soonest)) {
+            soonest = hours;
+        }
+    }
+    if (soonest < 0) {
+        return sendReportInterval;
+    }
+    float interval = soonest * 3600 * 1000 / REPORTS_BEFORE_STOCKOUT;
+    uint32_t shortest = min(reportMinInterval, sendReportInterval);
+    if (interval < shortest) {
+        return shortest;
+    }
+    return interval > sendReportInterval ? sendReportInterval : (uint32_t)interval;
+}
+
 /**
  * @brief Updates `notecardVoltage` and `usbPower` values by sending a `card.voltage` request.
  * 
@@ -751,9 +1095,19 @@ void readTiltSensor() {
     tiltAlert.setActive(tilted);
 }
 
+/**
+ * @brief Collects the ranges that are ready from the distance sensors. All sensors range at
+ * the same time, so this takes one I2C read per sensor rather than a ranging time per sensor.
+ */
+void collectRanges() {
+    for (DispensingColumn* column = columns; column; column = column->next) {
+        column->collectRange();
+    }
+}
+
 /**
  * @brief Polls all the sensors - notecard voltage and power state, notecard tilt
- * and distance sensors on all the columns.
+ * and the health of the distance sensors on all the columns.
  */
 void readSensors() {
     bool wasPowered = usbPower;
@@ -771,7 +1125,7 @@ void readSensors() {
         for (DispensingColumn* column = columns; column; column = column->next) {
             if (!column->isEnabled())
                 continue;
-            column->readDistance();
+            column->checkDistanceSensor();
         }
     }
     else {
@@ -949,6 +1303,7 @@ void environmentUpdated(J* env) {
     setIntValueFromEnvironment(env, changed, errors, &pollEnvironmentInterval, "environment_update_mins", 1000*60, DEFAULT_POLL_ENVIRONMENT_INTERVAL);
     setIntValueFromEnvironment(env, changed, errors, &readSensorsInterval, "monitor_secs", 1000, DEFAULT_POLL_SENSORS_INTERVAL);
     setIntValueFromEnvironment(env, changed, errors, &sendReportInterval, "report_mins", 1000*60, DEFAULT_REPORT_INTERVAL);
+    setIntValueFromEnvironment(env, changed, errors, &reportMinInterval, "report_min_mins", 1000*60, DEFAULT_REPORT_MIN_INTERVAL);
 
     uint32_t watchdogPeriod = readSensorsInterval || sendReportInterval || pollEnvironmentInterval;
     if (watchdogPeriod) {
@@ -980,6 +1335,7 @@ void environmentUpdated(J* env) {
 
     for (DispensingColumn* column = columns; column; column = column->next) {
         environmentUpdateDispensingColumn(changed, errors, env, column);
+        column->resample();
     }
 
     // publish the updates
@@ -1064,8 +1420,12 @@ void setup()
 
     auxSerialStream.begin(auxSerial.baudRate);
 
+    pinMode(TOF_INT_PIN, INPUT_PULLUP);
+    attachInterrupt(digitalPinToInterrupt(TOF_INT_PIN), tofInterruptHandler, FALLING);
+
     pollEnvironmentMs = millis();
     readEnvironment();
+    readNotecardTime();
 
     if (!readNotecardVoltage()) {
         // assume battery power until we can contact Notecard
@@ -1101,6 +1461,11 @@ void loop()
 
     notecardSleep.poll();
 
+    if (usbPower && (tofInterrupt || digitalRead(TOF_INT_PIN)==LOW)) {
+        tofInterrupt = false;
+        collectRanges();
+    }
+
     uint32_t now = millis();
     bool sensorsRead = false;
     if (readSensorsInterval && (now-readSensorsMs)>=readSensorsInterval) {
@@ -1111,7 +1476,7 @@ void loop()
         digitalWrite(LED_BUILTIN, LOW);
     }
 
-    if (sendReportInterval && (now-sendReportMs)>=sendReportInterval) {
+    if (sendReportInterval && (now-sendReportMs)>=reportInterval()) {
         sendReportMs = now;
         if (!sensorsRead) {
             readSensors();
@@ -1123,5 +1488,6 @@ void loop()
         pollEnvironmentMs = now;
         debug.println("checking environment...");
         readEnvironment();
+        readNotecardTime();     // also corrects clock drift
     }
 }
@@ -10,6 +10,7 @@
 
 // Application headers.
 #include "bme280.h"
+#include "scheduler.h"
 
 struct Bme280Ctx {
     const struct device *dev;
@@ -20,8 +21,14 @@ struct Bme280Ctx {
     double heatIndex;
 };
 
+// Readings are written on the sensor work queue and read on the Notecard I/O
+// thread.
+static struct k_spinlock readingsLock;
+
 // Forward declarations.
+#ifndef CONFIG_BOARD_NATIVE_SIM
 static const struct device *getDevice(void);
+#endif
 static void readTimerCb(struct k_timer *timer);
 static void readWorkCb(struct k_work *item);
 
@@ -46,6 +53,8 @@ bool bme280GetData(const Bme280Ctx *ctx, double *temp, double *humidity,
         return false;
     }
 
+    k_spinlock_key_t key = k_spin_lock(&readingsLock);
+
     if (temp != NULL) {
         *temp = ctx->temperature;
     }
@@ -58,6 +67,8 @@ bool bme280GetData(const Bme280Ctx *ctx, double *temp, double *humidity,
         *heatIndex = ctx->heatIndex;
     }
 
+    k_spin_unlock(&readingsLock, key);
+
     return true;
 }
 
@@ -75,12 +86,14 @@ Bme280Ctx *bme280Init(void)
     }
     memset(ctx, 0, sizeof(*ctx));
 
+#ifndef CONFIG_BOARD_NATIVE_SIM
     ctx->dev = getDevice();
     if (ctx->dev == NULL) {
         printk("bme280Init: error: getDevice failed.\n");
         free(ctx);
         return NULL;
     }
+#endif
 
     k_work_init(&ctx->readWorkItem, readWorkCb);
     k_timer_init(&ctx->readTimer, readTimerCb, NULL);
@@ -91,8 +104,9 @@ Bme280Ctx *bme280Init(void)
 }
 
 /**
- * Start the sensor reading timer. The sensor will be read periodically
- * according to the interval.
+ * Start the sensor reading timer. The sensor is read now and then periodically
+ * according to the interval, aligned with the other timers (see
+ * schedulerStartTimer).
  *
  * @param ctx      The sensor context object.
  * @param interval The sensor reading interval, in seconds.
@@ -110,7 +124,11 @@ bool bme280Start(Bme280Ctx *ctx, uint32_t interval)
         return false;
     }
 
-    k_timer_start(&ctx->readTimer, K_SECONDS(0), K_SECONDS(interval));
+    if (!schedulerSubmitSensorWork(&ctx->readWorkItem)) {
+        printk("bme280Start: error: schedulerSubmitSensorWork failed.\n");
+        return false;
+    }
+    schedulerStartTimer(&ctx->readTimer, interval * MSEC_PER_SEC);
 
     return true;
 }
@@ -167,6 +185,29 @@ static double calcHeatIndex(double temp, double humid)
     return heatIndex;
 }
 
+#ifdef CONFIG_BOARD_NATIVE_SIM
+
+// On native_sim there's no BME280. Readings swing in and out of the default
+// alarm bounds over this period instead.
+#define SIM_PERIOD_MS (10 * 60 * MSEC_PER_SEC)
+
+/**
+ * Make up a reading for native_sim.
+ *
+ * @param temp  The temperature reading, in Celsius like the BME280 driver's.
+ * @param humid The humidity reading.
+ */
+static void simulateReading(struct sensor_value *temp,
+    struct sensor_value *humid)
+{
+    double phase = 2 * M_PI * (k_uptime_get() % SIM_PERIOD_MS) / SIM_PERIOD_MS;
+
+    sensor_value_from_double(temp, 19 + 17 * sin(phase));
+    sensor_value_from_double(humid, 45 + 30 * cos(phase));
+}
+
+#else
+
 /**
  * Get a device handle for the BME280.
  *
@@ -194,6 +235,8 @@ static const struct device *getDevice(void)
     return dev;
 }
 
+#endif // CONFIG_BOARD_NATIVE_SIM
+
 /**
  * Read the temperature and humidity from the sensor and store the results in
  * the sensor context;
@@ -211,6 +254,9 @@ static bool readSensor(Bme280Ctx* ctx)
 
     struct sensor_value temp, humid;
 
+#ifdef CONFIG_BOARD_NATIVE_SIM
+    simulateReading(&temp, &humid);
+#else
     int rc;
     if ((rc = sensor_sample_fetch(ctx->dev)) != 0) {
         printk("readSensor: error: sensor_sample_fetch failed (%d).\n", rc);
@@ -219,14 +265,21 @@ static bool readSensor(Bme280Ctx* ctx)
 
     sensor_channel_get(ctx->dev, SENSOR_CHAN_AMBIENT_TEMP, &temp);
     sensor_channel_get(ctx->dev, SENSOR_CHAN_HUMIDITY, &humid);
+#endif
 
     // Multiply sensor value by 1.8 and add 32 to convert Celsius to Fahrenheit.
-    ctx->temperature = sensor_value_to_double(&temp) * 1.8 + 32;
-    ctx->humidity = sensor_value_to_double(&humid);
-    ctx->heatIndex = calcHeatIndex(ctx->temperature, ctx->humidity);
+    double temperature = sensor_value_to_double(&temp) * 1.8 + 32;
+    double humidity = sensor_value_to_double(&humid);
+    double heatIndex = calcHeatIndex(temperature, humidity);
+
+    k_spinlock_key_t key = k_spin_lock(&readingsLock);
+    ctx->temperature = temperature;
+    ctx->humidity = humidity;
+    ctx->heatIndex = heatIndex;
+    k_spin_unlock(&readingsLock, key);
 
     printk("readSensor: temp: %dF, humidity: %d%%, heat index: %dF.\n",
-           (int)ctx->temperature, (int)ctx->humidity, (int)ctx->heatIndex);
+           (int)temperature, (int)humidity, (int)heatIndex);
 
     return true;
 }
@@ -239,12 +292,12 @@ static bool readSensor(Bme280Ctx* ctx)
 static void readTimerCb(struct k_timer *timer)
 {
     Bme280Ctx *ctx = CONTAINER_OF(timer, Bme280Ctx, readTimer);
-    k_work_submit(&ctx->readWorkItem);
+    schedulerSubmitSensorWork(&ctx->readWorkItem);
 }
 
 /**
- * Callback that will be executed by the system workqueue when it's time to do a
- * sensor reading.
+ * Callback that will be executed by the sensor work queue when it's time to do
+ * a sensor reading.
  *
  * @param item The sensor reading work item.
  */
@@ -10,13 +10,15 @@
 
 // Application headers.
 #include "env_updater.h"
+#include "notecard_io.h"
 #include "publisher.h"
+#include "scheduler.h"
 
 struct EnvUpdaterCtx {
     PublisherCtx *publisherCtx;
     AlarmPublisherCtx *alarmPublisherCtx;
     NotecardEnvVarManager *envVarManager;
-    struct k_work envUpdateWorkItem;
+    NotecardIoJob envUpdateJob;
     struct k_timer envUpdateTimer;
     uint32_t envLastModTime;
     uint32_t interval;
@@ -24,7 +26,7 @@ struct EnvUpdaterCtx {
 
 // Forward declarations.
 static void envUpdateTimerCb(struct k_timer *timer);
-static void envUpdateWorkCb(struct k_work *item);
+static void envUpdateJobCb(NotecardIoJob *job);
 
 static const char *envVars[] = {
     "monitor_interval",
@@ -122,7 +124,9 @@ EnvUpdaterCtx *envUpdaterInit(PublisherCtx* publisherCtx,
     ctx->publisherCtx = publisherCtx;
     ctx->alarmPublisherCtx = alarmPublisherCtx;
 
-    k_work_init(&ctx->envUpdateWorkItem, envUpdateWorkCb);
+    // Checking for updates can wait for alarms and telemetry.
+    notecardIoJobInit(&ctx->envUpdateJob, envUpdateJobCb,
+        NOTECARD_IO_PRIO_BACKGROUND);
     k_timer_init(&ctx->envUpdateTimer, envUpdateTimerCb, NULL);
 
     printk("envUpdaterInit: Initialized environment variable updater.\n");
@@ -131,8 +135,9 @@ EnvUpdaterCtx *envUpdaterInit(PublisherCtx* publisherCtx,
 }
 
 /**
- * Start the environment variable update timer. Notehub will be checked
- * periodically for environment variable updates according to the interval.
+ * Start the environment variable update timer. Notehub is checked for
+ * environment variable updates now and then periodically according to the
+ * interval, aligned with the other timers (see schedulerStartTimer).
  *
  * @param ctx      The environment variable updater context object.
  * @param interval The interval to check for updates, in seconds.
@@ -151,7 +156,8 @@ bool envUpdaterStart(EnvUpdaterCtx *ctx, uint32_t interval)
         return false;
     }
 
-    k_timer_start(&ctx->envUpdateTimer, K_SECONDS(0), K_SECONDS(interval));
+    notecardIoSubmit(&ctx->envUpdateJob);
+    schedulerStartTimer(&ctx->envUpdateTimer, interval * MSEC_PER_SEC);
 
     return true;
 }
@@ -185,17 +191,17 @@ bool envUpdaterStop(EnvUpdaterCtx *ctx)
 static void envUpdateTimerCb(struct k_timer *timer)
 {
     EnvUpdaterCtx *ctx = CONTAINER_OF(timer, EnvUpdaterCtx, envUpdateTimer);
-    k_work_submit(&ctx->envUpdateWorkItem);
+    notecardIoSubmit(&ctx->envUpdateJob);
 }
 
 /**
- * Callback that will be executed by the system workqueue when it's time to
+ * Callback that will be executed by the Notecard I/O thread when it's time to
  * check for environment variable updates.
  *
- * @param item The environment variable update work item.
+ * @param job The environment variable update job.
  */
-static void envUpdateWorkCb(struct k_work *item)
+static void envUpdateJobCb(NotecardIoJob *job)
 {
-    EnvUpdaterCtx *ctx = CONTAINER_OF(item, EnvUpdaterCtx, envUpdateWorkItem);
+    EnvUpdaterCtx *ctx = CONTAINER_OF(job, EnvUpdaterCtx, envUpdateJob);
     NotecardEnvVarManager_fetch(ctx->envVarManager, envVars, numEnvVars);
 }
@@ -12,7 +12,9 @@
 #include "alarm_publisher.h"
 #include "bme280.h"
 #include "env_updater.h"
+#include "notecard_io.h"
 #include "publisher.h"
+#include "scheduler.h"
 
 // Uncomment this line and replace com.your-company:your-product-name with your
 // ProductUID.
@@ -23,13 +25,6 @@
 #pragma message "PRODUCT_UID is not defined in this example. Please ensure your Notecard has a product identifier set before running this example or define it in code here. More details at https://bit.ly/product-uid"
 #endif
 
-// Notecard locking functions.
-static bool notecardLocked = false;
-
-#ifndef NOTECARD_LOCK_POLLS_MS
-#define NOTECARD_LOCK_POLLS_MS 10
-#endif
-
 // Temperature in Fahrenheit.
 #define TEMPERATURE_MIN_DEFAULT 32
 #define TEMPERATURE_MAX_DEFAULT 95
@@ -48,20 +43,18 @@ static bool notecardLocked = false;
 #define OUTBOUND_SYNC_MINS 1
 #endif
 
-// Attempt to get a lock on the I2C bus. This will spin forever until the lock
-// is released.
+// Notecard locking functions. Requests are made from the Notecard I/O thread
+// once it's started, so the lock is normally uncontended.
+K_MUTEX_DEFINE(notecardMutex);
+
 void lockNotecard(void)
 {
-    while (notecardLocked) {
-        NoteDelayMs(NOTECARD_LOCK_POLLS_MS);
-    }
-
-    notecardLocked = true;
+    k_mutex_lock(&notecardMutex, K_FOREVER);
 }
 
 void unlockNotecard(void)
 {
-    notecardLocked = false;
+    k_mutex_unlock(&notecardMutex);
 }
 
 void main(void)
@@ -70,8 +63,14 @@ void main(void)
     NoteSetFnDefault(malloc, free, platform_delay, platform_millis);
     NoteSetFnDebugOutput(note_log_print);
     NoteSetFnNoteMutex(lockNotecard, unlockNotecard);
+#ifdef CONFIG_BOARD_NATIVE_SIM
+    // Talk to the simulated Notecard in note_c_hooks_sim.c.
+    NoteSetFnSerial(note_serial_reset, note_serial_transmit,
+                    note_serial_available, note_serial_receive);
+#else
     NoteSetFnI2C(NOTE_I2C_ADDR_DEFAULT, NOTE_I2C_MAX_DEFAULT, note_i2c_reset,
                  note_i2c_transmit, note_i2c_receive);
+#endif
 
     J *req = NoteNewRequest("hub.set");
     if (PRODUCT_UID[0]) {
@@ -88,6 +87,20 @@ void main(void)
         return;
     }
 
+    // From here on, sensor reads and alarm checks run on the sensor work queue
+    // and all Notecard requests are made from the Notecard I/O thread. The
+    // intervals below are multiples of one another, so their timers expire
+    // together and the device wakes once for all of them (see
+    // schedulerStartTimer).
+    if (!schedulerInit()) {
+        printk("schedulerInit failed, aborting.\n");
+        return;
+    }
+    if (!notecardIoStart()) {
+        printk("notecardIoStart failed, aborting.\n");
+        return;
+    }
+
     Bme280Ctx* bme280Ctx;
     // Read the sensor every 30 seconds.
     uint32_t interval = 30;
@@ -140,9 +153,9 @@ void main(void)
         return;
     }
 
-    while (true) {
-        k_sleep(K_SECONDS(10));
-    }
+    // Everything runs from timers from here on. Between them, the idle thread
+    // puts the MCU into the deepest sleep state that fits (see CONFIG_PM).
+    k_sleep(K_FOREVER);
 }
 
 void NoteUserAgentUpdate(J *ua) {
@@ -14,4 +14,9 @@ const char *note_i2c_transmit(uint16_t device_address_, uint8_t *buffer_, uint16
 
 size_t note_log_print(const char *message_);
 
+bool note_serial_available(void);
+char note_serial_receive(void);
+bool note_serial_reset(void);
+void note_serial_transmit(uint8_t *text_, size_t len_, bool flush_);
+
 #endif // NOTE_C_HOOKS_H
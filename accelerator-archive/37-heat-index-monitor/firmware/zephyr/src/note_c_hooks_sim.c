@@ -0,0 +1,91 @@
+// Notecard hooks for native_sim, where there's no Notecard. They stand in for
+// one on the serial interface: every request gets an empty JSON object back
+// after NOTECARD_SIM_LATENCY_MS, which is enough for the firmware to run and
+// shows how the Notecard I/O thread copes with slow transactions.
+
+#include "note_c_hooks.h"
+
+#include <string.h>
+
+#include <zephyr/kernel.h>
+
+#ifndef NOTECARD_SIM_LATENCY_MS
+#define NOTECARD_SIM_LATENCY_MS 1000
+#endif
+
+#ifndef NOTECARD_SIM_LINE_MAX
+#define NOTECARD_SIM_LINE_MAX 512
+#endif
+
+static char line[NOTECARD_SIM_LINE_MAX];
+static size_t line_len = 0;
+static const char *reply = NULL;
+static uint32_t reply_at_ms = 0;
+
+uint32_t platform_millis(void) {
+    return (uint32_t)k_uptime_get();
+}
+
+void platform_delay(uint32_t ms) {
+    k_msleep(ms);
+}
+
+size_t note_log_print(const char *message_) {
+    if (message_) {
+        printk("%s", message_);
+        return 1;
+    }
+
+    return 0;
+}
+
+// Answer a complete line from note-c. A blank line is note-c resynchronizing
+// and is echoed straight away, a "cmd" expects no reply and anything else is a
+// request.
+static void handle_line(void) {
+    line[line_len] = '\0';
+
+    if (line_len == 0) {
+        reply = "\r\n";
+        reply_at_ms = k_uptime_get_32();
+    } else if (strstr(line, "\"cmd\":") != NULL) {
+        printk("handle_line: %s\n", line);
+        reply = NULL;
+    } else {
+        printk("handle_line: %s\n", line);
+        reply = "{}\r\n";
+        reply_at_ms = k_uptime_get_32() + NOTECARD_SIM_LATENCY_MS;
+    }
+
+    line_len = 0;
+}
+
+bool note_serial_available(void) {
+    return reply != NULL && *reply != '\0' &&
+           (int32_t)(k_uptime_get_32() - reply_at_ms) >= 0;
+}
+
+char note_serial_receive(void) {
+    if (!note_serial_available()) {
+        return 0;
+    }
+
+    return *reply++;
+}
+
+bool note_serial_reset(void) {
+    line_len = 0;
+    reply = NULL;
+
+    return true;
+}
+
+void note_serial_transmit(uint8_t *text_, size_t len_, bool flush_) {
+    for (size_t i = 0; i < len_; i++) {
+        if (text_[i] == '\n') {
+            handle_line();
+        } else if (text_[i] != '\r' && line_len < sizeof(line) - 1) {
+            line[line_len++] = text_[i];
+        }
+    }
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+// C standard headers.
+#include <stdint.h>
+#include <stdbool.h>
+
+// Zephyr headers.
+#include <zephyr/kernel.h>
+#include <zephyr/sys/atomic.h>
+
+// Jobs are run highest priority first. A job waiting at a lower priority is
+// only run once no higher priority job is queued.
+typedef enum {
+    NOTECARD_IO_PRIO_ALARM,
+    NOTECARD_IO_PRIO_TELEMETRY,
+    NOTECARD_IO_PRIO_BACKGROUND,
+    NOTECARD_IO_PRIO_COUNT
+} NotecardIoPriority;
+
+struct NotecardIoJob;
+typedef void (*NotecardIoHandler)(struct NotecardIoJob *job);
+
+// A unit of Notecard I/O. Like a k_work item, a job is embedded in the context
+// object that owns it, and its handler uses CONTAINER_OF to get back to that
+// object. A job is queued at most once: submitting a job that is still waiting
+// to run does nothing, so a slow Notecard never builds up a backlog of stale
+// publishes.
+typedef struct NotecardIoJob {
+    NotecardIoHandler handler;
+    NotecardIoPriority priority;
+    atomic_t queued;
+    uint32_t queuedMs;
+} NotecardIoJob;
+
+// Statically define and initialize a job, like K_WORK_DEFINE.
+#define NOTECARD_IO_JOB_DEFINE(name, jobHandler, jobPriority) \
+    NotecardIoJob name = { \
+        .handler = (jobHandler), \
+        .priority = (jobPriority), \
+        .queued = ATOMIC_INIT(0), \
+        .queuedMs = 0 \
+    }
+
+void notecardIoJobInit(NotecardIoJob *job, NotecardIoHandler handler,
+    NotecardIoPriority priority);
+bool notecardIoStart(void);
+bool notecardIoSubmit(NotecardIoJob *job);
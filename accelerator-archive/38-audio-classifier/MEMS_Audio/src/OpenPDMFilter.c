@@ -30,6 +30,7 @@
 /* Includes ------------------------------------------------------------------*/
 
 #include "OpenPDMFilter.h"
+#include <string.h>
 
 
 
@@ -181,6 +182,25 @@ void Open_PDM_Filter_Init(TPDMFilter_InitStruct *Param) {
     uint32_t div_const = Param->sub_const * Param->MaxVolume / 32768 / FILTER_GAIN;
     Param->div_const = (div_const == 0 ? 1 : div_const);
 
+    #ifdef USE_PACKED_LUT
+    if (decimation == 64) {
+        uint16_t c, d, k;
+        for (d = 0; d < 64 / 8; d++) {
+            for (c = 0; c < 256; c++) {
+                uint32_t s0 = 0, s2 = 0;
+                for (k = 0; k < 8; k++) {
+                    if (c & (0x80 >> k)) {
+                        s0 += Param->coef[0][d * 8 + k];
+                        s2 += Param->coef[2][d * 8 + k];
+                    }
+                }
+                Param->packed_lut[d][c] = s0 | (s2 << 16);
+            }
+        }
+        return;
+    }
+    #endif
+
     #ifdef USE_LUT
     /* Look-Up Table. */
     uint16_t c, d, s;
@@ -203,7 +223,112 @@ void Open_PDM_Filter_Init(TPDMFilter_InitStruct *Param) {
     #endif
 }
 
+#ifdef USE_PACKED_LUT
+/*
+ * Packed decimation by 64.
+ *
+ * The three phases of a sinc^3 filter sum to Decimation^2 at every tap, so
+ * over the 64 input bits of one output sample Z0 + Z1 + Z2 = 4096 * (number
+ * of set bits). Only Z0 and Z2 are looked up, and since each is at most 43680
+ * for a whole sample they share one 32-bit word and are summed with plain
+ * adds that can't carry from the low half into the high half. Z1 comes from
+ * the bit count.
+ *
+ * With the DC offset removed, every value in the high/low-pass stage stays
+ * below 2^28, so it runs in 32 bits; only large volumes need a 64-bit
+ * multiply before the final division. The output matches the reference path
+ * exactly.
+ */
+#define PACKED_VOLUME_MAX_32BIT 1024
+
+/* Bit count of each byte of x, one count per byte. */
+static inline uint32_t byte_bit_counts(uint32_t x) {
+    x = x - ((x >> 1) & 0x55555555);
+    x = (x & 0x33333333) + ((x >> 2) & 0x33333333);
+    return (x + (x >> 4)) & 0x0F0F0F0F;
+}
+
+static int Open_PDM_Filter_64_Packed(uint8_t *data, int16_t *dataOut, uint16_t volume, TPDMFilter_InitStruct *Param) {
+    unsigned int i, data_out_index;
+    const uint8_t channels = Param->In_MicChannels;
+    const uint8_t data_inc = ((DECIMATION_MAX >> 4) * channels);
+    const packed_lut_t *lut = &Param->packed_lut;
+    const int32_t sub_const = (int32_t)Param->sub_const;
+    const int32_t div_const = (int32_t)Param->div_const;
+    const int32_t hp_alfa = Param->HP_ALFA;
+    const int32_t lp_alfa = Param->LP_ALFA;
+    int32_t coef0 = (int32_t)Param->Coef[0];
+    int32_t coef1 = (int32_t)Param->Coef[1];
+    int32_t OldOut = (int32_t)Param->OldOut;
+    int32_t OldIn = (int32_t)Param->OldIn;
+    int32_t OldZ = (int32_t)Param->OldZ;
+
+    for (i = 0, data_out_index = 0; i < Param->nSamples; i++, data_out_index += channels) {
+        /* The sample's 8 input bytes, first byte in the low bits of w0. */
+        uint32_t w0, w1;
+        #if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+        if (channels == 1) {
+            memcpy(&w0, data, sizeof(w0));
+            memcpy(&w1, data + 4, sizeof(w1));
+        }
+        else
+        #endif
+        {
+            w0 = data[0] | (data[channels] << 8) | (data[2 * channels] << 16) | ((uint32_t)data[3 * channels] << 24);
+            w1 = data[4 * channels] | (data[5 * channels] << 8) | (data[6 * channels] << 16) | ((uint32_t)data[7 * channels] << 24);
+        }
+
+        #define PDM_BYTE(w, k) (((w) >> (8 * (k))) & 0xFF)
+        const uint32_t z02 =
+            (*lut)[0][PDM_BYTE(w0, 0)] + (*lut)[1][PDM_BYTE(w0, 1)] +
+            (*lut)[2][PDM_BYTE(w0, 2)] + (*lut)[3][PDM_BYTE(w0, 3)] +
+            (*lut)[4][PDM_BYTE(w1, 0)] + (*lut)[5][PDM_BYTE(w1, 1)] +
+            (*lut)[6][PDM_BYTE(w1, 2)] + (*lut)[7][PDM_BYTE(w1, 3)];
+        #undef PDM_BYTE
+        const int32_t ones = (int32_t)(((byte_bit_counts(w0) + byte_bit_counts(w1)) * 0x01010101) >> 24);
+        const int32_t z0 = (int32_t)(z02 & 0xFFFF);
+        const int32_t z2 = (int32_t)(z02 >> 16);
+        const int32_t z1 = 4096 * ones - z0 - z2;
+
+        int32_t Z = coef1 + z2 - sub_const;
+        coef1 = coef0 + z1;
+        coef0 = z0;
+
+        OldOut = (hp_alfa * (OldOut + Z - OldIn)) >> 8;
+        OldIn = Z;
+        OldZ = ((256 - lp_alfa) * OldZ + lp_alfa * OldOut) >> 8;
+
+        if (volume <= PACKED_VOLUME_MAX_32BIT) {
+            Z = OldZ * volume;
+            Z = RoundDiv(Z, div_const);
+        }
+        else {
+            int64_t Z64 = (int64_t)OldZ * volume;
+            Z64 = RoundDiv(Z64, (int64_t)div_const);
+            Z = (int32_t)SaturaLH(Z64, -32700, 32700);
+        }
+        Z = SaturaLH(Z, -32700, 32700);
+
+        dataOut[data_out_index] = Z;
+        data += data_inc;
+    }
+
+    Param->Coef[0] = (uint32_t)coef0;
+    Param->Coef[1] = (uint32_t)coef1;
+    Param->OldOut = OldOut;
+    Param->OldIn = OldIn;
+    Param->OldZ = OldZ;
+    return data_out_index;
+}
+#endif
+
 int Open_PDM_Filter_64(uint8_t *data, int16_t *dataOut, uint16_t volume, TPDMFilter_InitStruct *Param) {
+    #ifdef USE_PACKED_LUT
+    if (Param->Decimation == 64) {
+        return Open_PDM_Filter_64_Packed(data, dataOut, volume, Param);
+    }
+    #endif
+
     uint8_t i, data_out_index;
     uint8_t channels = Param->In_MicChannels;
     uint8_t data_inc = ((DECIMATION_MAX >> 4) * channels);
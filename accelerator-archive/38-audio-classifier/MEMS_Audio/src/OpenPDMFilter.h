@@ -48,6 +48,17 @@ extern "C" {
  */
 #define USE_LUT
 
+/*
+ * Enable to decimate by 64 with a packed Look-Up Table (see
+ * Open_PDM_Filter_64 in OpenPDMFilter.c). It shares storage with the lut_t
+ * table, and gives the same output bit for bit with fewer memory accesses
+ * and no 64-bit arithmetic per sample. Define PDM_FILTER_REFERENCE to build
+ * the original path instead, e.g. to compare against it on a host.
+ */
+#if defined(USE_LUT) && !defined(PDM_FILTER_REFERENCE)
+#define USE_PACKED_LUT
+#endif
+
 #define SINCN 3
 #define DECIMATION_MAX 128 // can be 128 but this didn't work for me
 #define FILTER_GAIN 16
@@ -63,6 +74,13 @@ extern "C" {
 
 typedef int32_t lut_t[256][DECIMATION_MAX / 8][SINCN];
 
+/*
+ * Packed table for decimation by 64: for each of the 8 input bytes of an
+ * output sample and each byte value, the sinc phase 0 sum in the low half
+ * and the phase 2 sum in the high half.
+ */
+typedef uint32_t packed_lut_t[64 / 8][256];
+
 
 typedef struct
 {
@@ -90,7 +108,12 @@ typedef struct
     uint32_t sinc2[DECIMATION_MAX * 2];
     uint32_t coef[SINCN][DECIMATION_MAX];
     #ifdef USE_LUT
-    lut_t lut;
+    union {
+        lut_t lut;
+        #ifdef USE_PACKED_LUT
+        packed_lut_t packed_lut;
+        #endif
+    };
     #endif
 } TPDMFilter_InitStruct;
 
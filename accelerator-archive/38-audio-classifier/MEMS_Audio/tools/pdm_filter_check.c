@@ -0,0 +1,182 @@
+/*
+ * pdm_filter_check.c
+ *
+ * Host check and benchmark for the packed decimate-by-64 path in
+ * OpenPDMFilter.c.
+ *
+ * 1. Runs the packed path and the reference path (PDM_FILTER_REFERENCE) side
+ *    by side over synthetic PDM streams, for mono and stereo input and a range
+ *    of volumes, and fails on the first output sample that differs.
+ * 2. Times both paths and reports nanoseconds and, on x86, TSC cycles per
+ *    output sample.
+ *
+ * Build and run (from this directory):
+ *   gcc -O2 -std=gnu11 -I../src pdm_filter_check.c pdm_filter_ref.c \
+ *       ../src/OpenPDMFilter.c -lm -o pdm_filter_check
+ *   ./pdm_filter_check
+ *
+ * Host timings show the relative gain only; the Cortex-M4 figures differ.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_TSC
+#endif
+
+#include "OpenPDMFilter.h"
+
+void ref_filter_init(uint8_t decimation, uint8_t channels, unsigned int nSamples, uint8_t maxVolume);
+int ref_filter_64(uint8_t *data, int16_t *dataOut, uint16_t volume);
+
+#define SAMPLES_PER_CALL 16     /* MEMS_AUDIO_PCM_BUFFER_LENGTH */
+#define BYTES_PER_SAMPLE 8      /* 64 PDM bits */
+#define CALLS 4000              /* 4 s of audio at 16 kHz */
+#define MAX_CHANNELS 2
+
+static TPDMFilter_InitStruct filter;
+static uint8_t pdm[CALLS][SAMPLES_PER_CALL * BYTES_PER_SAMPLE * MAX_CHANNELS];
+
+static void filter_init(uint8_t channels, uint8_t maxVolume)
+{
+    memset(&filter, 0, sizeof(filter));
+    filter.Fs = 16000;
+    filter.LP_HZ = filter.Fs / 2;
+    filter.HP_HZ = 10;
+    filter.In_MicChannels = channels;
+    filter.Out_MicChannels = channels;
+    filter.Decimation = 64;
+    filter.MaxVolume = maxVolume;
+    filter.nSamples = SAMPLES_PER_CALL;
+    Open_PDM_Filter_Init(&filter);
+    ref_filter_init(64, channels, SAMPLES_PER_CALL, maxVolume);
+}
+
+/* Patterns: first-order sigma-delta of a tone sweep at a given level, random
+ * bits, and the all-0 / all-1 / alternating extremes. */
+static void make_pdm(int pattern, size_t len)
+{
+    uint8_t *p = &pdm[0][0];
+    double acc = 0;
+    size_t i;
+    int b;
+    srand(pattern);
+    for (i = 0; i < len; i++) {
+        uint8_t byte = 0;
+        switch (pattern) {
+        case 0: byte = 0x00; break;
+        case 1: byte = 0xFF; break;
+        case 2: byte = 0xAA; break;
+        case 3: byte = (i / 512) & 1 ? 0xFF : 0x00; break;
+        case 4: byte = (uint8_t)rand(); break;
+        default:
+            for (b = 0; b < 8; b++) {
+                const double t = (double)(i * 8 + b) / 1024000.0;
+                const double level = pattern == 5 ? 0.01 : pattern == 6 ? 0.5 : 0.99;
+                const double x = level * sin(2 * M_PI * (100 + 4000 * t) * t);
+                const int bit = acc + x >= 0;
+                acc += x - (bit ? 1 : -1);
+                byte = (uint8_t)((byte << 1) | bit);
+            }
+        }
+        p[i] = byte;
+    }
+}
+
+static int check(void)
+{
+    static const uint16_t volumes[] = { 1, 2, 64, 1024, 1025, 4096, 65535 };
+    static const uint8_t maxVolumes[] = { 0, 16, 255 };
+    int16_t out[SAMPLES_PER_CALL * MAX_CHANNELS], ref[SAMPLES_PER_CALL * MAX_CHANNELS];
+    unsigned long compared = 0;
+    int pattern;
+    size_t v, m, call, i;
+    uint8_t channels;
+
+    for (channels = 1; channels <= MAX_CHANNELS; channels++) {
+        for (pattern = 0; pattern < 8; pattern++) {
+            make_pdm(pattern, sizeof(pdm));
+            for (v = 0; v < sizeof(volumes) / sizeof(volumes[0]); v++) {
+                for (m = 0; m < sizeof(maxVolumes) / sizeof(maxVolumes[0]); m++) {
+                    filter_init(channels, maxVolumes[m]);
+                    for (call = 0; call < CALLS; call++) {
+                        memset(out, 0, sizeof(out));
+                        memset(ref, 0, sizeof(ref));
+                        const int n = Open_PDM_Filter_64(pdm[call], out, volumes[v], &filter);
+                        const int nRef = ref_filter_64(pdm[call], ref, volumes[v]);
+                        if (n != nRef || memcmp(out, ref, sizeof(out)) != 0) {
+                            for (i = 0; i < SAMPLES_PER_CALL * MAX_CHANNELS && out[i] == ref[i]; i++);
+                            printf("MISMATCH: %u ch, pattern %d, volume %u, MaxVolume %u, "
+                                "call %zu, sample %zu: %d != %d (returned %d, %d)\n",
+                                channels, pattern, volumes[v], maxVolumes[m], call, i,
+                                out[i], ref[i], n, nRef);
+                            return 1;
+                        }
+                        compared += SAMPLES_PER_CALL;
+                    }
+                }
+            }
+        }
+    }
+    printf("bit-exact: %lu samples compared\n", compared);
+    return 0;
+}
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void bench(void)
+{
+    const int rounds = 50;
+    int16_t out[SAMPLES_PER_CALL];
+    volatile int16_t sink = 0;
+    const double samples = (double)rounds * CALLS * SAMPLES_PER_CALL;
+    int path, r;
+    size_t call;
+
+    make_pdm(6, sizeof(pdm));
+    filter_init(1, 0);
+    printf("%-10s %12s %12s\n", "path", "ns/sample", "cycles/sample");
+    for (path = 0; path < 2; path++) {
+        const double t0 = now_ns();
+        #ifdef HAVE_TSC
+        const unsigned long long c0 = __rdtsc();
+        #endif
+        for (r = 0; r < rounds; r++) {
+            for (call = 0; call < CALLS; call++) {
+                if (path == 0) {
+                    ref_filter_64(pdm[call], out, 1);
+                }
+                else {
+                    Open_PDM_Filter_64(pdm[call], out, 1, &filter);
+                }
+                sink += out[0];
+            }
+        }
+        #ifdef HAVE_TSC
+        const double cycles = (double)(__rdtsc() - c0) / samples;
+        #else
+        const double cycles = NAN;
+        #endif
+        printf("%-10s %12.2f %12.1f\n", path == 0 ? "reference" : "packed",
+            (now_ns() - t0) / samples, cycles);
+    }
+    (void)sink;
+}
+
+int main(void)
+{
+    if (check() != 0) {
+        return 1;
+    }
+    bench();
+    return 0;
+}
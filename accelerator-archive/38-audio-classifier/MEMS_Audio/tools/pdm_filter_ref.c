@@ -0,0 +1,44 @@
+/*
+ * pdm_filter_ref.c
+ *
+ * The reference OpenPDMFilter build for pdm_filter_check.c: the same source
+ * compiled with PDM_FILTER_REFERENCE and its symbols renamed, so both paths
+ * can be linked into one host program.
+ */
+
+#define PDM_FILTER_REFERENCE
+
+#define Open_PDM_Filter_Init    ref_Open_PDM_Filter_Init
+#define Open_PDM_Filter_64      ref_Open_PDM_Filter_64
+#define Open_PDM_Filter_128     ref_Open_PDM_Filter_128
+#define convolve                ref_convolve
+#define filter_table            ref_filter_table
+#define filter_table_mono_64    ref_filter_table_mono_64
+#define filter_table_stereo_64  ref_filter_table_stereo_64
+#define filter_table_mono_128   ref_filter_table_mono_128
+#define filter_table_stereo_128 ref_filter_table_stereo_128
+#define filter_tables_64        ref_filter_tables_64
+#define filter_tables_128       ref_filter_tables_128
+
+#include "../src/OpenPDMFilter.c"
+
+static TPDMFilter_InitStruct refFilter;
+
+void ref_filter_init(uint8_t decimation, uint8_t channels, unsigned int nSamples, uint8_t maxVolume)
+{
+    memset(&refFilter, 0, sizeof(refFilter));
+    refFilter.Fs = 16000;
+    refFilter.LP_HZ = refFilter.Fs / 2;
+    refFilter.HP_HZ = 10;
+    refFilter.In_MicChannels = channels;
+    refFilter.Out_MicChannels = channels;
+    refFilter.Decimation = decimation;
+    refFilter.MaxVolume = maxVolume;
+    refFilter.nSamples = nSamples;
+    Open_PDM_Filter_Init(&refFilter);
+}
+
+int ref_filter_64(uint8_t *data, int16_t *dataOut, uint16_t volume)
+{
+    return Open_PDM_Filter_64(data, dataOut, volume, &refFilter);
+}
@@ -0,0 +1,316 @@
+// bench_pipeline.cpp
+//
+// Linux benchmark for the classifier's audio pipeline. Replays a WAV file
+// through the same PcmSliceRing and run_classifier_continuous() sequence as
+// classifier/src/main.cpp and reports the real-time factor (processing time /
+// audio time), the worst single classification against the time budget, and
+// any audio the ring had to drop.
+//
+// Audio arrival is emulated rather than slept: while a slice is being
+// classified, the samples that the microphone would have delivered in that
+// time are pushed into the ring in 1 ms blocks, exactly as the DMA callback
+// would push them. --scale multiplies the measured host time to approximate
+// a slower target (e.g. the Swan's Cortex-M4), so an overflow here predicts
+// one on the device.
+//
+// --batch runs the previous firmware's approach instead — whole, non-
+// overlapping windows through run_classifier() — for comparison.
+//
+// Build with ./build.sh (see the README), then:
+//   ./bench_pipeline faucet.wav [--scale N] [--batch] [--verbose]
+//
+// The WAV file must be 16 kHz, mono, 16-bit PCM, the format the MEMS_Audio
+// library produces.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <chrono>
+#include <vector>
+
+#include EI_MODEL_HEADER
+#include "audio_pipeline.h"
+
+// Must match classifier/src/main.cpp.
+#define SAMPLE_RATE_HZ 16000
+#define BLOCK_LEN      16    // MEMS_AUDIO_PCM_BUFFER_LENGTH: 1 ms at 16 kHz
+
+#ifndef NUM_SLICE_BUFS
+#define NUM_SLICE_BUFS 3
+#endif
+
+static_assert(EI_CLASSIFIER_FREQUENCY == SAMPLE_RATE_HZ,
+    "The model must be trained on 16 kHz audio.");
+static_assert(EI_CLASSIFIER_SLICE_SIZE % BLOCK_LEN == 0,
+    "Slice size must be a multiple of the MEMS_Audio block length.");
+
+typedef std::chrono::steady_clock Clock;
+
+static PcmSliceRing<EI_CLASSIFIER_SLICE_SIZE, NUM_SLICE_BUFS> pcmRing;
+static int16_t pcmScratch[BLOCK_LEN];
+static const int16_t *currentSlice = NULL;
+static const float *currentWindow = NULL;
+
+static int getSliceData(size_t offset, size_t length, float *out)
+{
+    return numpy::int16_to_float(currentSlice + offset, out, length);
+}
+
+static int getWindowData(size_t offset, size_t length, float *out)
+{
+    memcpy(out, currentWindow + offset, length * sizeof(float));
+    return 0;
+}
+
+static bool loadWav(const char *path, std::vector<int16_t> &pcm)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        perror(path);
+        return false;
+    }
+
+    uint8_t riff[12];
+    if (fread(riff, 1, sizeof(riff), f) != sizeof(riff) ||
+            memcmp(riff, "RIFF", 4) != 0 || memcmp(riff + 8, "WAVE", 4) != 0) {
+        fprintf(stderr, "%s: not a WAV file\n", path);
+        fclose(f);
+        return false;
+    }
+
+    bool fmtOk = false;
+    uint8_t hdr[8];
+    while (fread(hdr, 1, sizeof(hdr), f) == sizeof(hdr)) {
+        const uint32_t len = hdr[4] | (hdr[5] << 8) | (hdr[6] << 16) |
+            ((uint32_t)hdr[7] << 24);
+        if (memcmp(hdr, "fmt ", 4) == 0) {
+            uint8_t fmt[16];
+            if (len < sizeof(fmt) || fread(fmt, 1, sizeof(fmt), f) != sizeof(fmt)) {
+                break;
+            }
+            const uint16_t format = fmt[0] | (fmt[1] << 8);
+            const uint16_t channels = fmt[2] | (fmt[3] << 8);
+            const uint32_t rate = fmt[4] | (fmt[5] << 8) | (fmt[6] << 16) |
+                ((uint32_t)fmt[7] << 24);
+            const uint16_t bits = fmt[14] | (fmt[15] << 8);
+            if (format != 1 || channels != 1 || rate != SAMPLE_RATE_HZ ||
+                    bits != 16) {
+                fprintf(stderr, "%s: need 16 kHz mono 16-bit PCM (got format "
+                    "%u, %u ch, %u Hz, %u bit)\n", path, format, channels,
+                    rate, bits);
+                fclose(f);
+                return false;
+            }
+            fmtOk = true;
+            fseek(f, (long)(len - sizeof(fmt) + (len & 1)), SEEK_CUR);
+        }
+        else if (memcmp(hdr, "data", 4) == 0 && fmtOk) {
+            // Samples are little-endian, as is every host this builds on.
+            pcm.resize(len / sizeof(int16_t));
+            const size_t n = fread(pcm.data(), sizeof(int16_t), pcm.size(), f);
+            pcm.resize(n);
+            fclose(f);
+            return n > 0;
+        }
+        else {
+            fseek(f, (long)(len + (len & 1)), SEEK_CUR);
+        }
+    }
+
+    fprintf(stderr, "%s: no fmt/data chunk\n", path);
+    fclose(f);
+    return false;
+}
+
+static void printResult(double atSec, const ei_impulse_result_t &result)
+{
+    printf("%8.2f s ", atSec);
+    for (size_t i = 0; i < EI_CLASSIFIER_LABEL_COUNT; i++) {
+        printf("  %s: %.2f", result.classification[i].label,
+            result.classification[i].value);
+    }
+    printf("   (DSP: %d ms., Classification: %d ms.)\n",
+        result.timing.dsp, result.timing.classification);
+}
+
+struct Stats {
+    double busySec;       // scaled processing time
+    double maxSec;        // worst single run
+    uint32_t runs;
+    uint32_t errors;
+};
+
+// Streams the file through the ring the way the DMA callback and main loop
+// share it on the device.
+static Stats runStreaming(const std::vector<int16_t> &pcm, double scale,
+    bool verbose)
+{
+    Stats s = {0, 0, 0, 0};
+    size_t fed = 0;
+    // Where the "filter" writes its next block, as pcmOutputBuffer would.
+    int16_t *dest = pcmScratch;
+    uint32_t numSlicesClassified = 0;
+
+    // Delivers up to n samples of audio, one DMA block at a time.
+    auto feed = [&](size_t n) {
+        for (size_t done = 0; done < n && fed + BLOCK_LEN <= pcm.size();
+                done += BLOCK_LEN) {
+            memcpy(dest, &pcm[fed], BLOCK_LEN * sizeof(int16_t));
+            dest = pcmRing.commit(dest, BLOCK_LEN, pcmScratch);
+            fed += BLOCK_LEN;
+        }
+    };
+
+    run_classifier_init();
+
+    while (true) {
+        currentSlice = pcmRing.peek();
+        if (currentSlice == NULL) {
+            // Idle: the main loop spins until the next block arrives.
+            if (fed + BLOCK_LEN > pcm.size()) {
+                break;
+            }
+            feed(BLOCK_LEN);
+            continue;
+        }
+
+        signal_t signal;
+        signal.total_length = EI_CLASSIFIER_SLICE_SIZE;
+        signal.get_data = &getSliceData;
+        ei_impulse_result_t result = {0};
+
+        const Clock::time_point t0 = Clock::now();
+        EI_IMPULSE_ERROR err = run_classifier_continuous(&signal, &result,
+                                                         false);
+        const double sec = scale *
+            std::chrono::duration<double>(Clock::now() - t0).count();
+
+        // The microphone kept running while the slice was held.
+        feed((size_t)(sec * SAMPLE_RATE_HZ));
+        pcmRing.release();
+
+        s.busySec += sec;
+        if (sec > s.maxSec) {
+            s.maxSec = sec;
+        }
+        ++s.runs;
+        if (err != EI_IMPULSE_OK) {
+            ++s.errors;
+            continue;
+        }
+        if (verbose && ++numSlicesClassified >=
+                EI_CLASSIFIER_SLICES_PER_MODEL_WINDOW) {
+            printResult((double)fed / SAMPLE_RATE_HZ, result);
+        }
+    }
+    return s;
+}
+
+// The previous firmware: convert each full window to float and classify it.
+static Stats runBatch(const std::vector<int16_t> &pcm, double scale,
+    bool verbose)
+{
+    Stats s = {0, 0, 0, 0};
+    std::vector<float> window(EI_CLASSIFIER_RAW_SAMPLE_COUNT);
+
+    for (size_t off = 0; off + window.size() <= pcm.size();
+            off += window.size()) {
+        const Clock::time_point t0 = Clock::now();
+        for (size_t i = 0; i < window.size(); ++i) {
+            window[i] = (float)pcm[off + i];
+        }
+        currentWindow = window.data();
+        signal_t signal;
+        signal.total_length = window.size();
+        signal.get_data = &getWindowData;
+        ei_impulse_result_t result = {0};
+        EI_IMPULSE_ERROR err = run_classifier(&signal, &result, false);
+        const double sec = scale *
+            std::chrono::duration<double>(Clock::now() - t0).count();
+
+        s.busySec += sec;
+        if (sec > s.maxSec) {
+            s.maxSec = sec;
+        }
+        ++s.runs;
+        if (err != EI_IMPULSE_OK) {
+            ++s.errors;
+        }
+        else if (verbose) {
+            printResult((double)(off + window.size()) / SAMPLE_RATE_HZ, result);
+        }
+    }
+    return s;
+}
+
+static void usage()
+{
+    fprintf(stderr,
+        "usage: bench_pipeline file.wav [options]\n"
+        "  --scale N    multiply host processing time by N to approximate the\n"
+        "               target (default 1)\n"
+        "  --batch      classify whole windows with run_classifier() instead\n"
+        "  --verbose    print every classification result\n");
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2) {
+        usage();
+        return 2;
+    }
+
+    double scale = 1.0;
+    bool batch = false;
+    bool verbose = false;
+    for (int i = 2; i < argc; ++i) {
+        if (strcmp(argv[i], "--batch") == 0) {
+            batch = true;
+        }
+        else if (strcmp(argv[i], "--verbose") == 0) {
+            verbose = true;
+        }
+        else if (strcmp(argv[i], "--scale") == 0 && i + 1 < argc) {
+            scale = atof(argv[++i]);
+            if (scale <= 0) {
+                usage();
+                return 2;
+            }
+        }
+        else {
+            usage();
+            return 2;
+        }
+    }
+
+    std::vector<int16_t> pcm;
+    if (!loadWav(argv[1], pcm)) {
+        return 1;
+    }
+
+    const Stats s = batch ? runBatch(pcm, scale, verbose)
+                          : runStreaming(pcm, scale, verbose);
+    const double audioSec = (double)pcm.size() / SAMPLE_RATE_HZ;
+    const double budgetSec = (double)(batch ? EI_CLASSIFIER_RAW_SAMPLE_COUNT
+        : EI_CLASSIFIER_SLICE_SIZE) / SAMPLE_RATE_HZ;
+
+    printf("\nmode:            %s\n", batch ? "batch (run_classifier)"
+        : "streaming (run_classifier_continuous)");
+    printf("audio:           %.2f s\n", audioSec);
+    printf("runs:            %u (%u errors), %.0f ms of audio each\n",
+        s.runs, s.errors, budgetSec * 1000);
+    printf("processing:      %.3f s (scale %.1f)\n", s.busySec, scale);
+    printf("real-time factor %.3f\n", s.busySec / audioSec);
+    printf("worst run:       %.1f ms (%.0f%% of budget)\n", s.maxSec * 1000,
+        s.maxSec / budgetSec * 100);
+    if (!batch) {
+        printf("ring:            %u x %u samples, %lu bytes\n",
+            (unsigned)NUM_SLICE_BUFS, (unsigned)EI_CLASSIFIER_SLICE_SIZE,
+            (unsigned long)sizeof(pcmRing));
+        printf("dropped blocks:  %u%s\n", pcmRing.dropped(),
+            pcmRing.dropped() ? "  <- increase NUM_SLICE_BUFS or reduce "
+                                "the model's DSP cost" : "");
+    }
+    return (s.errors || (!batch && pcmRing.dropped())) ? 1 : 0;
+}
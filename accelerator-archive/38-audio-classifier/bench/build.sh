@@ -0,0 +1,64 @@
+#!/bin/bash
+set -e
+
+# Usage info
+show_help() {
+cat << EOF
+Usage: ${0##*/} EI_LIBRARY_DIR
+Build bench_pipeline against an Edge Impulse Arduino library export.
+
+     EI_LIBRARY_DIR  the directory unzipped in "Downloading the Model"
+                     (it contains src/<project>_inferencing.h)
+EOF
+}
+
+if [ $# -ne 1 ] || [ ! -d "$1/src" ]; then
+    show_help
+    exit 1
+fi
+
+here="$(cd "$(dirname "$0")" && pwd)"
+lib="$(cd "$1/src" && pwd)"
+sdk="$lib/edge-impulse-sdk"
+model_header="$(cd "$lib" && ls *_inferencing.h | head -n 1)"
+out="$here/build"
+
+if [ -z "$model_header" ]; then
+    echo "No *_inferencing.h in $lib" >&2
+    exit 1
+fi
+
+# Same slice count as classifier/src/main.cpp.
+defines="-DEI_CLASSIFIER_SLICES_PER_MODEL_WINDOW=4 -DTF_LITE_DISABLE_X86_NEON=1 \
+-DEI_MODEL_HEADER=\"$model_header\""
+includes="-I$here/../classifier/include -I$lib -I$sdk \
+-I$sdk/third_party/flatbuffers/include -I$sdk/third_party/gemmlowp \
+-I$sdk/third_party/ruy -I$sdk/CMSIS/DSP/Include -I$sdk/CMSIS/DSP/PrivateInclude \
+-I$sdk/CMSIS/NN/Include -I$sdk/CMSIS/Core/Include"
+
+# The SDK sources used by Edge Impulse's standalone Linux example; the other
+# porting layers and the Arm-only CMSIS kernels are left out.
+sources="$(
+    ls "$lib"/tflite-model/*.cpp 2>/dev/null
+    ls "$sdk"/dsp/kissfft/*.cpp "$sdk"/dsp/dct/*.cpp "$sdk"/dsp/memory.cpp
+    ls "$sdk"/porting/posix/*.c* 2>/dev/null
+    ls "$sdk"/CMSIS/DSP/Source/{TransformFunctions,CommonTables,BasicMathFunctions,ComplexMathFunctions,FastMathFunctions,SupportFunctions,MatrixFunctions,StatisticsFunctions}/*.c 2>/dev/null
+    find "$sdk"/tensorflow -name '*.cc' -o -name '*.c' -o -name '*.cpp'
+)"
+
+mkdir -p "$out"
+objs=""
+for src in $sources; do
+    obj="$out/$(echo "${src#$lib/}" | tr '/' '_').o"
+    if [ ! -f "$obj" ] || [ "$src" -nt "$obj" ]; then
+        case "$src" in
+            *.c) gcc -O2 -c $defines $includes "$src" -o "$obj" ;;
+            *)   g++ -O2 -std=c++14 -c $defines $includes "$src" -o "$obj" ;;
+        esac
+    fi
+    objs="$objs $obj"
+done
+
+g++ -O2 -std=c++14 $defines $includes "$here/bench_pipeline.cpp" $objs \
+    -lm -lpthread -o "$here/bench_pipeline"
+echo "Built $here/bench_pipeline ($model_header)"
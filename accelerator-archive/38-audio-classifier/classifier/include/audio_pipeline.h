@@ -0,0 +1,99 @@
+#ifndef AUDIO_PIPELINE_H
+#define AUDIO_PIPELINE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+// PcmSliceRing is a ring of int16 PCM samples between the MEMS_Audio capture
+// callback (interrupt context) and the classifier (main loop), sized as
+// NumSlices slices of SliceLen samples each.
+//
+// The PDM filter writes its output directly into the ring: after each block
+// is committed, the callback points MemsAudio::pcmOutputBuffer at the next
+// free region, so the next DMA half-transfer is decimated in place. The main
+// loop then hands each completed slice to the classifier by pointer, without
+// a copy, and releases it once classification is done. Because the ring is
+// an exact multiple of SliceLen and slices are consumed whole, a slice never
+// wraps the end of the buffer.
+//
+// When the classifier falls behind and the ring is full, incoming blocks are
+// dropped (and counted) rather than overwriting a slice being classified.
+template <size_t SliceLen, size_t NumSlices>
+class PcmSliceRing
+{
+public:
+    static const size_t Capacity = SliceLen * NumSlices;
+
+    PcmSliceRing() : writePos(0), readPos(0), droppedBlocks(0) {}
+
+    // Called from the capture callback with the block the filter just wrote.
+    // Returns where the filter should write the next block of the same length:
+    // a region of the ring if there is room, otherwise scratch.
+    int16_t *commit(const int16_t *block, size_t len, int16_t *scratch)
+    {
+        uint32_t w = writePos;
+        const uint32_t r = readPos;
+
+        if (block == &buf[w % Capacity]) {
+            // Decimated in place; just publish it.
+            w += len;
+        }
+        else if (w - r + len <= Capacity) {
+            // First block after start-up or after an overflow: the filter
+            // wrote to scratch, so copy it in.
+            const size_t idx = w % Capacity;
+            const size_t first = (len < Capacity - idx) ? len : Capacity - idx;
+            memcpy(&buf[idx], block, first * sizeof(int16_t));
+            memcpy(buf, block + first, (len - first) * sizeof(int16_t));
+            w += len;
+        }
+        else {
+            ++droppedBlocks;
+        }
+        writePos = w;
+
+        const size_t idx = w % Capacity;
+        if (w - r + len <= Capacity && idx + len <= Capacity) {
+            return &buf[idx];
+        }
+        return scratch;
+    }
+
+    // The oldest complete slice, or NULL if none is ready yet.
+    const int16_t *peek() const
+    {
+        if (writePos - readPos < SliceLen) {
+            return NULL;
+        }
+        return &buf[readPos % Capacity];
+    }
+
+    // Returns the slice from peek() to the capture side.
+    void release()
+    {
+        readPos = readPos + SliceLen;
+    }
+
+    // Number of capture blocks dropped because the ring was full.
+    uint32_t dropped() const
+    {
+        return droppedBlocks;
+    }
+
+    // Complete slices waiting to be classified.
+    size_t backlog() const
+    {
+        return (writePos - readPos) / SliceLen;
+    }
+
+private:
+    int16_t buf[Capacity];
+    // Monotonic sample counts; only the capture side writes writePos and only
+    // the main loop writes readPos, so no lock is needed on a single core.
+    volatile uint32_t writePos;
+    volatile uint32_t readPos;
+    volatile uint32_t droppedBlocks;
+};
+
+#endif // AUDIO_PIPELINE_H
@@ -2,6 +2,15 @@
 #include <Notecard.h>
 #include "NotecardEnvVarManager.h"
 #include <MEMSAudioCapture.h>
+#include "audio_pipeline.h"
+
+// The model window is classified in this many slices, each as soon as its
+// audio arrives, so consecutive windows overlap by all but one slice. This
+// must be defined before the Edge Impulse header is included.
+#ifndef EI_CLASSIFIER_SLICES_PER_MODEL_WINDOW
+#define EI_CLASSIFIER_SLICES_PER_MODEL_WINDOW 4
+#endif
+
 // Include your specific Edge Impulse header file here:
 // #include <running_faucet_detector_inferencing.h>
 
@@ -24,10 +33,6 @@
 #define INBOUND_SYNC_MINS 3
 #endif
 
-#ifndef MIN
-#define MIN(a,b) (((a)<(b))?(a):(b))
-#endif
-
 #ifndef LED_ON_PERIOD_MS
 #define LED_ON_PERIOD_MS 1000
 #endif
@@ -35,16 +40,27 @@
 // Define DEBUG_CLASSIFIER to print debug messages related to the classifier.
 #define DEBUG_CLASSIFIER
 
+#ifndef DETECTIONS_FILE
+#define DETECTIONS_FILE "detections.qo"
+#endif
+
+#ifndef SUMMARY_FILE
+#define SUMMARY_FILE "detection_summary.qo"
+#endif
+
 // Fetch environment variables every 5 minutes.
 #ifndef ENV_FETCH_INTERVAL_MS
 #define ENV_FETCH_INTERVAL_MS (5 * 60 * 1000)
 #endif
 
-#ifndef NUM_PCM_BUFS
-#define NUM_PCM_BUFS 3
+// Number of slices of audio that can be buffered while the classifier is
+// busy with an earlier one.
+#ifndef NUM_SLICE_BUFS
+#define NUM_SLICE_BUFS 3
 #endif
 
-#define PCM_BUF_SIZE EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE
+static_assert(EI_CLASSIFIER_SLICE_SIZE % MEMS_AUDIO_PCM_BUFFER_LENGTH == 0,
+    "Slice size must be a multiple of the MEMS_Audio block length.");
 
 MEMSAudioCapture mic;
 Notecard notecard;
@@ -54,34 +70,71 @@ NotecardEnvVarManager *envVarManager = NULL;
 const char *envVars[] = {
     "label",
     "detection_threshold",
-    "publish_rate"
+    "publish_rate",
+    "summary_period"
 };
 static const size_t numEnvVars = sizeof(envVars) / sizeof(envVars[0]);
 
-// pcmBuf is a simple FIFO of NUM_PCM_BUFS audio buffers. Audio captured by the
-// mic is pushed in and the main loop pulls it out for classification.
-static float pcmBuf[NUM_PCM_BUFS][PCM_BUF_SIZE];
-static size_t pcmBufLen = 0;
-static size_t numUnclassifiedBufs = 0;
-static uint8_t writeIndex = 0;
-static uint8_t readIndex = 0;
+// pcmRing is a FIFO of NUM_SLICE_BUFS slices of int16 audio. The PDM filter
+// decimates straight into it and the main loop classifies each slice in
+// place, converting to float only as the DSP block reads the samples.
+static PcmSliceRing<EI_CLASSIFIER_SLICE_SIZE, NUM_SLICE_BUFS> pcmRing;
+// Filter output goes here while the ring is full.
+static pcm_sample_t pcmScratch[MEMS_AUDIO_PCM_BUFFER_LENGTH];
+// The slice currently being classified, read by getSliceData.
+static const pcm_sample_t *currentSlice = NULL;
+static uint32_t reportedDrops = 0;
+// The first slices of a window are classified against zero-filled features,
+// so results aren't acted on until a full window has been seen.
+static uint32_t numSlicesClassified = 0;
+
+// Length of audio covered by each classification result.
+#define SLICE_MS ((uint32_t)EI_CLASSIFIER_SLICE_SIZE * 1000 / EI_CLASSIFIER_FREQUENCY)
+
+// Detections of one label over the current summary window. An event is a run
+// of consecutive slices above the detection threshold, so a single bark is one
+// event and a continuous alarm is one long event.
+struct DetectionStats {
+    bool inEvent;
+    uint16_t events;
+    uint32_t detections;
+    float maxProbability;
+    float sumProbability;
+    unsigned long firstMs;
+    unsigned long lastMs;
+};
+
+static DetectionStats detectionStats[EI_CLASSIFIER_LABEL_COUNT];
+static unsigned long summaryWindowStartMs = 0;
+// Notecard time at timeBaseMs, used to timestamp the first and last detection
+// in a summary. Zero until the Notecard has time.
+static uint32_t timeBaseEpoch = 0;
+static unsigned long timeBaseMs = 0;
 
 static unsigned long ledTurnedOnMs = 0;
 static unsigned long envFetchedMs = 0;
-static unsigned long lastPublishMs = 0;
+// When each label was last detected, for deciding whether a detection follows a
+// quiet period.
+static unsigned long lastDetectionMs[EI_CLASSIFIER_LABEL_COUNT] = {0};
 static bool ledOn = false;
 
 // By default, a detection will be published if the probability value for the
 // label of interest is > 0.6. This can be changed by setting the
 // "detection_threshold" environment variable.
 static float detectionThreshold = 0.6;
-// This is the label of interest. By default, it's set to nothing, so the user
-// must set the environment variable "label" for detections to be published.
-static char label[32] = {0};
-// A detection note will be published a maximum of once every publishRateMs
-// milliseconds. By default, this is set to 1 minute. The user can change this
-// by setting the environment variable "publish_rate".
+// This is the label of interest, or a comma-separated list of them. By default,
+// it's set to nothing, so the user must set the environment variable "label"
+// for detections to be published.
+static char label[64] = {0};
+// A detection note is published immediately for the first detection of a label
+// after publishRateMs milliseconds without one. Detections in between are only
+// counted in the summary. By default, this is set to 1 minute. The user can
+// change this by setting the environment variable "publish_rate".
 static uint32_t publishRateMs = 60 * 1000;
+// A summary note is published for each label detected in the last
+// summaryPeriodMs milliseconds. By default, this is set to 15 minutes. The user
+// can change this by setting the environment variable "summary_period".
+static uint32_t summaryPeriodMs = 15 * 60 * 1000;
 
 static void envVarManagerCb(const char *var, const char *val, void *userCtx)
 {
@@ -132,33 +185,92 @@ static void envVarManagerCb(const char *var, const char *val, void *userCtx)
             Serial.println(" seconds.");
         }
     }
+    else if (strcmp(var, "summary_period") == 0) {
+        int period = atoi(val);
+
+        if (period <= 0) {
+            Serial.println("summary_period must be a positive integer.");
+        }
+        else {
+            summaryPeriodMs = period * 1000;
+            Serial.print("Summary period set to ");
+            Serial.print(period);
+            Serial.println(" seconds.");
+        }
+    }
 }
 
-void accumulateSamples(MemsAudio* audio, pcm_sample_t* samples, size_t len)
+// Returns true if name is one of the comma-separated labels in label.
+static bool isLabelOfInterest(const char *name)
 {
-    if (numUnclassifiedBufs > 0 && writeIndex == readIndex) {
-        Serial.println("Overflow! Increase NUM_PCM_BUFS.");
-    }
+    size_t nameLen = strlen(name);
+    const char *p = label;
 
-    if (pcmBufLen < PCM_BUF_SIZE) {
-        size_t lenToCopy = MIN(PCM_BUF_SIZE - pcmBufLen, len);
-        for (size_t i = 0; i < lenToCopy; ++i) {
-            (pcmBuf[writeIndex] + pcmBufLen)[i] = (float)samples[i];
+    while (*p != '\0') {
+        while (*p == ' ' || *p == ',') {
+            ++p;
+        }
+        const char *end = p;
+        while (*end != '\0' && *end != ',') {
+            ++end;
+        }
+        size_t len = end - p;
+        while (len > 0 && p[len - 1] == ' ') {
+            --len;
+        }
+        if (len > 0 && len == nameLen && strncmp(p, name, len) == 0) {
+            return true;
         }
+        p = end;
+    }
+
+    return false;
+}
 
-        pcmBufLen += lenToCopy;
+// Called from the DMA interrupt with each block of filtered PCM. Pointing
+// pcmOutputBuffer back into the ring means the next block is written where it
+// will be classified, with no copy.
+void accumulateSamples(MemsAudio* audio, pcm_sample_t* samples, size_t len)
+{
+    audio->pcmOutputBuffer = pcmRing.commit(samples, len, pcmScratch);
+}
+
+static int getSliceData(size_t offset, size_t length, float *out)
+{
+    return numpy::int16_to_float(currentSlice + offset, out, length);
+}
+
+// Register the template for summary notes, so each one is stored and sent as a
+// compact fixed-length record instead of JSON.
+static void registerSummaryTemplate()
+{
+    J *req = notecard.newRequest("note.template");
+    if (req == NULL) {
+        Serial.println("Failed to create note.template request.");
+        return;
     }
 
-    if (pcmBufLen == PCM_BUF_SIZE) {
-        ++numUnclassifiedBufs;
-        pcmBufLen = 0;
+    J *body = JCreateObject();
+    if (body == NULL) {
+        JDelete(req);
+        Serial.println("Failed to create note.template request body.");
+        return;
+    }
 
-        if (writeIndex == NUM_PCM_BUFS - 1) {
-            writeIndex = 0;
-        }
-        else {
-            ++writeIndex;
-        }
+    JAddStringToObject(req, "file", SUMMARY_FILE);
+    JAddStringToObject(body, "label", TSTRINGV);
+    JAddNumberToObject(body, "events", TUINT16);
+    JAddNumberToObject(body, "detections", TUINT32);
+    JAddNumberToObject(body, "duration", TUINT32);
+    JAddNumberToObject(body, "max_probability", TFLOAT32);
+    JAddNumberToObject(body, "mean_probability", TFLOAT32);
+    JAddNumberToObject(body, "first", TUINT32);
+    JAddNumberToObject(body, "last", TUINT32);
+    JAddNumberToObject(body, "window", TUINT32);
+    JAddItemToObject(req, "body", body);
+
+    if (!notecard.sendRequest(req)) {
+        Serial.println("Failed to send note.template request.");
     }
 }
 
@@ -169,6 +281,8 @@ void setup()
     Serial.begin(115200);
     notecard.setDebugOutputStream(Serial);
 
+    run_classifier_init();
+
     if (!mic.begin(accumulateSamples)) {
         Serial.println("Unable to start audio capture.");
     }
@@ -190,6 +304,8 @@ void setup()
         Serial.println("Failed to send hub.set request to Notecard.");
     }
 
+    registerSummaryTemplate();
+
     envVarManager = NotecardEnvVarManager_alloc();
     if (envVarManager == NULL) {
         Serial.println("Failed to allocate env var manager.");
@@ -205,9 +321,35 @@ void setup()
     else {
         envFetchedMs = millis();
     }
+
+    // Audio that couldn't be buffered while the Notecard was being configured
+    // isn't an overflow in steady state.
+    reportedDrops = pcmRing.dropped();
+    summaryWindowStartMs = millis();
 }
 
-bool publishDetection(float probability)
+// Converts a millis() value to Unix time using the Notecard's clock. Returns 0
+// if the Notecard doesn't have time yet.
+static uint32_t msToEpoch(unsigned long ms)
+{
+    if (timeBaseEpoch == 0) {
+        J *rsp = notecard.requestAndResponse(notecard.newRequest("card.time"));
+        if (rsp != NULL) {
+            if (!notecard.responseError(rsp)) {
+                timeBaseEpoch = JGetInt(rsp, "time");
+                timeBaseMs = millis();
+            }
+            notecard.deleteResponse(rsp);
+        }
+        if (timeBaseEpoch == 0) {
+            return 0;
+        }
+    }
+
+    return timeBaseEpoch + (long)(ms - timeBaseMs) / 1000;
+}
+
+bool publishDetection(const char *detectedLabel, float probability)
 {
     bool success = true;
 
@@ -215,12 +357,12 @@ bool publishDetection(float probability)
 
     J *req = notecard.newRequest("note.add");
     if (req != NULL) {
-        JAddStringToObject(req, "file", "detections.qo");
+        JAddStringToObject(req, "file", DETECTIONS_FILE);
         JAddBoolToObject(req, "sync", true);
 
         J *body = JCreateObject();
         if (body != NULL) {
-            JAddStringToObject(body, "label", label);
+            JAddStringToObject(body, "label", detectedLabel);
             JAddNumberToObject(body, "probability", probability);
             JAddItemToObject(req, "body", body);
 
@@ -243,15 +385,86 @@ bool publishDetection(float probability)
     return success;
 }
 
-static void updateReadIndex()
+// Publishes a summary note for each label detected in the window that's ending
+// and starts a new window. Nothing is sent for a window without detections.
+static void publishSummaries(unsigned long currentMs)
 {
-    --numUnclassifiedBufs;
-    if (readIndex == NUM_PCM_BUFS - 1) {
-        readIndex = 0;
+    const uint32_t windowSecs = (currentMs - summaryWindowStartMs) / 1000;
+
+    for (size_t i = 0; i < EI_CLASSIFIER_LABEL_COUNT; i++) {
+        DetectionStats *stats = &detectionStats[i];
+        if (stats->detections == 0) {
+            continue;
+        }
+
+        const char *name = ei_classifier_inferencing_categories[i];
+        Serial.print("Publishing summary for ");
+        Serial.print(name);
+        Serial.println("...");
+
+        J *req = notecard.newRequest("note.add");
+        J *body = JCreateObject();
+        if (req == NULL || body == NULL) {
+            JDelete(req);
+            JDelete(body);
+            Serial.println("Failed to create note.add request for summary note.");
+        }
+        else {
+            JAddStringToObject(req, "file", SUMMARY_FILE);
+            JAddStringToObject(body, "label", name);
+            JAddNumberToObject(body, "events", stats->events);
+            JAddNumberToObject(body, "detections", stats->detections);
+            JAddNumberToObject(body, "duration",
+                (stats->detections * SLICE_MS + 500) / 1000);
+            JAddNumberToObject(body, "max_probability", stats->maxProbability);
+            JAddNumberToObject(body, "mean_probability",
+                stats->sumProbability / stats->detections);
+            JAddNumberToObject(body, "first", msToEpoch(stats->firstMs));
+            JAddNumberToObject(body, "last", msToEpoch(stats->lastMs));
+            JAddNumberToObject(body, "window", windowSecs);
+            JAddItemToObject(req, "body", body);
+
+            if (!notecard.sendRequest(req)) {
+                Serial.println("note.add for summary note failed.");
+            }
+        }
+
+        // An event still in progress carries over into the next window.
+        bool inEvent = stats->inEvent;
+        memset(stats, 0, sizeof(*stats));
+        stats->inEvent = inEvent;
     }
-    else {
-        ++readIndex;
+
+    summaryWindowStartMs = currentMs;
+}
+
+// Records one classification result for a label of interest.
+static void updateDetectionStats(size_t labelIdx, float probability,
+    bool detected, unsigned long currentMs)
+{
+    DetectionStats *stats = &detectionStats[labelIdx];
+
+    if (!detected) {
+        stats->inEvent = false;
+        return;
+    }
+
+    // An event carried over from the previous window is counted again here,
+    // so every summary with detections has at least one event.
+    if (!stats->inEvent || stats->detections == 0) {
+        ++stats->events;
+    }
+    if (stats->detections == 0) {
+        stats->firstMs = currentMs;
+        stats->maxProbability = probability;
+    }
+    else if (probability > stats->maxProbability) {
+        stats->maxProbability = probability;
     }
+    stats->inEvent = true;
+    ++stats->detections;
+    stats->sumProbability += probability;
+    stats->lastMs = currentMs;
 }
 
 void loop()
@@ -275,66 +488,81 @@ void loop()
         envFetchedMs = currentMs;
     }
 
-    // Run the classifier once we have a buffer to process.
-    if (numUnclassifiedBufs > 0) {
-        // Turn the raw buffer into a signal which we can the classify.
+    // Publish the summary of the window that just ended.
+    if (currentMs - summaryWindowStartMs >= summaryPeriodMs) {
+        publishSummaries(currentMs);
+    }
+
+    uint32_t drops = pcmRing.dropped();
+    if (drops != reportedDrops) {
+        Serial.println("Overflow! Increase NUM_SLICE_BUFS.");
+        reportedDrops = drops;
+    }
+
+    // Run the classifier once we have a slice to process.
+    currentSlice = pcmRing.peek();
+    if (currentSlice != NULL) {
+        // The signal reads the slice straight out of the ring.
         signal_t signal;
-        int err = numpy::signal_from_buffer(pcmBuf[readIndex], PCM_BUF_SIZE,
-                                            &signal);
-        if (err != 0) {
-            ei_printf("Failed to create signal from buffer (%d)\n", err);
-            updateReadIndex();
-            return;
-        }
+        signal.total_length = EI_CLASSIFIER_SLICE_SIZE;
+        signal.get_data = &getSliceData;
 
-        // Run the classifier.
+        // Run the classifier on the newest slice of the window.
         ei_impulse_result_t result = {0};
-        err = run_classifier(&signal, &result, false);
+        EI_IMPULSE_ERROR err = run_classifier_continuous(&signal, &result,
+                                                         false);
+        pcmRing.release();
         if (err != EI_IMPULSE_OK) {
             ei_printf("ERR: Failed to run classifier (%d)\n", err);
-            updateReadIndex();
             return;
         }
 
-        updateReadIndex();
+        if (numSlicesClassified < EI_CLASSIFIER_SLICES_PER_MODEL_WINDOW - 1) {
+            ++numSlicesClassified;
+            return;
+        }
 
     #ifdef DEBUG_CLASSIFIER
         ei_printf("(DSP: %d ms., Classification: %d ms.)\n",
             result.timing.dsp, result.timing.classification);
     #endif
 
-        float probability = 0;
+        currentMs = millis();
         for (size_t i = 0; i < EI_CLASSIFIER_LABEL_COUNT; i++) {
-            if (strcmp(result.classification[i].label, label) == 0) {
-                probability = result.classification[i].value;
-            }
+            const char *name = result.classification[i].label;
+            float probability = result.classification[i].value;
 
         #ifdef DEBUG_CLASSIFIER
             Serial.print("    ");
-            Serial.print(result.classification[i].label);
+            Serial.print(name);
             Serial.print(": ");
-            Serial.println(result.classification[i].value);
+            Serial.println(probability);
         #endif
-        }
 
-        if (probability > detectionThreshold) {
+            if (!isLabelOfInterest(name)) {
+                continue;
+            }
+
+            bool detected = probability > detectionThreshold;
+            updateDetectionStats(i, probability, detected, currentMs);
+            if (!detected) {
+                continue;
+            }
+
             // Turn on the LED.
             digitalWrite(LED_BUILTIN, HIGH);
-            ledTurnedOnMs = millis();
+            ledTurnedOnMs = currentMs;
             ledOn = true;
 
-            // Only publish the detection if it's been more than publishRateMs
-            // milliseconds since the last publish.
-            currentMs = millis();
-            if (lastPublishMs == 0 ||
-                (currentMs - lastPublishMs > publishRateMs)) {
-                lastPublishMs = currentMs;
-
-                // Publish a detection to Notehub.
-                if (!publishDetection(probability)) {
+            // Publish the first detection after a quiet period right away.
+            // Later ones are only counted until the summary is published.
+            if (lastDetectionMs[i] == 0 ||
+                (currentMs - lastDetectionMs[i] >= publishRateMs)) {
+                if (!publishDetection(name, probability)) {
                     Serial.println("Failed to publish detection note.");
                 }
             }
+            lastDetectionMs[i] = currentMs;
         }
     }
 }